@@ -2581,3 +2581,104 @@ int has_stdin_waiting(void)
     return _kbhit();
 }
 #endif
+
+/* app_run_tasks section */
+typedef struct {
+    void (*task) (void *arg);
+    void *arg;
+} APP_TASK;
+
+#if defined(OPENSSL_THREADS) && defined(_WIN32)
+# include <windows.h>
+
+typedef HANDLE APP_THREAD;
+
+static DWORD WINAPI app_thread_run(LPVOID arg)
+{
+    APP_TASK *t = arg;
+
+    t->task(t->arg);
+    return 0;
+}
+
+static int app_thread_start(APP_THREAD *thread, APP_TASK *t)
+{
+    *thread = CreateThread(NULL, 0, app_thread_run, t, 0, NULL);
+    return *thread != NULL;
+}
+
+static void app_thread_join(APP_THREAD thread)
+{
+    WaitForSingleObject(thread, INFINITE);
+    CloseHandle(thread);
+}
+#elif defined(OPENSSL_THREADS)
+# include <pthread.h>
+
+typedef pthread_t APP_THREAD;
+
+static void *app_thread_run(void *arg)
+{
+    APP_TASK *t = arg;
+
+    t->task(t->arg);
+    return NULL;
+}
+
+static int app_thread_start(APP_THREAD *thread, APP_TASK *t)
+{
+    return pthread_create(thread, NULL, app_thread_run, t) == 0;
+}
+
+static void app_thread_join(APP_THREAD thread)
+{
+    pthread_join(thread, NULL);
+}
+#else
+typedef int APP_THREAD;
+
+static int app_thread_start(APP_THREAD *thread, APP_TASK *t)
+{
+    return 0;
+}
+
+static void app_thread_join(APP_THREAD thread)
+{
+}
+#endif
+
+/*
+ * Run |num| tasks for the thread pool options of the library, each on a
+ * thread of its own and the first one on the calling thread. Tasks that
+ * cannot get a thread run on the calling thread after the first one.
+ * |pool| is unused.
+ */
+int app_run_tasks(void *pool, void (*task) (void *arg), void *args[],
+                  size_t num)
+{
+    APP_TASK *t;
+    APP_THREAD *threads;
+    size_t i, started;
+
+    if (num == 0)
+        return 1;
+    t = app_malloc(sizeof(*t) * num, "tasks");
+    threads = app_malloc(sizeof(*threads) * num, "threads");
+    for (i = 1; i < num; i++) {
+        t[i].task = task;
+        t[i].arg = args[i];
+        if (!app_thread_start(&threads[i], &t[i]))
+            break;
+    }
+    started = i;
+
+    task(args[0]);
+    for (i = started; i < num; i++)
+        task(args[i]);
+    for (i = 1; i < started; i++)
+        app_thread_join(threads[i]);
+
+    OPENSSL_free(t);
+    OPENSSL_free(threads);
+    return 1;
+}
@@ -542,6 +542,9 @@ int raw_write_stdout(const void *, int);
 # define TM_STOP         1
 double app_tminterval(int stop, int usertime);
 
+int app_run_tasks(void *pool, void (*task) (void *arg), void *args[],
+                  size_t num);
+
 /* this is an accident waiting to happen (-Wshadow is your friend) */
 extern int verify_depth;
 extern int verify_quiet;
@@ -36,7 +36,7 @@ typedef enum OPTION_choice {
     OPT_ERR = -1, OPT_EOF = 0, OPT_HELP,
     OPT_INFORM, OPT_OUTFORM, OPT_IN, OPT_OUT,
     OPT_ENGINE, OPT_CHECK, OPT_TEXT, OPT_NOOUT,
-    OPT_RAND, OPT_DSAPARAM, OPT_C, OPT_2, OPT_5
+    OPT_RAND, OPT_DSAPARAM, OPT_C, OPT_2, OPT_5, OPT_THREADS
 } OPTION_CHOICE;
 
 OPTIONS dhparam_options[] = {
@@ -55,6 +55,8 @@ OPTIONS dhparam_options[] = {
     {"C", OPT_C, '-', "Print C code"},
     {"2", OPT_2, '-', "Generate parameters using 2 as the generator value"},
     {"5", OPT_5, '-', "Generate parameters using 5 as the generator value"},
+    {"threads", OPT_THREADS, 'p',
+     "Number of threads to search for the prime on"},
 # ifndef OPENSSL_NO_DSA
     {"dsaparam", OPT_DSAPARAM, '-',
      "Read or generate DSA parameters, convert to DH"},
@@ -73,7 +75,7 @@ int dhparam_main(int argc, char **argv)
 #ifndef OPENSSL_NO_DSA
     int dsaparam = 0;
 #endif
-    int i, text = 0, C = 0, ret = 1, num = 0, g = 0;
+    int i, text = 0, C = 0, ret = 1, num = 0, g = 0, threads = 1;
     int informat = FORMAT_PEM, outformat = FORMAT_PEM, check = 0, noout = 0;
     OPTION_CHOICE o;
 
@@ -132,6 +134,9 @@ int dhparam_main(int argc, char **argv)
         case OPT_RAND:
             inrand = opt_arg();
             break;
+        case OPT_THREADS:
+            threads = atoi(opt_arg());
+            break;
         }
     }
     argc = opt_num_rest();
@@ -164,6 +169,8 @@ int dhparam_main(int argc, char **argv)
         }
 
         BN_GENCB_set(cb, dh_cb, bio_err);
+        if (threads > 1)
+            BN_GENCB_set_thread_pool(cb, app_run_tasks, NULL, threads);
         if (!app_RAND_load_file(NULL, 1) && inrand == NULL) {
             BIO_printf(bio_err,
                        "warning, not much extra random data, consider using the -rand option\n");
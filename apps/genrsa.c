@@ -33,7 +33,7 @@ static int genrsa_cb(int p, int n, BN_GENCB *cb);
 typedef enum OPTION_choice {
     OPT_ERR = -1, OPT_EOF = 0, OPT_HELP,
     OPT_3, OPT_F4, OPT_ENGINE,
-    OPT_OUT, OPT_RAND, OPT_PASSOUT, OPT_CIPHER
+    OPT_OUT, OPT_RAND, OPT_PASSOUT, OPT_CIPHER, OPT_THREADS
 } OPTION_CHOICE;
 
 OPTIONS genrsa_options[] = {
@@ -45,6 +45,7 @@ OPTIONS genrsa_options[] = {
     {"rand", OPT_RAND, 's',
      "Load the file(s) into the random number generator"},
     {"passout", OPT_PASSOUT, 's', "Output file pass phrase source"},
+    {"threads", OPT_THREADS, 'p', "Number of threads to search for primes on"},
     {"", OPT_CIPHER, '-', "Encrypt the output with any supported cipher"},
 # ifndef OPENSSL_NO_ENGINE
     {"engine", OPT_ENGINE, 's', "Use engine, possibly a hardware device"},
@@ -62,7 +63,7 @@ int genrsa_main(int argc, char **argv)
     const BIGNUM *e;
     RSA *rsa = NULL;
     const EVP_CIPHER *enc = NULL;
-    int ret = 1, num = DEFBITS, private = 0;
+    int ret = 1, num = DEFBITS, private = 0, threads = 1;
     unsigned long f4 = RSA_F4;
     char *outfile = NULL, *passoutarg = NULL, *passout = NULL;
     char *inrand = NULL, *prog, *hexe, *dece;
@@ -106,8 +107,13 @@ int genrsa_main(int argc, char **argv)
             if (!opt_cipher(opt_unknown(), &enc))
                 goto end;
             break;
+        case OPT_THREADS:
+            threads = atoi(opt_arg());
+            break;
         }
     }
+    if (threads > 1)
+        BN_GENCB_set_thread_pool(cb, app_run_tasks, NULL, threads);
     argc = opt_num_rest();
     argv = opt_rest();
     private = 1;
@@ -142,6 +142,8 @@
 static volatile int run = 0;
 
 static int mr = 0;
+static int restore = 0;
+static int multiblock = 0;
 static int usertime = 1;
 
 typedef struct loopargs_st {
@@ -168,6 +170,11 @@ typedef struct loopargs_st {
     EVP_CIPHER_CTX *ctx;
     HMAC_CTX *hctx;
     GCM128_CONTEXT *gcm_ctx;
+    /* Saved contexts restored for every message with -restore */
+    EVP_CIPHER_CTX *saved_ctx;
+    EVP_MD_CTX *mctx;
+    EVP_MD_CTX *saved_mctx;
+    HMAC_CTX *saved_hctx;
 } loopargs_t;
 
 #ifndef OPENSSL_NO_MD2
@@ -366,7 +373,7 @@ static int found(const char *name, const OPT_PAIR * pairs, int *result)
 typedef enum OPTION_choice {
     OPT_ERR = -1, OPT_EOF = 0, OPT_HELP,
     OPT_ELAPSED, OPT_EVP, OPT_DECRYPT, OPT_ENGINE, OPT_MULTI,
-    OPT_MR, OPT_MB, OPT_MISALIGN, OPT_ASYNCJOBS
+    OPT_MR, OPT_MB, OPT_MISALIGN, OPT_ASYNCJOBS, OPT_RESTORE
 } OPTION_CHOICE;
 
 OPTIONS speed_options[] = {
@@ -377,10 +384,13 @@ OPTIONS speed_options[] = {
     {"decrypt", OPT_DECRYPT, '-',
      "Time decryption instead of encryption (only EVP)"},
     {"mr", OPT_MR, '-', "Produce machine readable output"},
-    {"mb", OPT_MB, '-'},
+    {"mb", OPT_MB, '-',
+     "Use multi-buffer sha1/sha256 and multi-block EVP ciphers"},
     {"misalign", OPT_MISALIGN, 'n', "Amount to mis-align buffers"},
     {"elapsed", OPT_ELAPSED, '-',
      "Measure time in real time instead of CPU user time"},
+    {"restore", OPT_RESTORE, '-',
+     "Restore a saved context for every message (hmac and EVP only)"},
 #ifndef NO_FORK
     {"multi", OPT_MULTI, 'p', "Run benchmarks in parallel"},
 #endif
@@ -656,7 +666,10 @@ static int HMAC_loop(void *args)
     unsigned char hmac[MD5_DIGEST_LENGTH];
     int count;
     for (count = 0; COND(c[D_HMAC][testnum]); count++) {
-        HMAC_Init_ex(hctx, NULL, 0, NULL, NULL);
+        if (restore)
+            HMAC_CTX_copy(hctx, tempargs->saved_hctx);
+        else
+            HMAC_Init_ex(hctx, NULL, 0, NULL, NULL);
         HMAC_Update(hctx, buf, lengths[testnum]);
         HMAC_Final(hctx, &(hmac[0]), NULL);
     }
@@ -664,12 +677,31 @@ static int HMAC_loop(void *args)
 }
 #endif
 
+/* Messages hashed per call with -mb */
+#define MB_MSGS         8
+
 static int SHA1_loop(void *args)
 {
     loopargs_t *tempargs = (loopargs_t *)args;
     unsigned char *buf = tempargs->buf;
     unsigned char sha[SHA_DIGEST_LENGTH];
     int count;
+
+    if (multiblock) {
+        const unsigned char *d[MB_MSGS];
+        unsigned char mds[MB_MSGS][SHA_DIGEST_LENGTH], *md[MB_MSGS];
+        size_t n[MB_MSGS];
+        int i;
+
+        for (i = 0; i < MB_MSGS; i++) {
+            d[i] = buf;
+            n[i] = lengths[testnum];
+            md[i] = mds[i];
+        }
+        for (count = 0; COND(c[D_SHA1][testnum]); count += MB_MSGS)
+            SHA1_mb(d, n, md, MB_MSGS);
+        return count;
+    }
     for (count = 0; COND(c[D_SHA1][testnum]); count++)
         SHA1(buf, lengths[testnum], sha);
     return count;
@@ -681,6 +713,22 @@ static int SHA256_loop(void *args)
     unsigned char *buf = tempargs->buf;
     unsigned char sha256[SHA256_DIGEST_LENGTH];
     int count;
+
+    if (multiblock) {
+        const unsigned char *d[MB_MSGS];
+        unsigned char mds[MB_MSGS][SHA256_DIGEST_LENGTH], *md[MB_MSGS];
+        size_t n[MB_MSGS];
+        int i;
+
+        for (i = 0; i < MB_MSGS; i++) {
+            d[i] = buf;
+            n[i] = lengths[testnum];
+            md[i] = mds[i];
+        }
+        for (count = 0; COND(c[D_SHA256][testnum]); count += MB_MSGS)
+            SHA256_mb(d, n, md, MB_MSGS);
+        return count;
+    }
     for (count = 0; COND(c[D_SHA256][testnum]); count++)
         SHA256(buf, lengths[testnum], sha256);
     return count;
@@ -863,7 +911,34 @@ static int EVP_Update_loop(void *args)
     unsigned char *buf = tempargs->buf;
     EVP_CIPHER_CTX *ctx = tempargs->ctx;
     int outl, count;
-    if (decrypt)
+    if (EVP_CIPHER_CTX_mode(ctx) == EVP_CIPH_GCM_SIV_MODE) {
+        /*
+         * The text of a message has to be passed in one update, so time
+         * whole messages. Decryption fails the tag check, which costs
+         * little more than a successful one.
+         */
+        unsigned char tag[16] = { 0 };
+
+        for (count = 0;
+                COND(save_count * 4 * lengths[0] / lengths[testnum]);
+                count++) {
+            EVP_CipherInit_ex(ctx, NULL, NULL, NULL, iv, -1);
+            if (decrypt)
+                EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_AEAD_SET_TAG,
+                                    sizeof(tag), tag);
+            EVP_CipherUpdate(ctx, buf, &outl, buf, lengths[testnum]);
+            EVP_CipherFinal_ex(ctx, buf, &outl);
+        }
+        return count;
+    }
+    if (restore)
+        for (count = 0;
+                COND(save_count * 4 * lengths[0] / lengths[testnum]);
+                count++) {
+            EVP_CIPHER_CTX_copy(ctx, tempargs->saved_ctx);
+            EVP_CipherUpdate(ctx, buf, &outl, buf, lengths[testnum]);
+        }
+    else if (decrypt)
         for (count = 0;
                 COND(save_count * 4 * lengths[0] / lengths[testnum]);
                 count++)
@@ -886,10 +961,21 @@ static int EVP_Digest_loop(void *args)
     loopargs_t *tempargs = (loopargs_t *)args;
     unsigned char *buf = tempargs->buf;
     unsigned char md[EVP_MAX_MD_SIZE];
+    EVP_MD_CTX *ctx = tempargs->mctx;
     int count;
-    for (count = 0;
-            COND(save_count * 4 * lengths[0] / lengths[testnum]); count++)
-        EVP_Digest(buf, lengths[testnum], &(md[0]), NULL, evp_md, NULL);
+    if (restore)
+        for (count = 0;
+                COND(save_count * 4 * lengths[0] / lengths[testnum]);
+                count++) {
+            EVP_MD_CTX_copy_ex(ctx, tempargs->saved_mctx);
+            EVP_DigestUpdate(ctx, buf, lengths[testnum]);
+            EVP_DigestFinal_ex(ctx, md, NULL);
+        }
+    else
+        for (count = 0;
+                COND(save_count * 4 * lengths[0] / lengths[testnum]);
+                count++)
+            EVP_Digest(buf, lengths[testnum], &(md[0]), NULL, evp_md, NULL);
 
     return count;
 }
@@ -1198,7 +1284,7 @@ int speed_main(int argc, char **argv)
     const EVP_CIPHER *evp_cipher = NULL;
     double d = 0.0;
     OPTION_CHOICE o;
-    int multiblock = 0, doit[ALGOR_NUM], pr_header = 0;
+    int doit[ALGOR_NUM], pr_header = 0;
 #ifndef OPENSSL_NO_DSA
     int dsa_doit[DSA_NUM];
 #endif
@@ -1430,6 +1516,9 @@ int speed_main(int argc, char **argv)
         case OPT_MB:
             multiblock = 1;
             break;
+        case OPT_RESTORE:
+            restore = 1;
+            break;
         }
     }
     argc = opt_num_rest();
@@ -1919,6 +2008,15 @@ int speed_main(int argc, char **argv)
 
             HMAC_Init_ex(loopargs[i].hctx, (unsigned char *)"This is a key...",
                     16, EVP_md5(), NULL);
+            if (restore) {
+                loopargs[i].saved_hctx = HMAC_CTX_new();
+                if (loopargs[i].saved_hctx == NULL
+                        || !HMAC_CTX_copy(loopargs[i].saved_hctx,
+                                          loopargs[i].hctx)) {
+                    BIO_printf(bio_err, "HMAC malloc failure, exiting...");
+                    exit(1);
+                }
+            }
         }
         for (testnum = 0; testnum < SIZE_NUM; testnum++) {
             print_message(names[D_HMAC], c[D_HMAC][testnum], lengths[testnum]);
@@ -1929,6 +2027,7 @@ int speed_main(int argc, char **argv)
         }
         for (i = 0; i < loopargs_len; i++) {
             HMAC_CTX_free(loopargs[i].hctx);
+            HMAC_CTX_free(loopargs[i].saved_hctx);
         }
     }
 #endif
@@ -2276,6 +2375,10 @@ int speed_main(int argc, char **argv)
 #endif
         for (testnum = 0; testnum < SIZE_NUM; testnum++) {
             if (evp_cipher) {
+                /* ChaCha20 and 256-bit ciphers take more than |key16| */
+                int keylen = EVP_CIPHER_key_length(evp_cipher);
+                const unsigned char *evp_key = keylen <= 16 ? key16
+                                               : keylen <= 24 ? key24 : key32;
 
                 names[D_EVP] = OBJ_nid2ln(EVP_CIPHER_nid(evp_cipher));
                 /*
@@ -2287,10 +2390,19 @@ int speed_main(int argc, char **argv)
                 for (k = 0; k < loopargs_len; k++) {
                     loopargs[k].ctx = EVP_CIPHER_CTX_new();
                     if (decrypt)
-                        EVP_DecryptInit_ex(loopargs[k].ctx, evp_cipher, NULL, key16, iv);
+                        EVP_DecryptInit_ex(loopargs[k].ctx, evp_cipher, NULL, evp_key, iv);
                     else
-                        EVP_EncryptInit_ex(loopargs[k].ctx, evp_cipher, NULL, key16, iv);
+                        EVP_EncryptInit_ex(loopargs[k].ctx, evp_cipher, NULL, evp_key, iv);
                     EVP_CIPHER_CTX_set_padding(loopargs[k].ctx, 0);
+                    if (restore) {
+                        loopargs[k].saved_ctx = EVP_CIPHER_CTX_new();
+                        if (loopargs[k].saved_ctx == NULL
+                                || !EVP_CIPHER_CTX_copy(loopargs[k].saved_ctx,
+                                                        loopargs[k].ctx)) {
+                            BIO_printf(bio_err, "EVP_CIPHER_CTX_copy failure, exiting...");
+                            exit(1);
+                        }
+                    }
                 }
 
                 Time_F(START);
@@ -2298,14 +2410,32 @@ int speed_main(int argc, char **argv)
                 d = Time_F(STOP);
                 for (k = 0; k < loopargs_len; k++) {
                     EVP_CIPHER_CTX_free(loopargs[k].ctx);
+                    EVP_CIPHER_CTX_free(loopargs[k].saved_ctx);
+                    loopargs[k].saved_ctx = NULL;
                 }
             }
             if (evp_md) {
                 names[D_EVP] = OBJ_nid2ln(EVP_MD_type(evp_md));
                 print_message(names[D_EVP], save_count, lengths[testnum]);
+                for (k = 0; restore && k < loopargs_len; k++) {
+                    loopargs[k].mctx = EVP_MD_CTX_new();
+                    loopargs[k].saved_mctx = EVP_MD_CTX_new();
+                    if (loopargs[k].mctx == NULL
+                            || loopargs[k].saved_mctx == NULL
+                            || !EVP_DigestInit_ex(loopargs[k].saved_mctx,
+                                                  evp_md, NULL)) {
+                        BIO_printf(bio_err, "EVP_DigestInit_ex failure, exiting...");
+                        exit(1);
+                    }
+                }
                 Time_F(START);
                 count = run_benchmark(async_jobs, EVP_Digest_loop, loopargs);
                 d = Time_F(STOP);
+                for (k = 0; k < loopargs_len; k++) {
+                    EVP_MD_CTX_free(loopargs[k].mctx);
+                    EVP_MD_CTX_free(loopargs[k].saved_mctx);
+                    loopargs[k].mctx = loopargs[k].saved_mctx = NULL;
+                }
             }
             print_result(D_EVP, testnum, count, d);
         }
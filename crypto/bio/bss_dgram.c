@@ -7,6 +7,15 @@
  * https://www.openssl.org/source/license.html
  */
 
+/*
+ * We need to do this early, because stdio.h includes the header files that
+ * handle _GNU_SOURCE and other similar macros.  Defining it later is simply
+ * too late, because those headers are protected from re- inclusion.
+ */
+#if defined(__linux) && !defined(_GNU_SOURCE)
+# define _GNU_SOURCE            /* make sure recvmmsg/sendmmsg are declared */
+#endif
+
 #include <stdio.h>
 #include <errno.h>
 
@@ -31,6 +40,14 @@
 #  define IP_MTU      14        /* linux is lame */
 # endif
 
+# if defined(OPENSSL_SYS_LINUX) && defined(MSG_WAITFORONE)
+#  define OPENSSL_DGRAM_MMSG
+#  include <netinet/udp.h>
+#  if defined(UDP_SEGMENT) && defined(SOL_UDP)
+#   define OPENSSL_DGRAM_GSO
+#  endif
+# endif
+
 # if OPENSSL_USE_IPV6 && !defined(IPPROTO_IPV6)
 #  define IPPROTO_IPV6 41       /* windows is lame */
 # endif
@@ -66,6 +83,13 @@ static void dgram_sctp_handle_auth_free_key_event(BIO *b, union sctp_notificatio
 #  endif
 # endif
 
+static int dgram_mmsg_write(BIO *h, const char *buf, int num);
+static int dgram_mmsg_read(BIO *h, char *buf, int size);
+static int dgram_mmsg_puts(BIO *h, const char *str);
+static long dgram_mmsg_ctrl(BIO *h, int cmd, long arg1, void *arg2);
+static int dgram_mmsg_new(BIO *h);
+static int dgram_mmsg_free(BIO *data);
+
 static int BIO_dgram_should_retry(int s);
 
 static void get_current_time(struct timeval *t);
@@ -83,6 +107,19 @@ static const BIO_METHOD methods_dgramp = {
     NULL,
 };
 
+static const BIO_METHOD methods_dgramp_mmsg = {
+    BIO_TYPE_DGRAM_MMSG,
+    "batched datagram socket",
+    dgram_mmsg_write,
+    dgram_mmsg_read,
+    dgram_mmsg_puts,
+    NULL,                       /* dgram_gets, */
+    dgram_mmsg_ctrl,
+    dgram_mmsg_new,
+    dgram_mmsg_free,
+    NULL,
+};
+
 # ifndef OPENSSL_NO_SCTP
 static const BIO_METHOD methods_dgramp_sctp = {
     BIO_TYPE_DGRAM_SCTP,
@@ -108,6 +145,46 @@ typedef struct bio_dgram_data_st {
     unsigned int peekmode;
 } bio_dgram_data;
 
+/*
+ * Each receive slot is big enough for a maximum sized DTLS record
+ * (DTLS1_RT_HEADER_LENGTH + SSL3_RT_MAX_ENCRYPTED_LENGTH), anything bigger
+ * is truncated just like it would be by a recvfrom() into a short buffer.
+ */
+# define DGRAM_MMSG_SLOT_SIZE     (18 * 1024)
+# define DGRAM_MMSG_DEFAULT_BATCH 16
+# define DGRAM_MMSG_MAX_BATCH     64
+/* Largest payload the kernel accepts in a single UDP GSO send */
+# define DGRAM_MMSG_MAX_GSO       65000
+
+typedef struct bio_dgram_mmsg_data_st {
+    /* Must be first, the plain datagram ctrls operate on it */
+    bio_dgram_data dgram;
+    /* Receive side: up to |rbatch| datagrams are taken per syscall */
+    unsigned int rbatch;
+    unsigned int rcount;
+    unsigned int rnext;
+    unsigned char *rbuf;
+    unsigned int *rlen;
+    BIO_ADDR *rpeer;
+    /*
+     * Send side: with |wbatch| > 1 datagrams are queued back to back in
+     * |wbuf| and handed to the kernel on BIO_flush() or once the queue fills
+     */
+    unsigned int wbatch;
+    unsigned int wcount;
+    unsigned int wsent;
+    size_t wused;
+    unsigned char *wbuf;
+    size_t *woff;
+    unsigned int *wlen;
+    BIO_ADDR *wpeer;
+    int gso;
+# ifdef OPENSSL_DGRAM_MMSG
+    struct mmsghdr *msgs;
+    struct iovec *iov;
+# endif
+} bio_dgram_mmsg_data;
+
 # ifndef OPENSSL_NO_SCTP
 typedef struct bio_dgram_sctp_save_message_st {
     BIO *bio;
@@ -802,6 +879,456 @@ static int dgram_puts(BIO *bp, const char *str)
     return (ret);
 }
 
+const BIO_METHOD *BIO_s_datagram_mmsg(void)
+{
+    return (&methods_dgramp_mmsg);
+}
+
+BIO *BIO_new_dgram_mmsg(int fd, int close_flag)
+{
+    BIO *ret;
+
+    ret = BIO_new(BIO_s_datagram_mmsg());
+    if (ret == NULL)
+        return (NULL);
+    BIO_set_fd(ret, fd, close_flag);
+    return (ret);
+}
+
+static int dgram_mmsg_new(BIO *bi)
+{
+    bio_dgram_mmsg_data *data = OPENSSL_zalloc(sizeof(*data));
+
+    if (data == NULL)
+        return 0;
+    data->rbatch = DGRAM_MMSG_DEFAULT_BATCH;
+    data->wbatch = 1;
+    bi->ptr = data;
+    return (1);
+}
+
+static void dgram_mmsg_free_rbuf(bio_dgram_mmsg_data *data)
+{
+    OPENSSL_free(data->rbuf);
+    OPENSSL_free(data->rlen);
+    OPENSSL_free(data->rpeer);
+    data->rbuf = NULL;
+    data->rlen = NULL;
+    data->rpeer = NULL;
+    data->rcount = data->rnext = 0;
+}
+
+static void dgram_mmsg_free_wbuf(bio_dgram_mmsg_data *data)
+{
+    OPENSSL_free(data->wbuf);
+    OPENSSL_free(data->woff);
+    OPENSSL_free(data->wlen);
+    OPENSSL_free(data->wpeer);
+    data->wbuf = NULL;
+    data->woff = NULL;
+    data->wlen = NULL;
+    data->wpeer = NULL;
+    data->wcount = data->wsent = 0;
+    data->wused = 0;
+}
+
+static void dgram_mmsg_free_msgs(bio_dgram_mmsg_data *data)
+{
+# ifdef OPENSSL_DGRAM_MMSG
+    OPENSSL_free(data->msgs);
+    OPENSSL_free(data->iov);
+    data->msgs = NULL;
+    data->iov = NULL;
+# endif
+}
+
+static int dgram_mmsg_free(BIO *a)
+{
+    bio_dgram_mmsg_data *data;
+
+    if (a == NULL)
+        return (0);
+
+    data = (bio_dgram_mmsg_data *)a->ptr;
+    dgram_mmsg_free_rbuf(data);
+    dgram_mmsg_free_wbuf(data);
+    dgram_mmsg_free_msgs(data);
+
+    /* dgram_free() releases |data| itself */
+    return dgram_free(a);
+}
+
+/*
+ * The message header and iovec arrays are shared by the send and receive
+ * paths, so they are sized for the larger of the two batches.
+ */
+static int dgram_mmsg_setup_msgs(bio_dgram_mmsg_data *data)
+{
+# ifdef OPENSSL_DGRAM_MMSG
+    if (data->msgs == NULL) {
+        data->msgs = OPENSSL_malloc(sizeof(*data->msgs) * DGRAM_MMSG_MAX_BATCH);
+        data->iov = OPENSSL_malloc(sizeof(*data->iov) * DGRAM_MMSG_MAX_BATCH);
+        if (data->msgs == NULL || data->iov == NULL) {
+            dgram_mmsg_free_msgs(data);
+            return 0;
+        }
+    }
+# endif
+    return 1;
+}
+
+static int dgram_mmsg_setup_rbuf(bio_dgram_mmsg_data *data)
+{
+    if (data->rbuf != NULL)
+        return 1;
+
+    data->rbuf = OPENSSL_malloc((size_t)data->rbatch * DGRAM_MMSG_SLOT_SIZE);
+    data->rlen = OPENSSL_malloc(sizeof(*data->rlen) * data->rbatch);
+    data->rpeer = OPENSSL_malloc(sizeof(*data->rpeer) * data->rbatch);
+    if (data->rbuf == NULL || data->rlen == NULL || data->rpeer == NULL
+            || !dgram_mmsg_setup_msgs(data)) {
+        dgram_mmsg_free_rbuf(data);
+        return 0;
+    }
+    return 1;
+}
+
+static int dgram_mmsg_setup_wbuf(bio_dgram_mmsg_data *data)
+{
+    if (data->wbuf != NULL)
+        return 1;
+
+    data->wbuf = OPENSSL_malloc((size_t)data->wbatch * DGRAM_MMSG_SLOT_SIZE);
+    data->woff = OPENSSL_malloc(sizeof(*data->woff) * data->wbatch);
+    data->wlen = OPENSSL_malloc(sizeof(*data->wlen) * data->wbatch);
+    data->wpeer = OPENSSL_malloc(sizeof(*data->wpeer) * data->wbatch);
+    if (data->wbuf == NULL || data->woff == NULL || data->wlen == NULL
+            || data->wpeer == NULL || !dgram_mmsg_setup_msgs(data)) {
+        dgram_mmsg_free_wbuf(data);
+        return 0;
+    }
+    return 1;
+}
+
+/*
+ * Pull as many datagrams as are available (up to the batch size) off the
+ * socket in one go.  Blocks, subject to the receive timeout, until at least
+ * one arrives.  Returns the number of datagrams queued or <= 0 on error.
+ */
+static int dgram_mmsg_fill(BIO *b, bio_dgram_mmsg_data *data)
+{
+    int ret;
+# ifdef OPENSSL_DGRAM_MMSG
+    unsigned int i;
+# else
+    socklen_t len = sizeof(*data->rpeer);
+# endif
+
+    if (!dgram_mmsg_setup_rbuf(data))
+        return -1;
+
+    data->rcount = data->rnext = 0;
+    memset(data->rpeer, 0, sizeof(*data->rpeer) * data->rbatch);
+
+    clear_socket_error();
+    dgram_adjust_rcv_timeout(b);
+# ifdef OPENSSL_DGRAM_MMSG
+    memset(data->msgs, 0, sizeof(*data->msgs) * data->rbatch);
+    for (i = 0; i < data->rbatch; i++) {
+        data->iov[i].iov_base = data->rbuf + (size_t)i * DGRAM_MMSG_SLOT_SIZE;
+        data->iov[i].iov_len = DGRAM_MMSG_SLOT_SIZE;
+        data->msgs[i].msg_hdr.msg_name =
+            BIO_ADDR_sockaddr_noconst(&data->rpeer[i]);
+        data->msgs[i].msg_hdr.msg_namelen = sizeof(data->rpeer[i]);
+        data->msgs[i].msg_hdr.msg_iov = &data->iov[i];
+        data->msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+    ret = recvmmsg(b->num, data->msgs, data->rbatch, MSG_WAITFORONE, NULL);
+    for (i = 0; ret > 0 && i < (unsigned int)ret; i++)
+        data->rlen[i] = data->msgs[i].msg_len;
+# else
+    ret = recvfrom(b->num, (char *)data->rbuf, DGRAM_MMSG_SLOT_SIZE, 0,
+                   BIO_ADDR_sockaddr_noconst(&data->rpeer[0]), &len);
+    if (ret >= 0) {
+        data->rlen[0] = ret;
+        ret = 1;
+    }
+# endif
+
+    BIO_clear_retry_flags(b);
+    if (ret < 0) {
+        if (BIO_dgram_should_retry(ret)) {
+            BIO_set_retry_read(b);
+            data->dgram._errno = get_last_socket_error();
+        }
+    } else {
+        data->rcount = ret;
+    }
+
+    dgram_reset_rcv_timeout(b);
+    return ret;
+}
+
+static int dgram_mmsg_read(BIO *b, char *out, int outl)
+{
+    int ret;
+    bio_dgram_mmsg_data *data = (bio_dgram_mmsg_data *)b->ptr;
+    unsigned int slot;
+
+    if (out == NULL || outl < 0)
+        return 0;
+
+    if (data->rnext == data->rcount) {
+        /* Peeking at the wire must not consume a whole batch */
+        if (data->dgram.peekmode)
+            return dgram_read(b, out, outl);
+        ret = dgram_mmsg_fill(b, data);
+        if (ret <= 0)
+            return ret;
+    }
+
+    BIO_clear_retry_flags(b);
+    slot = data->rnext;
+    ret = data->rlen[slot];
+    /* As with recvfrom(), the excess of an over-long datagram is lost */
+    if (ret > outl)
+        ret = outl;
+    memcpy(out, data->rbuf + (size_t)slot * DGRAM_MMSG_SLOT_SIZE, ret);
+
+    if (!data->dgram.connected)
+        BIO_ctrl(b, BIO_CTRL_DGRAM_SET_PEER, 0, &data->rpeer[slot]);
+
+    if (!data->dgram.peekmode)
+        data->rnext++;
+    return ret;
+}
+
+# ifdef OPENSSL_DGRAM_GSO
+/*
+ * Try to hand the remaining queue to the kernel as one UDP GSO super-datagram.
+ * This is possible when the socket is connected and every datagram but the
+ * last has the same size.  Returns the number of datagrams sent, 0 if GSO is
+ * not applicable or -1 on error.
+ */
+static int dgram_mmsg_send_gso(BIO *b, bio_dgram_mmsg_data *data)
+{
+    struct msghdr msg;
+    struct cmsghdr *cm;
+    struct iovec iov;
+    union {
+        char buf[CMSG_SPACE(sizeof(uint16_t))];
+        struct cmsghdr align;
+    } control;
+    unsigned int i, n = data->wcount - data->wsent;
+    unsigned int seg = data->wlen[data->wsent];
+    size_t total = data->wused - data->woff[data->wsent];
+    int ret;
+
+    if (!data->gso || !data->dgram.connected || n < 2 || seg == 0
+            || total > DGRAM_MMSG_MAX_GSO)
+        return 0;
+    for (i = data->wsent; i < data->wcount - 1; i++)
+        if (data->wlen[i] != seg)
+            return 0;
+    if (data->wlen[data->wcount - 1] > seg)
+        return 0;
+
+    memset(&msg, 0, sizeof(msg));
+    memset(&control, 0, sizeof(control));
+    iov.iov_base = data->wbuf + data->woff[data->wsent];
+    iov.iov_len = total;
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control.buf;
+    msg.msg_controllen = sizeof(control.buf);
+    cm = CMSG_FIRSTHDR(&msg);
+    cm->cmsg_level = SOL_UDP;
+    cm->cmsg_type = UDP_SEGMENT;
+    cm->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+    *(uint16_t *)CMSG_DATA(cm) = (uint16_t)seg;
+
+    ret = sendmsg(b->num, &msg, 0);
+    if (ret < 0) {
+        if (BIO_dgram_should_retry(ret))
+            return -1;
+        /* No kernel support (or not usable here): don't try again */
+        data->gso = 0;
+        clear_socket_error();
+        return 0;
+    }
+    return n;
+}
+# endif
+
+/*
+ * Send everything that has been queued.  Returns 1 once the queue is empty,
+ * or <= 0 with the retry flags set as for a plain datagram write.
+ */
+static int dgram_mmsg_flush(BIO *b)
+{
+    bio_dgram_mmsg_data *data = (bio_dgram_mmsg_data *)b->ptr;
+    int ret = 1;
+# ifdef OPENSSL_DGRAM_MMSG
+    unsigned int i, n;
+# endif
+
+    BIO_clear_retry_flags(b);
+    while (data->wsent < data->wcount) {
+        clear_socket_error();
+# ifdef OPENSSL_DGRAM_GSO
+        ret = dgram_mmsg_send_gso(b, data);
+        if (ret == 0)
+# endif
+        {
+# ifdef OPENSSL_DGRAM_MMSG
+            n = data->wcount - data->wsent;
+            memset(data->msgs, 0, sizeof(*data->msgs) * n);
+            for (i = 0; i < n; i++) {
+                unsigned int q = data->wsent + i;
+
+                data->iov[i].iov_base = data->wbuf + data->woff[q];
+                data->iov[i].iov_len = data->wlen[q];
+                if (!data->dgram.connected) {
+                    data->msgs[i].msg_hdr.msg_name =
+                        BIO_ADDR_sockaddr_noconst(&data->wpeer[q]);
+                    data->msgs[i].msg_hdr.msg_namelen =
+                        BIO_ADDR_sockaddr_size(&data->wpeer[q]);
+                }
+                data->msgs[i].msg_hdr.msg_iov = &data->iov[i];
+                data->msgs[i].msg_hdr.msg_iovlen = 1;
+            }
+            ret = sendmmsg(b->num, data->msgs, n, 0);
+# else
+            unsigned int q = data->wsent;
+
+            if (data->dgram.connected)
+                ret = writesocket(b->num, data->wbuf + data->woff[q],
+                                  data->wlen[q]);
+            else
+                ret = sendto(b->num, data->wbuf + data->woff[q],
+                             data->wlen[q], 0,
+                             BIO_ADDR_sockaddr(&data->wpeer[q]),
+                             BIO_ADDR_sockaddr_size(&data->wpeer[q]));
+            if (ret >= 0)
+                ret = 1;
+# endif
+        }
+        if (ret <= 0) {
+            if (BIO_dgram_should_retry(ret)) {
+                BIO_set_retry_write(b);
+                data->dgram._errno = get_last_socket_error();
+            }
+            return ret < 0 ? ret : -1;
+        }
+        data->wsent += ret;
+    }
+
+    data->wcount = data->wsent = 0;
+    data->wused = 0;
+    return 1;
+}
+
+static int dgram_mmsg_write(BIO *b, const char *in, int inl)
+{
+    bio_dgram_mmsg_data *data = (bio_dgram_mmsg_data *)b->ptr;
+    int ret;
+    unsigned int q;
+
+    if (data->wbatch <= 1 || inl < 0 || inl > DGRAM_MMSG_SLOT_SIZE) {
+        /* Keep datagrams in order: anything queued goes out first */
+        if (data->wcount > 0 && (ret = dgram_mmsg_flush(b)) <= 0)
+            return ret;
+        return dgram_write(b, in, inl);
+    }
+
+    if (data->wcount == data->wbatch && (ret = dgram_mmsg_flush(b)) <= 0)
+        return ret;
+    if (!dgram_mmsg_setup_wbuf(data))
+        return -1;
+
+    q = data->wcount++;
+    data->woff[q] = data->wused;
+    data->wlen[q] = inl;
+    data->wpeer[q] = data->dgram.peer;
+    memcpy(data->wbuf + data->wused, in, inl);
+    data->wused += inl;
+
+    BIO_clear_retry_flags(b);
+    return inl;
+}
+
+static long dgram_mmsg_ctrl(BIO *b, int cmd, long num, void *ptr)
+{
+    bio_dgram_mmsg_data *data = (bio_dgram_mmsg_data *)b->ptr;
+    long ret = 1;
+
+    switch (cmd) {
+    case BIO_CTRL_RESET:
+    case BIO_C_SET_FD:
+        /* Whatever was queued belongs to the old socket */
+        data->rcount = data->rnext = 0;
+        data->wcount = data->wsent = 0;
+        data->wused = 0;
+        ret = dgram_ctrl(b, cmd, num, ptr);
+        break;
+    case BIO_CTRL_PENDING:
+        /* Size of the next queued datagram, like FIONREAD on a UDP socket */
+        ret = data->rnext < data->rcount ? data->rlen[data->rnext] : 0;
+        break;
+    case BIO_CTRL_WPENDING:
+        /*
+         * Queued datagrams are complete, nothing more can be added to them.
+         * DTLS sizes its next fragment on the assumption that any pending
+         * bytes share the datagram with it, so never report them here.
+         */
+        ret = 0;
+        break;
+    case BIO_CTRL_FLUSH:
+        ret = dgram_mmsg_flush(b);
+        break;
+    case BIO_CTRL_DGRAM_GET_QUEUED:
+        ret = data->rcount - data->rnext;
+        break;
+    case BIO_CTRL_DGRAM_SET_READ_BATCH:
+        if (num < 1 || num > DGRAM_MMSG_MAX_BATCH
+                || data->rnext < data->rcount) {
+            ret = 0;
+            break;
+        }
+        dgram_mmsg_free_rbuf(data);
+        data->rbatch = (unsigned int)num;
+        break;
+    case BIO_CTRL_DGRAM_SET_WRITE_BATCH:
+        if (num < 1 || num > DGRAM_MMSG_MAX_BATCH || data->wcount > 0) {
+            ret = 0;
+            break;
+        }
+        dgram_mmsg_free_wbuf(data);
+        data->wbatch = (unsigned int)num;
+        break;
+    case BIO_CTRL_DGRAM_SET_GSO:
+# ifdef OPENSSL_DGRAM_GSO
+        data->gso = num != 0;
+# else
+        ret = num == 0;
+# endif
+        break;
+    default:
+        ret = dgram_ctrl(b, cmd, num, ptr);
+        break;
+    }
+    return ret;
+}
+
+static int dgram_mmsg_puts(BIO *bp, const char *str)
+{
+    int n, ret;
+
+    n = strlen(str);
+    ret = dgram_mmsg_write(bp, str, n);
+    return (ret);
+}
+
 # ifndef OPENSSL_NO_SCTP
 const BIO_METHOD *BIO_s_datagram_sctp(void)
 {
@@ -0,0 +1,311 @@
+#! /usr/bin/env perl
+# Copyright 2016 The OpenSSL Project Authors. All Rights Reserved.
+#
+# Licensed under the OpenSSL license (the "License").  You may not use
+# this file except in compliance with the License.  You can obtain a copy
+# in the file LICENSE in the source distribution or at
+# https://www.openssl.org/source/license.html
+#
+# November 2016
+#
+# Almost Montgomery Multiplication in radix 2^52 with AVX512IFMA for
+# 1024-, 1536- and 2048-bit moduli, i.e. CRT halves of RSA-2048, 3072
+# and 4096. Numbers are held in 20, 30 and 40 52-bit limbs, four limbs
+# per 256-bit register, and the result is r = a*b/2^(52*n) mod m with
+# r < 2*m for a, b < 2*m. Multiply-accumulate of low and high halves
+# of the 104-bit limb products is done with VPMADD52LUQ and VPMADD52HUQ;
+# high halves are added after the accumulator is shifted down by one
+# limb, which puts them in the right place. Limbs are allowed to grow
+# past 52 bits within the loop and are normalized once at the end.
+#
+# 256-bit registers are used, rather than 512-bit ones, in order to
+# avoid frequency drop on processors that penalize the latter, and only
+# %ymm16-31 are used, which are volatile on Windows too.
+#
+# The exponentiation itself is in crypto/bn/rsaz_exp.c.
+#
+# rsa sign/sec		scalar(*)	this
+#			2048	3072	4096	2048	3072	4096
+# Ice Lake-class	921	304	118	1690(**)446	230
+#
+# (*)	ADCX/ADOX code path in x86_64-mont5.pl.
+# (**)	Both CRT halves at once with the x2 subroutine, 1166 with x1.
+
+$flavour = shift;
+$output  = shift;
+if ($flavour =~ /\./) { $output = $flavour; undef $flavour; }
+
+$win64=0; $win64=1 if ($flavour =~ /[nm]asm|mingw64/ || $output =~ /\.asm$/);
+
+$0 =~ m/(.*[\/\\])[^\/\\]+$/; $dir=$1;
+( $xlate="${dir}x86_64-xlate.pl" and -f $xlate ) or
+( $xlate="${dir}../../perlasm/x86_64-xlate.pl" and -f $xlate) or
+die "can't locate x86_64-xlate.pl";
+
+if (`$ENV{CC} -Wa,-v -c -o /dev/null -x assembler /dev/null 2>&1`
+		=~ /GNU assembler version ([2-9]\.[0-9]+)/) {
+	$avx512ifma = ($1>=2.26);
+}
+
+if (!$avx512ifma && $win64 && ($flavour =~ /nasm/ || $ENV{ASM} =~ /nasm/) &&
+	    `nasm -v 2>&1` =~ /NASM version ([2-9]\.[0-9]+)/) {
+	$avx512ifma = ($1>=2.11);
+}
+
+if (!$avx512ifma && `$ENV{CC} -v 2>&1` =~ /((?:^clang|LLVM) version|.*based on LLVM) ([3-9]\.[0-9]+)/) {
+	$avx512ifma = ($2>=7.0);
+}
+
+open OUT,"| \"$^X\" \"$xlate\" $flavour \"$output\"";
+*STDOUT=*OUT;
+
+if ($avx512ifma) {{{
+my ($rp,$ap,$bp,$np,$k0)=("%rdi","%rsi","%r11","%rcx","%r8");
+my ($acc,$mask,$cnt)=("%r9","%r10","%eax");
+my ($Bi,$Yi,$zero)=map("%ymm$_",(26..28));
+
+$code.=<<___;
+.text
+
+.extern	OPENSSL_ia32cap_P
+.globl	rsaz_avx512ifma_eligible
+.type	rsaz_avx512ifma_eligible,\@abi-omnipotent
+.align	32
+rsaz_avx512ifma_eligible:
+	mov	OPENSSL_ia32cap_P+8(%rip),%ecx
+	xor	%eax,%eax
+	and	\$`1<<8|1<<16|1<<17|1<<21|1<<31`,%ecx	# BMI2, AVX512F/DQ/IFMA/VL
+	cmp	\$`1<<8|1<<16|1<<17|1<<21|1<<31`,%ecx
+	sete	%al
+	ret
+.size	rsaz_avx512ifma_eligible,.-rsaz_avx512ifma_eligible
+___
+
+# void rsaz_amm52x${n}_x1_avx512ifma(BN_ULONG *res, const BN_ULONG *a,
+#                                    const BN_ULONG *b, const BN_ULONG *m,
+#                                    BN_ULONG k0);
+# void rsaz_amm52x${n}_x2_avx512ifma(BN_ULONG *res, const BN_ULONG *a,
+#                                    const BN_ULONG *b, const BN_ULONG *m,
+#                                    const BN_ULONG k0[2]);
+#
+# All operands are 52-bit limb vectors zero-padded to a multiple of 4
+# limbs, k0 = -m^-1 mod 2^52. The x2 flavour performs two independent
+# multiplications, each operand being two such vectors back to back,
+# interleaving their dependency chains.
+#
+# The lowest limb of the accumulator is tracked in $acc with full 104-bit
+# products of a[0] and m[0], so that y can be computed without waiting
+# for the vector unit. Lane 0 of the accumulator registers is stale
+# after the shift and is never used. If registers allow, products with
+# a and m are accumulated separately, which halves dependency chains in
+# the vector unit. That matters for 20 limbs, longer operands are bound
+# by multiplication throughput anyway.
+sub amm52 {
+my ($n,$x)=@_;
+my $r=($n+3)>>2;			# number of registers per number
+my $split=($x==1 && 2*$r<=13);
+my (@R,@S,@Bi,@Yi,@acc,@off);
+my $zero="%ymm28";
+
+for (my $l=0,my $i=16;$l<$x;$l++) {
+    $R[$l]=[map("%ymm$_",($i..$i+$r-1))];	# accumulator for a*b[i]
+    $i+=$r;
+    if ($split) {				# ... for m*y
+	$S[$l]=[map("%ymm$_",($i..$i+$r-1))];
+	$i+=$r;
+    } else {
+	$S[$l]=$R[$l];
+    }
+    ($Bi[$l],$Yi[$l])=$l ? ("%ymm29","%ymm30") : ("%ymm26","%ymm27");
+    $acc[$l]=$l ? "%r14" : $acc;
+    $off[$l]=32*$r*$l;
+}
+my $func="rsaz_amm52x${n}_x${x}_avx512ifma";
+
+$code.=<<___;
+.globl	$func
+.type	$func,\@function,5
+.align	32
+$func:
+	push		%rbx
+	push		%r12
+	push		%r13
+___
+$code.=<<___	if ($x>1);
+	push		%r14
+___
+$code.=<<___;
+	mov		%rdx,$bp
+	vpxord		$zero,$zero,$zero
+___
+for (my $l=0;$l<$x;$l++) {
+    for (my $k=0;$k<$r;$k++) {
+$code.=<<___;
+	vmovdqa64	$zero,$R[$l][$k]
+___
+$code.=<<___	if ($split);
+	vmovdqa64	$zero,$S[$l][$k]
+___
+    }
+$code.=<<___;
+	xor		$acc[$l],$acc[$l]
+___
+}
+$code.=<<___;
+	mov		\$0xfffffffffffff,$mask
+	mov		\$$n,$cnt
+	jmp		.Loop_amm52x${n}_x$x
+
+.align	32
+.Loop_amm52x${n}_x$x:
+___
+for (my $l=0;$l<$x;$l++) {
+my $k0i = $x>1 ? "`8*$l`($k0)" : $k0;
+$code.=<<___;
+	mov		$off[$l]($bp),%r13	# b[i]
+	vpbroadcastq	%r13,$Bi[$l]
+	mov		$off[$l]($ap),%rdx
+	mulx		%r13,%r13,%r12		# a[0]*b[i]
+	add		%r13,$acc[$l]
+	mov		%r12,%rbx
+	adc		\$0,%rbx
+
+	mov		$k0i,%r13
+	imul		$acc[$l],%r13
+	and		$mask,%r13		# y = acc*k0 mod 2^52
+	vpbroadcastq	%r13,$Yi[$l]
+	mov		$off[$l]($np),%rdx
+	mulx		%r13,%r13,%r12		# m[0]*y
+	add		%r13,$acc[$l]
+	adc		%r12,%rbx
+
+	shr		\$52,$acc[$l]		# acc is divisible by 2^52 now
+	shl		\$12,%rbx
+	or		%rbx,$acc[$l]
+___
+}
+$code.=<<___;
+	lea		8($bp),$bp
+___
+for (my $l=0;$l<$x;$l++) {
+    for (my $k=0;$k<$r;$k++) {
+$code.=<<___;
+	vpmadd52luq	`$off[$l]+32*$k`($ap),$Bi[$l],$R[$l][$k]
+___
+    }
+    for (my $k=0;$k<$r;$k++) {
+$code.=<<___;
+	vpmadd52luq	`$off[$l]+32*$k`($np),$Yi[$l],$S[$l][$k]
+___
+    }
+}
+for (my $l=0;$l<$x;$l++) {
+my ($R0x,$S0x)=map { my $t=$_; $t=~s/y/x/; $t } ($R[$l][0],$S[$l][0]);
+$code.=<<___;
+	vpextrq		\$1,$R0x,%r13		# limb 1 becomes limb 0
+	add		%r13,$acc[$l]
+___
+$code.=<<___	if ($split);
+	vpextrq		\$1,$S0x,%r13
+	add		%r13,$acc[$l]
+___
+    for (my $k=0;$k<$r;$k++) {		# shift accumulator down by a limb
+    my $next = $k<$r-1 ? $R[$l][$k+1] : $zero;
+$code.=<<___;
+	valignq		\$1,$R[$l][$k],$next,$R[$l][$k]
+___
+    }
+    for (my $k=0;$split && $k<$r;$k++) {
+    my $next = $k<$r-1 ? $S[$l][$k+1] : $zero;
+$code.=<<___;
+	valignq		\$1,$S[$l][$k],$next,$S[$l][$k]
+___
+    }
+}
+for (my $l=0;$l<$x;$l++) {
+    for (my $k=0;$k<$r;$k++) {		# high halves land one limb lower
+$code.=<<___;
+	vpmadd52huq	`$off[$l]+32*$k`($ap),$Bi[$l],$R[$l][$k]
+___
+    }
+    for (my $k=0;$k<$r;$k++) {
+$code.=<<___;
+	vpmadd52huq	`$off[$l]+32*$k`($np),$Yi[$l],$S[$l][$k]
+___
+    }
+}
+$code.=<<___;
+	dec		$cnt
+	jnz		.Loop_amm52x${n}_x$x
+___
+for (my $l=0;$l<$x;$l++) {
+    for (my $k=0;$k<$r;$k++) {
+$code.=<<___	if ($split);
+	vpaddq		$S[$l][$k],$R[$l][$k],$R[$l][$k]
+___
+$code.=<<___;
+	vmovdqu64	$R[$l][$k],`$off[$l]+32*$k`($rp)
+___
+    }
+$code.=<<___;
+	mov		$acc[$l],$off[$l]($rp)	# lane 0 is in acc
+	xor		%eax,%eax		# propagate carries
+___
+    for (my $j=0;$j<$n;$j++) {
+$code.=<<___;
+	add		`$off[$l]+8*$j`($rp),%rax
+	mov		%rax,%rdx
+	shr		\$52,%rax
+	and		$mask,%rdx
+	mov		%rdx,`$off[$l]+8*$j`($rp)
+___
+    }
+}
+$code.=<<___;
+	vzeroupper
+___
+$code.=<<___	if ($x>1);
+	pop		%r14
+___
+$code.=<<___;
+	pop		%r13
+	pop		%r12
+	pop		%rbx
+	ret
+.size	$func,.-$func
+___
+}
+
+amm52(20,1);
+amm52(30,1);
+amm52(40,1);
+amm52(20,2);
+}}} else {{{
+$code.=<<___;	# assembler is too old
+.text
+
+.globl	rsaz_avx512ifma_eligible
+.type	rsaz_avx512ifma_eligible,\@abi-omnipotent
+rsaz_avx512ifma_eligible:
+	xor	%eax,%eax
+	ret
+.size	rsaz_avx512ifma_eligible,.-rsaz_avx512ifma_eligible
+
+.globl	rsaz_amm52x20_x1_avx512ifma
+.globl	rsaz_amm52x30_x1_avx512ifma
+.globl	rsaz_amm52x40_x1_avx512ifma
+.globl	rsaz_amm52x20_x2_avx512ifma
+.type	rsaz_amm52x20_x1_avx512ifma,\@abi-omnipotent
+rsaz_amm52x20_x1_avx512ifma:
+rsaz_amm52x30_x1_avx512ifma:
+rsaz_amm52x40_x1_avx512ifma:
+rsaz_amm52x20_x2_avx512ifma:
+	.byte	0x0f,0x0b	# ud2
+	ret
+.size	rsaz_amm52x20_x1_avx512ifma,.-rsaz_amm52x20_x1_avx512ifma
+___
+}}}
+
+$code =~ s/\`([^\`]*)\`/eval $1/gem;
+print $code;
+close STDOUT;
@@ -7,7 +7,7 @@
  * https://www.openssl.org/source/license.html
  */
 
-#include "internal/cryptlib.h"
+#include "internal/cryptlib_int.h"
 #include "bn_lcl.h"
 
 /*-
@@ -36,6 +36,9 @@
 typedef struct bignum_pool_item {
     /* The bignum values */
     BIGNUM vals[BN_CTX_POOL_SIZE];
+    /* Initial limbs of all the values in one block, if an arena is used */
+    BN_ULONG *arena;
+    int words;
     /* Linked-list admin */
     struct bignum_pool_item *prev, *next;
 } BN_POOL_ITEM;
@@ -45,9 +48,12 @@ typedef struct bignum_pool {
     BN_POOL_ITEM *head, *current, *tail;
     /* Stack depth and allocation size */
     unsigned used, size;
+    /* Words of arena storage for each bignum, zero without an arena */
+    int words;
 } BN_POOL;
 static void BN_POOL_init(BN_POOL *);
 static void BN_POOL_finish(BN_POOL *);
+static void BN_POOL_cleanse(BN_POOL *);
 static BIGNUM *BN_POOL_get(BN_POOL *, int);
 static void BN_POOL_release(BN_POOL *, unsigned int);
 
@@ -85,6 +91,8 @@ struct bignum_ctx {
     int too_many;
     /* Flags. */
     int flags;
+    /* Set while the thread's cached BN_CTX is handed out */
+    int busy;
 };
 
 /* Enable this to find BN_CTX bugs */
@@ -154,6 +162,26 @@ BN_CTX *BN_CTX_secure_new(void)
     return ret;
 }
 
+/*
+ * Products and Montgomery reductions need twice the words of the modulus,
+ * plus a couple for carries.
+ */
+static int bn_arena_words(int bits)
+{
+    if (bits <= 0)
+        return 0;
+    return 2 * ((bits + BN_BITS2 - 1) / BN_BITS2) + 2;
+}
+
+BN_CTX *BN_CTX_arena_new(int bits)
+{
+    BN_CTX *ret = BN_CTX_new();
+
+    if (ret != NULL)
+        ret->pool.words = bn_arena_words(bits);
+    return ret;
+}
+
 void BN_CTX_free(BN_CTX *ctx)
 {
     if (ctx == NULL)
@@ -209,6 +237,78 @@ void BN_CTX_end(BN_CTX *ctx)
     CTXDBG_EXIT(ctx);
 }
 
+/*
+ * Each thread keeps one arena BN_CTX for the public key operations of the
+ * library, so that they need not allocate any memory once it has grown to
+ * fit them. It is cleansed between uses and freed when the thread stops.
+ */
+static CRYPTO_ONCE bn_ctx_thread_once = CRYPTO_ONCE_STATIC_INIT;
+static CRYPTO_THREAD_LOCAL bn_ctx_thread_local;
+static int bn_ctx_thread_inited = 0;
+
+static void bn_ctx_thread_init(void)
+{
+    bn_ctx_thread_inited = CRYPTO_THREAD_init_local(&bn_ctx_thread_local,
+                                                    NULL);
+}
+
+BN_CTX *bn_ctx_thread_get(int bits)
+{
+    BN_CTX *ctx;
+
+    if (!CRYPTO_THREAD_run_once(&bn_ctx_thread_once, bn_ctx_thread_init)
+        || !bn_ctx_thread_inited)
+        return BN_CTX_arena_new(bits);
+
+    ctx = CRYPTO_THREAD_get_local(&bn_ctx_thread_local);
+    if (ctx == NULL) {
+        if (!OPENSSL_init_crypto(0, NULL)
+            || !ossl_init_thread_start(OPENSSL_INIT_THREAD_BN_CTX))
+            return BN_CTX_arena_new(bits);
+        if ((ctx = BN_CTX_arena_new(bits)) == NULL)
+            return NULL;
+        if (!CRYPTO_THREAD_set_local(&bn_ctx_thread_local, ctx))
+            return ctx;
+    } else if (ctx->busy) {
+        /* Nested operation, e.g. from a callback */
+        return BN_CTX_arena_new(bits);
+    } else if (ctx->pool.words < bn_arena_words(bits)) {
+        /* Values already handed out are expanded when they are used */
+        ctx->pool.words = bn_arena_words(bits);
+    }
+    ctx->busy = 1;
+    return ctx;
+}
+
+void bn_ctx_thread_put(BN_CTX *ctx)
+{
+    if (ctx == NULL)
+        return;
+    if (!ctx->busy || ctx->used != 0 || ctx->stack.depth != 0
+        || ctx->err_stack || ctx->too_many) {
+        if (ctx->busy)
+            bn_ctx_delete_thread_state();
+        else
+            BN_CTX_free(ctx);
+        return;
+    }
+    BN_POOL_cleanse(&ctx->pool);
+    ctx->busy = 0;
+}
+
+void bn_ctx_delete_thread_state(void)
+{
+    BN_CTX *ctx;
+
+    if (!bn_ctx_thread_inited)
+        return;
+    ctx = CRYPTO_THREAD_get_local(&bn_ctx_thread_local);
+    if (ctx == NULL)
+        return;
+    CRYPTO_THREAD_set_local(&bn_ctx_thread_local, NULL);
+    BN_CTX_free(ctx);
+}
+
 BIGNUM *BN_CTX_get(BN_CTX *ctx)
 {
     BIGNUM *ret;
@@ -281,23 +381,45 @@ static void BN_POOL_init(BN_POOL *p)
 {
     p->head = p->current = p->tail = NULL;
     p->used = p->size = 0;
+    p->words = 0;
 }
 
 static void BN_POOL_finish(BN_POOL *p)
 {
     unsigned int loop;
     BIGNUM *bn;
+    BN_ULONG *arena;
 
     while (p->head) {
         for (loop = 0, bn = p->head->vals; loop++ < BN_CTX_POOL_SIZE; bn++)
             if (bn->d)
                 BN_clear_free(bn);
+        if ((arena = p->head->arena) != NULL) {
+            OPENSSL_cleanse(arena, BN_CTX_POOL_SIZE * p->head->words
+                                   * sizeof(*arena));
+            if (CRYPTO_secure_allocated(arena))
+                OPENSSL_secure_free(arena);
+            else
+                OPENSSL_free(arena);
+        }
         p->current = p->head->next;
         OPENSSL_free(p->head);
         p->head = p->current;
     }
 }
 
+static void BN_POOL_cleanse(BN_POOL *p)
+{
+    BN_POOL_ITEM *item;
+    unsigned int loop;
+    BIGNUM *bn;
+
+    for (item = p->head; item != NULL; item = item->next)
+        for (loop = 0, bn = item->vals; loop++ < BN_CTX_POOL_SIZE; bn++)
+            if (bn->d)
+                OPENSSL_cleanse(bn->d, bn->dmax * sizeof(bn->d[0]));
+}
+
 
 static BIGNUM *BN_POOL_get(BN_POOL *p, int flag)
 {
@@ -309,10 +431,27 @@ static BIGNUM *BN_POOL_get(BN_POOL *p, int flag)
         BN_POOL_ITEM *item = OPENSSL_malloc(sizeof(*item));
         if (item == NULL)
             return NULL;
-        for (loop = 0, bn = item->vals; loop++ < BN_CTX_POOL_SIZE; bn++) {
+        item->arena = NULL;
+        item->words = p->words;
+        if (p->words > 0) {
+            size_t len = BN_CTX_POOL_SIZE * p->words * sizeof(BN_ULONG);
+
+            if ((flag & BN_FLG_SECURE) != 0)
+                item->arena = OPENSSL_secure_zalloc(len);
+            else
+                item->arena = OPENSSL_zalloc(len);
+            /* Without an arena the values are simply allocated as needed */
+        }
+        for (loop = 0, bn = item->vals; loop < BN_CTX_POOL_SIZE;
+             loop++, bn++) {
             bn_init(bn);
             if ((flag & BN_FLG_SECURE) != 0)
                 BN_set_flags(bn, BN_FLG_SECURE);
+            if (item->arena != NULL) {
+                bn->d = item->arena + loop * p->words;
+                bn->dmax = p->words;
+                BN_set_flags(bn, BN_FLG_ARENA);
+            }
         }
         item->prev = p->tail;
         item->next = NULL;
@@ -658,7 +658,28 @@ int BN_mod_exp_mont_consttime(BIGNUM *rr, const BIGNUM *a, const BIGNUM *p,
      * RSAZ exponentiation. For further information see
      * crypto/bn/rsaz_exp.c and accompanying assembly modules.
      */
-    if ((16 == a->top) && (16 == p->top) && (BN_num_bits(m) == 1024)
+    if ((16 == top || 24 == top || 32 == top) && a->top <= top
+        && p->top <= top && !a->neg && BN_ucmp(a, m) < 0
+        && rsaz_avx512ifma_eligible()) {
+        BN_ULONG base_norm[32], exp_norm[32], rr_norm[32];
+
+        if (!bn_copy_words(base_norm, a, top)
+            || !bn_copy_words(exp_norm, p, top)
+            || !bn_copy_words(rr_norm, &mont->RR, top)
+            || bn_wexpand(rr, top) == NULL
+            || !RSAZ_mod_exp_avx512(rr->d, base_norm, exp_norm, m->d,
+                                    rr_norm, mont->n0[0], top * BN_BITS2,
+                                    BN_num_bits(p))) {
+            OPENSSL_cleanse(exp_norm, sizeof(exp_norm));
+            goto err;
+        }
+        OPENSSL_cleanse(exp_norm, sizeof(exp_norm));
+        rr->top = top;
+        rr->neg = 0;
+        bn_correct_top(rr);
+        ret = 1;
+        goto err;
+    } else if ((16 == a->top) && (16 == p->top) && (BN_num_bits(m) == 1024)
         && rsaz_avx2_eligible()) {
         if (NULL == bn_wexpand(rr, 16))
             goto err;
@@ -1094,6 +1115,274 @@ int BN_mod_exp_mont_consttime(BIGNUM *rr, const BIGNUM *a, const BIGNUM *p,
     return (ret);
 }
 
+/*
+ * rr1 = a1^p1 mod m1 and rr2 = a2^p2 mod m2 in constant time. With
+ * AVX512IFMA and moduli of the same supported size the two are computed
+ * together, otherwise this is two calls to BN_mod_exp_mont_consttime().
+ */
+int BN_mod_exp_mont_consttime_x2(BIGNUM *rr1, const BIGNUM *a1,
+                                 const BIGNUM *p1, const BIGNUM *m1,
+                                 BN_MONT_CTX *in_mont1,
+                                 BIGNUM *rr2, const BIGNUM *a2,
+                                 const BIGNUM *p2, const BIGNUM *m2,
+                                 BN_MONT_CTX *in_mont2, BN_CTX *ctx)
+{
+    int ret = 0;
+#ifdef RSAZ_ENABLED
+    BN_MONT_CTX *mont1 = NULL, *mont2 = NULL;
+    int top = m1->top;
+
+    if ((16 == top || 24 == top || 32 == top) && m2->top == top
+        && BN_is_odd(m1) && BN_is_odd(m2)
+        && a1->top <= top && p1->top <= top && !a1->neg
+        && BN_ucmp(a1, m1) < 0 && !BN_is_zero(p1)
+        && a2->top <= top && p2->top <= top && !a2->neg
+        && BN_ucmp(a2, m2) < 0 && !BN_is_zero(p2)
+        && rsaz_avx512ifma_eligible()) {
+        BN_ULONG base1[32], exp1[32], rr_norm1[32];
+        BN_ULONG base2[32], exp2[32], rr_norm2[32];
+
+        if ((mont1 = in_mont1) == NULL) {
+            if ((mont1 = BN_MONT_CTX_new()) == NULL
+                || !BN_MONT_CTX_set(mont1, m1, ctx))
+                goto err;
+        }
+        if ((mont2 = in_mont2) == NULL) {
+            if ((mont2 = BN_MONT_CTX_new()) == NULL
+                || !BN_MONT_CTX_set(mont2, m2, ctx))
+                goto err;
+        }
+
+        if (!bn_copy_words(base1, a1, top)
+            || !bn_copy_words(exp1, p1, top)
+            || !bn_copy_words(rr_norm1, &mont1->RR, top)
+            || !bn_copy_words(base2, a2, top)
+            || !bn_copy_words(exp2, p2, top)
+            || !bn_copy_words(rr_norm2, &mont2->RR, top)
+            || bn_wexpand(rr1, top) == NULL
+            || bn_wexpand(rr2, top) == NULL
+            || !RSAZ_mod_exp_avx512_x2(rr1->d, base1, exp1, m1->d, rr_norm1,
+                                       mont1->n0[0],
+                                       rr2->d, base2, exp2, m2->d, rr_norm2,
+                                       mont2->n0[0], top * BN_BITS2)) {
+            OPENSSL_cleanse(exp1, sizeof(exp1));
+            OPENSSL_cleanse(exp2, sizeof(exp2));
+            goto err;
+        }
+        OPENSSL_cleanse(exp1, sizeof(exp1));
+        OPENSSL_cleanse(exp2, sizeof(exp2));
+        rr1->top = top;
+        rr1->neg = 0;
+        bn_correct_top(rr1);
+        rr2->top = top;
+        rr2->neg = 0;
+        bn_correct_top(rr2);
+        ret = 1;
+ err:
+        if (in_mont1 == NULL)
+            BN_MONT_CTX_free(mont1);
+        if (in_mont2 == NULL)
+            BN_MONT_CTX_free(mont2);
+        return ret;
+    }
+#endif
+
+    ret = BN_mod_exp_mont_consttime(rr1, a1, p1, m1, ctx, in_mont1)
+          && BN_mod_exp_mont_consttime(rr2, a2, p2, m2, ctx, in_mont2);
+    return ret;
+}
+
+/*
+ * Fixed-base exponentiation with the comb method of Lim and Lee. For
+ * exponents of up to |bits| bits, split into |window| rows of |spacing|
+ * bits each, table entry i holds the product of g^(2^(j*spacing)) over the
+ * bits j set in i. One column of the exponent selects one entry, so g^p
+ * takes |spacing| squarings and multiplications instead of |bits|
+ * squarings. The table uses the layout of BN_mod_exp_mont_consttime(), and
+ * every column is looked up the same way, so the exponent is not revealed.
+ */
+struct bn_fixed_base_st {
+    int references;
+    CRYPTO_RWLOCK *lock;
+    BN_MONT_CTX *mont;
+    BIGNUM *g;
+    int bits;
+    int window;
+    int spacing;
+    size_t table_len;
+    unsigned char *table_free;
+    unsigned char *table;
+};
+
+BN_FIXED_BASE *bn_fixed_base_new(const BIGNUM *g, const BIGNUM *m, int bits,
+                                 BN_CTX *ctx)
+{
+    BN_FIXED_BASE *fb;
+    BIGNUM *tmp, *am;
+    int i, j, k, top = m->top;
+
+    if (bits <= 0 || !BN_is_odd(m))
+        return NULL;
+
+    if ((fb = OPENSSL_zalloc(sizeof(*fb))) == NULL)
+        return NULL;
+    fb->references = 1;
+    fb->bits = bits;
+    fb->window = BN_window_bits_for_fixed_base_exponent_size(bits);
+    fb->spacing = (bits + fb->window - 1) / fb->window;
+    fb->table_len = sizeof(m->d[0]) * top * (1 << fb->window);
+    fb->lock = CRYPTO_THREAD_lock_new();
+    fb->mont = BN_MONT_CTX_new();
+    fb->g = BN_dup(g);
+    fb->table_free =
+        OPENSSL_zalloc(fb->table_len + MOD_EXP_CTIME_MIN_CACHE_LINE_WIDTH);
+    if (fb->lock == NULL || fb->mont == NULL || fb->g == NULL
+        || fb->table_free == NULL || !BN_MONT_CTX_set(fb->mont, m, ctx)) {
+        bn_fixed_base_free(fb);
+        return NULL;
+    }
+    fb->table = MOD_EXP_CTIME_ALIGN(fb->table_free);
+
+    BN_CTX_start(ctx);
+    tmp = BN_CTX_get(ctx);
+    am = BN_CTX_get(ctx);
+    if (am == NULL
+        || !BN_to_montgomery(tmp, BN_value_one(), fb->mont, ctx)
+        || !MOD_EXP_CTIME_COPY_TO_PREBUF(tmp, top, fb->table, 0, fb->window)
+        || !BN_nnmod(am, g, m, ctx)
+        || !BN_to_montgomery(am, am, fb->mont, ctx))
+        goto err;
+
+    for (j = 0; j < fb->window; j++) {
+        /* am = g^(2^(j*spacing)), then fill in the entries with bit j set */
+        for (k = 0; j > 0 && k < fb->spacing; k++)
+            if (!BN_mod_mul_montgomery(am, am, am, fb->mont, ctx))
+                goto err;
+        for (i = 0; i < (1 << j); i++) {
+            if (!MOD_EXP_CTIME_COPY_FROM_PREBUF(tmp, top, fb->table, i,
+                                                fb->window)
+                || !BN_mod_mul_montgomery(tmp, tmp, am, fb->mont, ctx)
+                || !MOD_EXP_CTIME_COPY_TO_PREBUF(tmp, top, fb->table,
+                                                 (1 << j) + i, fb->window))
+                goto err;
+        }
+    }
+    BN_CTX_end(ctx);
+    return fb;
+
+ err:
+    BN_CTX_end(ctx);
+    bn_fixed_base_free(fb);
+    return NULL;
+}
+
+int bn_fixed_base_up_ref(BN_FIXED_BASE *fb)
+{
+    int i;
+
+    if (CRYPTO_atomic_add(&fb->references, 1, &i, fb->lock) <= 0)
+        return 0;
+    return i > 1 ? 1 : 0;
+}
+
+int bn_fixed_base_bits(const BN_FIXED_BASE *fb)
+{
+    return fb->bits;
+}
+
+void bn_fixed_base_free(BN_FIXED_BASE *fb)
+{
+    int i;
+
+    if (fb == NULL)
+        return;
+    if (fb->lock != NULL) {
+        CRYPTO_atomic_add(&fb->references, -1, &i, fb->lock);
+        if (i > 0)
+            return;
+    }
+    CRYPTO_THREAD_lock_free(fb->lock);
+    BN_MONT_CTX_free(fb->mont);
+    BN_free(fb->g);
+    if (fb->table_free != NULL) {
+        OPENSSL_cleanse(fb->table_free,
+                        fb->table_len + MOD_EXP_CTIME_MIN_CACHE_LINE_WIDTH);
+        OPENSSL_free(fb->table_free);
+    }
+    OPENSSL_free(fb);
+}
+
+BN_FIXED_BASE *bn_fixed_base_set_locked(BN_FIXED_BASE **pfb,
+                                        CRYPTO_RWLOCK *lock,
+                                        const BIGNUM *g, const BIGNUM *m,
+                                        int bits, BN_CTX *ctx)
+{
+    BN_FIXED_BASE *ret;
+
+    CRYPTO_THREAD_read_lock(lock);
+    ret = *pfb;
+    CRYPTO_THREAD_unlock(lock);
+    if (ret != NULL)
+        return ret;
+
+    /* As in BN_MONT_CTX_set_locked(), racing threads each do the work */
+    if ((ret = bn_fixed_base_new(g, m, bits, ctx)) == NULL)
+        return NULL;
+
+    CRYPTO_THREAD_write_lock(lock);
+    if (*pfb != NULL) {
+        bn_fixed_base_free(ret);
+        ret = *pfb;
+    } else
+        *pfb = ret;
+    CRYPTO_THREAD_unlock(lock);
+    return ret;
+}
+
+int bn_fixed_base_exp(BIGNUM *rr, const BIGNUM *p, const BN_FIXED_BASE *fb,
+                      BN_CTX *ctx)
+{
+    BIGNUM *tmp, *am;
+    int i, j, wvalue, ret = 0;
+    int top = fb->mont->N.top;
+
+    bn_check_top(p);
+
+    if (BN_num_bits(p) > fb->bits || BN_is_zero(p) || BN_is_negative(p))
+        return BN_mod_exp_mont_consttime(rr, fb->g, p, &fb->mont->N, ctx,
+                                         fb->mont);
+
+    BN_CTX_start(ctx);
+    tmp = BN_CTX_get(ctx);
+    am = BN_CTX_get(ctx);
+    if (am == NULL)
+        goto err;
+
+    for (i = fb->spacing - 1; i >= 0; i--) {
+        for (wvalue = 0, j = fb->window - 1; j >= 0; j--)
+            wvalue = (wvalue << 1) + BN_is_bit_set(p, j * fb->spacing + i);
+
+        if (i == fb->spacing - 1) {
+            if (!MOD_EXP_CTIME_COPY_FROM_PREBUF(tmp, top, fb->table, wvalue,
+                                                fb->window))
+                goto err;
+            continue;
+        }
+        if (!BN_mod_mul_montgomery(tmp, tmp, tmp, fb->mont, ctx)
+            || !MOD_EXP_CTIME_COPY_FROM_PREBUF(am, top, fb->table, wvalue,
+                                               fb->window)
+            || !BN_mod_mul_montgomery(tmp, tmp, am, fb->mont, ctx))
+            goto err;
+    }
+
+    if (!BN_from_montgomery(rr, tmp, fb->mont, ctx))
+        goto err;
+    ret = 1;
+ err:
+    BN_CTX_end(ctx);
+    return ret;
+}
+
 int BN_mod_exp_mont_word(BIGNUM *rr, BN_ULONG a, const BIGNUM *p,
                          const BIGNUM *m, BN_CTX *ctx, BN_MONT_CTX *in_mont)
 {
@@ -217,6 +217,13 @@ BN_ULONG bn_add_words(BN_ULONG *rp, const BN_ULONG *ap, const BN_ULONG *bp,
 BN_ULONG bn_sub_words(BN_ULONG *rp, const BN_ULONG *ap, const BN_ULONG *bp,
                       int num);
 
+/*
+ * Internal flag for BIGNUMs whose limbs are part of the arena of a BN_CTX.
+ * The limbs are not freed with the BIGNUM, and expanding it moves them to
+ * the heap.
+ */
+# define BN_FLG_ARENA            0x100
+
 struct bignum_st {
     BN_ULONG *d;                /* Pointer to an array of 'BN_BITS2' bit
                                  * chunks. */
@@ -262,6 +269,10 @@ struct bn_gencb_st {
         /* if(ver==2) - new callback style */
         int (*cb_2) (int, int, BN_GENCB *);
     } cb;
+    /* set with BN_GENCB_set_thread_pool() */
+    CRYPTO_RUN_TASKS *run_tasks;
+    void *pool;
+    int tasks;
 };
 
 /*-
@@ -330,6 +341,14 @@ struct bn_gencb_st {
 
 # endif
 
+/*
+ * Number of rows of the comb used by bn_fixed_base_exp(). Its table holds
+ * 2^w values, and every lookup reads all of them, which only pays off for
+ * longer exponents.
+ */
+# define BN_window_bits_for_fixed_base_exponent_size(b) \
+                ((b) > 2048 ? 6 : 5)
+
 /* Pentium pro 16,16,16,32,64 */
 /* Alpha       16,16,16,16.64 */
 # define BN_MULL_SIZE_NORMAL                     (16)/* 32 */
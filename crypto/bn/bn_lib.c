@@ -186,7 +186,7 @@ void BN_clear_free(BIGNUM *a)
     bn_check_top(a);
     if (a->d != NULL) {
         OPENSSL_cleanse(a->d, a->dmax * sizeof(a->d[0]));
-        if (!BN_get_flags(a, BN_FLG_STATIC_DATA))
+        if (!BN_get_flags(a, BN_FLG_STATIC_DATA | BN_FLG_ARENA))
             bn_free_d(a);
     }
     i = BN_get_flags(a, BN_FLG_MALLOCED);
@@ -200,7 +200,7 @@ void BN_free(BIGNUM *a)
     if (a == NULL)
         return;
     bn_check_top(a);
-    if (!BN_get_flags(a, BN_FLG_STATIC_DATA))
+    if (!BN_get_flags(a, BN_FLG_STATIC_DATA | BN_FLG_ARENA))
         bn_free_d(a);
     if (a->flags & BN_FLG_MALLOCED)
         OPENSSL_free(a);
@@ -330,7 +330,9 @@ BIGNUM *bn_expand2(BIGNUM *b, int words)
             return NULL;
         if (b->d) {
             OPENSSL_cleanse(b->d, b->dmax * sizeof(b->d[0]));
-            bn_free_d(b);
+            if (!BN_get_flags(b, BN_FLG_ARENA))
+                bn_free_d(b);
+            b->flags &= ~BN_FLG_ARENA;
         }
         b->d = a;
         b->dmax = words;
@@ -433,10 +435,10 @@ void BN_swap(BIGNUM *a, BIGNUM *b)
     b->dmax = tmp_dmax;
     b->neg = tmp_neg;
 
-    a->flags =
-        (flags_old_a & BN_FLG_MALLOCED) | (flags_old_b & BN_FLG_STATIC_DATA);
-    b->flags =
-        (flags_old_b & BN_FLG_MALLOCED) | (flags_old_a & BN_FLG_STATIC_DATA);
+    a->flags = (flags_old_a & BN_FLG_MALLOCED)
+        | (flags_old_b & (BN_FLG_STATIC_DATA | BN_FLG_ARENA));
+    b->flags = (flags_old_b & BN_FLG_MALLOCED)
+        | (flags_old_a & (BN_FLG_STATIC_DATA | BN_FLG_ARENA));
     bn_check_top(a);
     bn_check_top(b);
 }
@@ -963,7 +965,7 @@ BN_GENCB *BN_GENCB_new(void)
 {
     BN_GENCB *ret;
 
-    if ((ret = OPENSSL_malloc(sizeof(*ret))) == NULL) {
+    if ((ret = OPENSSL_zalloc(sizeof(*ret))) == NULL) {
         BNerr(BN_F_BN_GENCB_NEW, ERR_R_MALLOC_FAILURE);
         return (NULL);
     }
@@ -996,6 +998,7 @@ void BN_GENCB_set_old(BN_GENCB *gencb, void (*callback) (int, int, void *),
     tmp_gencb->ver = 1;
     tmp_gencb->arg = cb_arg;
     tmp_gencb->cb.cb_1 = callback;
+    tmp_gencb->run_tasks = NULL;
 }
 
 /* Populate a BN_GENCB structure with a "new"-style callback */
@@ -1006,6 +1009,7 @@ void BN_GENCB_set(BN_GENCB *gencb, int (*callback) (int, int, BN_GENCB *),
     tmp_gencb->ver = 2;
     tmp_gencb->arg = cb_arg;
     tmp_gencb->cb.cb_2 = callback;
+    tmp_gencb->run_tasks = NULL;
 }
 
 void *BN_GENCB_get_arg(BN_GENCB *cb)
@@ -1013,6 +1017,16 @@ void *BN_GENCB_get_arg(BN_GENCB *cb)
     return cb->arg;
 }
 
+/* Must be called after BN_GENCB_set() or BN_GENCB_set_old() */
+int BN_GENCB_set_thread_pool(BN_GENCB *gencb, CRYPTO_RUN_TASKS *run,
+                             void *pool, int tasks)
+{
+    gencb->run_tasks = run;
+    gencb->pool = pool;
+    gencb->tasks = tasks;
+    return 1;
+}
+
 BIGNUM *bn_wexpand(BIGNUM *a, int words)
 {
     return (words <= a->dmax) ? a : bn_expand2(a, words);
@@ -12,6 +12,7 @@
 #include <stdio.h>
 #include <time.h>
 #include "internal/cryptlib.h"
+#include "internal/cryptlib_int.h"
 #include "bn_lcl.h"
 
 /*
@@ -24,6 +25,8 @@
 static int witness(BIGNUM *w, const BIGNUM *a, const BIGNUM *a1,
                    const BIGNUM *a1_odd, int k, BN_CTX *ctx,
                    BN_MONT_CTX *mont);
+static int witness_squares(BIGNUM *w, const BIGNUM *a, const BIGNUM *a1,
+                           int k, BN_CTX *ctx);
 static int probable_prime(BIGNUM *rnd, int bits, prime_t *mods);
 static int probable_prime_dh_safe(BIGNUM *rnd, int bits,
                                   const BIGNUM *add, const BIGNUM *rem,
@@ -76,6 +79,9 @@ static const int prime_multiplier_bits = 11; /* 2^|prime_multiplier_bits| <=
                                               * |prime_multiplier| */
 static const int first_prime_index = 5;
 
+/* Number of candidates struck out at a time by the sieve */
+static const int sieve_size = 4096;
+
 int BN_GENCB_call(BN_GENCB *cb, int a, int b)
 {
     /* No callback means continue */
@@ -98,8 +104,10 @@ int BN_GENCB_call(BN_GENCB *cb, int a, int b)
     return 0;
 }
 
-int BN_generate_prime_ex(BIGNUM *ret, int bits, int safe,
-                         const BIGNUM *add, const BIGNUM *rem, BN_GENCB *cb)
+/* Search for primes of up to BN_BITS2 bits */
+static int bn_generate_prime_small(BIGNUM *ret, int bits, int safe,
+                                   const BIGNUM *add, const BIGNUM *rem,
+                                   BN_GENCB *cb)
 {
     BIGNUM *t;
     int found = 0;
@@ -108,16 +116,6 @@ int BN_generate_prime_ex(BIGNUM *ret, int bits, int safe,
     prime_t *mods = NULL;
     int checks = BN_prime_checks_for_size(bits);
 
-    if (bits < 2) {
-        /* There are no prime numbers this small. */
-        BNerr(BN_F_BN_GENERATE_PRIME_EX, BN_R_BITS_TOO_SMALL);
-        return 0;
-    } else if (bits == 2 && safe) {
-        /* The smallest safe prime (7) is three bits. */
-        BNerr(BN_F_BN_GENERATE_PRIME_EX, BN_R_BITS_TOO_SMALL);
-        return 0;
-    }
-
     mods = OPENSSL_zalloc(sizeof(*mods) * NUMPRIMES);
     if (mods == NULL)
         goto err;
@@ -191,6 +189,523 @@ int BN_generate_prime_ex(BIGNUM *ret, int bits, int safe,
     return found;
 }
 
+/*
+ * Incremental sieve over the candidates base + i*step, i < sieve_size.
+ * Candidates that are 0 or 1 modulo any of the small primes are struck
+ * out: the former are composite, and the latter would give p-1 (or, for
+ * safe primes, (p-1)/2) a small factor. Moving on to the next window only
+ * updates the residues.
+ */
+typedef struct {
+    BIGNUM *base;
+    BIGNUM *step;
+    prime_t *mods;              /* base mod primes[j] */
+    prime_t *steps;             /* step mod primes[j] */
+    prime_t *invs;              /* step^-1 mod primes[j], 0 if none */
+    unsigned char *composite;
+    int next;
+} BN_SIEVE;
+
+static void bn_sieve_free(BN_SIEVE *s)
+{
+    if (s == NULL)
+        return;
+    BN_clear_free(s->base);
+    BN_free(s->step);
+    OPENSSL_clear_free(s->mods, sizeof(*s->mods) * NUMPRIMES_SIEVE);
+    OPENSSL_free(s->steps);
+    OPENSSL_free(s->invs);
+    OPENSSL_clear_free(s->composite, sieve_size);
+    OPENSSL_free(s);
+}
+
+static BN_SIEVE *bn_sieve_new(void)
+{
+    BN_SIEVE *s = OPENSSL_zalloc(sizeof(*s));
+
+    if (s == NULL
+        || (s->base = BN_new()) == NULL
+        || (s->step = BN_new()) == NULL
+        || (s->mods = OPENSSL_malloc(sizeof(*s->mods)
+                                     * NUMPRIMES_SIEVE)) == NULL
+        || (s->steps = OPENSSL_malloc(sizeof(*s->steps)
+                                      * NUMPRIMES_SIEVE)) == NULL
+        || (s->invs = OPENSSL_malloc(sizeof(*s->invs)
+                                     * NUMPRIMES_SIEVE)) == NULL
+        || (s->composite = OPENSSL_malloc(sieve_size)) == NULL) {
+        bn_sieve_free(s);
+        return NULL;
+    }
+    return s;
+}
+
+/* a^-1 mod p, or 0 if a is a multiple of p */
+static prime_t inverse_mod_prime(BN_ULONG a, prime_t p)
+{
+    long r0 = p, r1 = (long)(a % p), t0 = 0, t1 = 1, q, t;
+
+    if (r1 == 0)
+        return 0;
+    while (r1 != 0) {
+        q = r0 / r1;
+        t = r0 - q * r1;
+        r0 = r1;
+        r1 = t;
+        t = t0 - q * t1;
+        t0 = t1;
+        t1 = t;
+    }
+    return (prime_t)(t0 < 0 ? t0 + p : t0);
+}
+
+static void bn_sieve_fill(BN_SIEVE *s)
+{
+    unsigned int p, m, inv, r, i;
+    int j;
+
+    memset(s->composite, 0, sieve_size);
+    for (j = 1; j < NUMPRIMES_SIEVE; j++) {
+        p = primes[j];
+        m = s->mods[j];
+        inv = s->invs[j];
+        if (inv == 0) {
+            /* all candidates are the same modulo p */
+            if (m == 0)
+                memset(s->composite, 1, sieve_size);
+            continue;
+        }
+        for (r = 0; r < 2; r++) {
+            /* base + i*step == r (mod p) */
+            for (i = (p + r - m) % p * inv % p; i < (unsigned int)sieve_size;
+                 i += p)
+                s->composite[i] = 1;
+        }
+    }
+    s->next = 0;
+}
+
+static int bn_sieve_set_step(BN_SIEVE *s, const BIGNUM *step)
+{
+    int j;
+
+    if (BN_copy(s->step, step) == NULL)
+        return 0;
+    for (j = 1; j < NUMPRIMES_SIEVE; j++) {
+        BN_ULONG mod = BN_mod_word(step, (BN_ULONG)primes[j]);
+
+        if (mod == (BN_ULONG)-1)
+            return 0;
+        s->steps[j] = (prime_t)mod;
+        s->invs[j] = inverse_mod_prime(mod, primes[j]);
+    }
+    return 1;
+}
+
+static int bn_sieve_set_base(BN_SIEVE *s, const BIGNUM *base)
+{
+    int j;
+
+    if (BN_copy(s->base, base) == NULL)
+        return 0;
+    for (j = 1; j < NUMPRIMES_SIEVE; j++) {
+        BN_ULONG mod = BN_mod_word(base, (BN_ULONG)primes[j]);
+
+        if (mod == (BN_ULONG)-1)
+            return 0;
+        s->mods[j] = (prime_t)mod;
+    }
+    bn_sieve_fill(s);
+    return 1;
+}
+
+/* Set |cand| to the next candidate that has not been struck out */
+static int bn_sieve_next(BN_SIEVE *s, BIGNUM *cand)
+{
+    int j;
+
+    while (s->next < sieve_size && s->composite[s->next])
+        s->next++;
+    while (s->next == sieve_size) {
+        /* move on to the next window */
+        if (BN_copy(cand, s->step) == NULL
+            || !BN_mul_word(cand, sieve_size)
+            || !BN_add(s->base, s->base, cand))
+            return 0;
+        for (j = 1; j < NUMPRIMES_SIEVE; j++)
+            s->mods[j] = (prime_t)((s->mods[j]
+                                    + (sieve_size % primes[j]) * s->steps[j])
+                                   % primes[j]);
+        bn_sieve_fill(s);
+        while (s->next < sieve_size && s->composite[s->next])
+            s->next++;
+    }
+    if (BN_copy(cand, s->step) == NULL
+        || !BN_mul_word(cand, s->next)
+        || !BN_add(cand, cand, s->base))
+        return 0;
+    s->next++;
+    return 1;
+}
+
+/*
+ * A random starting point for the search and the distance between
+ * candidates, following the same rules as probable_prime(),
+ * bn_probable_prime_dh() and probable_prime_dh_safe().
+ */
+static int bn_prime_start(BIGNUM *start, BIGNUM *step, int bits, int safe,
+                          const BIGNUM *add, const BIGNUM *rem, BN_CTX *ctx)
+{
+    BIGNUM *t1, *qadd;
+    int ret = 0;
+
+    if (add == NULL) {
+        if (!BN_rand(start, bits, 1, 1))
+            return 0;
+        if (!safe)
+            return BN_set_word(step, 2);
+        /* (p-1)/2 has to be odd too */
+        return BN_set_bit(start, 1) && BN_set_word(step, 4);
+    }
+
+    BN_CTX_start(ctx);
+    t1 = BN_CTX_get(ctx);
+    qadd = BN_CTX_get(ctx);
+    if (qadd == NULL || BN_copy(step, add) == NULL)
+        goto err;
+
+    if (!safe) {
+        /* we need ((rnd-rem) % add) == 0 */
+        if (!BN_rand(start, bits, 0, 1)
+            || !BN_mod(t1, start, add, ctx)
+            || !BN_sub(start, start, t1))
+            goto err;
+        if (rem == NULL) {
+            if (!BN_add_word(start, 1))
+                goto err;
+        } else {
+            if (!BN_add(start, start, rem))
+                goto err;
+        }
+        /* with an odd |add| every other candidate is even, skip those */
+        if (BN_is_odd(add)) {
+            if (!BN_is_odd(start) && !BN_add(start, start, add))
+                goto err;
+            if (!BN_lshift1(step, add))
+                goto err;
+        }
+    } else {
+        /* q = (p-1)/2 with ((q-rem/2) % (add/2)) == 0 */
+        if (!BN_rshift1(qadd, add)
+            || !BN_rand(start, bits - 1, 0, 1)
+            || !BN_mod(t1, start, qadd, ctx)
+            || !BN_sub(start, start, t1))
+            goto err;
+        if (rem == NULL) {
+            if (!BN_add_word(start, 1))
+                goto err;
+        } else {
+            if (!BN_rshift1(t1, rem) || !BN_add(start, start, t1))
+                goto err;
+        }
+        /* likewise for q when add/2 is odd, e.g. for DH generators 2 and 5 */
+        if (BN_is_odd(qadd)) {
+            if (!BN_is_odd(start) && !BN_add(start, start, qadd))
+                goto err;
+            if (!BN_lshift1(step, add))
+                goto err;
+        }
+        if (!BN_lshift1(start, start) || !BN_add_word(start, 1))
+            goto err;
+    }
+    ret = 1;
+ err:
+    BN_CTX_end(ctx);
+    return ret;
+}
+
+/*
+ * One Miller-Rabin round with a random base on each of a[0] and a[1],
+ * which are odd and greater than 3. The two modular exponentiations are
+ * done together by BN_mod_exp_mont_consttime_x2(). Sets composite[i] for
+ * a[i] found to be composite, returns 0 on error.
+ */
+static int bn_miller_rabin_x2(BIGNUM *const a[2], int composite[2],
+                              BN_CTX *ctx)
+{
+    BIGNUM *a1[2], *a1_odd[2], *w[2];
+    int i, k[2], ret = 0;
+
+    BN_CTX_start(ctx);
+    for (i = 0; i < 2; i++) {
+        a1[i] = BN_CTX_get(ctx);
+        a1_odd[i] = BN_CTX_get(ctx);
+        w[i] = BN_CTX_get(ctx);
+        if (w[i] == NULL)
+            goto err;
+
+        /* write a-1 as a1_odd * 2^k */
+        if (BN_copy(a1[i], a[i]) == NULL || !BN_sub_word(a1[i], 1))
+            goto err;
+        k[i] = 1;
+        while (!BN_is_bit_set(a1[i], k[i]))
+            k[i]++;
+        if (!BN_rshift(a1_odd[i], a1[i], k[i]))
+            goto err;
+
+        /* 1 <= w < a */
+        if (!BN_pseudo_rand_range(w[i], a1[i]) || !BN_add_word(w[i], 1))
+            goto err;
+    }
+
+    if (!BN_mod_exp_mont_consttime_x2(w[0], w[0], a1_odd[0], a[0], NULL,
+                                      w[1], w[1], a1_odd[1], a[1], NULL,
+                                      ctx))
+        goto err;
+
+    for (i = 0; i < 2; i++) {
+        composite[i] = witness_squares(w[i], a[i], a1[i], k[i], ctx);
+        if (composite[i] == -1)
+            goto err;
+    }
+    ret = 1;
+ err:
+    BN_CTX_end(ctx);
+    return ret;
+}
+
+/*
+ * Search for primes of more than BN_BITS2 bits. Candidates come from the
+ * sieve and go through a first round of Miller-Rabin in pairs: two
+ * candidates at a time, or p and (p-1)/2 for safe primes.
+ */
+static int bn_generate_prime_sieve(BIGNUM *ret, int bits, int safe,
+                                   const BIGNUM *add, const BIGNUM *rem,
+                                   BN_GENCB *cb)
+{
+    BIGNUM *start, *step, *c[2];
+    BN_SIEVE *sieve = NULL;
+    BN_CTX *ctx = NULL;
+    int found = 0, i, j, c1 = 0, composite[2];
+    int checks = BN_prime_checks_for_size(bits);
+
+    if ((sieve = bn_sieve_new()) == NULL || (ctx = BN_CTX_new()) == NULL)
+        goto err;
+    BN_CTX_start(ctx);
+    start = BN_CTX_get(ctx);
+    step = BN_CTX_get(ctx);
+    c[0] = BN_CTX_get(ctx);
+    c[1] = BN_CTX_get(ctx);
+    if (c[1] == NULL)
+        goto err;
+
+ again:
+    if (!bn_prime_start(start, step, bits, safe, add, rem, ctx)
+        || !bn_sieve_set_step(sieve, step)
+        || !bn_sieve_set_base(sieve, start))
+        goto err;
+
+    for (;;) {
+        for (i = 0; i < (safe ? 1 : 2); i++) {
+            if (!bn_sieve_next(sieve, c[i]))
+                goto err;
+            if (BN_num_bits(c[i]) > bits)
+                goto again;
+            if (!BN_GENCB_call(cb, 0, c1++))
+                /* aborted */
+                goto err;
+        }
+        if (safe && !BN_rshift1(c[1], c[0]))
+            goto err;
+
+        if (BN_is_odd(c[0]) && BN_is_odd(c[1])) {
+            if (!bn_miller_rabin_x2(c, composite, ctx))
+                goto err;
+        } else {
+            /*
+             * Only when |add| and |rem| rule out odd candidates (or odd q).
+             * An even one is composite, an odd one is left to the full test.
+             */
+            for (i = 0; i < 2; i++)
+                composite[i] = !BN_is_odd(c[i]);
+        }
+
+        if (!safe) {
+            for (i = 0; i < 2; i++) {
+                if (composite[i])
+                    continue;
+                j = BN_is_prime_fasttest_ex(c[i], checks, ctx, 0, cb);
+                if (j == -1)
+                    goto err;
+                if (j == 1) {
+                    /* we have a prime :-) */
+                    found = BN_copy(ret, c[i]) != NULL;
+                    goto err;
+                }
+            }
+            continue;
+        }
+
+        if (composite[0] || composite[1])
+            continue;
+        for (i = 0; i < checks; i++) {
+            j = BN_is_prime_fasttest_ex(c[0], 1, ctx, 0, cb);
+            if (j == -1)
+                goto err;
+            if (j == 0)
+                break;
+
+            j = BN_is_prime_fasttest_ex(c[1], 1, ctx, 0, cb);
+            if (j == -1)
+                goto err;
+            if (j == 0)
+                break;
+
+            if (!BN_GENCB_call(cb, 2, c1 - 1))
+                goto err;
+            /* We have a safe prime test pass */
+        }
+        if (i == checks) {
+            /* we have a safe prime :-) */
+            found = BN_copy(ret, c[0]) != NULL;
+            goto err;
+        }
+    }
+
+ err:
+    bn_sieve_free(sieve);
+    if (ctx != NULL)
+        BN_CTX_end(ctx);
+    BN_CTX_free(ctx);
+    bn_check_top(ret);
+    return found;
+}
+
+static int bn_generate_prime(BIGNUM *ret, int bits, int safe,
+                             const BIGNUM *add, const BIGNUM *rem,
+                             BN_GENCB *cb)
+{
+    if (bits > BN_BITS2)
+        return bn_generate_prime_sieve(ret, bits, safe, add, rem, cb);
+    return bn_generate_prime_small(ret, bits, safe, add, rem, cb);
+}
+
+/*
+ * Search for a prime with independent searches on a caller-supplied
+ * thread pool, set with BN_GENCB_set_thread_pool(). Each search gets a
+ * callback of its own that stops it once another search has found a
+ * prime, and forwards to the caller's callback one call at a time.
+ */
+typedef struct {
+    CRYPTO_RWLOCK *lock;
+    BN_GENCB *cb;
+    int done;
+} BN_PRIME_SEARCH;
+
+typedef struct {
+    BN_PRIME_SEARCH *search;
+    BN_GENCB cb;
+    BIGNUM *ret;
+    int bits, safe;
+    const BIGNUM *add, *rem;
+    int found;
+} BN_PRIME_TASK;
+
+static int bn_prime_task_cb(int a, int b, BN_GENCB *cb)
+{
+    BN_PRIME_SEARCH *search = BN_GENCB_get_arg(cb);
+    int ret;
+
+    CRYPTO_THREAD_write_lock(search->lock);
+    ret = !search->done && BN_GENCB_call(search->cb, a, b);
+    if (!ret)
+        search->done = 1;
+    CRYPTO_THREAD_unlock(search->lock);
+    return ret;
+}
+
+static void bn_prime_task(void *arg)
+{
+    BN_PRIME_TASK *t = arg;
+
+    t->found = bn_generate_prime(t->ret, t->bits, t->safe, t->add, t->rem,
+                                 &t->cb);
+    if (t->found) {
+        CRYPTO_THREAD_write_lock(t->search->lock);
+        /* the first one to get here wins */
+        if (t->search->done)
+            t->found = 0;
+        t->search->done = 1;
+        CRYPTO_THREAD_unlock(t->search->lock);
+    }
+}
+
+static int bn_generate_prime_mt(BIGNUM *ret, int bits, int safe,
+                                const BIGNUM *add, const BIGNUM *rem,
+                                BN_GENCB *cb)
+{
+    BN_PRIME_SEARCH search;
+    BN_PRIME_TASK *t = NULL;
+    void **args = NULL;
+    int i, n = cb->tasks, found = 0;
+
+    search.cb = cb;
+    search.done = 0;
+    if ((search.lock = CRYPTO_THREAD_lock_new()) == NULL
+        || (t = OPENSSL_zalloc(sizeof(*t) * n)) == NULL
+        || (args = OPENSSL_malloc(sizeof(*args) * n)) == NULL) {
+        BNerr(BN_F_BN_GENERATE_PRIME_MT, ERR_R_MALLOC_FAILURE);
+        goto err;
+    }
+    for (i = 0; i < n; i++) {
+        t[i].search = &search;
+        BN_GENCB_set(&t[i].cb, bn_prime_task_cb, &search);
+        t[i].bits = bits;
+        t[i].safe = safe;
+        t[i].add = add;
+        t[i].rem = rem;
+        if ((t[i].ret = BN_new()) == NULL) {
+            BNerr(BN_F_BN_GENERATE_PRIME_MT, ERR_R_MALLOC_FAILURE);
+            goto err;
+        }
+        args[i] = &t[i];
+    }
+
+    if (!crypto_run_tasks(cb->run_tasks, cb->pool, bn_prime_task, args, n)) {
+        BNerr(BN_F_BN_GENERATE_PRIME_MT, BN_R_TASKS_FAILED);
+        goto err;
+    }
+    for (i = 0; i < n && !found; i++)
+        if (t[i].found)
+            found = BN_copy(ret, t[i].ret) != NULL;
+
+ err:
+    if (t != NULL)
+        for (i = 0; i < n; i++)
+            BN_clear_free(t[i].ret);
+    OPENSSL_free(t);
+    OPENSSL_free(args);
+    CRYPTO_THREAD_lock_free(search.lock);
+    return found;
+}
+
+int BN_generate_prime_ex(BIGNUM *ret, int bits, int safe,
+                         const BIGNUM *add, const BIGNUM *rem, BN_GENCB *cb)
+{
+    if (bits < 2) {
+        /* There are no prime numbers this small. */
+        BNerr(BN_F_BN_GENERATE_PRIME_EX, BN_R_BITS_TOO_SMALL);
+        return 0;
+    } else if (bits == 2 && safe) {
+        /* The smallest safe prime (7) is three bits. */
+        BNerr(BN_F_BN_GENERATE_PRIME_EX, BN_R_BITS_TOO_SMALL);
+        return 0;
+    }
+
+    if (cb != NULL && cb->run_tasks != NULL && cb->tasks > 1)
+        return bn_generate_prime_mt(ret, bits, safe, add, rem, cb);
+    return bn_generate_prime(ret, bits, safe, add, rem, cb);
+}
+
 int BN_is_prime_ex(const BIGNUM *a, int checks, BN_CTX *ctx_passed,
                    BN_GENCB *cb)
 {
@@ -386,6 +901,13 @@ static int witness(BIGNUM *w, const BIGNUM *a, const BIGNUM *a1,
 {
     if (!BN_mod_exp_mont(w, w, a1_odd, a, ctx, mont)) /* w := w^a1_odd mod a */
         return -1;
+    return witness_squares(w, a, a1, k, ctx);
+}
+
+/* The rest of witness(), once w has been raised to the power a1_odd */
+static int witness_squares(BIGNUM *w, const BIGNUM *a, const BIGNUM *a1,
+                           int k, BN_CTX *ctx)
+{
     if (BN_is_one(w))
         return 0;               /* probably prime */
     if (BN_cmp(w, a1) == 0)
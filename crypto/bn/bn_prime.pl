@@ -22,7 +22,10 @@ print <<"EOF";
 EOF
 
 
-my $num = shift || 2048;
+# All primes below 2^16, the most that fit in prime_t, for the sieve in
+# BN_generate_prime_ex(). Trial division only uses the first 2048.
+my $num = shift || 6542;
+my $trial = $num < 2048 ? $num : 2048;
 my @primes = ( 2 );
 my $p = 1;
 loop: while ($#primes < $num-1) {
@@ -36,7 +39,8 @@ loop: while ($#primes < $num-1) {
 }
 
 print "typedef unsigned short prime_t;\n";
-printf "# define NUMPRIMES %d\n\n", $num;
+printf "# define NUMPRIMES %d\n", $trial;
+printf "# define NUMPRIMES_SIEVE %d\n\n", $num;
 
 printf "static const prime_t primes[%d] = {\n", $num;
 for (my $i = 0; $i <= $#primes; $i++) {
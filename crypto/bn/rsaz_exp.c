@@ -49,8 +49,10 @@
 * (2) University of Haifa, Israel                                            *
 *****************************************************************************/
 
+#include <string.h>
 #include <openssl/opensslconf.h>
 #include "rsaz_exp.h"
+#include "bn_lcl.h"
 
 #ifndef RSAZ_ENABLED
 NON_EMPTY_TRANSLATION_UNIT
@@ -349,4 +351,278 @@ void RSAZ_512_mod_exp(BN_ULONG result[8],
     OPENSSL_cleanse(storage, sizeof(storage));
 }
 
+/*
+ * See crypto/bn/asm/rsaz-avx512.pl for further details.
+ */
+void rsaz_amm52x20_x1_avx512ifma(BN_ULONG *res, const BN_ULONG *a,
+                                 const BN_ULONG *b, const BN_ULONG *m,
+                                 BN_ULONG k0);
+void rsaz_amm52x30_x1_avx512ifma(BN_ULONG *res, const BN_ULONG *a,
+                                 const BN_ULONG *b, const BN_ULONG *m,
+                                 BN_ULONG k0);
+void rsaz_amm52x40_x1_avx512ifma(BN_ULONG *res, const BN_ULONG *a,
+                                 const BN_ULONG *b, const BN_ULONG *m,
+                                 BN_ULONG k0);
+void rsaz_amm52x20_x2_avx512ifma(BN_ULONG *res, const BN_ULONG *a,
+                                 const BN_ULONG *b, const BN_ULONG *m,
+                                 const BN_ULONG k0[2]);
+
+#define AMM52_MASK      (((BN_ULONG)1 << 52) - 1)
+
+typedef void (*AMM52_FUNC) (BN_ULONG *res, const BN_ULONG *a,
+                            const BN_ULONG *b, const BN_ULONG *m,
+                            BN_ULONG k0);
+typedef void (*AMM52_X2_FUNC) (BN_ULONG *res, const BN_ULONG *a,
+                               const BN_ULONG *b, const BN_ULONG *m,
+                               const BN_ULONG k0[2]);
+
+/*
+ * One or two independent exponentiations, every operand holding |lanes|
+ * vectors of |size| limbs back to back. Lanes are multiplied in one go
+ * if there is an interleaved kernel for the size, and one by one if not.
+ */
+typedef struct {
+    AMM52_FUNC x1;
+    AMM52_X2_FUNC x2;
+    const BN_ULONG *m;
+    BN_ULONG k0[2];
+    int size, lanes;
+} RSAZ_AMM52;
+
+static void rsaz_amm52(const RSAZ_AMM52 *amm, BN_ULONG *res,
+                       const BN_ULONG *a, const BN_ULONG *b)
+{
+    int l;
+
+    if (amm->lanes == 2 && amm->x2 != NULL) {
+        amm->x2(res, a, b, amm->m, amm->k0);
+        return;
+    }
+    for (l = 0; l < amm->lanes; l++)
+        amm->x1(res + l * amm->size, a + l * amm->size, b + l * amm->size,
+                amm->m + l * amm->size, amm->k0[l]);
+}
+
+/* Convert |words| 64-bit words at |in| to |n| 52-bit limbs, |size| total */
+static void rsaz_norm2red52(BN_ULONG *out, int n, int size,
+                            const BN_ULONG *in, int words)
+{
+    int i, w, s;
+
+    for (i = 0; i < size; i++) {
+        BN_ULONG v = 0;
+
+        w = (52 * i) / 64;
+        s = (52 * i) % 64;
+        if (i < n && w < words) {
+            v = in[w] >> s;
+            if (s > 12 && w + 1 < words)
+                v |= in[w + 1] << (64 - s);
+        }
+        out[i] = v & AMM52_MASK;
+    }
+}
+
+/* Convert |n| 52-bit limbs at |in| to |words| 64-bit words */
+static void rsaz_red52_2norm(BN_ULONG *out, int words, const BN_ULONG *in,
+                             int n)
+{
+    int i, w, s;
+
+    for (i = 0; i < words; i++)
+        out[i] = 0;
+    for (i = 0; i < n; i++) {
+        w = (52 * i) / 64;
+        s = (52 * i) % 64;
+        if (w < words)
+            out[w] |= in[i] << s;
+        if (s > 12 && w + 1 < words)
+            out[w + 1] |= in[i] >> (64 - s);
+    }
+}
+
+/*
+ * Constant-time out = table[idx], for 32 entries of |n| limbs each,
+ * |stride| limbs apart
+ */
+static void rsaz_amm52_gather(BN_ULONG *out, const BN_ULONG *table,
+                              int stride, int n, unsigned int idx)
+{
+    int i, j;
+
+    for (j = 0; j < n; j++)
+        out[j] = 0;
+    for (i = 0; i < 32; i++, table += stride) {
+        BN_ULONG mask = 0 - (BN_ULONG)((((unsigned int)i ^ idx) - 1) >> 31);
+
+        for (j = 0; j < n; j++)
+            out[j] |= table[j] & mask;
+    }
+}
+
+/* |len| bits of |exp| starting at bit |bit| */
+static unsigned int rsaz_exp_window(const BN_ULONG *exp, int words, int bit,
+                                    int len)
+{
+    int w = bit / BN_BITS2, s = bit % BN_BITS2;
+    BN_ULONG v = exp[w] >> s;
+
+    if (s + len > BN_BITS2 && w + 1 < words)
+        v |= exp[w + 1] << (BN_BITS2 - s);
+    return (unsigned int)v & ((1U << len) - 1);
+}
+
+/*
+ * result[l] = base_norm[l]^exponent[l] mod m_norm[l] for l < |lanes|, all
+ * of |factor_size| bits, i.e. 1024, 1536 or 2048. All arrays are
+ * |factor_size|/64 words long, base < m and RR is 2^(2*factor_size) mod m.
+ * Fixed 5-bit windows over the low |exp_bits| bits of the exponents, so
+ * that short exponents, e.g. DH private keys, cost what they should.
+ */
+static int rsaz_mod_exp_avx512(BN_ULONG *const result[],
+                               const BN_ULONG *const base_norm[],
+                               const BN_ULONG *const exponent[],
+                               const BN_ULONG *const m_norm[],
+                               const BN_ULONG *const RR[],
+                               const BN_ULONG k0[], int factor_size,
+                               int exp_bits, int lanes)
+{
+    unsigned char *storage;
+    BN_ULONG *table, *base, *m, *rr, *res, *tmp, *one;
+    RSAZ_AMM52 amm;
+    int words = factor_size / BN_BITS2, n, stride, i, l, bit;
+    size_t len;
+
+    /* AMM wants 4*m < 2^(52*n) */
+    memset(&amm, 0, sizeof(amm));
+    switch (factor_size) {
+    case 1024:
+        amm.x1 = rsaz_amm52x20_x1_avx512ifma;
+        amm.x2 = rsaz_amm52x20_x2_avx512ifma;
+        n = 20;
+        break;
+    case 1536:
+        amm.x1 = rsaz_amm52x30_x1_avx512ifma;
+        n = 30;
+        break;
+    case 2048:
+        amm.x1 = rsaz_amm52x40_x1_avx512ifma;
+        n = 40;
+        break;
+    default:
+        return 0;
+    }
+    if (exp_bits <= 0 || exp_bits > factor_size)
+        exp_bits = factor_size;
+    amm.size = (n + 3) & ~3;
+    amm.lanes = lanes;
+    stride = lanes * amm.size;
+
+    /* 32 powers plus base, m, R^2, the result, a temporary and one */
+    len = (32 + 6) * stride * sizeof(BN_ULONG) + 64;
+    if ((storage = OPENSSL_malloc(len)) == NULL)
+        return 0;
+    table = (BN_ULONG *)(storage + (64 - ((size_t)storage % 64)));
+    base = table + 32 * stride;
+    m = base + stride;
+    rr = m + stride;
+    res = rr + stride;
+    tmp = res + stride;
+    one = tmp + stride;
+    amm.m = m;
+
+    /*
+     * RR is 2^(2*factor_size) mod m, convert it to R^2 mod m for
+     * R = 2^(52*n) by multiplying it by itself and then by 2^(4*d), d
+     * being 52*n - factor_size.
+     */
+    memset(one, 0, stride * sizeof(BN_ULONG));
+    for (l = 0; l < lanes; l++) {
+        amm.k0[l] = k0[l] & AMM52_MASK;
+        rsaz_norm2red52(m + l * amm.size, n, amm.size, m_norm[l], words);
+        rsaz_norm2red52(base + l * amm.size, n, amm.size, base_norm[l],
+                        words);
+        rsaz_norm2red52(tmp + l * amm.size, n, amm.size, RR[l], words);
+        one[l * amm.size] = 1;
+    }
+    rsaz_amm52(&amm, rr, tmp, tmp);
+    memset(tmp, 0, stride * sizeof(BN_ULONG));
+    bit = 4 * (52 * n - factor_size);
+    for (l = 0; l < lanes; l++)
+        tmp[l * amm.size + bit / 52] = (BN_ULONG)1 << (bit % 52);
+    rsaz_amm52(&amm, rr, rr, tmp);
+
+    /* table[0] = R mod m, table[1] = base*R mod m, ... */
+    rsaz_amm52(&amm, table, rr, one);
+    rsaz_amm52(&amm, table + stride, base, rr);
+    for (i = 2; i < 32; i++)
+        rsaz_amm52(&amm, table + i * stride, table + (i - 1) * stride,
+                   table + stride);
+
+    /* load first window */
+    bit = exp_bits - (exp_bits % 5 ? exp_bits % 5 : 5);
+    for (l = 0; l < lanes; l++)
+        rsaz_amm52_gather(res + l * amm.size, table + l * amm.size, stride,
+                          amm.size, rsaz_exp_window(exponent[l], words, bit,
+                                                    exp_bits - bit));
+
+    while (bit > 0) {
+        bit -= 5;
+        for (i = 0; i < 5; i++)
+            rsaz_amm52(&amm, res, res, res);
+        for (l = 0; l < lanes; l++)
+            rsaz_amm52_gather(tmp + l * amm.size, table + l * amm.size,
+                              stride, amm.size,
+                              rsaz_exp_window(exponent[l], words, bit, 5));
+        rsaz_amm52(&amm, res, res, tmp);
+    }
+
+    /* from Montgomery, the result is at most m */
+    rsaz_amm52(&amm, res, res, one);
+    for (l = 0; l < lanes; l++) {
+        BN_ULONG mask;
+
+        rsaz_red52_2norm(result[l], words, res + l * amm.size, n);
+        mask = 0 - bn_sub_words(tmp, result[l], m_norm[l], words);
+        for (i = 0; i < words; i++)
+            result[l][i] = (result[l][i] & mask) | (tmp[i] & ~mask);
+    }
+
+    OPENSSL_clear_free(storage, len);
+    return 1;
+}
+
+int RSAZ_mod_exp_avx512(BN_ULONG *result, const BN_ULONG *base_norm,
+                        const BN_ULONG *exponent, const BN_ULONG *m_norm,
+                        const BN_ULONG *RR, BN_ULONG k0, int factor_size,
+                        int exp_bits)
+{
+    return rsaz_mod_exp_avx512(&result, &base_norm, &exponent, &m_norm, &RR,
+                               &k0, factor_size, exp_bits, 1);
+}
+
+/*
+ * Two independent exponentiations with moduli of the same size, e.g. the
+ * CRT halves of an RSA private key operation, interleaved so that one
+ * fills the execution units while the other waits on its dependencies.
+ */
+int RSAZ_mod_exp_avx512_x2(BN_ULONG *res1, const BN_ULONG *base1,
+                           const BN_ULONG *exp1, const BN_ULONG *m1,
+                           const BN_ULONG *RR1, BN_ULONG k0_1,
+                           BN_ULONG *res2, const BN_ULONG *base2,
+                           const BN_ULONG *exp2, const BN_ULONG *m2,
+                           const BN_ULONG *RR2, BN_ULONG k0_2,
+                           int factor_size)
+{
+    BN_ULONG *const result[2] = { res1, res2 };
+    const BN_ULONG *const base[2] = { base1, base2 };
+    const BN_ULONG *const exponent[2] = { exp1, exp2 };
+    const BN_ULONG *const m[2] = { m1, m2 };
+    const BN_ULONG *const RR[2] = { RR1, RR2 };
+    const BN_ULONG k0[2] = { k0_1, k0_2 };
+
+    return rsaz_mod_exp_avx512(result, base, exponent, m, RR, k0,
+                               factor_size, factor_size, 2);
+}
+
 #endif
@@ -72,6 +72,20 @@ void RSAZ_512_mod_exp(BN_ULONG result[8],
                       const BN_ULONG m_norm[8], BN_ULONG k0,
                       const BN_ULONG RR[8]);
 
+int rsaz_avx512ifma_eligible(void);
+
+int RSAZ_mod_exp_avx512(BN_ULONG *result, const BN_ULONG *base_norm,
+                        const BN_ULONG *exponent, const BN_ULONG *m_norm,
+                        const BN_ULONG *RR, BN_ULONG k0, int factor_size,
+                        int exp_bits);
+int RSAZ_mod_exp_avx512_x2(BN_ULONG *res1, const BN_ULONG *base1,
+                           const BN_ULONG *exp1, const BN_ULONG *m1,
+                           const BN_ULONG *RR1, BN_ULONG k0_1,
+                           BN_ULONG *res2, const BN_ULONG *base2,
+                           const BN_ULONG *exp2, const BN_ULONG *m2,
+                           const BN_ULONG *RR2, BN_ULONG k0_2,
+                           int factor_size);
+
 # endif
 
 #endif
@@ -43,6 +43,17 @@
 #	limitations, SSE2 can do better, but gain is considered too
 #	low to justify the [maintenance] effort;
 # (iv)	Bulldozer actually executes 4xXOP code path that delivers 2.20;
+#
+# November 2016
+#
+# Add 16xAVX512F code path, which keeps whole state in registers and
+# is taken for inputs longer than 512 bytes. On Skylake-X class
+# processors it's ~2x faster than 8xAVX2 on large buffers.
+#
+# Add ChaCha20_Poly1305_seal and ChaCha20_Poly1305_open, which encrypt
+# or decrypt and hash the ciphertext with Poly1305 in a single pass.
+# 8xAVX2 rounds are interleaved with base 2^64 Poly1305 hashing 512
+# bytes of ciphertext on otherwise idle integer units.
 
 $flavour = shift;
 $output  = shift;
@@ -57,12 +68,12 @@ die "can't locate x86_64-xlate.pl";
 
 if (`$ENV{CC} -Wa,-v -c -o /dev/null -x assembler /dev/null 2>&1`
 		=~ /GNU assembler version ([2-9]\.[0-9]+)/) {
-	$avx = ($1>=2.19) + ($1>=2.22);
+	$avx = ($1>=2.19) + ($1>=2.22) + ($1>=2.25);
 }
 
 if (!$avx && $win64 && ($flavour =~ /nasm/ || $ENV{ASM} =~ /nasm/) &&
 	   `nasm -v 2>&1` =~ /NASM version ([2-9]\.[0-9]+)/) {
-	$avx = ($1>=2.09) + ($1>=2.10);
+	$avx = ($1>=2.09) + ($1>=2.10) + ($1>=2.12);
 }
 
 if (!$avx && $win64 && ($flavour =~ /masm/ || $ENV{ASM} =~ /ml64/) &&
@@ -71,7 +82,7 @@ if (!$avx && $win64 && ($flavour =~ /masm/ || $ENV{ASM} =~ /ml64/) &&
 }
 
 if (!$avx && `$ENV{CC} -v 2>&1` =~ /((?:^clang|LLVM) version|.*based on LLVM) ([3-9]\.[0-9]+)/) {
-	$avx = ($2>=3.0) + ($2>3.0);
+	$avx = ($2>=3.0) + ($2>3.0) + ($2>=3.6);
 }
 
 open OUT,"| \"$^X\" \"$xlate\" $flavour \"$output\"";
@@ -98,6 +109,10 @@ $code.=<<___;
 .long	0,2,4,6,1,3,5,7
 .Leight:
 .long	8,8,8,8,8,8,8,8
+.Lincz:
+.long	0,1,2,3,4,5,6,7,8,9,10,11,12,13,14,15
+.Lsixteen:
+.long	16,16,16,16,16,16,16,16,16,16,16,16,16,16,16,16
 .Lrot16:
 .byte	0x2,0x3,0x0,0x1, 0x6,0x7,0x4,0x5, 0xa,0xb,0x8,0x9, 0xe,0xf,0xc,0xd
 .Lrot24:
@@ -699,6 +714,12 @@ ChaCha20_4x:
 ___
 $code.=<<___	if ($avx>1);
 	shr		\$32,%r10		# OPENSSL_ia32cap_P+8
+___
+$code.=<<___	if ($avx>2);
+	test		\$`1<<16`,%r10		# test AVX512F
+	jnz		.LChaCha20_16x
+___
+$code.=<<___	if ($avx>1);
 	test		\$`1<<5`,%r10		# test AVX2
 	jnz		.LChaCha20_8x
 ___
@@ -1713,6 +1734,480 @@ my @x=map("\"$_\"",@xx);
 	);
 }
 
+########################################################################
+# Stitched ChaCha20-Poly1305
+#
+# size_t ChaCha20_Poly1305_seal(unsigned char *out, const unsigned char *inp,
+#                               size_t len, const unsigned int key[8],
+#                               const unsigned int counter[4], void *poly);
+# size_t ChaCha20_Poly1305_open(...);
+#
+# Encrypt or decrypt the leading multiple of 512 bytes of |inp| and hash
+# the ciphertext into the poly1305-x86_64 state |poly|, loading every
+# byte once. The number of bytes done is returned, which is zero if
+# processor lacks AVX2 or BMI2, if it has AVX512F, in which case
+# separate ChaCha20_16x and poly1305_blocks_avx2 passes are faster, if
+# hash value is kept in base 2^26, or if less than 2KB is encrypted,
+# because first and last 512 bytes are not overlapped then. Caller has
+# to make sure that counter doesn't wrap and that there is no partial
+# Poly1305 block pending.
+#
+# ChaCha20 rounds are the 8xAVX2 ones, with the 32 Poly1305 blocks of
+# each 512 bytes interleaved, so that the integer units hash while the
+# SIMD ones generate the keystream. When decrypting, the input is hashed
+# while the keystream for it is computed; when encrypting, the previous
+# 512 bytes of output are.
+{
+my ($d1,$d2,$d3,$r0,$r1,$s1)=map("%r$_",(8..13));
+my ($h0,$h1,$h2)=("%r14","%rbx","%rbp");
+my ($hp,$rem)=("%rcx","%r15");
+my $xframe = $win64 ? 0xa0 : 0;
+
+sub POLY1305_BLOCK {	# h = (h + 16 bytes at $hp + 2^128) * r, mulx flavour
+			# of poly1305_blocks' loop body
+my ($inp0,$inp8,$inp16)=map("'$_($hp)'",(0,8,16));
+my ($h0,$h1,$h2,$r0,$r1,$s1,$d1,$d2,$d3,$hp)=
+    map("\"$_\"",($h0,$h1,$h2,$r0,$r1,$s1,$d1,$d2,$d3,$hp));
+
+	(
+	"&add	($h0,$inp0)",		# accumulate input
+	"&adc	($h1,$inp8)",
+	"&lea	($hp,$inp16)",
+	"&adc	($h2,1)",
+
+	"&mov	('%rdx',$h0)",
+	"&mulx	($d3,$d2,$r1)",		# h0*r1
+	"&mulx	($d1,$h0,$r0)",		# h0*r0, future $h0
+	"&mov	('%rdx',$h1)",
+	"&mulx	('%rdx','%rax',$r0)",	# h1*r0
+	"&add	($d2,'%rax')",
+	"&adc	($d3,'%rdx')",
+	"&mov	('%rdx',$h1)",
+	"&mulx	('%rdx','%rax',$s1)",	# h1*s1
+	"&mov	($h1,$h2)",		# borrow $h1
+	"&add	($h0,'%rax')",
+	"&adc	($d1,'%rdx')",
+	"&imulq	($h1,$s1)",		# h2*s1
+	"&add	($d2,$h1)",
+	"&mov	($h1,$d1)",
+	"&adc	($d3,0)",
+	"&imulq	($h2,$r0)",		# h2*r0
+	"&add	($h1,$d2)",
+	"&mov	('%rax',-4)",		# mask value
+	"&adc	($d3,$h2)",
+
+	"&and	('%rax',$d3)",		# last reduction step
+	"&mov	($h2,$d3)",
+	"&shr	($d3,2)",
+	"&and	($h2,3)",
+	"&add	('%rax',$d3)",
+	"&add	($h0,'%rax')",
+	"&adc	($h1,0)",
+	"&adc	($h2,0)"
+	);
+}
+
+sub AVX2_stitch_DOUBLEROUND {	# AVX2_lane_ROUND without %r10 and %r11
+	map { s/'\(%r10\)'/'.Lrot16(%rip)'/; s/'\(%r11\)'/'.Lrot24(%rip)'/; $_ }
+	    (&AVX2_lane_ROUND(0, 4, 8,12), &AVX2_lane_ROUND(0, 5,10,15));
+}
+
+sub stitch {		# spread @$scalar evenly over @$simd
+my ($simd,$scalar)=@_;
+my ($n,$m,$j)=(scalar(@$simd),scalar(@$scalar),0);
+my @ret;
+
+	for (my $i=0; $i<$n; $i++) {
+		push @ret,$$simd[$i];
+		push @ret,$$scalar[$j++] while ($j<int(($i+1)*$m/$n));
+	}
+	@ret;
+}
+
+sub chacha20_poly1305_load {
+$code.=<<___;
+	vmovdqa		0x080(%rsp),$xa0	# re-load smashed key
+	vmovdqa		0x0a0(%rsp),$xa1
+	vmovdqa		0x0c0(%rsp),$xa2
+	vmovdqa		0x0e0(%rsp),$xa3
+	vmovdqa		0x100(%rsp),$xb0
+	vmovdqa		0x120(%rsp),$xb1
+	vmovdqa		0x140(%rsp),$xb2
+	vmovdqa		0x160(%rsp),$xb3
+	vmovdqa		0x180(%rsp),$xt0	# "xc0"
+	vmovdqa		0x1a0(%rsp),$xt1	# "xc1"
+	vmovdqa		0x1c0(%rsp),$xt2	# "xc2"
+	vmovdqa		0x1e0(%rsp),$xt3	# "xc3"
+	vmovdqa		0x200(%rsp),$xd0
+	vmovdqa		0x220(%rsp),$xd1
+	vmovdqa		0x240(%rsp),$xd2
+	vmovdqa		0x260(%rsp),$xd3
+	vmovdqa		$xt2,0x40(%rsp)		# SIMD equivalent of "@x[10]"
+	vmovdqa		$xt3,0x60(%rsp)		# SIMD equivalent of "@x[11]"
+	vbroadcasti128	.Lrot16(%rip),$xt3
+___
+}
+
+sub chacha20_poly1305_xor {	# same as ChaCha20_8x, sets flags for
+				# "more input?"
+my ($xa0,$xa1,$xa2,$xa3,$xb0,$xb1,$xb2,$xb3,
+    $xd0,$xd1,$xd2,$xd3,$xt0,$xt1,$xt2,$xt3)=
+   ($xa0,$xa1,$xa2,$xa3,$xb0,$xb1,$xb2,$xb3,
+    $xd0,$xd1,$xd2,$xd3,$xt0,$xt1,$xt2,$xt3);
+
+$code.=<<___;
+	vpaddd		0x080(%rsp),$xa0,$xa0	# accumulate key
+	vpaddd		0x0a0(%rsp),$xa1,$xa1
+	vpaddd		0x0c0(%rsp),$xa2,$xa2
+	vpaddd		0x0e0(%rsp),$xa3,$xa3
+
+	vpunpckldq	$xa1,$xa0,$xt2		# "de-interlace" data
+	vpunpckldq	$xa3,$xa2,$xt3
+	vpunpckhdq	$xa1,$xa0,$xa0
+	vpunpckhdq	$xa3,$xa2,$xa2
+	vpunpcklqdq	$xt3,$xt2,$xa1		# "a0"
+	vpunpckhqdq	$xt3,$xt2,$xt2		# "a1"
+	vpunpcklqdq	$xa2,$xa0,$xa3		# "a2"
+	vpunpckhqdq	$xa2,$xa0,$xa0		# "a3"
+___
+	($xa0,$xa1,$xa2,$xa3,$xt2)=($xa1,$xt2,$xa3,$xa0,$xa2);
+$code.=<<___;
+	vpaddd		0x100(%rsp),$xb0,$xb0
+	vpaddd		0x120(%rsp),$xb1,$xb1
+	vpaddd		0x140(%rsp),$xb2,$xb2
+	vpaddd		0x160(%rsp),$xb3,$xb3
+
+	vpunpckldq	$xb1,$xb0,$xt2
+	vpunpckldq	$xb3,$xb2,$xt3
+	vpunpckhdq	$xb1,$xb0,$xb0
+	vpunpckhdq	$xb3,$xb2,$xb2
+	vpunpcklqdq	$xt3,$xt2,$xb1		# "b0"
+	vpunpckhqdq	$xt3,$xt2,$xt2		# "b1"
+	vpunpcklqdq	$xb2,$xb0,$xb3		# "b2"
+	vpunpckhqdq	$xb2,$xb0,$xb0		# "b3"
+___
+	($xb0,$xb1,$xb2,$xb3,$xt2)=($xb1,$xt2,$xb3,$xb0,$xb2);
+$code.=<<___;
+	vperm2i128	\$0x20,$xb0,$xa0,$xt3	# "de-interlace" further
+	vperm2i128	\$0x31,$xb0,$xa0,$xb0
+	vperm2i128	\$0x20,$xb1,$xa1,$xa0
+	vperm2i128	\$0x31,$xb1,$xa1,$xb1
+	vperm2i128	\$0x20,$xb2,$xa2,$xa1
+	vperm2i128	\$0x31,$xb2,$xa2,$xb2
+	vperm2i128	\$0x20,$xb3,$xa3,$xa2
+	vperm2i128	\$0x31,$xb3,$xa3,$xb3
+___
+	($xa0,$xa1,$xa2,$xa3,$xt3)=($xt3,$xa0,$xa1,$xa2,$xa3);
+	my ($xc0,$xc1,$xc2,$xc3)=($xt0,$xt1,$xa0,$xa1);
+$code.=<<___;
+	vmovdqa		$xa0,0x00(%rsp)		# offload $xaN
+	vmovdqa		$xa1,0x20(%rsp)
+	vmovdqa		0x40(%rsp),$xc2		# $xa0
+	vmovdqa		0x60(%rsp),$xc3		# $xa1
+
+	vpaddd		0x180(%rsp),$xc0,$xc0
+	vpaddd		0x1a0(%rsp),$xc1,$xc1
+	vpaddd		0x1c0(%rsp),$xc2,$xc2
+	vpaddd		0x1e0(%rsp),$xc3,$xc3
+
+	vpunpckldq	$xc1,$xc0,$xt2
+	vpunpckldq	$xc3,$xc2,$xt3
+	vpunpckhdq	$xc1,$xc0,$xc0
+	vpunpckhdq	$xc3,$xc2,$xc2
+	vpunpcklqdq	$xt3,$xt2,$xc1		# "c0"
+	vpunpckhqdq	$xt3,$xt2,$xt2		# "c1"
+	vpunpcklqdq	$xc2,$xc0,$xc3		# "c2"
+	vpunpckhqdq	$xc2,$xc0,$xc0		# "c3"
+___
+	($xc0,$xc1,$xc2,$xc3,$xt2)=($xc1,$xt2,$xc3,$xc0,$xc2);
+$code.=<<___;
+	vpaddd		0x200(%rsp),$xd0,$xd0
+	vpaddd		0x220(%rsp),$xd1,$xd1
+	vpaddd		0x240(%rsp),$xd2,$xd2
+	vpaddd		0x260(%rsp),$xd3,$xd3
+
+	vpunpckldq	$xd1,$xd0,$xt2
+	vpunpckldq	$xd3,$xd2,$xt3
+	vpunpckhdq	$xd1,$xd0,$xd0
+	vpunpckhdq	$xd3,$xd2,$xd2
+	vpunpcklqdq	$xt3,$xt2,$xd1		# "d0"
+	vpunpckhqdq	$xt3,$xt2,$xt2		# "d1"
+	vpunpcklqdq	$xd2,$xd0,$xd3		# "d2"
+	vpunpckhqdq	$xd2,$xd0,$xd0		# "d3"
+___
+	($xd0,$xd1,$xd2,$xd3,$xt2)=($xd1,$xt2,$xd3,$xd0,$xd2);
+$code.=<<___;
+	vperm2i128	\$0x20,$xd0,$xc0,$xt3	# "de-interlace" further
+	vperm2i128	\$0x31,$xd0,$xc0,$xd0
+	vperm2i128	\$0x20,$xd1,$xc1,$xc0
+	vperm2i128	\$0x31,$xd1,$xc1,$xd1
+	vperm2i128	\$0x20,$xd2,$xc2,$xc1
+	vperm2i128	\$0x31,$xd2,$xc2,$xd2
+	vperm2i128	\$0x20,$xd3,$xc3,$xc2
+	vperm2i128	\$0x31,$xd3,$xc3,$xd3
+___
+	($xc0,$xc1,$xc2,$xc3,$xt3)=($xt3,$xc0,$xc1,$xc2,$xc3);
+	($xb0,$xb1,$xb2,$xb3,$xc0,$xc1,$xc2,$xc3)=
+	($xc0,$xc1,$xc2,$xc3,$xb0,$xb1,$xb2,$xb3);
+	($xa0,$xa1)=($xt2,$xt3);
+$code.=<<___;
+	vmovdqa		0x00(%rsp),$xa0		# $xaN was offloaded, remember?
+	vmovdqa		0x20(%rsp),$xa1
+___
+for (my $i=0; $i<4; $i++) {
+my ($a,$b,$c,$d)=($xa0,$xb0,$xc0,$xd0);
+$code.=<<___;
+	vpxor		0x00($inp),$a,$a	# xor with input
+	vpxor		0x20($inp),$b,$b
+	vpxor		0x40($inp),$c,$c
+	vpxor		0x60($inp),$d,$d
+	lea		0x80($inp),$inp
+	vmovdqu		$a,0x00($out)
+	vmovdqu		$b,0x20($out)
+	vmovdqu		$c,0x40($out)
+	vmovdqu		$d,0x60($out)
+	lea		0x80($out),$out
+___
+	($xa0,$xa1,$xa2,$xa3)=($xa1,$xa2,$xa3,$xa0);
+	($xb0,$xb1,$xb2,$xb3)=($xb1,$xb2,$xb3,$xb0);
+	($xc0,$xc1,$xc2,$xc3)=($xc1,$xc2,$xc3,$xc0);
+	($xd0,$xd1,$xd2,$xd3)=($xd1,$xd2,$xd3,$xd0);
+}
+$code.=<<___;
+	vmovdqa		0x200(%rsp),$xt0	# next SIMD counters
+	vpaddd		.Leight(%rip),$xt0,$xt0
+	vmovdqa		$xt0,0x200(%rsp)
+
+	sub		\$64*8,$rem
+___
+}
+
+$code.=<<___;
+.globl	ChaCha20_Poly1305_seal
+.type	ChaCha20_Poly1305_seal,\@function,6
+.align	32
+ChaCha20_Poly1305_seal:
+	mov		\$1,%eax
+	call		__ChaCha20_Poly1305
+	ret
+.size	ChaCha20_Poly1305_seal,.-ChaCha20_Poly1305_seal
+
+.globl	ChaCha20_Poly1305_open
+.type	ChaCha20_Poly1305_open,\@function,6
+.align	32
+ChaCha20_Poly1305_open:
+	xor		%eax,%eax
+	call		__ChaCha20_Poly1305
+	ret
+.size	ChaCha20_Poly1305_open,.-ChaCha20_Poly1305_open
+
+.type	__ChaCha20_Poly1305,\@abi-omnipotent
+.align	32
+__ChaCha20_Poly1305:
+	mov		OPENSSL_ia32cap_P+8(%rip),%r10d
+	and		\$`1<<5|1<<8|1<<16`,%r10d
+	cmp		\$`1<<5|1<<8`,%r10d	# AVX2 and BMI2, but not AVX512F?
+	jne		.Lno_stitch
+	cmpl		\$0,20(%r9)		# is_base2_26?
+	jne		.Lno_stitch
+	and		\$-64*8,$len
+	jz		.Lno_stitch
+	test		%eax,%eax
+	jz		.Lstitch
+	cmp		\$64*8*4,$len		# encrypting has to fill the pipe
+	jae		.Lstitch
+.Lno_stitch:
+	xor		%eax,%eax
+	ret
+
+.align	32
+.Lstitch:
+	push		%rbx
+	push		%rbp
+	push		%r12
+	push		%r13
+	push		%r14
+	push		%r15
+	mov		%rsp,%r10
+	sub		\$0x2a0+$xframe,%rsp
+	and		\$-32,%rsp
+___
+$code.=<<___	if ($win64);
+	movaps		%xmm6,0x2a0(%rsp)
+	movaps		%xmm7,0x2b0(%rsp)
+	movaps		%xmm8,0x2c0(%rsp)
+	movaps		%xmm9,0x2d0(%rsp)
+	movaps		%xmm10,0x2e0(%rsp)
+	movaps		%xmm11,0x2f0(%rsp)
+	movaps		%xmm12,0x300(%rsp)
+	movaps		%xmm13,0x310(%rsp)
+	movaps		%xmm14,0x320(%rsp)
+	movaps		%xmm15,0x330(%rsp)
+___
+$code.=<<___;
+	vzeroupper
+	mov		%r10,0x280(%rsp)
+	mov		$len,0x288(%rsp)
+	mov		%r9,0x290(%rsp)
+	mov		$len,$rem
+
+	################ stack layout
+	# +0x00		SIMD equivalent of @x[8-12]
+	# ...
+	# +0x80		constant copy of key[0-2] smashed by lanes
+	# ...
+	# +0x200	SIMD counters (with nonce smashed by lanes)
+	# ...
+	# +0x280	saved %rsp
+	# +0x288	return value
+	# +0x290	Poly1305 state
+	# +0x298	non-zero when encrypting
+	# +0x29c	round counter
+
+	vbroadcasti128	.Lsigma(%rip),$xa3	# key[0]
+	vbroadcasti128	($key),$xb3		# key[1]
+	vbroadcasti128	16($key),$xt3		# key[2]
+	vbroadcasti128	($counter),$xd3		# key[3]
+
+	vpshufd		\$0x00,$xa3,$xa0	# smash key by lanes...
+	vpshufd		\$0x55,$xa3,$xa1
+	vpshufd		\$0xaa,$xa3,$xa2
+	vpshufd		\$0xff,$xa3,$xa3
+	vmovdqa		$xa0,0x080(%rsp)	# ... and offload
+	vmovdqa		$xa1,0x0a0(%rsp)
+	vmovdqa		$xa2,0x0c0(%rsp)
+	vmovdqa		$xa3,0x0e0(%rsp)
+
+	vpshufd		\$0x00,$xb3,$xb0
+	vpshufd		\$0x55,$xb3,$xb1
+	vpshufd		\$0xaa,$xb3,$xb2
+	vpshufd		\$0xff,$xb3,$xb3
+	vmovdqa		$xb0,0x100(%rsp)
+	vmovdqa		$xb1,0x120(%rsp)
+	vmovdqa		$xb2,0x140(%rsp)
+	vmovdqa		$xb3,0x160(%rsp)
+
+	vpshufd		\$0x00,$xt3,$xt0	# "xc0"
+	vpshufd		\$0x55,$xt3,$xt1	# "xc1"
+	vpshufd		\$0xaa,$xt3,$xt2	# "xc2"
+	vpshufd		\$0xff,$xt3,$xt3	# "xc3"
+	vmovdqa		$xt0,0x180(%rsp)
+	vmovdqa		$xt1,0x1a0(%rsp)
+	vmovdqa		$xt2,0x1c0(%rsp)
+	vmovdqa		$xt3,0x1e0(%rsp)
+
+	vpshufd		\$0x00,$xd3,$xd0
+	vpshufd		\$0x55,$xd3,$xd1
+	vpshufd		\$0xaa,$xd3,$xd2
+	vpshufd		\$0xff,$xd3,$xd3
+	vpaddd		.Lincy(%rip),$xd0,$xd0
+	vmovdqa		$xd0,0x200(%rsp)
+	vmovdqa		$xd1,0x220(%rsp)
+	vmovdqa		$xd2,0x240(%rsp)
+	vmovdqa		$xd3,0x260(%rsp)
+
+	mov		24(%r9),$r0		# load r
+	mov		32(%r9),$s1
+	mov		0(%r9),$h0		# load hash value
+	mov		8(%r9),$h1
+	mov		16(%r9),$h2
+	mov		$s1,$r1
+	shr		\$2,$s1
+	add		$r1,$s1			# s1 = r1 + (r1 >> 2)
+
+	mov		%eax,0x298(%rsp)
+	mov		$inp,$hp		# hash input before decrypting it
+	test		%eax,%eax
+	jz		.Loop_stitch
+
+	mov		$out,$hp		# hash output one iteration behind
+___
+	&chacha20_poly1305_load();
+$code.=<<___;
+	mov		\$10,%r8d
+.Loop_seal_first:
+___
+	foreach (&AVX2_stitch_DOUBLEROUND()) { eval; }
+$code.=<<___;
+	dec		%r8d
+	jnz		.Loop_seal_first
+___
+	&chacha20_poly1305_xor();
+$code.=<<___;
+	jz		.Lseal_last
+
+.align	32
+.Loop_stitch:
+___
+	&chacha20_poly1305_load();
+$code.=<<___;
+	movl		\$8,0x29c(%rsp)
+.Loop_stitch_3:
+___
+	foreach (&stitch([&AVX2_stitch_DOUBLEROUND()],
+			 [map(&POLY1305_BLOCK(),(1..3))])) { eval; }
+$code.=<<___;
+	decl		0x29c(%rsp)
+	jnz		.Loop_stitch_3
+
+	movl		\$2,0x29c(%rsp)
+.Loop_stitch_4:
+___
+	foreach (&stitch([&AVX2_stitch_DOUBLEROUND()],
+			 [map(&POLY1305_BLOCK(),(1..4))])) { eval; }
+$code.=<<___;
+	decl		0x29c(%rsp)
+	jnz		.Loop_stitch_4
+___
+	&chacha20_poly1305_xor();
+$code.=<<___;
+	jnz		.Loop_stitch
+
+	cmpl		\$0,0x298(%rsp)		# open?
+	je		.Ldone_stitch
+
+.Lseal_last:
+	mov		\$32,$rem
+.Loop_seal_last:
+___
+	foreach (&POLY1305_BLOCK()) { eval; }
+$code.=<<___;
+	dec		$rem
+	jnz		.Loop_seal_last
+
+.Ldone_stitch:
+	mov		0x290(%rsp),%r9
+	mov		$h0,0(%r9)		# store hash value
+	mov		$h1,8(%r9)
+	mov		$h2,16(%r9)
+	vzeroall
+___
+$code.=<<___	if ($win64);
+	movaps		0x2a0(%rsp),%xmm6
+	movaps		0x2b0(%rsp),%xmm7
+	movaps		0x2c0(%rsp),%xmm8
+	movaps		0x2d0(%rsp),%xmm9
+	movaps		0x2e0(%rsp),%xmm10
+	movaps		0x2f0(%rsp),%xmm11
+	movaps		0x300(%rsp),%xmm12
+	movaps		0x310(%rsp),%xmm13
+	movaps		0x320(%rsp),%xmm14
+	movaps		0x330(%rsp),%xmm15
+___
+$code.=<<___;
+	mov		0x288(%rsp),%rax
+	mov		0x280(%rsp),%rsp
+	pop		%r15
+	pop		%r14
+	pop		%r13
+	pop		%r12
+	pop		%rbp
+	pop		%rbx
+	ret
+.size	__ChaCha20_Poly1305,.-__ChaCha20_Poly1305
+___
+}
+
 my $xframe = $win64 ? 0xb0 : 8;
 
 $code.=<<___;
@@ -2233,6 +2728,277 @@ $code.=<<___;
 ___
 }
 
+########################################################################
+# AVX512 code paths
+if ($avx>2) {
+my ($xa0,$xa1,$xa2,$xa3, $xb0,$xb1,$xb2,$xb3,
+    $xc0,$xc1,$xc2,$xc3, $xd0,$xd1,$xd2,$xd3)=map("%zmm$_",(0..15));
+my @xx=($xa0,$xa1,$xa2,$xa3, $xb0,$xb1,$xb2,$xb3,
+	$xc0,$xc1,$xc2,$xc3, $xd0,$xd1,$xd2,$xd3);
+my @key=map("%zmm$_",(16..31));
+my ($xt0,$xt1,$xt2,$xt3)=@key[0..3];	# sigma is re-loaded every time
+
+sub AVX512_lane_ROUND {
+my ($a0,$b0,$c0,$d0)=@_;
+my ($a1,$b1,$c1,$d1)=map(($_&~3)+(($_+1)&3),($a0,$b0,$c0,$d0));
+my ($a2,$b2,$c2,$d2)=map(($_&~3)+(($_+1)&3),($a1,$b1,$c1,$d1));
+my ($a3,$b3,$c3,$d3)=map(($_&~3)+(($_+1)&3),($a2,$b2,$c2,$d2));
+my @x=map("\"$_\"",@xx);
+my @a=@x[$a0,$a1,$a2,$a3];
+my @b=@x[$b0,$b1,$b2,$b3];
+my @c=@x[$c0,$c1,$c2,$c3];
+my @d=@x[$d0,$d1,$d2,$d3];
+my @ret;
+
+	# With 32 registers all 16 words of state stay in registers, and
+	# rotations are single vprold instructions, so that all four
+	# quarter-rounds are simply interleaved step by step.
+
+	foreach my $rot (16,12,8,7) {
+	    my ($p,$q,$r) = ($rot==16 || $rot==8) ? (\@a,\@b,\@d)
+						    : (\@c,\@d,\@b);
+	    push @ret,map("&vpaddd	($$p[$_],$$p[$_],$$q[$_])",(0..3));
+	    push @ret,map("&vpxord	($$r[$_],$$r[$_],$$p[$_])",(0..3));
+	    push @ret,map("&vprold	($$r[$_],$$r[$_],$rot)",(0..3));
+	}
+	@ret;
+}
+
+my $xframe = $win64 ? 0xa0 : 0;
+
+$code.=<<___;
+.type	ChaCha20_16x,\@function,5
+.align	32
+ChaCha20_16x:
+.LChaCha20_16x:
+	cmp		\$512,$len		# 8x is faster on shorter inputs
+	jbe		.LChaCha20_8x
+	mov		%rsp,%r10
+	sub		\$0x410+$xframe,%rsp
+	and		\$-64,%rsp
+___
+$code.=<<___	if ($win64);
+	movaps		%xmm6,0x410(%rsp)
+	movaps		%xmm7,0x420(%rsp)
+	movaps		%xmm8,0x430(%rsp)
+	movaps		%xmm9,0x440(%rsp)
+	movaps		%xmm10,0x450(%rsp)
+	movaps		%xmm11,0x460(%rsp)
+	movaps		%xmm12,0x470(%rsp)
+	movaps		%xmm13,0x480(%rsp)
+	movaps		%xmm14,0x490(%rsp)
+	movaps		%xmm15,0x4a0(%rsp)
+___
+$code.=<<___;
+	vzeroupper
+	mov		%r10,0x400(%rsp)
+
+	################ stack layout
+	# +0x000	key stream for the tail
+	# ...
+	# +0x400	saved %rsp
+
+	lea		.Lsigma(%rip),%r10
+	vpbroadcastd	0x00($key),@key[4]	# smash key by lanes...
+	vpbroadcastd	0x04($key),@key[5]
+	vpbroadcastd	0x08($key),@key[6]
+	vpbroadcastd	0x0c($key),@key[7]
+	vpbroadcastd	0x10($key),@key[8]
+	vpbroadcastd	0x14($key),@key[9]
+	vpbroadcastd	0x18($key),@key[10]
+	vpbroadcastd	0x1c($key),@key[11]
+	vpbroadcastd	0x00($counter),@key[12]
+	vpbroadcastd	0x04($counter),@key[13]
+	vpbroadcastd	0x08($counter),@key[14]
+	vpbroadcastd	0x0c($counter),@key[15]
+	vpaddd		.Lincz(%rip),@key[12],@key[12]	# SIMD counters
+	jmp		.Loop_outer16x
+
+.align	32
+.Loop_outer16x:
+	vpbroadcastd	0x00(%r10),$xt0		# ... and re-load sigma
+	vpbroadcastd	0x04(%r10),$xt1
+	vpbroadcastd	0x08(%r10),$xt2
+	vpbroadcastd	0x0c(%r10),$xt3
+___
+	foreach (0..15) { $code.="\tvmovdqa32\t@key[$_],@xx[$_]\n"; }
+$code.=<<___;
+	mov		\$10,%eax
+	jmp		.Loop16x
+
+.align	32
+.Loop16x:
+___
+	foreach (&AVX512_lane_ROUND(0, 4, 8,12)) { eval; }
+	foreach (&AVX512_lane_ROUND(0, 5,10,15)) { eval; }
+$code.=<<___;
+	dec		%eax
+	jnz		.Loop16x
+
+___
+	foreach (0..15) { $code.="\tvpaddd\t\t@key[$_],@xx[$_],@xx[$_]\n"; }
+$code.=<<___;
+	vpaddd		.Lsixteen(%rip),@key[12],@key[12]	# next SIMD counters
+
+	vpunpckldq	$xa1,$xa0,$xt2		# "de-interlace" data
+	vpunpckldq	$xa3,$xa2,$xt3
+	vpunpckhdq	$xa1,$xa0,$xa0
+	vpunpckhdq	$xa3,$xa2,$xa2
+	vpunpcklqdq	$xt3,$xt2,$xa1		# "a0"
+	vpunpckhqdq	$xt3,$xt2,$xt2		# "a1"
+	vpunpcklqdq	$xa2,$xa0,$xa3		# "a2"
+	vpunpckhqdq	$xa2,$xa0,$xa0		# "a3"
+___
+	($xa0,$xa1,$xa2,$xa3,$xt2)=($xa1,$xt2,$xa3,$xa0,$xa2);
+$code.=<<___;
+	vpunpckldq	$xb1,$xb0,$xt2
+	vpunpckldq	$xb3,$xb2,$xt3
+	vpunpckhdq	$xb1,$xb0,$xb0
+	vpunpckhdq	$xb3,$xb2,$xb2
+	vpunpcklqdq	$xt3,$xt2,$xb1		# "b0"
+	vpunpckhqdq	$xt3,$xt2,$xt2		# "b1"
+	vpunpcklqdq	$xb2,$xb0,$xb3		# "b2"
+	vpunpckhqdq	$xb2,$xb0,$xb0		# "b3"
+___
+	($xb0,$xb1,$xb2,$xb3,$xt2)=($xb1,$xt2,$xb3,$xb0,$xb2);
+$code.=<<___;
+	vpunpckldq	$xc1,$xc0,$xt2
+	vpunpckldq	$xc3,$xc2,$xt3
+	vpunpckhdq	$xc1,$xc0,$xc0
+	vpunpckhdq	$xc3,$xc2,$xc2
+	vpunpcklqdq	$xt3,$xt2,$xc1		# "c0"
+	vpunpckhqdq	$xt3,$xt2,$xt2		# "c1"
+	vpunpcklqdq	$xc2,$xc0,$xc3		# "c2"
+	vpunpckhqdq	$xc2,$xc0,$xc0		# "c3"
+___
+	($xc0,$xc1,$xc2,$xc3,$xt2)=($xc1,$xt2,$xc3,$xc0,$xc2);
+$code.=<<___;
+	vpunpckldq	$xd1,$xd0,$xt2
+	vpunpckldq	$xd3,$xd2,$xt3
+	vpunpckhdq	$xd1,$xd0,$xd0
+	vpunpckhdq	$xd3,$xd2,$xd2
+	vpunpcklqdq	$xt3,$xt2,$xd1		# "d0"
+	vpunpckhqdq	$xt3,$xt2,$xt2		# "d1"
+	vpunpcklqdq	$xd2,$xd0,$xd3		# "d2"
+	vpunpckhqdq	$xd2,$xd0,$xd0		# "d3"
+___
+	($xd0,$xd1,$xd2,$xd3,$xt2)=($xd1,$xt2,$xd3,$xd0,$xd2);
+
+	# 128-bit lane #i of "aN" holds words 0-3 of block 4*i+N, so
+	# that collecting lanes #i of "aN", "bN", "cN" and "dN" yields
+	# complete block 4*i+N...
+
+my @xa=($xa0,$xa1,$xa2,$xa3);
+my @xb=($xb0,$xb1,$xb2,$xb3);
+my @xc=($xc0,$xc1,$xc2,$xc3);
+my @xd=($xd0,$xd1,$xd2,$xd3);
+my @blk;
+my $xt=$xt3;
+for my $n (0..3) {
+my ($a,$b,$c,$d)=($xa[$n],$xb[$n],$xc[$n],$xd[$n]);
+$code.=<<___;
+	vshufi32x4	\$0x44,$b,$a,$xt	# "de-interlace" further
+	vshufi32x4	\$0xee,$b,$a,$b
+	vshufi32x4	\$0x44,$d,$c,$a
+	vshufi32x4	\$0xee,$d,$c,$d
+	vshufi32x4	\$0x88,$a,$xt,$c	# block $n
+	vshufi32x4	\$0xdd,$a,$xt,$a	# block `4+$n`
+	vshufi32x4	\$0x88,$d,$b,$xt	# block `8+$n`
+	vshufi32x4	\$0xdd,$d,$b,$d		# block `12+$n`
+___
+	@blk[$n,4+$n,8+$n,12+$n]=($c,$a,$xt,$d);
+	$xt=$b;
+}
+$code.=<<___;
+
+	cmp		\$64*16,$len
+	jb		.Ltail16x
+
+___
+	foreach (0..15) {
+	    $code.="\tvpxord\t\t`64*$_`($inp),$blk[$_],$blk[$_]\n";
+	    $code.="\tvmovdqu32\t$blk[$_],`64*$_`($out)\n";
+	}
+$code.=<<___;
+	lea		0x400($inp),$inp
+	lea		0x400($out),$out
+
+	sub		\$64*16,$len
+	jnz		.Loop_outer16x
+
+	jmp		.Ldone16x
+
+.align	32
+.Ltail16x:
+___
+	foreach (0..15) { $code.="\tvmovdqa32\t$blk[$_],`64*$_`(%rsp)\n"; }
+$code.=<<___;
+	xor		%r10,%r10
+	sub		\$64,$len
+	jb		.Less_than_64_16x
+
+.Loop_tail64_16x:
+	vmovdqa32	(%rsp,%r10),$xt
+	vpxord		($inp,%r10),$xt,$xt
+	vmovdqu32	$xt,($out,%r10)
+	lea		64(%r10),%r10
+	sub		\$64,$len
+	jae		.Loop_tail64_16x
+
+.Less_than_64_16x:
+	add		\$64,$len
+	jz		.Ldone16x
+
+.Loop_tail16x:
+	movzb		($inp,%r10),%eax
+	movzb		(%rsp,%r10),%ecx
+	lea		1(%r10),%r10
+	xor		%ecx,%eax
+	mov		%al,-1($out,%r10)
+	dec		$len
+	jnz		.Loop_tail16x
+
+.Ldone16x:
+	vzeroall
+___
+$code.=<<___	if ($win64);
+	movaps		0x410(%rsp),%xmm6
+	movaps		0x420(%rsp),%xmm7
+	movaps		0x430(%rsp),%xmm8
+	movaps		0x440(%rsp),%xmm9
+	movaps		0x450(%rsp),%xmm10
+	movaps		0x460(%rsp),%xmm11
+	movaps		0x470(%rsp),%xmm12
+	movaps		0x480(%rsp),%xmm13
+	movaps		0x490(%rsp),%xmm14
+	movaps		0x4a0(%rsp),%xmm15
+___
+$code.=<<___;
+	mov		0x400(%rsp),%rsp
+	ret
+.size	ChaCha20_16x,.-ChaCha20_16x
+___
+}
+
+# Assembler can't do AVX2, so there is no stitched ChaCha20-Poly1305.
+if ($avx<2) {
+$code.=<<___;
+.globl	ChaCha20_Poly1305_seal
+.type	ChaCha20_Poly1305_seal,\@abi-omnipotent
+ChaCha20_Poly1305_seal:
+	xor	%eax,%eax		# assembler can't do AVX2
+	ret
+.size	ChaCha20_Poly1305_seal,.-ChaCha20_Poly1305_seal
+
+.globl	ChaCha20_Poly1305_open
+.type	ChaCha20_Poly1305_open,\@abi-omnipotent
+ChaCha20_Poly1305_open:
+	xor	%eax,%eax
+	ret
+.size	ChaCha20_Poly1305_open,.-ChaCha20_Poly1305_open
+___
+}
+
 foreach (split("\n",$code)) {
 	s/\`([^\`]*)\`/eval $1/geo;
 
@@ -409,6 +409,15 @@ static int int_dh_param_copy(DH *to, const DH *from, int is_x942)
         }
     } else
         to->length = from->length;
+
+    bn_fixed_base_free(to->fixed_base_g);
+    to->fixed_base_g = NULL;
+    CRYPTO_THREAD_read_lock(from->lock);
+    if (from->fixed_base_g != NULL
+        && bn_fixed_base_bits(from->fixed_base_g) >= dh_priv_bits(to)
+        && bn_fixed_base_up_ref(from->fixed_base_g))
+        to->fixed_base_g = from->fixed_base_g;
+    CRYPTO_THREAD_unlock(from->lock);
     return 1;
 }
 
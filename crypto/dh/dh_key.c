@@ -61,6 +61,55 @@ const DH_METHOD *DH_OpenSSL(void)
     return &dh_ossl;
 }
 
+/* The length of the private exponents generate_key() picks */
+int dh_priv_bits(const DH *dh)
+{
+    if (dh->q != NULL)
+        return BN_num_bits(dh->q);
+    return dh->length ? dh->length : BN_num_bits(dh->p) - 1;
+}
+
+/*
+ * The powers of g are only used if both key generation and exponentiation
+ * are our own.
+ */
+static int dh_use_fixed_base(const DH *dh)
+{
+    return dh->meth->generate_key == generate_key
+           && dh->meth->bn_mod_exp == dh_bn_mod_exp
+           && (dh->flags & DH_FLAG_CACHE_MONT_P) != 0;
+}
+
+/*
+ * Give |to|, a copy of the parameters of |from|, the powers of g cached in
+ * |from|, computing them first if needed, so that they are computed once
+ * for all the keys generated from the same parameters. They are only shared
+ * if they cover the private exponents of |to|, as a copy may have lost q.
+ */
+int dh_share_fixed_base(DH *to, DH *from)
+{
+    BN_FIXED_BASE *fb;
+    BN_CTX *ctx;
+    int bits;
+
+    if (to->p == NULL || to->g == NULL
+        || !dh_use_fixed_base(to) || !dh_use_fixed_base(from))
+        return 1;
+    bits = dh_priv_bits(to);
+    if ((ctx = bn_ctx_thread_get(BN_num_bits(from->p))) == NULL)
+        return 0;
+    fb = bn_fixed_base_set_locked(&from->fixed_base_g, from->lock, from->g,
+                                  from->p, bits, ctx);
+    bn_ctx_thread_put(ctx);
+    if (fb == NULL)
+        return 0;
+    if (bn_fixed_base_bits(fb) >= bits && bn_fixed_base_up_ref(fb)) {
+        bn_fixed_base_free(to->fixed_base_g);
+        to->fixed_base_g = fb;
+    }
+    return 1;
+}
+
 static int generate_key(DH *dh)
 {
     int ok = 0;
@@ -70,7 +119,7 @@ static int generate_key(DH *dh)
     BN_MONT_CTX *mont = NULL;
     BIGNUM *pub_key = NULL, *priv_key = NULL;
 
-    ctx = BN_CTX_new();
+    ctx = bn_ctx_thread_get(BN_num_bits(dh->p));
     if (ctx == NULL)
         goto err;
 
@@ -113,12 +162,22 @@ static int generate_key(DH *dh)
 
     {
         BIGNUM *prk = BN_new();
+        BN_FIXED_BASE *fb = NULL;
+        int ret;
 
         if (prk == NULL)
             goto err;
         BN_with_flags(prk, priv_key, BN_FLG_CONSTTIME);
 
-        if (!dh->meth->bn_mod_exp(dh, pub_key, dh->g, prk, dh->p, ctx, mont)) {
+        if (dh_use_fixed_base(dh)) {
+            fb = bn_fixed_base_set_locked(&dh->fixed_base_g, dh->lock, dh->g,
+                                          dh->p, dh_priv_bits(dh), ctx);
+            ret = fb != NULL && bn_fixed_base_exp(pub_key, prk, fb, ctx);
+        } else {
+            ret = dh->meth->bn_mod_exp(dh, pub_key, dh->g, prk, dh->p, ctx,
+                                       mont);
+        }
+        if (!ret) {
             BN_free(prk);
             goto err;
         }
@@ -137,7 +196,7 @@ static int generate_key(DH *dh)
         BN_free(pub_key);
     if (priv_key != dh->priv_key)
         BN_free(priv_key);
-    BN_CTX_free(ctx);
+    bn_ctx_thread_put(ctx);
     return (ok);
 }
 
@@ -154,7 +213,7 @@ static int compute_key(unsigned char *key, const BIGNUM *pub_key, DH *dh)
         goto err;
     }
 
-    ctx = BN_CTX_new();
+    ctx = bn_ctx_thread_get(BN_num_bits(dh->p));
     if (ctx == NULL)
         goto err;
     BN_CTX_start(ctx);
@@ -188,7 +247,7 @@ static int compute_key(unsigned char *key, const BIGNUM *pub_key, DH *dh)
  err:
     if (ctx != NULL) {
         BN_CTX_end(ctx);
-        BN_CTX_free(ctx);
+        bn_ctx_thread_put(ctx);
     }
     return (ret);
 }
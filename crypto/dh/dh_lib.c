@@ -127,6 +127,7 @@ void DH_free(DH *r)
 
     CRYPTO_THREAD_lock_free(r->lock);
 
+    bn_fixed_base_free(r->fixed_base_g);
     BN_clear_free(r->p);
     BN_clear_free(r->g);
     BN_clear_free(r->q);
@@ -220,6 +221,10 @@ int DH_set0_pqg(DH *dh, BIGNUM *p, BIGNUM *q, BIGNUM *g)
         dh->length = BN_num_bits(q);
     }
 
+    /* Powers of the old g are of no use any more */
+    bn_fixed_base_free(dh->fixed_base_g);
+    dh->fixed_base_g = NULL;
+
     return 1;
 }
 
@@ -8,6 +8,7 @@
  */
 
 #include <openssl/dh.h>
+#include "internal/bn_int.h"
 
 struct dh_st {
     /*
@@ -23,6 +24,8 @@ struct dh_st {
     BIGNUM *priv_key;           /* x */
     int flags;
     BN_MONT_CTX *method_mont_p;
+    /* Powers of g for key generation, shared with copies of the parameters */
+    BN_FIXED_BASE *fixed_base_g;
     /* Place holders if we want to do X9.42 DH */
     BIGNUM *q;
     BIGNUM *j;
@@ -54,3 +57,6 @@ struct dh_method {
     int (*generate_params) (DH *dh, int prime_len, int generator,
                             BN_GENCB *cb);
 };
+
+int dh_priv_bits(const DH *dh);
+int dh_share_fixed_base(DH *to, DH *from);
@@ -369,7 +369,8 @@ static int pkey_dh_keygen(EVP_PKEY_CTX *ctx, EVP_PKEY *pkey)
         return 0;
     EVP_PKEY_assign(pkey, ctx->pmeth->pkey_id, dh);
     /* Note: if error return, pkey is freed by parent routine */
-    if (!EVP_PKEY_copy_parameters(pkey, ctx->pkey))
+    if (!EVP_PKEY_copy_parameters(pkey, ctx->pkey)
+        || !dh_share_fixed_base(dh, ctx->pkey->pkey.dh))
         return 0;
     return DH_generate_key(pkey->pkey.dh);
 }
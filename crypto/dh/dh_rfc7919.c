@@ -0,0 +1,50 @@
+/*
+ * Copyright 2016 The OpenSSL Project Authors. All Rights Reserved.
+ *
+ * Licensed under the OpenSSL license (the "License").  You may not use
+ * this file except in compliance with the License.  You can obtain a copy
+ * in the file LICENSE in the source distribution or at
+ * https://www.openssl.org/source/license.html
+ */
+
+#include <stdio.h>
+#include "internal/cryptlib.h"
+#include "dh_locl.h"
+#include <openssl/bn.h>
+#include "internal/bn_dh.h"
+
+/*
+ * The groups are safe primes, so q is (p - 1) / 2 and not worth storing.
+ * Private keys are shorter than p, of the lengths recommended in RFC 7919,
+ * twice the security level of the group.
+ */
+static DH *dh_param_init(const BIGNUM *p, long length)
+{
+    DH *dh = DH_new();
+
+    if (dh == NULL)
+        return NULL;
+    dh->p = BN_dup(p);
+    dh->g = BN_dup(&_bignum_ffdhe_g);
+    if (dh->p == NULL || dh->g == NULL) {
+        DH_free(dh);
+        return NULL;
+    }
+    dh->length = length;
+    return dh;
+}
+
+DH *DH_get_ffdhe2048(void)
+{
+    return dh_param_init(&_bignum_ffdhe2048_p, 225);
+}
+
+DH *DH_get_ffdhe3072(void)
+{
+    return dh_param_init(&_bignum_ffdhe3072_p, 275);
+}
+
+DH *DH_get_ffdhe4096(void)
+{
+    return dh_param_init(&_bignum_ffdhe4096_p, 325);
+}
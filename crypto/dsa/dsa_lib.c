@@ -136,6 +136,7 @@ void DSA_free(DSA *r)
 
     CRYPTO_THREAD_lock_free(r->lock);
 
+    bn_fixed_base_free(r->fixed_base_g);
     BN_clear_free(r->p);
     BN_clear_free(r->q);
     BN_clear_free(r->g);
@@ -287,6 +288,10 @@ int DSA_set0_pqg(DSA *d, BIGNUM *p, BIGNUM *q, BIGNUM *g)
         d->g = g;
     }
 
+    /* Powers of the old g are of no use any more */
+    bn_fixed_base_free(d->fixed_base_g);
+    d->fixed_base_g = NULL;
+
     return 1;
 }
 
@@ -8,6 +8,7 @@
  */
 
 #include <openssl/dsa.h>
+#include "internal/bn_int.h"
 
 struct dsa_st {
     /*
@@ -24,6 +25,8 @@ struct dsa_st {
     int flags;
     /* Normally used to cache montgomery values */
     BN_MONT_CTX *method_mont_p;
+    /* Powers of g for signing */
+    BN_FIXED_BASE *fixed_base_g;
     int references;
     CRYPTO_EX_DATA ex_data;
     const DSA_METHOD *meth;
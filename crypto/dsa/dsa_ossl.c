@@ -132,6 +132,7 @@ static int dsa_sign_setup(DSA *dsa, BN_CTX *ctx_in,
 {
     BN_CTX *ctx = NULL;
     BIGNUM *k, *kinv = NULL, *r = *rp;
+    BN_FIXED_BASE *fb;
     int ret = 0;
 
     if (!dsa->p || !dsa->q || !dsa->g) {
@@ -191,6 +192,13 @@ static int dsa_sign_setup(DSA *dsa, BN_CTX *ctx_in,
             if (!dsa->meth->bn_mod_exp(dsa, r, dsa->g, k, dsa->p, ctx,
                                        dsa->method_mont_p))
                 goto err;
+    } else if (dsa->flags & DSA_FLAG_CACHE_MONT_P) {
+            /* k has exactly one bit more than q by now */
+            fb = bn_fixed_base_set_locked(&dsa->fixed_base_g, dsa->lock,
+                                          dsa->g, dsa->p,
+                                          BN_num_bits(dsa->q) + 1, ctx);
+            if (fb == NULL || !bn_fixed_base_exp(r, k, fb, ctx))
+                goto err;
     } else {
             if (!BN_mod_exp_mont(r, dsa->g, k, dsa->p, ctx, dsa->method_mont_p))
                 goto err;
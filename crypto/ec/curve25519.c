@@ -13,6 +13,9 @@
  * The field functions are shared by Ed25519 and X25519 where possible. */
 
 #include <string.h>
+#include <openssl/err.h>
+#include <openssl/rand.h>
+#include <openssl/sha.h>
 #include "ec_lcl.h"
 
 
@@ -898,6 +901,103 @@ static void fe_sq2(fe h, const fe f) {
   h[9] = h9;
 }
 
+/* return 0 if f == 0
+ * return 1 if f != 0
+ *
+ * Preconditions:
+ *    |f| bounded by 1.1*2^26,1.1*2^25,1.1*2^26,1.1*2^25,etc. */
+static int fe_isnonzero(const fe f) {
+  static const uint8_t zero[32] = {0};
+  uint8_t s[32];
+
+  fe_tobytes(s, f);
+  return CRYPTO_memcmp(s, zero, sizeof(zero)) != 0;
+}
+
+/* return 1 if f is in {1,3,5,...,q-2}
+ * return 0 if f is in {0,2,4,...,q-1}
+ *
+ * Preconditions:
+ *    |f| bounded by 1.1*2^26,1.1*2^25,1.1*2^26,1.1*2^25,etc. */
+static int fe_isnegative(const fe f) {
+  uint8_t s[32];
+
+  fe_tobytes(s, f);
+  return s[0] & 1;
+}
+
+/* out = z ** ((2 ** 255 - 19 - 5) / 8) = z ** (2 ** 252 - 3), which is used
+ * to compute square roots. The chain follows fe_invert. */
+static void fe_pow22523(fe out, const fe z) {
+  fe t0;
+  fe t1;
+  fe t2;
+  int i;
+
+  /* t0 = z ** 11, t1 = z ** 9 */
+  fe_sq(t0, z);
+  fe_sq(t1, t0);
+  fe_sq(t1, t1);
+  fe_mul(t1, z, t1);
+  fe_mul(t0, t0, t1);
+
+  /* t0 = z ** (2 ** 5 - 1) */
+  fe_sq(t0, t0);
+  fe_mul(t0, t1, t0);
+
+  /* t0 = z ** (2 ** 10 - 1) */
+  fe_sq(t1, t0);
+  for (i = 1; i < 5; ++i) {
+    fe_sq(t1, t1);
+  }
+  fe_mul(t0, t1, t0);
+
+  /* t1 = z ** (2 ** 20 - 1) */
+  fe_sq(t1, t0);
+  for (i = 1; i < 10; ++i) {
+    fe_sq(t1, t1);
+  }
+  fe_mul(t1, t1, t0);
+
+  /* t1 = z ** (2 ** 40 - 1) */
+  fe_sq(t2, t1);
+  for (i = 1; i < 20; ++i) {
+    fe_sq(t2, t2);
+  }
+  fe_mul(t1, t2, t1);
+
+  /* t0 = z ** (2 ** 50 - 1) */
+  for (i = 0; i < 10; ++i) {
+    fe_sq(t1, t1);
+  }
+  fe_mul(t0, t1, t0);
+
+  /* t1 = z ** (2 ** 100 - 1) */
+  fe_sq(t1, t0);
+  for (i = 1; i < 50; ++i) {
+    fe_sq(t1, t1);
+  }
+  fe_mul(t1, t1, t0);
+
+  /* t1 = z ** (2 ** 200 - 1) */
+  fe_sq(t2, t1);
+  for (i = 1; i < 100; ++i) {
+    fe_sq(t2, t2);
+  }
+  fe_mul(t1, t2, t1);
+
+  /* t0 = z ** (2 ** 250 - 1) */
+  for (i = 0; i < 50; ++i) {
+    fe_sq(t1, t1);
+  }
+  fe_mul(t0, t1, t0);
+
+  /* out = z ** ((2 ** 2) * (2 ** 250 - 1) + 1) */
+  fe_sq(t0, t0);
+  fe_sq(t0, t0);
+  fe_mul(out, t0, z);
+}
+
 /* ge means group element.
 
  * Here the group is the set of pairs (x,y) of field elements (see fe.h)
@@ -1016,6 +1116,143 @@ static void ge_madd(ge_p1p1 *r, const ge_p3 *p, const ge_precomp *q) {
   fe_sub(r->T, t0, r->T);
 }
 
+/* r = p - q */
+static void ge_msub(ge_p1p1 *r, const ge_p3 *p, const ge_precomp *q) {
+  fe t0;
+
+  fe_add(r->X, p->Y, p->X);
+  fe_sub(r->Y, p->Y, p->X);
+  fe_mul(r->Z, r->X, q->yminusx);
+  fe_mul(r->Y, r->Y, q->yplusx);
+  fe_mul(r->T, q->xy2d, p->T);
+  fe_add(t0, p->Z, p->Z);
+  fe_sub(r->X, r->Z, r->Y);
+  fe_add(r->Y, r->Z, r->Y);
+  fe_sub(r->Z, t0, r->T);
+  fe_add(r->T, t0, r->T);
+}
+
+/* r = p */
+static void ge_p3_to_cached(ge_cached *r, const ge_p3 *p) {
+  static const fe d2 = {-21827239, -5839606, -30745221, 13898782, 229458,
+                        15978800, -12551817, -6495438, 29715968, 9444199};
+
+  fe_add(r->YplusX, p->Y, p->X);
+  fe_sub(r->YminusX, p->Y, p->X);
+  fe_copy(r->Z, p->Z);
+  fe_mul(r->T2d, p->T, d2);
+}
+
+/* r = p + q */
+static void ge_add(ge_p1p1 *r, const ge_p3 *p, const ge_cached *q) {
+  fe t0;
+
+  fe_add(r->X, p->Y, p->X);
+  fe_sub(r->Y, p->Y, p->X);
+  fe_mul(r->Z, r->X, q->YplusX);
+  fe_mul(r->Y, r->Y, q->YminusX);
+  fe_mul(r->T, q->T2d, p->T);
+  fe_mul(r->X, p->Z, q->Z);
+  fe_add(t0, r->X, r->X);
+  fe_sub(r->X, r->Z, r->Y);
+  fe_add(r->Y, r->Z, r->Y);
+  fe_add(r->Z, t0, r->T);
+  fe_sub(r->T, t0, r->T);
+}
+
+/* r = p - q */
+static void ge_sub(ge_p1p1 *r, const ge_p3 *p, const ge_cached *q) {
+  fe t0;
+
+  fe_add(r->X, p->Y, p->X);
+  fe_sub(r->Y, p->Y, p->X);
+  fe_mul(r->Z, r->X, q->YminusX);
+  fe_mul(r->Y, r->Y, q->YplusX);
+  fe_mul(r->T, q->T2d, p->T);
+  fe_mul(r->X, p->Z, q->Z);
+  fe_add(t0, r->X, r->X);
+  fe_sub(r->X, r->Z, r->Y);
+  fe_add(r->Y, r->Z, r->Y);
+  fe_sub(r->Z, t0, r->T);
+  fe_add(r->T, t0, r->T);
+}
+
+/* r = p + q, in place on r */
+static void ge_p3_add(ge_p3 *r, const ge_p3 *q) {
+  ge_cached c;
+  ge_p1p1 t;
+
+  ge_p3_to_cached(&c, q);
+  ge_add(&t, r, &c);
+  ge_p1p1_to_p3(r, &t);
+}
+
+static void ge_tobytes(uint8_t *s, const ge_p2 *h) {
+  fe recip;
+  fe x;
+  fe y;
+
+  fe_invert(recip, h->Z);
+  fe_mul(x, h->X, recip);
+  fe_mul(y, h->Y, recip);
+  fe_tobytes(s, y);
+  s[31] ^= fe_isnegative(x) << 7;
+}
+
+static void ge_p3_tobytes(uint8_t *s, const ge_p3 *h) {
+  ge_p2 p;
+
+  ge_p3_to_p2(&p, h);
+  ge_tobytes(s, &p);
+}
+
+/* Decodes the point encoded in s and returns 0, or returns -1 if s does not
+ * encode a point on the curve. Runs in variable time. */
+static int ge_frombytes_vartime(ge_p3 *h, const uint8_t *s) {
+  static const fe d = {-10913610, 13857413, -15372611, 6949391, 114729,
+                       -8787816, -6275908, -3247719, -18696448, -12055116};
+  static const fe sqrtm1 = {-32595792, -7943725, 9377950, 3500415, 12389472,
+                            -272473, -25146209, -2005654, 326686, 11406482};
+  fe u;
+  fe v;
+  fe v3;
+  fe vxx;
+  fe check;
+
+  fe_frombytes(h->Y, s);
+  fe_1(h->Z);
+  fe_sq(u, h->Y);
+  fe_mul(v, u, d);
+  fe_sub(u, u, h->Z); /* u = y^2-1 */
+  fe_add(v, v, h->Z); /* v = dy^2+1 */
+
+  fe_sq(v3, v);
+  fe_mul(v3, v3, v); /* v3 = v^3 */
+  fe_sq(h->X, v3);
+  fe_mul(h->X, h->X, v);
+  fe_mul(h->X, h->X, u); /* x = uv^7 */
+
+  fe_pow22523(h->X, h->X); /* x = (uv^7)^((q-5)/8) */
+  fe_mul(h->X, h->X, v3);
+  fe_mul(h->X, h->X, u); /* x = uv^3(uv^7)^((q-5)/8) */
+
+  fe_sq(vxx, h->X);
+  fe_mul(vxx, vxx, v);
+  fe_sub(check, vxx, u); /* vx^2-u */
+  if (fe_isnonzero(check)) {
+    fe_add(check, vxx, u); /* vx^2+u */
+    if (fe_isnonzero(check))
+      return -1;
+    fe_mul(h->X, h->X, sqrtm1);
+  }
+
+  if (fe_isnegative(h->X) != (s[31] >> 7))
+    fe_neg(h->X, h->X);
+
+  fe_mul(h->T, h->X, h->Y);
+  return 0;
+}
+
 static uint8_t equal(signed char b, signed char c) {
   uint8_t ub = b;
   uint8_t uc = c;
@@ -3228,6 +3465,441 @@ static void ge_scalarmult_base(ge_p3 *h, const uint8_t *a) {
   }
 }
 
+/* The scalar functions work modulo the group order
+ * l = 2^252 + 27742317777372353535851937790883648493, on little-endian
+ * byte strings that are split into 21-bit signed limbs for the arithmetic.
+ * Since 2^252 = -27742317777372353535851937790883648493 mod l, a limb at
+ * position 12 or above is folded down using the limbs of that value in
+ * kL252. */
+static const int64_t kL252[6] = {
+  666643, 470296, 654183, -997805, 136657, -683901
+};
+
+/* Splits |len| bytes at |in| into |n| 21-bit limbs; the top limb takes
+ * whatever bits are left over. */
+static void sc_load(int64_t *s, size_t n, const uint8_t *in, size_t len) {
+  uint64_t acc = 0;
+  unsigned bits = 0;
+  size_t i, j = 0;
+
+  for (i = 0; i < n - 1; i++) {
+    while (bits < 21) {
+      acc |= (uint64_t)in[j++] << bits;
+      bits += 8;
+    }
+    s[i] = acc & 0x1fffff;
+    acc >>= 21;
+    bits -= 21;
+  }
+  while (j < len) {
+    acc |= (uint64_t)in[j++] << bits;
+    bits += 8;
+  }
+  s[n - 1] = acc;
+}
+
+/* Propagates the carries from limb |from| up to limb |to|, rounding each
+ * limb to [-2^20, 2^20) if |round| is set and to [0, 2^21) otherwise. */
+static void sc_carry(int64_t *s, int from, int to, int round) {
+  int64_t carry;
+  int i;
+
+  for (i = from; i < to; i++) {
+    if (round)
+      carry = (s[i] + (1 << 20)) >> 21;
+    else
+      carry = s[i] >> 21;
+    s[i + 1] += carry;
+    s[i] -= carry * ((int64_t)1 << 21);
+  }
+}
+
+/* Folds limbs |top| down to |bottom| into the limbs below them. */
+static void sc_fold(int64_t *s, int top, int bottom) {
+  int i, k;
+
+  for (k = top; k >= bottom; k--) {
+    for (i = 0; i < 6; i++)
+      s[k - 12 + i] += s[k] * kL252[i];
+    s[k] = 0;
+  }
+}
+
+/* Reduces the 24 limbs in s, each of them at most about 2^42 in magnitude,
+ * modulo l and writes the result to out. */
+static void sc_reduce_limbs(uint8_t *out, int64_t *s) {
+  uint64_t acc = 0;
+  unsigned bits = 0;
+  int i, j = 0;
+
+  sc_fold(s, 23, 18);
+  sc_carry(s, 6, 17, 1);
+  sc_fold(s, 17, 12);
+  sc_carry(s, 0, 12, 1);
+  sc_fold(s, 12, 12);
+  sc_carry(s, 0, 12, 0);
+  sc_fold(s, 12, 12);
+  sc_carry(s, 0, 11, 0);
+
+  for (i = 0; i < 12; i++) {
+    acc |= (uint64_t)s[i] << bits;
+    bits += 21;
+    while (bits >= 8 && j < 32) {
+      out[j++] = (uint8_t)acc;
+      acc >>= 8;
+      bits -= 8;
+    }
+  }
+  while (j < 32) {
+    out[j++] = (uint8_t)acc;
+    acc >>= 8;
+  }
+}
+
+/* Input:
+ *   s[0]+256*s[1]+...+256^63*s[63] = s
+ *
+ * Output:
+ *   s[0]+256*s[1]+...+256^31*s[31] = s mod l
+ *   where l = 2^252 + 27742317777372353535851937790883648493.
+ *   Overwrites s in place. */
+static void x25519_sc_reduce(uint8_t *s) {
+  int64_t limbs[24];
+
+  sc_load(limbs, 24, s, 64);
+  sc_reduce_limbs(s, limbs);
+}
+
+/* Input:
+ *   a[0]+256*a[1]+...+256^31*a[31] = a
+ *   b[0]+256*b[1]+...+256^31*b[31] = b
+ *   c[0]+256*c[1]+...+256^31*c[31] = c
+ *
+ * Output:
+ *   s[0]+256*s[1]+...+256^31*s[31] = (ab+c) mod l
+ *   where l = 2^252 + 27742317777372353535851937790883648493. */
+static void sc_muladd(uint8_t *s, const uint8_t *a, const uint8_t *b,
+                      const uint8_t *c) {
+  int64_t al[12], bl[12], cl[12];
+  int64_t limbs[24];
+  int i, j;
+
+  sc_load(al, 12, a, 32);
+  sc_load(bl, 12, b, 32);
+  sc_load(cl, 12, c, 32);
+
+  for (i = 0; i < 24; i++)
+    limbs[i] = i < 12 ? cl[i] : 0;
+  for (i = 0; i < 12; i++)
+    for (j = 0; j < 12; j++)
+      limbs[i + j] += al[i] * bl[j];
+
+  sc_carry(limbs, 0, 23, 1);
+  sc_reduce_limbs(s, limbs);
+}
+
+/* Returns 1 if the little-endian scalar s is less than l. */
+static int sc_is_canonical(const uint8_t *s) {
+  static const uint8_t kOrder[32] = {
+    0xed, 0xd3, 0xf5, 0x5c, 0x1a, 0x63, 0x12, 0x58, 0xd6, 0x9c, 0xf7,
+    0xa2, 0xde, 0xf9, 0xde, 0x14, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x10
+  };
+  int i;
+
+  for (i = 31; i >= 0; i--) {
+    if (s[i] != kOrder[i])
+      return s[i] < kOrder[i];
+  }
+  return 0;
+}
+
+/* Recodes the scalar a into signed digits r[0..255], of which the nonzero
+ * ones are odd, at most |max| in magnitude and at least as many positions
+ * apart as the window is wide. */
+static void slide(signed char *r, const uint8_t *a, int max) {
+  int i;
+  int b;
+  int k;
+
+  for (i = 0; i < 256; ++i) {
+    r[i] = 1 & (a[i >> 3] >> (i & 7));
+  }
+
+  for (i = 0; i < 256; ++i) {
+    if (r[i]) {
+      for (b = 1; b <= 6 && i + b < 256; ++b) {
+        if (r[i + b]) {
+          if (r[i] + (r[i + b] << b) <= max) {
+            r[i] += r[i + b] << b;
+            r[i + b] = 0;
+          } else if (r[i] - (r[i + b] << b) >= -max) {
+            r[i] -= r[i + b] << b;
+            for (k = i + b; k < 256; ++k) {
+              if (!r[k]) {
+                r[k] = 1;
+                break;
+              }
+              r[k] = 0;
+            }
+          } else {
+            break;
+          }
+        }
+      }
+    }
+  }
+}
+
+/* r = a * A + b * B
+ * where a = a[0]+256*a[1]+...+256^31 a[31].
+ * and b = b[0]+256*b[1]+...+256^31 b[31].
+ * B is the Ed25519 base point (x,4/5) with x positive.
+ *
+ * The odd multiples of B up to 7B come straight from the first row of
+ * k25519Precomp; those of A up to 15A are computed here. Runs in variable
+ * time, so it must only be used with public inputs. */
+static void ge_double_scalarmult_vartime(ge_p2 *r, const uint8_t *a,
+                                         const ge_p3 *A, const uint8_t *b) {
+  signed char aslide[256];
+  signed char bslide[256];
+  ge_cached Ai[8]; /* A,3A,5A,7A,9A,11A,13A,15A */
+  ge_p1p1 t;
+  ge_p3 u;
+  ge_p3 A2;
+  int i;
+
+  slide(aslide, a, 15);
+  slide(bslide, b, 7);
+
+  ge_p3_to_cached(&Ai[0], A);
+  ge_p3_dbl(&t, A);
+  ge_p1p1_to_p3(&A2, &t);
+  for (i = 0; i < 7; i++) {
+    ge_add(&t, &A2, &Ai[i]);
+    ge_p1p1_to_p3(&u, &t);
+    ge_p3_to_cached(&Ai[i + 1], &u);
+  }
+
+  fe_0(r->X);
+  fe_1(r->Y);
+  fe_1(r->Z);
+
+  for (i = 255; i >= 0; --i) {
+    if (aslide[i] || bslide[i]) {
+      break;
+    }
+  }
+
+  for (; i >= 0; --i) {
+    ge_p2_dbl(&t, r);
+
+    if (aslide[i] > 0) {
+      ge_p1p1_to_p3(&u, &t);
+      ge_add(&t, &u, &Ai[aslide[i] / 2]);
+    } else if (aslide[i] < 0) {
+      ge_p1p1_to_p3(&u, &t);
+      ge_sub(&t, &u, &Ai[(-aslide[i]) / 2]);
+    }
+
+    if (bslide[i] > 0) {
+      ge_p1p1_to_p3(&u, &t);
+      ge_madd(&t, &u, &k25519Precomp[0][bslide[i] - 1]);
+    } else if (bslide[i] < 0) {
+      ge_p1p1_to_p3(&u, &t);
+      ge_msub(&t, &u, &k25519Precomp[0][-bslide[i] - 1]);
+    }
+
+    ge_p1p1_to_p2(r, &t);
+  }
+}
+
+/* Returns the |w| bits of the scalar s starting at bit |pos|. */
+static unsigned sc_window(const uint8_t *s, unsigned pos, unsigned w) {
+  unsigned i = pos >> 3;
+  uint32_t v = s[i];
+
+  if (i + 1 < 32)
+    v |= (uint32_t)s[i + 1] << 8;
+  if (i + 2 < 32)
+    v |= (uint32_t)s[i + 2] << 16;
+  return (v >> (pos & 7)) & ((1U << w) - 1);
+}
+
+/* r = scalars[0] * points[0] + ... + scalars[num-1] * points[num-1]
+ *
+ * This is Straus' method: the scalars are recoded like in
+ * ge_double_scalarmult_vartime and all points share the doublings. It
+ * costs about 256 doublings plus num * 50 additions. Runs in variable time.
+ * Returns 0 if memory could not be allocated. */
+static int ge_straus_vartime(ge_p3 *r, const uint8_t (*scalars)[32],
+                             const ge_p3 *points, size_t num) {
+  signed char *slides;
+  ge_cached *Ai;
+  ge_p1p1 t;
+  ge_p3 u;
+  ge_p2 s;
+  size_t j;
+  int i, k;
+
+  if (num > OPENSSL_MALLOC_MAX_NELEMS(ge_cached) / 8)
+    return 0;
+  slides = OPENSSL_malloc(num * 256);
+  Ai = OPENSSL_malloc(num * 8 * sizeof(*Ai));
+  if (slides == NULL || Ai == NULL) {
+    OPENSSL_free(slides);
+    OPENSSL_free(Ai);
+    return 0;
+  }
+
+  for (j = 0; j < num; j++) {
+    slide(slides + 256 * j, scalars[j], 15);
+    ge_p3_to_cached(&Ai[8 * j], &points[j]);
+    ge_p3_dbl(&t, &points[j]);
+    ge_p1p1_to_p3(&u, &t);
+    for (k = 0; k < 7; k++) {
+      ge_add(&t, &u, &Ai[8 * j + k]);
+      ge_p1p1_to_p3(r, &t);
+      ge_p3_to_cached(&Ai[8 * j + k + 1], r);
+    }
+  }
+
+  ge_p3_0(r);
+  for (i = 255; i >= 0; --i) {
+    for (j = 0; j < num; j++) {
+      if (slides[256 * j + i])
+        break;
+    }
+    if (j < num)
+      break;
+  }
+
+  for (; i >= 0; --i) {
+    ge_p3_to_p2(&s, r);
+    ge_p2_dbl(&t, &s);
+    ge_p1p1_to_p3(r, &t);
+
+    for (j = 0; j < num; j++) {
+      int d = slides[256 * j + i];
+
+      if (d > 0) {
+        ge_add(&t, r, &Ai[8 * j + d / 2]);
+        ge_p1p1_to_p3(r, &t);
+      } else if (d < 0) {
+        ge_sub(&t, r, &Ai[8 * j + (-d) / 2]);
+        ge_p1p1_to_p3(r, &t);
+      }
+    }
+  }
+
+  OPENSSL_free(slides);
+  OPENSSL_free(Ai);
+  return 1;
+}
+
+/* r = scalars[0] * points[0] + ... + scalars[num-1] * points[num-1]
+ *
+ * This is Pippenger's bucket method: the scalars are cut into w-bit
+ * windows, and for each window every point is added into the bucket
+ * selected by its digit, after which the buckets are summed with their
+ * weights using a running sum. This costs about 253/w * (num + 2^(w+1))
+ * additions, so w grows with num. All scalars must be less than l. Runs
+ * in variable time. Returns 0 if memory could not be allocated. */
+static int ge_pippenger_vartime(ge_p3 *r, const uint8_t (*scalars)[32],
+                                const ge_p3 *points, size_t num) {
+  ge_cached *cached;
+  ge_p3 *buckets;
+  ge_p3 sum;
+  ge_cached c;
+  ge_p1p1 t;
+  ge_p2 s;
+  unsigned char *used;
+  size_t i, nbuckets;
+  unsigned w, win, bits = 253;
+  int j, k, top;
+
+  for (w = 1; w < 16; w++) {
+    size_t cost = (bits + w - 1) / w * (num + ((size_t)2 << w));
+    size_t next = (bits + w) / (w + 1) * (num + ((size_t)4 << w));
+    if (next >= cost)
+      break;
+  }
+  if (num > OPENSSL_MALLOC_MAX_NELEMS(ge_cached))
+    return 0;
+  nbuckets = ((size_t)1 << w) - 1;
+  buckets = OPENSSL_malloc(nbuckets * sizeof(*buckets));
+  used = OPENSSL_malloc(nbuckets);
+  cached = OPENSSL_malloc(num * sizeof(*cached));
+  if (buckets == NULL || used == NULL || cached == NULL) {
+    OPENSSL_free(buckets);
+    OPENSSL_free(used);
+    OPENSSL_free(cached);
+    return 0;
+  }
+  for (i = 0; i < num; i++)
+    ge_p3_to_cached(&cached[i], &points[i]);
+
+  ge_p3_0(r);
+  for (win = (bits + w - 1) / w; win-- > 0;) {
+    if (win != (bits + w - 1) / w - 1) {
+      ge_p3_to_p2(&s, r);
+      for (k = 0; k < (int)w - 1; k++) {
+        ge_p2_dbl(&t, &s);
+        ge_p1p1_to_p2(&s, &t);
+      }
+      ge_p2_dbl(&t, &s);
+      ge_p1p1_to_p3(r, &t);
+    }
+
+    memset(used, 0, nbuckets);
+    top = -1;
+    for (i = 0; i < num; i++) {
+      unsigned digit = sc_window(scalars[i], win * w, w);
+
+      if (digit == 0)
+        continue;
+      if (used[digit - 1]) {
+        ge_add(&t, &buckets[digit - 1], &cached[i]);
+        ge_p1p1_to_p3(&buckets[digit - 1], &t);
+      } else {
+        ge_p3_0(&buckets[digit - 1]);
+        ge_add(&t, &buckets[digit - 1], &cached[i]);
+        ge_p1p1_to_p3(&buckets[digit - 1], &t);
+        used[digit - 1] = 1;
+        if ((int)digit - 1 > top)
+          top = digit - 1;
+      }
+    }
+
+    /* r += sum over j of (j+1) * buckets[j] */
+    if (top < 0)
+      continue;
+    sum = buckets[top];
+    for (j = top; j >= 0; j--) {
+      if (j != top && used[j])
+        ge_p3_add(&sum, &buckets[j]);
+      ge_p3_to_cached(&c, &sum);
+      ge_add(&t, r, &c);
+      ge_p1p1_to_p3(r, &t);
+    }
+  }
+
+  OPENSSL_free(buckets);
+  OPENSSL_free(used);
+  OPENSSL_free(cached);
+  return 1;
+}
+
+/* Below about this many points Straus' method is faster than Pippenger's */
+#define GE_PIPPENGER_MIN 512
+
+static int ge_multi_scalarmult_vartime(ge_p3 *r, const uint8_t (*scalars)[32],
+                                       const ge_p3 *points, size_t num) {
+  if (num < GE_PIPPENGER_MIN)
+    return ge_straus_vartime(r, scalars, points, num);
+  return ge_pippenger_vartime(r, scalars, points, num);
+}
+
 /* Replace (f,g) with (g,f) if b == 1;
  * replace (f,g) with (f,g) if b == 0.
  *
@@ -3392,3 +4064,248 @@ void X25519_public_from_private(uint8_t out_public_value[32],
   fe_mul(zplusy, zplusy, zminusy_inv);
   fe_tobytes(out_public_value, zplusy);
 }
+
+void ED25519_public_from_private(uint8_t out_public_key[32],
+                                 const uint8_t private_key[32]) {
+  uint8_t az[SHA512_DIGEST_LENGTH];
+  ge_p3 A;
+
+  SHA512(private_key, 32, az);
+
+  az[0] &= 248;
+  az[31] &= 63;
+  az[31] |= 64;
+
+  ge_scalarmult_base(&A, az);
+  ge_p3_tobytes(out_public_key, &A);
+
+  OPENSSL_cleanse(az, sizeof(az));
+}
+
+int ED25519_sign(uint8_t *out_sig, const uint8_t *message, size_t message_len,
+                 const uint8_t public_key[32], const uint8_t private_key[32]) {
+  uint8_t az[SHA512_DIGEST_LENGTH];
+  uint8_t nonce[SHA512_DIGEST_LENGTH];
+  uint8_t hram[SHA512_DIGEST_LENGTH];
+  ge_p3 R;
+  SHA512_CTX hash_ctx;
+
+  SHA512(private_key, 32, az);
+
+  az[0] &= 248;
+  az[31] &= 63;
+  az[31] |= 64;
+
+  SHA512_Init(&hash_ctx);
+  SHA512_Update(&hash_ctx, az + 32, 32);
+  SHA512_Update(&hash_ctx, message, message_len);
+  SHA512_Final(nonce, &hash_ctx);
+
+  x25519_sc_reduce(nonce);
+  ge_scalarmult_base(&R, nonce);
+  ge_p3_tobytes(out_sig, &R);
+
+  SHA512_Init(&hash_ctx);
+  SHA512_Update(&hash_ctx, out_sig, 32);
+  SHA512_Update(&hash_ctx, public_key, 32);
+  SHA512_Update(&hash_ctx, message, message_len);
+  SHA512_Final(hram, &hash_ctx);
+
+  x25519_sc_reduce(hram);
+  sc_muladd(out_sig + 32, hram, az, nonce);
+
+  OPENSSL_cleanse(&hash_ctx, sizeof(hash_ctx));
+  OPENSSL_cleanse(nonce, sizeof(nonce));
+  OPENSSL_cleanse(az, sizeof(az));
+
+  return 1;
+}
+
+/* Computes h = SHA512(R || A || M) mod l for the verification equation. */
+static void ed25519_hram(uint8_t h[SHA512_DIGEST_LENGTH],
+                         const uint8_t *message, size_t message_len,
+                         const uint8_t signature[64],
+                         const uint8_t public_key[32]) {
+  SHA512_CTX hash_ctx;
+
+  SHA512_Init(&hash_ctx);
+  SHA512_Update(&hash_ctx, signature, 32);
+  SHA512_Update(&hash_ctx, public_key, 32);
+  SHA512_Update(&hash_ctx, message, message_len);
+  SHA512_Final(h, &hash_ctx);
+
+  x25519_sc_reduce(h);
+}
+
+/* Sets r = 8 * p. */
+static void ge_p2_mul_cofactor(ge_p2 *r, const ge_p2 *p) {
+  ge_p1p1 t;
+
+  ge_p2_dbl(&t, p);
+  ge_p1p1_to_p2(r, &t);
+  ge_p2_dbl(&t, r);
+  ge_p1p1_to_p2(r, &t);
+  ge_p2_dbl(&t, r);
+  ge_p1p1_to_p2(r, &t);
+}
+
+/* Returns 1 if p and q are the same point, 0 otherwise. */
+static int ge_p2_equal(const ge_p2 *p, const ge_p2 *q) {
+  fe a, b;
+
+  fe_mul(a, p->X, q->Z);
+  fe_mul(b, q->X, p->Z);
+  fe_sub(a, a, b);
+  if (fe_isnonzero(a))
+    return 0;
+  fe_mul(a, p->Y, q->Z);
+  fe_mul(b, q->Y, p->Z);
+  fe_sub(a, a, b);
+  return !fe_isnonzero(a);
+}
+
+/*
+ * Like ED25519_verify_batch(), this accepts a signature when
+ * 8*(S*B - h*A) == 8*R, so that components of small order in R or A do
+ * not make the two disagree. The common case where S*B - h*A encodes to
+ * R exactly needs no more than the usual check.
+ */
+int ED25519_verify(const uint8_t *message, size_t message_len,
+                   const uint8_t signature[64], const uint8_t public_key[32]) {
+  ge_p3 A, Rsig;
+  ge_p2 R, R8;
+  uint8_t h[SHA512_DIGEST_LENGTH];
+  uint8_t rcheck[32];
+
+  if (!sc_is_canonical(signature + 32)
+      || ge_frombytes_vartime(&A, public_key) != 0)
+    return 0;
+
+  fe_neg(A.X, A.X);
+  fe_neg(A.T, A.T);
+
+  ed25519_hram(h, message, message_len, signature, public_key);
+
+  /* R = S*B - h*A */
+  ge_double_scalarmult_vartime(&R, h, &A, signature + 32);
+  ge_tobytes(rcheck, &R);
+  if (CRYPTO_memcmp(rcheck, signature, sizeof(rcheck)) == 0)
+    return 1;
+
+  if (ge_frombytes_vartime(&Rsig, signature) != 0)
+    return 0;
+  ge_p3_to_p2(&R8, &Rsig);
+  ge_p2_mul_cofactor(&R8, &R8);
+  ge_p2_mul_cofactor(&R, &R);
+  return ge_p2_equal(&R, &R8);
+}
+
+/* Batches smaller than this are verified one signature at a time */
+#define ED25519_BATCH_MIN 4
+
+/* Length in bytes of the random coefficients of the batch equation */
+#define ED25519_BATCH_ZLEN 16
+
+/*
+ * The batch is checked with a single multi-scalar multiplication:
+ * with random z_i the sum over i of z_i * (S_i*B - R_i - h_i*A_i) is zero,
+ * up to the small-order components removed by multiplying with the
+ * cofactor 8, when each of the signatures is valid. A forgery passes with
+ * probability at most 2^-128 as the z_i are unknown to the signer.
+ */
+int ED25519_verify_batch(const unsigned char *const *messages,
+                         const size_t *message_lens,
+                         const unsigned char *const *signatures,
+                         const unsigned char *const *public_keys,
+                         size_t num) {
+  static const uint8_t zero[32] = {0};
+  ge_p3 *points = NULL;
+  uint8_t (*scalars)[32] = NULL;
+  uint8_t *z = NULL;
+  uint8_t h[SHA512_DIGEST_LENGTH];
+  uint8_t zi[32];
+  uint8_t ssum[32];
+  ge_p3 Q, S;
+  ge_p1p1 t;
+  ge_p2 p;
+  size_t i;
+  int ret = -1;
+
+  if (num < ED25519_BATCH_MIN) {
+    for (i = 0; i < num; i++) {
+      if (!ED25519_verify(messages[i], message_lens[i], signatures[i],
+                          public_keys[i]))
+        return 0;
+    }
+    return 1;
+  }
+
+  if (num > OPENSSL_MALLOC_MAX_NELEMS(ge_p3) / 2
+      || num > OPENSSL_MALLOC_MAX_NELEMS(uint8_t) / ED25519_BATCH_ZLEN) {
+    ECerr(EC_F_ED25519_VERIFY_BATCH, ERR_R_MALLOC_FAILURE);
+    return -1;
+  }
+
+  points = OPENSSL_malloc(2 * num * sizeof(*points));
+  scalars = OPENSSL_malloc(2 * num * sizeof(*scalars));
+  z = OPENSSL_malloc(num * ED25519_BATCH_ZLEN);
+  if (points == NULL || scalars == NULL || z == NULL) {
+    ECerr(EC_F_ED25519_VERIFY_BATCH, ERR_R_MALLOC_FAILURE);
+    goto err;
+  }
+  if (RAND_bytes(z, num * ED25519_BATCH_ZLEN) <= 0)
+    goto err;
+
+  memset(ssum, 0, sizeof(ssum));
+  memset(zi, 0, sizeof(zi));
+  ret = 0;
+  for (i = 0; i < num; i++) {
+    if (!sc_is_canonical(signatures[i] + 32))
+      goto err;
+
+    /* -z_i * R_i */
+    if (ge_frombytes_vartime(&points[2 * i], signatures[i]) != 0)
+      goto err;
+    fe_neg(points[2 * i].X, points[2 * i].X);
+    fe_neg(points[2 * i].T, points[2 * i].T);
+    memcpy(zi, z + i * ED25519_BATCH_ZLEN, ED25519_BATCH_ZLEN);
+    memcpy(scalars[2 * i], zi, 32);
+
+    /* -z_i * h_i * A_i */
+    if (ge_frombytes_vartime(&points[2 * i + 1], public_keys[i]) != 0)
+      goto err;
+    fe_neg(points[2 * i + 1].X, points[2 * i + 1].X);
+    fe_neg(points[2 * i + 1].T, points[2 * i + 1].T);
+    ed25519_hram(h, messages[i], message_lens[i], signatures[i],
+                 public_keys[i]);
+    sc_muladd(scalars[2 * i + 1], zi, h, zero);
+
+    /* sum of z_i * S_i */
+    sc_muladd(ssum, zi, signatures[i] + 32, ssum);
+  }
+
+  ret = -1;
+  if (!ge_multi_scalarmult_vartime(&Q, (const uint8_t (*)[32])scalars,
+                                   points, 2 * num)) {
+    ECerr(EC_F_ED25519_VERIFY_BATCH, ERR_R_MALLOC_FAILURE);
+    goto err;
+  }
+  ge_scalarmult_base(&S, ssum);
+  ge_p3_add(&Q, &S);
+
+  /* Clear the cofactor and check for the neutral element (0, 1) */
+  ge_p3_dbl(&t, &Q);
+  ge_p1p1_to_p2(&p, &t);
+  ge_p2_dbl(&t, &p);
+  ge_p1p1_to_p2(&p, &t);
+  ge_p2_dbl(&t, &p);
+  ge_p1p1_to_p2(&p, &t);
+  fe_sub(p.Y, p.Y, p.Z);
+  ret = !fe_isnonzero(p.X) && !fe_isnonzero(p.Y);
+
+ err:
+  OPENSSL_free(points);
+  OPENSSL_free(scalars);
+  OPENSSL_free(z);
+  return ret;
+}
@@ -14,6 +14,8 @@
 
 /* Length of Curve 25519 keys */
 #define EC_X25519_KEYLEN    32
+/* Length of Ed25519 signatures */
+#define EC_ED25519_SIGLEN   64
 /* Group degree and order bits */
 #define EC_X25519_BITS      253
 
@@ -76,7 +78,12 @@ static int x25519_set_private(EC_KEY *eckey, const BIGNUM *priv_key)
     return 1;
 }
 
-static int x25519_keycheck(const EC_KEY *eckey)
+/*
+ * Check the key, deriving the public key from the private one with
+ * |pub_from_priv| which differs between X25519 and Ed25519
+ */
+static int ec_25519_keycheck(const EC_KEY *eckey,
+                             void (*pub_from_priv)(uint8_t *, const uint8_t *))
 {
     const char *pubkey;
     if (eckey->pub_key == NULL)
@@ -96,7 +103,7 @@ static int x25519_keycheck(const EC_KEY *eckey)
             OPENSSL_cleanse(tmp, EC_X25519_KEYLEN);
             return 0;
         }
-        X25519_public_from_private(tmp, eckey->custom_data);
+        pub_from_priv(tmp, eckey->custom_data);
         if (CRYPTO_memcmp(pubkey, tmp, EC_X25519_KEYLEN) == 0)
             return 1;
         return 0;
@@ -105,6 +112,11 @@ static int x25519_keycheck(const EC_KEY *eckey)
     }
 }
 
+static int x25519_keycheck(const EC_KEY *eckey)
+{
+    return ec_25519_keycheck(eckey, X25519_public_from_private);
+}
+
 static int x25519_keygenpub(EC_KEY *eckey)
 {
     X25519_public_from_private(eckey->pub_key->custom_data,
@@ -112,7 +124,11 @@ static int x25519_keygenpub(EC_KEY *eckey)
     return 1;
 }
 
-static int x25519_keygen(EC_KEY *eckey)
+/*
+ * Generate a random private key, clamped for X25519 if |clamp| is set, and
+ * the matching public key
+ */
+static int ec_25519_keygen(EC_KEY *eckey, int clamp)
 {
     unsigned char *key;
     if (x25519_init_private(eckey, NULL) == 0)
@@ -120,9 +136,11 @@ static int x25519_keygen(EC_KEY *eckey)
     key = eckey->custom_data;
     if (RAND_bytes(key, EC_X25519_KEYLEN) <= 0)
         return 0;
-    key[0] &= 248;
-    key[31] &= 127;
-    key[31] |= 64;
+    if (clamp) {
+        key[0] &= 248;
+        key[31] &= 127;
+        key[31] |= 64;
+    }
     /*
      * Although the private key is kept as an array in eckey->custom_data
      * Set eckey->priv_key too so existing code which uses
@@ -139,7 +157,12 @@ static int x25519_keygen(EC_KEY *eckey)
         eckey->pub_key = EC_POINT_new(eckey->group);
     if (eckey->pub_key == NULL)
         return 0;
-    return x25519_keygenpub(eckey);
+    return eckey->group->meth->keygenpub(eckey);
+}
+
+static int x25519_keygen(EC_KEY *eckey)
+{
+    return ec_25519_keygen(eckey, 1);
 }
 
 static void x25519_keyfinish(EC_KEY *eckey)
@@ -326,3 +349,131 @@ const EC_METHOD *ec_x25519_meth(void)
 
     return &ret;
 }
+
+/*
+ * Ed25519 keys are held like X25519 ones: the 32 byte private key (the seed
+ * which is hashed to derive the secret scalar) in eckey->custom_data and the
+ * 32 byte encoded public key in the custom_data of the public key point.
+ */
+
+static int ed25519_keycheck(const EC_KEY *eckey)
+{
+    return ec_25519_keycheck(eckey, ED25519_public_from_private);
+}
+
+static int ed25519_keygenpub(EC_KEY *eckey)
+{
+    ED25519_public_from_private(eckey->pub_key->custom_data,
+                                eckey->custom_data);
+    return 1;
+}
+
+static int ed25519_keygen(EC_KEY *eckey)
+{
+    return ec_25519_keygen(eckey, 0);
+}
+
+static int ed25519_oct2point(const EC_GROUP *grp, EC_POINT *pt,
+                             const unsigned char *buf, size_t len,
+                             BN_CTX *ctx)
+{
+    /* Unlike for X25519 the MSB holds the sign of x and is kept */
+    if (len != EC_X25519_KEYLEN)
+        return 0;
+    memcpy(pt->custom_data, buf, EC_X25519_KEYLEN);
+    return 1;
+}
+
+static int ed25519_sign_message(unsigned char *sig, size_t *siglen,
+                                const unsigned char *tbs, size_t tbslen,
+                                const EC_KEY *eckey)
+{
+    uint8_t pub[EC_X25519_KEYLEN];
+
+    if (sig == NULL) {
+        *siglen = EC_ED25519_SIGLEN;
+        return 1;
+    }
+    if (*siglen < EC_ED25519_SIGLEN || eckey->custom_data == NULL)
+        return 0;
+    /*
+     * The public key goes into the hash for the signature, and a stored one
+     * that does not match the private key would give away the secret scalar,
+     * so always derive it afresh.
+     */
+    ED25519_public_from_private(pub, eckey->custom_data);
+    if (ED25519_sign(sig, tbs, tbslen, pub, eckey->custom_data) == 0)
+        return 0;
+    *siglen = EC_ED25519_SIGLEN;
+    return 1;
+}
+
+static int ed25519_verify_message(const unsigned char *sig, size_t siglen,
+                                  const unsigned char *tbs, size_t tbslen,
+                                  const EC_KEY *eckey)
+{
+    if (siglen != EC_ED25519_SIGLEN || eckey->pub_key == NULL)
+        return 0;
+    return ED25519_verify(tbs, tbslen, sig, eckey->pub_key->custom_data);
+}
+
+const EC_METHOD *ec_ed25519_meth(void)
+{
+    static const EC_METHOD ret = {
+        EC_FLAGS_CUSTOM_CURVE | EC_FLAGS_NO_SIGN,
+        NID_undef,
+        x25519_group_init,      /* group_init */
+        0,                      /* group_finish */
+        0,                      /* group_clear_finish */
+        x25519_group_copy,      /* group_copy */
+        0,                      /* group_set_curve */
+        0,                      /* group_get_curve */
+        x25519_group_get_degree,
+        x25519_group_order_bits,
+        0,                      /* group_check_discriminant */
+        x25519_point_init,
+        x25519_point_finish,
+        x25519_point_clear_finish,
+        x25519_point_copy,
+        0,                      /* point_set_to_infinity */
+        0,                      /* set_Jprojective_coordinates_GFp */
+        0,                      /* get_Jprojective_coordinates_GFp */
+        0,                      /* point_set_affine_coordinates */
+        0,                      /* point_get_affine_coordinates */
+        0,                      /* point_set_compressed_coordinates */
+        x25519_point2oct,
+        ed25519_oct2point,
+        0,                      /* simple_add */
+        0,                      /* simple_dbl */
+        0,                      /* simple_invert */
+        0,                      /* simple_is_at_infinity */
+        0,                      /* simple_is_on_curve */
+        x25519_point_cmp,
+        0,                      /* simple_make_affine */
+        0,                      /* simple_points_make_affine */
+        0,                      /* points_mul */
+        0,                      /* precompute_mult */
+        0,                      /* have_precompute_mult */
+        0,                      /* field_mul */
+        0,                      /* field_sqr */
+        0,                      /* field_div */
+        0,                      /* field_encode */
+        0,                      /* field_decode */
+        0,                      /* field_set_to_one */
+        x25519_priv2oct,
+        x25519_oct2priv,
+        x25519_set_private,
+        ed25519_keygen,
+        ed25519_keycheck,
+        ed25519_keygenpub,
+        x25519_keycopy,
+        x25519_keyfinish,
+        0,                      /* ecdh_compute_key */
+        0,                      /* point_precompute_mult */
+        0,                      /* point_pre_comp_free */
+        ed25519_sign_message,
+        ed25519_verify_message
+    };
+
+    return &ret;
+}
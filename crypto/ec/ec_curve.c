@@ -2803,7 +2803,12 @@ static const ec_list_element curve_list[] = {
     {NID_secp256k1, &_EC_SECG_PRIME_256K1.h, 0,
      "SECG curve over a 256 bit prime field"},
     /* SECG secp256r1 is the same as X9.62 prime256v1 and hence omitted */
-    {NID_secp384r1, &_EC_NIST_PRIME_384.h, 0,
+    {NID_secp384r1, &_EC_NIST_PRIME_384.h,
+#if defined(ECP_NISTZ384_ASM)
+     EC_GFp_nistz384_method,
+#else
+     0,
+#endif
      "NIST/SECG curve over a 384 bit prime field"},
 #ifndef OPENSSL_NO_EC_NISTP_64_GCC_128
     {NID_secp521r1, &_EC_NIST_PRIME_521.h, EC_GFp_nistp521_method,
@@ -2974,6 +2979,7 @@ static const ec_list_element curve_list[] = {
     {NID_brainpoolP512t1, &_EC_brainpoolP512t1.h, 0,
      "RFC 5639 curve over a 512 bit prime field"},
     {NID_X25519, NULL, ec_x25519_meth, "X25519"},
+    {NID_ED25519, NULL, ec_ed25519_meth, "Ed25519"},
 };
 
 #define curve_list_length OSSL_NELEM(curve_list)
@@ -47,9 +47,16 @@ static ERR_STRING_DATA EC_str_functs[] = {
     {ERR_FUNC(EC_F_ECP_NISTZ256_GET_AFFINE), "ecp_nistz256_get_affine"},
     {ERR_FUNC(EC_F_ECP_NISTZ256_MULT_PRECOMPUTE),
      "ecp_nistz256_mult_precompute"},
+    {ERR_FUNC(EC_F_ECP_NISTZ256_PIPPENGER_MUL), "ecp_nistz256_pippenger_mul"},
+    {ERR_FUNC(EC_F_ECP_NISTZ256_POINT_PRECOMPUTE_MULT),
+     "ecp_nistz256_point_precompute_mult"},
     {ERR_FUNC(EC_F_ECP_NISTZ256_POINTS_MUL), "ecp_nistz256_points_mul"},
     {ERR_FUNC(EC_F_ECP_NISTZ256_PRE_COMP_NEW), "ecp_nistz256_pre_comp_new"},
     {ERR_FUNC(EC_F_ECP_NISTZ256_WINDOWED_MUL), "ecp_nistz256_windowed_mul"},
+    {ERR_FUNC(EC_F_ECP_NISTZ384_GET_AFFINE), "ecp_nistz384_get_affine"},
+    {ERR_FUNC(EC_F_ECP_NISTZ384_PIPPENGER_MUL), "ecp_nistz384_pippenger_mul"},
+    {ERR_FUNC(EC_F_ECP_NISTZ384_POINTS_MUL), "ecp_nistz384_points_mul"},
+    {ERR_FUNC(EC_F_ECP_NISTZ384_WINDOWED_MUL), "ecp_nistz384_windowed_mul"},
     {ERR_FUNC(EC_F_EC_ASN1_GROUP2CURVE), "ec_asn1_group2curve"},
     {ERR_FUNC(EC_F_EC_ASN1_GROUP2FIELDID), "ec_asn1_group2fieldid"},
     {ERR_FUNC(EC_F_EC_GF2M_MONTGOMERY_POINT_MULTIPLY),
@@ -146,6 +153,7 @@ static ERR_STRING_DATA EC_str_functs[] = {
     {ERR_FUNC(EC_F_EC_KEY_SIMPLE_CHECK_KEY), "ec_key_simple_check_key"},
     {ERR_FUNC(EC_F_EC_KEY_SIMPLE_OCT2PRIV), "ec_key_simple_oct2priv"},
     {ERR_FUNC(EC_F_EC_KEY_SIMPLE_PRIV2OCT), "ec_key_simple_priv2oct"},
+    {ERR_FUNC(EC_F_EC_PIPPENGER_MUL), "ec_pippenger_mul"},
     {ERR_FUNC(EC_F_EC_POINTS_MAKE_AFFINE), "EC_POINTs_make_affine"},
     {ERR_FUNC(EC_F_EC_POINT_ADD), "EC_POINT_add"},
     {ERR_FUNC(EC_F_EC_POINT_CMP), "EC_POINT_cmp"},
@@ -164,6 +172,7 @@ static ERR_STRING_DATA EC_str_functs[] = {
     {ERR_FUNC(EC_F_EC_POINT_NEW), "EC_POINT_new"},
     {ERR_FUNC(EC_F_EC_POINT_OCT2POINT), "EC_POINT_oct2point"},
     {ERR_FUNC(EC_F_EC_POINT_POINT2OCT), "EC_POINT_point2oct"},
+    {ERR_FUNC(EC_F_EC_POINT_PRECOMPUTE_MULT), "EC_POINT_precompute_mult"},
     {ERR_FUNC(EC_F_EC_POINT_SET_AFFINE_COORDINATES_GF2M),
      "EC_POINT_set_affine_coordinates_GF2m"},
     {ERR_FUNC(EC_F_EC_POINT_SET_AFFINE_COORDINATES_GFP),
@@ -178,6 +187,7 @@ static ERR_STRING_DATA EC_str_functs[] = {
     {ERR_FUNC(EC_F_EC_PRE_COMP_NEW), "ec_pre_comp_new"},
     {ERR_FUNC(EC_F_EC_WNAF_MUL), "ec_wNAF_mul"},
     {ERR_FUNC(EC_F_EC_WNAF_PRECOMPUTE_MULT), "ec_wNAF_precompute_mult"},
+    {ERR_FUNC(EC_F_ED25519_VERIFY_BATCH), "ED25519_verify_batch"},
     {ERR_FUNC(EC_F_I2D_ECPARAMETERS), "i2d_ECParameters"},
     {ERR_FUNC(EC_F_I2D_ECPKPARAMETERS), "i2d_ECPKParameters"},
     {ERR_FUNC(EC_F_I2D_ECPRIVATEKEY), "i2d_ECPrivateKey"},
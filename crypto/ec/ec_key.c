@@ -500,6 +500,13 @@ int EC_KEY_precompute_mult(EC_KEY *key, BN_CTX *ctx)
     return EC_GROUP_precompute_mult(key->group, ctx);
 }
 
+int EC_KEY_precompute_public_mult(EC_KEY *key, BN_CTX *ctx)
+{
+    if (key->group == NULL || key->pub_key == NULL)
+        return 0;
+    return EC_POINT_precompute_mult(key->group, key->pub_key, ctx);
+}
+
 int EC_KEY_get_flags(const EC_KEY *key)
 {
     return key->flags;
@@ -41,7 +41,7 @@
 /* Use custom formats for EC_GROUP, EC_POINT and EC_KEY */
 #define EC_FLAGS_CUSTOM_CURVE   0x2
 
-/* Curve does not support signing operations */
+/* Curve does not support ECDSA signing operations */
 #define EC_FLAGS_NO_SIGN        0x4
 
 /*
@@ -169,6 +169,20 @@ struct ec_method_st {
     /* custom ECDH operation */
     int (*ecdh_compute_key)(unsigned char **pout, size_t *poutlen,
                             const EC_POINT *pub_key, const EC_KEY *ecdh);
+    /* precomputed multiples of an arbitrary point */
+    int (*point_precompute_mult)(const EC_GROUP *group, EC_POINT *point,
+                                 BN_CTX *ctx);
+    void (*point_pre_comp_free)(EC_POINT *point);
+    /*
+     * custom signature operations on the message itself, used instead of
+     * ECDSA: sign_message sets *siglen to the signature length if sig is NULL
+     */
+    int (*sign_message)(unsigned char *sig, size_t *siglen,
+                        const unsigned char *tbs, size_t tbslen,
+                        const EC_KEY *eckey);
+    int (*verify_message)(const unsigned char *sig, size_t siglen,
+                          const unsigned char *tbs, size_t tbslen,
+                          const EC_KEY *eckey);
 } /* EC_METHOD */ ;
 
 /*
@@ -285,6 +299,11 @@ struct ec_point_st {
      * For example in X25519 this contains the public key in a 32 byte buffer.
      */
     void *custom_data;
+    /*
+     * Method specific table of multiples of the point, set up by
+     * EC_POINT_precompute_mult() and not carried over by EC_POINT_copy()
+     */
+    void *pre_comp;
 } /* EC_POINT */ ;
 
 NISTP224_PRE_COMP *EC_nistp224_pre_comp_dup(NISTP224_PRE_COMP *);
@@ -310,6 +329,12 @@ int ec_wNAF_mul(const EC_GROUP *group, EC_POINT *r, const BIGNUM *scalar,
                 BN_CTX *);
 int ec_wNAF_precompute_mult(EC_GROUP *group, BN_CTX *);
 int ec_wNAF_have_precompute_mult(const EC_GROUP *group);
+int ec_pippenger_mul(const EC_GROUP *group, EC_POINT *r, const BIGNUM *scalar,
+                     size_t num, const EC_POINT *points[],
+                     const BIGNUM *scalars[], BN_CTX *);
+size_t ec_pippenger_window_size(size_t num, size_t bits);
+void ec_pippenger_recode(int *digits, const unsigned char *scalar,
+                         size_t len, size_t w, size_t numwin);
 
 /* method functions in ecp_smpl.c */
 int ec_GFp_simple_group_init(EC_GROUP *);
@@ -550,6 +575,13 @@ int ec_group_simple_order_bits(const EC_GROUP *group);
  */
 const EC_METHOD *EC_GFp_nistz256_method(void);
 #endif
+#ifdef ECP_NISTZ384_ASM
+/** Returns GFp methods using montgomery multiplication, with constant time
+ * P384 arithmetic on 64-bit platforms.
+ *  \return  EC_METHOD object
+ */
+const EC_METHOD *EC_GFp_nistz384_method(void);
+#endif
 
 size_t ec_key_simple_priv2oct(const EC_KEY *eckey,
                               unsigned char *buf, size_t len);
@@ -619,3 +651,12 @@ int X25519(uint8_t out_shared_key[32], const uint8_t private_key[32],
            const uint8_t peer_public_value[32]);
 void X25519_public_from_private(uint8_t out_public_value[32],
                                 const uint8_t private_key[32]);
+
+const EC_METHOD *ec_ed25519_meth(void);
+
+void ED25519_public_from_private(uint8_t out_public_key[32],
+                                 const uint8_t private_key[32]);
+int ED25519_sign(uint8_t *out_sig, const uint8_t *message, size_t message_len,
+                 const uint8_t public_key[32], const uint8_t private_key[32]);
+int ED25519_verify(const uint8_t *message, size_t message_len,
+                   const uint8_t signature[64], const uint8_t public_key[32]);
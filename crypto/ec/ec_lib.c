@@ -573,11 +573,19 @@ EC_POINT *EC_POINT_new(const EC_GROUP *group)
     return ret;
 }
 
+static void ec_point_pre_comp_free(EC_POINT *point)
+{
+    if (point->pre_comp != NULL && point->meth->point_pre_comp_free != 0)
+        point->meth->point_pre_comp_free(point);
+    point->pre_comp = NULL;
+}
+
 void EC_POINT_free(EC_POINT *point)
 {
     if (!point)
         return;
 
+    ec_point_pre_comp_free(point);
     if (point->meth->point_finish != 0)
         point->meth->point_finish(point);
     OPENSSL_free(point);
@@ -588,6 +596,7 @@ void EC_POINT_clear_free(EC_POINT *point)
     if (!point)
         return;
 
+    ec_point_pre_comp_free(point);
     if (point->meth->point_clear_finish != 0)
         point->meth->point_clear_finish(point);
     else if (point->meth->point_finish != 0)
@@ -607,6 +616,7 @@ int EC_POINT_copy(EC_POINT *dest, const EC_POINT *src)
     }
     if (dest == src)
         return 1;
+    ec_point_pre_comp_free(dest);
     return dest->meth->point_copy(dest, src);
 }
 
@@ -941,6 +951,19 @@ int EC_GROUP_precompute_mult(EC_GROUP *group, BN_CTX *ctx)
         return 1;               /* nothing to do, so report success */
 }
 
+int EC_POINT_precompute_mult(const EC_GROUP *group, EC_POINT *point,
+                             BN_CTX *ctx)
+{
+    if (group->meth != point->meth) {
+        ECerr(EC_F_EC_POINT_PRECOMPUTE_MULT, EC_R_INCOMPATIBLE_OBJECTS);
+        return 0;
+    }
+    if (group->meth->point_precompute_mult != 0)
+        return group->meth->point_precompute_mult(group, point, ctx);
+    else
+        return 1;               /* nothing to do, so report success */
+}
+
 int EC_GROUP_have_precompute_mult(const EC_GROUP *group)
 {
     if (group->meth->mul == 0)
@@ -115,6 +115,259 @@ void EC_ec_pre_comp_free(EC_PRE_COMP *pre)
                   (b) >=   20 ? 2 : \
                   1))
 
+/*
+ * Number of points from which ec_wNAF_mul() uses the bucket method of
+ * ec_pippenger_mul() instead of interleaved wNAFs
+ */
+#define EC_PIPPENGER_MIN_POINTS 128
+
+/* largest window size ec_pippenger_window_size() will choose */
+#define EC_PIPPENGER_MAX_WINDOW 16
+
+/*-
+ * Returns the window size w for the bucket method with 'num' scalars of
+ * 'bits' bits each. Every one of the (bits + w) / w windows costs one
+ * addition per point plus two per bucket, and there are 2^(w-1) buckets.
+ */
+size_t ec_pippenger_window_size(size_t num, size_t bits)
+{
+    size_t w, cost, best = 1, best_cost = (size_t)-1;
+
+    for (w = 1; w <= EC_PIPPENGER_MAX_WINDOW; w++) {
+        cost = ((bits + w) / w) * (num + ((size_t)1 << w));
+        if (cost < best_cost) {
+            best_cost = cost;
+            best = w;
+        }
+    }
+    return best;
+}
+
+/*-
+ * Recodes the little-endian 'len'-byte scalar into 'numwin' signed digits
+ * of 'w' bits each, digits[k] in [-2^(w-1), 2^(w-1)], so that
+ *      scalar = \sum digits[k] * 2^(w*k)
+ * numwin * w must exceed the bit length of the scalar to absorb the final
+ * carry.
+ */
+void ec_pippenger_recode(int *digits, const unsigned char *scalar,
+                         size_t len, size_t w, size_t numwin)
+{
+    size_t k, b, bit;
+    int d, carry = 0;
+
+    for (k = 0; k < numwin; k++) {
+        d = carry;
+        for (b = 0; b < w; b++) {
+            bit = k * w + b;
+            if (bit / 8 < len)
+                d += ((scalar[bit / 8] >> (bit % 8)) & 1) << b;
+        }
+        carry = d > (1 << (w - 1));
+        if (carry)
+            d -= 1 << w;
+        digits[k] = d;
+    }
+}
+
+/*-
+ * Compute
+ *      \sum scalars[i]*points[i],
+ * also including
+ *      scalar*generator
+ * in the addition if scalar != NULL, with the bucket method of Pippenger
+ * (see e.g. Bernstein et al., "Faster batch forgery identification",
+ * INDOCRYPT 2012). For each window, starting from the most significant one,
+ * every point is added to the bucket selected by its digit, so that
+ *      \sum_j j*bucket[j]
+ * is the contribution of the window; the buckets are then combined with a
+ * running sum. Unlike the interleaved wNAF method of ec_wNAF_mul(), the
+ * cost per point decreases with 'num'. Not constant time.
+ */
+int ec_pippenger_mul(const EC_GROUP *group, EC_POINT *r, const BIGNUM *scalar,
+                     size_t num, const EC_POINT *points[],
+                     const BIGNUM *scalars[], BN_CTX *ctx)
+{
+    BN_CTX *new_ctx = NULL;
+    const EC_POINT *point;
+    const BIGNUM *k;
+    BIGNUM *tmp;
+    EC_POINT **val = NULL;      /* affine copies of the points */
+    EC_POINT **bucket = NULL;
+    EC_POINT *sum = NULL, *acc = NULL;
+    unsigned char *p_str = NULL;
+    unsigned char *used = NULL;
+    int *digits = NULL;
+    size_t totalnum, len, bits, w, numwin, numbuckets, i, j;
+    int d, b, top, acc_is_infinity = 1, ret = 0;
+
+    if (group->meth != r->meth) {
+        ECerr(EC_F_EC_PIPPENGER_MUL, EC_R_INCOMPATIBLE_OBJECTS);
+        return 0;
+    }
+
+    totalnum = num + (scalar != NULL);
+    if (totalnum == 0)
+        return EC_POINT_set_to_infinity(group, r);
+
+    if (BN_is_zero(group->order)) {
+        ECerr(EC_F_EC_PIPPENGER_MUL, EC_R_UNKNOWN_ORDER);
+        return 0;
+    }
+
+    bits = BN_num_bits(group->order);
+    len = BN_num_bytes(group->order);
+    w = ec_pippenger_window_size(totalnum, bits);
+    numwin = (bits + w) / w;
+    numbuckets = (size_t)1 << (w - 1);
+
+    if (totalnum > OPENSSL_MALLOC_MAX_NELEMS(EC_POINT *)
+        || totalnum > OPENSSL_MALLOC_MAX_NELEMS(int) / numwin
+        || totalnum > OPENSSL_MALLOC_MAX_NELEMS(unsigned char) / len) {
+        ECerr(EC_F_EC_PIPPENGER_MUL, ERR_R_MALLOC_FAILURE);
+        return 0;
+    }
+
+    if (ctx == NULL) {
+        ctx = new_ctx = BN_CTX_new();
+        if (ctx == NULL)
+            goto err;
+    }
+    BN_CTX_start(ctx);
+    if ((tmp = BN_CTX_get(ctx)) == NULL)
+        goto err;
+
+    val = OPENSSL_zalloc(totalnum * sizeof(val[0]));
+    bucket = OPENSSL_zalloc(numbuckets * sizeof(bucket[0]));
+    used = OPENSSL_malloc(numbuckets);
+    p_str = OPENSSL_malloc(totalnum * len);
+    digits = OPENSSL_malloc(totalnum * numwin * sizeof(digits[0]));
+    if (val == NULL || bucket == NULL || used == NULL || p_str == NULL
+        || digits == NULL) {
+        ECerr(EC_F_EC_PIPPENGER_MUL, ERR_R_MALLOC_FAILURE);
+        goto err;
+    }
+
+    for (i = 0; i < totalnum; i++) {
+        if (i < num) {
+            point = points[i];
+            k = scalars[i];
+            if (group->meth != point->meth) {
+                ECerr(EC_F_EC_PIPPENGER_MUL, EC_R_INCOMPATIBLE_OBJECTS);
+                goto err;
+            }
+        } else {
+            point = EC_GROUP_get0_generator(group);
+            k = scalar;
+            if (point == NULL) {
+                ECerr(EC_F_EC_PIPPENGER_MUL, EC_R_UNDEFINED_GENERATOR);
+                goto err;
+            }
+        }
+
+        if (BN_is_negative(k) || (size_t)BN_num_bits(k) > bits) {
+            if (!BN_nnmod(tmp, k, group->order, ctx))
+                goto err;
+            k = tmp;
+        }
+        if (BN_bn2lebinpad(k, p_str + i * len, (int)len) < 0)
+            goto err;
+        ec_pippenger_recode(digits + i * numwin, p_str + i * len, len, w,
+                            numwin);
+
+        if ((val[i] = EC_POINT_dup(point, group)) == NULL)
+            goto err;
+    }
+
+    /* Affine points make every addition to a bucket a mixed one */
+    if (!EC_POINTs_make_affine(group, totalnum, val, ctx))
+        goto err;
+
+    for (j = 0; j < numbuckets; j++) {
+        if ((bucket[j] = EC_POINT_new(group)) == NULL)
+            goto err;
+    }
+    if ((sum = EC_POINT_new(group)) == NULL
+        || (acc = EC_POINT_new(group)) == NULL)
+        goto err;
+
+    for (i = numwin; i-- > 0;) {
+        if (!acc_is_infinity) {
+            for (j = 0; j < w; j++) {
+                if (!EC_POINT_dbl(group, acc, acc, ctx))
+                    goto err;
+            }
+        }
+
+        memset(used, 0, numbuckets);
+        top = -1;
+        for (j = 0; j < totalnum; j++) {
+            d = digits[j * numwin + i];
+            if (d == 0)
+                continue;
+            b = (d < 0 ? -d : d) - 1;
+            if (d < 0 && !EC_POINT_invert(group, val[j], ctx))
+                goto err;
+            if (used[b]) {
+                if (!EC_POINT_add(group, bucket[b], bucket[b], val[j], ctx))
+                    goto err;
+            } else {
+                if (!EC_POINT_copy(bucket[b], val[j]))
+                    goto err;
+                used[b] = 1;
+                if (b > top)
+                    top = b;
+            }
+            if (d < 0 && !EC_POINT_invert(group, val[j], ctx))
+                goto err;
+        }
+        if (top < 0)
+            continue;
+
+        /* acc += \sum_j (j+1)*bucket[j], summing the buckets top down */
+        if (!EC_POINT_copy(sum, bucket[top]))
+            goto err;
+        for (b = top; b >= 0; b--) {
+            if (b < top && used[b]
+                && !EC_POINT_add(group, sum, sum, bucket[b], ctx))
+                goto err;
+            if (acc_is_infinity) {
+                if (!EC_POINT_copy(acc, sum))
+                    goto err;
+                acc_is_infinity = 0;
+            } else if (!EC_POINT_add(group, acc, acc, sum, ctx)) {
+                goto err;
+            }
+        }
+    }
+
+    if (acc_is_infinity)
+        ret = EC_POINT_set_to_infinity(group, r);
+    else
+        ret = EC_POINT_copy(r, acc);
+
+ err:
+    if (ctx != NULL)
+        BN_CTX_end(ctx);
+    BN_CTX_free(new_ctx);
+    if (val != NULL) {
+        for (i = 0; i < totalnum; i++)
+            EC_POINT_free(val[i]);
+        OPENSSL_free(val);
+    }
+    if (bucket != NULL) {
+        for (j = 0; j < numbuckets; j++)
+            EC_POINT_free(bucket[j]);
+        OPENSSL_free(bucket);
+    }
+    EC_POINT_free(sum);
+    EC_POINT_free(acc);
+    OPENSSL_clear_free(p_str, totalnum * len);
+    OPENSSL_clear_free(digits, totalnum * numwin * sizeof(digits[0]));
+    OPENSSL_free(used);
+    return ret;
+}
+
 /*-
  * Compute
  *      \sum scalars[i]*points[i],
@@ -167,6 +420,9 @@ int ec_wNAF_mul(const EC_GROUP *group, EC_POINT *r, const BIGNUM *scalar,
         }
     }
 
+    if (num >= EC_PIPPENGER_MIN_POINTS && !BN_is_zero(group->order))
+        return ec_pippenger_mul(group, r, scalar, num, points, scalars, ctx);
+
     if (ctx == NULL) {
         ctx = new_ctx = BN_CTX_new();
         if (ctx == NULL)
@@ -103,6 +103,23 @@ static int pkey_ec_sign(EVP_PKEY_CTX *ctx, unsigned char *sig, size_t *siglen,
     EC_PKEY_CTX *dctx = ctx->data;
     EC_KEY *ec = ctx->pkey->pkey.ec;
 
+    if (ec->group->meth->sign_message != NULL) {
+        size_t len;
+
+        /* The curve signs the message itself, e.g. Ed25519 */
+        if (!ec->group->meth->sign_message(NULL, &len, tbs, tbslen, ec))
+            return 0;
+        if (sig == NULL) {
+            *siglen = len;
+            return 1;
+        }
+        if (*siglen < len) {
+            ECerr(EC_F_PKEY_EC_SIGN, EC_R_BUFFER_TOO_SMALL);
+            return 0;
+        }
+        return ec->group->meth->sign_message(sig, siglen, tbs, tbslen, ec);
+    }
+
     if (!sig) {
         *siglen = ECDSA_size(ec);
         return 1;
@@ -132,6 +149,9 @@ static int pkey_ec_verify(EVP_PKEY_CTX *ctx,
     EC_PKEY_CTX *dctx = ctx->data;
     EC_KEY *ec = ctx->pkey->pkey.ec;
 
+    if (ec->group->meth->verify_message != NULL)
+        return ec->group->meth->verify_message(sig, siglen, tbs, tbslen, ec);
+
     if (dctx->md)
         type = EVP_MD_type(dctx->md);
     else
@@ -26,6 +26,7 @@
 #include <limits.h>
 
 #include "internal/cryptlib.h"
+#include "internal/bn_int.h"
 
 #include <openssl/err.h>
 #include <openssl/bn.h>
@@ -61,7 +62,8 @@ int ecdh_simple_compute_key(unsigned char **pout, size_t *poutlen,
     size_t buflen, len;
     unsigned char *buf = NULL;
 
-    if ((ctx = BN_CTX_new()) == NULL)
+    ctx = bn_ctx_thread_get(EC_GROUP_get_degree(EC_KEY_get0_group(ecdh)));
+    if (ctx == NULL)
         goto err;
     BN_CTX_start(ctx);
     x = BN_CTX_get(ctx);
@@ -137,7 +139,7 @@ int ecdh_simple_compute_key(unsigned char **pout, size_t *poutlen,
     EC_POINT_free(tmp);
     if (ctx)
         BN_CTX_end(ctx);
-    BN_CTX_free(ctx);
+    bn_ctx_thread_put(ctx);
     OPENSSL_free(buf);
     return ret;
 }
@@ -13,6 +13,7 @@
 #include <openssl/bn.h>
 #include <openssl/rand.h>
 #include <openssl/ec.h>
+#include "internal/bn_int.h"
 #include "ec_lcl.h"
 
 int ossl_ecdsa_sign(int type, const unsigned char *dgst, int dlen,
@@ -53,7 +54,7 @@ static int ecdsa_sign_setup(EC_KEY *eckey, BN_CTX *ctx_in,
     }
 
     if (ctx_in == NULL) {
-        if ((ctx = BN_CTX_new()) == NULL) {
+        if ((ctx = bn_ctx_thread_get(EC_GROUP_get_degree(group))) == NULL) {
             ECerr(EC_F_ECDSA_SIGN_SETUP, ERR_R_MALLOC_FAILURE);
             return 0;
         }
@@ -179,7 +180,7 @@ static int ecdsa_sign_setup(EC_KEY *eckey, BN_CTX *ctx_in,
         BN_clear_free(r);
     }
     if (ctx != ctx_in)
-        BN_CTX_free(ctx);
+        bn_ctx_thread_put(ctx);
     EC_POINT_free(tmp_point);
     BN_clear_free(X);
     return (ret);
@@ -223,7 +224,7 @@ ECDSA_SIG *ossl_ecdsa_sign_sig(const unsigned char *dgst, int dgst_len,
     }
     s = ret->s;
 
-    if ((ctx = BN_CTX_new()) == NULL ||
+    if ((ctx = bn_ctx_thread_get(EC_GROUP_get_degree(group))) == NULL ||
         (tmp = BN_new()) == NULL || (m = BN_new()) == NULL) {
         ECerr(EC_F_OSSL_ECDSA_SIGN_SIG, ERR_R_MALLOC_FAILURE);
         goto err;
@@ -297,7 +298,7 @@ ECDSA_SIG *ossl_ecdsa_sign_sig(const unsigned char *dgst, int dgst_len,
         ECDSA_SIG_free(ret);
         ret = NULL;
     }
-    BN_CTX_free(ctx);
+    bn_ctx_thread_put(ctx);
     BN_clear_free(m);
     BN_clear_free(tmp);
     BN_clear_free(kinv);
@@ -358,7 +359,7 @@ int ossl_ecdsa_verify_sig(const unsigned char *dgst, int dgst_len,
         return -1;
     }
 
-    ctx = BN_CTX_new();
+    ctx = bn_ctx_thread_get(EC_GROUP_get_degree(group));
     if (ctx == NULL) {
         ECerr(EC_F_OSSL_ECDSA_VERIFY_SIG, ERR_R_MALLOC_FAILURE);
         return -1;
@@ -450,7 +451,7 @@ int ossl_ecdsa_verify_sig(const unsigned char *dgst, int dgst_len,
     ret = (BN_ucmp(u1, sig->r) == 0);
  err:
     BN_CTX_end(ctx);
-    BN_CTX_free(ctx);
+    bn_ctx_thread_put(ctx);
     EC_POINT_free(point);
     return ret;
 }
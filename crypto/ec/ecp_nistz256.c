@@ -632,6 +632,9 @@ __owur static int ecp_nistz256_windowed_mul(const EC_GROUP *group,
                   EC_R_COORDINATES_OUT_OF_RANGE);
             goto err;
         }
+        /* ecp_nistz256_point_add() expects the point at infinity as zeros */
+        if (EC_POINT_is_at_infinity(group, point[i]))
+            memset(&temp[0], 0, sizeof(temp[0]));
 
         /*
          * row[0] is implicitly (0,0,0) (the point at infinity), therefore it
@@ -733,6 +736,132 @@ __owur static int ecp_nistz256_windowed_mul(const EC_GROUP *group,
     return ret;
 }
 
+/*
+ * Number of points from which ecp_nistz256_points_mul() uses the bucket
+ * method instead of ecp_nistz256_windowed_mul()
+ */
+#define ECP_NISTZ256_PIPPENGER_MIN_POINTS 48
+
+/*
+ * r = sum(scalar[i]*point[i]) with the bucket method, see ec_pippenger_mul().
+ * This is not constant-time and only used for many points, which only come
+ * up with public scalars, e.g. in batch verification.
+ */
+__owur static int ecp_nistz256_pippenger_mul(const EC_GROUP *group,
+                                             P256_POINT *r,
+                                             const BIGNUM **scalar,
+                                             const EC_POINT **point,
+                                             size_t num, BN_CTX *ctx)
+{
+    size_t i, j, w, numwin, numbuckets;
+    int d, b, top, r_is_infinity = 1, ret = 0;
+    unsigned char p_str[33];
+    const BIGNUM *k;
+    BIGNUM *mod;
+    int *digits = NULL;
+    unsigned char *used = NULL;
+    P256_POINT *val = NULL, *bucket = NULL;
+    const P256_POINT *in;
+    ALIGN32 P256_POINT sum, neg;
+
+    w = ec_pippenger_window_size(num, 256);
+    numwin = (256 + w) / w;
+    numbuckets = (size_t)1 << (w - 1);
+
+    if (num > OPENSSL_MALLOC_MAX_NELEMS(P256_POINT)
+        || num > OPENSSL_MALLOC_MAX_NELEMS(int) / numwin
+        || (val = OPENSSL_malloc(num * sizeof(P256_POINT))) == NULL
+        || (bucket = OPENSSL_malloc(numbuckets * sizeof(P256_POINT))) == NULL
+        || (used = OPENSSL_malloc(numbuckets)) == NULL
+        || (digits = OPENSSL_malloc(num * numwin * sizeof(int))) == NULL) {
+        ECerr(EC_F_ECP_NISTZ256_PIPPENGER_MUL, ERR_R_MALLOC_FAILURE);
+        goto err;
+    }
+
+    if ((mod = BN_CTX_get(ctx)) == NULL)
+        goto err;
+
+    for (i = 0; i < num; i++) {
+        k = scalar[i];
+        if ((BN_num_bits(k) > 256) || BN_is_negative(k)) {
+            if (!BN_nnmod(mod, k, group->order, ctx)) {
+                ECerr(EC_F_ECP_NISTZ256_PIPPENGER_MUL, ERR_R_BN_LIB);
+                goto err;
+            }
+            k = mod;
+        }
+        if (BN_bn2lebinpad(k, p_str, sizeof(p_str)) < 0)
+            goto err;
+        ec_pippenger_recode(digits + i * numwin, p_str, sizeof(p_str), w,
+                            numwin);
+
+        if (!ecp_nistz256_bignum_to_field_elem(val[i].X, point[i]->X)
+            || !ecp_nistz256_bignum_to_field_elem(val[i].Y, point[i]->Y)
+            || !ecp_nistz256_bignum_to_field_elem(val[i].Z, point[i]->Z)) {
+            ECerr(EC_F_ECP_NISTZ256_PIPPENGER_MUL,
+                  EC_R_COORDINATES_OUT_OF_RANGE);
+            goto err;
+        }
+        if (EC_POINT_is_at_infinity(group, point[i]))
+            memset(&val[i], 0, sizeof(val[i]));
+    }
+
+    memset(r, 0, sizeof(*r));
+    for (i = numwin; i-- > 0;) {
+        if (!r_is_infinity) {
+            for (j = 0; j < w; j++)
+                ecp_nistz256_point_double(r, r);
+        }
+
+        memset(used, 0, numbuckets);
+        top = -1;
+        for (j = 0; j < num; j++) {
+            d = digits[j * numwin + i];
+            if (d == 0)
+                continue;
+            in = &val[j];
+            if (d < 0) {
+                memcpy(neg.X, in->X, sizeof(neg.X));
+                ecp_nistz256_neg(neg.Y, in->Y);
+                memcpy(neg.Z, in->Z, sizeof(neg.Z));
+                in = &neg;
+                d = -d;
+            }
+            b = d - 1;
+            if (used[b]) {
+                ecp_nistz256_point_add(&bucket[b], &bucket[b], in);
+            } else {
+                memcpy(&bucket[b], in, sizeof(P256_POINT));
+                used[b] = 1;
+                if (b > top)
+                    top = b;
+            }
+        }
+        if (top < 0)
+            continue;
+
+        /* r += sum((b+1)*bucket[b]), summing the buckets top down */
+        memcpy(&sum, &bucket[top], sizeof(P256_POINT));
+        for (b = top; b >= 0; b--) {
+            if (b < top && used[b])
+                ecp_nistz256_point_add(&sum, &sum, &bucket[b]);
+            if (r_is_infinity)
+                memcpy(r, &sum, sizeof(P256_POINT));
+            else
+                ecp_nistz256_point_add(r, r, &sum);
+            r_is_infinity = 0;
+        }
+    }
+
+    ret = 1;
+ err:
+    OPENSSL_free(val);
+    OPENSSL_free(bucket);
+    OPENSSL_free(used);
+    OPENSSL_free(digits);
+    return ret;
+}
+
 /* Coordinates of G, for which we have precomputed tables */
 const static BN_ULONG def_xG[P256_LIMBS] = {
     TOBN(0x79e730d4, 0x18a9143c), TOBN(0x75ba95fc, 0x5fedb601),
@@ -1114,6 +1243,244 @@ __owur static int ecp_nistz256_set_from_affine(EC_POINT *out, const EC_GROUP *gr
     return ret;
 }
 
+/*
+ * r = scalar*P, where |table| holds the multiples of P laid out like the
+ * precomputed generator table: row i holds 1..64 times 2^(7*i)*P, in affine
+ * form.
+ */
+__owur static int ecp_nistz256_comb_mul(const EC_GROUP *group, P256_POINT *r,
+                                        const BIGNUM *scalar,
+                                        const PRECOMP256_ROW *table,
+                                        BN_CTX *ctx)
+{
+    int i;
+    unsigned char p_str[33] = { 0 };
+    unsigned int idx = 0;
+    const unsigned int window_size = 7;
+    const unsigned int mask = (1 << (window_size + 1)) - 1;
+    unsigned int wvalue;
+    BN_ULONG infty;
+    ALIGN32 union {
+        P256_POINT p;
+        P256_POINT_AFFINE a;
+    } t, p;
+    BIGNUM *tmp_scalar;
+
+    if ((BN_num_bits(scalar) > 256) || BN_is_negative(scalar)) {
+        if ((tmp_scalar = BN_CTX_get(ctx)) == NULL)
+            return 0;
+
+        if (!BN_nnmod(tmp_scalar, scalar, group->order, ctx)) {
+            ECerr(EC_F_ECP_NISTZ256_POINTS_MUL, ERR_R_BN_LIB);
+            return 0;
+        }
+        scalar = tmp_scalar;
+    }
+
+    for (i = 0; i < bn_get_top(scalar) * BN_BYTES; i += BN_BYTES) {
+        BN_ULONG d = bn_get_words(scalar)[i / BN_BYTES];
+
+        p_str[i + 0] = (unsigned char)d;
+        p_str[i + 1] = (unsigned char)(d >> 8);
+        p_str[i + 2] = (unsigned char)(d >> 16);
+        p_str[i + 3] = (unsigned char)(d >>= 24);
+        if (BN_BYTES == 8) {
+            d >>= 8;
+            p_str[i + 4] = (unsigned char)d;
+            p_str[i + 5] = (unsigned char)(d >> 8);
+            p_str[i + 6] = (unsigned char)(d >> 16);
+            p_str[i + 7] = (unsigned char)(d >> 24);
+        }
+    }
+
+    for (; i < 33; i++)
+        p_str[i] = 0;
+
+#if defined(ECP_NISTZ256_AVX2)
+    if (ecp_nistz_avx2_eligible()) {
+        ecp_nistz256_avx2_mul_g(r, p_str, table);
+    } else
+#endif
+    {
+        /* First window */
+        wvalue = (p_str[0] << 1) & mask;
+        idx += window_size;
+
+        wvalue = _booth_recode_w7(wvalue);
+
+        ecp_nistz256_gather_w7(&p.a, table[0], wvalue >> 1);
+
+        ecp_nistz256_neg(p.p.Z, p.p.Y);
+        copy_conditional(p.p.Y, p.p.Z, wvalue & 1);
+
+        /*
+         * (0, 0) is not on the curve and stands for infinity, which
+         * needs Z = 0 to be recognised as such by the additions below.
+         */
+        infty = p.p.X[0] | p.p.X[1] | p.p.X[2] | p.p.X[3]
+                | p.p.Y[0] | p.p.Y[1] | p.p.Y[2] | p.p.Y[3];
+        if (P256_LIMBS == 8)
+            infty |= p.p.X[4] | p.p.X[5] | p.p.X[6] | p.p.X[7]
+                     | p.p.Y[4] | p.p.Y[5] | p.p.Y[6] | p.p.Y[7];
+        infty = 0 - is_zero(infty);
+        for (i = 0; i < P256_LIMBS; i++)
+            p.p.Z[i] = ONE[i] & ~infty;
+
+        for (i = 1; i < 37; i++) {
+            unsigned int off = (idx - 1) / 8;
+            wvalue = p_str[off] | p_str[off + 1] << 8;
+            wvalue = (wvalue >> ((idx - 1) % 8)) & mask;
+            idx += window_size;
+
+            wvalue = _booth_recode_w7(wvalue);
+
+            ecp_nistz256_gather_w7(&t.a, table[i], wvalue >> 1);
+
+            ecp_nistz256_neg(t.p.Z, t.a.Y);
+            copy_conditional(t.a.Y, t.p.Z, wvalue & 1);
+
+            ecp_nistz256_point_add_affine(&p.p, &p.p, &t.a);
+        }
+        memcpy(r, &p.p, sizeof(p.p));
+    }
+
+    OPENSSL_cleanse(p_str, sizeof(p_str));
+    return 1;
+}
+
+/* structure for precomputed multiples of an arbitrary point */
+typedef struct {
+    /* The point the table was computed for, in the Montgomery domain */
+    P256_POINT_AFFINE point;
+    PRECOMP256_ROW *precomp;
+    void *precomp_storage;
+} NISTZ256_POINT_PRE_COMP;
+
+static void ecp_nistz256_point_pre_comp_free(EC_POINT *point)
+{
+    NISTZ256_POINT_PRE_COMP *pre = point->pre_comp;
+
+    if (pre == NULL)
+        return;
+    OPENSSL_free(pre->precomp_storage);
+    OPENSSL_free(pre);
+    point->pre_comp = NULL;
+}
+
+/*
+ * Computes the same table for |point| as ecp_nistz256_mult_precompute()
+ * does for the generator, but with P256 arithmetic rather than EC_POINTs,
+ * and converts all 37*64 multiples to affine form with one inversion.
+ */
+__owur static int ecp_nistz256_point_precompute_mult(const EC_GROUP *group,
+                                                     EC_POINT *point,
+                                                     BN_CTX *ctx)
+{
+    const int n = 37 * 64;
+    NISTZ256_POINT_PRE_COMP *pre = NULL;
+    P256_POINT *pts = NULL, base;
+    BN_ULONG (*prod)[P256_LIMBS] = NULL;
+    BN_ULONG inv[P256_LIMBS], zinv[P256_LIMBS], zinv2[P256_LIMBS];
+    P256_POINT_AFFINE temp;
+    unsigned char *precomp_storage = NULL;
+    int i, k, ret = 0;
+
+    ecp_nistz256_point_pre_comp_free(point);
+
+    /*
+     * All multiples of a point of the (prime order) group up to the order
+     * are finite, which the batch inversion below relies on.
+     */
+    if (EC_POINT_is_at_infinity(group, point)
+        || EC_POINT_is_on_curve(group, point, ctx) <= 0) {
+        ECerr(EC_F_ECP_NISTZ256_POINT_PRECOMPUTE_MULT,
+              EC_R_POINT_IS_NOT_ON_CURVE);
+        return 0;
+    }
+    if (!EC_POINT_make_affine(group, point, ctx))
+        return 0;
+
+    pre = OPENSSL_zalloc(sizeof(*pre));
+    precomp_storage =
+        OPENSSL_malloc(37 * 64 * sizeof(P256_POINT_AFFINE) + 64);
+    pts = OPENSSL_malloc(n * sizeof(*pts));
+    prod = OPENSSL_malloc(n * sizeof(*prod));
+    if (pre == NULL || precomp_storage == NULL || pts == NULL
+        || prod == NULL) {
+        ECerr(EC_F_ECP_NISTZ256_POINT_PRECOMPUTE_MULT, ERR_R_MALLOC_FAILURE);
+        goto err;
+    }
+
+    if (!ecp_nistz256_bignum_to_field_elem(pre->point.X, point->X) ||
+        !ecp_nistz256_bignum_to_field_elem(pre->point.Y, point->Y)) {
+        ECerr(EC_F_ECP_NISTZ256_POINT_PRECOMPUTE_MULT,
+              EC_R_COORDINATES_OUT_OF_RANGE);
+        goto err;
+    }
+    memcpy(base.X, pre->point.X, sizeof(base.X));
+    memcpy(base.Y, pre->point.Y, sizeof(base.Y));
+    memcpy(base.Z, ONE, sizeof(base.Z));
+
+    /* pts[64*j+k] = (k+1)*2^(7*j)*P */
+    for (i = 0; i < n; i += 64) {
+        memcpy(&pts[i], &base, sizeof(base));
+        ecp_nistz256_point_double(&pts[i + 1], &pts[i]);
+        for (k = 2; k < 64; k++)
+            ecp_nistz256_point_add(&pts[i + k], &pts[i + k - 1], &pts[i]);
+        ecp_nistz256_point_double(&base, &pts[i + 63]);
+    }
+
+    memcpy(prod[0], pts[0].Z, sizeof(prod[0]));
+    for (i = 1; i < n; i++)
+        ecp_nistz256_mul_mont(prod[i], prod[i - 1], pts[i].Z);
+    ecp_nistz256_mod_inverse(inv, prod[n - 1]);
+
+    pre->precomp = (void *)ALIGNPTR(precomp_storage, 64);
+    for (i = n - 1; i >= 0; i--) {
+        if (i > 0) {
+            ecp_nistz256_mul_mont(zinv, inv, prod[i - 1]);
+            ecp_nistz256_mul_mont(inv, inv, pts[i].Z);
+        } else {
+            memcpy(zinv, inv, sizeof(zinv));
+        }
+        ecp_nistz256_sqr_mont(zinv2, zinv);
+        ecp_nistz256_mul_mont(temp.X, pts[i].X, zinv2);
+        ecp_nistz256_mul_mont(zinv2, zinv2, zinv);
+        ecp_nistz256_mul_mont(temp.Y, pts[i].Y, zinv2);
+        ecp_nistz256_scatter_w7(pre->precomp[i / 64], &temp, i % 64);
+    }
+
+    pre->precomp_storage = precomp_storage;
+    precomp_storage = NULL;
+    point->pre_comp = pre;
+    pre = NULL;
+    ret = 1;
+
+ err:
+    OPENSSL_free(pre);
+    OPENSSL_free(precomp_storage);
+    OPENSSL_free(pts);
+    OPENSSL_free(prod);
+    return ret;
+}
+
+/*
+ * Returns the table set up by ecp_nistz256_point_precompute_mult() for
+ * |point|, or NULL if there is none or the point was changed since.
+ */
+static const PRECOMP256_ROW *ecp_nistz256_point_table(const EC_POINT *point)
+{
+    const NISTZ256_POINT_PRE_COMP *pre = point->pre_comp;
+    BN_ULONG x[P256_LIMBS], y[P256_LIMBS];
+
+    if (pre == NULL || !point->Z_is_one
+        || !ecp_nistz256_bignum_to_field_elem(x, point->X)
+        || !ecp_nistz256_bignum_to_field_elem(y, point->Y)
+        || !is_equal(x, pre->point.X) || !is_equal(y, pre->point.Y))
+        return NULL;
+    return pre->precomp;
+}
+
 /* r = scalar*G + sum(scalars[i]*points[i]) */
 __owur static int ecp_nistz256_points_mul(const EC_GROUP *group,
                                           EC_POINT *r,
@@ -1122,24 +1489,18 @@ __owur static int ecp_nistz256_points_mul(const EC_GROUP *group,
                                           const EC_POINT *points[],
                                           const BIGNUM *scalars[], BN_CTX *ctx)
 {
-    int i = 0, ret = 0, no_precomp_for_generator = 0, p_is_infinity = 0;
-    size_t j;
-    unsigned char p_str[33] = { 0 };
+    int ret = 0, no_precomp_for_generator = 0, p_is_infinity = 0;
+    size_t j, k, num_tables = 0;
     const PRECOMP256_ROW *preComputedTable = NULL;
     const NISTZ256_PRE_COMP *pre_comp = NULL;
     const EC_POINT *generator = NULL;
     BN_CTX *new_ctx = NULL;
     const BIGNUM **new_scalars = NULL;
     const EC_POINT **new_points = NULL;
-    unsigned int idx = 0;
-    const unsigned int window_size = 7;
-    const unsigned int mask = (1 << (window_size + 1)) - 1;
-    unsigned int wvalue;
     ALIGN32 union {
         P256_POINT p;
         P256_POINT_AFFINE a;
     } t, p;
-    BIGNUM *tmp_scalar;
 
     if ((num + 1) == 0 || (num + 1) > OPENSSL_MALLOC_MAX_NELEMS(void *)) {
         ECerr(EC_F_ECP_NISTZ256_POINTS_MUL, ERR_R_MALLOC_FAILURE);
@@ -1159,6 +1520,8 @@ __owur static int ecp_nistz256_points_mul(const EC_GROUP *group,
             ECerr(EC_F_ECP_NISTZ256_POINTS_MUL, EC_R_INCOMPATIBLE_OBJECTS);
             return 0;
         }
+        if (points[j]->pre_comp != NULL)
+            num_tables++;
     }
 
     if (ctx == NULL) {
@@ -1212,74 +1575,9 @@ __owur static int ecp_nistz256_points_mul(const EC_GROUP *group,
         }
 
         if (preComputedTable) {
-            if ((BN_num_bits(scalar) > 256)
-                || BN_is_negative(scalar)) {
-                if ((tmp_scalar = BN_CTX_get(ctx)) == NULL)
-                    goto err;
-
-                if (!BN_nnmod(tmp_scalar, scalar, group->order, ctx)) {
-                    ECerr(EC_F_ECP_NISTZ256_POINTS_MUL, ERR_R_BN_LIB);
-                    goto err;
-                }
-                scalar = tmp_scalar;
-            }
-
-            for (i = 0; i < bn_get_top(scalar) * BN_BYTES; i += BN_BYTES) {
-                BN_ULONG d = bn_get_words(scalar)[i / BN_BYTES];
-
-                p_str[i + 0] = (unsigned char)d;
-                p_str[i + 1] = (unsigned char)(d >> 8);
-                p_str[i + 2] = (unsigned char)(d >> 16);
-                p_str[i + 3] = (unsigned char)(d >>= 24);
-                if (BN_BYTES == 8) {
-                    d >>= 8;
-                    p_str[i + 4] = (unsigned char)d;
-                    p_str[i + 5] = (unsigned char)(d >> 8);
-                    p_str[i + 6] = (unsigned char)(d >> 16);
-                    p_str[i + 7] = (unsigned char)(d >> 24);
-                }
-            }
-
-            for (; i < 33; i++)
-                p_str[i] = 0;
-
-#if defined(ECP_NISTZ256_AVX2)
-            if (ecp_nistz_avx2_eligible()) {
-                ecp_nistz256_avx2_mul_g(&p.p, p_str, preComputedTable);
-            } else
-#endif
-            {
-                /* First window */
-                wvalue = (p_str[0] << 1) & mask;
-                idx += window_size;
-
-                wvalue = _booth_recode_w7(wvalue);
-
-                ecp_nistz256_gather_w7(&p.a, preComputedTable[0],
-                                       wvalue >> 1);
-
-                ecp_nistz256_neg(p.p.Z, p.p.Y);
-                copy_conditional(p.p.Y, p.p.Z, wvalue & 1);
-
-                memcpy(p.p.Z, ONE, sizeof(ONE));
-
-                for (i = 1; i < 37; i++) {
-                    unsigned int off = (idx - 1) / 8;
-                    wvalue = p_str[off] | p_str[off + 1] << 8;
-                    wvalue = (wvalue >> ((idx - 1) % 8)) & mask;
-                    idx += window_size;
-
-                    wvalue = _booth_recode_w7(wvalue);
-
-                    ecp_nistz256_gather_w7(&t.a,
-                                           preComputedTable[i], wvalue >> 1);
-
-                    ecp_nistz256_neg(t.p.Z, t.a.Y);
-                    copy_conditional(t.a.Y, t.p.Z, wvalue & 1);
-
-                    ecp_nistz256_point_add_affine(&p.p, &p.p, &t.a);
-                }
-            }
+            if (!ecp_nistz256_comb_mul(group, &p.p, scalar,
+                                       preComputedTable, ctx))
+                goto err;
         } else {
             p_is_infinity = 1;
             no_precomp_for_generator = 1;
@@ -1287,10 +1585,11 @@ __owur static int ecp_nistz256_points_mul(const EC_GROUP *group,
     } else
         p_is_infinity = 1;
 
-    if (no_precomp_for_generator) {
+    if (no_precomp_for_generator || num_tables > 0) {
         /*
-         * Without a precomputed table for the generator, it has to be
-         * handled like a normal point.
+         * Points with a table from EC_POINT_precompute_mult() are handled
+         * like the generator. Without a precomputed table for the generator,
+         * it has to be handled like a normal point.
          */
         new_scalars = OPENSSL_malloc((num + 1) * sizeof(BIGNUM *));
         if (new_scalars == NULL) {
@@ -1304,14 +1603,31 @@ __owur static int ecp_nistz256_points_mul(const EC_GROUP *group,
             goto err;
         }
 
-        memcpy(new_scalars, scalars, num * sizeof(BIGNUM *));
-        new_scalars[num] = scalar;
-        memcpy(new_points, points, num * sizeof(EC_POINT *));
-        new_points[num] = generator;
+        for (j = 0, k = 0; j < num; j++) {
+            const PRECOMP256_ROW *table = ecp_nistz256_point_table(points[j]);
+            P256_POINT *out = &t.p;
+
+            if (table == NULL) {
+                new_scalars[k] = scalars[j];
+                new_points[k++] = points[j];
+                continue;
+            }
+            if (p_is_infinity)
+                out = &p.p;
+            if (!ecp_nistz256_comb_mul(group, out, scalars[j], table, ctx))
+                goto err;
+            if (!p_is_infinity)
+                ecp_nistz256_point_add(&p.p, &p.p, out);
+            p_is_infinity = 0;
+        }
+        if (no_precomp_for_generator) {
+            new_scalars[k] = scalar;
+            new_points[k++] = generator;
+        }
 
         scalars = new_scalars;
         points = new_points;
-        num++;
+        num = k;
     }
 
     if (num) {
@@ -1319,8 +1635,14 @@ __owur static int ecp_nistz256_points_mul(const EC_GROUP *group,
         if (p_is_infinity)
             out = &p.p;
 
-        if (!ecp_nistz256_windowed_mul(group, out, scalars, points, num, ctx))
+        if (num >= ECP_NISTZ256_PIPPENGER_MIN_POINTS) {
+            if (!ecp_nistz256_pippenger_mul(group, out, scalars, points, num,
+                                            ctx))
+                goto err;
+        } else if (!ecp_nistz256_windowed_mul(group, out, scalars, points,
+                                              num, ctx)) {
             goto err;
+        }
 
         if (!p_is_infinity)
             ecp_nistz256_point_add(&p.p, &p.p, out);
@@ -1505,7 +1827,9 @@ const EC_METHOD *EC_GFp_nistz256_method(void)
         ec_key_simple_generate_public_key,
         0, /* keycopy */
         0, /* keyfinish */
-        ecdh_simple_compute_key
+        ecdh_simple_compute_key,
+        ecp_nistz256_point_precompute_mult,
+        ecp_nistz256_point_pre_comp_free
     };
 
     return &ret;
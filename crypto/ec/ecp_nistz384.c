@@ -0,0 +1,1146 @@
+/*
+ * Copyright 2016 The OpenSSL Project Authors. All Rights Reserved.
+ *
+ * Licensed under the OpenSSL license (the "License").  You may not use
+ * this file except in compliance with the License.  You can obtain a copy
+ * in the file LICENSE in the source distribution or at
+ * https://www.openssl.org/source/license.html
+ */
+
+/*
+ * Constant time arithmetic on the NIST P-384 curve, along the lines of
+ * ecp_nistz256.c: field elements are kept as six 64-bit (or twelve 32-bit)
+ * words in the Montgomery domain, points in Jacobian coordinates, scalars
+ * are recoded in signed windows and multiples of points are looked up by
+ * scanning whole tables. Multiplications of the default generator use a
+ * precomputed table, see ecp_nistz384_table.c.
+ */
+
+#include <string.h>
+
+#include "internal/cryptlib.h"
+#include "internal/bn_int.h"
+#include "ec_lcl.h"
+
+#if BN_BITS2 != 64
+# define TOBN(hi,lo)    lo,hi
+#else
+# define TOBN(hi,lo)    ((BN_ULONG)hi<<32|lo)
+#endif
+
+#define P384_LIMBS      (384/BN_BITS2)
+
+typedef struct {
+    BN_ULONG X[P384_LIMBS];
+    BN_ULONG Y[P384_LIMBS];
+    BN_ULONG Z[P384_LIMBS];
+} P384_POINT;
+
+typedef struct {
+    BN_ULONG X[P384_LIMBS];
+    BN_ULONG Y[P384_LIMBS];
+} P384_POINT_AFFINE;
+
+typedef P384_POINT_AFFINE PRECOMP384_ROW[16];
+
+/* The polynomial, 2^384 - 2^128 - 2^96 + 2^32 - 1 */
+static const BN_ULONG P384[P384_LIMBS] = {
+    TOBN(0x00000000, 0xffffffff), TOBN(0xffffffff, 0x00000000),
+    TOBN(0xffffffff, 0xfffffffe), TOBN(0xffffffff, 0xffffffff),
+    TOBN(0xffffffff, 0xffffffff), TOBN(0xffffffff, 0xffffffff)
+};
+
+/* One converted into the Montgomery domain */
+static const BN_ULONG ONE[P384_LIMBS] = {
+    TOBN(0xffffffff, 0x00000001), TOBN(0x00000000, 0xffffffff),
+    TOBN(0x00000000, 0x00000001), TOBN(0x00000000, 0x00000000),
+    TOBN(0x00000000, 0x00000000), TOBN(0x00000000, 0x00000000)
+};
+
+static const BN_ULONG ZERO[P384_LIMBS] = { 0 };
+
+#include "ecp_nistz384_table.c"
+
+#if defined(__x86_64) || defined(__x86_64__) || \
+    defined(_M_AMD64) || defined(_M_X64)
+/* Montgomery mul: res = a*b*2^-384 mod P, in ecp_nistz384-x86_64.pl */
+void ecp_nistz384_mul_mont(BN_ULONG res[P384_LIMBS],
+                           const BN_ULONG a[P384_LIMBS],
+                           const BN_ULONG b[P384_LIMBS]);
+#else
+/* -P^-1 mod 2^BN_BITS2, in the form bn_mul_mont() expects */
+static const BN_ULONG N0[2] = { TOBN(0x00000001, 0x00000001) };
+
+/* Montgomery mul: res = a*b*2^-384 mod P */
+static void ecp_nistz384_mul_mont(BN_ULONG res[P384_LIMBS],
+                                  const BN_ULONG a[P384_LIMBS],
+                                  const BN_ULONG b[P384_LIMBS])
+{
+    bn_mul_mont(res, a, b, P384, N0, P384_LIMBS);
+}
+#endif
+
+/* Montgomery sqr: res = a*a*2^-384 mod P */
+static void ecp_nistz384_sqr_mont(BN_ULONG res[P384_LIMBS],
+                                  const BN_ULONG a[P384_LIMBS])
+{
+    ecp_nistz384_mul_mont(res, a, a);
+}
+
+/* res = a squared |n| times, n > 0 */
+static void ecp_nistz384_sqr_mont_n(BN_ULONG res[P384_LIMBS],
+                                    const BN_ULONG a[P384_LIMBS], int n)
+{
+    ecp_nistz384_sqr_mont(res, a);
+    while (--n > 0)
+        ecp_nistz384_sqr_mont(res, res);
+}
+
+static void copy_conditional(BN_ULONG dst[P384_LIMBS],
+                             const BN_ULONG src[P384_LIMBS], BN_ULONG move)
+{
+    BN_ULONG mask1 = 0-move;
+    BN_ULONG mask2 = ~mask1;
+    int i;
+
+    for (i = 0; i < P384_LIMBS; i++)
+        dst[i] = (src[i] & mask1) ^ (dst[i] & mask2);
+}
+
+static BN_ULONG is_zero(BN_ULONG in)
+{
+    in |= (0 - in);
+    in = ~in;
+    in >>= BN_BITS2 - 1;
+    return in;
+}
+
+static BN_ULONG is_equal(const BN_ULONG a[P384_LIMBS],
+                         const BN_ULONG b[P384_LIMBS])
+{
+    BN_ULONG res = 0;
+    int i;
+
+    for (i = 0; i < P384_LIMBS; i++)
+        res |= a[i] ^ b[i];
+
+    return is_zero(res);
+}
+
+static BN_ULONG is_zero_elem(const BN_ULONG a[P384_LIMBS])
+{
+    return is_equal(a, ZERO);
+}
+
+/* res = a+b, returning the carry */
+static BN_ULONG add_words(BN_ULONG res[P384_LIMBS],
+                          const BN_ULONG a[P384_LIMBS],
+                          const BN_ULONG b[P384_LIMBS])
+{
+    BN_ULONG c = 0, t;
+    int i;
+
+    for (i = 0; i < P384_LIMBS; i++) {
+        t = a[i] + c;
+        c = t < c;
+        res[i] = t + b[i];
+        c += res[i] < t;
+    }
+    return c;
+}
+
+/* res = a-b, returning the borrow */
+static BN_ULONG sub_words(BN_ULONG res[P384_LIMBS],
+                          const BN_ULONG a[P384_LIMBS],
+                          const BN_ULONG b[P384_LIMBS])
+{
+    BN_ULONG c = 0, t;
+    int i;
+
+    for (i = 0; i < P384_LIMBS; i++) {
+        t = a[i] - c;
+        c = t > a[i];
+        res[i] = t - b[i];
+        c += res[i] > t;
+    }
+    return c;
+}
+
+/* Modular add: res = a+b mod P */
+static void ecp_nistz384_add(BN_ULONG res[P384_LIMBS],
+                             const BN_ULONG a[P384_LIMBS],
+                             const BN_ULONG b[P384_LIMBS])
+{
+    BN_ULONG t[P384_LIMBS], u[P384_LIMBS], c, borrow;
+
+    c = add_words(t, a, b);
+    borrow = sub_words(u, t, P384);
+    /* a+b is less than P if it did not carry and subtracting P borrowed */
+    copy_conditional(u, t, ~c & borrow & 1);
+    memcpy(res, u, sizeof(u));
+}
+
+/* Modular sub: res = a-b mod P */
+static void ecp_nistz384_sub(BN_ULONG res[P384_LIMBS],
+                             const BN_ULONG a[P384_LIMBS],
+                             const BN_ULONG b[P384_LIMBS])
+{
+    BN_ULONG t[P384_LIMBS], u[P384_LIMBS], borrow;
+
+    borrow = sub_words(t, a, b);
+    add_words(u, t, P384);
+    copy_conditional(t, u, borrow);
+    memcpy(res, t, sizeof(t));
+}
+
+/* Modular neg: res = -a mod P */
+static void ecp_nistz384_neg(BN_ULONG res[P384_LIMBS],
+                             const BN_ULONG a[P384_LIMBS])
+{
+    ecp_nistz384_sub(res, ZERO, a);
+}
+
+/* Modular mul by 2: res = 2*a mod P */
+static void ecp_nistz384_mul_by_2(BN_ULONG res[P384_LIMBS],
+                                  const BN_ULONG a[P384_LIMBS])
+{
+    ecp_nistz384_add(res, a, a);
+}
+
+/* Modular mul by 3: res = 3*a mod P */
+static void ecp_nistz384_mul_by_3(BN_ULONG res[P384_LIMBS],
+                                  const BN_ULONG a[P384_LIMBS])
+{
+    BN_ULONG t[P384_LIMBS];
+
+    ecp_nistz384_add(t, a, a);
+    ecp_nistz384_add(res, t, a);
+}
+
+/* Modular div by 2: res = a/2 mod P */
+static void ecp_nistz384_div_by_2(BN_ULONG res[P384_LIMBS],
+                                  const BN_ULONG a[P384_LIMBS])
+{
+    BN_ULONG t[P384_LIMBS], mask = 0 - (a[0] & 1), c;
+    int i;
+
+    /* add P if a is odd, then shift */
+    for (i = 0; i < P384_LIMBS; i++)
+        t[i] = P384[i] & mask;
+    c = add_words(t, a, t);
+
+    for (i = 0; i < P384_LIMBS - 1; i++)
+        res[i] = (t[i] >> 1) | (t[i + 1] << (BN_BITS2 - 1));
+    res[i] = (t[i] >> 1) | (c << (BN_BITS2 - 1));
+}
+
+/* Convert a number from Montgomery domain, by multiplying with 1 */
+static void ecp_nistz384_from_mont(BN_ULONG res[P384_LIMBS],
+                                   const BN_ULONG in[P384_LIMBS])
+{
+    static const BN_ULONG one[P384_LIMBS] = { 1 };
+
+    ecp_nistz384_mul_mont(res, in, one);
+}
+
+/* r = in^-1 mod p */
+static void ecp_nistz384_mod_inverse(BN_ULONG r[P384_LIMBS],
+                                     const BN_ULONG in[P384_LIMBS])
+{
+    /*
+     * We use FLT and poly-2 as exponent, which is 255 ones, a zero, 32
+     * ones, 64 zeros, 30 ones, a zero and a one. xN below is in raised to
+     * N ones.
+     */
+    BN_ULONG x2[P384_LIMBS], x3[P384_LIMBS], x6[P384_LIMBS];
+    BN_ULONG x12[P384_LIMBS], x15[P384_LIMBS], x30[P384_LIMBS];
+    BN_ULONG x32[P384_LIMBS], t[P384_LIMBS], res[P384_LIMBS];
+
+    ecp_nistz384_sqr_mont(t, in);
+    ecp_nistz384_mul_mont(x2, t, in);
+    ecp_nistz384_sqr_mont(t, x2);
+    ecp_nistz384_mul_mont(x3, t, in);
+    ecp_nistz384_sqr_mont_n(t, x3, 3);
+    ecp_nistz384_mul_mont(x6, t, x3);
+    ecp_nistz384_sqr_mont_n(t, x6, 6);
+    ecp_nistz384_mul_mont(x12, t, x6);
+    ecp_nistz384_sqr_mont_n(t, x12, 3);
+    ecp_nistz384_mul_mont(x15, t, x3);
+    ecp_nistz384_sqr_mont_n(t, x15, 15);
+    ecp_nistz384_mul_mont(x30, t, x15);
+    ecp_nistz384_sqr_mont_n(t, x30, 2);
+    ecp_nistz384_mul_mont(x32, t, x2);
+
+    ecp_nistz384_sqr_mont_n(t, x30, 30);
+    ecp_nistz384_mul_mont(res, t, x30);         /* x60 */
+    ecp_nistz384_sqr_mont_n(t, res, 60);
+    ecp_nistz384_mul_mont(res, t, res);         /* x120 */
+    ecp_nistz384_sqr_mont_n(t, res, 120);
+    ecp_nistz384_mul_mont(res, t, res);         /* x240 */
+    ecp_nistz384_sqr_mont_n(t, res, 15);
+    ecp_nistz384_mul_mont(res, t, x15);         /* x255 */
+
+    ecp_nistz384_sqr_mont_n(t, res, 1 + 32);
+    ecp_nistz384_mul_mont(res, t, x32);
+    ecp_nistz384_sqr_mont_n(t, res, 64 + 30);
+    ecp_nistz384_mul_mont(res, t, x30);
+    ecp_nistz384_sqr_mont_n(t, res, 2);
+    ecp_nistz384_mul_mont(r, t, in);
+}
+
+/*
+ * Points are in Jacobian coordinates, with Z = 0 for the point at infinity.
+ * Affine points from the tables encode infinity as (0,0), which is not on
+ * the curve.
+ */
+
+/* Point double: r = 2*a */
+static void ecp_nistz384_point_double(P384_POINT *r, const P384_POINT *a)
+{
+    BN_ULONG S[P384_LIMBS];
+    BN_ULONG M[P384_LIMBS];
+    BN_ULONG Zsqr[P384_LIMBS];
+    BN_ULONG tmp0[P384_LIMBS];
+
+    const BN_ULONG *in_x = a->X;
+    const BN_ULONG *in_y = a->Y;
+    const BN_ULONG *in_z = a->Z;
+
+    BN_ULONG *res_x = r->X;
+    BN_ULONG *res_y = r->Y;
+    BN_ULONG *res_z = r->Z;
+
+    ecp_nistz384_mul_by_2(S, in_y);
+
+    ecp_nistz384_sqr_mont(Zsqr, in_z);
+
+    ecp_nistz384_sqr_mont(S, S);
+
+    ecp_nistz384_mul_mont(res_z, in_z, in_y);
+    ecp_nistz384_mul_by_2(res_z, res_z);
+
+    ecp_nistz384_add(M, in_x, Zsqr);
+    ecp_nistz384_sub(Zsqr, in_x, Zsqr);
+
+    ecp_nistz384_sqr_mont(res_y, S);
+    ecp_nistz384_div_by_2(res_y, res_y);
+
+    ecp_nistz384_mul_mont(M, M, Zsqr);
+    ecp_nistz384_mul_by_3(M, M);
+
+    ecp_nistz384_mul_mont(S, S, in_x);
+    ecp_nistz384_mul_by_2(tmp0, S);
+
+    ecp_nistz384_sqr_mont(res_x, M);
+
+    ecp_nistz384_sub(res_x, res_x, tmp0);
+    ecp_nistz384_sub(S, S, res_x);
+
+    ecp_nistz384_mul_mont(S, S, M);
+    ecp_nistz384_sub(res_y, S, res_y);
+}
+
+/* Point addition: r = a+b */
+static void ecp_nistz384_point_add(P384_POINT *r,
+                                   const P384_POINT *a, const P384_POINT *b)
+{
+    BN_ULONG U2[P384_LIMBS], S2[P384_LIMBS];
+    BN_ULONG U1[P384_LIMBS], S1[P384_LIMBS];
+    BN_ULONG Z1sqr[P384_LIMBS];
+    BN_ULONG Z2sqr[P384_LIMBS];
+    BN_ULONG H[P384_LIMBS], R[P384_LIMBS];
+    BN_ULONG Hsqr[P384_LIMBS];
+    BN_ULONG Rsqr[P384_LIMBS];
+    BN_ULONG Hcub[P384_LIMBS];
+
+    BN_ULONG res_x[P384_LIMBS];
+    BN_ULONG res_y[P384_LIMBS];
+    BN_ULONG res_z[P384_LIMBS];
+
+    BN_ULONG in1infty, in2infty;
+
+    const BN_ULONG *in1_x = a->X;
+    const BN_ULONG *in1_y = a->Y;
+    const BN_ULONG *in1_z = a->Z;
+
+    const BN_ULONG *in2_x = b->X;
+    const BN_ULONG *in2_y = b->Y;
+    const BN_ULONG *in2_z = b->Z;
+
+    in1infty = is_zero_elem(in1_z);
+    in2infty = is_zero_elem(in2_z);
+
+    ecp_nistz384_sqr_mont(Z2sqr, in2_z);        /* Z2^2 */
+    ecp_nistz384_sqr_mont(Z1sqr, in1_z);        /* Z1^2 */
+
+    ecp_nistz384_mul_mont(S1, Z2sqr, in2_z);    /* S1 = Z2^3 */
+    ecp_nistz384_mul_mont(S2, Z1sqr, in1_z);    /* S2 = Z1^3 */
+
+    ecp_nistz384_mul_mont(S1, S1, in1_y);       /* S1 = Y1*Z2^3 */
+    ecp_nistz384_mul_mont(S2, S2, in2_y);       /* S2 = Y2*Z1^3 */
+    ecp_nistz384_sub(R, S2, S1);                /* R = S2 - S1 */
+
+    ecp_nistz384_mul_mont(U1, in1_x, Z2sqr);    /* U1 = X1*Z2^2 */
+    ecp_nistz384_mul_mont(U2, in2_x, Z1sqr);    /* U2 = X2*Z1^2 */
+    ecp_nistz384_sub(H, U2, U1);                /* H = U2 - U1 */
+
+    /*
+     * This should not happen during sign/ecdh, so no constant time violation
+     */
+    if (is_equal(U1, U2) && !in1infty && !in2infty) {
+        if (is_equal(S1, S2)) {
+            ecp_nistz384_point_double(r, a);
+            return;
+        } else {
+            memset(r, 0, sizeof(*r));
+            return;
+        }
+    }
+
+    ecp_nistz384_sqr_mont(Rsqr, R);             /* R^2 */
+    ecp_nistz384_mul_mont(res_z, H, in1_z);     /* Z3 = H*Z1*Z2 */
+    ecp_nistz384_sqr_mont(Hsqr, H);             /* H^2 */
+    ecp_nistz384_mul_mont(res_z, res_z, in2_z); /* Z3 = H*Z1*Z2 */
+    ecp_nistz384_mul_mont(Hcub, Hsqr, H);       /* H^3 */
+
+    ecp_nistz384_mul_mont(U2, U1, Hsqr);        /* U1*H^2 */
+    ecp_nistz384_mul_by_2(Hsqr, U2);            /* 2*U1*H^2 */
+
+    ecp_nistz384_sub(res_x, Rsqr, Hsqr);
+    ecp_nistz384_sub(res_x, res_x, Hcub);
+
+    ecp_nistz384_sub(res_y, U2, res_x);
+
+    ecp_nistz384_mul_mont(S2, S1, Hcub);
+    ecp_nistz384_mul_mont(res_y, R, res_y);
+    ecp_nistz384_sub(res_y, res_y, S2);
+
+    copy_conditional(res_x, in2_x, in1infty);
+    copy_conditional(res_y, in2_y, in1infty);
+    copy_conditional(res_z, in2_z, in1infty);
+
+    copy_conditional(res_x, in1_x, in2infty);
+    copy_conditional(res_y, in1_y, in2infty);
+    copy_conditional(res_z, in1_z, in2infty);
+
+    memcpy(r->X, res_x, sizeof(res_x));
+    memcpy(r->Y, res_y, sizeof(res_y));
+    memcpy(r->Z, res_z, sizeof(res_z));
+}
+
+/* Point addition when b is known to be affine: r = a+b */
+static void ecp_nistz384_point_add_affine(P384_POINT *r,
+                                          const P384_POINT *a,
+                                          const P384_POINT_AFFINE *b)
+{
+    BN_ULONG U2[P384_LIMBS], S2[P384_LIMBS];
+    BN_ULONG Z1sqr[P384_LIMBS];
+    BN_ULONG H[P384_LIMBS], R[P384_LIMBS];
+    BN_ULONG Hsqr[P384_LIMBS];
+    BN_ULONG Rsqr[P384_LIMBS];
+    BN_ULONG Hcub[P384_LIMBS];
+
+    BN_ULONG res_x[P384_LIMBS];
+    BN_ULONG res_y[P384_LIMBS];
+    BN_ULONG res_z[P384_LIMBS];
+
+    BN_ULONG in1infty, in2infty;
+
+    const BN_ULONG *in1_x = a->X;
+    const BN_ULONG *in1_y = a->Y;
+    const BN_ULONG *in1_z = a->Z;
+
+    const BN_ULONG *in2_x = b->X;
+    const BN_ULONG *in2_y = b->Y;
+
+    in1infty = is_zero_elem(in1_z);
+    in2infty = is_zero_elem(in2_x) & is_zero_elem(in2_y);
+
+    ecp_nistz384_sqr_mont(Z1sqr, in1_z);        /* Z1^2 */
+
+    ecp_nistz384_mul_mont(U2, in2_x, Z1sqr);    /* U2 = X2*Z1^2 */
+    ecp_nistz384_sub(H, U2, in1_x);             /* H = U2 - U1 */
+
+    ecp_nistz384_mul_mont(S2, Z1sqr, in1_z);    /* S2 = Z1^3 */
+
+    ecp_nistz384_mul_mont(res_z, H, in1_z);     /* Z3 = H*Z1*Z2 */
+
+    ecp_nistz384_mul_mont(S2, S2, in2_y);       /* S2 = Y2*Z1^3 */
+    ecp_nistz384_sub(R, S2, in1_y);             /* R = S2 - S1 */
+
+    /*
+     * This should not happen during sign/ecdh, so no constant time violation
+     */
+    if (is_zero_elem(H) && !in1infty && !in2infty) {
+        if (is_zero_elem(R)) {
+            ecp_nistz384_point_double(r, a);
+            return;
+        } else {
+            memset(r, 0, sizeof(*r));
+            return;
+        }
+    }
+
+    ecp_nistz384_sqr_mont(Hsqr, H);             /* H^2 */
+    ecp_nistz384_sqr_mont(Rsqr, R);             /* R^2 */
+    ecp_nistz384_mul_mont(Hcub, Hsqr, H);       /* H^3 */
+
+    ecp_nistz384_mul_mont(U2, in1_x, Hsqr);     /* U1*H^2 */
+    ecp_nistz384_mul_by_2(Hsqr, U2);            /* 2*U1*H^2 */
+
+    ecp_nistz384_sub(res_x, Rsqr, Hsqr);
+    ecp_nistz384_sub(res_x, res_x, Hcub);
+    ecp_nistz384_sub(H, U2, res_x);
+
+    ecp_nistz384_mul_mont(S2, in1_y, Hcub);
+    ecp_nistz384_mul_mont(H, H, R);
+    ecp_nistz384_sub(res_y, H, S2);
+
+    copy_conditional(res_x, in2_x, in1infty);
+    copy_conditional(res_x, in1_x, in2infty);
+
+    copy_conditional(res_y, in2_y, in1infty);
+    copy_conditional(res_y, in1_y, in2infty);
+
+    copy_conditional(res_z, ONE, in1infty);
+    copy_conditional(res_z, in1_z, in2infty);
+
+    memcpy(r->X, res_x, sizeof(res_x));
+    memcpy(r->Y, res_y, sizeof(res_y));
+    memcpy(r->Z, res_z, sizeof(res_z));
+}
+
+/*
+ * Constant time table access: val = in_t[index - 1], or all zeros if
+ * |index| is zero.
+ */
+static void ecp_nistz384_gather_w5(P384_POINT *val,
+                                   const P384_POINT in_t[16], int index)
+{
+    BN_ULONG mask;
+    int i, j;
+
+    memset(val, 0, sizeof(*val));
+    for (i = 0; i < 16; i++) {
+        mask = 0 - is_zero((BN_ULONG)(index ^ (i + 1)));
+        for (j = 0; j < P384_LIMBS; j++) {
+            val->X[j] |= in_t[i].X[j] & mask;
+            val->Y[j] |= in_t[i].Y[j] & mask;
+            val->Z[j] |= in_t[i].Z[j] & mask;
+        }
+    }
+}
+
+static void ecp_nistz384_gather_affine_w5(P384_POINT_AFFINE *val,
+                                          const P384_POINT_AFFINE in_t[16],
+                                          int index)
+{
+    BN_ULONG mask;
+    int i, j;
+
+    memset(val, 0, sizeof(*val));
+    for (i = 0; i < 16; i++) {
+        mask = 0 - is_zero((BN_ULONG)(index ^ (i + 1)));
+        for (j = 0; j < P384_LIMBS; j++) {
+            val->X[j] |= in_t[i].X[j] & mask;
+            val->Y[j] |= in_t[i].Y[j] & mask;
+        }
+    }
+}
+
+static unsigned int _booth_recode_w5(unsigned int in)
+{
+    unsigned int s, d;
+
+    s = ~((in >> 5) - 1);
+    d = (1 << 6) - in - 1;
+    d = (d & s) | (in & ~s);
+    d = (d >> 1) + (d & 1);
+
+    return (d << 1) + (s & 1);
+}
+
+/*
+ * ecp_nistz384_bignum_to_field_elem copies the contents of |in| to |out| and
+ * returns one if it fits. Otherwise it returns zero.
+ */
+__owur static int ecp_nistz384_bignum_to_field_elem(BN_ULONG out[P384_LIMBS],
+                                                    const BIGNUM *in)
+{
+    return bn_copy_words(out, in, P384_LIMBS);
+}
+
+/*
+ * Writes |scalar| reduced modulo the group order to |p_str| in little-endian
+ * order, zero padded to 49 bytes so that every window can be read as two
+ * bytes.
+ */
+__owur static int ecp_nistz384_scalar_to_bytes(const EC_GROUP *group,
+                                               unsigned char p_str[49],
+                                               const BIGNUM *scalar,
+                                               BN_CTX *ctx)
+{
+    int i;
+
+    /* This is an unusual input, we don't guarantee constant-timeness. */
+    if ((BN_num_bits(scalar) > 384) || BN_is_negative(scalar)) {
+        BIGNUM *mod;
+
+        if ((mod = BN_CTX_get(ctx)) == NULL)
+            return 0;
+        if (!BN_nnmod(mod, scalar, group->order, ctx)) {
+            ECerr(EC_F_ECP_NISTZ384_POINTS_MUL, ERR_R_BN_LIB);
+            return 0;
+        }
+        scalar = mod;
+    }
+
+    for (i = 0; i < bn_get_top(scalar) * BN_BYTES; i += BN_BYTES) {
+        BN_ULONG d = bn_get_words(scalar)[i / BN_BYTES];
+
+        p_str[i + 0] = (unsigned char)d;
+        p_str[i + 1] = (unsigned char)(d >> 8);
+        p_str[i + 2] = (unsigned char)(d >> 16);
+        p_str[i + 3] = (unsigned char)(d >>= 24);
+        if (BN_BYTES == 8) {
+            d >>= 8;
+            p_str[i + 4] = (unsigned char)d;
+            p_str[i + 5] = (unsigned char)(d >> 8);
+            p_str[i + 6] = (unsigned char)(d >> 16);
+            p_str[i + 7] = (unsigned char)(d >> 24);
+        }
+    }
+    for (; i < 49; i++)
+        p_str[i] = 0;
+
+    return 1;
+}
+
+/* r = sum(scalar[i]*point[i]) */
+__owur static int ecp_nistz384_windowed_mul(const EC_GROUP *group,
+                                            P384_POINT *r,
+                                            const BIGNUM **scalar,
+                                            const EC_POINT **point,
+                                            size_t num, BN_CTX *ctx)
+{
+    size_t i;
+    int ret = 0;
+    unsigned int idx;
+    unsigned char (*p_str)[49] = NULL;
+    const unsigned int window_size = 5;
+    const unsigned int mask = (1 << (window_size + 1)) - 1;
+    unsigned int wvalue;
+    P384_POINT *temp;           /* place for 5 temporary points */
+    P384_POINT (*table)[16] = NULL;
+
+    if ((num * 16 + 5) > OPENSSL_MALLOC_MAX_NELEMS(P384_POINT)
+        || (table = OPENSSL_malloc((num * 16 + 5) * sizeof(P384_POINT)))
+           == NULL
+        || (p_str = OPENSSL_malloc(num * 49 * sizeof(unsigned char)))
+           == NULL) {
+        ECerr(EC_F_ECP_NISTZ384_WINDOWED_MUL, ERR_R_MALLOC_FAILURE);
+        goto err;
+    }
+
+    temp = (P384_POINT *)(table + num);
+
+    for (i = 0; i < num; i++) {
+        P384_POINT *row = table[i];
+
+        if (!ecp_nistz384_scalar_to_bytes(group, p_str[i], scalar[i], ctx))
+            goto err;
+
+        if (!ecp_nistz384_bignum_to_field_elem(temp[0].X, point[i]->X)
+            || !ecp_nistz384_bignum_to_field_elem(temp[0].Y, point[i]->Y)
+            || !ecp_nistz384_bignum_to_field_elem(temp[0].Z, point[i]->Z)) {
+            ECerr(EC_F_ECP_NISTZ384_WINDOWED_MUL,
+                  EC_R_COORDINATES_OUT_OF_RANGE);
+            goto err;
+        }
+
+        /*
+         * row[0] is implicitly (0,0,0) (the point at infinity), therefore it
+         * is not stored. All other values are actually stored with an offset
+         * of -1 in table.
+         */
+
+        row[0] = temp[0];
+        ecp_nistz384_point_double(&row[1], &row[0]);                 /* 2 */
+        ecp_nistz384_point_add   (&row[2], &row[1], &row[0]);        /* 3 */
+        ecp_nistz384_point_double(&row[3], &row[1]);                 /* 4 */
+        ecp_nistz384_point_add   (&row[4], &row[3], &row[0]);        /* 5 */
+        ecp_nistz384_point_double(&row[5], &row[2]);                 /* 6 */
+        ecp_nistz384_point_add   (&row[6], &row[5], &row[0]);        /* 7 */
+        ecp_nistz384_point_double(&row[7], &row[3]);                 /* 8 */
+        ecp_nistz384_point_add   (&row[8], &row[7], &row[0]);        /* 9 */
+        ecp_nistz384_point_double(&row[9], &row[4]);                 /* 10 */
+        ecp_nistz384_point_add   (&row[10], &row[9], &row[0]);       /* 11 */
+        ecp_nistz384_point_double(&row[11], &row[5]);                /* 12 */
+        ecp_nistz384_point_add   (&row[12], &row[11], &row[0]);      /* 13 */
+        ecp_nistz384_point_double(&row[13], &row[6]);                /* 14 */
+        ecp_nistz384_point_add   (&row[14], &row[13], &row[0]);      /* 15 */
+        ecp_nistz384_point_double(&row[15], &row[7]);                /* 16 */
+    }
+
+    /*
+     * The top window covers bits 379 to 384 and, as the scalars are less
+     * than 2^384, is never negative.
+     */
+    idx = 380;
+
+    wvalue = p_str[0][(idx - 1) / 8] | p_str[0][(idx - 1) / 8 + 1] << 8;
+    wvalue = (wvalue >> ((idx - 1) % 8)) & mask;
+
+    ecp_nistz384_gather_w5(r, table[0], _booth_recode_w5(wvalue) >> 1);
+
+    while (idx >= 5) {
+        for (i = (idx == 380 ? 1 : 0); i < num; i++) {
+            unsigned int off = (idx - 1) / 8;
+
+            wvalue = p_str[i][off] | p_str[i][off + 1] << 8;
+            wvalue = (wvalue >> ((idx - 1) % 8)) & mask;
+
+            wvalue = _booth_recode_w5(wvalue);
+
+            ecp_nistz384_gather_w5(&temp[0], table[i], wvalue >> 1);
+
+            ecp_nistz384_neg(temp[1].Y, temp[0].Y);
+            copy_conditional(temp[0].Y, temp[1].Y, (wvalue & 1));
+
+            ecp_nistz384_point_add(r, r, &temp[0]);
+        }
+
+        idx -= window_size;
+
+        ecp_nistz384_point_double(r, r);
+        ecp_nistz384_point_double(r, r);
+        ecp_nistz384_point_double(r, r);
+        ecp_nistz384_point_double(r, r);
+        ecp_nistz384_point_double(r, r);
+    }
+
+    /* Final window */
+    for (i = 0; i < num; i++) {
+        wvalue = p_str[i][0];
+        wvalue = (wvalue << 1) & mask;
+
+        wvalue = _booth_recode_w5(wvalue);
+
+        ecp_nistz384_gather_w5(&temp[0], table[i], wvalue >> 1);
+
+        ecp_nistz384_neg(temp[1].Y, temp[0].Y);
+        copy_conditional(temp[0].Y, temp[1].Y, wvalue & 1);
+
+        ecp_nistz384_point_add(r, r, &temp[0]);
+    }
+
+    ret = 1;
+ err:
+    OPENSSL_clear_free(table, (num * 16 + 5) * sizeof(P384_POINT));
+    OPENSSL_clear_free(p_str, num * 49 * sizeof(unsigned char));
+    return ret;
+}
+
+/*
+ * Number of points from which ecp_nistz384_points_mul() uses the bucket
+ * method instead of ecp_nistz384_windowed_mul()
+ */
+#define ECP_NISTZ384_PIPPENGER_MIN_POINTS 64
+
+/*
+ * r = sum(scalar[i]*point[i]) with the bucket method, see ec_pippenger_mul().
+ * Not constant-time, like ecp_nistz256_pippenger_mul().
+ */
+__owur static int ecp_nistz384_pippenger_mul(const EC_GROUP *group,
+                                             P384_POINT *r,
+                                             const BIGNUM **scalar,
+                                             const EC_POINT **point,
+                                             size_t num, BN_CTX *ctx)
+{
+    size_t i, j, w, numwin, numbuckets;
+    int d, b, top, r_is_infinity = 1, ret = 0;
+    unsigned char p_str[49];
+    int *digits = NULL;
+    unsigned char *used = NULL;
+    P384_POINT *val = NULL, *bucket = NULL;
+    const P384_POINT *in;
+    P384_POINT sum, neg;
+
+    w = ec_pippenger_window_size(num, 384);
+    numwin = (384 + w) / w;
+    numbuckets = (size_t)1 << (w - 1);
+
+    if (num > OPENSSL_MALLOC_MAX_NELEMS(P384_POINT)
+        || num > OPENSSL_MALLOC_MAX_NELEMS(int) / numwin
+        || (val = OPENSSL_malloc(num * sizeof(P384_POINT))) == NULL
+        || (bucket = OPENSSL_malloc(numbuckets * sizeof(P384_POINT))) == NULL
+        || (used = OPENSSL_malloc(numbuckets)) == NULL
+        || (digits = OPENSSL_malloc(num * numwin * sizeof(int))) == NULL) {
+        ECerr(EC_F_ECP_NISTZ384_PIPPENGER_MUL, ERR_R_MALLOC_FAILURE);
+        goto err;
+    }
+
+    for (i = 0; i < num; i++) {
+        if (!ecp_nistz384_scalar_to_bytes(group, p_str, scalar[i], ctx))
+            goto err;
+        ec_pippenger_recode(digits + i * numwin, p_str, sizeof(p_str), w,
+                            numwin);
+
+        if (!ecp_nistz384_bignum_to_field_elem(val[i].X, point[i]->X)
+            || !ecp_nistz384_bignum_to_field_elem(val[i].Y, point[i]->Y)
+            || !ecp_nistz384_bignum_to_field_elem(val[i].Z, point[i]->Z)) {
+            ECerr(EC_F_ECP_NISTZ384_PIPPENGER_MUL,
+                  EC_R_COORDINATES_OUT_OF_RANGE);
+            goto err;
+        }
+    }
+
+    memset(r, 0, sizeof(*r));
+    for (i = numwin; i-- > 0;) {
+        if (!r_is_infinity) {
+            for (j = 0; j < w; j++)
+                ecp_nistz384_point_double(r, r);
+        }
+
+        memset(used, 0, numbuckets);
+        top = -1;
+        for (j = 0; j < num; j++) {
+            d = digits[j * numwin + i];
+            if (d == 0)
+                continue;
+            in = &val[j];
+            if (d < 0) {
+                memcpy(neg.X, in->X, sizeof(neg.X));
+                ecp_nistz384_neg(neg.Y, in->Y);
+                memcpy(neg.Z, in->Z, sizeof(neg.Z));
+                in = &neg;
+                d = -d;
+            }
+            b = d - 1;
+            if (used[b]) {
+                ecp_nistz384_point_add(&bucket[b], &bucket[b], in);
+            } else {
+                bucket[b] = *in;
+                used[b] = 1;
+                if (b > top)
+                    top = b;
+            }
+        }
+        if (top < 0)
+            continue;
+
+        /* r += sum((b+1)*bucket[b]), summing the buckets top down */
+        sum = bucket[top];
+        for (b = top; b >= 0; b--) {
+            if (b < top && used[b])
+                ecp_nistz384_point_add(&sum, &sum, &bucket[b]);
+            if (r_is_infinity)
+                *r = sum;
+            else
+                ecp_nistz384_point_add(r, r, &sum);
+            r_is_infinity = 0;
+        }
+    }
+
+    ret = 1;
+ err:
+    OPENSSL_free(val);
+    OPENSSL_free(bucket);
+    OPENSSL_free(used);
+    OPENSSL_free(digits);
+    return ret;
+}
+
+/* r = scalar*G with the precomputed table for the default generator */
+__owur static int ecp_nistz384_mul_g(const EC_GROUP *group, P384_POINT *r,
+                                     const BIGNUM *scalar, BN_CTX *ctx)
+{
+    const PRECOMP384_ROW *table =
+        (const PRECOMP384_ROW *)ecp_nistz384_precomputed;
+    unsigned char p_str[49];
+    unsigned int idx = 0;
+    const unsigned int window_size = 5;
+    const unsigned int mask = (1 << (window_size + 1)) - 1;
+    unsigned int wvalue;
+    P384_POINT_AFFINE t;
+    BN_ULONG neg[P384_LIMBS], infty;
+    int i;
+
+    if (!ecp_nistz384_scalar_to_bytes(group, p_str, scalar, ctx))
+        return 0;
+
+    /* First window */
+    wvalue = (p_str[0] << 1) & mask;
+    idx += window_size;
+
+    wvalue = _booth_recode_w5(wvalue);
+
+    ecp_nistz384_gather_affine_w5(&t, table[0], wvalue >> 1);
+
+    ecp_nistz384_neg(neg, t.Y);
+    copy_conditional(t.Y, neg, wvalue & 1);
+
+    memcpy(r->X, t.X, sizeof(r->X));
+    memcpy(r->Y, t.Y, sizeof(r->Y));
+    /* (0,0) from the table is infinity, for which Z has to be zero */
+    infty = is_zero_elem(t.X) & is_zero_elem(t.Y);
+    memcpy(r->Z, ONE, sizeof(r->Z));
+    copy_conditional(r->Z, ZERO, infty);
+
+    for (i = 1; i < 77; i++) {
+        unsigned int off = (idx - 1) / 8;
+        wvalue = p_str[off] | p_str[off + 1] << 8;
+        wvalue = (wvalue >> ((idx - 1) % 8)) & mask;
+        idx += window_size;
+
+        wvalue = _booth_recode_w5(wvalue);
+
+        ecp_nistz384_gather_affine_w5(&t, table[i], wvalue >> 1);
+
+        ecp_nistz384_neg(neg, t.Y);
+        copy_conditional(t.Y, neg, wvalue & 1);
+
+        ecp_nistz384_point_add_affine(r, r, &t);
+    }
+
+    OPENSSL_cleanse(p_str, sizeof(p_str));
+    return 1;
+}
+
+/*
+ * ecp_nistz384_is_affine_G returns one if |generator| is the standard, P-384
+ * generator.
+ */
+static int ecp_nistz384_is_affine_G(const EC_POINT *generator)
+{
+    const P384_POINT_AFFINE *G =
+        (const P384_POINT_AFFINE *)ecp_nistz384_precomputed[0];
+
+    return (bn_get_top(generator->X) == P384_LIMBS) &&
+        (bn_get_top(generator->Y) == P384_LIMBS) &&
+        is_equal(bn_get_words(generator->X), G->X) &&
+        is_equal(bn_get_words(generator->Y), G->Y) &&
+        generator->Z_is_one;
+}
+
+/* r = scalar*G + sum(scalars[i]*points[i]) */
+__owur static int ecp_nistz384_points_mul(const EC_GROUP *group,
+                                          EC_POINT *r,
+                                          const BIGNUM *scalar,
+                                          size_t num,
+                                          const EC_POINT *points[],
+                                          const BIGNUM *scalars[], BN_CTX *ctx)
+{
+    int ret = 0, p_is_infinity = 1;
+    size_t j;
+    const EC_POINT *generator = NULL;
+    BN_CTX *new_ctx = NULL;
+    const BIGNUM **new_scalars = NULL;
+    const EC_POINT **new_points = NULL;
+    P384_POINT p, t;
+
+    if ((num + 1) == 0 || (num + 1) > OPENSSL_MALLOC_MAX_NELEMS(void *)) {
+        ECerr(EC_F_ECP_NISTZ384_POINTS_MUL, ERR_R_MALLOC_FAILURE);
+        return 0;
+    }
+
+    if (group->meth != r->meth) {
+        ECerr(EC_F_ECP_NISTZ384_POINTS_MUL, EC_R_INCOMPATIBLE_OBJECTS);
+        return 0;
+    }
+
+    if ((scalar == NULL) && (num == 0))
+        return EC_POINT_set_to_infinity(group, r);
+
+    for (j = 0; j < num; j++) {
+        if (group->meth != points[j]->meth) {
+            ECerr(EC_F_ECP_NISTZ384_POINTS_MUL, EC_R_INCOMPATIBLE_OBJECTS);
+            return 0;
+        }
+    }
+
+    if (ctx == NULL) {
+        ctx = new_ctx = BN_CTX_new();
+        if (ctx == NULL)
+            goto err;
+    }
+
+    BN_CTX_start(ctx);
+
+    if (scalar) {
+        generator = EC_GROUP_get0_generator(group);
+        if (generator == NULL) {
+            ECerr(EC_F_ECP_NISTZ384_POINTS_MUL, EC_R_UNDEFINED_GENERATOR);
+            goto err;
+        }
+
+        if (ecp_nistz384_is_affine_G(generator)) {
+            if (!ecp_nistz384_mul_g(group, &p, scalar, ctx))
+                goto err;
+            p_is_infinity = 0;
+        } else {
+            /*
+             * Without a precomputed table for the generator, it has to be
+             * handled like a normal point.
+             */
+            new_scalars = OPENSSL_malloc((num + 1) * sizeof(BIGNUM *));
+            new_points = OPENSSL_malloc((num + 1) * sizeof(EC_POINT *));
+            if (new_scalars == NULL || new_points == NULL) {
+                ECerr(EC_F_ECP_NISTZ384_POINTS_MUL, ERR_R_MALLOC_FAILURE);
+                goto err;
+            }
+
+            memcpy(new_scalars, scalars, num * sizeof(BIGNUM *));
+            new_scalars[num] = scalar;
+            memcpy(new_points, points, num * sizeof(EC_POINT *));
+            new_points[num] = generator;
+
+            scalars = new_scalars;
+            points = new_points;
+            num++;
+        }
+    }
+
+    if (num) {
+        P384_POINT *out = &t;
+        if (p_is_infinity)
+            out = &p;
+
+        if (num >= ECP_NISTZ384_PIPPENGER_MIN_POINTS) {
+            if (!ecp_nistz384_pippenger_mul(group, out, scalars, points, num,
+                                            ctx))
+                goto err;
+        } else if (!ecp_nistz384_windowed_mul(group, out, scalars, points,
+                                              num, ctx)) {
+            goto err;
+        }
+
+        if (!p_is_infinity)
+            ecp_nistz384_point_add(&p, &p, out);
+    }
+
+    /* Not constant-time, but we're only operating on the public output. */
+    if (!bn_set_words(r->X, p.X, P384_LIMBS) ||
+        !bn_set_words(r->Y, p.Y, P384_LIMBS) ||
+        !bn_set_words(r->Z, p.Z, P384_LIMBS)) {
+        goto err;
+    }
+    r->Z_is_one = is_equal(p.Z, ONE) & 1;
+
+    ret = 1;
+
+err:
+    if (ctx)
+        BN_CTX_end(ctx);
+    BN_CTX_free(new_ctx);
+    OPENSSL_free(new_points);
+    OPENSSL_free(new_scalars);
+    return ret;
+}
+
+__owur static int ecp_nistz384_get_affine(const EC_GROUP *group,
+                                          const EC_POINT *point,
+                                          BIGNUM *x, BIGNUM *y, BN_CTX *ctx)
+{
+    BN_ULONG z_inv2[P384_LIMBS];
+    BN_ULONG z_inv3[P384_LIMBS];
+    BN_ULONG x_aff[P384_LIMBS];
+    BN_ULONG y_aff[P384_LIMBS];
+    BN_ULONG point_x[P384_LIMBS], point_y[P384_LIMBS], point_z[P384_LIMBS];
+    BN_ULONG x_ret[P384_LIMBS], y_ret[P384_LIMBS];
+
+    if (EC_POINT_is_at_infinity(group, point)) {
+        ECerr(EC_F_ECP_NISTZ384_GET_AFFINE, EC_R_POINT_AT_INFINITY);
+        return 0;
+    }
+
+    if (!ecp_nistz384_bignum_to_field_elem(point_x, point->X) ||
+        !ecp_nistz384_bignum_to_field_elem(point_y, point->Y) ||
+        !ecp_nistz384_bignum_to_field_elem(point_z, point->Z)) {
+        ECerr(EC_F_ECP_NISTZ384_GET_AFFINE, EC_R_COORDINATES_OUT_OF_RANGE);
+        return 0;
+    }
+
+    ecp_nistz384_mod_inverse(z_inv3, point_z);
+    ecp_nistz384_sqr_mont(z_inv2, z_inv3);
+    ecp_nistz384_mul_mont(x_aff, z_inv2, point_x);
+
+    if (x != NULL) {
+        ecp_nistz384_from_mont(x_ret, x_aff);
+        if (!bn_set_words(x, x_ret, P384_LIMBS))
+            return 0;
+    }
+
+    if (y != NULL) {
+        ecp_nistz384_mul_mont(z_inv3, z_inv3, z_inv2);
+        ecp_nistz384_mul_mont(y_aff, z_inv3, point_y);
+        ecp_nistz384_from_mont(y_ret, y_aff);
+        if (!bn_set_words(y, y_ret, P384_LIMBS))
+            return 0;
+    }
+
+    return 1;
+}
+
+static int ecp_nistz384_window_have_precompute_mult(const EC_GROUP *group)
+{
+    /* There is a hard-coded table for the default generator. */
+    const EC_POINT *generator = EC_GROUP_get0_generator(group);
+
+    return generator != NULL && ecp_nistz384_is_affine_G(generator);
+}
+
+const EC_METHOD *EC_GFp_nistz384_method(void)
+{
+    static const EC_METHOD ret = {
+        EC_FLAGS_DEFAULT_OCT,
+        NID_X9_62_prime_field,
+        ec_GFp_mont_group_init,
+        ec_GFp_mont_group_finish,
+        ec_GFp_mont_group_clear_finish,
+        ec_GFp_mont_group_copy,
+        ec_GFp_mont_group_set_curve,
+        ec_GFp_simple_group_get_curve,
+        ec_GFp_simple_group_get_degree,
+        ec_group_simple_order_bits,
+        ec_GFp_simple_group_check_discriminant,
+        ec_GFp_simple_point_init,
+        ec_GFp_simple_point_finish,
+        ec_GFp_simple_point_clear_finish,
+        ec_GFp_simple_point_copy,
+        ec_GFp_simple_point_set_to_infinity,
+        ec_GFp_simple_set_Jprojective_coordinates_GFp,
+        ec_GFp_simple_get_Jprojective_coordinates_GFp,
+        ec_GFp_simple_point_set_affine_coordinates,
+        ecp_nistz384_get_affine,
+        0, 0, 0,
+        ec_GFp_simple_add,
+        ec_GFp_simple_dbl,
+        ec_GFp_simple_invert,
+        ec_GFp_simple_is_at_infinity,
+        ec_GFp_simple_is_on_curve,
+        ec_GFp_simple_cmp,
+        ec_GFp_simple_make_affine,
+        ec_GFp_simple_points_make_affine,
+        ecp_nistz384_points_mul,                    /* mul */
+        0,                                          /* precompute_mult */
+        ecp_nistz384_window_have_precompute_mult,   /* have_precompute_mult */
+        ec_GFp_mont_field_mul,
+        ec_GFp_mont_field_sqr,
+        0,                                          /* field_div */
+        ec_GFp_mont_field_encode,
+        ec_GFp_mont_field_decode,
+        ec_GFp_mont_field_set_to_one,
+        ec_key_simple_priv2oct,
+        ec_key_simple_oct2priv,
+        0, /* set private */
+        ec_key_simple_generate_key,
+        ec_key_simple_check_key,
+        ec_key_simple_generate_public_key,
+        0, /* keycopy */
+        0, /* keyfinish */
+        ecdh_simple_compute_key
+    };
+
+    return &ret;
+}
@@ -0,0 +1,7418 @@
+/*
+ * Copyright 2016 The OpenSSL Project Authors. All Rights Reserved.
+ *
+ * Licensed under the OpenSSL license (the "License").  You may not use
+ * this file except in compliance with the License.  You can obtain a copy
+ * in the file LICENSE in the source distribution or at
+ * https://www.openssl.org/source/license.html
+ */
+
+/*
+ * This is the precomputed constant time access table for the code in
+ * ecp_nistz384.c, for the default generator. The table consists of 77
+ * subtables, each subtable contains 16 affine points. The affine points are
+ * encoded as twelve uint64's, six for the x coordinate and six for the y,
+ * both in the Montgomery domain and in little-endian order. Subtable i holds
+ * 1 to 16 times 2^(5*i)*G. There are 77 tables because a signed, 4-bit
+ * wNAF form of the scalar is used and ceil(384/(4 + 1)) = 77. Within each
+ * table there are 16 values because the 4-bit wNAF value can take 16 values,
+ * ignoring the sign bit, which is implemented by performing a negation of
+ * the affine point when required.
+ */
+
+static const BN_ULONG ecp_nistz384_precomputed[77][16 *
+                                                   sizeof(P384_POINT_AFFINE) /
+                                                   sizeof(BN_ULONG)] = {
+    {TOBN(0x3dd07566, 0x49c0b528), TOBN(0x20e378e2, 0xa0d6ce38),
+     TOBN(0x879c3afc, 0x541b4d6e), TOBN(0x64548684, 0x59a30eff),
+     TOBN(0x812ff723, 0x614ede2b), TOBN(0x4d3aadc2, 0x299e1513),
+     TOBN(0x23043dad, 0x4b03a4fe), TOBN(0xa1bfa8bf, 0x7bb4a9ac),
+     TOBN(0x8bade756, 0x2e83b050), TOBN(0xc6c35219, 0x68f4ffd9),
+     TOBN(0xdd800226, 0x3969a840), TOBN(0x2b78abc2, 0x5a15c5e9),
+     TOBN(0xc8229e55, 0x783dde91), TOBN(0x8e6c8f2e, 0x022b53f0),
+     TOBN(0x3504e6f0, 0xff9d48a1), TOBN(0xda821495, 0xf0687f50),
+     TOBN(0x9c90a4fd, 0x2de4b506), TOBN(0xdb93b776, 0x427460c3),
+     TOBN(0x42ea8463, 0x3140bfda), TOBN(0xe8e8e4a8, 0xc2aaccd8),
+     TOBN(0x15e4f18b, 0xdc588258), TOBN(0x09f1fe41, 0x5172bad9),
+     TOBN(0x070d4309, 0x00b0e684), TOBN(0xe34947f7, 0x123df0c2),
+     TOBN(0x05e4dbe6, 0xc1dc4073), TOBN(0xc54ea9ff, 0xf04f779c),
+     TOBN(0x6b2034e9, 0xa170ccf0), TOBN(0x3a48d732, 0xd51c6c3e),
+     TOBN(0xe36f7e2d, 0x263aa470), TOBN(0xd283fe68, 0xe7c1c3ac),
+     TOBN(0x7e284821, 0xc04ee157), TOBN(0x92d789a7, 0x7ae0e36d),
+     TOBN(0x132663c0, 0x4ef67446), TOBN(0x68012d5a, 0xd2e1d0b4),
+     TOBN(0xf6db68b1, 0x5102b339), TOBN(0x465465fc, 0x983292af),
+     TOBN(0x0aae8477, 0xebb68f2c), TOBN(0x30594ccb, 0xee0421e3),
+     TOBN(0x2e4f153b, 0x0aecac46), TOBN(0x078358d4, 0x736400ad),
+     TOBN(0xfb40f647, 0xd685d979), TOBN(0xcfeee6dd, 0x34179228),
+     TOBN(0x54f3e8e7, 0x9b3a03b2), TOBN(0xe74bb7f1, 0x7bfec97e),
+     TOBN(0x8e3e61a3, 0x4c542ad1), TOBN(0x147162d3, 0x0418c693),
+     TOBN(0xe607b9e3, 0x3820017d), TOBN(0x50946875, 0x303df319),
+     TOBN(0xbb595eba, 0x68f1f0df), TOBN(0xc185c0cb, 0xcc873466),
+     TOBN(0x7f1eb1b5, 0x293c703b), TOBN(0x60db2cf5, 0xaacc05e6),
+     TOBN(0xc676b987, 0xe2e8e4c6), TOBN(0xe1bb26b1, 0x1d178ffb),
+     TOBN(0x2b694ba0, 0x7073fa21), TOBN(0x22c16e2e, 0x72f34566),
+     TOBN(0x80b61b31, 0x01c35b99), TOBN(0x4b237faf, 0x982c0411),
+     TOBN(0xe6c59440, 0x24de236d), TOBN(0x4db1c9d6, 0xe209e4a3),
+     TOBN(0x7eb5c931, 0x7d56dad8), TOBN(0xcb2454b3, 0x39d3413a),
+     TOBN(0xec52930f, 0x580d57f2), TOBN(0x2a33f666, 0x1bdf6015),
+     TOBN(0x4f0f6a96, 0x2b02d33b), TOBN(0xc482e189, 0xf0430c40),
+     TOBN(0x3f62b16e, 0xa7b08203), TOBN(0x739ac69d, 0x5b3d4dce),
+     TOBN(0x8bd4bffc, 0xb79e33b0), TOBN(0x93c9e5f6, 0x1b546f05),
+     TOBN(0x586d8ede, 0xdf21559a), TOBN(0xc9962152, 0xaf2a9eba),
+     TOBN(0xdf13b9d1, 0x7d69222b), TOBN(0x4ce6415f, 0x874774b1),
+     TOBN(0x731edcf8, 0x211faa95), TOBN(0x5f4215d1, 0x659753ed),
+     TOBN(0xf893db58, 0x9db2df55), TOBN(0x932c9f81, 0x1c89025b),
+     TOBN(0x0996b220, 0x7706a61e), TOBN(0x135349d5, 0xa8641c79),
+     TOBN(0x65aad76f, 0x50130844), TOBN(0x0ff37c04, 0x01fff780),
+     TOBN(0xf57f238e, 0x693b0706), TOBN(0xd90a16b6, 0xaf6c9b3e),
+     TOBN(0x23f60a05, 0xdd9bcbba), TOBN(0x9e336de5, 0xae9b587a),
+     TOBN(0x1c5c2e71, 0x93d7e30f), TOBN(0x1d9aebd6, 0x4f3ddb37),
+     TOBN(0x1c7b5fe1, 0x16b66423), TOBN(0x5db4f184, 0x349cd9b1),
+     TOBN(0x0d2cfe83, 0xe6655a44), TOBN(0x836dbb36, 0xb7e55e87),
+     TOBN(0x701754bf, 0x7d8686e4), TOBN(0xe9923263, 0xa42dbba2),
+     TOBN(0x7008d943, 0xc48ecf0e), TOBN(0x3c0c6dd7, 0x0d27ef61),
+     TOBN(0x2f5d200e, 0x2353b92f), TOBN(0xe35d8729, 0x3fd7e4f9),
+     TOBN(0x26094833, 0xa96d745d), TOBN(0xdc351dc1, 0x3cbfff3f),
+     TOBN(0x26d464c6, 0xdad54d6a), TOBN(0x5cab1d1d, 0x53636c6a),
+     TOBN(0xf2813072, 0xb18ec0b0), TOBN(0x3777e270, 0xd742aa2f),
+     TOBN(0x27f061c7, 0x033ca7c2), TOBN(0xa6ecaccc, 0x68ead0d8),
+     TOBN(0x7d9429f4, 0xee69a754), TOBN(0xe7706334, 0x31e8f5c6),
+     TOBN(0x845539d3, 0xc8d99c02), TOBN(0x2a15a9a6, 0xe58d6787),
+     TOBN(0xe9f6368e, 0xab225fa3), TOBN(0x54a612d7, 0xeb32cabe),
+     TOBN(0xc2f64602, 0x5c4845ec), TOBN(0xa91a5280, 0xdb1c212e),
+     TOBN(0xbb971f78, 0xe67b5fce), TOBN(0x03a530eb, 0x13b9e85c),
+     TOBN(0x592ac0ba, 0x794eabfd), TOBN(0x81961b8c, 0xcfd7fd1d),
+     TOBN(0x3e03370a, 0x47a9b8aa), TOBN(0x6eb995be, 0xc80174e8),
+     TOBN(0xc7708b19, 0xb68b8c7d), TOBN(0x4532077c, 0x44377aba),
+     TOBN(0x0dcc6770, 0x6cdad64f), TOBN(0x01b8bf56, 0x147b6602),
+     TOBN(0xf8d89885, 0xf0561d79), TOBN(0x9c19e9fc, 0x7ba9c437),
+     TOBN(0x764eb146, 0xbdc4ba25), TOBN(0x604fe46b, 0xac144b83),
+     TOBN(0x3ce81329, 0x8a77e780), TOBN(0x2e070f36, 0xfe9e682e),
+     TOBN(0x41821d0c, 0x3a53287a), TOBN(0x9aa62f9f, 0x3533f918),
+     TOBN(0x3db84772, 0x70313de0), TOBN(0xd4258cc5, 0x5d970420),
+     TOBN(0x03aced26, 0xc8edfee1), TOBN(0xf67eb422, 0x35d77d83),
+     TOBN(0x523c40db, 0xcf9ab45c), TOBN(0x627b415f, 0x9c35b26d),
+     TOBN(0xfacc45e4, 0x8be55ed8), TOBN(0x80d60af6, 0x27aa651a),
+     TOBN(0x8c79848f, 0xd0e102ac), TOBN(0x40c64a4e, 0x66bed5af),
+     TOBN(0x0329eab1, 0xf7942f0e), TOBN(0x0c6e430e, 0xf9c4af3d),
+     TOBN(0x9b7aeb7e, 0x75ccbdfb), TOBN(0xb25e28c5, 0xf6749a95),
+     TOBN(0x8a7a8e46, 0x33b7d4ae), TOBN(0xdb5203a8, 0xd9c1bd56),
+     TOBN(0xd2657265, 0xed22df97), TOBN(0xb51c56e1, 0x8cf23c94),
+     TOBN(0xf4d39459, 0x6c3d812d), TOBN(0xd8e88f1a, 0x87cae0c2),
+     TOBN(0x789a2a48, 0xcf4d0fe3), TOBN(0xb7feac2d, 0xfec38d60),
+     TOBN(0x81fdbd1c, 0x3b490ec3), TOBN(0x4617adb7, 0xcc6979e1),
+     TOBN(0x5865e501, 0x8f75244c), TOBN(0xd02225fb, 0x01ec909f),
+     TOBN(0xca6b1af8, 0xb1f85c2a), TOBN(0x44ce05ff, 0x88957166),
+     TOBN(0x8058994c, 0x5710c0c9), TOBN(0x46d227c4, 0x32f6b1ba),
+     TOBN(0xbe4b4a90, 0x03cb68e5), TOBN(0x540b8b82, 0x730a99d1),
+     TOBN(0x1ecc8585, 0xe11dbbbf), TOBN(0x72445345, 0xd9c3b691),
+     TOBN(0x647d24db, 0x13690a74), TOBN(0x4429839d, 0xdefbadf5),
+     TOBN(0x446ad888, 0x4709f4a9), TOBN(0x2b7210e2, 0xec3dabd8),
+     TOBN(0x83ccf195, 0x50e07b34), TOBN(0x59500917, 0x789b3075),
+     TOBN(0x0fc01fd4, 0xeb085993), TOBN(0xfb62d26f, 0x4903026b),
+     TOBN(0x2309cc9d, 0x6fe989bb), TOBN(0x61609cbd, 0x144bd586),
+     TOBN(0x4b23d3a0, 0xde06610c), TOBN(0xdddc2866, 0xd898f470),
+     TOBN(0x8733fc41, 0x400c5797), TOBN(0x5a68c6fe, 0xd0bc2716),
+     TOBN(0xda6e8a7f, 0x7c33ed91), TOBN(0x992afb5b, 0x0ecdd2d8),
+     TOBN(0x37cf6551, 0x7917652a), TOBN(0x317b63ea, 0x2887d5ff),
+     TOBN(0x37065f53, 0x13bdc3fa), TOBN(0xa10896aa, 0x435abaa1),
+     TOBN(0x9b21615f, 0xefabca26), TOBN(0xeb07ddea, 0x230cf00d),
+     TOBN(0x914871dc, 0x154d410f), TOBN(0xb333bdfb, 0xc88ee148),
+     TOBN(0x51c305c6, 0xa72d1967), TOBN(0x659db481, 0x81ef2513)},
+    {TOBN(0xad852b87, 0x8c0a64a4), TOBN(0x0d784cf2, 0x08f779d5),
+     TOBN(0x1896b9fc, 0xc651b1dd), TOBN(0xba8953d6, 0x12e8dc87),
+     TOBN(0x3a9865ba, 0xa631cfb0), TOBN(0x5dd2a4a0, 0x626b3d79),
+     TOBN(0x1148bc72, 0x687c20bb), TOBN(0xa372dfc2, 0xf2a52bfd),
+     TOBN(0x77315f9e, 0x9448fd08), TOBN(0x4bcb06f0, 0x0a2377b6),
+     TOBN(0x73b42725, 0xb35b4ff0), TOBN(0xc510ad93, 0xaabca99f),
+     TOBN(0xed4de4f8, 0x8e89b258), TOBN(0x957c980f, 0x297a9a37),
+     TOBN(0xe04b3d30, 0xf8a0580d), TOBN(0xa309199d, 0xca57b7bd),
+     TOBN(0xfc8e87cf, 0x3be44d56), TOBN(0x4f5d5ab6, 0xd1b30e5c),
+     TOBN(0xb213c6a0, 0x30a9325b), TOBN(0x0fd1c52d, 0xf091bc01),
+     TOBN(0xfe51bbbf, 0x1090fede), TOBN(0x6d97cabc, 0x301fe259),
+     TOBN(0x3ee12789, 0x5ecd3fe8), TOBN(0x888b708b, 0x9404ca51),
+     TOBN(0xdc529385, 0x1d15bba7), TOBN(0x8fd61e31, 0x148840d4),
+     TOBN(0xee21597e, 0x52ce08f6), TOBN(0x26de4c65, 0x81998af2),
+     TOBN(0xcb4aa43c, 0x9741eb42), TOBN(0x8bf3dccc, 0x39c18b96),
+     TOBN(0x66e1d5da, 0xd872984e), TOBN(0x507e2405, 0x7dd87c39),
+     TOBN(0x8545396f, 0x305ee4f0), TOBN(0xf9d19ea0, 0xc831254b),
+     TOBN(0xcee0842f, 0x5d5680b8), TOBN(0xb257fb6c, 0x5a4434a4),
+     TOBN(0xe484fd9f, 0x8258030f), TOBN(0x0f4fa5ef, 0xf21af80a),
+     TOBN(0xc0dd449e, 0x7c1c3984), TOBN(0xf3133891, 0x18eb5195),
+     TOBN(0x0336aab8, 0x777a16d2), TOBN(0xa6661cc4, 0xc241720a),
+     TOBN(0x678db970, 0xa7efacd0), TOBN(0x22896865, 0x6461e382),
+     TOBN(0x5d85a0e4, 0xa022c7a4), TOBN(0xb01f1e04, 0x34a02a6b),
+     TOBN(0x2657eedd, 0xa5791ce3), TOBN(0x239dcab2, 0xa277ac5b),
+     TOBN(0x7f74672d, 0x0b3db49f), TOBN(0x026275e9, 0xadc8418d),
+     TOBN(0x18866523, 0xfe7cc4ee), TOBN(0x3546317b, 0xbbf36aca),
+     TOBN(0x282313fa, 0x80caf049), TOBN(0x08275c9c, 0x9a49d91c),
+     TOBN(0xe41f92ec, 0xab71c2a8), TOBN(0xb5674698, 0x1dd95aae),
+     TOBN(0x82347685, 0xa8c4dc57), TOBN(0xf78b23d6, 0xa847fd1e),
+     TOBN(0x8194f070, 0xb692f868), TOBN(0xfe0dee06, 0xa5f2ad03),
+     TOBN(0x61361c06, 0x22abee22), TOBN(0xe82123bc, 0x2f42a470),
+     TOBN(0x2c97dda1, 0x3c6ceff4), TOBN(0xc2eea21f, 0xadcb0453),
+     TOBN(0xdf2a4407, 0xc78ec9ff), TOBN(0x54557c55, 0x9625c735),
+     TOBN(0xc693c985, 0x7c440c0a), TOBN(0x918e7324, 0xe56622c1),
+     TOBN(0x8f990d2b, 0xa5f0900f), TOBN(0xa5b7d193, 0xc6aeeaef),
+     TOBN(0x9f053d95, 0x450456e3), TOBN(0xdf783b1c, 0xad418ef1),
+     TOBN(0x08d2ce13, 0xbe6c3221), TOBN(0x0f53824c, 0x9c0624ea),
+     TOBN(0xad3ca744, 0x5da25412), TOBN(0xecb38a41, 0x93fea7cc),
+     TOBN(0x8ae838d8, 0xcba623c4), TOBN(0xa75c8da5, 0x41d85222),
+     TOBN(0x9f48b828, 0x290807c8), TOBN(0x4df75f09, 0x22f4ab6a),
+     TOBN(0x02511a3e, 0x7cab82a9), TOBN(0xcc052dc3, 0x21da354e),
+     TOBN(0x7db6c1f3, 0x03ca73e9), TOBN(0xca1d4279, 0xcb99244e),
+     TOBN(0x9a7a5b42, 0x6ae54da1), TOBN(0xcfcadaab, 0x7040b022),
+     TOBN(0x7539438e, 0x3d9f0e61), TOBN(0x013c6719, 0xe328c2e2),
+     TOBN(0x7f4a706c, 0xcccbf891), TOBN(0xa335ab82, 0x735a2d28),
+     TOBN(0x46694ef0, 0x3d984124), TOBN(0x0e0bdfab, 0xc166b337),
+     TOBN(0x9d54ed8b, 0x423d47e4), TOBN(0x8075a8cb, 0xf44c9180),
+     TOBN(0xd4f5b184, 0xabe9b384), TOBN(0x424dd00b, 0x41abdc75),
+     TOBN(0x36137ae5, 0xf2432ae5), TOBN(0x2d941abc, 0xad5f443d),
+     TOBN(0xe31e96f2, 0xee013f80), TOBN(0x24127d20, 0x26385266),
+     TOBN(0xd4004cf3, 0xeae97f8b), TOBN(0xbf3b201a, 0x62527c9e),
+     TOBN(0x0cd0fee1, 0xcb8a2a2f), TOBN(0x48894469, 0x8fdceb43),
+     TOBN(0xe67565ba, 0x2250a356), TOBN(0xbbb5f8ca, 0x2ccfe7d1),
+     TOBN(0x431a268f, 0xa350fe88), TOBN(0xd2eb0373, 0x4e5b64d2),
+     TOBN(0x2ad7ae0d, 0xf5d0255f), TOBN(0x4c04dee0, 0xd0836f8b),
+     TOBN(0x15e3493e, 0x4ec33606), TOBN(0x590aefe6, 0x5f5eea30),
+     TOBN(0x09ef5a2e, 0x2e49ba54), TOBN(0xf56d447f, 0x69a0d232),
+     TOBN(0x045f26b6, 0xe2510f5e), TOBN(0xf90e1888, 0x9941083a),
+     TOBN(0x6e6a3bd6, 0xe66f6b9b), TOBN(0x637ad390, 0x251f82ae),
+     TOBN(0xc40374b6, 0x43cdf91a), TOBN(0x62f5f8ad, 0x2d6c6d88),
+     TOBN(0x3da03590, 0x11ff6e09), TOBN(0x41194047, 0xa685c0e8),
+     TOBN(0x7c5323ff, 0x72b9c9ce), TOBN(0xf84ce505, 0x4f599daf),
+     TOBN(0xd0dec10e, 0x5882ef19), TOBN(0x1ca3449d, 0xde1e3a06),
+     TOBN(0x317e4e7f, 0xb09af84a), TOBN(0x0ebaa2c9, 0x1a46bc75),
+     TOBN(0x42b00a72, 0xc103f200), TOBN(0x1c30ada5, 0xc3719155),
+     TOBN(0x565bacfa, 0x5c1cb58c), TOBN(0x374f516c, 0x35fa4670),
+     TOBN(0x99a710b1, 0x400f1d87), TOBN(0xec3ca386, 0xee47be8b),
+     TOBN(0x3a00dcad, 0x37168fee), TOBN(0x1a69d674, 0x1765a0df),
+     TOBN(0x85233afe, 0x917c4909), TOBN(0xa3aa97a4, 0xe9bd6210),
+     TOBN(0x01010526, 0x310885f3), TOBN(0x21c5de3f, 0xb5007b08),
+     TOBN(0x5df0c6ef, 0xee8ddabd), TOBN(0x5d17d45a, 0x0f6dfdef),
+     TOBN(0xb73d831a, 0x251c9f79), TOBN(0x397779e6, 0xcb1df19d),
+     TOBN(0xe97f7bcf, 0xaf897b90), TOBN(0xbaeecdda, 0xe05af5ab),
+     TOBN(0x3c80856e, 0x1b81fd5b), TOBN(0xea309bd0, 0xeca4f983),
+     TOBN(0x534d8950, 0x22ab76a2), TOBN(0xa8d63627, 0x6d620cfe),
+     TOBN(0xa13d622c, 0x6b0cfcfc), TOBN(0x584a9d2e, 0x84d9147e),
+     TOBN(0xf23b9565, 0xd200ea9c), TOBN(0x5f44b61a, 0x193d5fe0),
+     TOBN(0x430a3d3a, 0x64b4c78d), TOBN(0x045dc592, 0xc91c2b41),
+     TOBN(0xafd6bf05, 0xbe13c1e4), TOBN(0x256e2b98, 0xe2ea8c26),
+     TOBN(0x06711695, 0x903983f4), TOBN(0xbefbfbcb, 0x217c1577),
+     TOBN(0xa214b26a, 0x7324c85c), TOBN(0xfa2d4711, 0xdd98b968),
+     TOBN(0xed722297, 0xf5d9cc93), TOBN(0x65cec50f, 0xd45f8635),
+     TOBN(0x41627e4a, 0xc792e6b3), TOBN(0xc254a08c, 0x228dbb39),
+     TOBN(0x5b28fd3f, 0xdf6fb26b), TOBN(0x1471d353, 0x4bdc6969),
+     TOBN(0x8600c734, 0x7c20f79d), TOBN(0x2bef7d87, 0xca3052ba),
+     TOBN(0xc52d0bdf, 0x7b082112), TOBN(0x0e649a4b, 0x2bf757ca),
+     TOBN(0x0c1f41bd, 0xb13eeb84), TOBN(0xd7115e8f, 0x8ecf9ace),
+     TOBN(0xa62f5e31, 0x1698ba68), TOBN(0x6a06d7be, 0xc862e751),
+     TOBN(0xd875c1a4, 0xf95eee3f), TOBN(0xb25f8da3, 0xa0b2b331),
+     TOBN(0x4e52fd11, 0x1827c037), TOBN(0xacd38c2a, 0x9d72ba3c),
+     TOBN(0x5e2cb07f, 0xd7801edf), TOBN(0xf9fa2c0b, 0x3adc065a),
+     TOBN(0xa296c53f, 0xd4de1f25), TOBN(0xd408060c, 0x838f7169),
+     TOBN(0x68e19d7b, 0x2e8a6ce7), TOBN(0x2cc6e06c, 0x94b58671),
+     TOBN(0x93d02a07, 0xc1cb6151), TOBN(0xa10fb4cf, 0x35003126),
+     TOBN(0x6aa069f5, 0x1aa3bc4e), TOBN(0x0e44fbf0, 0xdd09b142),
+     TOBN(0xe264f343, 0x832e5945), TOBN(0x5dca2adc, 0x1fc166ac)},
+    {TOBN(0x56ad7582, 0xa0eb176a), TOBN(0x085b5a36, 0x6e19aa00),
+     TOBN(0x85f2c6ff, 0xe2c8b036), TOBN(0x55c6d357, 0xfcd7336b),
+     TOBN(0xb1ecc56d, 0x22a46acd), TOBN(0x8e0f9767, 0x36277ac7),
+     TOBN(0xa4ed11e9, 0x01878921), TOBN(0xd3835566, 0x7f4fb650),
+     TOBN(0x5fdaba45, 0x266158aa), TOBN(0x6f0b27fd, 0x89e0dff0),
+     TOBN(0x32ef7ae2, 0xeb6b02d0), TOBN(0x2f145871, 0xcc1b46e1),
+     TOBN(0xe65245ce, 0xf6e9f82c), TOBN(0x9e234dff, 0xf6da7b5a),
+     TOBN(0x5677c121, 0xbad2c806), TOBN(0xc52dec32, 0x060fcf24),
+     TOBN(0x78d07067, 0x5d78ccca), TOBN(0x630002ea, 0x1bc8b6fb),
+     TOBN(0xc5cb86be, 0xeb2e99ae), TOBN(0xf13981e7, 0x8551d16f),
+     TOBN(0xfbb7cdf2, 0xc92a70d7), TOBN(0x5a9ff1f1, 0xf53cd2a1),
+     TOBN(0xfdbe6b7a, 0x984f1139), TOBN(0x4403d046, 0xa470a9f1),
+     TOBN(0xb5b16cd4, 0x8d040c69), TOBN(0xfdaba315, 0xf95a2dc4),
+     TOBN(0xc9fef349, 0x61ce4704), TOBN(0x5fe87a0d, 0xdbb53ed6),
+     TOBN(0x3f0ccc79, 0x73d70f93), TOBN(0x4601d1bc, 0x46724a1a),
+     TOBN(0x5c4a15ae, 0x24f08565), TOBN(0x5eda1e8a, 0xaa577320),
+     TOBN(0xe31ebb35, 0xbb32d307), TOBN(0xcdc6f13b, 0xdc770a0e),
+     TOBN(0xbe3ae514, 0xc434c2f8), TOBN(0x57c7fdf6, 0x3a0ef0d1),
+     TOBN(0xeb06571c, 0x0f547eba), TOBN(0xf292c38d, 0x6246c0dc),
+     TOBN(0xa1859667, 0x26eed224), TOBN(0x8d9e56e4, 0x6100e387),
+     TOBN(0x470506b9, 0xdc6298d1), TOBN(0xb19e084c, 0xf3350ad0),
+     TOBN(0x83eb62a8, 0x12abd898), TOBN(0x70f152cc, 0x2222342c),
+     TOBN(0xb089e880, 0xe1bd4a82), TOBN(0xd4d1e70f, 0xcaf3b3fc),
+     TOBN(0xd0b1ec63, 0x95ffd65c), TOBN(0x79f27f3a, 0x9b184ebb),
+     TOBN(0xc2467f9a, 0xb92a9a13), TOBN(0x0c3ee8eb, 0x6add349a),
+     TOBN(0x59250eda, 0x45e99644), TOBN(0x22ce0635, 0xc8a2df27),
+     TOBN(0xec7b643e, 0x312e8698), TOBN(0x334ccf2e, 0xaebd1587),
+     TOBN(0x0c1c6873, 0x6bca2900), TOBN(0x00beb4c2, 0x09826cb1),
+     TOBN(0x12dbb586, 0xcde6b725), TOBN(0x8d7cee6c, 0x66dfed41),
+     TOBN(0xc38deba2, 0x014de4c8), TOBN(0xa3ba6ec7, 0x6248442d),
+     TOBN(0x3c686079, 0xd42aeb95), TOBN(0xc162e5e9, 0x85e3ea0f),
+     TOBN(0x34cf5861, 0x1bbb2455), TOBN(0x7650de1d, 0x8773b064),
+     TOBN(0x3b7562c6, 0xd2bab35d), TOBN(0x83191b44, 0x33d0741b),
+     TOBN(0x4b604db0, 0x3a6bd9cf), TOBN(0x87cd84db, 0x074aed21),
+     TOBN(0x02a042d2, 0xd4f91f9c), TOBN(0x5a5d52e5, 0xe42c2a67),
+     TOBN(0x31291acd, 0x1d5f216a), TOBN(0x9c3971bc, 0xcd6203c8),
+     TOBN(0x92e4c851, 0xaa1ef488), TOBN(0x4f91fc22, 0x846528a9),
+     TOBN(0xaa2f5d2d, 0x5dc13a84), TOBN(0xba06aa68, 0xf1072d4d),
+     TOBN(0xf4f3b17c, 0x5e3a2ba9), TOBN(0xff36a535, 0x5e4dde77),
+     TOBN(0xe8ef143a, 0xae17dddc), TOBN(0xcc82631b, 0xa1fcd4ec),
+     TOBN(0x97db807e, 0xc7d3963b), TOBN(0xe4aff045, 0x21d85ce2),
+     TOBN(0x2d6480e6, 0x74667392), TOBN(0xc8ce97f3, 0xa55d0b3f),
+     TOBN(0xd4277731, 0x4c14ee0e), TOBN(0xda8146d1, 0x5e881c3f),
+     TOBN(0x6b0746b0, 0x99f1867c), TOBN(0x1ec73d72, 0x602dd4cc),
+     TOBN(0x27fae515, 0x38081120), TOBN(0x6a677bdc, 0x2f8b2f2d),
+     TOBN(0xb924af64, 0xd60544e9), TOBN(0x1439e183, 0xdcfc6b16),
+     TOBN(0x4e88e9ae, 0x068565ac), TOBN(0x8a3dbd25, 0xa9a4f146),
+     TOBN(0xdb4a3e48, 0x3f93f734), TOBN(0xb1971c05, 0x8f1d33bc),
+     TOBN(0x059a5f98, 0x56e8d1d1), TOBN(0x93a2d2ac, 0x5c228e89),
+     TOBN(0x0bc2c885, 0xfea48feb), TOBN(0x27fdf3be, 0x7b7e188c),
+     TOBN(0xec579682, 0xd399ba6e), TOBN(0x01b12e12, 0xb3fdb5d0),
+     TOBN(0x8e00941b, 0x742f66b8), TOBN(0xd79bc58f, 0x478d8ee4),
+     TOBN(0xefdcd053, 0x9ad50729), TOBN(0x8738666f, 0x3bf7bfea),
+     TOBN(0x20192810, 0xd7afaff1), TOBN(0x6c13e29e, 0xd233e892),
+     TOBN(0xf1f5df24, 0xff9ae345), TOBN(0x5b8038b9, 0x3dd75336),
+     TOBN(0x4746c5da, 0x7d2c0058), TOBN(0x667b07bd, 0x51ddd827),
+     TOBN(0x1b3c67c2, 0x8cfdfd25), TOBN(0x058dea06, 0x06dac0d6),
+     TOBN(0xd19040fd, 0x846c847d), TOBN(0x4e5cbe59, 0x07d00ec6),
+     TOBN(0x2dc442fe, 0xf1930296), TOBN(0x12f89640, 0xfdb583be),
+     TOBN(0x0694f44f, 0x5606f66b), TOBN(0xa9fcca6c, 0xbbef8446),
+     TOBN(0x0c229fb9, 0x4b5cb12f), TOBN(0x0486ba2d, 0xe930ff3e),
+     TOBN(0x00797293, 0xb80c37f6), TOBN(0x71be9538, 0xb43335e0),
+     TOBN(0x0a604693, 0xda0d9cb7), TOBN(0xb248f30d, 0x745cc02e),
+     TOBN(0xfa889343, 0xd9a3013b), TOBN(0xd8642bc0, 0x53d6a4d4),
+     TOBN(0x9f89c21a, 0xe216af4b), TOBN(0x86272900, 0x41947320),
+     TOBN(0x06f5f8f7, 0xa269c49a), TOBN(0xb3bc6d62, 0x727495ba),
+     TOBN(0xd1de964b, 0xd1066e5a), TOBN(0x26ccad6b, 0x749909df),
+     TOBN(0xbc4b55af, 0x0de9eb07), TOBN(0x9f11b995, 0xa60289bf),
+     TOBN(0x3e59000c, 0x52392c61), TOBN(0x2128c46a, 0x5ccff4fc),
+     TOBN(0xb28b306b, 0xea1e0d5e), TOBN(0x5f6ef5d5, 0xf5cfa47d),
+     TOBN(0x59b0542c, 0xe3f824fa), TOBN(0x70f097b2, 0x2f52b71c),
+     TOBN(0x4483b726, 0x04c6d263), TOBN(0x48720be7, 0x34d93e5b),
+     TOBN(0x864bbbb7, 0x95ad5fe3), TOBN(0x24f15dcb, 0xe8113888),
+     TOBN(0x968fcf60, 0x6edb61fe), TOBN(0xbf266d1c, 0xc7e1aff9),
+     TOBN(0xd85a1555, 0x3f4a5d91), TOBN(0xd5ff238e, 0xf8416ead),
+     TOBN(0xcc0e75da, 0x30d18538), TOBN(0xcf8a5435, 0xb2b91d71),
+     TOBN(0xfae90226, 0x027a7e72), TOBN(0x8e39918c, 0x627c27f7),
+     TOBN(0x5b8235c9, 0x18d454b0), TOBN(0xef92e643, 0x44987803),
+     TOBN(0xb39b33ce, 0x41ff08a5), TOBN(0xaf6dfb28, 0x32450c03),
+     TOBN(0xe21947c5, 0x7b45c3f2), TOBN(0x21b529f6, 0xbc35bfdf),
+     TOBN(0xc0a26928, 0x4c5be366), TOBN(0x73856f3a, 0xd366b21e),
+     TOBN(0x53e26b66, 0x3df444f7), TOBN(0xb18a295e, 0x8b9c7ac1),
+     TOBN(0x6b9df497, 0x301f1f11), TOBN(0x6e77d0e2, 0x7607f372),
+     TOBN(0xd2e6b296, 0xc311fc01), TOBN(0x18a224e0, 0x7a396a6c),
+     TOBN(0x8507c707, 0x9b97dff2), TOBN(0xacc0b6a5, 0x983d26af),
+     TOBN(0xdcc30fd6, 0x2b62fdb2), TOBN(0xe9b03755, 0xa68ab541),
+     TOBN(0x270bc073, 0x13b6c3a0), TOBN(0x952ec4b9, 0x649051fc),
+     TOBN(0x4814c2c2, 0xe70ceb83), TOBN(0x07632da5, 0xc090e636),
+     TOBN(0x1c340686, 0x11fcdb0b), TOBN(0x7b4985d7, 0x113f2ce9),
+     TOBN(0xc3072347, 0x16da3a7d), TOBN(0xf0575aef, 0x0d7d36ab),
+     TOBN(0x721bb836, 0x3a7f43c3), TOBN(0xab5b3108, 0xc12dca0f),
+     TOBN(0x9cc9a789, 0x34853870), TOBN(0x78b604a7, 0xaf598c4f),
+     TOBN(0xd370375e, 0x476f27c8), TOBN(0x9f0415b8, 0x0b15cba5),
+     TOBN(0x2bcfd9a4, 0xd400dc1f), TOBN(0x2a6fe03b, 0x4bc62ddd),
+     TOBN(0xb05a6464, 0xa211b19f), TOBN(0xce059d41, 0x9990b504),
+     TOBN(0x011c5f87, 0xd94951d3), TOBN(0x13cec089, 0x00d9c7b0)},
+    {TOBN(0xf365419f, 0x9b280fd9), TOBN(0x13e3b127, 0x46365672),
+     TOBN(0x8a91c165, 0xc41880aa), TOBN(0x3eb27a97, 0xf9712fbd),
+     TOBN(0xa6587aec, 0x76c55678), TOBN(0x7c3a04b7, 0x02cd79cf),
+     TOBN(0xfc878f9c, 0xda712eb8), TOBN(0x076e6117, 0x0fca3e02),
+     TOBN(0x09a184d8, 0xcaf6df5e), TOBN(0xd32bf232, 0xaabcde75),
+     TOBN(0xf601d0de, 0x03de597a), TOBN(0x85d2b5fc, 0xc5da2858),
+     TOBN(0xb6029961, 0xae899afa), TOBN(0x8eedd66e, 0x681b6e1b),
+     TOBN(0x82db693b, 0x4df3e5b1), TOBN(0xb5131488, 0xa0c3e357),
+     TOBN(0xbfb01ff3, 0xccb2f577), TOBN(0x28ea9470, 0x27a72cc3),
+     TOBN(0x26170928, 0xe39e325e), TOBN(0x42d4876b, 0x84f80188),
+     TOBN(0x0bec6a63, 0x4c872d76), TOBN(0xa0a7cc90, 0xb14d9c9f),
+     TOBN(0x8a32d2c4, 0x4f6c7778), TOBN(0xe7cd346e, 0x3b889a4c),
+     TOBN(0xea95b5c9, 0x437f2efb), TOBN(0x67d3e9b5, 0x8e52ce8e),
+     TOBN(0xfb331024, 0x88ff5455), TOBN(0x883ec9fc, 0xc3101ded),
+     TOBN(0x056218e2, 0x0ca5f1f9), TOBN(0x4c9b2483, 0xbccc65d8),
+     TOBN(0x13199b26, 0x123db2ec), TOBN(0xbc1d8247, 0x9aff90db),
+     TOBN(0xc4a9311d, 0x367516f6), TOBN(0x3b40c867, 0xcb6e90d6),
+     TOBN(0xff674ff8, 0x4034415c), TOBN(0x2787db45, 0xa1821e7e),
+     TOBN(0x860ef794, 0x609683ac), TOBN(0xf0631ad3, 0x9af1c522),
+     TOBN(0x322c8366, 0x2ee7f522), TOBN(0x58ccd95f, 0x54122af0),
+     TOBN(0x7454880c, 0x2bbb2d80), TOBN(0xea173d82, 0x86d8d577),
+     TOBN(0xd5a3057c, 0xea1cc801), TOBN(0xfd08d482, 0xbbb2a189),
+     TOBN(0x26aac99e, 0xc3c512f8), TOBN(0xc3eac036, 0x556d891e),
+     TOBN(0x866c3aa7, 0xbf9f6112), TOBN(0x7c4c8fb9, 0xc144f7e9),
+     TOBN(0xc0c1eb0f, 0x8343f5dd), TOBN(0xa205e66a, 0x0126fa2d),
+     TOBN(0x37530a32, 0x44fd8be4), TOBN(0x3c7af6f6, 0x96ab64cf),
+     TOBN(0x1f043050, 0x76657202), TOBN(0x2c59d31c, 0x828f3fb1),
+     TOBN(0xa61cba51, 0xe7f5926e), TOBN(0xb2de4273, 0x91ebeb81),
+     TOBN(0x976f2c34, 0xbb855476), TOBN(0x0c6c02c3, 0x269e4f86),
+     TOBN(0xc69bed8f, 0xe2e01fff), TOBN(0x19aa421c, 0x480bf7b4),
+     TOBN(0xad0d24c7, 0xb617206b), TOBN(0xb8be483f, 0x9dd13f59),
+     TOBN(0xa55134ff, 0x7655aa29), TOBN(0xa3d10385, 0x7a5e217e),
+     TOBN(0xfbb9eeb5, 0x3a21b295), TOBN(0x1de71555, 0xc84a136d),
+     TOBN(0x7579398e, 0x0b7487b3), TOBN(0xc6ca9575, 0xa14dce87),
+     TOBN(0x99b32e1e, 0x46452257), TOBN(0x99d54955, 0x479d8f2c),
+     TOBN(0xc2a8a6a1, 0x930b80ef), TOBN(0x58d9db81, 0x656c850b),
+     TOBN(0x6c85a0ed, 0xa682508c), TOBN(0x8350b515, 0xedcce6c8),
+     TOBN(0xa84a6765, 0x6f95898d), TOBN(0x55b0ae97, 0x1e419847),
+     TOBN(0x11115c6e, 0xdd6a885d), TOBN(0x6f0beaf6, 0x4fb174a4),
+     TOBN(0xaaae44b2, 0x815af3af), TOBN(0xcf0697b9, 0x927a2c1c),
+     TOBN(0x37639d62, 0xd7d645ee), TOBN(0x157b7eda, 0x2effec37),
+     TOBN(0xb55e5075, 0x9b9c66e6), TOBN(0x33a66a1f, 0x85f597ec),
+     TOBN(0x171898aa, 0x8f7782b6), TOBN(0x8b7a706b, 0x499b3a81),
+     TOBN(0xbc0e835f, 0xfdb2c1ba), TOBN(0x4ee30281, 0x591f5aaf),
+     TOBN(0xfd71de3b, 0xcc272c6a), TOBN(0x532800c4, 0x6e93f68a),
+     TOBN(0x35ee0804, 0x8365c576), TOBN(0x6c2bcc94, 0xcd4c0221),
+     TOBN(0x49f37ff5, 0x957b2ff6), TOBN(0x315d8e7e, 0x5ec029c0),
+     TOBN(0x33230602, 0xef324c12), TOBN(0xf5847f9b, 0x966b2578),
+     TOBN(0xc29b123e, 0x1453b1e1), TOBN(0xefb07788, 0x20059b44),
+     TOBN(0x15554ade, 0x9291671e), TOBN(0xeb5a1980, 0x429dea37),
+     TOBN(0xf96dacbb, 0x6c4b867d), TOBN(0x4f5563d6, 0xabab4d68),
+     TOBN(0xb5b0ecff, 0xcbe76297), TOBN(0x5a22996a, 0x51d6bd43),
+     TOBN(0x0088ec95, 0xb7e5cfc6), TOBN(0x4863a5a1, 0xfe373e05),
+     TOBN(0x42b7925b, 0xc244d93d), TOBN(0x85bad135, 0x40117113),
+     TOBN(0x86283e21, 0xf9daa551), TOBN(0x47fd23f8, 0x1f696f1b),
+     TOBN(0x7d029b1b, 0xb9784a9a), TOBN(0x7c7798be, 0xa0c0acb5),
+     TOBN(0x41241c71, 0x6d7c682b), TOBN(0x11c6c113, 0x1d33c2b0),
+     TOBN(0x5d469ca2, 0x3565cf32), TOBN(0xa949f022, 0xbad4bdbf),
+     TOBN(0x3d054cc2, 0xa13cf4cd), TOBN(0x13bd2166, 0x9e3ce279),
+     TOBN(0x01bc70e6, 0x8a4beafc), TOBN(0xb39e351d, 0x8aba087e),
+     TOBN(0x26072a5d, 0x82357232), TOBN(0x3762764e, 0x9f0fd2f1),
+     TOBN(0x9c5813f6, 0x0c16733e), TOBN(0xea2e0e03, 0x718951d4),
+     TOBN(0xae195bd4, 0x69e63818), TOBN(0x241a4afc, 0xfa2f9a6e),
+     TOBN(0x0e97519f, 0x9165d59a), TOBN(0x416bd373, 0x58e5af1b),
+     TOBN(0xc4e81128, 0x8197b7ec), TOBN(0x4145be2c, 0x9c6ba0d0),
+     TOBN(0xc82cb2a1, 0x7d40b98a), TOBN(0xc3c28487, 0xbccfa8b8),
+     TOBN(0x84aa863e, 0xa4ee10a1), TOBN(0x24d805a6, 0x87919ccd),
+     TOBN(0x553f3206, 0xb5c399b2), TOBN(0x775b9217, 0x3cc109bd),
+     TOBN(0x25c01263, 0xfe384088), TOBN(0xa3c4418b, 0xd5f743cf),
+     TOBN(0x3d69705d, 0xdf91f1f0), TOBN(0x547d4626, 0x9ebddad1),
+     TOBN(0x0198ab1a, 0x2626cebd), TOBN(0xaf8320f2, 0x85b1afe8),
+     TOBN(0xb9c0968c, 0xe17e6efd), TOBN(0xfedc75c2, 0x90215bb6),
+     TOBN(0x8061d340, 0x143ff74d), TOBN(0x59e94fc6, 0xa23aa7b3),
+     TOBN(0xf7c79a0b, 0x914c3b81), TOBN(0x5a836211, 0x702c6ae7),
+     TOBN(0x2570d63c, 0x718123c3), TOBN(0x7e86d11e, 0xc9f5ce3c),
+     TOBN(0x80f03f97, 0x17bcce3b), TOBN(0x073975b1, 0x465a7446),
+     TOBN(0x29f66de7, 0xcb357ace), TOBN(0xe87bd12c, 0x04894fb0),
+     TOBN(0xfc501a26, 0x51a0b5ae), TOBN(0x20a3170c, 0x02207a3b),
+     TOBN(0x3ee52d8f, 0x5fe63bd4), TOBN(0x09f8405c, 0x7a7da77c),
+     TOBN(0x35ce95c6, 0x1881a757), TOBN(0x0a8cf9d9, 0xc13e3707),
+     TOBN(0xe71258d5, 0x48d2d3f6), TOBN(0xcf4fd691, 0x0bbe7c0d),
+     TOBN(0xbd6496e1, 0xfb9479f1), TOBN(0x711c669a, 0xab8cb3a2),
+     TOBN(0xcbe85013, 0x58cfdfb4), TOBN(0x655c902b, 0x59275b4a),
+     TOBN(0x7e0ff05b, 0x20f722ba), TOBN(0xcb00031d, 0x42b17aad),
+     TOBN(0x3360ff11, 0xd54bf1a4), TOBN(0xbab994cb, 0x5c79494b),
+     TOBN(0x953ad553, 0x757d7771), TOBN(0xf17f14f0, 0x68b58ed5),
+     TOBN(0x22361531, 0x7523c422), TOBN(0xf0f05f96, 0x5ebf0d49),
+     TOBN(0x33866765, 0x49182267), TOBN(0xf87eccc1, 0xad71c3eb),
+     TOBN(0xd7708e18, 0x913d8dca), TOBN(0x27fe27e1, 0xb193eef9),
+     TOBN(0x33376365, 0xcc45e65d), TOBN(0x599b4778, 0xd700ac20),
+     TOBN(0xda643272, 0xed068028), TOBN(0x86b52135, 0xa91fb87f),
+     TOBN(0x23865a7c, 0x35b43943), TOBN(0x6ac01588, 0x4606bbf2),
+     TOBN(0x9660ab72, 0x1559fb9a), TOBN(0x1fcb09e7, 0x3ce2f1a5),
+     TOBN(0x62af29ab, 0x793d2f0c), TOBN(0xad5aaef5, 0x3aee7efc),
+     TOBN(0xee9f29b7, 0x44c11037), TOBN(0xb2a19cf1, 0xd36c2571),
+     TOBN(0xb87d88e2, 0x65b552b7), TOBN(0xd8b4f172, 0xbeb253d4)},
+    {TOBN(0x31bdb483, 0x72876ae8), TOBN(0xe3325d98, 0x961ed1bf),
+     TOBN(0x18c04246, 0x9b6fc64d), TOBN(0x0dcc15fa, 0x15786b8c),
+     TOBN(0x81acdb06, 0x8e63da4a), TOBN(0xd3a4b643, 0xdada70fb),
+     TOBN(0x46361afe, 0xdea424eb), TOBN(0xdc2d2cae, 0x89b92970),
+     TOBN(0xf389b61b, 0x615694e6), TOBN(0x7036def1, 0x872951d2),
+     TOBN(0x40fd3bda, 0xd93badc7), TOBN(0x45ab6321, 0x380a68d3),
+     TOBN(0xc5cf8997, 0xce0b5b72), TOBN(0x350adde1, 0x9d7154ba),
+     TOBN(0x8139681e, 0x307b254a), TOBN(0xcc87fb57, 0x75cd94d7),
+     TOBN(0x90e70274, 0x78684954), TOBN(0xc4fdf4c0, 0x95ceb991),
+     TOBN(0x91bbc0ab, 0x8762c84c), TOBN(0x5e09e226, 0xce09e8ad),
+     TOBN(0x1cb83d70, 0x4b93d45f), TOBN(0xe2299024, 0xf541da1f),
+     TOBN(0x3eef7ce1, 0x4b7ffd10), TOBN(0x53ee63bb, 0xb3fc1b9a),
+     TOBN(0x23c1f744, 0x81a2703a), TOBN(0x1a5d075c, 0xb9859136),
+     TOBN(0xa4f82c9d, 0x5afd1bfd), TOBN(0xa3d1e9a4, 0xf89d76fe),
+     TOBN(0x964f7050, 0x75702f80), TOBN(0x182bf349, 0xf56c089d),
+     TOBN(0xe205fa8f, 0xbe0da6e1), TOBN(0x32905eb9, 0x0a40f8f3),
+     TOBN(0x331a1004, 0x356d4395), TOBN(0x58b78901, 0xfdbbdfde),
+     TOBN(0xa52a1597, 0x9ba00e71), TOBN(0xe0092e1f, 0x55497a30),
+     TOBN(0xe5004e80, 0x03682f59), TOBN(0xccdb9cb7, 0xf642ac0f),
+     TOBN(0x405f50d1, 0xbd869f77), TOBN(0xecffa54d, 0xe7ebea2c),
+     TOBN(0x3354dc22, 0xd87620ba), TOBN(0x01bb2988, 0xb1c01ff4),
+     TOBN(0xd9370076, 0xe16477fd), TOBN(0x45303d2a, 0x2e71ba4b),
+     TOBN(0xc0de7627, 0x3291e5c5), TOBN(0x5cfebd87, 0xf0a7ca55),
+     TOBN(0xde116280, 0x9e592a30), TOBN(0xdd26e577, 0xa78ebce4),
+     TOBN(0x5562a856, 0x70ee8f39), TOBN(0x86b0c117, 0x64e52a9c),
+     TOBN(0xc19f3174, 0x09c75b8c), TOBN(0x21c7cc31, 0x24923f80),
+     TOBN(0xe63fe47f, 0x8f5b291e), TOBN(0x3d6d3c05, 0x0dc08b05),
+     TOBN(0x58ae455e, 0xee0c39a1), TOBN(0x78bea431, 0x0ad97942),
+     TOBN(0x42c7c97f, 0x3ee3989c), TOBN(0xc1b03af5, 0xf38759ae),
+     TOBN(0x1a673c75, 0xbcf46899), TOBN(0x4831b7d3, 0x8d508c7d),
+     TOBN(0x1e9b23b9, 0xff1735a8), TOBN(0xc3bf3d5b, 0x2b0e4b7b),
+     TOBN(0xd4cc00fe, 0x59b7721c), TOBN(0xd5c36f9c, 0x9e2f4ceb),
+     TOBN(0xdeca06ba, 0xc90af70e), TOBN(0x42676f12, 0x416ee799),
+     TOBN(0x0d7afe1b, 0x6f748c6f), TOBN(0x0b7a6de5, 0x39c39d55),
+     TOBN(0x11e43d6e, 0xe6eaed18), TOBN(0x5baf8602, 0x496087e0),
+     TOBN(0xf833634f, 0xb1a3a66e), TOBN(0x25098c8a, 0x79398677),
+     TOBN(0x76512d1b, 0xc552e354), TOBN(0x2b7eb6df, 0x273020fd),
+     TOBN(0xd1c73aa8, 0x025a5f25), TOBN(0x2aba1929, 0x5cbd2a40),
+     TOBN(0xb53cadc3, 0xc88d61c6), TOBN(0x7e66a95e, 0x098290f3),
+     TOBN(0x72800ecb, 0xaf4c5073), TOBN(0x81f2725e, 0x9dc63faf),
+     TOBN(0x14bf92a7, 0x282ba9d1), TOBN(0x90629672, 0xbd5f1bb2),
+     TOBN(0x362f68eb, 0xa97c6c96), TOBN(0xb1d3bb8b, 0x7ea9d601),
+     TOBN(0xe141e763, 0xd4720770), TOBN(0xb9739e70, 0xddb3b450),
+     TOBN(0x46e6cde4, 0x96131446), TOBN(0x0458a5d5, 0xcb6c2ef7),
+     TOBN(0xb7747634, 0x532f9fd8), TOBN(0xf62d3721, 0x16544457),
+     TOBN(0xbfacb4de, 0xd3100854), TOBN(0x70788a31, 0xb39d3f62),
+     TOBN(0x9b543220, 0xf22d92e4), TOBN(0xaa4590f6, 0x55723258),
+     TOBN(0xc7b6730e, 0x01ddb8bc), TOBN(0xae252cf8, 0x69e1e7bd),
+     TOBN(0x73878f7f, 0xa9c94429), TOBN(0xb35c3bc8, 0x456ca6d8),
+     TOBN(0xd96f0b3c, 0xf721923a), TOBN(0x28d8f06c, 0xe6d44fa1),
+     TOBN(0x94efdcdc, 0xd5cd671a), TOBN(0x0299ab93, 0x3f97d481),
+     TOBN(0xb7ced6ea, 0x2fd1d324), TOBN(0xbd683208, 0x7e932ec2),
+     TOBN(0x24ed31fb, 0xcb755a6e), TOBN(0xa636098e, 0xe48781d2),
+     TOBN(0x8687c63c, 0xf0a4f297), TOBN(0xbb523440, 0x07478526),
+     TOBN(0xc618cf0d, 0xdd4b8d8d), TOBN(0x471cda86, 0x40dcfbfb),
+     TOBN(0xba0dd7ac, 0x08882ce6), TOBN(0x58e5d2f5, 0x6cd336e7),
+     TOBN(0xcdda8301, 0xaf096540), TOBN(0xf6d26846, 0x3cf31600),
+     TOBN(0x6150cd98, 0x2197efd5), TOBN(0x4440fbfa, 0x55fb0877),
+     TOBN(0xca31871c, 0x90757f1d), TOBN(0xc4a1faac, 0xbdd756c8),
+     TOBN(0xc9d4ac1b, 0xcbb8421e), TOBN(0x3c0c2914, 0xb17c43be),
+     TOBN(0x2e5f7419, 0x34124b56), TOBN(0x1f223ae1, 0x4b3f02ca),
+     TOBN(0x6345b427, 0xe8336c7e), TOBN(0x92123e16, 0xf5d0e3d0),
+     TOBN(0xdaf0d14d, 0x45e79f3a), TOBN(0x6aca6765, 0x6f3bd0c6),
+     TOBN(0xf6169fab, 0x403813f4), TOBN(0x31dc39c0, 0x334a4c59),
+     TOBN(0x74c46753, 0xd589866d), TOBN(0x5741511d, 0x984c6a5d),
+     TOBN(0xf2631287, 0x97fed2d3), TOBN(0x5687ca1b, 0x11614886),
+     TOBN(0x46fdb65c, 0xaa6fe9ea), TOBN(0xe0d48e5e, 0x05494cd9),
+     TOBN(0x5adef570, 0x4afbf837), TOBN(0xc96ba4b9, 0x1c9e2cad),
+     TOBN(0x1e8158f7, 0x054a158c), TOBN(0x47be7320, 0x9e38b88d),
+     TOBN(0x9b99971e, 0x6d2993ec), TOBN(0xac9b0bfa, 0xdf980ecc),
+     TOBN(0x9da09642, 0xd96ca391), TOBN(0xd6710536, 0x9bf4305c),
+     TOBN(0x40cc1adf, 0xa0dfafae), TOBN(0xe27e32f8, 0xa209699b),
+     TOBN(0x076d902a, 0x33836d4b), TOBN(0xec6c5c43, 0x24afb557),
+     TOBN(0xa0fe2d1c, 0xa0516a0f), TOBN(0x6fb8d737, 0x00d22ecc),
+     TOBN(0xf1de9077, 0xdaf1d7b3), TOBN(0xe4695f77, 0xd4c0c1eb),
+     TOBN(0x5f0fd8a8, 0xb4375573), TOBN(0x76238359, 0x5e50944f),
+     TOBN(0x65ea2f28, 0x635cd76f), TOBN(0x08547769, 0x25fde7b0),
+     TOBN(0xb2345a2e, 0x51944304), TOBN(0x86efa2f7, 0xa16c980d),
+     TOBN(0xeaaddeb8, 0x36e87d82), TOBN(0xc12587a7, 0x1ffd7210),
+     TOBN(0xf93d2f5c, 0x731f6838), TOBN(0xb96594e8, 0xf7097a65),
+     TOBN(0x08d6717a, 0xb016e8d3), TOBN(0x9c378de8, 0x1984d825),
+     TOBN(0x627d41e7, 0xcb2a0c26), TOBN(0x1f447501, 0xc697ceb1),
+     TOBN(0x8dc40831, 0xc760550b), TOBN(0x70ad4870, 0x7fac97b0),
+     TOBN(0x5ac7f22e, 0x7021c170), TOBN(0xa6f730e4, 0x929d5931),
+     TOBN(0x4ccbe2d0, 0xbf4d1d63), TOBN(0x32e33401, 0x397366d5),
+     TOBN(0xc83afdde, 0x71bda2ce), TOBN(0x8dace2ac, 0x478ed9e6),
+     TOBN(0x3ac6a559, 0x763fdd9e), TOBN(0x0ffdb04c, 0xb398558f),
+     TOBN(0x6c1b99b2, 0xafb9d6b8), TOBN(0x572ba39c, 0x27f815dd),
+     TOBN(0x9de73ee7, 0x0dbcf842), TOBN(0x2a3ed589, 0x29267b88),
+     TOBN(0xd46a7fd3, 0x15ebbbb3), TOBN(0xd1d01863, 0xe29400c7),
+     TOBN(0x7d27d71f, 0xd186cb09), TOBN(0x67cb7f4e, 0x3bc213c7),
+     TOBN(0x418cafeb, 0x6075b2cf), TOBN(0xc0d691e6, 0xd93a06f7),
+     TOBN(0xc16a9525, 0x9dd001b9), TOBN(0xa0583230, 0x026f17b9),
+     TOBN(0x4c1041b0, 0x7845900b), TOBN(0x28740791, 0x47a22aae),
+     TOBN(0x8d08efd6, 0x2c1758e9), TOBN(0x9cc6f207, 0xe6c3229a),
+     TOBN(0xec69e902, 0x082d8924), TOBN(0x9cfa1dea, 0xf331dfe7)},
+    {TOBN(0x8ec4335f, 0xabe7c60e), TOBN(0x01f198c1, 0x0a6a9fb5),
+     TOBN(0x3ff96de0, 0x01141ab6), TOBN(0xb21acc2c, 0x2eca98a1),
+     TOBN(0x61548490, 0x10fdf648), TOBN(0x2c01a99c, 0xd1403e8b),
+     TOBN(0xf1a35f30, 0x6fa509d7), TOBN(0xf7715fe3, 0xe3f08e9f),
+     TOBN(0x89c26c07, 0x7fc9a752), TOBN(0x8d2535fe, 0x420d48a0),
+     TOBN(0x80ec5ddd, 0x52fe2e73), TOBN(0x041b8df0, 0x71704f39),
+     TOBN(0x498808ed, 0xc65fafce), TOBN(0x3676a7cc, 0x4e806bc3),
+     TOBN(0x796e25f1, 0x76c6b964), TOBN(0x1aced64b, 0xac474261),
+     TOBN(0xa62470fc, 0x29a460c1), TOBN(0x77501dce, 0x5e751e48),
+     TOBN(0xcc00053b, 0x6d9e3641), TOBN(0x2b5bc4ae, 0x9a3f5a0b),
+     TOBN(0xddaccc2e, 0x3f9ca178), TOBN(0xad33f34a, 0x0b80d1b0),
+     TOBN(0x6a76df93, 0x64642225), TOBN(0xc145f36f, 0x778e761b),
+     TOBN(0xdffb03ae, 0xc10b43ae), TOBN(0x39b1266e, 0x9433a54b),
+     TOBN(0x4c262521, 0xb19fe0db), TOBN(0x0ec1e54f, 0x3d5c7fee),
+     TOBN(0x2856510b, 0x05e68e1e), TOBN(0x49382c1e, 0xdc80b8a6),
+     TOBN(0x80a50931, 0x2471bdd5), TOBN(0xe8cde185, 0x81974aa9),
+     TOBN(0xca6112ee, 0x28235c52), TOBN(0xd28a0eb8, 0x301f9653),
+     TOBN(0x22b11e26, 0xe11fcdf8), TOBN(0x97e6fc5d, 0xe4d735f3),
+     TOBN(0x9c66a32b, 0xecc5f6da), TOBN(0xe4ff4043, 0x1719ba2c),
+     TOBN(0x8c6cfab7, 0x21e716ef), TOBN(0x32c8fccb, 0x96ed74e6),
+     TOBN(0x475890dd, 0x0b110c83), TOBN(0xdfada95f, 0x5cb4eefe),
+     TOBN(0x9d7b89a6, 0x93240fe1), TOBN(0x6afdb2d0, 0x210b776f),
+     TOBN(0xc3f0b55b, 0xca7a7d52), TOBN(0xa6e56a06, 0x55d04585),
+     TOBN(0x818e221c, 0x4257acc5), TOBN(0x05207b63, 0xfcb8d39e),
+     TOBN(0x00fc2cfe, 0xac993097), TOBN(0x4d3532b1, 0x76b4508c),
+     TOBN(0x0887cb17, 0xa24c9add), TOBN(0x2698a3e0, 0x1a9972dd),
+     TOBN(0xa6f0258b, 0x26352346), TOBN(0xf6791599, 0x3132792c),
+     TOBN(0x2c3d2ebb, 0x92f39495), TOBN(0xf8405894, 0x3f9e744c),
+     TOBN(0xba220301, 0x54833968), TOBN(0xa0c5454e, 0xb7936d27),
+     TOBN(0xdd9078e1, 0xb0ca30ec), TOBN(0xfa5e78ae, 0x5a80ec29),
+     TOBN(0xc948333b, 0xe68b9c0c), TOBN(0x96e30042, 0x265cb56b),
+     TOBN(0x957516bd, 0x3c12bd22), TOBN(0x0d328473, 0x0033e495),
+     TOBN(0x23ff9704, 0xc9e2117d), TOBN(0x81693f98, 0xe3d28a72),
+     TOBN(0x7a0ba6c9, 0xf8066b56), TOBN(0x0e2e2242, 0x332bdbe8),
+     TOBN(0x885d3c00, 0xe9f4ce83), TOBN(0x3145e5ec, 0x8ae96eae),
+     TOBN(0x8d4b26d4, 0x91e3d14c), TOBN(0x17b5782a, 0xa9ad6fe2),
+     TOBN(0x39062094, 0xcabd9b94), TOBN(0x20b3910b, 0xc68dc31e),
+     TOBN(0x7d78a043, 0x0b708450), TOBN(0xe113da29, 0x522bd0d5),
+     TOBN(0xc46fa10a, 0xf7f27be8), TOBN(0x8258b2ce, 0x295393a0),
+     TOBN(0xf69dc622, 0x28d958d8), TOBN(0x97b796c0, 0x991261e9),
+     TOBN(0xaedea55e, 0x36482f74), TOBN(0x6e4f2e3c, 0xeec962cd),
+     TOBN(0x782f495a, 0x2a06b626), TOBN(0x41e32a4d, 0xfe23dd4b),
+     TOBN(0x0a74da82, 0xd8ada6cc), TOBN(0xc6b98a3c, 0xbea55457),
+     TOBN(0x896c26bb, 0x57c2f5ac), TOBN(0x981e2f72, 0x845d45e4),
+     TOBN(0xca152b87, 0x7e9a7d36), TOBN(0x49666d45, 0x7b582e8f),
+     TOBN(0xea3b9bda, 0x49fc20b9), TOBN(0x5bcbc84a, 0x7c71f153),
+     TOBN(0xd346fc5d, 0x5748a654), TOBN(0x7ac2f217, 0x622665ee),
+     TOBN(0xbb5efe7f, 0xb6f16e27), TOBN(0xb1810a70, 0x644c9dc8),
+     TOBN(0xe0c7946c, 0x2e4b40f5), TOBN(0x7ef21fe5, 0x7dd0f6de),
+     TOBN(0xc2a8cdd8, 0xf81f21f3), TOBN(0x6ad73e42, 0xc7ebe7a3),
+     TOBN(0x3e8099c3, 0x5d42a7be), TOBN(0x151c6de8, 0x6df16d22),
+     TOBN(0x214a649b, 0x5293c104), TOBN(0x769763d1, 0x56b4d1d3),
+     TOBN(0x78b33355, 0xe3bebab4), TOBN(0xe10a70ce, 0xc78a804e),
+     TOBN(0x985a16fe, 0x211f735e), TOBN(0xfd50c868, 0x56605fc0),
+     TOBN(0x16bcf31c, 0x8f646cdb), TOBN(0xe9b4b8a9, 0x059f65cc),
+     TOBN(0x34a47964, 0xf8971dbd), TOBN(0xd76f597f, 0xcfe021f8),
+     TOBN(0x23bab19c, 0x573891a6), TOBN(0xdf670285, 0x2645a244),
+     TOBN(0xcc338b2c, 0x4347674f), TOBN(0x1ddd83da, 0x4c07ab3e),
+     TOBN(0xee6bb102, 0x31bf757d), TOBN(0x3f2828c5, 0x032ec673),
+     TOBN(0xcf0daf5f, 0x0cd7c8f8), TOBN(0x1b5d1126, 0x56eba0e0),
+     TOBN(0xd9b864d9, 0xdcf6b460), TOBN(0xf453164e, 0x5141107c),
+     TOBN(0xac36ccb9, 0xb019575e), TOBN(0x996c97bb, 0xa0040dea),
+     TOBN(0xf684e539, 0x86b7899e), TOBN(0xb11bb533, 0x6b00d106),
+     TOBN(0x86af64aa, 0xbe831360), TOBN(0xbda68250, 0xb21650cc),
+     TOBN(0xc080ad14, 0xffd7b0c6), TOBN(0xa7cd582f, 0x1a3844b9),
+     TOBN(0x3656ad08, 0x4531ed01), TOBN(0xe12b761e, 0x0af8481d),
+     TOBN(0x94a35f64, 0x8532b8e4), TOBN(0xc2cf81f8, 0x2227ce87),
+     TOBN(0x2c0a163f, 0x7f8ce7c5), TOBN(0xe9de5d0f, 0xba5e1907),
+     TOBN(0x0a58d572, 0xc1c14999), TOBN(0x406a3ecc, 0xd934e441),
+     TOBN(0xf9ef9a75, 0xc315d861), TOBN(0xa18abeae, 0x864a28bd),
+     TOBN(0x9e65f3c3, 0x60831100), TOBN(0xf757107b, 0x2d4749cd),
+     TOBN(0x8fec38eb, 0xe8d782bb), TOBN(0x74b4d444, 0xbe94b2ae),
+     TOBN(0x796fc73b, 0x59480d9b), TOBN(0x9f33407a, 0xe0555912),
+     TOBN(0xbc428d52, 0xbcd9a4bb), TOBN(0xffe3b15b, 0x82ac0b57),
+     TOBN(0x0f4cbd0a, 0xab58a714), TOBN(0xe3b57ece, 0x353b82bf),
+     TOBN(0x67e16b95, 0xf77aa72a), TOBN(0x7b5d3eda, 0x112a81cc),
+     TOBN(0x6795b775, 0x8d749470), TOBN(0x334bb4fc, 0xfe097d37),
+     TOBN(0x0489c0ce, 0x64deebc3), TOBN(0x0cf28e29, 0x85092a86),
+     TOBN(0x0cc8d80b, 0x29843096), TOBN(0x1f5107d7, 0x6aaf8c7c),
+     TOBN(0x6fb26e1a, 0xd1647601), TOBN(0x66da08d5, 0x2e2ca8c0),
+     TOBN(0xac0a6fbb, 0x34d9e92a), TOBN(0x596cc78b, 0x52203763),
+     TOBN(0x145521ab, 0x8e88a471), TOBN(0x9bdbd482, 0x64bde8f6),
+     TOBN(0x5a4d25bd, 0x01b4d2ea), TOBN(0xef1fc362, 0x6e7152ae),
+     TOBN(0xd188389a, 0xfba5462d), TOBN(0x951d4667, 0xf01d497c),
+     TOBN(0x294045fb, 0xbcc5466f), TOBN(0x145c2078, 0x039461a1),
+     TOBN(0x21c890c8, 0x2a620ace), TOBN(0x1ecc5928, 0x896d0458),
+     TOBN(0x14130b9c, 0xd3f9fb46), TOBN(0xf001b3c2, 0x461506dc),
+     TOBN(0xd90a95e2, 0x97a1b5c2), TOBN(0x9e37948e, 0xdf6487be),
+     TOBN(0x00ce787c, 0x3b165a95), TOBN(0x10d4f2a6, 0xe49c468d),
+     TOBN(0xf0f26eb8, 0xacd25333), TOBN(0x25b513b0, 0x63f3570b),
+     TOBN(0x98d08981, 0x9bc5917b), TOBN(0x9f90885d, 0x187fac5d),
+     TOBN(0x651b1828, 0x7cfc13db), TOBN(0x2d606e4c, 0x8655a658),
+     TOBN(0xba64d3c5, 0x63c91b71), TOBN(0x36c7d7d8, 0xb82a5090),
+     TOBN(0x2d1dff02, 0xcab1d598), TOBN(0xa95788d7, 0xbe78f90d),
+     TOBN(0x1ac2ee6b, 0x0ea1fe01), TOBN(0xc100b60c, 0xd5c1273c),
+     TOBN(0x4496084c, 0xeae603e7), TOBN(0x7fcaaf5f, 0x77c2fdfb)},
+    {TOBN(0xe8e3225a, 0x6abdd842), TOBN(0x8c85f18f, 0x3b367b02),
+     TOBN(0xf147a421, 0x9f42edb9), TOBN(0x6d4bc00d, 0x0d411d4d),
+     TOBN(0xa1a13a27, 0x70014bb4), TOBN(0xb896d97b, 0xfa10166f),
+     TOBN(0xb2a1dfa7, 0x0c302c6d), TOBN(0x0a24bd5d, 0x808a63a4),
+     TOBN(0x8409a3a2, 0xf88c7359), TOBN(0x071f3838, 0x347726a0),
+     TOBN(0xd18a551c, 0x27507bb9), TOBN(0xe0c4cc34, 0xb359b167),
+     TOBN(0xa44f6ef8, 0x80e9d9f3), TOBN(0xaa7621e9, 0x1d14d618),
+     TOBN(0xcb0e4ed8, 0x0eaf6671), TOBN(0x2bf485f8, 0x181514a2),
+     TOBN(0x74670e18, 0x0a2927ea), TOBN(0xe1b54616, 0x12c14645),
+     TOBN(0x4068c074, 0x2a67ed61), TOBN(0xd10c7a57, 0x739063ca),
+     TOBN(0x391b651d, 0x698b2816), TOBN(0xf310d169, 0x6da14fa8),
+     TOBN(0xa089be6b, 0xd8a578b1), TOBN(0xa314b3a8, 0x44389ad7),
+     TOBN(0x664ff053, 0x68ed0760), TOBN(0xc3cdc991, 0x38fae9fe),
+     TOBN(0x3fe057aa, 0xf1f30a86), TOBN(0xbae99022, 0x2d08c72a),
+     TOBN(0x4f5faf3f, 0x6f09e13f), TOBN(0x44461a44, 0x13d26b29),
+     TOBN(0xc2504c1b, 0xf95418ed), TOBN(0x12766ea7, 0xdb3ff26c),
+     TOBN(0x2f956e95, 0x07a22399), TOBN(0x2716e70f, 0x5a00cdd3),
+     TOBN(0x80c02014, 0x0e9fba99), TOBN(0xbe587ac3, 0x0519875d),
+     TOBN(0xba86aec1, 0x70128295), TOBN(0x83a09b65, 0xc12f35ce),
+     TOBN(0x8978ff07, 0x89df2f80), TOBN(0x85750cfd, 0x97a773d5),
+     TOBN(0x806bb730, 0xfc3f35f6), TOBN(0x04503422, 0xfed868c9),
+     TOBN(0xdc0fcde0, 0x86ffdbae), TOBN(0x8f4297e1, 0x1860f43b),
+     TOBN(0xfefb7d02, 0x8d3ad6cd), TOBN(0x5c652b59, 0x97293550),
+     TOBN(0x32e12942, 0xed5cfbba), TOBN(0x06192aaf, 0x98800d22),
+     TOBN(0xccf0fb42, 0x3c9eb0ca), TOBN(0x8703c669, 0x4aa03b40),
+     TOBN(0x44c735a7, 0x4001af07), TOBN(0x9616dd93, 0x2e874ed1),
+     TOBN(0x5c2e8520, 0x474ba621), TOBN(0xddf13cd3, 0xfa93d8b4),
+     TOBN(0xd68c9b45, 0x75df1b67), TOBN(0x4cd24228, 0x8f80d389),
+     TOBN(0x0f1a16bc, 0xc09f47fc), TOBN(0xc414dc6a, 0x9cd4842a),
+     TOBN(0xbb0fa94f, 0x1f353c6d), TOBN(0x40512455, 0x1950d073),
+     TOBN(0x935b9e24, 0x4d2edd5f), TOBN(0xfeb46fb5, 0xefb287b8),
+     TOBN(0xa51700a3, 0xf5018b92), TOBN(0xc328beba, 0x23864e2a),
+     TOBN(0x113b5c9a, 0x995f70c1), TOBN(0xc0b11c22, 0xda1b5d51),
+     TOBN(0x9b99b907, 0xf4a360cb), TOBN(0xf4ee9995, 0xadf0b094),
+     TOBN(0xf67c7cf2, 0xf94b3f0e), TOBN(0x664a51a1, 0xdcaf10cc),
+     TOBN(0xa3709ccc, 0xe937a669), TOBN(0xea97bace, 0x4862f098),
+     TOBN(0x51758334, 0xc942a3f5), TOBN(0x7cc01e88, 0x32182ba6),
+     TOBN(0x772af257, 0x74de4fe6), TOBN(0xb1b3c448, 0xe9667bf8),
+     TOBN(0x71cb2738, 0x8079caf6), TOBN(0x48890c64, 0x1d823a40),
+     TOBN(0x47a5887b, 0x0e9edbda), TOBN(0x916dfb0c, 0xbe089e5a),
+     TOBN(0x3185090e, 0x1eb42ddf), TOBN(0x3c7eaa13, 0xb7f3af26),
+     TOBN(0x940ed8c7, 0x9e9963b2), TOBN(0xd85e77db, 0x3426ac10),
+     TOBN(0x162cdf34, 0x2efffd95), TOBN(0x92111fda, 0xd59086e8),
+     TOBN(0x4478d114, 0x454eb977), TOBN(0x8ce403d8, 0xdea38a67),
+     TOBN(0xd459633b, 0x7435728a), TOBN(0x3a7be4e3, 0xa63b0504),
+     TOBN(0x0c74066b, 0x335dba3e), TOBN(0x4e8fb1d7, 0xc6ea6ee5),
+     TOBN(0x3398b588, 0xa99690ed), TOBN(0x4949517c, 0x3ad77562),
+     TOBN(0xf9824f09, 0xcbbb60ee), TOBN(0x9fdcafdf, 0x85660bec),
+     TOBN(0xf26bd861, 0x8875d9e8), TOBN(0x22e2380d, 0xbea9c273),
+     TOBN(0x5f151837, 0x91995508), TOBN(0xb97f40a6, 0x648aa1c6),
+     TOBN(0x7478f5f8, 0x3977d848), TOBN(0x21e876ae, 0x35b57de6),
+     TOBN(0xf620b180, 0xa93fc7f6), TOBN(0xf49bd07e, 0x1b148996),
+     TOBN(0xfb085726, 0x1c4f60e1), TOBN(0x6a6653af, 0x7ad6b84d),
+     TOBN(0x913a2d02, 0x2e05b686), TOBN(0x94746629, 0x407dda9a),
+     TOBN(0xb8465d16, 0xda684157), TOBN(0xdadde1ab, 0xb238faae),
+     TOBN(0xe2cd45e7, 0xc6b9bea8), TOBN(0x7251d4a1, 0x5cf413d5),
+     TOBN(0x615cea8b, 0xaae1765b), TOBN(0x75aa8318, 0x13f36885),
+     TOBN(0x7d5b0bf7, 0xb8767cc1), TOBN(0xec38a8ff, 0x8022968c),
+     TOBN(0x034805b6, 0x2a07faeb), TOBN(0x916f9eb0, 0x33b7321e),
+     TOBN(0x34963633, 0xc0c577ce), TOBN(0x8ee07efd, 0xabb8d3ce),
+     TOBN(0xa0bd6c0d, 0xa8a29345), TOBN(0xc676b6c5, 0x5d7f5ef9),
+     TOBN(0x303b6d7c, 0x20ad7259), TOBN(0x06542a19, 0xd8fe09a7),
+     TOBN(0x5a06653c, 0xa959014a), TOBN(0xf45fd79a, 0x5bcfe0cb),
+     TOBN(0x29058d98, 0x4e583468), TOBN(0xf1bd25e6, 0x0cd7afc0),
+     TOBN(0x2a88246e, 0xf7dbe54c), TOBN(0x680eaff8, 0x35e0ef3d),
+     TOBN(0x5942c97f, 0x726e59b9), TOBN(0x43e97139, 0x8d5c0825),
+     TOBN(0x2daddb11, 0xa406d4d7), TOBN(0xb02b5da5, 0xa2a33d81),
+     TOBN(0xb73ce827, 0x21a6aa89), TOBN(0x10919587, 0x467506de),
+     TOBN(0x0927724c, 0x428d8daa), TOBN(0x0ede991f, 0x7c17adfd),
+     TOBN(0x8518dab1, 0xbf7ddb3d), TOBN(0x04b091c4, 0x2a54e1b8),
+     TOBN(0x5943c37f, 0x89e7a398), TOBN(0x8e63f5e8, 0xe273f6f3),
+     TOBN(0xc6d0352b, 0x83143d22), TOBN(0x30e43182, 0xebd1628e),
+     TOBN(0x606658a9, 0x9991167e), TOBN(0xb8773e15, 0x72c4b43d),
+     TOBN(0x6cb364cd, 0xe025abce), TOBN(0xafa58e9b, 0x0c5a653e),
+     TOBN(0xa7e35a54, 0x134a68bf), TOBN(0xcb831d42, 0xba4d9db6),
+     TOBN(0xae37348e, 0xde83ef97), TOBN(0x4ac64a6a, 0x62ddd553),
+     TOBN(0x5feb5e0d, 0x715bb6b4), TOBN(0xf876efae, 0x043424b2),
+     TOBN(0x7b56a291, 0xad91a9ef), TOBN(0x817c7053, 0x356f3ade),
+     TOBN(0x3d6e8d6d, 0x8dff7dff), TOBN(0x6b6c194a, 0xd5be4ad1),
+     TOBN(0x57b93f2d, 0xb6fcd08b), TOBN(0x99f09948, 0xf3761f23),
+     TOBN(0x4062f3d6, 0xac8b018f), TOBN(0x4b58ac05, 0xa27af72c),
+     TOBN(0x4abcc815, 0x04d0cdfd), TOBN(0xa50043e0, 0xbda4b02f),
+     TOBN(0xe11297e5, 0x27a9c083), TOBN(0x2b2d8d52, 0x9779c5b3),
+     TOBN(0x3de3d330, 0xdfdecfed), TOBN(0xfe2487ca, 0xae7fc522),
+     TOBN(0x1c2fc508, 0x8f7a83e5), TOBN(0xa7c56233, 0xb9970c92),
+     TOBN(0x949c7173, 0x8bafa66f), TOBN(0x1e299b2d, 0x5bbb0490),
+     TOBN(0xb9a79e7c, 0x18fcb9e8), TOBN(0xe6372ce6, 0x9cb5cc50),
+     TOBN(0x114fc628, 0xf465c6aa), TOBN(0xc5539520, 0x8cb797f6),
+     TOBN(0x7df94ed7, 0xa73ad211), TOBN(0x41eb8e1f, 0x8e0cd008),
+     TOBN(0xb028725a, 0x004cbb0d), TOBN(0x1340186d, 0x372c1656),
+     TOBN(0x4074ee27, 0x978029bb), TOBN(0xa9394bda, 0xbae0d0c0),
+     TOBN(0xaa01d539, 0x72cecb4b), TOBN(0x4b0cf127, 0x9a7dd9c4),
+     TOBN(0x3e3e3f16, 0x5bc787cf), TOBN(0xdf48f7e1, 0x942de53f),
+     TOBN(0x0cc69719, 0x567b9d0e), TOBN(0x631e3315, 0x8d0d2750),
+     TOBN(0x9fedc1e2, 0x92314a09), TOBN(0x7547d226, 0x14a1adcb),
+     TOBN(0x405561a4, 0x8662b86a), TOBN(0x149fa2b1, 0xf5480b7d)},
+    {TOBN(0x923d0b44, 0xbda4aaa7), TOBN(0xced14ce4, 0xfee29f7b),
+     TOBN(0x1656be00, 0x9cf5b87d), TOBN(0x13a37d0d, 0x1d61103d),
+     TOBN(0x1d705880, 0xfb652393), TOBN(0x870a31bb, 0xed712ed8),
+     TOBN(0x15ad02e6, 0xad7c21e3), TOBN(0xf004e447, 0xc36c2831),
+     TOBN(0x56aa376c, 0xba2b3ffd), TOBN(0xc3be2b2f, 0x9745443c),
+     TOBN(0x47c8a870, 0xeb903660), TOBN(0x976c303e, 0x6c6c192d),
+     TOBN(0x148bd39c, 0xf4fb80d4), TOBN(0x469b208c, 0xfff04e65),
+     TOBN(0xf397fbe2, 0xce548415), TOBN(0x441e5c2c, 0x87fdde9f),
+     TOBN(0x6366b49f, 0xfee9c179), TOBN(0x38d02bd3, 0x2938dc71),
+     TOBN(0x26d450fa, 0xc49c5444), TOBN(0x4569f95d, 0x2b23d3d7),
+     TOBN(0x5f68bf4d, 0x298fd876), TOBN(0xe86df047, 0x544768b6),
+     TOBN(0x40b69a32, 0xf8491267), TOBN(0xcbf3adf9, 0xf917c71a),
+     TOBN(0x32498d4d, 0x8125489c), TOBN(0x965e8d07, 0xa5a46ae0),
+     TOBN(0x6cea5e47, 0xe96a7e29), TOBN(0xf78293a4, 0x668039ff),
+     TOBN(0x62548a96, 0xf63edd32), TOBN(0xe8e6af95, 0xa83e8256),
+     TOBN(0x76e60c3b, 0x0db6263b), TOBN(0xa1ee4b06, 0x21b3d668),
+     TOBN(0xa17dbf8b, 0x9e49b0b5), TOBN(0x4b29ba12, 0x7eb366fd),
+     TOBN(0x5e0ed781, 0xd29b565f), TOBN(0x8cb50d53, 0x199b36f9),
+     TOBN(0xa66c7035, 0x29aa3150), TOBN(0xd038a5ab, 0x479e61fc),
+     TOBN(0xdee33e96, 0xb5ab5410), TOBN(0xd068929c, 0x7c57d123),
+     TOBN(0x0839a208, 0xf1d6ad37), TOBN(0x8f523dab, 0x123f8178),
+     TOBN(0xb3e5e524, 0xa67d3840), TOBN(0x88bda75e, 0x52eb59df),
+     TOBN(0x513a0ab7, 0x389f2dd3), TOBN(0x3197a145, 0x890bba6f),
+     TOBN(0x61add75b, 0x6f66bf09), TOBN(0x5c9dfc15, 0x4eef1722),
+     TOBN(0x66dc2850, 0x07769b1b), TOBN(0xe07fb741, 0x4d71fac4),
+     TOBN(0x5ae688a6, 0xc2abbe60), TOBN(0x08ae92fa, 0xdcbfd296),
+     TOBN(0xbc291256, 0xb43044d1), TOBN(0x0e1d71ed, 0x9fcdf213),
+     TOBN(0xf0c5b281, 0x02485685), TOBN(0x5d3f9302, 0xe3f68f42),
+     TOBN(0xbbbfac50, 0xffe4f036), TOBN(0xb5b5f261, 0x74fdba44),
+     TOBN(0x4ebe1d07, 0x0d746760), TOBN(0xbb0f7812, 0xc37f04b7),
+     TOBN(0x810b6ab3, 0x6df1199d), TOBN(0xc229308b, 0xb4f293b7),
+     TOBN(0x3cf838dd, 0x89897750), TOBN(0x3e391e4e, 0x7a336c9a),
+     TOBN(0x70148337, 0x176f89c0), TOBN(0x54b15bac, 0xbc4f1e22),
+     TOBN(0x32b104f9, 0x2c0f2885), TOBN(0x2c39cefa, 0x67034f2a),
+     TOBN(0xb8310437, 0xbf178ac1), TOBN(0x722299f5, 0xc99370d5),
+     TOBN(0x0a493cf0, 0x332b93a8), TOBN(0x00e0ab41, 0xa420f719),
+     TOBN(0xf2592543, 0x4cab24da), TOBN(0x52be9bbc, 0xe7c3b9c5),
+     TOBN(0xaab7a8b6, 0x4660d1a0), TOBN(0x09738b81, 0x9a9600f4),
+     TOBN(0x58f0c866, 0x37de9e3c), TOBN(0x0aea5cc1, 0x5db31f4f),
+     TOBN(0xe480406f, 0x499868be), TOBN(0x0d8fc7f0, 0xf6913a44),
+     TOBN(0x72823644, 0x35f2e14e), TOBN(0xb147b310, 0x45e37a93),
+     TOBN(0xb1e7aa5b, 0xf15c1af7), TOBN(0xa8685068, 0xb03e7713),
+     TOBN(0x21feb7fc, 0x21c34c2b), TOBN(0xab6a553a, 0xddb0140e),
+     TOBN(0x03a65576, 0x24b04e6f), TOBN(0x2531f186, 0x342cb0ad),
+     TOBN(0x088c4d54, 0xa24f6426), TOBN(0x9a0ee15c, 0x06a873ea),
+     TOBN(0xdbe0253f, 0xd33bc748), TOBN(0xdad3339f, 0x5db8ac9e),
+     TOBN(0xeaaf3681, 0x73e65901), TOBN(0x71f1fab2, 0xccbfa504),
+     TOBN(0xb7b84522, 0x4b0e163e), TOBN(0xe0fca837, 0x3c779f3b),
+     TOBN(0x710988eb, 0x46baf373), TOBN(0x8cceb935, 0xb57d5018),
+     TOBN(0x1864603f, 0xa45fdf17), TOBN(0x3dcaae73, 0xef48e6d0),
+     TOBN(0xadd9420b, 0x590322c5), TOBN(0x947783e3, 0x9b135f67),
+     TOBN(0xfde76368, 0x8bf5049f), TOBN(0xf00e4c18, 0x2caa4023),
+     TOBN(0x4d3b0f23, 0xd355b3d6), TOBN(0x181fabcc, 0x20d5799d),
+     TOBN(0x29499b40, 0xab2ad0af), TOBN(0xf6e66328, 0xf9a938aa),
+     TOBN(0xcd7b3c42, 0xbcbe922d), TOBN(0x2fe02b3b, 0x95dd1a5c),
+     TOBN(0xeb66bcbd, 0x24ef5c38), TOBN(0x7edcc21c, 0xe579c309),
+     TOBN(0x7b19d491, 0x16f6c900), TOBN(0x36019ecd, 0xb6317c2c),
+     TOBN(0x554ba553, 0x91d9001c), TOBN(0xa5e30b98, 0x14f31e44),
+     TOBN(0x3d1fe33b, 0xffda4032), TOBN(0x5dfec478, 0x2306675c),
+     TOBN(0xbe59305e, 0x000c91e7), TOBN(0x3c4e52a3, 0x25a6b879),
+     TOBN(0x02fcc14e, 0xc5ea88ac), TOBN(0xca29bb6d, 0x56d093b6),
+     TOBN(0x876aeda9, 0x0e6fe94d), TOBN(0xfa11a142, 0xd7225a9d),
+     TOBN(0xfea3ca05, 0x3d03fed8), TOBN(0x435854c6, 0xc54d5962),
+     TOBN(0xd7707374, 0x54a6dfd5), TOBN(0xb8960017, 0xa3e55d02),
+     TOBN(0xd4015a0c, 0x04d65c3e), TOBN(0x397f93d1, 0xe98a1204),
+     TOBN(0xb0efa2e5, 0x5f3ed850), TOBN(0x18f24469, 0x8a3ec67b),
+     TOBN(0xa35802f5, 0xd62cd9f9), TOBN(0x0ca9c15d, 0x4148436e),
+     TOBN(0x261a991d, 0x472b9d21), TOBN(0xd81a1ed6, 0xa2f8e875),
+     TOBN(0x942f213a, 0x699b6d63), TOBN(0x041a12fc, 0x0ae57758),
+     TOBN(0x61191c82, 0xbd70aabb), TOBN(0x3776eb8b, 0xee4c23b3),
+     TOBN(0xabe23e86, 0x52511222), TOBN(0x66dd967d, 0x30dabb91),
+     TOBN(0x77650c59, 0x7ed27424), TOBN(0x08ea2ebd, 0xab25a050),
+     TOBN(0xa410ba3a, 0xb6cb5a02), TOBN(0x6eb40d15, 0xd07c5c6b),
+     TOBN(0x0de81e91, 0x07dcc811), TOBN(0x996f46eb, 0x2631b7af),
+     TOBN(0x5a350ba7, 0x5b7a22f3), TOBN(0xf42b24e7, 0x634159af),
+     TOBN(0x07bae0ab, 0xc30952fd), TOBN(0x3488cda2, 0xd644e0b0),
+     TOBN(0x23ae40d0, 0xe2111e12), TOBN(0x650af54e, 0xc80cdb56),
+     TOBN(0x0f33a30b, 0x7d4aa2a8), TOBN(0x4e8d3e98, 0x442a00e8),
+     TOBN(0xa624ab37, 0x59a8bc95), TOBN(0x4b7e3fa6, 0x1c971228),
+     TOBN(0xe8229c42, 0x73aa694b), TOBN(0x0cc31029, 0x779288ab),
+     TOBN(0xf8eff30f, 0x57575e0e), TOBN(0xee5e0194, 0x7d52803e),
+     TOBN(0x32d87e55, 0x8a78f632), TOBN(0x48a06031, 0xe454904e),
+     TOBN(0xaa2cb8dd, 0x16c6e626), TOBN(0xadd098ac, 0x2c140452),
+     TOBN(0xd25f285d, 0x2d3031b1), TOBN(0xfb5fbbe1, 0x75b59543),
+     TOBN(0x2297041f, 0xd7a21503), TOBN(0xfe7738c2, 0x657f03f0),
+     TOBN(0x994a8deb, 0x168fa34a), TOBN(0x0c772e02, 0xa53c4fdb),
+     TOBN(0x67f835d1, 0x50124cd3), TOBN(0x0e0d2635, 0x6993cbbe),
+     TOBN(0x9857ed84, 0x5257f11d), TOBN(0xdc23a728, 0xac556942),
+     TOBN(0xf0e1bb29, 0xdeb32a7f), TOBN(0xb8c3c43f, 0xee0d70f4),
+     TOBN(0xc294b0ef, 0xc60ad214), TOBN(0xa4d438dc, 0x679067ca),
+     TOBN(0x520b0bb9, 0x05c755e4), TOBN(0xa2c2c59b, 0xf89f0048),
+     TOBN(0x85c1c73a, 0x73c23975), TOBN(0x6e4dec49, 0x783aabba),
+     TOBN(0x69f0c69b, 0xb0463155), TOBN(0x61a42b94, 0x9c97b17b),
+     TOBN(0x55af24a9, 0x45d331a3), TOBN(0x4b0e63f8, 0xf5fe81fd),
+     TOBN(0x4034283d, 0x708671c4), TOBN(0x200ddab3, 0x5fd9001a),
+     TOBN(0xe45f28e4, 0x342eaf3b), TOBN(0x3e8375b4, 0x1ba936c4)},
+    {TOBN(0xb083ba6a, 0xec074aea), TOBN(0x46fac5ef, 0x7f0b505b),
+     TOBN(0x95367a21, 0xfc82dc03), TOBN(0x227be26a, 0x9d3679d8),
+     TOBN(0xc70f6d6c, 0x7e9724c0), TOBN(0xcd68c757, 0xf9ebec0f),
+     TOBN(0x29dde03e, 0x8ff321b2), TOBN(0xf84ad7bb, 0x031939dc),
+     TOBN(0xdaf590c9, 0x0f602f4b), TOBN(0x17c52888, 0x49722bc4),
+     TOBN(0xa8df99f0, 0x089b22b6), TOBN(0xc21bc5d4, 0xe59b9b90),
+     TOBN(0x6f577529, 0x51c2bb65), TOBN(0x4a0c1c28, 0x4b874bdb),
+     TOBN(0x19a18427, 0x78b96c6d), TOBN(0xa674f992, 0x2f593505),
+     TOBN(0x5abeeec4, 0x6b7209d6), TOBN(0x42d15d01, 0x47cf5fff),
+     TOBN(0xe24509b7, 0xb49e3b4e), TOBN(0x81be939c, 0x639ee6e8),
+     TOBN(0x7f7daf59, 0x5761e8e3), TOBN(0xed5cfcb8, 0xd420a288),
+     TOBN(0x365b29eb, 0x7a0ff696), TOBN(0x7d146805, 0x99a1ac8f),
+     TOBN(0x4936c6a0, 0x8a31973f), TOBN(0x54d442fa, 0x83b8c205),
+     TOBN(0x03aee8b4, 0x5714f2c6), TOBN(0x139bd692, 0x3f5ac25a),
+     TOBN(0x6a2e42ba, 0xb5b33794), TOBN(0x50fa1164, 0x3ff7bba9),
+     TOBN(0xb61d8643, 0xf7e2c099), TOBN(0x2366c993, 0xbd5c6637),
+     TOBN(0x62110e14, 0x72eb77fa), TOBN(0x3d5b96f1, 0x3b99c635),
+     TOBN(0x956ecf64, 0xf674c9f2), TOBN(0xc56f7e51, 0xef2ba250),
+     TOBN(0x9ee1ec3a, 0xadcdaa68), TOBN(0xd98c498f, 0xdcbb6548),
+     TOBN(0x32b97375, 0x88102ac0), TOBN(0xdd296cf9, 0xc08527f4),
+     TOBN(0xb74f8145, 0xfae3dfbe), TOBN(0x84131eb9, 0x6cd7cc4f),
+     TOBN(0xa0f2fe7a, 0x927ff15b), TOBN(0x6b0ade4d, 0xeee1a4b4),
+     TOBN(0x6e7df2d4, 0x0eeb90a7), TOBN(0xe2f46e20, 0xbe4de684),
+     TOBN(0xcd28feba, 0x3fdd06bc), TOBN(0x8e4205ae, 0xe6d6d9f6),
+     TOBN(0x246ffcb6, 0xff602c1b), TOBN(0x1e1a1d74, 0x6e1258e0),
+     TOBN(0xb4b43ae2, 0x250e6676), TOBN(0x95c1b5f0, 0x924ce5fa),
+     TOBN(0x2555795b, 0xebd8c776), TOBN(0x4c1e03dc, 0xacd9d9d0),
+     TOBN(0xe1d74aa6, 0x9ce90c61), TOBN(0xa88c0769, 0xa9c4b9f9),
+     TOBN(0xdf74df27, 0x95af56de), TOBN(0x24b10c5f, 0xb331b6f4),
+     TOBN(0xb0a6df9a, 0x6559e137), TOBN(0x6acc1b8f, 0xc06637f2),
+     TOBN(0x9ad73168, 0xf4a59550), TOBN(0x2a488d69, 0x8409d7af),
+     TOBN(0x9e946c2d, 0x30b3a5f4), TOBN(0x7bc4ced7, 0xc89723d5),
+     TOBN(0x79f514a1, 0xbd31f607), TOBN(0x7d493f59, 0x3a274341),
+     TOBN(0x7eb01027, 0xd45d55d1), TOBN(0x63f76909, 0x14735d1e),
+     TOBN(0x718d760f, 0x35be21cb), TOBN(0xba58160b, 0x7c793331),
+     TOBN(0xfbc0ce1f, 0x8d30d29e), TOBN(0x4645c0c2, 0xc6f4b03a),
+     TOBN(0xbd8c0868, 0x34b4e381), TOBN(0x278cacc7, 0x30dff271),
+     TOBN(0x87ed12de, 0x02459389), TOBN(0x3f7d98ff, 0xdef840b6),
+     TOBN(0x71eee0cb, 0x5f0b56e1), TOBN(0x462b5c9b, 0xd8d9be87),
+     TOBN(0xe6b50b5a, 0x98094c0f), TOBN(0x26f3b274, 0x508c67ce),
+     TOBN(0x418b1bd1, 0x7cb1f992), TOBN(0x607818ed, 0x4ff11827),
+     TOBN(0xe630d93a, 0x9b042c63), TOBN(0x38b9eff3, 0x8c779ae3),
+     TOBN(0x35d47426, 0xf78d33ef), TOBN(0x4af25db2, 0x8440c42c),
+     TOBN(0xbd6a15e2, 0x2e91bf5e), TOBN(0xe366a84c, 0xc08b6b1a),
+     TOBN(0x759c122f, 0x55b97de8), TOBN(0xecec558f, 0x08a03f29),
+     TOBN(0xdcc9fca2, 0xea9d2060), TOBN(0xb3e49b8e, 0x9f361fe1),
+     TOBN(0xdeae3902, 0x9b59cd04), TOBN(0xf532ede0, 0x6f5e5bd4),
+     TOBN(0x84fbeeb9, 0x36099f4d), TOBN(0x73576b1f, 0x088d2052),
+     TOBN(0xe8767d36, 0x729c5431), TOBN(0xa8bd07c0, 0xbb94642c),
+     TOBN(0x0c11fc8e, 0x58f2e5b2), TOBN(0xd8912d48, 0x547533fe),
+     TOBN(0xaae14f5e, 0x230d91fb), TOBN(0xc122051a, 0x676dfba0),
+     TOBN(0x9ed4501f, 0x5ea93078), TOBN(0x2758515c, 0xbd4bee0a),
+     TOBN(0x97733c6c, 0x94d21f52), TOBN(0x139bcd6d, 0x4ad306a2),
+     TOBN(0x0aaecbdc, 0x298123cc), TOBN(0x102b8a31, 0x1cb7c7c9),
+     TOBN(0x2b85dd03, 0x139a9f83), TOBN(0x02740ec2, 0xf55cbff9),
+     TOBN(0xdca3616a, 0xdc3bd5f6), TOBN(0x52843de5, 0xa5da9b2c),
+     TOBN(0x7ee7890a, 0x1e22c1cb), TOBN(0xd5cf1511, 0x4aee5c76),
+     TOBN(0x86d70af0, 0xc7234c24), TOBN(0x1735378b, 0x6b6a709f),
+     TOBN(0x9989ed21, 0x423f32e5), TOBN(0x4675a4ff, 0xe739b1fd),
+     TOBN(0x873edb62, 0x304ce529), TOBN(0x60b6624a, 0x7f1db13e),
+     TOBN(0x22a28e59, 0xfaf46675), TOBN(0x10757308, 0x10a31e7d),
+     TOBN(0xc7eeac84, 0x2b4c2f4f), TOBN(0xba370148, 0xb5ef5184),
+     TOBN(0x4a5a2866, 0x8732e055), TOBN(0x14b8dcdc, 0xb887c36f),
+     TOBN(0xdba8c85c, 0x433f093d), TOBN(0x73df549d, 0x1c9a201c),
+     TOBN(0x69aa0d7b, 0x70f927d8), TOBN(0xfa3a8685, 0xd7d2493a),
+     TOBN(0x6f48a255, 0x0a7f4013), TOBN(0xd20c8bf9, 0xdd393067),
+     TOBN(0xee43828c, 0x6b512bc6), TOBN(0xf73dc9f5, 0x50b91e60),
+     TOBN(0x68f23f30, 0xf5dbde6b), TOBN(0xaf2fe9e3, 0xddd15e00),
+     TOBN(0xfbf34dae, 0x86578d49), TOBN(0x68979655, 0x6c130010),
+     TOBN(0x137a5fc3, 0x09942897), TOBN(0xff1f0bfe, 0x9959f06d),
+     TOBN(0x2dd0a04a, 0xbd7ee14b), TOBN(0x59c46072, 0xe54e2161),
+     TOBN(0xf470bdae, 0xea7518ad), TOBN(0xce556e43, 0x40c471cd),
+     TOBN(0x4ec874ea, 0x81625e78), TOBN(0x8b8d8b5a, 0x3fbe9267),
+     TOBN(0xa3d9d164, 0x9421ec2f), TOBN(0x490e92d9, 0x880ea295),
+     TOBN(0x745d1edc, 0xd8f3b6da), TOBN(0x0116628b, 0x8f18ba03),
+     TOBN(0x0ff6bce0, 0x834eadce), TOBN(0x464697f2, 0x000827f7),
+     TOBN(0x08dccf84, 0x498d724e), TOBN(0x7896d365, 0x1e88304c),
+     TOBN(0xe63ebcce, 0x135e3622), TOBN(0xfb942e8e, 0xdc007521),
+     TOBN(0x6b97dae4, 0x829ee0c7), TOBN(0xcaaad7e3, 0xf274bc7d),
+     TOBN(0x87bee424, 0x512f7d86), TOBN(0xb5a03e5b, 0x3f7b0dde),
+     TOBN(0xc29db9c1, 0xf9fca5a8), TOBN(0x538a6f8b, 0xede64af8),
+     TOBN(0x0e518ba8, 0x8b3c715f), TOBN(0xc1cb4c31, 0x3cb5b861),
+     TOBN(0x5cd61604, 0xc76dbfa0), TOBN(0xc557e50d, 0xffdac22e),
+     TOBN(0x7892fc51, 0xf67b53e8), TOBN(0xa42f85c1, 0xea7c141c),
+     TOBN(0xbb155a66, 0xa3688621), TOBN(0xed2fd7cd, 0xf91b52a3),
+     TOBN(0x52798f5d, 0xea20cb88), TOBN(0x069ce105, 0x373f7dd8),
+     TOBN(0xf9392ec7, 0x8ca78f6b), TOBN(0xb3013e25, 0x6b335169),
+     TOBN(0x1d92f800, 0x6b11715c), TOBN(0xadd4050e, 0xff9dc464),
+     TOBN(0x2ac22659, 0x8465b84a), TOBN(0x2729d646, 0x465b2bd6),
+     TOBN(0x6202344a, 0xe4eff9dd), TOBN(0x51f3198f, 0xcd9b90b9),
+     TOBN(0x2ba8c790, 0x22b25f2e), TOBN(0xf4670a51, 0x1af0f4a8),
+     TOBN(0x6842f36a, 0x2fc2451e), TOBN(0xfc5c9558, 0xbb91e1e3),
+     TOBN(0x035d1dfc, 0xc3ead762), TOBN(0x3d0721cb, 0x031e5556),
+     TOBN(0x3af0cc81, 0x3af18a2e), TOBN(0x7888cee2, 0xbd11a363),
+     TOBN(0x80c3de0a, 0x6ade1d12), TOBN(0xe8c3a5bd, 0x93b2dcb5),
+     TOBN(0xe3adbd7c, 0x90a2214d), TOBN(0xfe8646d5, 0x1192948d)},
+    {TOBN(0x65026297, 0xba958101), TOBN(0xbeb4adf9, 0x8eef151d),
+     TOBN(0x623763a4, 0x60c8bbf7), TOBN(0xfa8f5ad7, 0x8b2a7120),
+     TOBN(0xfd744bdf, 0x085497e7), TOBN(0xf9b6f97e, 0x2ba35618),
+     TOBN(0x0cebfe9d, 0xf8a15e86), TOBN(0x47a6d013, 0x29576088),
+     TOBN(0x655817a3, 0xfcf19627), TOBN(0x30ab44f7, 0xc2f11261),
+     TOBN(0xbb001c9d, 0xddf2c850), TOBN(0xb45c7eff, 0x073260c3),
+     TOBN(0xfa7d1236, 0xe2319f38), TOBN(0x9ba1a1c0, 0xa551d3fe),
+     TOBN(0x9ea27288, 0xbeb1282b), TOBN(0x1c069efa, 0x07fee8a9),
+     TOBN(0x5749c7b5, 0x5870fee9), TOBN(0xbedca76f, 0xafcec6fa),
+     TOBN(0xa3f8f1b1, 0x4c63c5e2), TOBN(0xaa1bb156, 0x94758ac3),
+     TOBN(0x753329a9, 0xb59dc06e), TOBN(0xfa8e5f5b, 0x98a92c38),
+     TOBN(0x6b6f46fd, 0x3c2b4662), TOBN(0x716f41a1, 0xec04c6c6),
+     TOBN(0x0430af77, 0x59b11c7a), TOBN(0xf71cc5b1, 0xd4f47aca),
+     TOBN(0xe1a7905f, 0x12e9190f), TOBN(0x1c689b70, 0x12db9e14),
+     TOBN(0x6bdd3dc9, 0x0abaeeac), TOBN(0x97f1c244, 0x504f0319),
+     TOBN(0x874afd61, 0xa7a54b51), TOBN(0xd4604ecb, 0xe3d979b8),
+     TOBN(0x0d33eee1, 0xebf4aab1), TOBN(0xa3631cac, 0x1aa49fe6),
+     TOBN(0x0d8340fb, 0xf2217cfd), TOBN(0xf6373284, 0x423b7e77),
+     TOBN(0x78a53b5a, 0x9563e3bb), TOBN(0x19c75eb2, 0x86af355c),
+     TOBN(0x3520f427, 0x019a6f8e), TOBN(0xde6fcad6, 0xdc3ad0ba),
+     TOBN(0xfec96e4f, 0x79745b7c), TOBN(0x5e566bbd, 0xb133f2dc),
+     TOBN(0x50088a2b, 0x26561be7), TOBN(0x16275b4c, 0xc5fddfc7),
+     TOBN(0xf21332ff, 0x23ae4b9d), TOBN(0x8cbc659e, 0x85246712),
+     TOBN(0x27fa9c8d, 0xf50b515e), TOBN(0x25ecf745, 0x494ac8b7),
+     TOBN(0x437b7224, 0x641e3bd1), TOBN(0x84e39f79, 0x80a58460),
+     TOBN(0x68e52927, 0x09759523), TOBN(0x0176a3ac, 0xe77f5904),
+     TOBN(0xde92fb15, 0xe151e242), TOBN(0x79965c9a, 0xeb1438d4),
+     TOBN(0x318a810a, 0x596700b9), TOBN(0xa8a6ec57, 0xc2198cbe),
+     TOBN(0xd7709aaa, 0xbf030fd2), TOBN(0xb4320234, 0x72f5d326),
+     TOBN(0xc9945214, 0xb03bce50), TOBN(0x0bc06d9b, 0xd4ecba09),
+     TOBN(0xa1972c21, 0x96fffb94), TOBN(0xbe040930, 0x99d7633b),
+     TOBN(0xb116ff40, 0x7e23d66e), TOBN(0xcb12b2bb, 0x949a19f1),
+     TOBN(0x75df10ee, 0x79e49e91), TOBN(0xa3bf9076, 0x4890bcf4),
+     TOBN(0xcbaa76a6, 0x09a30252), TOBN(0x17c224a9, 0x0ee5728e),
+     TOBN(0xcbc56e5c, 0xf4f3f4cb), TOBN(0x8a07110f, 0x4fe868a5),
+     TOBN(0x23289f21, 0x25e110a2), TOBN(0x0289c12b, 0xd7693c45),
+     TOBN(0x06ba6db1, 0xf184c91f), TOBN(0x3c0a348a, 0x45fd0382),
+     TOBN(0x0d535b6e, 0x4434b527), TOBN(0x7bbfa2c8, 0x692bae0b),
+     TOBN(0x5c59a08e, 0xbe7fe51c), TOBN(0xbaa7d2be, 0x36e80cb8),
+     TOBN(0x8a42d8d1, 0xbed3cae8), TOBN(0xd9e0bc0d, 0x15ff4962),
+     TOBN(0xe51fce93, 0x644c75ff), TOBN(0x40222561, 0xb9392d63),
+     TOBN(0x8ab1d286, 0x023b4787), TOBN(0xfa85c220, 0xa1b3190d),
+     TOBN(0x29864753, 0x2b0c535b), TOBN(0x90dd6953, 0x70506296),
+     TOBN(0x038cd6b4, 0x216ab9ac), TOBN(0x3df9b7b7, 0xbe12d76a),
+     TOBN(0x13f4d978, 0x5f347bdb), TOBN(0x222c5c9c, 0x13e94489),
+     TOBN(0x5f8e796f, 0x2680dc64), TOBN(0x120e7cb7, 0x58352417),
+     TOBN(0x254b5d8a, 0xd10740b8), TOBN(0xc38b8efb, 0x5337dee6),
+     TOBN(0xf688c2e1, 0x94f02247), TOBN(0x7b5c75f3, 0x6c25bc4c),
+     TOBN(0x1213a2fc, 0x938e2480), TOBN(0x2dff0ea8, 0xed7b85a1),
+     TOBN(0x4f280c74, 0x0cc9619f), TOBN(0x3a215bc5, 0x66678817),
+     TOBN(0xa51602ca, 0x327985a8), TOBN(0xd6916920, 0x10f02615),
+     TOBN(0xd01274aa, 0x3dc4f2b6), TOBN(0x40feccd7, 0x3ff804d1),
+     TOBN(0xe508a27c, 0xa2100fa4), TOBN(0x37cc757e, 0xd90cc776),
+     TOBN(0xaec4884b, 0xb74827c4), TOBN(0x0c904582, 0x4ac34a27),
+     TOBN(0x6ad3f9d3, 0xf761baaa), TOBN(0x3936d0d9, 0xa5ae6088),
+     TOBN(0x54d5bff0, 0x83a0dd41), TOBN(0x418c4b20, 0x70cfa7fe),
+     TOBN(0xdc4d4742, 0x892317fc), TOBN(0x1248e2c0, 0x265359a1),
+     TOBN(0xa14ee83c, 0x2120ad82), TOBN(0x048b7b27, 0x89260c26),
+     TOBN(0x637e71d5, 0xb5fe2775), TOBN(0x849213d5, 0xf3e08f62),
+     TOBN(0x8a8a2da8, 0x5a9faeb1), TOBN(0x57047761, 0xef96612f),
+     TOBN(0x7608efa7, 0x027a3ba4), TOBN(0x14cb67ad, 0xcf450422),
+     TOBN(0xc55a7aae, 0x5330ef70), TOBN(0x3f18a78d, 0x64901358),
+     TOBN(0x264d3a5c, 0xfeb668df), TOBN(0xdc0569c0, 0xbcf7c23b),
+     TOBN(0x93af8a9b, 0x6ae18907), TOBN(0x55dd3e3a, 0x24b8e961),
+     TOBN(0x1c3fcd34, 0x36171692), TOBN(0xfc0ab80c, 0x2f1f7ca5),
+     TOBN(0x0dadc166, 0x564878a7), TOBN(0x7d20d34b, 0x000d81f3),
+     TOBN(0x0e8d03f8, 0xb19231b4), TOBN(0xe4498dbd, 0xdcda852b),
+     TOBN(0x9963a6bb, 0x31a8dddb), TOBN(0x80bfba33, 0xd949c6cf),
+     TOBN(0x72e48395, 0x1b6e1ab7), TOBN(0x35a2a802, 0x82d7301d),
+     TOBN(0xcfce9b91, 0x01edd784), TOBN(0x794ab50e, 0xcd9bcb9c),
+     TOBN(0xe1f90e0c, 0xf465c3ca), TOBN(0xb7ded4b5, 0x902b1b57),
+     TOBN(0xe593dafc, 0x8a8c27b4), TOBN(0xa80faad4, 0x6f940ca0),
+     TOBN(0x5396fd32, 0x421e65d3), TOBN(0x6c826fe2, 0x15e91d37),
+     TOBN(0x14c80f4a, 0x3cc3d9cb), TOBN(0xdb760a13, 0x43028c7f),
+     TOBN(0xd7a541bd, 0xce1a3e42), TOBN(0x4726a5b7, 0xb81193f1),
+     TOBN(0x5c96916d, 0xf004d745), TOBN(0xc86961c0, 0xad031ec3),
+     TOBN(0xb5a73c58, 0xb8d28a4f), TOBN(0x9a7bcb0e, 0x7ed16163),
+     TOBN(0x3f6871f3, 0x2fbd18f5), TOBN(0xebef020a, 0x42155e84),
+     TOBN(0xce6c810c, 0x4cdd5d8c), TOBN(0x9fc290a4, 0x078c9bc1),
+     TOBN(0x84debffd, 0x96d47e78), TOBN(0xf291d301, 0x143590fe),
+     TOBN(0x7cc5c36d, 0x69111f3a), TOBN(0x3a2cdc42, 0x46311370),
+     TOBN(0xd3d8bb98, 0x9e6f14a7), TOBN(0xfeb97d41, 0x481e22db),
+     TOBN(0xe1e20cfb, 0x462748fe), TOBN(0xcf8f5dd0, 0xa2eaf3c7),
+     TOBN(0xb4f9acd4, 0x302a52d4), TOBN(0x1c154dcd, 0x8d715c96),
+     TOBN(0x5f492236, 0xb13ddc9c), TOBN(0xc930fb0e, 0xbabe466c),
+     TOBN(0x21daa0b9, 0x5c017d52), TOBN(0xc182a975, 0xea9a6c9b),
+     TOBN(0x45d3d6c0, 0x4fd839af), TOBN(0x9e4ce10a, 0x3d89b744),
+     TOBN(0x906af540, 0x3a947f16), TOBN(0xa0f8e1b7, 0xa377f4f3),
+     TOBN(0x268360cc, 0xe343d7c1), TOBN(0x66fe9eb7, 0xbddbeb1a),
+     TOBN(0xf5c80368, 0xc3bafefc), TOBN(0x0e183ee0, 0x6664d04e),
+     TOBN(0x36c9dbbe, 0xfda8520e), TOBN(0x573507ce, 0x6ae3ea98),
+     TOBN(0x1ab38db6, 0x96a8f9f1), TOBN(0xe031d235, 0x6b01e6bc),
+     TOBN(0x10466ae6, 0x8afc4ada), TOBN(0x3b35df41, 0xed9c44e4),
+     TOBN(0x61272c12, 0xc7bd99e8), TOBN(0x6a4ae7b4, 0x805afd79),
+     TOBN(0xf4c47a91, 0x0ecc49eb), TOBN(0xeb95dfec, 0xcbe84d5c),
+     TOBN(0x43f3b71c, 0x8ee497d7), TOBN(0x2547af52, 0x4c6fece4)},
+    {TOBN(0xe323ed0c, 0xced45039), TOBN(0x04ce0b67, 0xa90aa713),
+     TOBN(0x9c092f06, 0xe8d68e4e), TOBN(0xd8f5555a, 0xd0742e5d),
+     TOBN(0xe2d175bf, 0x00d3df92), TOBN(0x8ca55f15, 0x4f71aeab),
+     TOBN(0xd1762d72, 0x642d391d), TOBN(0x0dfdd3c2, 0xaec466bd),
+     TOBN(0x2caacb4c, 0x6281f2a7), TOBN(0x635ba470, 0x3603e53a),
+     TOBN(0x94a9811d, 0x49fecf29), TOBN(0x3a42cf09, 0x466bf361),
+     TOBN(0x0f05710b, 0x11bccf2f), TOBN(0x7113085a, 0x7aec1bc6),
+     TOBN(0x137da67a, 0x46b8d0e2), TOBN(0x454b89fc, 0x698b78cc),
+     TOBN(0xf2a6e1de, 0x258a9393), TOBN(0x5f1804e7, 0x16488e69),
+     TOBN(0x7c6c5502, 0x15b3bf35), TOBN(0x3b0e09a5, 0xb05c2ec1),
+     TOBN(0x4b9de30e, 0x92f15247), TOBN(0x09d4ca93, 0x27e70a0a),
+     TOBN(0x9c8b1634, 0x0d149363), TOBN(0x54a8287c, 0xce642137),
+     TOBN(0x49ecd6f3, 0x346a764e), TOBN(0xe46847f1, 0x4105e657),
+     TOBN(0xce9cb2b5, 0x7550f608), TOBN(0x45f1a1f7, 0xf4cf062e),
+     TOBN(0xcdb19a11, 0x2c27d38a), TOBN(0x36d375b2, 0x84e50b19),
+     TOBN(0xf4369154, 0x0dba6405), TOBN(0x4c9dc863, 0x040354dc),
+     TOBN(0x7229e70e, 0xa24d09cf), TOBN(0xe72aa86c, 0x7cf6831b),
+     TOBN(0x487fb684, 0x25392838), TOBN(0xe88bed04, 0x430b9b47),
+     TOBN(0xf8a8499b, 0x666fa8a8), TOBN(0xd0f94015, 0x71bba84a),
+     TOBN(0xb85e1b1d, 0x515e1328), TOBN(0x88a2636b, 0xa941e788),
+     TOBN(0xa045241d, 0x2b5dd8d8), TOBN(0x161be476, 0x332f0350),
+     TOBN(0x96c4b205, 0xa18fac6b), TOBN(0x5cbe8d5e, 0x73fc5337),
+     TOBN(0x6fc33fc6, 0xd00b6029), TOBN(0x07a914ee, 0x89aa3b79),
+     TOBN(0x35353eb7, 0xa4d4dd00), TOBN(0xc026bdc0, 0x673e8956),
+     TOBN(0xccda3721, 0x67103852), TOBN(0xf78d2247, 0x0c54de53),
+     TOBN(0xebd16036, 0xafa44aa5), TOBN(0x7b880248, 0x64a24ab9),
+     TOBN(0x86b38e96, 0x1c2bc78e), TOBN(0xd0aa0d05, 0x8d63b295),
+     TOBN(0x24912955, 0xc62fcbf1), TOBN(0x77a68156, 0xb9ac435c),
+     TOBN(0x432401c7, 0x1b360b26), TOBN(0x091f19f3, 0x4c58ef8c),
+     TOBN(0x3a4a61f4, 0x83d46c9d), TOBN(0xad0e5c72, 0xe8d616cd),
+     TOBN(0x33b029bc, 0xcdaa6831), TOBN(0x2548552d, 0x4c1f9ced),
+     TOBN(0x35f1a002, 0xdece1c8c), TOBN(0xc6b87fd7, 0xacc23aa5),
+     TOBN(0x0b8bb275, 0xbab029a4), TOBN(0xf07bc067, 0x30bfb42d),
+     TOBN(0x1688ff5d, 0x1f69ce9d), TOBN(0xeedb7b5e, 0xdb10585e),
+     TOBN(0xb7a88cf0, 0xd432c197), TOBN(0x20731bdd, 0x015a350a),
+     TOBN(0x5fa18354, 0x63223f5c), TOBN(0xe392e131, 0x8024693f),
+     TOBN(0xdfaeea0a, 0x0154731e), TOBN(0x9e53419d, 0xe15a0388),
+     TOBN(0x2ad6a83c, 0x25a992c8), TOBN(0xa2ba020f, 0xe125501a),
+     TOBN(0x894ebaf8, 0xd4dd04dc), TOBN(0xd48cb958, 0x50765559),
+     TOBN(0xf9b58d09, 0x80dec92b), TOBN(0x2a0e1165, 0x9da299d7),
+     TOBN(0x3c081853, 0xefe9cb11), TOBN(0xb9f3b702, 0xa511c5e0),
+     TOBN(0xa8f7a25f, 0x70486180), TOBN(0xc0358b25, 0x591b3e2f),
+     TOBN(0xf36e8398, 0xeaddf274), TOBN(0xe41553a1, 0x6a5e4ddb),
+     TOBN(0x36ab0746, 0x4efc5b0c), TOBN(0xb211e59a, 0xd316c434),
+     TOBN(0x2515ec9f, 0x16ccf839), TOBN(0x6ecb7465, 0x03dc6a07),
+     TOBN(0x842b7275, 0xc65c1b07), TOBN(0xf7ceeec5, 0x35750ab6),
+     TOBN(0x967d711c, 0xcef5255d), TOBN(0xcd3bfb07, 0x5108cb92),
+     TOBN(0xe50c0d8a, 0xec1b9740), TOBN(0x9e8d5661, 0x1a9e6308),
+     TOBN(0x84f8ea13, 0xccb8a36a), TOBN(0x5f7aeeff, 0xa05709a2),
+     TOBN(0x4942d04e, 0x60574f37), TOBN(0x855b13e9, 0xe048b400),
+     TOBN(0x747e4067, 0xa6b59c09), TOBN(0xc349fb05, 0x074d3990),
+     TOBN(0x398e6afa, 0xec2c7e03), TOBN(0xce361865, 0xec2d5a4c),
+     TOBN(0xfc04bf8e, 0xb6f57d22), TOBN(0xf0e0b84c, 0x759ce6c6),
+     TOBN(0xb6514123, 0x5ee7e528), TOBN(0x8ca144bd, 0xf5c0f9b9),
+     TOBN(0xc1370dae, 0xf6a58536), TOBN(0x6f2e5b37, 0xc56b0ae9),
+     TOBN(0x5511d682, 0x92f6b6a3), TOBN(0x2e9e5034, 0xae575249),
+     TOBN(0x3e5a32f8, 0x1d14bed7), TOBN(0xa346a86f, 0x75efd17a),
+     TOBN(0x4f2510a6, 0x0309fd7a), TOBN(0x689ecd74, 0xd0b1425e),
+     TOBN(0x9e9bebe1, 0x9f771e24), TOBN(0x20188045, 0xadc5b48c),
+     TOBN(0xe49811b6, 0xb845230b), TOBN(0x420855ec, 0x5a8687f8),
+     TOBN(0xe650e49a, 0xbae1b94d), TOBN(0xb6b162e6, 0xe3199794),
+     TOBN(0xdc706859, 0xb4ec0480), TOBN(0x28b618c2, 0x4b1a06ca),
+     TOBN(0x0929a001, 0x403acdc2), TOBN(0x796dfd97, 0x2da3aefd),
+     TOBN(0x16389072, 0xef4c1673), TOBN(0x600d8bd7, 0xfc94a4f5),
+     TOBN(0xf003214d, 0xe5f386a9), TOBN(0xa7af0499, 0xe62cbb48),
+     TOBN(0x750a3b00, 0xde82bad5), TOBN(0x6c615b83, 0x8e7dc8ee),
+     TOBN(0x283eec26, 0xd71543a6), TOBN(0x98fa08be, 0xa7627841),
+     TOBN(0x269a83b8, 0x27ad302d), TOBN(0x225f2f12, 0xbde3fdd0),
+     TOBN(0x046fcf38, 0x0130b3a6), TOBN(0xea733c1a, 0xc3ed9043),
+     TOBN(0xf870f14d, 0x70aa08d1), TOBN(0x643d18b8, 0x34391e0b),
+     TOBN(0xf3e1d5f4, 0x847be772), TOBN(0xa9498223, 0xd0ed73a0),
+     TOBN(0x6933ccf0, 0x14b3babb), TOBN(0xc2439ae4, 0x37f08f70),
+     TOBN(0xb643f4e0, 0xf88d049b), TOBN(0x5e0ac1fb, 0x12682fcf),
+     TOBN(0xeaf7874d, 0x9f981c8f), TOBN(0x9c2adfd2, 0xb1af779d),
+     TOBN(0x9a7abead, 0xdaa8c275), TOBN(0x09ad5521, 0x24cacec4),
+     TOBN(0x069cd5c4, 0x0ead1646), TOBN(0x5186bf19, 0x0a6157d1),
+     TOBN(0xcc222a93, 0x96503506), TOBN(0xfeaa7bde, 0xbd29686e),
+     TOBN(0xb0d65b0d, 0xa7257c8d), TOBN(0xc31c0a88, 0x98aa227f),
+     TOBN(0xb4b7651f, 0x5be1d45b), TOBN(0x0425200a, 0x7f0cf680),
+     TOBN(0x200d12b4, 0x8960be95), TOBN(0x02fdd1a1, 0x4945b193),
+     TOBN(0xedd70e3e, 0x27d046d8), TOBN(0xc1cc086a, 0x83f14e12),
+     TOBN(0x1580e72b, 0x2629396e), TOBN(0xc87439db, 0xf9ed73c1),
+     TOBN(0x5debdf30, 0xa90c5128), TOBN(0x0b6c020e, 0x9fbe14ef),
+     TOBN(0x168da56a, 0x0149a0b0), TOBN(0xc66a4dbd, 0x79c58ac6),
+     TOBN(0x800aec84, 0x330b8e2e), TOBN(0x1a2c033e, 0x335837bf),
+     TOBN(0xf1a91551, 0xfe6f6dd9), TOBN(0x326c42b2, 0x1de7360a),
+     TOBN(0x300e740b, 0x7b66f9d5), TOBN(0x53bcc700, 0x68ce95d4),
+     TOBN(0xc9e225ac, 0x3d80f228), TOBN(0x64b2ad4e, 0x6977dfdb),
+     TOBN(0xac863b08, 0x01f23221), TOBN(0x0517a648, 0xdf11e5f7),
+     TOBN(0xbf7aedcb, 0x68d11050), TOBN(0x2607e337, 0x77b3029c),
+     TOBN(0x1afa6aa6, 0x206add5d), TOBN(0x66cfbbae, 0x150ea4c9),
+     TOBN(0x07fb920b, 0x5d36da4f), TOBN(0x144d51f9, 0x291e774f),
+     TOBN(0x26c2c134, 0xf40d87a8), TOBN(0xc8cf3524, 0xa932f1a0),
+     TOBN(0x35bb2a42, 0x5aeb0bde), TOBN(0x5cfcc1da, 0xc4be960a),
+     TOBN(0x5c40cabf, 0xaa1838ed), TOBN(0xea0c05ff, 0xe2855f1f),
+     TOBN(0x931ebb02, 0xfd525934), TOBN(0x31a7b78f, 0x16246fd4)},
+    {TOBN(0xcd92906c, 0x6d6ae962), TOBN(0x62835615, 0x9807d881),
+     TOBN(0x0d692978, 0x1fdc1915), TOBN(0x45d01a8c, 0x269d611e),
+     TOBN(0xe7bd1e70, 0x9665b00a), TOBN(0x08638534, 0x9bcaa388),
+     TOBN(0x8f189e88, 0x2dd24299), TOBN(0x5f643392, 0xb82fb270),
+     TOBN(0xca65bf16, 0xc633b111), TOBN(0xc6adc9c9, 0xd6f1dac8),
+     TOBN(0x0df2c293, 0xa3c3381d), TOBN(0xdd6ae97d, 0x8388cd12),
+     TOBN(0xffdbd0eb, 0x3863db02), TOBN(0x8b825683, 0x2f57e10f),
+     TOBN(0xc11acead, 0x35e7a3a2), TOBN(0x4998cf8c, 0x67833028),
+     TOBN(0x8f3a346b, 0x844c7976), TOBN(0x0a9d872c, 0xdb9b1a1c),
+     TOBN(0x8735dabc, 0xb98d445d), TOBN(0x93790d80, 0x305fa0a9),
+     TOBN(0x7c0add49, 0xd267a01a), TOBN(0x2b46c913, 0xffa20d11),
+     TOBN(0xf2acef26, 0xd8ab2d4a), TOBN(0x71b701b9, 0x3d926080),
+     TOBN(0x7cae584d, 0xfbf536a1), TOBN(0x0af06fc2, 0x5b52faa9),
+     TOBN(0x807706dc, 0x2827b872), TOBN(0xf029478f, 0x59903742),
+     TOBN(0x0e8c393c, 0x85cd7aed), TOBN(0x2e1e6ade, 0xa331bee7),
+     TOBN(0xf5d13dad, 0xcdb7f97a), TOBN(0xdb22fed1, 0x8577c3cc),
+     TOBN(0x6f453180, 0x81e39043), TOBN(0x41d4bb25, 0xa00a806c),
+     TOBN(0xe6064b92, 0xe28670a7), TOBN(0x733a31c8, 0xa7c63f88),
+     TOBN(0xe9d2a98a, 0x5133de8e), TOBN(0x37083b60, 0xb81b8b00),
+     TOBN(0xf399325d, 0xceaf86ae), TOBN(0x03b17c88, 0x8f161525),
+     TOBN(0xd8ac35c9, 0x84211b9d), TOBN(0x22083784, 0x9050ca48),
+     TOBN(0xa818c44b, 0xc9fab832), TOBN(0x8882bcce, 0xe5aea7da),
+     TOBN(0x633aaf35, 0xf8715b04), TOBN(0x5463e1b9, 0x9d8829a9),
+     TOBN(0xb18df52d, 0x84a820f1), TOBN(0x9d5ef891, 0xd096675d),
+     TOBN(0x394174d0, 0xc2b47dd2), TOBN(0x06b117a8, 0x30a87997),
+     TOBN(0xcfd81d41, 0x894731e5), TOBN(0x6476b1af, 0xc84e7d05),
+     TOBN(0x37069fe2, 0x743b8218), TOBN(0x93f21550, 0xa36173d8),
+     TOBN(0xa8ae70f4, 0xedadef86), TOBN(0xdac5d021, 0x76366073),
+     TOBN(0x4063ba57, 0x1c982076), TOBN(0xc3471b5f, 0x2d24d61e),
+     TOBN(0x57b69c41, 0xae4d820f), TOBN(0xf73e14a4, 0xc463a391),
+     TOBN(0xd54e2c7c, 0xac60496d), TOBN(0xc06d5e5d, 0x04cd50a4),
+     TOBN(0xcb4105e8, 0xe60f7f59), TOBN(0x705db308, 0x427483ad),
+     TOBN(0xf73ba98b, 0xf2bff383), TOBN(0xa945611a, 0x0220e6e9),
+     TOBN(0xc01c46b8, 0xd957e12b), TOBN(0x458897b7, 0xacb1f371),
+     TOBN(0xf738dc0b, 0xfa3403e6), TOBN(0x098bc687, 0xd2202896),
+     TOBN(0xec0c217a, 0x5f882e5e), TOBN(0x8f25af77, 0xa1f4eb13),
+     TOBN(0x86e6a8fc, 0x195736e9), TOBN(0x88099bf3, 0x1a20620f),
+     TOBN(0xf3d9998b, 0x9cdc1db9), TOBN(0xf36d583e, 0x47042834),
+     TOBN(0xcd4519d8, 0x25a0d589), TOBN(0x78c435ab, 0x1e04a91d),
+     TOBN(0x0428e76e, 0xe44d9e31), TOBN(0x63994993, 0xce821aab),
+     TOBN(0xd167ceb7, 0x2625cfce), TOBN(0x9f242245, 0x0ddf2b89),
+     TOBN(0x182e33d6, 0x717ffb5e), TOBN(0x3800290e, 0x26de205c),
+     TOBN(0x2615c782, 0x59ee4124), TOBN(0x4dc2824c, 0x76532b4b),
+     TOBN(0x9c3b1d77, 0x1c84a04b), TOBN(0xb6fc203f, 0xcb9f9e34),
+     TOBN(0xbed65464, 0xc64f7846), TOBN(0x04f520a2, 0xeb004248),
+     TOBN(0x5c017727, 0x4a58fd22), TOBN(0x25958482, 0xc10d9472),
+     TOBN(0xb78c6666, 0xaceb0e3a), TOBN(0x18d3c188, 0xfc046f0a),
+     TOBN(0x7f3e2f30, 0x1baa9595), TOBN(0xa574f8cd, 0x8a2844e8),
+     TOBN(0x9fd2e524, 0x4bcc5a81), TOBN(0xc73e2598, 0xd3f2f80f),
+     TOBN(0xff838e9c, 0x15dc157c), TOBN(0x0b2491d2, 0xc522319e),
+     TOBN(0x2b65f042, 0x909592d6), TOBN(0xf113045c, 0x849f5dee),
+     TOBN(0x84fe31be, 0x9b287c3d), TOBN(0xd0481262, 0x80097bd0),
+     TOBN(0xaf203cba, 0x63660f87), TOBN(0x5621c3d8, 0x0ea001b3),
+     TOBN(0x125a5eaa, 0x346ea29b), TOBN(0x3dcec22c, 0x3ca79649),
+     TOBN(0xc899eba3, 0x81c2d81f), TOBN(0xb27267d6, 0xf3f0a431),
+     TOBN(0x607c8629, 0xda55568e), TOBN(0x6b547228, 0x2b1dc1d9),
+     TOBN(0x23232311, 0xc9c001ff), TOBN(0x207a2eb2, 0x488f8b85),
+     TOBN(0x3867ac9a, 0xdac37a28), TOBN(0xa36d14d3, 0x2584a5f0),
+     TOBN(0x7398c647, 0xa74488ff), TOBN(0xf6ed920f, 0xbe087640),
+     TOBN(0x72beddc7, 0x6319a571), TOBN(0x55c2cd82, 0x6a244aeb),
+     TOBN(0x42df5630, 0x9ede92f1), TOBN(0xe6957bc4, 0x76503aa7),
+     TOBN(0xe7abfe12, 0xfbec9577), TOBN(0x9660e762, 0x274b7f6c),
+     TOBN(0xf78af22c, 0x35f12ea2), TOBN(0x73ab1bbb, 0xb51bec2c),
+     TOBN(0x5e8e40e6, 0x1641f424), TOBN(0x1af751d9, 0x0905e4be),
+     TOBN(0xb5130ade, 0x1c033198), TOBN(0x96d47ab2, 0xa22f5f19),
+     TOBN(0x5aff3e66, 0x55340d4c), TOBN(0xab4aa5a7, 0x1bed65fa),
+     TOBN(0xb7da79c6, 0x25f8a53b), TOBN(0x6b950bdf, 0xd331ad8e),
+     TOBN(0x3481b7b5, 0x4aa36d18), TOBN(0x6efeaf88, 0xed0e3091),
+     TOBN(0xeb017bdd, 0xc993074c), TOBN(0x8431a6d6, 0x529dd654),
+     TOBN(0xf5177231, 0xbd069585), TOBN(0x6d753b10, 0x3ce85096),
+     TOBN(0x194d82d3, 0x4ca26741), TOBN(0xeaeffe15, 0xadcd1650),
+     TOBN(0x4dcec3d9, 0xaf7758b7), TOBN(0xf5fdf666, 0x4cc2c819),
+     TOBN(0x7e9ad6e8, 0xae850261), TOBN(0xbeb25ca0, 0x11960968),
+     TOBN(0x60c5f0ee, 0xad4cfa42), TOBN(0x81714b3f, 0xeca5c508),
+     TOBN(0x810e71d7, 0xb78a290f), TOBN(0x03536cec, 0x3260114c),
+     TOBN(0x24d29f0f, 0x6a16cdf6), TOBN(0xec45a58a, 0x4a4c964c),
+     TOBN(0xbaaa5fb3, 0xea344b44), TOBN(0xf1b7a68c, 0xfeb783f6),
+     TOBN(0x533c4b72, 0x3ddd7062), TOBN(0x6a33a0dc, 0x1598b5f7),
+     TOBN(0x94bdc7f4, 0xa9810744), TOBN(0x464195da, 0xf045d859),
+     TOBN(0x27e2dab0, 0xd654cb57), TOBN(0x1d4e1e53, 0x7a491956),
+     TOBN(0xa1ef570c, 0x31d5d099), TOBN(0x01cd21ee, 0x295f3de7),
+     TOBN(0x8681b00d, 0xb8249038), TOBN(0x17c31bce, 0x93781b71),
+     TOBN(0x4324e90c, 0x6a1b5748), TOBN(0x44f9324c, 0x1222e554),
+     TOBN(0xe30ba10f, 0xffd53dd0), TOBN(0x2e5817a8, 0xb48eeef0),
+     TOBN(0x6b0ee060, 0x24b3a9a7), TOBN(0xcf78c3fe, 0xd5f6545c),
+     TOBN(0x050bedaa, 0xfe0f2ec6), TOBN(0x0b7774b8, 0xb3e6b4f8),
+     TOBN(0x096b9e19, 0x2b4a853e), TOBN(0xa7463661, 0x0698f7ca),
+     TOBN(0xe1d1d1be, 0xf090c97b), TOBN(0xbc1e09d9, 0x55517a2f),
+     TOBN(0xb3e24dd5, 0x5868ee3d), TOBN(0xd6103494, 0xd7b83619),
+     TOBN(0xaf739559, 0x3b0129b3), TOBN(0xef42bb60, 0x3ded9fb3),
+     TOBN(0xa349bb66, 0xc8fccaa9), TOBN(0x7888755f, 0x31a53ee7),
+     TOBN(0xa6e1d891, 0xc18d3750), TOBN(0x9985aa4d, 0xae8d2bfb),
+     TOBN(0x8baec9ae, 0x31b33078), TOBN(0xee68295a, 0x98750e94),
+     TOBN(0x0d834bf8, 0xd6ddf305), TOBN(0xab33dff3, 0x9762126c),
+     TOBN(0x0c22faaa, 0x0c51d098), TOBN(0x32404042, 0xb887a10f),
+     TOBN(0x31f6a614, 0x248bed32), TOBN(0x311f8630, 0x1ce0d662)},
+    {TOBN(0xac6dbdf6, 0xedc9ce62), TOBN(0xa58f5b44, 0x0f9c006e),
+     TOBN(0x16694de3, 0xdc28e1b0), TOBN(0x2d039cf2, 0xa6647711),
+     TOBN(0xa13bbe6f, 0xc5b08b4b), TOBN(0xe44da930, 0x10ebd8ce),
+     TOBN(0xcd472087, 0x19649a16), TOBN(0xe18f4e44, 0x683e5df1),
+     TOBN(0xb3f66303, 0x929bfa28), TOBN(0x7c378e43, 0x818249bf),
+     TOBN(0x76068c80, 0x847f7cd9), TOBN(0xee3db6d1, 0x987eba16),
+     TOBN(0x1238e097, 0xae658422), TOBN(0xb4631ddb, 0x568df55f),
+     TOBN(0x451254e7, 0xf74c5c50), TOBN(0x238b16d2, 0x8805813b),
+     TOBN(0x23987b28, 0x925e7a6e), TOBN(0x93b72e2d, 0x2a1a10bc),
+     TOBN(0x944c784d, 0x05e44b7f), TOBN(0x7d70fd09, 0x8c8e3120),
+     TOBN(0x6bf1ab2a, 0xead45716), TOBN(0xd5f8f0e6, 0x31c04205),
+     TOBN(0xac062526, 0xa10b8881), TOBN(0xa1a83cf0, 0xfe5505a8),
+     TOBN(0xcbbd8576, 0xc42a2f52), TOBN(0x9acc6f70, 0x9d2b06bb),
+     TOBN(0xe5cb5620, 0x2e6b72a4), TOBN(0x5738ea0e, 0x7c024443),
+     TOBN(0x8ed06170, 0xb55368f3), TOBN(0xe54c99bb, 0x1aeed44f),
+     TOBN(0x3d90a6b2, 0xe2e0d8b2), TOBN(0x21718977, 0xcf7b2856),
+     TOBN(0x089093dc, 0xc5612aec), TOBN(0xc272ef6f, 0x99c1bacc),
+     TOBN(0x47db3b43, 0xdc43eaad), TOBN(0x730f30e4, 0x0832d891),
+     TOBN(0xac92ee15, 0x37d83369), TOBN(0xc968c187, 0xfecec65c),
+     TOBN(0x29a7ca87, 0x6e7a3265), TOBN(0x0f2b7e7a, 0x8456c9af),
+     TOBN(0x7471824e, 0x9754326f), TOBN(0x498687bf, 0x364d2ec8),
+     TOBN(0x86d8aacd, 0x3c6ee351), TOBN(0x01ee6823, 0xf6f41e85),
+     TOBN(0x9805fc88, 0x1d79f7eb), TOBN(0x377ac3a4, 0x0040547d),
+     TOBN(0xd39215d4, 0x61b4e90b), TOBN(0x2547416e, 0x4c5fd81b),
+     TOBN(0x9ffe5563, 0x0c7fecdb), TOBN(0x55cc67b6, 0xf88101e5),
+     TOBN(0x3039f981, 0xcbefa3c7), TOBN(0x2ab06883, 0x667bfd64),
+     TOBN(0x9007a257, 0x4340e3df), TOBN(0x1ac3f3fa, 0x5a3a49ca),
+     TOBN(0x9c7be629, 0xc97e20fd), TOBN(0xf61823d3, 0xa3dae003),
+     TOBN(0xffe7ff39, 0xe7380dba), TOBN(0x620bb9b5, 0x9facc3b8),
+     TOBN(0x2ddcb8cd, 0x31ae422c), TOBN(0x1de3bcfa, 0xd12c3c43),
+     TOBN(0x03621d34, 0xf6e10789), TOBN(0xc72143b8, 0x410c4004),
+     TOBN(0x886d00f6, 0x6ca2933a), TOBN(0xd0a22382, 0xde1494a2),
+     TOBN(0xb8656c4d, 0x0bdcdf82), TOBN(0x5199d9d3, 0xc4a58832),
+     TOBN(0xa982c1aa, 0xe1c0f449), TOBN(0xe9cefb90, 0x5a922bdb),
+     TOBN(0xfc268de4, 0x31390c6d), TOBN(0xea4160e1, 0x8c4fe595),
+     TOBN(0x6c427a63, 0x6790d82f), TOBN(0xaceb0154, 0xfc519907),
+     TOBN(0x8c074946, 0xd6e0f9a9), TOBN(0x662fa995, 0x51c3b05b),
+     TOBN(0x6cdae969, 0x04bb2048), TOBN(0x6dec9594, 0xd6dc8b60),
+     TOBN(0x8d265869, 0x54438bbc), TOBN(0x88e983e3, 0x1b0e95a5),
+     TOBN(0x8189f114, 0x60cbf838), TOBN(0x77190697, 0x771dc46b),
+     TOBN(0x775775a2, 0x27f8ec1a), TOBN(0x7a125240, 0x607e3739),
+     TOBN(0xafae84e7, 0x4f793e4e), TOBN(0x44fa17f3, 0x5bf5baf4),
+     TOBN(0xa10292b9, 0x07a6fbf8), TOBN(0x292c1a20, 0x3fa6235b),
+     TOBN(0x7a36f18f, 0x73ad7a1f), TOBN(0x8b2c7b0c, 0x5897b11f),
+     TOBN(0xf7b9a272, 0xcb664c61), TOBN(0xb6d366af, 0x8f81e22c),
+     TOBN(0x3b99b211, 0x8e342bba), TOBN(0x03ce158b, 0xb06ced2b),
+     TOBN(0x3af1175d, 0x001db74b), TOBN(0x526f0846, 0x7159cb8a),
+     TOBN(0x6a3c6e1f, 0xebde4601), TOBN(0xfad5963b, 0x8c232eac),
+     TOBN(0xa21e69a5, 0xd03ac439), TOBN(0x2069c5fc, 0x88aa8094),
+     TOBN(0xb041eea7, 0x8c08f206), TOBN(0x55b9d461, 0x3d65b8ed),
+     TOBN(0x951ea25c, 0xd392c7c4), TOBN(0x4b9a1cec, 0x9d166232),
+     TOBN(0xc184fcd8, 0xfcf931a4), TOBN(0xba59ad44, 0x063ad374),
+     TOBN(0x1868ad2a, 0x1aa9796f), TOBN(0x38a34018, 0xdff29832),
+     TOBN(0x01fc8801, 0x03df8070), TOBN(0x1282cce0, 0x48dd334a),
+     TOBN(0x21387e8a, 0x42a993b1), TOBN(0xbcb65533, 0x68b1f2a0),
+     TOBN(0x3161d87a, 0xa5f7e4b9), TOBN(0x927b4130, 0x1bce0a84),
+     TOBN(0x3aabd327, 0x87be0ae9), TOBN(0x0163c6aa, 0x0aed169d),
+     TOBN(0xad1e0f0e, 0x11584051), TOBN(0x1ba46302, 0x74093225),
+     TOBN(0xed045618, 0x0a6a1f01), TOBN(0x15d07c63, 0x6da060ed),
+     TOBN(0xa4584f72, 0xb7e003ae), TOBN(0xf6e6b7c4, 0xa02ec136),
+     TOBN(0x76aa9557, 0x26d8503c), TOBN(0xbe962b63, 0x6bc3e3d0),
+     TOBN(0xf5ca93e5, 0x97de8841), TOBN(0x1561b05e, 0xaf3f2c16),
+     TOBN(0x34be00aa, 0xd34bff98), TOBN(0xea21e6e9, 0xd23d2925),
+     TOBN(0x55713230, 0x394c3afb), TOBN(0xeaf0529b, 0xd6c8beca),
+     TOBN(0xff38a743, 0x202b9a11), TOBN(0xa13e39fc, 0x6d3a398b),
+     TOBN(0x8cbd644b, 0x86e2615a), TOBN(0x92063988, 0x191057ec),
+     TOBN(0x71503219, 0x74962b2e), TOBN(0x3beeaf81, 0xe1db7ec7),
+     TOBN(0x702784cc, 0x445c4e88), TOBN(0x7aa58315, 0x9baad7ed),
+     TOBN(0x72b76e2f, 0xd044b38a), TOBN(0x35a2bb8f, 0x6a7f2101),
+     TOBN(0x5e6ae263, 0xa14c2bf2), TOBN(0x8fb614c0, 0x34bb719d),
+     TOBN(0x7949eeca, 0x5dcd7c65), TOBN(0xb198be58, 0x7670aeb1),
+     TOBN(0xb2238dfc, 0x93cabf25), TOBN(0x6a6d4555, 0x1a422b95),
+     TOBN(0x787835ce, 0x13f89146), TOBN(0x7fcd42cc, 0x69446c3f),
+     TOBN(0x0da2aa98, 0x840e679d), TOBN(0x44f20523, 0x18779a1b),
+     TOBN(0xe3a3b34f, 0xefbf5935), TOBN(0xa5d2cfd0, 0xb9947b70),
+     TOBN(0xae2af4ef, 0x27f4e16f), TOBN(0xa7fa70d2, 0xb9d21322),
+     TOBN(0x68084919, 0xb3fd566b), TOBN(0xf04d71c8, 0xd7aad6ab),
+     TOBN(0xdbea21e4, 0x10bc4260), TOBN(0xaa7dc665, 0x8d949b42),
+     TOBN(0x3ddea6d9, 0xf7848707), TOBN(0xc11260d0, 0x6dbcf13a),
+     TOBN(0x62c5ee60, 0xa16508f0), TOBN(0x4bdfa38f, 0xcb56535c),
+     TOBN(0xd391e786, 0x4fa5a6b0), TOBN(0x173c3d70, 0x2d4cd296),
+     TOBN(0x9c5c596f, 0x5fa3f53c), TOBN(0x77d39514, 0x1ddd3732),
+     TOBN(0xca1bb91d, 0xa5bf4edc), TOBN(0xb23afd38, 0x1cd98b09),
+     TOBN(0x198248ed, 0x60bdfa0f), TOBN(0x559dd99c, 0xfb69a4b1),
+     TOBN(0xd8e958a0, 0x6ccb8213), TOBN(0x118d9db9, 0x91900b54),
+     TOBN(0x09bb9d49, 0x85e8ced6), TOBN(0x410e9fb5, 0x24019281),
+     TOBN(0x3b31b4e1, 0x6d74c86e), TOBN(0x52bc0252, 0x020bb77d),
+     TOBN(0x5616a26f, 0x27092ce4), TOBN(0x67774dbc, 0xa08f65cd),
+     TOBN(0x560ad494, 0xc08bd569), TOBN(0xbe26da36, 0xad498783),
+     TOBN(0x0276c8ab, 0x7f019c91), TOBN(0x09843ada, 0x5248266e),
+     TOBN(0xa54768da, 0xb1b43eef), TOBN(0x13e41f47, 0xe14fda22),
+     TOBN(0x774df203, 0xfaef6863), TOBN(0xf795a034, 0xbd7471b3),
+     TOBN(0xf0958718, 0xb47de2e9), TOBN(0xc92f7888, 0xe1160cff),
+     TOBN(0x86ded97b, 0x0146c790), TOBN(0x015918f5, 0x480a4b7b),
+     TOBN(0x05588920, 0x424e8459), TOBN(0x37455914, 0xeecf8b2b),
+     TOBN(0xe7d3df1f, 0xb968a6fa), TOBN(0x07a0ffd6, 0xbad0719f)},
+    {TOBN(0x2566021f, 0x98d23f6f), TOBN(0xfb883e12, 0x34ca97ca),
+     TOBN(0x34e047a5, 0xd9f51b69), TOBN(0x0b50d91d, 0xf8efa646),
+     TOBN(0xc2bbcbb2, 0x971f584f), TOBN(0x4136f0e4, 0x0907c91c),
+     TOBN(0xa7ebeb0d, 0xe735cc48), TOBN(0xa7d1bedc, 0xe113c8fa),
+     TOBN(0xc04d9a07, 0x3f5c962a), TOBN(0x95c155e5, 0x3ff74a2f),
+     TOBN(0x923c65a5, 0x3df0749d), TOBN(0x10d5f812, 0x27ae35d0),
+     TOBN(0xd5469c7b, 0xecee6e87), TOBN(0x056180bc, 0x33a4c917),
+     TOBN(0xf881ca21, 0xa16caa7a), TOBN(0x221de182, 0xe6cc7f39),
+     TOBN(0x10d61ab5, 0x31378723), TOBN(0xfb763bd9, 0x520c9660),
+     TOBN(0x145214cd, 0x0d6b1541), TOBN(0xd9f7ff2d, 0xd70223e7),
+     TOBN(0x9fce59e3, 0x0cb1fe69), TOBN(0x2e6e77fa, 0x3e299fe7),
+     TOBN(0x3a0cf652, 0xd5af78cf), TOBN(0x50cc42c5, 0x3e852159),
+     TOBN(0x0791dfa1, 0xdf764716), TOBN(0x31bf6876, 0x8c66da07),
+     TOBN(0x49f25b77, 0xccedf4f3), TOBN(0x05170ccd, 0x5d965c05),
+     TOBN(0x37d9521b, 0xd49e6727), TOBN(0x15482512, 0x86a00176),
+     TOBN(0xdab44493, 0x6c00eb48), TOBN(0x102c6b95, 0xe00c5c5d),
+     TOBN(0x43660c3e, 0x4c2506ba), TOBN(0xb2fb2616, 0x5ec6f132),
+     TOBN(0xccc4221a, 0x99ac7691), TOBN(0x05b29758, 0xa576deb5),
+     TOBN(0x4a873076, 0xad8c49b7), TOBN(0x891598ce, 0x7146575f),
+     TOBN(0xc1d3042f, 0x427ea198), TOBN(0xdc592111, 0xed259219),
+     TOBN(0x0abdbd16, 0x234850ca), TOBN(0x26b94126, 0x43b6fe8d),
+     TOBN(0xd3c79d17, 0x36a1cfe9), TOBN(0x57638621, 0x9a2b3baf),
+     TOBN(0xa736535d, 0x5a98bf65), TOBN(0xacb3b7dd, 0xab2cdb2b),
+     TOBN(0x37d3743a, 0xdaaf89ee), TOBN(0xf19d9aba, 0x0b348532),
+     TOBN(0xafad01a0, 0xd93c54b2), TOBN(0x659bff96, 0x95536c49),
+     TOBN(0x7b91aac2, 0xb9734c15), TOBN(0x55c7f082, 0x24e02f59),
+     TOBN(0xebcb71e7, 0x3a26e551), TOBN(0x5b7225f7, 0x6c6343eb),
+     TOBN(0x021c48fb, 0x17d5e775), TOBN(0x57536a42, 0xbd859c87),
+     TOBN(0x24852cc0, 0xae2b63e9), TOBN(0x21515020, 0xc0ce0ef1),
+     TOBN(0x2ac7336c, 0x8fed825e), TOBN(0x4bc87fee, 0xa0152819),
+     TOBN(0xe7c396d6, 0x4654712c), TOBN(0x1fa5ea50, 0x7a26e994),
+     TOBN(0xaa987687, 0x09012b83), TOBN(0xf1ef9792, 0xe9b17e98),
+     TOBN(0x2c22bcb0, 0x6dc2db10), TOBN(0xae42ddf6, 0xed4be80e),
+     TOBN(0x672080f6, 0x2e743405), TOBN(0xa15a7f97, 0x5b7821d1),
+     TOBN(0x0cd912f2, 0x47adbf07), TOBN(0x6919c0dc, 0xb6c4ae8f),
+     TOBN(0x62b13edd, 0x14c6253c), TOBN(0x66f35919, 0xf8032287),
+     TOBN(0x2713b58c, 0x9d628e1d), TOBN(0x3729960a, 0xfaa8ba1e),
+     TOBN(0xc3438130, 0xab53bc93), TOBN(0xcef9eda5, 0xe9c165e7),
+     TOBN(0x9bacd1c3, 0xfd02650b), TOBN(0xbb300334, 0x540ece72),
+     TOBN(0x21f5a5d3, 0xd9c4f0ed), TOBN(0x1ba32e4f, 0xf7c19269),
+     TOBN(0x8f073beb, 0x2cf320fb), TOBN(0xb49766c4, 0x5599646f),
+     TOBN(0x68180d66, 0x49e4f200), TOBN(0x8203d8ae, 0xeaeddb36),
+     TOBN(0xa68295da, 0x2caf088b), TOBN(0x23d6439a, 0x5c8709fe),
+     TOBN(0x8deba0cf, 0xfe0c3df0), TOBN(0x5b4d037b, 0x3cd00a1a),
+     TOBN(0xe9edc429, 0xaa0f9088), TOBN(0x6f5827e3, 0x5847def7),
+     TOBN(0x9739d03d, 0x306ad966), TOBN(0x7c6b18af, 0xaed51d04),
+     TOBN(0xdc3d34ff, 0x1759060a), TOBN(0x029e9aa9, 0xa7e94dbb),
+     TOBN(0x2a3cdfa0, 0xf7e8b7f3), TOBN(0x42f87bf0, 0xbbd8f6f4),
+     TOBN(0x516f138b, 0xed210253), TOBN(0x5ec2fa32, 0x4433461a),
+     TOBN(0x0dbe2c66, 0xcdaf1280), TOBN(0x086b91e5, 0x9fbf3318),
+     TOBN(0xfb0223ee, 0x399a1ca6), TOBN(0xd6f86d9b, 0x0db5b20f),
+     TOBN(0xec02bca2, 0x5752d618), TOBN(0x952fafca, 0xaf69f3f1),
+     TOBN(0xf304cb75, 0x33c4d294), TOBN(0x78085727, 0xdac65608),
+     TOBN(0x22f302ef, 0x840a4466), TOBN(0x33fb889d, 0xc371c31f),
+     TOBN(0xaa4711f5, 0x4f890542), TOBN(0x862421d9, 0xeba822c4),
+     TOBN(0x2f667179, 0x848280fc), TOBN(0x4de16d87, 0xc201ed75),
+     TOBN(0xd20e1399, 0xc5e61b5d), TOBN(0x3f7114b4, 0x9ed67ec7),
+     TOBN(0x561fd497, 0x9b5a88f9), TOBN(0xb202eb86, 0xd84db2c1),
+     TOBN(0x67d8fb90, 0xc8637d3d), TOBN(0x3d1d78a1, 0x032b1853),
+     TOBN(0xe07bf775, 0xef1af9ac), TOBN(0x691e1dee, 0xa57d6ada),
+     TOBN(0x834701da, 0x3801c65d), TOBN(0x5bb35c48, 0x955aa27d),
+     TOBN(0x0ef0f375, 0xdb7ad387), TOBN(0xd25e337f, 0x06cd1d53),
+     TOBN(0x757a1f9d, 0x90cd91de), TOBN(0x1604f153, 0xd61bbd60),
+     TOBN(0x6a01e8cf, 0x8bb95dc4), TOBN(0x34b7be62, 0x75bbdb13),
+     TOBN(0x0a96b3a1, 0x21e9b029), TOBN(0x25615c3b, 0x2946df44),
+     TOBN(0x5eda7d19, 0x19d04842), TOBN(0x08317975, 0xfba84668),
+     TOBN(0x12474bd8, 0xa55a3a4d), TOBN(0xe326aaf1, 0x9e471af4),
+     TOBN(0xf201a930, 0x8caadaa6), TOBN(0x546821f8, 0x35304341),
+     TOBN(0x7fe452c3, 0x088353e1), TOBN(0x8f1ff628, 0xfc82566a),
+     TOBN(0x49526f46, 0xd99f8967), TOBN(0xb19c80c0, 0xa4009690),
+     TOBN(0xeccf9759, 0x1cbc0716), TOBN(0x2e13ae2c, 0xaf4cbc8b),
+     TOBN(0x12b0df13, 0xf32e29ad), TOBN(0xa2005d6e, 0x0b1565f0),
+     TOBN(0xdb891eed, 0xd06014e0), TOBN(0x69685d61, 0x03e9970a),
+     TOBN(0x3a612db4, 0x02838113), TOBN(0xc1cd7b3a, 0xdcdef0b0),
+     TOBN(0x612b299d, 0xa41d6c1e), TOBN(0x982161ed, 0x0ed386a0),
+     TOBN(0xb36bbe2f, 0x3ea1bf1e), TOBN(0x0d8c3752, 0xceb2a5ec),
+     TOBN(0xc02cd7f6, 0xec03bddd), TOBN(0xa87977c1, 0x52631d9e),
+     TOBN(0x7b546cc3, 0x7e398d7e), TOBN(0x5b1218a8, 0x04845671),
+     TOBN(0xfa3e43e5, 0x6cb173d1), TOBN(0x2502258d, 0x4591b5a5),
+     TOBN(0xae8c4b55, 0x8ca9682a), TOBN(0x8cb1ffb4, 0xec81a288),
+     TOBN(0xd11ae888, 0xbfc84fd1), TOBN(0xa3b083a0, 0xd774577c),
+     TOBN(0x119b41c1, 0x1da9afc5), TOBN(0x44bc7762, 0x2934e22b),
+     TOBN(0xa04694f3, 0x7c639d6c), TOBN(0xd5e1ce57, 0x32c5b8ea),
+     TOBN(0xd507c39b, 0x9749e8b6), TOBN(0x16cc0b57, 0x55255b63),
+     TOBN(0x71e5df78, 0x614f6f37), TOBN(0x5cf0e08d, 0xa0b80bee),
+     TOBN(0x1f8dae17, 0x1e32051f), TOBN(0x54ae365d, 0x83bc233b),
+     TOBN(0x97ea005b, 0x1b84aaa6), TOBN(0xf4766d92, 0x64c75139),
+     TOBN(0x9b93bbf2, 0x41215701), TOBN(0xb18f042d, 0x8cf8a865),
+     TOBN(0x5dfb96dd, 0x0867556f), TOBN(0xe9fafbb8, 0x597fd6a1),
+     TOBN(0x729b2f50, 0xfe48bbc6), TOBN(0x2cf85f6b, 0x7f37ff9b),
+     TOBN(0xcd8c2ec9, 0x378ef62b), TOBN(0x7f4a3c54, 0x91a7c4b9),
+     TOBN(0xe12386d4, 0xdb83e1ab), TOBN(0x9a792032, 0xbb549bb5),
+     TOBN(0xaf81cba6, 0x2807c0f1), TOBN(0xd4ad7d87, 0xabf2008e),
+     TOBN(0x9d7a7230, 0x7e9ad6cd), TOBN(0xb30636b0, 0x8b517b2a),
+     TOBN(0x47c324da, 0xec900516), TOBN(0x408cd0d3, 0x7193eb30),
+     TOBN(0x8f0bcce2, 0xd315c655), TOBN(0x540ad4e0, 0x869d6c22)},
+    {TOBN(0x4b5e753d, 0xdae0ff8b), TOBN(0xe55c83e4, 0xda3d97b5),
+     TOBN(0x4034d75f, 0x42fa905b), TOBN(0x89b85eda, 0xc33e462b),
+     TOBN(0x31f413c3, 0x058de3bb), TOBN(0x66c01c80, 0x6ba75391),
+     TOBN(0x3f500202, 0x373e28de), TOBN(0x5090b33b, 0x4b9be739),
+     TOBN(0x7297aa10, 0xefa2addd), TOBN(0x3e8ccdbe, 0x1a6566aa),
+     TOBN(0x4dfda07f, 0xd7b4f214), TOBN(0xa659bd1e, 0x7cb1cae7),
+     TOBN(0x31796c23, 0x87d11691), TOBN(0x02991ea2, 0xa9de506c),
+     TOBN(0x4ff0cb71, 0x6cb0c301), TOBN(0xdd0cdbd7, 0xd1702ca9),
+     TOBN(0x470a26c8, 0xe1a02a90), TOBN(0xb705b7ba, 0xd7054625),
+     TOBN(0xfadc2e86, 0xd4a1a268), TOBN(0x0fd97646, 0x68e9f923),
+     TOBN(0x042b5ebb, 0x2951a8fe), TOBN(0xe4af9d03, 0x64197a76),
+     TOBN(0xdd2c6bb3, 0x249c1b5d), TOBN(0x60af89bd, 0xf01932b1),
+     TOBN(0x4374145d, 0x41afcd64), TOBN(0x98b72d60, 0x49d21198),
+     TOBN(0xc0ff394b, 0xdfde8a41), TOBN(0xed1112e5, 0xee1ff7a5),
+     TOBN(0x87a920e8, 0xcb5036fc), TOBN(0x437123f6, 0x2deb225e),
+     TOBN(0x37e527af, 0xb9ad8c58), TOBN(0x3e3c9998, 0xabfaef38),
+     TOBN(0xb656bcc5, 0x50b2b4e2), TOBN(0xfacc8a19, 0x3bf5699d),
+     TOBN(0x98cec74f, 0xe616307a), TOBN(0x34af333d, 0xd3ef8bab),
+     TOBN(0x9ded9b0d, 0x744ec273), TOBN(0x5bdfe547, 0x2e79e4d5),
+     TOBN(0x94f3aaf5, 0x39393728), TOBN(0x22136862, 0xa438413e),
+     TOBN(0x449286da, 0x373c7de3), TOBN(0xa709d85d, 0x29aa1540),
+     TOBN(0x1bd13e41, 0x0284a4f6), TOBN(0x37b54d69, 0xf0799c8b),
+     TOBN(0xd43b558f, 0x6bcd0cb2), TOBN(0xf5757c0e, 0x9e610369),
+     TOBN(0x15c80b23, 0xc16e0651), TOBN(0xacb2cf64, 0x001820aa),
+     TOBN(0x0629e4dd, 0xeec37f48), TOBN(0x3f7556a2, 0xda7de716),
+     TOBN(0xcacd8f27, 0x661662bc), TOBN(0x65d8bc2c, 0xeaf01690),
+     TOBN(0x83ac6647, 0x7c39c893), TOBN(0x353f60db, 0xf59440e1),
+     TOBN(0x2597b0d6, 0x852c575a), TOBN(0x410885f7, 0x3a40c2b3),
+     TOBN(0x953ab347, 0x2fcc2488), TOBN(0x9f753e5e, 0xef4cc6d8),
+     TOBN(0xfc32bb4d, 0x97f69e63), TOBN(0x461c1b0c, 0x87e8c264),
+     TOBN(0x2bea7e75, 0xac4b62f5), TOBN(0xcf255dcd, 0xc6297871),
+     TOBN(0xdd88db87, 0x81b25c72), TOBN(0x77ad90b3, 0xb617dc04),
+     TOBN(0x65ee1382, 0x0ed4a7d6), TOBN(0x4c08df9c, 0xd9644c8f),
+     TOBN(0x072d3784, 0x525a023f), TOBN(0x1aef69ce, 0xfce399fb),
+     TOBN(0xb07fd78e, 0xd7f29044), TOBN(0xa3754e14, 0x43043fa7),
+     TOBN(0x97bdae92, 0xff9fe4d9), TOBN(0xad63ba6a, 0x700fe6b8),
+     TOBN(0xa571929b, 0xa1ca17db), TOBN(0xce7a12f5, 0x45e146b8),
+     TOBN(0x39df1446, 0xd9eb426d), TOBN(0x1e48b3f8, 0xdc27f268),
+     TOBN(0xa2d7dfa1, 0xff548455), TOBN(0x750068b8, 0x6ef1cc82),
+     TOBN(0x4d699306, 0x667fce62), TOBN(0x98540b9d, 0x131c5412),
+     TOBN(0xf8a62cd3, 0x47c580b0), TOBN(0x2b55460f, 0x73795005),
+     TOBN(0x3206c025, 0x7b8db337), TOBN(0x2280934b, 0xd0dda5a2),
+     TOBN(0x10a8aabd, 0x2352478c), TOBN(0x599d9dfa, 0x1364c40f),
+     TOBN(0xa009df1a, 0x076945a2), TOBN(0xf869152c, 0x03861f02),
+     TOBN(0xc405226e, 0x9f866a3c), TOBN(0x93bd737d, 0x8b41ecbb),
+     TOBN(0xb5c9ed10, 0x33901eed), TOBN(0x90e4ce8f, 0x99312b80),
+     TOBN(0x1a9ef22e, 0x57589279), TOBN(0x83ef607d, 0x7fe2d6aa),
+     TOBN(0xf2da8454, 0x3473dbfa), TOBN(0x14f36d3a, 0x57879066),
+     TOBN(0x2c780f22, 0x0ea3ce34), TOBN(0x240a211e, 0x4b8aac72),
+     TOBN(0x7a266e5d, 0xc2625a99), TOBN(0x1cb15d3e, 0x3b30c878),
+     TOBN(0x8cd8ccab, 0x0e1b21d3), TOBN(0x53c64279, 0xadc1a6b3),
+     TOBN(0xe60d15b9, 0x60bf708d), TOBN(0x6e431c1b, 0x0cb5ad4b),
+     TOBN(0xec874c3e, 0x82033111), TOBN(0x88054a1d, 0x9141eae5),
+     TOBN(0x98438a5a, 0xddf53a28), TOBN(0x168f0b0f, 0xfa12c657),
+     TOBN(0xd621ce26, 0x629d7a57), TOBN(0xbf571de7, 0xcc1f8af1),
+     TOBN(0x2c5cfaf9, 0x304adaa3), TOBN(0x950addbd, 0x3f283b49),
+     TOBN(0x622dc27c, 0xee6d1cd1), TOBN(0x26d92004, 0x1f0863fb),
+     TOBN(0xe243b2a2, 0xa41ec585), TOBN(0x0dbd9adf, 0x2bea6235),
+     TOBN(0xcb083c4d, 0x6f0820f5), TOBN(0x809ecbaf, 0xd5493931),
+     TOBN(0x96470674, 0x14b7ffa8), TOBN(0x2cdfe22e, 0x53fc2224),
+     TOBN(0xc8b1333c, 0x7cd74a06), TOBN(0x7d5ac4dc, 0x271006bf),
+     TOBN(0xe9377d9f, 0xc14e0e56), TOBN(0xaa8651db, 0x7a92ab1f),
+     TOBN(0x77cee814, 0x5fc11fb5), TOBN(0x1e7c5ca0, 0x27870b14),
+     TOBN(0xdeef4b3f, 0x6f959698), TOBN(0x7c59f26e, 0x5daa9bda),
+     TOBN(0x4d0d5aec, 0xfd312368), TOBN(0x5247a6f3, 0xb738de68),
+     TOBN(0x1c4e8ba9, 0x90c04807), TOBN(0x0554b41b, 0xcce126ca),
+     TOBN(0x3df98ea9, 0xa81cc26a), TOBN(0x982ed568, 0x83b2c6f3),
+     TOBN(0xc9cbd1b5, 0xea6d6976), TOBN(0x3f9f2319, 0x7e25ffbc),
+     TOBN(0xbca8e056, 0x7da6280e), TOBN(0x7abd3166, 0x35cda713),
+     TOBN(0x46ef321d, 0x740ae011), TOBN(0xb17f6c75, 0xdb214a33),
+     TOBN(0x37b73b4b, 0x51de4044), TOBN(0x5bccf3cc, 0xccd9ba8d),
+     TOBN(0xa2ca080d, 0xd0f7045b), TOBN(0x79caf906, 0x68cf4dcc),
+     TOBN(0xcc3605a9, 0xa7b07d22), TOBN(0x4370eb18, 0xb4ebe4e7),
+     TOBN(0xbe393039, 0x248867c1), TOBN(0xc8e4851e, 0xcb1a75ff),
+     TOBN(0x215f3fbe, 0x39cb6da4), TOBN(0x6f2102ee, 0xe41f9a34),
+     TOBN(0x61d484ab, 0xdfae7c27), TOBN(0xf5143bd2, 0x6f1260fc),
+     TOBN(0xa70b6c06, 0x7514bccc), TOBN(0xe71ca833, 0xd23506f5),
+     TOBN(0xe2f50ba8, 0xeae03a8e), TOBN(0x2ac3b508, 0x83c33359),
+     TOBN(0xe94b930f, 0x3655cabd), TOBN(0x6ef6aac4, 0xa342443c),
+     TOBN(0x2feb8005, 0xbae255da), TOBN(0x4625a15c, 0xac6e2095),
+     TOBN(0x75c6311d, 0x0ec76c1e), TOBN(0x896a0740, 0x9b81c6f2),
+     TOBN(0xbad3e2f9, 0x073378bb), TOBN(0x2984a106, 0x29266ec0),
+     TOBN(0xa68a5351, 0xa788010a), TOBN(0x321aa113, 0x017cd052),
+     TOBN(0xecfb6175, 0x2f34db5c), TOBN(0xfe080ced, 0xca2b51df),
+     TOBN(0xba296908, 0x03360c88), TOBN(0x3fb087c0, 0x36311812),
+     TOBN(0xec5fb10a, 0xd9ff6a48), TOBN(0x52f7077f, 0x207dd8e1),
+     TOBN(0x8e65cfb8, 0x44c02fbc), TOBN(0x4f4fcde2, 0xfbf4bfd5),
+     TOBN(0xd1ff5415, 0x6cc74320), TOBN(0xf989d544, 0xf68b036a),
+     TOBN(0xafedc2db, 0x973bd9be), TOBN(0x7bdc3569, 0x4785e26a),
+     TOBN(0x0df36796, 0x751ae9ba), TOBN(0xfebde691, 0xccdabd95),
+     TOBN(0x3499b44b, 0xc77488cc), TOBN(0xde000e01, 0xaa8f3c10),
+     TOBN(0x30140406, 0xc1f517d7), TOBN(0xd4b3c8eb, 0x82a174e8),
+     TOBN(0xc8835b13, 0xaf2c9b3a), TOBN(0x2cd7626e, 0x443716f4),
+     TOBN(0x336c4f4b, 0x9c22de71), TOBN(0x9dd2b277, 0xf2529f60),
+     TOBN(0x6ffba2dc, 0x828c34d3), TOBN(0x257a345c, 0x34d0d1f7),
+     TOBN(0xbc1eff05, 0x6ca4fbce), TOBN(0x05b33562, 0x0768349f)},
+    {TOBN(0x5d7afe9a, 0x10fa53ce), TOBN(0xe2415b50, 0x1ff49021),
+     TOBN(0xe39a067d, 0xc6523492), TOBN(0x34585275, 0x27557f5d),
+     TOBN(0x756b8d86, 0x930e9f9d), TOBN(0x88df6219, 0x040d52d8),
+     TOBN(0x606eb60b, 0x5362b045), TOBN(0xd179818c, 0x9e383cbe),
+     TOBN(0xa6215748, 0xe068d293), TOBN(0x73fbdca2, 0x2fce158d),
+     TOBN(0x9cfee07d, 0xcb183c8f), TOBN(0xc0bf2beb, 0xa5e03c98),
+     TOBN(0x86230934, 0xf14a99d9), TOBN(0x1cf9c66e, 0x97c1c092),
+     TOBN(0x01e186ba, 0x6f595ed3), TOBN(0xd3291c3d, 0xe2284a58),
+     TOBN(0x03dee231, 0x1b9e5e25), TOBN(0xf2e9b4ad, 0x15cc9f53),
+     TOBN(0x4fba1567, 0x9770c29d), TOBN(0xbf7d6736, 0x50c4ae2f),
+     TOBN(0x86901eb9, 0x2532d015), TOBN(0x4396fd78, 0x4e7455de),
+     TOBN(0x2fbcea8f, 0xbcf811c9), TOBN(0x3981ad15, 0xae952b37),
+     TOBN(0x5563ba50, 0x4caea411), TOBN(0x6d06f7ff, 0x59297ddc),
+     TOBN(0x244c00ac, 0xb2fb7a6e), TOBN(0x25aac3d4, 0x35df586e),
+     TOBN(0x6c6777e4, 0xd67be5f9), TOBN(0x476cbbf1, 0x11c24c8a),
+     TOBN(0x60832359, 0x83b496fc), TOBN(0xcc13c191, 0x09a871a0),
+     TOBN(0x7c0e049f, 0x56f78170), TOBN(0x19bda64b, 0x6eafe939),
+     TOBN(0x04381fb6, 0x09aa41e3), TOBN(0xe4d4dcbb, 0x0b8c4500),
+     TOBN(0x6bd2c54d, 0x4cb89afa), TOBN(0xe78c8bfa, 0x36527751),
+     TOBN(0x27f52654, 0xe3eee747), TOBN(0x56f20583, 0x9598d907),
+     TOBN(0x5f91c2d0, 0x27cb3712), TOBN(0xc501819f, 0xa3e33c5b),
+     TOBN(0x248490aa, 0x4eded738), TOBN(0xde7ac944, 0x27789065),
+     TOBN(0x20138b3d, 0x74f7d38b), TOBN(0xae791f60, 0x2fb60214),
+     TOBN(0x6b4fb300, 0xbd033d4e), TOBN(0xc69c25d9, 0xbdfd1f17),
+     TOBN(0x8a5cb7ae, 0x92717482), TOBN(0x3dc97730, 0xc49d53e9),
+     TOBN(0x07b1e2cc, 0x5302d584), TOBN(0x06617e8e, 0x397b46cb),
+     TOBN(0x73426657, 0xe8e9f451), TOBN(0x82dcb228, 0xdd517335),
+     TOBN(0x39cde297, 0x5cad6d10), TOBN(0x76991f56, 0x2e4b0ebd),
+     TOBN(0xf3e3b3b2, 0x5020cfc6), TOBN(0x35a63790, 0xe51bbaca),
+     TOBN(0x47b21e6f, 0x4a23f2ec), TOBN(0x964c6fb5, 0x620e0b06),
+     TOBN(0x9bd2b68d, 0xbe832a0c), TOBN(0x0efa6b60, 0xf1e49e28),
+     TOBN(0x67e7f359, 0x89586da1), TOBN(0xbc04c8aa, 0xfd0944ca),
+     TOBN(0xb8db5424, 0xf0569b5a), TOBN(0xc27dd125, 0x0cc5546e),
+     TOBN(0x8f0ef9df, 0xad67b577), TOBN(0x1b5d4068, 0x9824cbc2),
+     TOBN(0x2ec1eb64, 0x4e7329b8), TOBN(0x3e0e7f37, 0xe6896b04),
+     TOBN(0xad2bff11, 0xc118b6bf), TOBN(0xe17ec8dc, 0x40f93fa6),
+     TOBN(0xc7e68075, 0x98692833), TOBN(0x311dd043, 0xe1257bf1),
+     TOBN(0xd4356992, 0xe6258442), TOBN(0x7868deca, 0x05ddf6d2),
+     TOBN(0x61b3a961, 0x95a0951b), TOBN(0x0cda07bf, 0x61c6fc20),
+     TOBN(0xac9aa65d, 0x2d061312), TOBN(0x4d9c4f20, 0xb65f1a23),
+     TOBN(0x862e4927, 0xb06611a8), TOBN(0x0d1c906e, 0x6cccfba0),
+     TOBN(0x0c82ac34, 0x6a49234c), TOBN(0x70f3c70b, 0xaadbaea7),
+     TOBN(0x0c3d2056, 0xbe21a890), TOBN(0x1c1ffbfb, 0x8fcfba99),
+     TOBN(0x1b68a98b, 0x1fbf56ca), TOBN(0x56fd85ff, 0x396e31cd),
+     TOBN(0xd2ca5844, 0x4382c03b), TOBN(0xc442030a, 0x7d3ef917),
+     TOBN(0x4129a731, 0x426afafa), TOBN(0xacff17ff, 0x5eaae9c6),
+     TOBN(0x9e854180, 0x653f3b23), TOBN(0xe65a1a14, 0x9ee066bd),
+     TOBN(0x3420084e, 0x362ea5fe), TOBN(0x6fe58801, 0xc7911e2e),
+     TOBN(0x4dd38c42, 0x02a97a2b), TOBN(0x2a8d49c2, 0xfdb98b51),
+     TOBN(0x7034c753, 0x5cb2e0ca), TOBN(0x87e0d6d3, 0xc4b59d32),
+     TOBN(0x9544bb07, 0x35514758), TOBN(0x9ed743da, 0x4ff27eb0),
+     TOBN(0x1d21a1ad, 0xa0163883), TOBN(0xd6442498, 0x38c57492),
+     TOBN(0xf46e8acc, 0xf2fd1b7f), TOBN(0xec9932c5, 0xc8005cfe),
+     TOBN(0x5fe24f52, 0xb802c109), TOBN(0x5539c03b, 0xe3ee9ba7),
+     TOBN(0x4c3f4f49, 0x05a95afb), TOBN(0xd53a1d3a, 0xf5db9d6b),
+     TOBN(0x0fbd9bad, 0x1844be86), TOBN(0x6b3b80ee, 0x272afc14),
+     TOBN(0xd727b0b6, 0xaa40a738), TOBN(0x8a21bf45, 0x4d809a37),
+     TOBN(0x09fb0640, 0x70767232), TOBN(0xa671a2cc, 0x45bf5d89),
+     TOBN(0xa7e5ff8a, 0xd73a211b), TOBN(0xccdbf621, 0xd9a6b97d),
+     TOBN(0x38448e2c, 0xc89e8f56), TOBN(0x07e4e9c3, 0x2126da09),
+     TOBN(0x762e6584, 0x7adcc8b8), TOBN(0xedef40a7, 0x7924eafd),
+     TOBN(0xe1990688, 0x5913e468), TOBN(0x1882db47, 0x289bc581),
+     TOBN(0x680cd99b, 0xe6084637), TOBN(0x5249f00e, 0x1adacd71),
+     TOBN(0x0d3b583f, 0x933bf6cb), TOBN(0x51c86774, 0x9b02a63d),
+     TOBN(0x0be0ada7, 0x1dc57813), TOBN(0xd4b63964, 0x1e2c5f9f),
+     TOBN(0x810b38b0, 0x2c77c4e5), TOBN(0x9f06b31d, 0x862013cb),
+     TOBN(0x43f0ae67, 0x6c4be6a0), TOBN(0xabc6a17a, 0x504bffeb),
+     TOBN(0xd5be6c25, 0xdbb4492e), TOBN(0x7efc9ee8, 0x84bff97f),
+     TOBN(0x54fbd9d7, 0x062da2e2), TOBN(0x1befeb61, 0xc6d2ac32),
+     TOBN(0x14cf6dc0, 0xcbafef5b), TOBN(0x8e640e47, 0x71d12192),
+     TOBN(0xd0566543, 0xd9a16800), TOBN(0x9cc2ade9, 0xbeb1e28d),
+     TOBN(0xcbfeb450, 0x38e65833), TOBN(0x3852eaac, 0xd0f5acb2),
+     TOBN(0x8bbac220, 0x3b5a25dc), TOBN(0x6e216404, 0x7deb0149),
+     TOBN(0x3d6eecea, 0x7ae10837), TOBN(0x2ab3cd3d, 0xeb944203),
+     TOBN(0x8fdcb595, 0x5114d51a), TOBN(0xfbf0f726, 0x92471196),
+     TOBN(0x6523ea38, 0xb20cdb3f), TOBN(0xc08ad84a, 0x5796c8f8),
+     TOBN(0xd7977bc2, 0x71b564cb), TOBN(0x16a9e700, 0x5d66093e),
+     TOBN(0x67fb9a6f, 0x144cd814), TOBN(0xbf2094bb, 0xeecab0d4),
+     TOBN(0x4f10299a, 0x6c50f6a1), TOBN(0xa51c6774, 0x69a1caf7),
+     TOBN(0x024b18bc, 0x0cbede41), TOBN(0x7883c01e, 0x6b03ac7d),
+     TOBN(0xa7b99e74, 0x1c5213be), TOBN(0x529fad7a, 0x85a97540),
+     TOBN(0x0b6fe59d, 0x03125409), TOBN(0xf1581679, 0x76275b90),
+     TOBN(0xcaa0969d, 0x6ad18919), TOBN(0xc47afe13, 0xee7761dc),
+     TOBN(0xcae681fc, 0xdfb12539), TOBN(0x58dabc76, 0x02ea65f4),
+     TOBN(0x3f19ec08, 0x35a505bf), TOBN(0x83186122, 0xb0032e38),
+     TOBN(0xe5c2eac4, 0x2b3126ec), TOBN(0x4368683f, 0xf752524f),
+     TOBN(0x03de9cdd, 0x3ab28694), TOBN(0xfc5e70df, 0x61d0253b),
+     TOBN(0x7991742a, 0x789a16d4), TOBN(0xefdb8003, 0x226ee928),
+     TOBN(0x0468fe4c, 0xa4e62a4f), TOBN(0x3ce92ccb, 0xd07dd729),
+     TOBN(0x447bed93, 0xfe688c1e), TOBN(0xd5ff355d, 0xcae39d89),
+     TOBN(0x5e930d65, 0xc4650b85), TOBN(0xbe96b2ae, 0x6350da54),
+     TOBN(0xcfac4f7e, 0xfa08bd49), TOBN(0x277e8456, 0xa6e10f64),
+     TOBN(0x41be3067, 0x407ac162), TOBN(0xcfd1d032, 0x52a9b68b),
+     TOBN(0x8d8d216a, 0x9c337e0b), TOBN(0xace044dc, 0x4e1b9cf5),
+     TOBN(0xad9a4102, 0xc60d54c3), TOBN(0xb09420f0, 0x28815187),
+     TOBN(0x881179c6, 0x0b3b8e59), TOBN(0x872685ed, 0x5b09aba1)},
+    {TOBN(0x22313dee, 0x5852b59b), TOBN(0x6f56c8e8, 0xb6a0b37f),
+     TOBN(0x43d6eeae, 0xa76ec380), TOBN(0xa1655136, 0x0275ad36),
+     TOBN(0xe5c1b65a, 0xdf095bda), TOBN(0xbd1ffa8d, 0x367c44b0),
+     TOBN(0xe2b419c2, 0x6b48af2b), TOBN(0x57bbbd97, 0x3da194c8),
+     TOBN(0xb5fbe51f, 0xa2baff05), TOBN(0xa0594d70, 0x6269b5d0),
+     TOBN(0x0b07b705, 0x23e8d667), TOBN(0xae1976b5, 0x63e016e7),
+     TOBN(0x022aa09d, 0x236b71dc), TOBN(0xb1ce6a0e, 0xa65a7640),
+     TOBN(0x317344c5, 0xb38b417a), TOBN(0x29a74cdb, 0x436451ec),
+     TOBN(0xd898eb6c, 0xa8b1c876), TOBN(0xf0134f99, 0xb74eeffd),
+     TOBN(0x0d9eab64, 0x225d71f7), TOBN(0x9679b453, 0xceb3cc2d),
+     TOBN(0x37c894ce, 0x14dbff2f), TOBN(0x3704d349, 0x27065280),
+     TOBN(0x9ee435d8, 0xba29a0cd), TOBN(0x675bea14, 0x09c11c4f),
+     TOBN(0x2fde4893, 0xfbecaaae), TOBN(0x444346de, 0x30332229),
+     TOBN(0x157b8a5b, 0x09456ed5), TOBN(0x73606a79, 0x25797c6c),
+     TOBN(0xa9d0f47c, 0x33c14c06), TOBN(0x7bc8962c, 0xfaf971ca),
+     TOBN(0x6e763c51, 0x65909dfd), TOBN(0x1bbbe41b, 0x14a9bf42),
+     TOBN(0xd95b7ecb, 0xc49e9efc), TOBN(0x0c317927, 0xb38f2b59),
+     TOBN(0x97912b53, 0xb3c397db), TOBN(0xcb3879aa, 0x45c7abc7),
+     TOBN(0x8b3269a2, 0x714a10e8), TOBN(0x64cef040, 0xa4a2727e),
+     TOBN(0xbc5ac714, 0xe428865c), TOBN(0x531dd17f, 0xfdaba094),
+     TOBN(0x86d24057, 0x18d657f2), TOBN(0xe807b0d9, 0x2f99dbbf),
+     TOBN(0xc428a80f, 0x6848ef88), TOBN(0xb3ef0709, 0xd0b73ce5),
+     TOBN(0xa7526919, 0x22a5d255), TOBN(0xbfe63923, 0x18a18586),
+     TOBN(0x28a0c772, 0xfcf633b3), TOBN(0xad22b4ec, 0x3f3c5298),
+     TOBN(0xcd81bdcf, 0x24359b81), TOBN(0x6fd326e2, 0xdb4c321c),
+     TOBN(0x4cb0228b, 0xf8ebe39c), TOBN(0x496a9dce, 0xb2cdd852),
+     TOBN(0x0f115a1a, 0xd0e9b3af), TOBN(0xaa08bf36, 0xd8eeef8a),
+     TOBN(0x5232a515, 0x06e5e739), TOBN(0x21fae9d5, 0x8407a551),
+     TOBN(0x289d18b0, 0x8994b4e8), TOBN(0xb4e346a8, 0x09097a52),
+     TOBN(0xc641510f, 0x324621d0), TOBN(0xc567fd4a, 0x95a41ab8),
+     TOBN(0xc8c9b0ae, 0x7176dd90), TOBN(0xa9560454, 0x2917d487),
+     TOBN(0xb03b7946, 0xe62c508e), TOBN(0x60425926, 0xe9fe2321),
+     TOBN(0x73b10bba, 0x80c1d136), TOBN(0xc30a847d, 0x9d218c9c),
+     TOBN(0x6ed0c8ef, 0x2073859f), TOBN(0xa176eabf, 0x432dd97f),
+     TOBN(0x3078096a, 0xb9e96167), TOBN(0xb28f0e6c, 0xc473e377),
+     TOBN(0xb44e4995, 0x683a3bc8), TOBN(0x483512ee, 0xd3523796),
+     TOBN(0x261578c7, 0xd57c8de9), TOBN(0xb9bc491f, 0x3836c5c8),
+     TOBN(0x993266b4, 0x14c8038f), TOBN(0xbacad755, 0xfaa7cc39),
+     TOBN(0x418c4def, 0xd69b7e27), TOBN(0x53fdc5cd, 0xae751533),
+     TOBN(0x6f3bd329, 0xc3eea63a), TOBN(0xa7a22091, 0xe53dd29e),
+     TOBN(0xb7164f73, 0xdc4c54ec), TOBN(0xca66290d, 0x44d3d74e),
+     TOBN(0xf77c6242, 0x4c9ea511), TOBN(0x34337f55, 0x1f714c49),
+     TOBN(0x93a62e7c, 0xfa43699c), TOBN(0xdad73890, 0x1bc422d9),
+     TOBN(0x265e3cbb, 0x10cc9544), TOBN(0x28cceb06, 0x2f37154c),
+     TOBN(0x6b79b071, 0x3bf2e08b), TOBN(0x88e025df, 0x3ab39091),
+     TOBN(0x50a8d04d, 0x126522bd), TOBN(0xeabbc1b7, 0xb779bacf),
+     TOBN(0x3db4336a, 0xc21cc62e), TOBN(0x4747f0a3, 0x6fc00450),
+     TOBN(0x067cbf1c, 0x544b2d95), TOBN(0x2480b7d8, 0xfd2be7a7),
+     TOBN(0x5ed2b216, 0xa64b6c4b), TOBN(0x1c38794f, 0x3aae640d),
+     TOBN(0x30bbaee0, 0x8905794f), TOBN(0x0d9ee41e, 0xc8699cfb),
+     TOBN(0xaf38daf2, 0xcf7b7c29), TOBN(0x0d6a05ca, 0x43e53513),
+     TOBN(0xbe96c644, 0x2606ab56), TOBN(0x13e7a072, 0xe9eb9734),
+     TOBN(0xf9669445, 0x5ff50cd7), TOBN(0x68ef26b5, 0x47da6f1d),
+     TOBN(0xf0028738, 0x23687cb7), TOBN(0x5ed9c876, 0x6217c1ce),
+     TOBN(0x21965f08, 0xb6ba9a0d), TOBN(0xa744f068, 0x06cab532),
+     TOBN(0xd15d5fa4, 0x5d4b9a92), TOBN(0xc79fc89b, 0x955ee1f4),
+     TOBN(0x6367e8b2, 0x7b2775f6), TOBN(0x2076cd8b, 0xe2294382),
+     TOBN(0xe5c20ced, 0xc9089d2e), TOBN(0xe6097605, 0xd76d6424),
+     TOBN(0xa69f79eb, 0x02b41ca6), TOBN(0x9738d39d, 0x63e07498),
+     TOBN(0x35c14a6a, 0x92974776), TOBN(0x3a000a51, 0x7270fd02),
+     TOBN(0x423ba513, 0x0a3a9691), TOBN(0xf421b1e7, 0xb3179296),
+     TOBN(0x6b51bcdb, 0x1a871e1b), TOBN(0x6e3bb5b5, 0x464e4300),
+     TOBN(0x24171e2e, 0xfc6c54cc), TOBN(0xa9dfa947, 0xd3e58dc2),
+     TOBN(0x175b3309, 0x9de9cfa7), TOBN(0x707b2529, 0x2d1015da),
+     TOBN(0xcbb95f17, 0x993ea65a), TOBN(0x93515063, 0x0447450d),
+     TOBN(0x0f47b205, 0x1b2753c9), TOBN(0x4a0bab14, 0xe7d427cf),
+     TOBN(0x2724c535, 0x58e996c5), TOBN(0x24010322, 0xd7453876),
+     TOBN(0x3532b79c, 0x74818d0b), TOBN(0x1984146e, 0xb27b07e9),
+     TOBN(0x948b0c4f, 0x471646df), TOBN(0x551b1c61, 0x32ef8e08),
+     TOBN(0x22c08434, 0x25f892bb), TOBN(0x8fd873a8, 0x4853c594),
+     TOBN(0xff0bdf02, 0xffdf802e), TOBN(0x527d6993, 0x8239b779),
+     TOBN(0xed66f25c, 0x27ace140), TOBN(0x7389d738, 0xa1a846a0),
+     TOBN(0xa39def39, 0xb5aa7ca1), TOBN(0x591cb173, 0xc47c33df),
+     TOBN(0xa09dac79, 0x6bbab872), TOBN(0x3ef9d7cf, 0x7208ba2f),
+     TOBN(0x3cc18931, 0x7a0a34fc), TOBN(0xae31c62b, 0xbcc3380f),
+     TOBN(0xd72a6794, 0x0287c0b4), TOBN(0x3373382c, 0x68e334f1),
+     TOBN(0xd0310ca8, 0xbd20c6a6), TOBN(0xa2734b87, 0x42c033fd),
+     TOBN(0xa5d390f1, 0x8dce4509), TOBN(0xfc84e74b, 0x3e1afcb5),
+     TOBN(0xd605097e, 0x12e471f2), TOBN(0x8cff86ab, 0x2bb4aa64),
+     TOBN(0x4a878412, 0xea65a755), TOBN(0xfa790b77, 0x2f2b55fb),
+     TOBN(0xd13fb9b3, 0x5098a08f), TOBN(0x39e474d7, 0xb359117d),
+     TOBN(0xc37499c1, 0xe8e5a3d5), TOBN(0x5abf6859, 0xc7586167),
+     TOBN(0x13143ba8, 0x310fec8a), TOBN(0x3543979f, 0x75918fc2),
+     TOBN(0xf55a9b62, 0xcbb0bde9), TOBN(0xd6c1d000, 0x29359b93),
+     TOBN(0xb028334d, 0xf2cd8a9c), TOBN(0xb8719291, 0x570f76f6),
+     TOBN(0x662a386e, 0x01065a2d), TOBN(0xdf1634cb, 0x53d940ae),
+     TOBN(0x625a7b83, 0x8f5b41f9), TOBN(0xa033e4fe, 0xee6aa1b4),
+     TOBN(0x51e9d463, 0x1e42babb), TOBN(0x660bc2e4, 0x0d388468),
+     TOBN(0x3f702189, 0xfcbb114a), TOBN(0x6b46fe35, 0xb414ca78),
+     TOBN(0x328f6cf2, 0x4a57316b), TOBN(0x917423b5, 0x381ad156),
+     TOBN(0x0233e423, 0xd52eb122), TOBN(0xc2848352, 0x1154b0c9),
+     TOBN(0x2ca09cef, 0x6349e35b), TOBN(0x3b70afc3, 0xded2ec54),
+     TOBN(0xc813474d, 0x52dded3d), TOBN(0x2d3f21bf, 0x12f00ee0),
+     TOBN(0xa0908f76, 0x92f215c6), TOBN(0xb97d60e9, 0x4e9c0440),
+     TOBN(0x84ad10c1, 0x34b6a8e0), TOBN(0x6f37fd95, 0x6e7c163e),
+     TOBN(0x7caae8c8, 0xd057e0c3), TOBN(0x534f52c2, 0x553721a2)},
+    {TOBN(0xa354c1de, 0x72a041b2), TOBN(0xe83df259, 0x29d1330a),
+     TOBN(0x67661099, 0x9d532bbd), TOBN(0xb7c2f4cf, 0x52011751),
+     TOBN(0x6945d34f, 0xf659e35e), TOBN(0x6217d20b, 0xa1303b7b),
+     TOBN(0xa200ddba, 0x25751bad), TOBN(0xa74a7290, 0x01d3566d),
+     TOBN(0x3018445f, 0xaa82b46f), TOBN(0xc3e6a3ac, 0xfccedc1b),
+     TOBN(0xe86ae870, 0x3353e29f), TOBN(0x1c8085bb, 0xfd7e8547),
+     TOBN(0x306b63e3, 0xb4dcea78), TOBN(0x4b102092, 0x13636935),
+     TOBN(0x36bb6889, 0x8bdeddea), TOBN(0x9331655d, 0x67a329ac),
+     TOBN(0x14c7fe26, 0xba92ccce), TOBN(0x4e7d6929, 0xbe0519b4),
+     TOBN(0x0dc39dbd, 0x164d50e2), TOBN(0xd4c430a0, 0xb1679cc5),
+     TOBN(0xc7f78818, 0xfa8682ba), TOBN(0x43396ead, 0xb60aad97),
+     TOBN(0x751784d7, 0xff2c64cc), TOBN(0xd37928be, 0x866af43e),
+     TOBN(0xf0a69e68, 0x5a91c9aa), TOBN(0x0304d201, 0x05c13197),
+     TOBN(0x773a3ab7, 0xcd14af1d), TOBN(0xc0b88edd, 0x558d555d),
+     TOBN(0xeb12d197, 0xd2e63dd6), TOBN(0x4a8e849f, 0xbcd9cdb3),
+     TOBN(0x06432985, 0x965eaa14), TOBN(0x453d9386, 0x1a5a6f43),
+     TOBN(0xbd28f616, 0x4171b9bc), TOBN(0x37781639, 0xbbfcf90a),
+     TOBN(0x1f93898f, 0x3a36084d), TOBN(0x1fefd8b7, 0xdd00ca75),
+     TOBN(0xb9207dbc, 0x2b2f1bcc), TOBN(0x6afd6871, 0xa3e83ef7),
+     TOBN(0x49924e55, 0x34ba150b), TOBN(0x2935ebf1, 0xdfec9972),
+     TOBN(0x34bf5e94, 0xb76f870d), TOBN(0x22d0f32b, 0x4c20385c),
+     TOBN(0xc78ac172, 0x8ccc8e72), TOBN(0x7b45b822, 0x0ccecb0a),
+     TOBN(0x76c67ee4, 0xcfb4b8ba), TOBN(0xecfaefb2, 0xcd8724b6),
+     TOBN(0xe9bc3d67, 0x340bc1ef), TOBN(0xed40b2b9, 0xca5541b5),
+     TOBN(0x9b8a3eb3, 0x069e6432), TOBN(0x43aaa7fc, 0x721397f7),
+     TOBN(0x46e23c6c, 0xa7e83a71), TOBN(0x71b261d5, 0x93fa3c25),
+     TOBN(0x4a47a105, 0x0f523a72), TOBN(0x31919e89, 0x8dcad752),
+     TOBN(0x4c8b06e7, 0x0c5dd2ad), TOBN(0x677ec5f3, 0x8bdc55e7),
+     TOBN(0x4372d55d, 0xcb1b5828), TOBN(0x7bf054c1, 0xf04dd321),
+     TOBN(0x4e8c1a99, 0x2e44584e), TOBN(0x68078037, 0x51d35d78),
+     TOBN(0x25ae3499, 0x81d311b3), TOBN(0x8640f52a, 0x3b16037b),
+     TOBN(0xac083994, 0x1d947065), TOBN(0x3723c75e, 0xe2e693d2),
+     TOBN(0x65040a51, 0xb66f429e), TOBN(0x7f582b0b, 0x035a3a53),
+     TOBN(0x20eca9e1, 0x0a166da6), TOBN(0x45b37e20, 0x2c4cc565),
+     TOBN(0xeab88295, 0x7a8a96e3), TOBN(0x99e771da, 0xb60a1a1b),
+     TOBN(0x2cdd778c, 0x23b03965), TOBN(0x8d4d7a72, 0x91052478),
+     TOBN(0xa52d3c2d, 0x7e8f73b5), TOBN(0x86d80633, 0x51842657),
+     TOBN(0x58f01253, 0xb3949eba), TOBN(0x97689f15, 0xe79367d0),
+     TOBN(0x918bf9a3, 0x0d820328), TOBN(0x2d4bc994, 0x41c959df),
+     TOBN(0x37392f6e, 0x8c16ee54), TOBN(0x9f726d58, 0xe6f0849b),
+     TOBN(0x497de1e4, 0xb8208f08), TOBN(0x60c51233, 0xd51a29b3),
+     TOBN(0x0f61fb03, 0xc9e1d465), TOBN(0x09494bd0, 0xfbe2613c),
+     TOBN(0x4f293478, 0x154d0f99), TOBN(0x1b82320d, 0xd07a24b3),
+     TOBN(0x1bf7c94f, 0x64d55f6f), TOBN(0x4489b57d, 0x725c5125),
+     TOBN(0x3aa4d43a, 0xb1b6a091), TOBN(0x054842bd, 0xcf7a60fa),
+     TOBN(0xaa918a4d, 0x2aeb4cb6), TOBN(0xcbdaff99, 0xac7d317b),
+     TOBN(0xed0e00a1, 0x6812a03c), TOBN(0xb09acf27, 0x0b0a1e4b),
+     TOBN(0xc73a41f7, 0xac28386b), TOBN(0x43134dbd, 0xf4cd1321),
+     TOBN(0x08336ffe, 0xd8c33924), TOBN(0x15b56cbf, 0x5140b253),
+     TOBN(0x38dcd310, 0x306caedb), TOBN(0x04ecd496, 0x47944afd),
+     TOBN(0x1280d23f, 0x68a48f95), TOBN(0xf4142204, 0x34363c6e),
+     TOBN(0xd0a397ea, 0xcaa8717f), TOBN(0xb51a1669, 0xc3994b80),
+     TOBN(0xa02eed91, 0x6c56808b), TOBN(0xc3ab55c5, 0x83545c3c),
+     TOBN(0x8b835820, 0xfd26114a), TOBN(0xe0cfa4a6, 0xffff324c),
+     TOBN(0xcf63d279, 0x51c0d95e), TOBN(0x3b170a0b, 0xac86a014),
+     TOBN(0xc21eaaa9, 0x881095e1), TOBN(0xed2fda11, 0x6069a3eb),
+     TOBN(0x536264b9, 0xbd2f1c5a), TOBN(0x819e1cff, 0xde312c2c),
+     TOBN(0x6c30f983, 0xdfd6ce38), TOBN(0x2f32cc4c, 0x980b439e),
+     TOBN(0x9fab10b6, 0x3b9c03b2), TOBN(0xdfebe34e, 0x011ab74a),
+     TOBN(0x587360e3, 0xb80963f6), TOBN(0x3db1f610, 0x8692e352),
+     TOBN(0x63a094c5, 0xfe3d070b), TOBN(0xf769b919, 0x88515eb1),
+     TOBN(0xafe86e14, 0x50d1131d), TOBN(0x6bf27788, 0x6774d3d4),
+     TOBN(0x7231d699, 0xffd805d0), TOBN(0x05132e5b, 0x6304116e),
+     TOBN(0x3d5e255b, 0xe34ce5bc), TOBN(0xfd9c3bd0, 0xc95e3089),
+     TOBN(0x22a24023, 0xb83cbac9), TOBN(0xfb6d2b6f, 0xb0b3b98a),
+     TOBN(0x74af1115, 0xf7e36fcd), TOBN(0xcfe15eaf, 0xf9da3bf0),
+     TOBN(0x266d2c1c, 0xbb2fcdae), TOBN(0xb538d4a2, 0x52be93f2),
+     TOBN(0x774c88ba, 0x73bd0094), TOBN(0x65283a9b, 0x81a7e042),
+     TOBN(0xe1438bbf, 0xd0381625), TOBN(0x450e1f64, 0x4d0db206),
+     TOBN(0xb38ae9ef, 0x4e60fc4a), TOBN(0x14ce87e1, 0x12719817),
+     TOBN(0x831d41ec, 0x570303f0), TOBN(0x71729170, 0x28850444),
+     TOBN(0x2077ea32, 0xccd609f5), TOBN(0x091d1166, 0xcd273fdc),
+     TOBN(0xdf216dd8, 0x4b2ca517), TOBN(0xb3eec4b9, 0xc6b74c4d),
+     TOBN(0xf564e6c8, 0x1c14e77b), TOBN(0xcde25f1c, 0x2c2c9395),
+     TOBN(0x7e31f7a5, 0x049fcc83), TOBN(0x6913707b, 0x9284c753),
+     TOBN(0xb92a6f24, 0x58e6eb5f), TOBN(0x85b0cab5, 0x95148292),
+     TOBN(0xeaad036d, 0x7449be92), TOBN(0x2f6a2888, 0xeb94a702),
+     TOBN(0xd7d8773d, 0x47d59fb0), TOBN(0x612d2573, 0x03c0bf25),
+     TOBN(0xb872a105, 0x84d2c3bb), TOBN(0x44bca571, 0x39196026),
+     TOBN(0x857327d8, 0x4e352e5d), TOBN(0xa6c6004a, 0xd925f99f),
+     TOBN(0x48aaf266, 0xbab79ead), TOBN(0x213ad923, 0xadab2a3f),
+     TOBN(0x3be29b6d, 0xf371cc48), TOBN(0xe732b906, 0x2385c9f4),
+     TOBN(0x562e0be1, 0x23f0a84e), TOBN(0xbb6b0172, 0x28c4b0db),
+     TOBN(0x71a93ae5, 0xf4c6d8be), TOBN(0x76b8bb16, 0x551f1fe9),
+     TOBN(0xbbfaaa94, 0xc39926a8), TOBN(0xb9a59fdb, 0x60a138aa),
+     TOBN(0x217a1aa2, 0x947e30e9), TOBN(0xcac988c9, 0xc52c9fff),
+     TOBN(0x5676473a, 0x3bae3c39), TOBN(0x7d84b353, 0x857f04c9),
+     TOBN(0xdeded30c, 0xdd324e24), TOBN(0xf07c678a, 0x9c242899),
+     TOBN(0x956d0553, 0x8cb64f3b), TOBN(0x9d34e2f5, 0x502cb2b0),
+     TOBN(0x99e1054a, 0x51dd03b3), TOBN(0x86b8bfa5, 0x4d60a593),
+     TOBN(0x10a53b90, 0x754d15e9), TOBN(0x6cde9a0c, 0x5f4c7218),
+     TOBN(0x740d513f, 0xabef2b96), TOBN(0xff6cc47c, 0xd3f802fd),
+     TOBN(0x1be6825b, 0xeb0627af), TOBN(0xdb21ede5, 0x5886c2dc),
+     TOBN(0xb6cfb2c6, 0xf5daaed7), TOBN(0x68b61aa8, 0xfae29a9c),
+     TOBN(0x7a1e16f5, 0x3a5a485b), TOBN(0x16b60b92, 0xe7b2223e),
+     TOBN(0x332f33d8, 0x36a13a9b), TOBN(0x4567c313, 0x876cd1a2)},
+    {TOBN(0xa896d28e, 0x4aea3fa2), TOBN(0xc6137a45, 0x6db06ee9),
+     TOBN(0x1bbafe8c, 0x06fb15cc), TOBN(0x2daab296, 0x1cdffdad),
+     TOBN(0x984defc8, 0xe1119b3a), TOBN(0x9cd44c3c, 0xde2a25a3),
+     TOBN(0xa7f54ece, 0x54ed6d73), TOBN(0xd283017f, 0x50907054),
+     TOBN(0x69130efc, 0x6a3b9442), TOBN(0x5d17f127, 0x6785163b),
+     TOBN(0xc019911b, 0x172b1d0a), TOBN(0xa19c745f, 0x7e3e093c),
+     TOBN(0xe185bdc2, 0xab83d932), TOBN(0x0a75845d, 0xd7c4e754),
+     TOBN(0x1f6f3397, 0xc3fe5695), TOBN(0x6c9f3a5f, 0x61f6a04f),
+     TOBN(0x3c0f9d4b, 0xb390a92b), TOBN(0x9e3336b7, 0x4793b454),
+     TOBN(0x91ad0c34, 0x1472f06b), TOBN(0x4110047a, 0x892cbdd7),
+     TOBN(0xfa24d905, 0x65d53c83), TOBN(0xd63e5833, 0x4176007d),
+     TOBN(0x741089fd, 0x2cd1623c), TOBN(0x6b3d9202, 0x2685d345),
+     TOBN(0x1ac37f31, 0x3586c802), TOBN(0x70daca37, 0xa9cb8662),
+     TOBN(0x6e57d6a7, 0x8d9c7bf6), TOBN(0x27069e2c, 0xe97eec9b),
+     TOBN(0x16284ceb, 0x4e877a82), TOBN(0x30856e26, 0x774f6288),
+     TOBN(0x88e53ea7, 0xfa33820f), TOBN(0xbfe3b89f, 0x715ced07),
+     TOBN(0x6cf55589, 0x743b11c6), TOBN(0x020f8a09, 0x2edd201e),
+     TOBN(0xc80afc2c, 0xb15c27e0), TOBN(0x56557371, 0xcc53751a),
+     TOBN(0x1d510157, 0xc9cb7f6d), TOBN(0x532a0773, 0x46ab7372),
+     TOBN(0x2ea07e2f, 0xc6dde9e2), TOBN(0xceed9ad9, 0x37d5bb1f),
+     TOBN(0x3121994b, 0x98cc6e28), TOBN(0x67d2fbb5, 0x67ad8fc4),
+     TOBN(0x34707fb3, 0xdc9f195d), TOBN(0x6a601f48, 0x1fd5a013),
+     TOBN(0xfe939b8d, 0x81ef6cb5), TOBN(0x5c51e8ab, 0x1223a9a1),
+     TOBN(0x8f6d7993, 0xdb74cf37), TOBN(0x0b81c5b7, 0x972808e1),
+     TOBN(0xcc54c384, 0xe26e1212), TOBN(0xf4c6a3cb, 0xfee6836b),
+     TOBN(0x62589405, 0x91cccc5d), TOBN(0x5ed3f3ce, 0x135a7e68),
+     TOBN(0x11cc139f, 0xe1994768), TOBN(0x6386c5c4, 0x77c07147),
+     TOBN(0x444230ae, 0x75fb9b2d), TOBN(0xa5972fd9, 0x8029bfeb),
+     TOBN(0x46e687ec, 0xdb5f8291), TOBN(0xf00bf689, 0x0de6d5f7),
+     TOBN(0xbf946c50, 0x36af6be3), TOBN(0xd6d9aaef, 0xd39dee1d),
+     TOBN(0xcb4e8512, 0x3bf921af), TOBN(0x28fc6332, 0x532e81d3),
+     TOBN(0x682d8637, 0xf69f907d), TOBN(0xbd9fa8f4, 0x5f759a16),
+     TOBN(0x091ea9fa, 0x51f03716), TOBN(0xd685a141, 0x32c630e9),
+     TOBN(0x7600c9ac, 0x3d249cf4), TOBN(0x687e2022, 0x002cd2b5),
+     TOBN(0x7ec205ab, 0x55334058), TOBN(0x9d0d86b1, 0x3ecf1368),
+     TOBN(0xb3fc17a7, 0xfc7baf6d), TOBN(0x57939961, 0x361c91cd),
+     TOBN(0xeb74751b, 0x37318b6d), TOBN(0xb967a3cf, 0x5abe7213),
+     TOBN(0x80741539, 0x02ab79cc), TOBN(0x11b647ae, 0xafbc3e08),
+     TOBN(0x3e34458e, 0x9e949616), TOBN(0x6d714d62, 0x72591fad),
+     TOBN(0x813ba91c, 0x131b7659), TOBN(0x7f836d36, 0xfd0e295e),
+     TOBN(0x192531f8, 0xc5d7be99), TOBN(0xce83f561, 0x901e480e),
+     TOBN(0x7b187da4, 0xf1bba4dd), TOBN(0x090754d0, 0xf5c82a33),
+     TOBN(0x0db33228, 0x010c0754), TOBN(0x10635ffa, 0x8eca7c59),
+     TOBN(0x6efd8538, 0x0e8a38fa), TOBN(0xc1812ea5, 0x769360d8),
+     TOBN(0x505723dc, 0x76f27ef5), TOBN(0xd0358e02, 0xf35af2e8),
+     TOBN(0x9f7bb7fe, 0xd99419ee), TOBN(0x87c66e83, 0x430a0e2d),
+     TOBN(0x01187549, 0x773eaf7f), TOBN(0x05bbbba4, 0x89d51bda),
+     TOBN(0x52cabb06, 0x640ccde6), TOBN(0x0d5cb557, 0xe7ff387d),
+     TOBN(0xa338a9f7, 0x526f59f3), TOBN(0x9b866285, 0x216004f8),
+     TOBN(0xe94cfd05, 0xeb6fcc58), TOBN(0xc60b12ea, 0x2432ba24),
+     TOBN(0x3bb7acf1, 0xef1227f5), TOBN(0x176e0ef7, 0x5ec503dd),
+     TOBN(0x9c2337f7, 0x236f9707), TOBN(0xdc2b0f77, 0xe029aa27),
+     TOBN(0xb795424a, 0xa5f85372), TOBN(0x2eb6d54b, 0x1485af98),
+     TOBN(0xd2ce87dd, 0x7e3f46c7), TOBN(0xc5eaf6ad, 0x830f743c),
+     TOBN(0x709d61ca, 0x10e06f1a), TOBN(0xaa1e9fc5, 0x78eba75c),
+     TOBN(0xf85d062f, 0x914b2cfc), TOBN(0xe73b3baf, 0x9089d85c),
+     TOBN(0x4ac05fea, 0xc4a284b9), TOBN(0x92c78a43, 0x3acb7268),
+     TOBN(0x7b5586f8, 0xee45bb4d), TOBN(0xc39a0d0e, 0x6ac0a9e7),
+     TOBN(0xe4bbe3d5, 0x4d6f9ab8), TOBN(0x1489463f, 0x1fd46a08),
+     TOBN(0x3ba31825, 0x29dba364), TOBN(0x94f000d6, 0x8138511b),
+     TOBN(0x9f8eafec, 0xee9b6d83), TOBN(0x069d5ad9, 0xf4eac676),
+     TOBN(0xbf9ccc6e, 0xb5687ebb), TOBN(0x5d0f44be, 0x9d213f1d),
+     TOBN(0x372b5296, 0x0d0d6e70), TOBN(0xef1466ef, 0xf8bb90f3),
+     TOBN(0x2ec1daae, 0x949789b2), TOBN(0x5c7d9b6d, 0xb40be288),
+     TOBN(0x48319460, 0xc351e87f), TOBN(0xfeaa721c, 0x5db0fde9),
+     TOBN(0xb33d58e9, 0xd16dc699), TOBN(0xe3f296f2, 0x3ca8d3d6),
+     TOBN(0x70187dfb, 0xc39c1cef), TOBN(0xa785216e, 0x0c50c71e),
+     TOBN(0x30188b81, 0x6a6c0d60), TOBN(0xeaeda67d, 0x6a27e97b),
+     TOBN(0x4a519282, 0x6ba389aa), TOBN(0xb96c7c7e, 0xa2bf1273),
+     TOBN(0x8ff10657, 0x267fe714), TOBN(0xdff4a271, 0x996d91b7),
+     TOBN(0xe34ba3e1, 0x1dc7aed4), TOBN(0xc457048b, 0x38853d61),
+     TOBN(0xe89825db, 0x1ccbf658), TOBN(0x68c7b455, 0x6b255edd),
+     TOBN(0x2f6f6a0f, 0x49d38208), TOBN(0x38fbcb5b, 0x11ee2340),
+     TOBN(0x06e43b73, 0x865a4304), TOBN(0x08c696e6, 0x06d728ad),
+     TOBN(0xdb82930d, 0x961c650b), TOBN(0xf1de8cb5, 0xc20c5b68),
+     TOBN(0xd8e3cf7b, 0xf8e1f9b9), TOBN(0xd6e081ab, 0xf3a304ed),
+     TOBN(0xf08d8624, 0xcd3cb8bb), TOBN(0xa3fe7742, 0xb26aa9cb),
+     TOBN(0xa3a9d220, 0x0de295f6), TOBN(0xfd465046, 0xb9579b7f),
+     TOBN(0xdc14cb2a, 0x74871e18), TOBN(0x017b1340, 0xfcb8974a),
+     TOBN(0xea5cb054, 0x6e93c20f), TOBN(0xa7c078ad, 0xa9e2ad1f),
+     TOBN(0xa37207d4, 0xbeb26838), TOBN(0xcd8b3b25, 0xde7ee8ee),
+     TOBN(0xdca6606a, 0x2801a7ff), TOBN(0xad2fedcf, 0x0f8af3fa),
+     TOBN(0xf27d30b4, 0x9b530c05), TOBN(0x071fc1c3, 0x6b2a4613),
+     TOBN(0x363aaa99, 0xb72cea9f), TOBN(0x7a33ed8f, 0x3d350374),
+     TOBN(0xac02833f, 0xf2f3e9ea), TOBN(0x43bcbde0, 0x956fb86e),
+     TOBN(0xf888696b, 0x95735c62), TOBN(0xefa03aae, 0xe7b2fd9e),
+     TOBN(0x0e563e92, 0xe75b2684), TOBN(0xa49d2f31, 0xd7f335bd),
+     TOBN(0x08664171, 0x8ac31404), TOBN(0x35866eab, 0x07ccf31f),
+     TOBN(0x6bca6111, 0x04122373), TOBN(0x730c92e5, 0xcb21398b),
+     TOBN(0x283791a8, 0xb93102d5), TOBN(0x4b41d94d, 0x50dc1b38),
+     TOBN(0xc377b373, 0xbb20fabf), TOBN(0x68d3aa52, 0xf986b847),
+     TOBN(0xd9c2f2ad, 0xf39b6894), TOBN(0x1bbff106, 0xbd6da22e),
+     TOBN(0x3f7e5b8e, 0x7e09678e), TOBN(0xad6a8789, 0x7ed3ee78),
+     TOBN(0x689e6b31, 0xaf9807b9), TOBN(0xeca87778, 0xbd1f6ef2),
+     TOBN(0x17d3277e, 0xdda78c54), TOBN(0xe686cacc, 0xefb65cb7),
+     TOBN(0x758aa1ab, 0x19a30f0c), TOBN(0xb40df97f, 0xb11f071e)},
+    {TOBN(0x16f3708b, 0x953b9223), TOBN(0x0d3780f8, 0x770e7cf3),
+     TOBN(0x97a615b2, 0x27bb71a8), TOBN(0xa8b9a864, 0x162f8b55),
+     TOBN(0x80ee8362, 0xd91e3fb9), TOBN(0xb2009a09, 0xf83a4ff6),
+     TOBN(0x07a7873a, 0xc1696281), TOBN(0x17ff00c2, 0x23095ddc),
+     TOBN(0x427f683d, 0x860d60ba), TOBN(0xea995927, 0x1f87d32a),
+     TOBN(0xb2ac69fa, 0xa050319d), TOBN(0x30c362b9, 0xd2d0b9ce),
+     TOBN(0x24480c57, 0xf26feef9), TOBN(0xc31a2694, 0x3a0e1240),
+     TOBN(0x735002c3, 0x273e2bc7), TOBN(0x8c42e9c5, 0x3ef1ed4c),
+     TOBN(0x028babf6, 0x7f4948e8), TOBN(0x6a502f43, 0x8a978632),
+     TOBN(0xf5f13a46, 0xb74536fe), TOBN(0x1d218bab, 0xd8a9f0eb),
+     TOBN(0x30f36bcc, 0x37232768), TOBN(0xc5317b31, 0x576e8c18),
+     TOBN(0xef1d57a6, 0x9bbcb766), TOBN(0x917c4930, 0xb3e3d4dc),
+     TOBN(0xff41d51f, 0xaae4bfd4), TOBN(0xcf50b141, 0x17c44fac),
+     TOBN(0x078b808e, 0x657a1ea4), TOBN(0xc5aac1a8, 0x93c00c55),
+     TOBN(0xcb99cfd0, 0xcc4d1c0f), TOBN(0x1d104893, 0x3fa123a6),
+     TOBN(0x49646059, 0x023ca92f), TOBN(0x5833e326, 0xf3982134),
+     TOBN(0x2e0d4bc9, 0xc5781cdd), TOBN(0x5f7f84ed, 0x8d5e75f5),
+     TOBN(0xb6655f1f, 0xe1e8a383), TOBN(0xcc18514c, 0x296e4943),
+     TOBN(0x53ebbaae, 0xb475d8f3), TOBN(0x3d6ea31c, 0xff76beda),
+     TOBN(0x3c15f25d, 0x340986b4), TOBN(0xc5925d2e, 0x3365312a),
+     TOBN(0xc35d3ee2, 0x51641f96), TOBN(0x11eb2f75, 0x984128e4),
+     TOBN(0xb41a21a8, 0x3d04bc99), TOBN(0xf2d28600, 0x6436c3d0),
+     TOBN(0x4ffcf4c0, 0xfaf5663c), TOBN(0x889d285a, 0x0a62c9dc),
+     TOBN(0x0908665a, 0xcb2d60c5), TOBN(0xe2f19c59, 0x0a131be5),
+     TOBN(0xa93a7dbc, 0xb1e46617), TOBN(0xd0ad4a47, 0xd77195a7),
+     TOBN(0x020d8467, 0xe5948165), TOBN(0xa3375bd9, 0x25267b60),
+     TOBN(0x8cf54ab2, 0x8c44e226), TOBN(0xc4f7f467, 0xf2bf5bfe),
+     TOBN(0xde336f92, 0xc414077a), TOBN(0x92656952, 0xc92d7219),
+     TOBN(0x31645a70, 0xc09ee1d9), TOBN(0x8cfe567d, 0x292630eb),
+     TOBN(0xb835edb9, 0x7c16c0a8), TOBN(0x8ac88e9c, 0x48dee1be),
+     TOBN(0x318feb4c, 0x22319bfb), TOBN(0xfd0a1331, 0xa1ee9625),
+     TOBN(0x1e4a786d, 0x5b238661), TOBN(0x88e04305, 0xa722c591),
+     TOBN(0x38eb062a, 0xf406cb01), TOBN(0x21caa381, 0xe7216364),
+     TOBN(0x450c1d29, 0xf0e1f665), TOBN(0x369af7bf, 0x207a1320),
+     TOBN(0xfe46a53a, 0x6f6c0680), TOBN(0x4553199a, 0x25eac032),
+     TOBN(0x41fa659a, 0xffc49722), TOBN(0xfb9e0c73, 0xbbcb7a29),
+     TOBN(0xca53bd85, 0x7e09207e), TOBN(0xa304cf7d, 0xfa171b01),
+     TOBN(0xa93499d7, 0x881beffa), TOBN(0xc0b04ee5, 0x95cf1295),
+     TOBN(0xe0cf548e, 0x90cd1e30), TOBN(0xfa82436e, 0x821b4efc),
+     TOBN(0xbb4d7958, 0x979ab01d), TOBN(0x4a1c815b, 0xd48ca82b),
+     TOBN(0xbacf6a1b, 0x627640fd), TOBN(0x31150946, 0xabd9a758),
+     TOBN(0x2c9d7d14, 0x906bea56), TOBN(0xd2450bcf, 0x17e06ed1),
+     TOBN(0xc0de60f5, 0x091354ff), TOBN(0xd7cc38bb, 0xa1bd1975),
+     TOBN(0xf4122aa8, 0xe734e2df), TOBN(0x08f40f63, 0xef773db6),
+     TOBN(0x0a7e9484, 0xce2d71c5), TOBN(0xcc791733, 0x78a3f825),
+     TOBN(0x0cac7a5b, 0xb47beec9), TOBN(0x1cbea0e4, 0xa3f7b5b6),
+     TOBN(0xecf19a90, 0xd3e18145), TOBN(0x0d1b062a, 0x0aadf689),
+     TOBN(0x42299f1f, 0xf3f0acf7), TOBN(0x63a64539, 0x5ac252b9),
+     TOBN(0xfda26247, 0x8db83d7d), TOBN(0x3a2d1c29, 0x2ad24ac5),
+     TOBN(0x586b6219, 0xa01d0daa), TOBN(0xa92f773b, 0x949dbc96),
+     TOBN(0x89c9668d, 0x5dc355d0), TOBN(0x0aaeecdf, 0xb5e40672),
+     TOBN(0x5945a47f, 0x2c701014), TOBN(0x50e4a494, 0xc5590e89),
+     TOBN(0x307cbd9f, 0x7fd21edd), TOBN(0x96005378, 0xb85543b7),
+     TOBN(0x9f87fddf, 0xba214861), TOBN(0xcdd615c5, 0xf9d9d2c7),
+     TOBN(0xa4bfe151, 0x5bd11a42), TOBN(0x38920da2, 0x0ea6729b),
+     TOBN(0x41e28260, 0xa0ee708f), TOBN(0xff4fdff4, 0xabc9d5f5),
+     TOBN(0x6ed92241, 0xffaae99e), TOBN(0x6075ce0d, 0xc04fe4d9),
+     TOBN(0xf10a173e, 0x5db066f5), TOBN(0xa2edee12, 0xe75ef129),
+     TOBN(0xd2a0823f, 0x8ed02e85), TOBN(0xffa78cf4, 0x2e522dc1),
+     TOBN(0x07041e46, 0x00c939fd), TOBN(0x3369357f, 0x3a9a8bba),
+     TOBN(0x3b202533, 0x1a4e68b1), TOBN(0xa2ead2d7, 0xf7504686),
+     TOBN(0xb0bb1808, 0xa569cb36), TOBN(0x953f539c, 0xc015c68f),
+     TOBN(0x45c876dc, 0x9a6fefe1), TOBN(0xe87ce8ac, 0xbede60ec),
+     TOBN(0xecfc84dd, 0xf3c69642), TOBN(0xabe549ed, 0x3a90826b),
+     TOBN(0x03a29df4, 0x57cca429), TOBN(0x08d4e9a1, 0xb8e72b83),
+     TOBN(0x88d9c51b, 0x79e7ef57), TOBN(0x48102f0e, 0xdc075e38),
+     TOBN(0xa1fc20f7, 0xba264fa8), TOBN(0x0f625415, 0x4105e64a),
+     TOBN(0x2e5581c2, 0x8e2e8e16), TOBN(0x912c80fa, 0x4c456234),
+     TOBN(0x7fd61fb9, 0xe9e31ad4), TOBN(0xa5de4e7d, 0x1c19e811),
+     TOBN(0x6a7ab2cc, 0x2961b64d), TOBN(0xbf06db25, 0x5bb2da03),
+     TOBN(0x33f76a85, 0xab06af4d), TOBN(0xda387e54, 0x4866378d),
+     TOBN(0xbb71deb8, 0x56826f8c), TOBN(0xbbe3ce38, 0xeb64ecb6),
+     TOBN(0x2a6f3d84, 0xbb63bdd0), TOBN(0x8b5becec, 0xc2792d41),
+     TOBN(0xb0412202, 0xec9fa26b), TOBN(0xbdaad566, 0xbc706607),
+     TOBN(0xd34e3ef1, 0xd8d361d4), TOBN(0xb4fe020e, 0xeb3c3f14),
+     TOBN(0xc6bac95d, 0x82656dd4), TOBN(0x8cf56ba0, 0x88ffb328),
+     TOBN(0x33f04dda, 0xdc84969a), TOBN(0x642d93d6, 0xa5f1d0eb),
+     TOBN(0x122e35f6, 0x93ce88dd), TOBN(0xbcffc369, 0x02c0e82a),
+     TOBN(0x0e935934, 0xfd5d084c), TOBN(0x7cd4992a, 0x9121a6e0),
+     TOBN(0xab773dba, 0x8e15d863), TOBN(0x9cea4a51, 0xcab64644),
+     TOBN(0x516754d7, 0x2efff061), TOBN(0xd8af89da, 0xcd3a36a4),
+     TOBN(0xc7d352ac, 0x4615774e), TOBN(0xd1bb914b, 0x21ae0d27),
+     TOBN(0x8a8aed97, 0x9199938e), TOBN(0xeb06789a, 0xcd6f3495),
+     TOBN(0xc51d7766, 0x775f93ee), TOBN(0x7eb6909f, 0x0a8af851),
+     TOBN(0xf6708309, 0x6a82fd92), TOBN(0x08652b2b, 0xfffaccf2),
+     TOBN(0x8ac0e67b, 0xf0da4c5c), TOBN(0x26c5a4be, 0xb0fabc5d),
+     TOBN(0x3e5ad350, 0xb1dcad44), TOBN(0xb539e10e, 0x3aa30664),
+     TOBN(0x266f4163, 0xa41fef81), TOBN(0x860401ec, 0x78ef116f),
+     TOBN(0xb0fc5cc3, 0x3563575b), TOBN(0xc28a5cb5, 0xd4c9e03a),
+     TOBN(0x93399eff, 0xcc9bbe6c), TOBN(0x50a48cb2, 0x9c9a84a2),
+     TOBN(0x44bfd166, 0x5c1d4586), TOBN(0x46434e19, 0x8d1d86d6),
+     TOBN(0xe50fcf81, 0xc3936683), TOBN(0xc9b4eb06, 0x8b08680f),
+     TOBN(0xf90882c5, 0x2832aab0), TOBN(0x42823cef, 0xecbf5dda),
+     TOBN(0xfd4d51c7, 0x44ae08f0), TOBN(0xb54a08f1, 0xbbd21c1c),
+     TOBN(0xb72953db, 0xfb187c34), TOBN(0x166f7f26, 0xf8ed037f),
+     TOBN(0xd2b1077a, 0x097bad45), TOBN(0x47794cdc, 0x790dd808)},
+    {TOBN(0xa05c751c, 0xd1d1b007), TOBN(0x016c213b, 0x0213e478),
+     TOBN(0x9c56e26c, 0xf4c98fee), TOBN(0x6084f8b9, 0xe7b3a7c7),
+     TOBN(0xa0b042f6, 0xdecc1646), TOBN(0x4a6f3c1a, 0xfbf3a0bc),
+     TOBN(0x94524c2c, 0x51c9f909), TOBN(0xf3b3ad40, 0x3a6d3748),
+     TOBN(0x18792d6e, 0x7ce1f9f5), TOBN(0x8ebc2fd7, 0xfc0c34fa),
+     TOBN(0x032a9f41, 0x780a1693), TOBN(0x34f9801e, 0x56a60019),
+     TOBN(0xa4b957d2, 0x62c36887), TOBN(0xaf15a485, 0xfc24cff8),
+     TOBN(0x11575e80, 0xa271d9e0), TOBN(0x0fff68d4, 0x4b9367e5),
+     TOBN(0xf55ba673, 0x2279779f), TOBN(0x9d72cca6, 0xd4d68f68),
+     TOBN(0x01474ab1, 0x590ffe4c), TOBN(0xd20f44e1, 0x074d634b),
+     TOBN(0x63903a83, 0x36111d25), TOBN(0x37342a5f, 0xab531cef),
+     TOBN(0xd3c93fe7, 0x702ed867), TOBN(0x05d14369, 0x6279f7e1),
+     TOBN(0xb398290c, 0xf0db3751), TOBN(0x01170580, 0xba42c976),
+     TOBN(0x3e71aa29, 0x56560b89), TOBN(0x80817aac, 0x50e6647b),
+     TOBN(0x35c833ad, 0xa0be42da), TOBN(0xfa3c6148, 0xf1baba4e),
+     TOBN(0xc57be645, 0xcd8f6253), TOBN(0x77cee46b, 0xc657ad0d),
+     TOBN(0x83007731, 0x0defd908), TOBN(0x92fe9bce, 0x899cba56),
+     TOBN(0x48450ec4, 0xbceffb5a), TOBN(0xe615148d, 0xf2f5f4bf),
+     TOBN(0xdccf68bc, 0xcbaf4685), TOBN(0xb333e464, 0x270a2bcc),
+     TOBN(0xe43ae199, 0x254dd3e3), TOBN(0xe8526e26, 0xddce5c84),
+     TOBN(0x52bad815, 0xea0b4258), TOBN(0x67c12c1b, 0x094574c4),
+     TOBN(0xa5362fcb, 0x861545b7), TOBN(0x3e904c35, 0xc2b2eb62),
+     TOBN(0x0f9312b5, 0xeeffc2cd), TOBN(0x5475657b, 0x14de4e5b),
+     TOBN(0x746e67d4, 0xf0233fa5), TOBN(0xb5157d7f, 0x35471ec2),
+     TOBN(0xf55edabb, 0x90b86166), TOBN(0x27f7d784, 0x075430a2),
+     TOBN(0xf53e822b, 0x9bf17161), TOBN(0x4a5b3b93, 0xafe808dc),
+     TOBN(0x590bbbde, 0xd7272f55), TOBN(0x233d63fa, 0xeaea79a1),
+     TOBN(0xd7042bea, 0xfe1eba07), TOBN(0xd2b9aea0, 0x10750d7e),
+     TOBN(0xd8d1e690, 0x31078aa5), TOBN(0x9e837f18, 0x7e37bc8b),
+     TOBN(0x9558ff4f, 0x85008975), TOBN(0x93edb837, 0x421fe867),
+     TOBN(0x3503d937, 0x1f23a0d8), TOBN(0x64c598a8, 0xc321dde0),
+     TOBN(0x67f101ef, 0x5b52e0f0), TOBN(0xb6b5b4c2, 0xf955b5fa),
+     TOBN(0xb5f03d53, 0x880e0569), TOBN(0x121c3ac1, 0xc99393ef),
+     TOBN(0x90755bd6, 0x57330666), TOBN(0x70ae5793, 0xd4d71d3d),
+     TOBN(0x326ffd51, 0x9e9ce792), TOBN(0x1b772d73, 0x96ccfa14),
+     TOBN(0x652710f4, 0x874a22de), TOBN(0x72768469, 0xdb210342),
+     TOBN(0xaa6489df, 0x83d55b5a), TOBN(0xea092e49, 0x86bf27f7),
+     TOBN(0x4d8943a9, 0x5fa2efec), TOBN(0xc9baae53, 0x720e1a8c),
+     TOBN(0xc055444b, 0x95a4f8a3), TOBN(0x93bd01e8, 0xa7c1206b),
+     TOBN(0xd97765b6, 0x714a27df), TOBN(0xd622d954, 0x193f1b16),
+     TOBN(0x115cc35a, 0xf1503b15), TOBN(0x1dd5359f, 0xa9fa21f8),
+     TOBN(0x197c3299, 0x6dfed1f1), TOBN(0xdee8b7c9, 0xf77f2679),
+     TOBN(0x58d6998e, 0x171c1439), TOBN(0xfd4a98f4, 0x01feedec),
+     TOBN(0x420b2a01, 0x65739fce), TOBN(0x5c5db308, 0x22f7a073),
+     TOBN(0x016c5478, 0x05042f00), TOBN(0x5fc73ce2, 0xa12413d9),
+     TOBN(0x8ceb2d70, 0xe932aa17), TOBN(0xb4d66b67, 0x0537afaf),
+     TOBN(0x2638d012, 0x339c146b), TOBN(0x02fbb7b6, 0x28ac0555),
+     TOBN(0x7fcb0c81, 0x62d46e63), TOBN(0xeaa9ff4f, 0x066d088e),
+     TOBN(0x5405179f, 0x394fd855), TOBN(0xc9d6e244, 0x49fdfb33),
+     TOBN(0x70ebcab4, 0xbd903393), TOBN(0x0d3a3899, 0xa2c56780),
+     TOBN(0x012c7256, 0x683d1a0a), TOBN(0xc688fc88, 0x80a48f3b),
+     TOBN(0x18095754, 0x6f7df527), TOBN(0x9e339b4b, 0x71315d16),
+     TOBN(0x90560c28, 0xa956bb12), TOBN(0x2becea60, 0xd42eee8d),
+     TOBN(0x82aeb9a7, 0x50632653), TOBN(0xed34353e, 0xdfa5cd6a),
+     TOBN(0x8273db99, 0x2d189057), TOBN(0x4d1b05fc, 0xe1b5f8cc),
+     TOBN(0x5fec7c83, 0x0a7c32d1), TOBN(0x28ddaf28, 0xea9b4d45),
+     TOBN(0xb6bb62ac, 0xa2fc58be), TOBN(0xfc65b7aa, 0x4a41852d),
+     TOBN(0x6e765194, 0x1c9e6045), TOBN(0x3acabf28, 0xfc116257),
+     TOBN(0xc9d5e805, 0x4b5a4ba8), TOBN(0x9a072259, 0xcbdcf1eb),
+     TOBN(0xc67cf643, 0x439fc8fc), TOBN(0x917ef6f8, 0xb4333aa8),
+     TOBN(0x82154d2c, 0x91aecce4), TOBN(0x312c6070, 0x5041887f),
+     TOBN(0xecf589f3, 0xfb9fbd71), TOBN(0x67660a7d, 0xb524bde4),
+     TOBN(0xe99b029d, 0x724acf23), TOBN(0xdf06e4af, 0x6d1cd891),
+     TOBN(0x07806cb5, 0x80ee304d), TOBN(0x0c70bb9f, 0x7443a8f8),
+     TOBN(0x01ec3414, 0x08b0830a), TOBN(0xfd7b63c3, 0x5a81510b),
+     TOBN(0xe90a0a39, 0x453b5f93), TOBN(0xab700f8f, 0x9bc71725),
+     TOBN(0x311ebba2, 0xfc37efed), TOBN(0x8a6a42d6, 0x60cfd6bc),
+     TOBN(0xb4051b3a, 0xf2a4871e), TOBN(0x66ce77b8, 0xc2f0ebf0),
+     TOBN(0x84abc948, 0x0ad28477), TOBN(0xc82e5c62, 0x63d9d11a),
+     TOBN(0x99ffc70c, 0x007dcf93), TOBN(0x5e974edf, 0xd964c822),
+     TOBN(0x0fee3572, 0x513085e3), TOBN(0xbe67a880, 0x46ce8444),
+     TOBN(0x136ceeb8, 0x06d17129), TOBN(0x0da512ae, 0x662d86fd),
+     TOBN(0x9401aec2, 0xb9f00793), TOBN(0x064ec4f4, 0xb997f0bf),
+     TOBN(0xdc0cc1fd, 0x849240c8), TOBN(0x39a75f37, 0xb6e92d72),
+     TOBN(0xaa43ca5d, 0x0224a4ab), TOBN(0x9c4d6325, 0x54614c47),
+     TOBN(0x1767366f, 0xc6709da3), TOBN(0xa6b482d1, 0x23479232),
+     TOBN(0x54dc6ddc, 0x84d63e85), TOBN(0x0accb5ad, 0xc99d3b9e),
+     TOBN(0x211716bb, 0xe8aa3abf), TOBN(0xd0fe25ad, 0x69ec6406),
+     TOBN(0xe7acaa84, 0x57e0105d), TOBN(0x3c06d3bd, 0x3851fd57),
+     TOBN(0x23cf3c61, 0x2a9c631b), TOBN(0x13888aaa, 0x33863bf8),
+     TOBN(0xf2396355, 0x717783ee), TOBN(0xf21e1a48, 0x36b300e1),
+     TOBN(0xa734cb3b, 0x9d27b4cb), TOBN(0x0a7effed, 0x796e34b6),
+     TOBN(0xfc586477, 0x3615cc7a), TOBN(0x1f98ed77, 0x88844a21),
+     TOBN(0xd6e28940, 0x7ad4c7bd), TOBN(0xa00d64eb, 0xe9331c7e),
+     TOBN(0x0d5c1769, 0xdf85c705), TOBN(0x7086c93d, 0xa409dcd1),
+     TOBN(0x9710839d, 0x0e8d75d8), TOBN(0x17b7db75, 0xebdd4177),
+     TOBN(0xaf69eb58, 0xf649a809), TOBN(0x6ef19ea2, 0x8a84e220),
+     TOBN(0x36eb5c66, 0x65c278b2), TOBN(0xd2a15128, 0x81ea9d65),
+     TOBN(0x4fcba840, 0x769300ad), TOBN(0xc2052ccd, 0xc8e536e5),
+     TOBN(0x9caee014, 0xac263b8f), TOBN(0x56f7ed7a, 0xf9239663),
+     TOBN(0x17e3d0b8, 0x713b8541), TOBN(0xf372b048, 0xc6b5e839),
+     TOBN(0xf8ef0261, 0xd0bb1848), TOBN(0x9b804cee, 0xc71a3bbe),
+     TOBN(0x00b7d171, 0x542a88ae), TOBN(0xf2b8ed10, 0xe9097b9e),
+     TOBN(0xdbad9f12, 0x2c0a009a), TOBN(0x245fc1e9, 0x205fb1bf),
+     TOBN(0xa8a4834f, 0xb83debf5), TOBN(0xc3ee226d, 0x637e449b),
+     TOBN(0xe3070d93, 0xcab82664), TOBN(0x24b8094d, 0xb37320e8)},
+    {TOBN(0xb506b7b9, 0x25059699), TOBN(0x349fd83f, 0x01ab02e5),
+     TOBN(0x64b729ad, 0x3789281e), TOBN(0x69ae8f81, 0xf9af4561),
+     TOBN(0x007befe1, 0x56f91860), TOBN(0xb578c566, 0xedc250fb),
+     TOBN(0x1c16d75a, 0x67ae4801), TOBN(0x04c35a7e, 0xa1d3f592),
+     TOBN(0x5dc97da9, 0x36881f89), TOBN(0xaddb6031, 0x03a5b1ea),
+     TOBN(0x7eb515b1, 0x3e153a0f), TOBN(0xdc3a9219, 0x2b4a1ee2),
+     TOBN(0xe7365f9e, 0x512cc92a), TOBN(0x9efdcf8b, 0x5172a654),
+     TOBN(0xbfb389ac, 0x8e611fc3), TOBN(0xce778fd5, 0x699c227d),
+     TOBN(0xdc1f47b6, 0x3ff2ef17), TOBN(0x2ae0f683, 0x02672ed4),
+     TOBN(0x51c63806, 0xa8e879cb), TOBN(0xd3dfecf0, 0x3909f526),
+     TOBN(0x375b3d13, 0xe00e12a2), TOBN(0x91f9f750, 0xbf8df325),
+     TOBN(0xf1ea0e42, 0x1df5f21a), TOBN(0xaed73e7f, 0x32c60584),
+     TOBN(0x03b07fb5, 0xe0728e6d), TOBN(0x9e046920, 0x1012234e),
+     TOBN(0x272e6449, 0x35637644), TOBN(0x2b6ad1c2, 0xa55bcadf),
+     TOBN(0x86c52776, 0x5c71c6af), TOBN(0xa25bd60b, 0xc1678806),
+     TOBN(0x0cae8294, 0x76bb32f8), TOBN(0x389ce4e6, 0x33e03cb2),
+     TOBN(0x504df833, 0x7513dfb6), TOBN(0x4260ee8e, 0x1b351dda),
+     TOBN(0xa473c5d9, 0xdbaf7cd0), TOBN(0x22cb7cb4, 0x71e390fd),
+     TOBN(0x1d9aa9fa, 0x26caebd8), TOBN(0x6b646869, 0x26b7a673),
+     TOBN(0x7ebed6a1, 0x7f167b47), TOBN(0x324c13f8, 0x5bd9153d),
+     TOBN(0xe9ea5b73, 0x4c682ba6), TOBN(0x2961da7d, 0x7e3ff6e2),
+     TOBN(0x1ed2b050, 0x01a83dad), TOBN(0xb232951d, 0xc4a2f60a),
+     TOBN(0xafcea5d3, 0xd68b8ec6), TOBN(0x21dc058d, 0x1c6ce0d2),
+     TOBN(0x0043de75, 0xe719410c), TOBN(0x4edd792c, 0xe15cf534),
+     TOBN(0x0f45245f, 0x3babe09e), TOBN(0x0959326f, 0xa9f2fac5),
+     TOBN(0x7629e7fb, 0x5cc136e5), TOBN(0x208bd5a6, 0xe48b7eb0),
+     TOBN(0x637891d6, 0xb75a85cb), TOBN(0xf0ad9d8d, 0x9f27b57e),
+     TOBN(0x437b6944, 0xe0454b05), TOBN(0x022c51d7, 0x02ed3592),
+     TOBN(0x0f79e2bd, 0x0dc0a769), TOBN(0x54ace1fd, 0xd9b81f9b),
+     TOBN(0x38611d66, 0xf95ea8dc), TOBN(0x52443ca8, 0xf0e6147b),
+     TOBN(0x857d6855, 0x8bc272d0), TOBN(0x4583eeee, 0xb5be2485),
+     TOBN(0xb83586da, 0xfe0152ec), TOBN(0x8b0eb223, 0xe830294a),
+     TOBN(0x757582b6, 0xa5b0e880), TOBN(0x5140c016, 0x9cca7fff),
+     TOBN(0x07a00782, 0xe9228f12), TOBN(0xb96e2b5d, 0xd4973080),
+     TOBN(0x3cceb9a6, 0xe88efbe6), TOBN(0x9955b630, 0x73fcdd25),
+     TOBN(0x04f26ab0, 0x2805d470), TOBN(0x90b38299, 0x424da086),
+     TOBN(0x73f1ae48, 0xf4f6c5b4), TOBN(0xee5af13d, 0x4a477f01),
+     TOBN(0x274614a2, 0xddb93d52), TOBN(0x90b0c563, 0xc320aaf5),
+     TOBN(0xee2303c8, 0xef990b0b), TOBN(0x00d028e7, 0x3061f140),
+     TOBN(0xff705011, 0xcb3d8eaf), TOBN(0xae1d9908, 0x62594f4c),
+     TOBN(0x22a27cec, 0xdafea438), TOBN(0xa78e12d5, 0xc5962ea9),
+     TOBN(0x5bbe9d87, 0x8e65f9cf), TOBN(0xa222580c, 0xf47cefa6),
+     TOBN(0xf7aaa732, 0x959abb9e), TOBN(0x1222ad0a, 0x2ebf80b9),
+     TOBN(0xa1a41737, 0x2e0c286e), TOBN(0x3b668502, 0x5da3472d),
+     TOBN(0xbc0d116b, 0x7576f2a2), TOBN(0xfdbcad95, 0xa36a27d4),
+     TOBN(0xcdb3f474, 0x9d54f7ee), TOBN(0xe2e0f5f9, 0x8a5643a3),
+     TOBN(0xc70d11b9, 0x69d4f171), TOBN(0xdf96d136, 0x6cca4ef7),
+     TOBN(0x570693db, 0x2fc6afdf), TOBN(0x5059e67b, 0x567504da),
+     TOBN(0x2c8107d4, 0x7fe632a2), TOBN(0xfc46c745, 0xede7bff8),
+     TOBN(0x2d3b1286, 0x4650025b), TOBN(0x815ef3cb, 0xe74cd65f),
+     TOBN(0x5431b01b, 0xa256f01c), TOBN(0xe832ff11, 0x39915cfa),
+     TOBN(0x2c106de6, 0x07d7af84), TOBN(0x67303b78, 0x6d4753e7),
+     TOBN(0x5f886ffa, 0x6d75c8de), TOBN(0x932a6c20, 0x967131cf),
+     TOBN(0x5bc94a91, 0x70aebbb0), TOBN(0xa85b3044, 0xfd56e06d),
+     TOBN(0xc904558a, 0xe7eba799), TOBN(0x46b6031b, 0xb2fa7331),
+     TOBN(0x6620e2b5, 0x0653675c), TOBN(0xd1373a35, 0x7d2218f7),
+     TOBN(0x0f4b3ca3, 0xaf55a5e7), TOBN(0x50774160, 0x714e70c2),
+     TOBN(0xacc63d14, 0x69188455), TOBN(0x89a795fe, 0x043b8b30),
+     TOBN(0xac2fd66c, 0xe1e4b9cf), TOBN(0xac792702, 0x1bf67f26),
+     TOBN(0xb9513f0d, 0x1143d437), TOBN(0x02198050, 0x811f2931),
+     TOBN(0x6d4acdba, 0x7b480776), TOBN(0x8b518cd4, 0x66dffeb5),
+     TOBN(0x8826c994, 0x51918859), TOBN(0xd2b6a7a0, 0x38fad835),
+     TOBN(0xd315417a, 0x6929a870), TOBN(0x05d85252, 0xc5a769e1),
+     TOBN(0x2fa06335, 0xec0d091e), TOBN(0xb0cc3372, 0x87768c88),
+     TOBN(0xacbda5ba, 0x58a2eb9d), TOBN(0x2a404fc9, 0x76b7b057),
+     TOBN(0x073abb71, 0x838c6135), TOBN(0xbdf89b13, 0x5cfc4f3c),
+     TOBN(0xd00eb9c5, 0x3508675f), TOBN(0x92ec76a4, 0xa117dc95),
+     TOBN(0xf58d6f85, 0x334ca15c), TOBN(0xeeb52216, 0x9cee0544),
+     TOBN(0x3eb9847f, 0xf21457c2), TOBN(0x547908bc, 0x5524c60d),
+     TOBN(0xb5b49d22, 0x5198709b), TOBN(0x718abce6, 0x324abc67),
+     TOBN(0xdab8ff2f, 0x4abd54ba), TOBN(0x98be59e6, 0x7184d444),
+     TOBN(0x45b74b54, 0xbabeb4b0), TOBN(0xd8d8bb30, 0xff71a5ac),
+     TOBN(0x8aedf7e2, 0x8ec13e6f), TOBN(0x8b952620, 0xd950792d),
+     TOBN(0x36e9dac2, 0x04918f59), TOBN(0x5e49a5a2, 0xd3dd47ed),
+     TOBN(0xb17455be, 0xe863c2bd), TOBN(0x8caac6a9, 0x326a0d66),
+     TOBN(0xb6c3f5e4, 0x27bb72e1), TOBN(0x17566c9d, 0xee5fe09b),
+     TOBN(0xfd6bbcc2, 0x5e3db64d), TOBN(0xd437d07a, 0x3189319c),
+     TOBN(0xad00dfc4, 0xcd3166a5), TOBN(0xab75927b, 0x0bd63003),
+     TOBN(0xa7672a39, 0xafc43be8), TOBN(0xefc49015, 0xc72f97aa),
+     TOBN(0x81c63c05, 0x0e48f2ed), TOBN(0x62f39f32, 0x833a22cc),
+     TOBN(0xf7a34801, 0x72c0c0c4), TOBN(0x4711cd41, 0xa4158538),
+     TOBN(0xa3c99a4d, 0x1d15f2f3), TOBN(0x4b82c1c1, 0x7bee1b47),
+     TOBN(0xc7d60b48, 0x9d199f10), TOBN(0xd1d1f03d, 0x5f16fa95),
+     TOBN(0x96c780c9, 0x32fbeaf2), TOBN(0x0662e250, 0x376ff106),
+     TOBN(0x728e3346, 0x78571c8f), TOBN(0xd0a886b5, 0x6cb339d3),
+     TOBN(0xf4ea3338, 0x0a5671ba), TOBN(0x43823401, 0xa64850a4),
+     TOBN(0xa7729cd5, 0x33117b9d), TOBN(0x4dd45760, 0x2b78cffb),
+     TOBN(0xbe057111, 0x5a67d812), TOBN(0x7ec6cf92, 0x5105a3fc),
+     TOBN(0x5dbcb4bc, 0x0ccafeec), TOBN(0xa7587f15, 0x803092f8),
+     TOBN(0x67ee61d5, 0xa884efad), TOBN(0xd4ced554, 0xca47d9ca),
+     TOBN(0x02c6b608, 0x3b03dcbc), TOBN(0x2b20149e, 0x3b9d868a),
+     TOBN(0xaf5ab01d, 0x4f57eb0c), TOBN(0x59935b94, 0xd750e515),
+     TOBN(0x32721b40, 0x8f89ad68), TOBN(0x673bd755, 0xa7e3ceff),
+     TOBN(0xbd462fd8, 0xef3b3393), TOBN(0x99142264, 0x0e59a120),
+     TOBN(0x4162da61, 0x9263fa61), TOBN(0x2ed1f2de, 0xb6488eb3),
+     TOBN(0xb0bd37a8, 0x725680c4), TOBN(0x17218bf0, 0x29ec27b0)},
+    {TOBN(0xfb09e756, 0x4bd044ef), TOBN(0xdbc9fcdf, 0xbb964fb3),
+     TOBN(0x451c5b01, 0xcdb1f4f5), TOBN(0xb02f9068, 0xf1dd1cf0),
+     TOBN(0xd4765e7c, 0x0c687e41), TOBN(0x89b64981, 0xd1967bd3),
+     TOBN(0x06a0e4ec, 0xf0439d65), TOBN(0x564c387d, 0xa5abbcec),
+     TOBN(0xc1e9d01a, 0xc651d806), TOBN(0x5e6ebd83, 0x0618a96c),
+     TOBN(0x9ce1aace, 0xc54ad8ce), TOBN(0xe5248a08, 0x9953f90f),
+     TOBN(0xda2b0725, 0xbb296c27), TOBN(0x1f22ffa4, 0xd341171b),
+     TOBN(0xc721e35a, 0x5b132756), TOBN(0xe5695e84, 0xfadb6907),
+     TOBN(0xbc5a3bf4, 0xc283f546), TOBN(0x9182cb3e, 0xdde128ae),
+     TOBN(0x179c7fa6, 0x6592e05e), TOBN(0x1e604790, 0xf38e8586),
+     TOBN(0xaf7e83be, 0xa16bad55), TOBN(0x6f41231e, 0x9137ecd8),
+     TOBN(0xac87543d, 0x8f30d1ab), TOBN(0x630a9d87, 0xb1ee0ee8),
+     TOBN(0xd8ccf550, 0x0850b471), TOBN(0xea8f73d2, 0xf7ebfcd8),
+     TOBN(0xfb374f99, 0x7f138136), TOBN(0x6b3a1ab8, 0x6cd70e73),
+     TOBN(0xc4577c13, 0x42f40008), TOBN(0xb23800f9, 0xa0517e75),
+     TOBN(0x79deaa45, 0x7088a19b), TOBN(0xa8410f51, 0x702183ed),
+     TOBN(0xe2761fa1, 0x2c9f6594), TOBN(0xed1d0112, 0x52868276),
+     TOBN(0x9e9805d7, 0xc22157a4), TOBN(0xbe4aa213, 0xac7653e9),
+     TOBN(0x359cbfa0, 0x5e4f1914), TOBN(0x6992cd48, 0xd922176a),
+     TOBN(0x2fd5e90f, 0x630cbcb5), TOBN(0x2b0f6130, 0x6ddbf238),
+     TOBN(0x5070970a, 0x3af753e6), TOBN(0x433d0094, 0x41727016),
+     TOBN(0x2eb15b3b, 0x9dca97e2), TOBN(0x3a7379cd, 0x00d96875),
+     TOBN(0x0d4374ae, 0xe930a75c), TOBN(0x3cd36046, 0x849e7727),
+     TOBN(0x9ac3117e, 0x336a19ff), TOBN(0x2d1373c9, 0x433ddc04),
+     TOBN(0xa60026f0, 0x13a2a0f2), TOBN(0x173b08a8, 0xd6d8a91c),
+     TOBN(0xfa6b3eea, 0x2b0ff7fb), TOBN(0xd5417c7e, 0x4201b05d),
+     TOBN(0x91dacda7, 0x598f4c56), TOBN(0x00323d9a, 0x0a1513a5),
+     TOBN(0x079a4ef1, 0x38bf2619), TOBN(0xfe91faae, 0xee3512cc),
+     TOBN(0xbf9aabdf, 0xbc03468f), TOBN(0x0d46d3a2, 0x01d3ca1f),
+     TOBN(0x6bfad511, 0x3e677e61), TOBN(0x219a70aa, 0x6dabf925),
+     TOBN(0x8e145869, 0x8faa3eca), TOBN(0x811c0ab1, 0x511c5e09),
+     TOBN(0x08a52f04, 0xc39fd20b), TOBN(0xa7c22263, 0x5e5f514e),
+     TOBN(0x365701af, 0x8507e5c6), TOBN(0xba1c1ce2, 0x495177cc),
+     TOBN(0xed128050, 0xbd3d7f93), TOBN(0xf5b3a508, 0x05af7fa4),
+     TOBN(0xe27a017c, 0x7eb1e384), TOBN(0xaa95d99a, 0x1fbca0a7),
+     TOBN(0x61a459cf, 0xbaa36562), TOBN(0xc1ee4d7b, 0xb7f845c1),
+     TOBN(0x164a4fa1, 0xa4945d9f), TOBN(0xf9fb0327, 0x8ce7f161),
+     TOBN(0x5284c704, 0x9891eb36), TOBN(0x9ca1ee6b, 0x9bd23713),
+     TOBN(0xb364fe43, 0xbdc043e0), TOBN(0xcf9c9e70, 0xae82eb35),
+     TOBN(0xa375b9d5, 0xbcde9b87), TOBN(0x55f437d7, 0x6d5ada37),
+     TOBN(0x49fc8d72, 0x85bf9126), TOBN(0xf13cbab7, 0xbd83c1bc),
+     TOBN(0xc3d75306, 0xf847972a), TOBN(0x8c27482a, 0xb1da55aa),
+     TOBN(0x985dcb43, 0xe4362d67), TOBN(0xecb860c2, 0xa939bea4),
+     TOBN(0x40597f30, 0x55fbf1d5), TOBN(0xb6d166bf, 0x43fcd98a),
+     TOBN(0x59325709, 0x15ec99ca), TOBN(0xe05ae3b9, 0xc5bdd370),
+     TOBN(0xc18f7827, 0x0c7b943b), TOBN(0x84bde9c6, 0x4dd572cc),
+     TOBN(0x5d50a89d, 0xf478e56b), TOBN(0x242c2f48, 0x64d29053),
+     TOBN(0xcda12c61, 0x61cf7e0e), TOBN(0xf8b6890e, 0xac8d1d40),
+     TOBN(0x3f2c311e, 0x37d03584), TOBN(0xb387b3cc, 0xbb91574c),
+     TOBN(0xa64914d1, 0x8d7aa7af), TOBN(0x7586999a, 0xea0fb673),
+     TOBN(0x25ee7a70, 0x14e5014b), TOBN(0x1015b142, 0x557fce0f),
+     TOBN(0xbb839712, 0x10cc9d92), TOBN(0x31118426, 0xabbb3b2a),
+     TOBN(0xc3a4fa6f, 0xa29866e5), TOBN(0xbdb3a495, 0x66310a76),
+     TOBN(0xd397ceb6, 0xa11055e7), TOBN(0xc8d47e10, 0x0240bd0d),
+     TOBN(0x76624aad, 0xfc8d5f6c), TOBN(0xb7dbb41a, 0x0144a0ff),
+     TOBN(0xd7be190f, 0x30df5bea), TOBN(0xb61e3e97, 0x9ed58b6a),
+     TOBN(0xce192eb3, 0x14bf09f6), TOBN(0x3d6632af, 0x27ad3fc4),
+     TOBN(0x51f180e8, 0xcdd7c93b), TOBN(0x257df031, 0x932c89f0),
+     TOBN(0xed1ffbcb, 0xb680f621), TOBN(0x6d8be601, 0x34ef3db2),
+     TOBN(0xc32869e3, 0x044b7f8a), TOBN(0x8db40995, 0x09958ada),
+     TOBN(0x004888a9, 0x7ebfc0d7), TOBN(0x5546c1b1, 0x0f90df8a),
+     TOBN(0x9c73aa4e, 0xddfb6a92), TOBN(0xb492a723, 0x2782e2a4),
+     TOBN(0x5e79ce87, 0x2b9b9390), TOBN(0xb8165f79, 0x2564d95a),
+     TOBN(0x235665e2, 0xa8f207cb), TOBN(0xdef16762, 0x1087fea6),
+     TOBN(0xf4275ea2, 0x7b9d891a), TOBN(0x70b2662a, 0x1f98a6d9),
+     TOBN(0x2990c521, 0x5fd15926), TOBN(0x2734975d, 0xc30089d5),
+     TOBN(0x7a9a9dd7, 0xb6b11af8), TOBN(0xac4c50dd, 0x16a42f8f),
+     TOBN(0x1550267b, 0x6726c324), TOBN(0x12cfb2fd, 0x7f841afb),
+     TOBN(0xa41b1905, 0x2f046430), TOBN(0x8f5f5373, 0xb7d786cb),
+     TOBN(0x7b61b39c, 0x729e09fb), TOBN(0x07a5415f, 0x2626da4c),
+     TOBN(0x65d6efb8, 0x4a348905), TOBN(0xf377862c, 0xf2e864b9),
+     TOBN(0x3c94000d, 0xab96cdb2), TOBN(0x2176321a, 0x8efef0f6),
+     TOBN(0xfbd2489f, 0xaffedcf4), TOBN(0xe41dfcac, 0x41feb03e),
+     TOBN(0xf13f6579, 0xe9a86cd1), TOBN(0xfe3c2a91, 0xb7ff732f),
+     TOBN(0xd447c728, 0x82f008fc), TOBN(0xe4e9c054, 0x0e1924b1),
+     TOBN(0xe0d6bfc3, 0x048bb350), TOBN(0x5fe1c204, 0x2fb5fc5b),
+     TOBN(0x70799d49, 0xaa50972b), TOBN(0x7c79c24e, 0xd2c42b50),
+     TOBN(0x4ffa2c53, 0x5405cd06), TOBN(0xd890bea7, 0xc7ba6f8b),
+     TOBN(0xee68456d, 0x94747d5c), TOBN(0x5c0312fe, 0xef40112f),
+     TOBN(0x57a480bc, 0x0fcb2565), TOBN(0x549b31ad, 0x7c529c68),
+     TOBN(0xcfdc5d33, 0x402bdb03), TOBN(0x955bfd5d, 0xbf45407e),
+     TOBN(0x8381a1ec, 0x1fdb20fd), TOBN(0x89dafbdc, 0x4fe0b38e),
+     TOBN(0xf33c8706, 0x68f59249), TOBN(0xb6cc7618, 0x68be67d2),
+     TOBN(0xa7897c7c, 0xea4845b8), TOBN(0x6773f08b, 0x93f2f9a9),
+     TOBN(0x642405c1, 0x14a03fc5), TOBN(0x5b973584, 0x4cf34763),
+     TOBN(0x9f24c2cc, 0x3331c03d), TOBN(0x56428a37, 0x6f9bf4f5),
+     TOBN(0x2e83d070, 0x703e5e73), TOBN(0xb8e4e61a, 0x573c3cf4),
+     TOBN(0x7a18ec58, 0x8f3e3efe), TOBN(0xbab02660, 0xb812e5a7),
+     TOBN(0xee826e36, 0x8289de63), TOBN(0x86d263f9, 0xc1a8eb16),
+     TOBN(0xee8f3e72, 0xd7b85103), TOBN(0xa3627d9b, 0xe567c787),
+     TOBN(0x8c558000, 0xc1c1bc68), TOBN(0x9e48a67a, 0x83fd6ca6),
+     TOBN(0xacf0d75c, 0xeb7a35cb), TOBN(0x0fbdce4c, 0xf0a93110),
+     TOBN(0x82b2d13a, 0x9cc50c85), TOBN(0x696fd259, 0xcef70d6f),
+     TOBN(0x1cc9be2e, 0x457b88c2), TOBN(0x0d58b34b, 0x1f04c0bc),
+     TOBN(0x52bd479f, 0x195a532b), TOBN(0x769fe6ca, 0x1ab3605c),
+     TOBN(0xba6a63e4, 0x8a24c1e0), TOBN(0x86dea462, 0x99da5d7a)},
+    {TOBN(0x509abccb, 0x65682820), TOBN(0xfbfa1d09, 0x4ff86137),
+     TOBN(0x1ae371bd, 0x640bc2f6), TOBN(0xa155c297, 0x8f546c68),
+     TOBN(0x8858cadc, 0xc08b8cbf), TOBN(0xafac5b0a, 0x1d96948b),
+     TOBN(0x919cb226, 0x82e25016), TOBN(0xd147df4a, 0xb064ffc3),
+     TOBN(0x25dd0f1a, 0xb4abe560), TOBN(0xc6bbe636, 0x9cb75bd1),
+     TOBN(0xbb367cf9, 0x47a778e4), TOBN(0x5714aa4d, 0xbde524b3),
+     TOBN(0xc6307399, 0x166915df), TOBN(0xb35545bc, 0x5da8a26e),
+     TOBN(0x8e0126aa, 0xe3a99321), TOBN(0x0fbfdf76, 0xda9308d1),
+     TOBN(0x2163ed6b, 0x6168e505), TOBN(0x71f3d008, 0x7500d8bd),
+     TOBN(0xf5715960, 0x5ac13f65), TOBN(0xc1cd9a67, 0x55172d5b),
+     TOBN(0x6b225f7e, 0x53d84c65), TOBN(0x9c031269, 0x025029da),
+     TOBN(0x54c1edfa, 0x17d89aed), TOBN(0x5b023878, 0x6b435150),
+     TOBN(0x1e7ae160, 0x1e94d949), TOBN(0x177dc53e, 0xe78e6221),
+     TOBN(0x8af29d8f, 0x7aeb9882), TOBN(0x2d9a60fd, 0x9e3f3906),
+     TOBN(0x6979fcd6, 0xdf962156), TOBN(0xdd2fe588, 0x7e1e54b8),
+     TOBN(0x9cccf310, 0x76643453), TOBN(0x94ece1a8, 0x4e0643d0),
+     TOBN(0x745449cb, 0xc111d8cf), TOBN(0x872afa4a, 0xe6cfbd97),
+     TOBN(0x5c27b7ca, 0x10dfb34e), TOBN(0x505e62bc, 0x533480fe),
+     TOBN(0x009ef80a, 0xae238fa1), TOBN(0xb41d9b24, 0x486af6b5),
+     TOBN(0xab4455ed, 0x685add95), TOBN(0x18f323f6, 0x72c7dac8),
+     TOBN(0xe7009790, 0xe372f168), TOBN(0x4d5bcba6, 0x067bea99),
+     TOBN(0xf15bdbcc, 0x51a2a9a9), TOBN(0xde7e4f74, 0x2fac9169),
+     TOBN(0x2fd62c30, 0x4bdbec36), TOBN(0x8b3ea93d, 0x1b3ac6c7),
+     TOBN(0xce1c8e5c, 0x9c293889), TOBN(0x19664dda, 0x11564f8b),
+     TOBN(0x5f266f13, 0x175418b2), TOBN(0x6bd7a869, 0x03a626f9),
+     TOBN(0xc7b53230, 0x4a6f11ca), TOBN(0xa216b056, 0xbfc8cced),
+     TOBN(0xa274d5d8, 0xb288cb7c), TOBN(0x6fc4a35d, 0x924897ad),
+     TOBN(0x1ea532eb, 0x81fc6940), TOBN(0x2fcd817e, 0x2acbbc45),
+     TOBN(0x45eee93f, 0x67814fa3), TOBN(0x3b3da48c, 0x1229e035),
+     TOBN(0xd049a976, 0xefd8e3d7), TOBN(0x8087dff7, 0xbf81f314),
+     TOBN(0x77faac22, 0xbd366155), TOBN(0x13cc4038, 0x282f11b5),
+     TOBN(0x31ad1dd4, 0x5fbd35ab), TOBN(0x7e0de9da, 0x45d6d40e),
+     TOBN(0xa16c5f19, 0x39749ef6), TOBN(0x761cd6cf, 0x85691cf2),
+     TOBN(0x156536ad, 0x4d59b802), TOBN(0xee98dc41, 0x87c4b11d),
+     TOBN(0x165a1eac, 0xd35088fc), TOBN(0xce8a7335, 0x38fb995c),
+     TOBN(0x34d0d331, 0x3293b3a5), TOBN(0xfcf548ca, 0x8b570e79),
+     TOBN(0x7be5946e, 0xa85af34a), TOBN(0x420593c9, 0xda6fb0e0),
+     TOBN(0x40b83c00, 0x987f9246), TOBN(0xac35f4e9, 0xa15d192b),
+     TOBN(0x1979bd33, 0x776a678c), TOBN(0x0a7d973e, 0x8f6068d3),
+     TOBN(0x71d322e8, 0x7e6298fe), TOBN(0xbb23a299, 0x36af9b65),
+     TOBN(0x14e2b970, 0x6644c50c), TOBN(0x5f7f2073, 0x73570bd3),
+     TOBN(0x40215c56, 0x9055538b), TOBN(0x91372e64, 0x365500c9),
+     TOBN(0x6a3a2327, 0x9af0a75c), TOBN(0xf832a815, 0x9f1f250d),
+     TOBN(0x17030c33, 0x22a82d3f), TOBN(0x24bf18ea, 0x14cbc835),
+     TOBN(0x319dc4ca, 0xb2da2727), TOBN(0x481df360, 0x6d020d4a),
+     TOBN(0xaeebdd8a, 0x7fc22ba5), TOBN(0xbd0515c6, 0xa91e28ab),
+     TOBN(0xfc8a2978, 0x595f361d), TOBN(0xe60dd96c, 0x1ae8fa3c),
+     TOBN(0x19c2109a, 0xa5341575), TOBN(0xfd6e92bb, 0x06a0ee48),
+     TOBN(0x650008f9, 0x77b5c7c5), TOBN(0x4bcf6002, 0x02a6d087),
+     TOBN(0x391ebfa3, 0x82234273), TOBN(0x9dcb05d3, 0x86cd884e),
+     TOBN(0x1b5e7afa, 0x8753b3fa), TOBN(0xd453e9b4, 0x2d1e513c),
+     TOBN(0x3b1a0dea, 0x4b3a74b4), TOBN(0xf8989aac, 0x5bebd592),
+     TOBN(0xac3ec9f5, 0x61dc640b), TOBN(0x4ba9dd0a, 0x6c4b301b),
+     TOBN(0xf686a5fe, 0x04e48df6), TOBN(0x8b0d2d76, 0x0631d1e6),
+     TOBN(0x443deaab, 0x03c87a20), TOBN(0x57dbd224, 0xbb817740),
+     TOBN(0xf88918de, 0xd51d6acd), TOBN(0x48c9b2f1, 0x7d4ec9be),
+     TOBN(0x78b41104, 0xdfc48a69), TOBN(0x44a81443, 0x78827f54),
+     TOBN(0x74ed7949, 0x16a22495), TOBN(0x6b9e9128, 0xea92d3e6),
+     TOBN(0x6fe6449b, 0x0d9fe252), TOBN(0x31743d06, 0xc14e825a),
+     TOBN(0xd9d4ad8c, 0x08690f00), TOBN(0x562e2f60, 0x0e65f748),
+     TOBN(0xe9e01117, 0xb1befb0a), TOBN(0x7ce74721, 0xd25cb1ae),
+     TOBN(0x946216c6, 0x2d4437ad), TOBN(0x83b03131, 0xea8b2d85),
+     TOBN(0x3614b15d, 0x2c4fa895), TOBN(0x393317d9, 0xc23c6bf7),
+     TOBN(0xda73495a, 0xdcd80eb4), TOBN(0x850dfb46, 0x6338db53),
+     TOBN(0x3329c498, 0xc9b8943a), TOBN(0x1ee615b5, 0x0765d94a),
+     TOBN(0x2d16a6cf, 0xd67c17b3), TOBN(0x050d6bfe, 0x6f8a9ed5),
+     TOBN(0x92501ff8, 0x8b7f8cb2), TOBN(0xcdaa6c93, 0x578a4cfd),
+     TOBN(0x95b99a05, 0xe5303846), TOBN(0x30a72fdc, 0x2543d1a9),
+     TOBN(0x6648126b, 0x11808771), TOBN(0x6980dd99, 0xeefb8145),
+     TOBN(0xd9a87f83, 0xf1949aad), TOBN(0x3b4f208d, 0xf7b8ab95),
+     TOBN(0x3341e118, 0xc40122e4), TOBN(0xe513567f, 0x853b291e),
+     TOBN(0xd4f1bbb7, 0x3b565bad), TOBN(0x86207b43, 0xa7658f77),
+     TOBN(0xe5737dce, 0xf87cd72c), TOBN(0xdf41230a, 0x7a1c9f7f),
+     TOBN(0x7fe5cfcf, 0x34e0d519), TOBN(0x83cc1da5, 0x26033c9d),
+     TOBN(0x4195ef1a, 0xe16dffd0), TOBN(0x7c388f6e, 0x8af91671),
+     TOBN(0xeb1002b8, 0x62283e40), TOBN(0x08122e57, 0xa96be04c),
+     TOBN(0x48cb2d0c, 0xdf9fac7c), TOBN(0xa3c007ae, 0x41f0946d),
+     TOBN(0x4d6fa5c5, 0xcec27088), TOBN(0xe1fbc03e, 0xdcd5fcfa),
+     TOBN(0xbab37a63, 0x9bece059), TOBN(0x5a60ec87, 0x7fa28fc3),
+     TOBN(0x69e1086c, 0x1d4a8f5b), TOBN(0x3a873844, 0x65814282),
+     TOBN(0xb642dc16, 0x2676cc7d), TOBN(0x8d152bb9, 0x97e423a0),
+     TOBN(0x66ac1b37, 0x160ff40b), TOBN(0x7410ba67, 0xf657547a),
+     TOBN(0x8f47debb, 0xadcc6823), TOBN(0x44e9bf64, 0xb1536fa1),
+     TOBN(0x1cfdd504, 0x939e5461), TOBN(0xba5729e1, 0x43bb3b90),
+     TOBN(0xb5c26108, 0xdd63f6d4), TOBN(0xefb8dfc7, 0x60229177),
+     TOBN(0x9d980889, 0x23e4cc7d), TOBN(0x59579ee8, 0xc211c92b),
+     TOBN(0x6f146300, 0x35fe17b4), TOBN(0x6c1e7075, 0x0ca61e4a),
+     TOBN(0x8671156d, 0x19d582e1), TOBN(0x36a3d858, 0x07230605),
+     TOBN(0xd9314e61, 0xa352dcdc), TOBN(0x7a9d0de7, 0x4c6bc2b1),
+     TOBN(0xb57d3f71, 0xc894ab77), TOBN(0xb3564bc7, 0xd4e5a04e),
+     TOBN(0x2e32f896, 0xcde5e785), TOBN(0xcd55ae7a, 0xb9db8f31),
+     TOBN(0x278db1ad, 0x8f832885), TOBN(0x271d9078, 0xadcbd933),
+     TOBN(0x2208fae3, 0x4a64f863), TOBN(0x974046e0, 0x39c89365),
+     TOBN(0xcb46f272, 0xb3cd0cd3), TOBN(0x31f34e1a, 0x74e59edc),
+     TOBN(0x3421d316, 0xedd50418), TOBN(0xb1d8a064, 0xcabe36ed),
+     TOBN(0xdb13e560, 0x362efcda), TOBN(0x567c2b6c, 0xc71eb3ee)},
+    {TOBN(0x2af8ed81, 0x70d4d7bc), TOBN(0xabc3e15f, 0xb632435c),
+     TOBN(0x4c0e726f, 0x78219356), TOBN(0x8c1962a1, 0xb87254c4),
+     TOBN(0x30796a71, 0xc9e7691a), TOBN(0xd453ef19, 0xa75a12ee),
+     TOBN(0x535f42c2, 0x13ae4964), TOBN(0x86831c3c, 0x0da9586a),
+     TOBN(0xb7f1ef35, 0xe39a7a58), TOBN(0xa2789ae2, 0xd459b91a),
+     TOBN(0xeadbca7f, 0x02fd429d), TOBN(0x94f215d4, 0x65290f57),
+     TOBN(0xc0855002, 0x4b950889), TOBN(0xee99dbfe, 0x8ce24da0),
+     TOBN(0xdda71d96, 0x4318e860), TOBN(0x01d3d396, 0x04fe9b85),
+     TOBN(0xda4bc065, 0xe25e7e20), TOBN(0xd3a50b87, 0xe076c81c),
+     TOBN(0x5b9f8219, 0x31e5f494), TOBN(0x6a140527, 0xa6a1b821),
+     TOBN(0xf52683e4, 0xd8dd159b), TOBN(0xca9c8887, 0x20b18043),
+     TOBN(0x73c040fa, 0x08a0d8f5), TOBN(0x92e482e8, 0x179525c4),
+     TOBN(0x37ed2be5, 0x1cfb79ac), TOBN(0x801946f3, 0xe7af84c3),
+     TOBN(0xb061ad8a, 0xe77c2f00), TOBN(0xe87e1a9a, 0x44de16a8),
+     TOBN(0xdf4f57c8, 0x7ee490ff), TOBN(0x4e793b49, 0x005993ed),
+     TOBN(0xe1036387, 0xbccb593f), TOBN(0xf1749411, 0x95e09b80),
+     TOBN(0x59cb20d1, 0x5ab42f91), TOBN(0xa738a18d, 0xac0ff033),
+     TOBN(0xda501a2e, 0x2ac1e7f4), TOBN(0x1b67eda0, 0x84d8a6e0),
+     TOBN(0x3a828904, 0xa4d2313e), TOBN(0xbf4946b1, 0x92e66888),
+     TOBN(0xc574898a, 0xe5fa19d2), TOBN(0x0b13dbb6, 0x5e1c5fa4),
+     TOBN(0xf11343ba, 0x7c390fc2), TOBN(0x35b1418f, 0xd7d32187),
+     TOBN(0xc92cb1bb, 0x83e7fe7b), TOBN(0x0b969455, 0xd78365c4),
+     TOBN(0xda69dfe5, 0x672f2af7), TOBN(0x9c62d7b4, 0x30932441),
+     TOBN(0x165672ad, 0x94af02d6), TOBN(0xd2cc734d, 0xcde81c22),
+     TOBN(0x1d27efce, 0x1080e90b), TOBN(0xa2815246, 0x3fd01dc6),
+     TOBN(0x99a3fb83, 0xcaa26d18), TOBN(0xd27e6133, 0xb82babbe),
+     TOBN(0x61030dfd, 0xd783dd60), TOBN(0x295a2913, 0x73c78cb8),
+     TOBN(0x8707a2cf, 0x68be6a92), TOBN(0xc9c2fb98, 0xeeb3474a),
+     TOBN(0x7c3fd412, 0xa2b176b8), TOBN(0xd5b52e2f, 0xc7202101),
+     TOBN(0x24a63030, 0xf0a6d536), TOBN(0x05842de3, 0x04648ec0),
+     TOBN(0xd45e3501, 0x33f4d416), TOBN(0xbb40233a, 0x4bf9131e),
+     TOBN(0x1532a088, 0xe302483a), TOBN(0x3475e8b8, 0x2c2485c0),
+     TOBN(0x08f9ea56, 0x969cdbe6), TOBN(0x31928645, 0x253cd738),
+     TOBN(0x1cf323a4, 0xac9836be), TOBN(0xdf647ccf, 0x02b6e4de),
+     TOBN(0x9a31e84f, 0xc06f3d09), TOBN(0xd326b86e, 0x39efe6d9),
+     TOBN(0x77e3e1df, 0x14ac4dec), TOBN(0xf2d5917a, 0xf3e0c582),
+     TOBN(0x67477cdc, 0x30577ac9), TOBN(0x51dd9775, 0x244f92a8),
+     TOBN(0x31fd60b9, 0x917eec66), TOBN(0xacd95bd4, 0xd66c5c1d),
+     TOBN(0x2e0551f3, 0xbf9508ba), TOBN(0x121168e1, 0x688cb243),
+     TOBN(0x8c039740, 0x4540d230), TOBN(0xc4ed3cf6, 0x009ecdf9),
+     TOBN(0x191825e1, 0x44db62af), TOBN(0x3ee8acab, 0xc4a030da),
+     TOBN(0x8ab154a8, 0x94081504), TOBN(0x1fe09e4b, 0x486c9cd0),
+     TOBN(0xe92b56c0, 0x02cf37fd), TOBN(0xa75bbcb0, 0xf71b34de),
+     TOBN(0x7754d0ef, 0x50f5c482), TOBN(0x850a9ef6, 0x11fa89fe),
+     TOBN(0x97d74b1b, 0xba4ea7d8), TOBN(0xfc757c25, 0xaab7ba2e),
+     TOBN(0x06f30ab0, 0xf2a67fdd), TOBN(0xb10aba14, 0x12e72af8),
+     TOBN(0x47580bca, 0x7a2e053d), TOBN(0x85795598, 0xdcf0e14c),
+     TOBN(0xc3596781, 0xd6f55310), TOBN(0x8ab251b7, 0x4c9b7e18),
+     TOBN(0x512f82f9, 0xd113450b), TOBN(0x5878c901, 0x2dbc9197),
+     TOBN(0xdb87412b, 0xe13f355b), TOBN(0x0a0a4a9b, 0x935b8a5e),
+     TOBN(0x818587bd, 0xf25a5351), TOBN(0xe8079310, 0x31e3d9c7),
+     TOBN(0x8b1d47c7, 0x611bc1b1), TOBN(0x51722b58, 0x72a823f2),
+     TOBN(0x6f97ee8a, 0x53b36b3e), TOBN(0x6e085aac, 0x946dd453),
+     TOBN(0x2ec5057d, 0xe65e6533), TOBN(0xf82d9d71, 0x4bb18801),
+     TOBN(0x4ab13850, 0x4dbb8798), TOBN(0x0e7980d7, 0x72d04cd2),
+     TOBN(0x1755c566, 0x0b3271c6), TOBN(0x8414efb0, 0x9d9d1468),
+     TOBN(0x61a58630, 0x1795ce66), TOBN(0xb6a8b393, 0x232924a1),
+     TOBN(0xa992f0ce, 0xae031bd6), TOBN(0x6747fb5f, 0x2915acc1),
+     TOBN(0x03daa266, 0x93e9c0d2), TOBN(0xc18fa364, 0x5400d554),
+     TOBN(0xaf04ff8d, 0x9497e895), TOBN(0x86c3cfc2, 0x50b6b339),
+     TOBN(0xad81fa93, 0x8ba5aa8e), TOBN(0x723e628e, 0x8f7aa69e),
+     TOBN(0x0ba7c2de, 0xef35937c), TOBN(0x83a43ec5, 0x6decfb40),
+     TOBN(0xf520f849, 0xe60c4f2d), TOBN(0x8260e8ae, 0x457e3b5e),
+     TOBN(0x7ce874f0, 0xbf1d9ed7), TOBN(0x5fde3553, 0x7f1a5466),
+     TOBN(0x5a63777c, 0x0c162dbb), TOBN(0x0fd04f8c, 0xdad87289),
+     TOBN(0xca2d9e0e, 0x640761d5), TOBN(0x4615cff8, 0x38501adb),
+     TOBN(0x376b2a7f, 0x04e1e6e3), TOBN(0xea0dcb70, 0xa31774b4),
+     TOBN(0xfc7fe4cc, 0x5cbdec2e), TOBN(0x8568499d, 0xf03f459e),
+     TOBN(0xe9fd8fb2, 0x8b78900e), TOBN(0xd33c6e30, 0xe431bf97),
+     TOBN(0xd904b8f5, 0xc896e766), TOBN(0xa8f577cf, 0x82748cef),
+     TOBN(0x93dd921b, 0x87e044b3), TOBN(0x23d79837, 0xf76eebe9),
+     TOBN(0x5e0a7493, 0xe569feeb), TOBN(0xd0797549, 0x414dddb6),
+     TOBN(0x9422789b, 0x110b4a25), TOBN(0x5c26779f, 0x70ad8cc1),
+     TOBN(0x4ee6a748, 0xec4f1e14), TOBN(0xfb584a0d, 0x5c7ab5e0),
+     TOBN(0xed1dcb0b, 0xfb21ee66), TOBN(0xdbed1f00, 0x11c6863c),
+     TOBN(0xd2969269, 0xb1b1d187), TOBN(0xf7d0c3f2, 0xafe964e6),
+     TOBN(0xe05ee93f, 0x12bb865e), TOBN(0x1afb7bee, 0xed79118e),
+     TOBN(0x220af138, 0x0f0fe453), TOBN(0x1463aa1a, 0x52782ab9),
+     TOBN(0xfd9e3542, 0xbfe5b1a7), TOBN(0xb42d2a41, 0x75938cea),
+     TOBN(0x74688a15, 0x3befb760), TOBN(0x8daeeaa2, 0x2e33dbe7),
+     TOBN(0xc9c1ea08, 0x3e677801), TOBN(0x68ecf4e4, 0x34effe1e),
+     TOBN(0x927700cc, 0xd294c321), TOBN(0x9e2e723d, 0xe940afc5),
+     TOBN(0xbcfac07a, 0x7cf6cd43), TOBN(0xa009ef94, 0xd1006bc3),
+     TOBN(0xa02016b0, 0x373d13e3), TOBN(0x4e097adb, 0xabae5822),
+     TOBN(0x7c139d56, 0xd7dbe5f9), TOBN(0xfc16e611, 0x0b83685b),
+     TOBN(0xfa723c02, 0x9018463c), TOBN(0xc472458c, 0x840bf5d7),
+     TOBN(0x4d809359, 0x0af07591), TOBN(0x418d8830, 0x3308dfd9),
+     TOBN(0x9b381e04, 0x0c365ae3), TOBN(0x3780bf33, 0xf8190fd1),
+     TOBN(0x45397418, 0xdd03e854), TOBN(0xa95d030f, 0x4e51e491),
+     TOBN(0x87c8c686, 0xe3286cea), TOBN(0x01c773bf, 0x900b5f83),
+     TOBN(0x8db8b78c, 0xc898b8bc), TOBN(0x686896da, 0x502940cd),
+     TOBN(0x67e50f02, 0x2dde2e3c), TOBN(0x2e2461f3, 0x8cbf406c),
+     TOBN(0x32182781, 0xe1f7ff60), TOBN(0x26934b05, 0xe30e2688),
+     TOBN(0x95adc204, 0xfc4494f6), TOBN(0x4c7f30c5, 0x161b7499),
+     TOBN(0xd5caf060, 0xb7341737), TOBN(0xed93187f, 0xd128d46c),
+     TOBN(0x3f2819cb, 0x20fc1e04), TOBN(0x48c4086f, 0x2b7f70a1)},
+    {TOBN(0xd74d09c1, 0x0ece13ae), TOBN(0x5e59d9e0, 0x57a6bd95),
+     TOBN(0xdb1ccfdc, 0xe132b940), TOBN(0xa0e5309c, 0x843d3c66),
+     TOBN(0x1fbd03a5, 0xf9cb3ef4), TOBN(0xcdc9ef0a, 0x00ea5177),
+     TOBN(0x1ebf5a15, 0xcb784a6b), TOBN(0xa67382af, 0x8a0d109a),
+     TOBN(0x3256c37a, 0xa0d34d15), TOBN(0xee40efa5, 0x0fca43af),
+     TOBN(0xc299bbd4, 0xb9841bde), TOBN(0x6df68f60, 0x3bef4a0b),
+     TOBN(0xe01295fd, 0xd9d7c50a), TOBN(0xaf31b4ea, 0x67f8ef0d),
+     TOBN(0x2ec9689f, 0x9eaf8eb7), TOBN(0x327b96c5, 0xc622acc5),
+     TOBN(0xae918f81, 0xb2757f2a), TOBN(0x74927d68, 0x4fd6606e),
+     TOBN(0x09bb7fce, 0x18574215), TOBN(0xfea383bc, 0xe8e68b72),
+     TOBN(0xdf2a6f12, 0x5fb47511), TOBN(0xbe88faa1, 0x8e399520),
+     TOBN(0x0166d57e, 0x3fb1c3a2), TOBN(0x5907ef2f, 0xe525f81f),
+     TOBN(0xf24fab9b, 0x57797e5c), TOBN(0xd8500987, 0x3add682c),
+     TOBN(0x75e370e7, 0x33ac4fb5), TOBN(0xd8d61642, 0xc8a69765),
+     TOBN(0xf057f10a, 0x5e30aa0e), TOBN(0xaf953087, 0x4f1e8637),
+     TOBN(0x887f06b3, 0x701cd1a0), TOBN(0xd7c6a9c6, 0x8a200082),
+     TOBN(0x4319f7eb, 0x6e6483a0), TOBN(0x44f1aaff, 0x475d4bfd),
+     TOBN(0xa8ee73b5, 0x0f811fc7), TOBN(0xbb67bcdc, 0x82916f8b),
+     TOBN(0xdefe3a7b, 0x8a37f660), TOBN(0x7898db8c, 0x858f5765),
+     TOBN(0x7366c26a, 0x73d1f9b4), TOBN(0x35d5d718, 0x237ae8b7),
+     TOBN(0x3efb20fe, 0xb4478259), TOBN(0xccd0fed7, 0xaa545ee3),
+     TOBN(0x750edd05, 0xed22d152), TOBN(0x4f8020f9, 0xee20d4c6),
+     TOBN(0x16e60f37, 0x0a9e29dc), TOBN(0x9cf0a136, 0xbfbec7f6),
+     TOBN(0xb430a34b, 0x2e47e143), TOBN(0x2e2560bb, 0xc6cdd1a9),
+     TOBN(0x2cb5625c, 0x2a9af85a), TOBN(0x9ba19601, 0xfea96b60),
+     TOBN(0x25dd6aca, 0xd7549809), TOBN(0x9c02e613, 0x5b4c31e9),
+     TOBN(0x40c4baea, 0xe09dbb63), TOBN(0x38455db7, 0xf49beece),
+     TOBN(0xe9846d0d, 0x5b848716), TOBN(0x9c63043d, 0xd2ebce35),
+     TOBN(0xedee8e86, 0xbc26a79e), TOBN(0x70c46f94, 0x0869c85f),
+     TOBN(0x34b05934, 0x7bc49e34), TOBN(0x737fe693, 0xa80d7d8e),
+     TOBN(0x799352da, 0xe4161a65), TOBN(0xe5cf7ad8, 0x56253ce6),
+     TOBN(0xf606bf79, 0x6de32775), TOBN(0xddc0f3a3, 0x57fce8db),
+     TOBN(0x1075fc23, 0x16cf4a47), TOBN(0x078f0e04, 0xb27c5ad8),
+     TOBN(0x9fc47795, 0x3f7100aa), TOBN(0x3ac48925, 0x4673ffa2),
+     TOBN(0xb8263f42, 0xf9cd8348), TOBN(0x5bdfde30, 0x68cc92d5),
+     TOBN(0x2250927b, 0x1ac37f9c), TOBN(0x26ec8328, 0xb33da359),
+     TOBN(0x76923635, 0x236eaa28), TOBN(0x5acc650b, 0x657d0640),
+     TOBN(0x2652ec7e, 0xc20a58ab), TOBN(0x93385f9f, 0x1a5459f9),
+     TOBN(0x45952d39, 0x306e2091), TOBN(0xb31f5a42, 0x34cef2f2),
+     TOBN(0x0d9b0484, 0x1f3c055f), TOBN(0x6c5ef8ee, 0xae3b1f4d),
+     TOBN(0xd3fdb464, 0xbd24becd), TOBN(0x49b11a10, 0xa2210148),
+     TOBN(0x73de2855, 0x1472893a), TOBN(0x99435b57, 0x6ee531f7),
+     TOBN(0xf186d6bc, 0xc88d568a), TOBN(0x872bc4c7, 0x528535dd),
+     TOBN(0xc9e7432e, 0xdfe64dc3), TOBN(0xd9fc4832, 0xd795ea57),
+     TOBN(0xf4ffdb81, 0xc845af2b), TOBN(0x66d7e788, 0x2b670517),
+     TOBN(0xa7c1be04, 0xd7b7a1c6), TOBN(0xbed88479, 0xd5b2a249),
+     TOBN(0x62ff8aba, 0x03f2ef6d), TOBN(0x60ecaac4, 0x20dc701d),
+     TOBN(0x9f4b559f, 0x4ff10119), TOBN(0x0582c931, 0x3cd54fd0),
+     TOBN(0x271f5d70, 0x3940d5dd), TOBN(0x7707d109, 0x192fb2b6),
+     TOBN(0xc6131828, 0xda210560), TOBN(0x21750048, 0x0bc534c0),
+     TOBN(0xa96593d1, 0x23487a61), TOBN(0xdab1698b, 0x0b9c6e92),
+     TOBN(0x8a7951a5, 0x1f7abe02), TOBN(0xa9394a4b, 0xecd49e72),
+     TOBN(0x95ba141d, 0x2f6f53d5), TOBN(0x03809379, 0x6cdb90cc),
+     TOBN(0xa5e0ebf3, 0x0586a3ef), TOBN(0x75f006dd, 0x70606681),
+     TOBN(0xea9da8f0, 0x12bbaeb6), TOBN(0x3fba06b1, 0x8c9f8360),
+     TOBN(0xc11bd7ab, 0xb28c0ac3), TOBN(0x1e05af2f, 0xaa8a01bd),
+     TOBN(0xae1e99c5, 0xf000b1c3), TOBN(0x93ee8064, 0x53d79930),
+     TOBN(0x5728089e, 0x4c4f5513), TOBN(0x755351f3, 0xb1f70b76),
+     TOBN(0x187ac651, 0x675f77ef), TOBN(0x5cf7bfb5, 0x53067d84),
+     TOBN(0x62929083, 0x8174b5c0), TOBN(0x720e2079, 0x8d5be74d),
+     TOBN(0xcdb0e974, 0x15c26385), TOBN(0x7110dd68, 0x40c9a381),
+     TOBN(0x1fd85657, 0x8180d82b), TOBN(0xa42cad51, 0xb97cf516),
+     TOBN(0xd0e97506, 0xc8e096e2), TOBN(0x9372ac5c, 0xac077c1c),
+     TOBN(0x080cac77, 0x528c6d23), TOBN(0xa62b7b39, 0xc192bee8),
+     TOBN(0xf1b2be68, 0x596c03b4), TOBN(0x9e367c67, 0x65cdde1a),
+     TOBN(0xdb0a51db, 0xa97f58bb), TOBN(0xa9b52c4d, 0xc29dbc0d),
+     TOBN(0xab8cc09f, 0xf5eb9ad1), TOBN(0x97a4de76, 0x132edbfe),
+     TOBN(0xa2e11c54, 0x8baf6347), TOBN(0xcee54229, 0x683cfcf6),
+     TOBN(0xe1e993b8, 0xdcfc6555), TOBN(0x333bf16a, 0xbe9df066),
+     TOBN(0x5207e093, 0x060d62df), TOBN(0xfa32324d, 0x69b0f5fa),
+     TOBN(0xef16fbcf, 0xd3243d2d), TOBN(0x540a2e59, 0xf04f8e45),
+     TOBN(0xb5e70f9c, 0x48317bba), TOBN(0x00dbe9b2, 0x5b35baa1),
+     TOBN(0xa7c2e951, 0x04a6bdf1), TOBN(0xe7b50010, 0x45310414),
+     TOBN(0x0ad7ac85, 0x250deed3), TOBN(0xeb7ad465, 0x07fd3b65),
+     TOBN(0xcac35e8c, 0x6bdc321a), TOBN(0xf773a3e9, 0xe992ce8e),
+     TOBN(0x99cbc651, 0x0f682437), TOBN(0x62f7b15d, 0x7ff5f4b3),
+     TOBN(0xf3c08dfd, 0x6d131441), TOBN(0x8b998754, 0xfbb0fd4b),
+     TOBN(0x88dae889, 0xe061d5b7), TOBN(0x9f6e8dca, 0x2a346488),
+     TOBN(0x0eaed675, 0xebb512ee), TOBN(0x347e0756, 0x058efbd5),
+     TOBN(0xadf792ca, 0x296d3d47), TOBN(0x57f00c0a, 0x4654d012),
+     TOBN(0xa1e08a04, 0xbccc5803), TOBN(0x610677f0, 0x5b2f11d1),
+     TOBN(0x0d9393d7, 0xb81acfd2), TOBN(0xb258e157, 0x0587c219),
+     TOBN(0x372a1857, 0xb4ceba47), TOBN(0xe1ce8bb5, 0x3ecc1c5d),
+     TOBN(0x7efdf301, 0x922cecd0), TOBN(0xcab8cb17, 0x0d8aa653),
+     TOBN(0xc60f118a, 0xd85124dd), TOBN(0x4a045272, 0xa77febb9),
+     TOBN(0xbae0edf5, 0x45555221), TOBN(0x1fb21695, 0xab65b900),
+     TOBN(0x9179d546, 0xd56b9882), TOBN(0xead5f78e, 0x006bc680),
+     TOBN(0x6c3ef1c1, 0xed9d8095), TOBN(0xe22832c1, 0xd024f8cd),
+     TOBN(0x8c783b9d, 0x157c5363), TOBN(0x25c1bd7e, 0x000d3603),
+     TOBN(0x4e76a723, 0xe8ff7a81), TOBN(0xa55cfcb4, 0x4a955196),
+     TOBN(0x31954a56, 0x79d05497), TOBN(0xc12520b6, 0xfe76d4d8),
+     TOBN(0x8c433ec5, 0xe37ef1d2), TOBN(0xcd0f2035, 0x75bc3b66),
+     TOBN(0x3723f145, 0x249cd98b), TOBN(0x1356e0d2, 0xea3b42a3),
+     TOBN(0xf607fee0, 0xf174c7b5), TOBN(0x318afc5e, 0x0127be39),
+     TOBN(0xd47b5d74, 0xcea5417f), TOBN(0x6891940a, 0x10fca22b),
+     TOBN(0x5cea4133, 0x2b635e8b), TOBN(0x93db2ed6, 0xb5934fef)},
+    {TOBN(0xb1f4fead, 0x41b959b5), TOBN(0x6edb53a9, 0xe71890c0),
+     TOBN(0x48b47efe, 0x2e28aa2a), TOBN(0x70dad2e9, 0xb3151d67),
+     TOBN(0x87a8178b, 0x436a3460), TOBN(0x0f86f9f5, 0x801f7af7),
+     TOBN(0xfab462e3, 0xa982fc14), TOBN(0xe29126ba, 0xcb03e978),
+     TOBN(0xb4696b3f, 0xe6681282), TOBN(0x3bd9910a, 0x6a3fdc1d),
+     TOBN(0x44091284, 0x49e37dac), TOBN(0x3b4bfabc, 0xcf605fb3),
+     TOBN(0x57edf71e, 0xdf9a9f18), TOBN(0xbf834240, 0x627a0b79),
+     TOBN(0xb37aba1a, 0xa6934160), TOBN(0xd45b3d2c, 0x5e639a54),
+     TOBN(0x62c6b9ad, 0x70bce957), TOBN(0x16bc35a7, 0x5d7e87f3),
+     TOBN(0xb0216982, 0x66b4a982), TOBN(0xb56050dd, 0x0e51c9bc),
+     TOBN(0x15aa692b, 0x478e4b91), TOBN(0xdd67cf29, 0xbe3fe25a),
+     TOBN(0xf1ef75b0, 0x06bdd4a8), TOBN(0xf71a285b, 0x41df627a),
+     TOBN(0x3176a43a, 0xb7a3ce87), TOBN(0x9fa09e97, 0x5f130e73),
+     TOBN(0x971cc37b, 0x9368e156), TOBN(0x2cabf535, 0xb8981792),
+     TOBN(0xaec2862e, 0x4d0f0bc0), TOBN(0xa1a48c18, 0x3ce8c100),
+     TOBN(0x288f4e69, 0x4af2eae9), TOBN(0x778845f2, 0x1f9339bd),
+     TOBN(0x1ef5fdfd, 0x17dfaa6a), TOBN(0xc784117e, 0x3483a6fc),
+     TOBN(0xe8c82f05, 0xf3c5c19e), TOBN(0xf39b3c1d, 0x1da87ab6),
+     TOBN(0xa58a27c5, 0x8a541be6), TOBN(0xaf669499, 0x54fd7683),
+     TOBN(0x24318266, 0x00079a25), TOBN(0x113f6fcf, 0x2606caf5),
+     TOBN(0xf6ff2be3, 0x16cb28c8), TOBN(0x8f7fc60e, 0x3c17caa6),
+     TOBN(0x8ea577e0, 0x7d35e26c), TOBN(0xc3e744c0, 0xf0628903),
+     TOBN(0x4b28eff4, 0x592a57ee), TOBN(0x76e1f87c, 0x5e3f67b2),
+     TOBN(0x40d7a676, 0xfb008902), TOBN(0x68a9dc76, 0x4b6e6b7e),
+     TOBN(0xfc14716f, 0xe4fbe1d8), TOBN(0x711c4f60, 0x88d5fc05),
+     TOBN(0x53df2711, 0x8ab2552f), TOBN(0xeb4a3587, 0xb3039434),
+     TOBN(0x84223085, 0x825eba03), TOBN(0x1aff30b7, 0xf69569cf),
+     TOBN(0x752a2b25, 0x30d38055), TOBN(0x8fb8ef5e, 0x7dc7727e),
+     TOBN(0x8f0b8bea, 0x679f84b9), TOBN(0x076e7b05, 0x004815a9),
+     TOBN(0x93275037, 0x65debb2f), TOBN(0x24f92c79, 0x83a686b0),
+     TOBN(0xf9597802, 0xdff082f7), TOBN(0xb47fcfee, 0xeb44042c),
+     TOBN(0x0e2570c9, 0x8ac1e9a9), TOBN(0x144f5763, 0x9168391b),
+     TOBN(0x7c5fe9e6, 0xfe49b3b2), TOBN(0x30dd5a41, 0xe1202056),
+     TOBN(0xb0866f7c, 0xe5132272), TOBN(0xaa2d7c60, 0x199d029c),
+     TOBN(0xb37c3232, 0x2bd29ff9), TOBN(0x6c0e511b, 0x29bc5c36),
+     TOBN(0xb64e16b6, 0xbaa69a42), TOBN(0x9fd7d79b, 0x28545caf),
+     TOBN(0x0620003c, 0x0c3576d3), TOBN(0xa9608ecd, 0x31b24876),
+     TOBN(0x7dcb576a, 0x2d83f362), TOBN(0x88a3a38a, 0x7df98941),
+     TOBN(0xdd182e8a, 0xb3596afe), TOBN(0x9c740d01, 0xe02a5357),
+     TOBN(0x2fed2fcc, 0xb75d5d3b), TOBN(0xd0ea6d50, 0x8d34ca34),
+     TOBN(0xfe4b8743, 0x8f4bd1dd), TOBN(0x73c5acd3, 0xb130c5c5),
+     TOBN(0x9f8b0817, 0x2dadbb20), TOBN(0x34b74294, 0xc5a59dfc),
+     TOBN(0x76e2751a, 0x12575913), TOBN(0x2c605991, 0x4a5f8c4a),
+     TOBN(0x58322dfb, 0x71fba662), TOBN(0x228aec08, 0x5e0886af),
+     TOBN(0x8d83b627, 0x6aee544c), TOBN(0x338f5fb6, 0xe29f9639),
+     TOBN(0x1ba4cfe0, 0xbf5e19fa), TOBN(0x2eea84c5, 0xb9e4f8f6),
+     TOBN(0x7e0eed58, 0xcee95d92), TOBN(0x2d29282a, 0xbe535540),
+     TOBN(0x866638b6, 0x07a9a1f4), TOBN(0x91599977, 0x6ab8dc82),
+     TOBN(0x6741d444, 0xa2144cce), TOBN(0x06ce4c04, 0x771c7c6c),
+     TOBN(0x3d5bc2d2, 0xae0ff352), TOBN(0xa0ae03ba, 0x0e05ca8a),
+     TOBN(0xbf718851, 0x833183d8), TOBN(0x7095f4d4, 0xccdc956f),
+     TOBN(0x23268e4a, 0xb3ab0c80), TOBN(0x984cf1eb, 0xc16c6dad),
+     TOBN(0xc2333145, 0x67120ec8), TOBN(0xc615f60e, 0x9cd9a03f),
+     TOBN(0xe9e35fd3, 0xb3d16871), TOBN(0xc9b9853d, 0x15e76b83),
+     TOBN(0xd8e314ab, 0xbb7fefd2), TOBN(0x74d946ba, 0xaa61ea98),
+     TOBN(0x10cfd8b5, 0x00fd45fb), TOBN(0x87dfda88, 0x357f8e42),
+     TOBN(0x6dab4a2f, 0x27bf7a3a), TOBN(0x4dd49a15, 0x03b613f5),
+     TOBN(0x1f5491dc, 0x74f2c1a8), TOBN(0x98d17370, 0xcc8ee02e),
+     TOBN(0x01ef39fe, 0x3f141b03), TOBN(0xa5b04673, 0x6984d4c3),
+     TOBN(0x10c40183, 0x4a926cdb), TOBN(0x3e7bbe18, 0xe2af1758),
+     TOBN(0xda178c95, 0xc2faa336), TOBN(0xb4ae744b, 0x68d20d12),
+     TOBN(0x5b75f4e9, 0x5e066620), TOBN(0x4138315f, 0x41e95800),
+     TOBN(0xf5c97da9, 0x010c2c6a), TOBN(0xbc4ff40f, 0xe07bbf8d),
+     TOBN(0xbdd6bc9f, 0x21709050), TOBN(0xf3f4dcf2, 0xc5f7bb78),
+     TOBN(0x584ce030, 0x9b1da924), TOBN(0x44b81c48, 0xec3d9507),
+     TOBN(0x1dfab021, 0x73e1961e), TOBN(0x9212120e, 0xa77458a8),
+     TOBN(0x599ece96, 0xf9612455), TOBN(0xe1c6eb81, 0xc725cba4),
+     TOBN(0x2afc5ba8, 0x6373ccee), TOBN(0xe4556833, 0xc64f7261),
+     TOBN(0xf29ad540, 0x414ce1ab), TOBN(0x7094e067, 0x3ee82a77),
+     TOBN(0xfa26eaa0, 0xdc9716fa), TOBN(0x340da4be, 0x9ceb36af),
+     TOBN(0x9570ade5, 0x4e1c94bd), TOBN(0xf4a86d8e, 0x20b0ddbe),
+     TOBN(0x967ab653, 0xdc6eff6f), TOBN(0x48890be5, 0xe8bab7a4),
+     TOBN(0x74ee2fe8, 0xc96437e8), TOBN(0xeafe095d, 0x0bfd2bb3),
+     TOBN(0xc75f0e53, 0x103d0a33), TOBN(0x22190801, 0x70f13700),
+     TOBN(0x96684d5b, 0x101d133f), TOBN(0x6c98178f, 0xf21b224b),
+     TOBN(0xe3003316, 0x1d59dd67), TOBN(0x933de68f, 0x734e7699),
+     TOBN(0xa3883631, 0xa305ea84), TOBN(0x21afb4d0, 0x6d66c90f),
+     TOBN(0xebeecc72, 0x330568ce), TOBN(0x6b65b757, 0x62b5a3ae),
+     TOBN(0x4069700f, 0xf637841c), TOBN(0x6ee84605, 0xb1c94076),
+     TOBN(0xcd64ecd7, 0x829e1bc4), TOBN(0x606944a8, 0x45cdda86),
+     TOBN(0xb0f2d5fe, 0x58f036ae), TOBN(0x0391590a, 0xec18a23f),
+     TOBN(0xe29e3891, 0x1a82e6c2), TOBN(0x5489a628, 0x6bd4a55b),
+     TOBN(0xf3e7a351, 0x7ae6380c), TOBN(0xb3272f23, 0x6ae0ae07),
+     TOBN(0xb605a039, 0xe66cd800), TOBN(0xd4e522ea, 0x2aac1b66),
+     TOBN(0xbb9d0b1c, 0x8b153f87), TOBN(0xa3d52cbe, 0x518a921d),
+     TOBN(0x232a29d2, 0x2110cd42), TOBN(0x9083e225, 0x8a40d59b),
+     TOBN(0x3b00382e, 0xaa50f55d), TOBN(0x4ad64680, 0xc02cf900),
+     TOBN(0x2f25bd26, 0x36cad5d1), TOBN(0x9c693e85, 0x64eb9c45),
+     TOBN(0xe4ea93e5, 0xccf60708), TOBN(0xb932b958, 0xf9270541),
+     TOBN(0xee93f51f, 0x5eb454ce), TOBN(0x1e82e354, 0x38840e07),
+     TOBN(0xa16c79cf, 0xaf4d260b), TOBN(0xfe853f6c, 0xfab3c3c8),
+     TOBN(0xb8bd6aa0, 0xc2f47e68), TOBN(0x277d590f, 0x2c9b4914),
+     TOBN(0xb6d1c810, 0x097242a8), TOBN(0xcf2f3d8e, 0x45f75512),
+     TOBN(0x2176162b, 0x74a20c3b), TOBN(0xeee8bcb8, 0x2b2bcdda),
+     TOBN(0xfcf8c0d1, 0xa503aee7), TOBN(0x5d1f94a5, 0x7af4dd78),
+     TOBN(0x8f0bc1a6, 0x2ab43be4), TOBN(0xd22dbf16, 0xba9e071b)},
+    {TOBN(0x705bfe37, 0xb4e814b3), TOBN(0x22f0de61, 0x702013c6),
+     TOBN(0x811e77a9, 0xbc456797), TOBN(0x4f52c4e6, 0x17081a2f),
+     TOBN(0x87405d81, 0x9fe1640e), TOBN(0x53fa82b7, 0x707711d7),
+     TOBN(0xdc6fff83, 0x0ee4aea6), TOBN(0x8413e22f, 0xfd60373d),
+     TOBN(0x0ecb66be, 0xa9cf3ead), TOBN(0x7418372e, 0x87139b8b),
+     TOBN(0x6aaccf29, 0x5e42b4d7), TOBN(0xb6dc5925, 0x31fc932e),
+     TOBN(0xfa3b4c8e, 0xb88ee8f9), TOBN(0x1f288e60, 0xb521ab57),
+     TOBN(0x06aa3956, 0x2e8c4d8c), TOBN(0x4981c3e5, 0xcf89935b),
+     TOBN(0xbdbd0c47, 0x45fa071e), TOBN(0xa78f831c, 0x496073be),
+     TOBN(0x09a72986, 0xa4e5c001), TOBN(0xac527731, 0x709cb728),
+     TOBN(0x9a64b5b3, 0x988f2781), TOBN(0x6ac9440d, 0x73b1719d),
+     TOBN(0x58ad54c7, 0xe3d2e807), TOBN(0x1c157448, 0x8f06742b),
+     TOBN(0x6b5b7b2a, 0x75c953b2), TOBN(0x927ed77c, 0xa7f1cd5b),
+     TOBN(0x2e8c5399, 0x4cba0e5e), TOBN(0x03aeb14a, 0x3f4a941b),
+     TOBN(0xedbad9a0, 0xa1385c8a), TOBN(0x925a49c1, 0x67fd2258),
+     TOBN(0xe7e368ee, 0x3365ffed), TOBN(0xcc4aad2d, 0xd106eb87),
+     TOBN(0x4ce908da, 0xa980b53b), TOBN(0xd3f49540, 0x16929ac8),
+     TOBN(0x613c804d, 0xd5c05c32), TOBN(0xa42290cc, 0xd7973344),
+     TOBN(0x33952177, 0xa98cf218), TOBN(0x841d9e1f, 0x579ee53a),
+     TOBN(0x1084d61e, 0x0a285bd5), TOBN(0x3935a84e, 0x71171b1c),
+     TOBN(0x8ac2433c, 0xf29b29f9), TOBN(0x5dd868b5, 0x6dd1e9bd),
+     TOBN(0x88da0478, 0x8d102390), TOBN(0x1140735a, 0x657400d1),
+     TOBN(0xa792a25f, 0x9d5b19e1), TOBN(0x9ee015cb, 0x6a27fa79),
+     TOBN(0xea3bf8b5, 0x7ba16a8e), TOBN(0xc5f0cc26, 0xc15fde67),
+     TOBN(0x2e152d95, 0xee2c3290), TOBN(0x8437df2e, 0x4a9ceda4),
+     TOBN(0x4151754e, 0x3c7ebfd1), TOBN(0x556c59a8, 0x88f80aea),
+     TOBN(0x8d099c5d, 0x8de44dbc), TOBN(0x9ecce7fc, 0x77abeecc),
+     TOBN(0x5e0a0f38, 0x3aa311cf), TOBN(0x99ff1eec, 0xb8f2bff5),
+     TOBN(0x5ae0b483, 0xb5dcf488), TOBN(0x11212c45, 0x91483a02),
+     TOBN(0x99fe0738, 0x312134a1), TOBN(0x3b855db0, 0xa72745ef),
+     TOBN(0x37f50e43, 0x892c8eec), TOBN(0xf06a2f04, 0x7d85a7e2),
+     TOBN(0x3916af85, 0xe1d11150), TOBN(0xf56e852f, 0x6785ae1c),
+     TOBN(0xbf8c72ad, 0xae6ada8c), TOBN(0x1fcd53e3, 0xe13285b2),
+     TOBN(0x5327920c, 0xbd56d348), TOBN(0x82a394fb, 0x445658a8),
+     TOBN(0xa7132857, 0x3caf3792), TOBN(0xb15ab34b, 0x550ffe1c),
+     TOBN(0x81898066, 0x6a5d4e4f), TOBN(0x0bda153b, 0x2f854f9d),
+     TOBN(0x77a31009, 0x722730fe), TOBN(0x93707ac4, 0xd5cdd297),
+     TOBN(0xa290be39, 0xd3811e8c), TOBN(0x831a9b95, 0x92a5cdb7),
+     TOBN(0xc74cda84, 0xe7342270), TOBN(0x96466190, 0x3f48affc),
+     TOBN(0xb0496cca, 0x5520b0f0), TOBN(0xc8742cd9, 0xbae930ff),
+     TOBN(0x3a30737a, 0xeaea703a), TOBN(0x0a8e6fb7, 0xfb758854),
+     TOBN(0x9ab9523e, 0x6796f4d1), TOBN(0x36e6c05d, 0xfdf7140f),
+     TOBN(0x3b623150, 0x64ef6a95), TOBN(0x97645381, 0xaaa5b792),
+     TOBN(0x4bc2c31c, 0x56471100), TOBN(0x4a0e73bb, 0x1bae8d2a),
+     TOBN(0xbfc0770a, 0x8df1f76a), TOBN(0x5089916f, 0xa7bb16ca),
+     TOBN(0x2afe5b1c, 0xf31fe82e), TOBN(0x0b06831d, 0xf0119977),
+     TOBN(0x97caa333, 0xa1af2a82), TOBN(0x93cb92c5, 0xdafed6cd),
+     TOBN(0x09553e7e, 0x92c3b2e3), TOBN(0x3d9c4b7d, 0x61af2956),
+     TOBN(0xd83f574a, 0x08f84746), TOBN(0x48fc9715, 0xca07f5f8),
+     TOBN(0xb3d5d0d2, 0xdcc51638), TOBN(0xc2a5e335, 0x6153bdcd),
+     TOBN(0x8242cd9a, 0x8aa4ef74), TOBN(0xe71ba25b, 0x0bdaa0d0),
+     TOBN(0x4342d4bb, 0xa4ff172d), TOBN(0x81db10df, 0xfc1341a2),
+     TOBN(0xdd93dd87, 0x7dacb140), TOBN(0x6f8a4e81, 0xd12d347f),
+     TOBN(0x0d4e7e46, 0x1bc369be), TOBN(0x3ce10a77, 0x1fafd0c5),
+     TOBN(0x5559dd31, 0xe67145b6), TOBN(0xf2d905b4, 0x5b2427e7),
+     TOBN(0x0d840fab, 0xcaf57d0c), TOBN(0x96258665, 0x78742ab6),
+     TOBN(0xc85482ad, 0x409c1c8e), TOBN(0xdca2a058, 0xadaa6167),
+     TOBN(0xec26ad9a, 0x0c8885fd), TOBN(0x1b93b8a2, 0x2a600cb2),
+     TOBN(0x340aa7fc, 0x2539986b), TOBN(0xd7674876, 0xa23dee41),
+     TOBN(0xa948a929, 0x2e1a9837), TOBN(0x9ae67d2a, 0x71438da9),
+     TOBN(0xeac6f447, 0xd56bdf1f), TOBN(0xb22e8425, 0xc2b502ff),
+     TOBN(0xe1cc9d3d, 0xfca5a501), TOBN(0x8192bc29, 0xb64baf39),
+     TOBN(0xeb2c901a, 0x52ce849e), TOBN(0x7f5f38b1, 0x1dd506f1),
+     TOBN(0xfb3684b1, 0x0f0a1d68), TOBN(0x16c4aacd, 0xe9240ff8),
+     TOBN(0xffa68243, 0x5a4d8995), TOBN(0x27264ab5, 0x54e4c95d),
+     TOBN(0x9aa40cdc, 0x4f34ffaa), TOBN(0xcb8a30a3, 0x5fd818ee),
+     TOBN(0x39038863, 0xf7f35053), TOBN(0x421a17f3, 0x328787d2),
+     TOBN(0x38aa682e, 0xf3d8310f), TOBN(0xb52d41e8, 0xf4123153),
+     TOBN(0x4fbef3dd, 0x7026310b), TOBN(0x0c6bd7ad, 0xf6ff5692),
+     TOBN(0x3831c6b2, 0xa9be5d0c), TOBN(0xb5c9ae85, 0xe8d328b8),
+     TOBN(0x76d26abc, 0x6516bba4), TOBN(0xc237f9a5, 0x446d35a8),
+     TOBN(0xb2b16c0f, 0xf012a8d0), TOBN(0xddf2b7fe, 0x0ee0315b),
+     TOBN(0xbb85b640, 0x056ad6c2), TOBN(0x7c51ef96, 0xac074372),
+     TOBN(0x1c7ce31c, 0xf10b43fc), TOBN(0x08e4101b, 0x26f4d3a4),
+     TOBN(0xd18511c4, 0x3968459f), TOBN(0x00e20c3f, 0xd6d07839),
+     TOBN(0xd5bcd598, 0xe4fcdc11), TOBN(0x99e9a4d0, 0xc877f6a2),
+     TOBN(0x9c5dd9d0, 0xbd491646), TOBN(0x83918f60, 0x9bfd7a1a),
+     TOBN(0x4bc130cd, 0x7e2b95a3), TOBN(0x668825fb, 0xfbc31c83),
+     TOBN(0x817d77b1, 0x06a9ad54), TOBN(0x3a999d7d, 0x89a25eca),
+     TOBN(0xd3ac4107, 0xda68b768), TOBN(0x6904bcdd, 0xbebc4c4d),
+     TOBN(0xb0d2103c, 0xa53d39e9), TOBN(0xdba86bd2, 0x30a5e950),
+     TOBN(0xb0925680, 0x4f52208e), TOBN(0x37c3156a, 0x28495b2c),
+     TOBN(0x2389ab34, 0xc15855ae), TOBN(0xc14dfd96, 0x3017194f),
+     TOBN(0x420e0719, 0x1146b838), TOBN(0x1a9f909b, 0x8fb4b6fc),
+     TOBN(0x2926ef17, 0xdd63404d), TOBN(0x0e89c4d4, 0x1399cc68),
+     TOBN(0x6507fede, 0xf7ec20b8), TOBN(0x1ac084ff, 0x88c751d6),
+     TOBN(0x31bc08be, 0xdefe29e6), TOBN(0xd4219971, 0x4f0692c5),
+     TOBN(0x4d6ee742, 0x36069bc0), TOBN(0x3868ef6a, 0xff80f3d7),
+     TOBN(0x6df02d7c, 0x5a9c6f4b), TOBN(0x2c3096bb, 0x101abf69),
+     TOBN(0x0c2b01ec, 0x8eaacaeb), TOBN(0x65914c20, 0xeb2e687a),
+     TOBN(0x13722ab0, 0x79ed523a), TOBN(0x33b29bec, 0x249d5624),
+     TOBN(0xd3d0f467, 0xf76fdaf7), TOBN(0x7ce072f9, 0x12ddfd9a),
+     TOBN(0xce918a57, 0x47bdefd3), TOBN(0x14d38ab4, 0x750e5315),
+     TOBN(0x08bbb20e, 0x3346f647), TOBN(0x428b917f, 0x05b26894),
+     TOBN(0xc8fb5c21, 0xca865ba6), TOBN(0xee6e41e0, 0x2e6e8e6f),
+     TOBN(0xd00ae621, 0x4c608b60), TOBN(0x65975639, 0x6ff685cd)},
+    {TOBN(0xbbccce39, 0xa368eff6), TOBN(0xd8caabdf, 0x8ceb5c43),
+     TOBN(0x9eae35a5, 0xd2252fda), TOBN(0xa8f4f209, 0x54e7dd49),
+     TOBN(0xa56d72a6, 0x295100fd), TOBN(0x20fc1fe8, 0x56767727),
+     TOBN(0xbf60b248, 0x0bbaa5ab), TOBN(0xa4f3ce5a, 0x313911f2),
+     TOBN(0xc2a67ad4, 0xb93dab9c), TOBN(0x18cd0ed0, 0x22d71f39),
+     TOBN(0x04380c42, 0x5f304db2), TOBN(0x26420cbb, 0x6729c821),
+     TOBN(0xca07923c, 0x0eb008c8), TOBN(0xab79402d, 0x9985912e),
+     TOBN(0x41e379e8, 0x3cb02510), TOBN(0xfabac005, 0xbeb383ef),
+     TOBN(0x24d12d9a, 0x1076dd0d), TOBN(0x95afd46f, 0xb208f127),
+     TOBN(0x9cc38a60, 0xb1031e46), TOBN(0x93e21e97, 0x7009f6bc),
+     TOBN(0x6f6360d9, 0x8ac219ef), TOBN(0x1edaab3f, 0xaf284c80),
+     TOBN(0x9c3b5281, 0x019e366a), TOBN(0x6475c579, 0xbc9e9726),
+     TOBN(0x26bd07d6, 0xbdfbcae8), TOBN(0x10b5173f, 0xdf01a80a),
+     TOBN(0xd831c546, 0x6798b96c), TOBN(0x1d6b4108, 0x1d3f3859),
+     TOBN(0x501d38ec, 0x991b9ec7), TOBN(0x26319283, 0xd78431a9),
+     TOBN(0x8b85baf7, 0x118b343c), TOBN(0x4696cddd, 0x58def7d0),
+     TOBN(0xefc7c110, 0x7acdcf58), TOBN(0xd9af415c, 0x848d5842),
+     TOBN(0x6b5a06bc, 0x0ac7fdac), TOBN(0x7d623e0d, 0xa344319b),
+     TOBN(0x8410d829, 0x8d85a25a), TOBN(0x48ee0135, 0x4af81a14),
+     TOBN(0xae460d0d, 0x18c25348), TOBN(0x5d0279a0, 0x7eb035a3),
+     TOBN(0x87e7c128, 0x9a114414), TOBN(0x17c08a8e, 0xc0744f79),
+     TOBN(0xb7b2b4f1, 0x025cdbe3), TOBN(0x9a74f15d, 0x82d1af60),
+     TOBN(0x124a7395, 0xb51ee685), TOBN(0xf2937c4b, 0xf6122422),
+     TOBN(0xb4ec1332, 0x07f1a7ff), TOBN(0xad801112, 0xf886032e),
+     TOBN(0x4c0d7806, 0x0c9d3547), TOBN(0x993f048d, 0xcf2aed47),
+     TOBN(0x5217c453, 0xe4b57e22), TOBN(0xb4669e35, 0xf4172b28),
+     TOBN(0x509a3cd0, 0x49f999f8), TOBN(0xd19f8632, 0x87c69d41),
+     TOBN(0xe14d01e8, 0x4c8fded0), TOBN(0x342880fd, 0xeafd9e1c),
+     TOBN(0x0e17bff2, 0x70dc2bf0), TOBN(0x46560b7b, 0xc0186400),
+     TOBN(0xe28c7b9c, 0x49a4dd34), TOBN(0x18211916, 0x0f325d06),
+     TOBN(0xdd4eb3d0, 0x7bb5346e), TOBN(0x9a46ad01, 0x382e7db7),
+     TOBN(0x1200285d, 0xdc1973c7), TOBN(0xfd342bea, 0xa0046b98),
+     TOBN(0xd1917349, 0x1219a7fc), TOBN(0x5383d319, 0xb7caffe5),
+     TOBN(0xea5a0c4e, 0x2e0fa118), TOBN(0x1cc2de3c, 0xa5457b28),
+     TOBN(0x5b2a16dc, 0x6046eeea), TOBN(0x1755e1fe, 0xcc8e64b1),
+     TOBN(0x51e4946e, 0x9e7fadda), TOBN(0xf805422f, 0xfcbf4ec2),
+     TOBN(0x46d70888, 0xd7e02e18), TOBN(0x7c806954, 0xd9f11fd9),
+     TOBN(0xe4948fca, 0x4fbea271), TOBN(0x7d6c7765, 0xbd80a9df),
+     TOBN(0x1b470ea6, 0xf3871c71), TOBN(0xd62de244, 0x8330a570),
+     TOBN(0xdaecddc1, 0xc659c3a7), TOBN(0x8621e513, 0x077f7afc),
+     TOBN(0x56c7cd84, 0xcaeeef13), TOBN(0xc60c910f, 0xc685a356),
+     TOBN(0xe68bc5c5, 0x9dd93ddc), TOBN(0xd904e89f, 0xfeb64895),
+     TOBN(0xf877e8c6, 0xbd08ffaf), TOBN(0x24718fef, 0xaf23012f),
+     TOBN(0x19ff269f, 0x2b004cfe), TOBN(0x8adc5d77, 0x95450f8b),
+     TOBN(0x688ce8bc, 0xe2a7d458), TOBN(0x74d7445b, 0x97bd7fdc),
+     TOBN(0x1b9f4ad6, 0x41e6abad), TOBN(0x6652ed05, 0xf00e4bf5),
+     TOBN(0xabee1f7e, 0x71d83d86), TOBN(0xe693c76d, 0x25ffc219),
+     TOBN(0x1c9a84af, 0xc873f553), TOBN(0x84d27187, 0x66d77a55),
+     TOBN(0x75d874fb, 0x8ba7917a), TOBN(0x18fa7f53, 0xfd043bd4),
+     TOBN(0x212a0ad7, 0x1fc3979e), TOBN(0x5703a7d9, 0x5d6eac0e),
+     TOBN(0x222f7188, 0x017dead5), TOBN(0x1ec687b7, 0x0f6c1817),
+     TOBN(0x23412fc3, 0x238bacb6), TOBN(0xb85d70e9, 0x54ced154),
+     TOBN(0xd4e06722, 0xbda674d0), TOBN(0x3ea5f178, 0x36f5a0c2),
+     TOBN(0x7e7d79cf, 0xf5c6d2ca), TOBN(0x1fff9464, 0x3dbb3c73),
+     TOBN(0xe566dc05, 0x7e5f7121), TOBN(0xccac74e2, 0x2ed07bc3),
+     TOBN(0xaabfdfcd, 0xc70401b4), TOBN(0xac9fc449, 0x6254e0db),
+     TOBN(0x358d885f, 0x11c7de05), TOBN(0xb8e6a4a9, 0xd60772b4),
+     TOBN(0x884272a5, 0xcfe917ce), TOBN(0xdfbe9868, 0x9a3d347a),
+     TOBN(0x06b90848, 0xc9d1bacc), TOBN(0xc4ccedb6, 0xdb8c6288),
+     TOBN(0x892878b9, 0x79e5683e), TOBN(0x1b521829, 0x243273e3),
+     TOBN(0x916e19d0, 0xf163e4a8), TOBN(0x1e6740e7, 0x1489df17),
+     TOBN(0x1eaf9723, 0x339f3a47), TOBN(0x22f0ed1a, 0x124b8dad),
+     TOBN(0x39c9166c, 0x49c3dd04), TOBN(0x628e7fd4, 0xce1e9acc),
+     TOBN(0x124ddf27, 0x40031676), TOBN(0x00256939, 0x1eddb9be),
+     TOBN(0xd39e25e7, 0xd360b0da), TOBN(0x6e3015a8, 0x4aa6c4c9),
+     TOBN(0xc6a2f643, 0x623eda09), TOBN(0xbeff2d12, 0x50aa99fb),
+     TOBN(0x099369c4, 0xbf0c6fbe), TOBN(0x976f78b2, 0xfe7d5727),
+     TOBN(0x32feb503, 0xd18267a9), TOBN(0x162c4150, 0x1a7dd0fe),
+     TOBN(0x3141e377, 0x26b8e969), TOBN(0x50497a64, 0x3b53a94a),
+     TOBN(0x96159f41, 0x607b4cfc), TOBN(0x1999b704, 0x2f111bab),
+     TOBN(0x3254987c, 0x760f2eae), TOBN(0x5308075b, 0x841014fa),
+     TOBN(0xc634127e, 0x4e7adad8), TOBN(0x32a70a60, 0x59ffbfe6),
+     TOBN(0x1feef7ce, 0x93ee8089), TOBN(0xc6b180bc, 0x252dd7bd),
+     TOBN(0xa16fb20b, 0x1788f051), TOBN(0xd86fd392, 0xe046ed39),
+     TOBN(0xda0a3611, 0x9378ce1d), TOBN(0x121ef3e7, 0xa5f7a61d),
+     TOBN(0x94d22061, 0x92d13cae), TOBN(0x5076046a, 0x77c72e08),
+     TOBN(0xf18bc233, 0x7d2308b9), TOBN(0x004db3c5, 0x17f977b1),
+     TOBN(0xd05ae399, 0x0471c11d), TOBN(0x86a2a557, 0x85cd1726),
+     TOBN(0x7279c369, 0xa1f857e6), TOBN(0x029d30ef, 0x27fb373a),
+     TOBN(0xe82cbc80, 0x6827358b), TOBN(0x2bfe09aa, 0xa18f57ab),
+     TOBN(0x63bf3145, 0xe5503492), TOBN(0x7ea15bea, 0xfb28ee43),
+     TOBN(0x8e6d428f, 0x5eec91b8), TOBN(0x215e03e9, 0x611b1799),
+     TOBN(0xb9957371, 0x61d476de), TOBN(0x2320c764, 0xe76726a5),
+     TOBN(0xc5de8817, 0x8e5e26f5), TOBN(0x24aae069, 0x9161e0b7),
+     TOBN(0xb8d9b286, 0x72107804), TOBN(0xb5a7c413, 0x3303b79b),
+     TOBN(0x927eef78, 0x5fa37ded), TOBN(0xa1c5cf1e, 0xad67daba),
+     TOBN(0xaa5e3fb2, 0x7360e7c7), TOBN(0x8354e61a, 0x0a0c0993),
+     TOBN(0x2ec73af9, 0x7f5458cc), TOBN(0xde4cb488, 0x48474325),
+     TOBN(0x2dd134c7, 0x7209bc69), TOBN(0xb70c5567, 0x451a2abe),
+     TOBN(0x2cd1b200, 0x8e293018), TOBN(0x15f8da7a, 0xd33c0d72),
+     TOBN(0x5584cbb3, 0x893b9a2d), TOBN(0x820c660b, 0x00850c5d),
+     TOBN(0x4126d826, 0x7df2d43d), TOBN(0xdd5bbbf0, 0x0109e801),
+     TOBN(0x85b92ee3, 0x38172f1c), TOBN(0x609d4f93, 0xf31430d9),
+     TOBN(0x1e059a07, 0xeadaf9d6), TOBN(0x70e6536c, 0x0f125fb0),
+     TOBN(0xd6220751, 0x560f20e7), TOBN(0xa59489ae, 0x7aaf3a9a),
+     TOBN(0x7b70e2f6, 0x64bae14e), TOBN(0x0dd03701, 0x76d08249)},
+    {TOBN(0xaff47822, 0x31cb94c9), TOBN(0xf1b5a0b7, 0x803c1af4),
+     TOBN(0xbeb85f8d, 0x2ef696a9), TOBN(0x8ce5baab, 0x4fa94fca),
+     TOBN(0x0a32f962, 0x00d41a43), TOBN(0x0f69ad57, 0x74f6e772),
+     TOBN(0xbe0221af, 0x6ccb5157), TOBN(0xcb83969a, 0x2a4f91ff),
+     TOBN(0x78ff85d6, 0xa7e49f39), TOBN(0x63006589, 0xcb5d3c63),
+     TOBN(0xe8e43835, 0x96eb65f5), TOBN(0x79f59da9, 0xff8adbdf),
+     TOBN(0x082ea61d, 0x10eeed24), TOBN(0x7c9d5ade, 0x143fd59d),
+     TOBN(0x7d33df96, 0x2e54f5cf), TOBN(0x340b0d36, 0xe39dc6ab),
+     TOBN(0xd97a8b84, 0x8d179b13), TOBN(0x88184bb0, 0x288d388c),
+     TOBN(0x2237e507, 0xe116ae6d), TOBN(0x3e97b063, 0x211b2cf0),
+     TOBN(0x645f8bcb, 0x42be7459), TOBN(0xce2b0f54, 0xde2176b6),
+     TOBN(0xaf570a09, 0xd1e2f09c), TOBN(0x110adf56, 0x57fdc001),
+     TOBN(0x9d21c740, 0x842e4246), TOBN(0x30f474c4, 0x4ab098a5),
+     TOBN(0x57f8b1a3, 0xaae5d701), TOBN(0x477e4f88, 0x91978d15),
+     TOBN(0x2913ffb4, 0x0fb85b1e), TOBN(0x80aedb22, 0x58489fb4),
+     TOBN(0x0e1ab267, 0x0912d86a), TOBN(0xea5e6a41, 0x82933f3a),
+     TOBN(0xf578ccb6, 0x57ab8d86), TOBN(0x339fd796, 0x547f64bd),
+     TOBN(0x90469394, 0x3f3e497e), TOBN(0x2cde596c, 0x1d864706),
+     TOBN(0x158bfe27, 0xbcb6db29), TOBN(0x96721241, 0x0054d963),
+     TOBN(0xf07b153b, 0x8e71aca1), TOBN(0x5e676981, 0x71b11643),
+     TOBN(0x77b7dd7d, 0xd04e2f90), TOBN(0x07814aa6, 0xf0dcf109),
+     TOBN(0xd3bab2a4, 0xfe1d0b1e), TOBN(0x50abba31, 0xbe69e691),
+     TOBN(0x54fe99af, 0xc6f53cd9), TOBN(0x071f2a4f, 0x628039e4),
+     TOBN(0xf1f44181, 0xb183aa16), TOBN(0xdf0138e0, 0x5010f6f9),
+     TOBN(0x5737f903, 0xaff45947), TOBN(0xe576f8ff, 0x62c5dfd1),
+     TOBN(0x2a7d4f18, 0xe1e379a2), TOBN(0x8596ffaf, 0xf2f26f8c),
+     TOBN(0x12f49653, 0xfab86608), TOBN(0xcc618497, 0x3aab1eaf),
+     TOBN(0x7b5d029f, 0x865d9611), TOBN(0x87af2d58, 0xbf6861f5),
+     TOBN(0xb7653646, 0x31b2d7cf), TOBN(0x60f47e05, 0x8be46ef9),
+     TOBN(0xa21106a9, 0xb1c175ce), TOBN(0x21cb0e27, 0xdeb065b6),
+     TOBN(0xb287e26d, 0xb340f4eb), TOBN(0xa397cfd1, 0xb34c2948),
+     TOBN(0x0d91d763, 0x9a7ead15), TOBN(0xd71901b9, 0x66e88f14),
+     TOBN(0x02447ad3, 0xb4884ac2), TOBN(0x5e6f7545, 0xd006f448),
+     TOBN(0x2af6bfee, 0xec5744e3), TOBN(0x643f46b1, 0xf55cd6ab),
+     TOBN(0x13400bc4, 0x87b2c127), TOBN(0xd1dddff4, 0x4629859b),
+     TOBN(0x9710cae0, 0x20feecb9), TOBN(0x594bc27c, 0xd02d4300),
+     TOBN(0xb0233c4d, 0xaa331700), TOBN(0x3bf63a61, 0x30b3a854),
+     TOBN(0xc269d68b, 0x49b806e2), TOBN(0x4a079274, 0xda8ddca6),
+     TOBN(0x256bc009, 0x0db04d76), TOBN(0x7395c11c, 0x1f47dfee),
+     TOBN(0x51bbcc95, 0x13886ec2), TOBN(0x9d5377eb, 0x244d1f0d),
+     TOBN(0xa6e0f054, 0xff9e6b3a), TOBN(0x307f9e93, 0x204e5258),
+     TOBN(0x8069c01d, 0x8d34d97b), TOBN(0x30f785ce, 0x43c24997),
+     TOBN(0xb1e36501, 0x9c77ca60), TOBN(0xfe084a23, 0x01018e14),
+     TOBN(0xbf451d2c, 0xa4bfdcec), TOBN(0xd210892f, 0xb29cdcfe),
+     TOBN(0x5b12bcd8, 0x94514871), TOBN(0xd03ca18c, 0x1809b1e3),
+     TOBN(0x09b24311, 0x5858e4ea), TOBN(0x37b30d50, 0xe57524b4),
+     TOBN(0xcef0a16b, 0x5de334b5), TOBN(0xfe0bd1e2, 0x0b116076),
+     TOBN(0x54e4b482, 0x89ae2bf4), TOBN(0xfbcc5e1a, 0x68c8a937),
+     TOBN(0xf7473902, 0x91ae19fb), TOBN(0xc1c228d3, 0x1bed3f8d),
+     TOBN(0x763ba8ee, 0x6552154e), TOBN(0xb7b60248, 0xe2063ce7),
+     TOBN(0xafaf01b8, 0x178a5184), TOBN(0xe193b834, 0x7901d21a),
+     TOBN(0x1d29f7d6, 0x260eb30f), TOBN(0x030516c6, 0xc23b4b94),
+     TOBN(0x30a8046a, 0x7dc4a09a), TOBN(0x8414133a, 0xb5ee1147),
+     TOBN(0x7ec8dccf, 0x4453f1a6), TOBN(0xe380e69c, 0x59da8e8d),
+     TOBN(0x28fdf72f, 0x22c77f4b), TOBN(0xfa077b15, 0x32485220),
+     TOBN(0xc3801faf, 0xd6325081), TOBN(0x8dd4e3c9, 0x891ff5df),
+     TOBN(0x6726c5ec, 0xaa73c827), TOBN(0x12af9707, 0xe9b9b128),
+     TOBN(0x5e6ae3cb, 0xff25cf07), TOBN(0x0613bef8, 0xd7cb7adc),
+     TOBN(0xfd426caa, 0xcef4cd47), TOBN(0xe14ed3ef, 0xced0e435),
+     TOBN(0x8323a861, 0x6000ec80), TOBN(0x58221041, 0x941f8071),
+     TOBN(0x6f766821, 0xa83eb17c), TOBN(0x91fe58c1, 0xbd7ff851),
+     TOBN(0x7ce09f04, 0x9063af8a), TOBN(0x5230b3c6, 0x6c109e02),
+     TOBN(0x501adb33, 0x36274fb9), TOBN(0xcfb34bec, 0x90547af3),
+     TOBN(0x622d1387, 0x40f61ec9), TOBN(0xdf26e4c6, 0x0e3e98d1),
+     TOBN(0x6b3b3d62, 0x7c676ee3), TOBN(0x9f841097, 0xf0244737),
+     TOBN(0xcfaf6ead, 0x4fc8dd58), TOBN(0x4f5d463b, 0xcd534ab4),
+     TOBN(0xa5023e13, 0x64be0f56), TOBN(0x6a7310e0, 0x0046f45c),
+     TOBN(0xe0af09ae, 0xec8700d3), TOBN(0xdea5fb7c, 0xeb2d38f0),
+     TOBN(0xc038eae6, 0x859852e6), TOBN(0xd515fb4c, 0x8c34f04c),
+     TOBN(0x546b778e, 0x1488c207), TOBN(0x8cf4f114, 0x6258d8ba),
+     TOBN(0x474e60d8, 0x5182c96c), TOBN(0xcd038730, 0x3dbde757),
+     TOBN(0x387232f8, 0x76ab01ff), TOBN(0x277614f6, 0x28231392),
+     TOBN(0x930c3c59, 0x80b86bc6), TOBN(0xebc8c144, 0xa06d10a8),
+     TOBN(0x20743ddd, 0x81e55432), TOBN(0x059521d4, 0x006d3073),
+     TOBN(0x8d4fe303, 0x12dbc785), TOBN(0x15a4debc, 0xdf4901d6),
+     TOBN(0xc9b226b1, 0xb37b2d8b), TOBN(0x385ac3c9, 0x0fe9bdbf),
+     TOBN(0x64df89f7, 0xfeaa5bff), TOBN(0x67de8e03, 0x81de42ba),
+     TOBN(0x12bd8322, 0x5bf63f6f), TOBN(0xb499f8ff, 0x32b4ec13),
+     TOBN(0xba0800b8, 0x9608c827), TOBN(0x560c31f5, 0x47dfcd84),
+     TOBN(0xd52e8fdc, 0x520dba6e), TOBN(0x66a917c2, 0x854fa4ee),
+     TOBN(0xfc543b79, 0xc6e5d664), TOBN(0x5b643692, 0x32b530aa),
+     TOBN(0x427dc1ef, 0x563a3933), TOBN(0x4e47c929, 0x88d5902f),
+     TOBN(0x9eff3a40, 0x93eca4fb), TOBN(0xc5b396ee, 0x59260a69),
+     TOBN(0x936a5062, 0x48e70137), TOBN(0x69eb44f6, 0x21bba959),
+     TOBN(0x0af34aa7, 0xab9f58a2), TOBN(0x0ba16d98, 0x7d150dcb),
+     TOBN(0x444d5495, 0xb7c119b4), TOBN(0x317a55e5, 0x5ecc3210),
+     TOBN(0x8fa3b3ce, 0xb1aa90c0), TOBN(0x8e7c7539, 0x0b2e9392),
+     TOBN(0x5ee5f3e8, 0xe8921afa), TOBN(0x3934ea8d, 0xa3100dd3),
+     TOBN(0x955045b1, 0x4c8ae6ce), TOBN(0xa54acb5f, 0x649897fc),
+     TOBN(0x4204fab6, 0xe7081246), TOBN(0xec3dc968, 0x6dce3a55),
+     TOBN(0x309b1eb3, 0x3ef5a413), TOBN(0xa7607981, 0xa81f43fb),
+     TOBN(0x87c2b81e, 0xbf8a894c), TOBN(0x27a40bce, 0x0d293293),
+     TOBN(0x7f4c315b, 0xe4bf3714), TOBN(0x03fdc14e, 0x01236895),
+     TOBN(0x319c88f8, 0xdff053fe), TOBN(0x146bb448, 0xea3fa121),
+     TOBN(0xfcc2a05d, 0xf0dd1380), TOBN(0xc8d55b02, 0x4acba9fa),
+     TOBN(0x871358de, 0x5927313e), TOBN(0xfd1d81d3, 0x17ce294a)},
+    {TOBN(0xd3797831, 0xff63ae69), TOBN(0xa753de02, 0xce4c7eaf),
+     TOBN(0x2ff7a6a6, 0x11a4e339), TOBN(0x904f86f0, 0x5328043a),
+     TOBN(0xe29d31c0, 0x12e9f7dd), TOBN(0x8825a639, 0xc0a51904),
+     TOBN(0x070c2696, 0xebfc2cc7), TOBN(0xc03ce643, 0xc5f7a943),
+     TOBN(0x5b970d0c, 0x12c8a1f5), TOBN(0x572aaaa1, 0xab352a83),
+     TOBN(0x63df45a9, 0x0c5eb0c7), TOBN(0x95c951e1, 0xd4977599),
+     TOBN(0x2c5b0e42, 0xbca07a42), TOBN(0xbe57f359, 0x7a0dffa1),
+     TOBN(0xace48595, 0x9aa90727), TOBN(0x32be886a, 0xf658699b),
+     TOBN(0xce75d6c6, 0xda3b18e6), TOBN(0x9d563e4f, 0x69caf667),
+     TOBN(0xc17c66cf, 0x065eb772), TOBN(0xfbe12381, 0x4df9f6ef),
+     TOBN(0xceb80041, 0x623db4ef), TOBN(0xe75615b2, 0xc74762e1),
+     TOBN(0xade8a543, 0x8671c52f), TOBN(0xb713c401, 0xcacaf2ec),
+     TOBN(0xe6d039ef, 0x467eb167), TOBN(0xa7e0959d, 0x74696cf9),
+     TOBN(0xf3a19b9d, 0x7078d8a0), TOBN(0x5d4ec99c, 0x07cdc6f6),
+     TOBN(0x4842d0f9, 0x8386eed8), TOBN(0x48f5ab80, 0x545fc0d5),
+     TOBN(0x8906fc62, 0x6d39c2f7), TOBN(0x1c050d69, 0x1bf5366a),
+     TOBN(0xac506c57, 0x9f54d0d6), TOBN(0x9a356a6e, 0xf9e4b94c),
+     TOBN(0x62632c51, 0x08a75e61), TOBN(0xfc1b9fa5, 0xc6951dc2),
+     TOBN(0xa933aaf7, 0xa4886619), TOBN(0x9ec1915f, 0x4af13c7f),
+     TOBN(0x25a9dff8, 0x854de496), TOBN(0xa8b31d9b, 0x247bec15),
+     TOBN(0x468a25c8, 0x4661e58d), TOBN(0x8989c046, 0x786a0707),
+     TOBN(0x282db8ca, 0xbb66922e), TOBN(0x73bf240d, 0x45ca29ff),
+     TOBN(0xa2c40faa, 0xeaeda06e), TOBN(0x69632929, 0xadd94b47),
+     TOBN(0xc72354f6, 0xb0069076), TOBN(0x8d197fbf, 0x7878e92c),
+     TOBN(0x69a9ebd8, 0xa83bbb88), TOBN(0xcbab0b5a, 0x29f98875),
+     TOBN(0x325e487e, 0x4e7611f0), TOBN(0x90aa24b1, 0xd955cc3b),
+     TOBN(0x840e70a1, 0x3c264d53), TOBN(0x15bcf88b, 0xad7f4f81),
+     TOBN(0xe47552cc, 0x2cf0df0a), TOBN(0xcb999733, 0x79205ea9),
+     TOBN(0x25dc58bd, 0x10d5ca45), TOBN(0x0947d715, 0x1228b978),
+     TOBN(0x9a0204da, 0x4f2c7c4a), TOBN(0x4377ea4a, 0x4690052c),
+     TOBN(0x015c325e, 0xb8e79179), TOBN(0xf4fc6133, 0x5b57dce6),
+     TOBN(0x27a51e5d, 0x78d6858f), TOBN(0x13babcab, 0x4dd5f180),
+     TOBN(0xfaa19cb1, 0x847e499e), TOBN(0xe2688ae6, 0x08aaea61),
+     TOBN(0xe20d7edc, 0xe86100d5), TOBN(0xa9b0d46b, 0xed2fedac),
+     TOBN(0x5e99cc0c, 0x1d357ded), TOBN(0x4c1263ab, 0x723cac89),
+     TOBN(0xad5f3e6f, 0xf15e22f4), TOBN(0xf25f3950, 0xd77dae65),
+     TOBN(0x3c0e2b97, 0x37e8e6b2), TOBN(0xa2037913, 0x575da8b7),
+     TOBN(0xeedf0a75, 0xb925cbb2), TOBN(0x4f28ec1b, 0xc561b405),
+     TOBN(0x368fb274, 0x2901931c), TOBN(0x52b54eee, 0x2f26221f),
+     TOBN(0x381845b6, 0x247812a9), TOBN(0xf9bcc961, 0x9115a0df),
+     TOBN(0xef127dfe, 0xcb84d25b), TOBN(0x4256afe5, 0xfa10e0a7),
+     TOBN(0x0c08a532, 0x353a15eb), TOBN(0xbbd15b17, 0x6a91e61e),
+     TOBN(0x854b0584, 0x6150771a), TOBN(0x35fdd9b4, 0xd9ca9868),
+     TOBN(0xec829389, 0x4c32fc71), TOBN(0x882fad4c, 0x9ec8f90d),
+     TOBN(0x2d39990d, 0xc6c7b9c0), TOBN(0x7fbc201b, 0xd71a25e5),
+     TOBN(0x6b852e65, 0x5166da7d), TOBN(0xc6bde23a, 0x3d8c6e36),
+     TOBN(0x37001154, 0x5857f048), TOBN(0x746621fc, 0x1ccb9bc8),
+     TOBN(0x97e44e63, 0x612bb853), TOBN(0xabc3b450, 0x758da4ed),
+     TOBN(0x856463a8, 0xbb44db8a), TOBN(0x18ec5abe, 0x4baf2f64),
+     TOBN(0x75efa67d, 0x92980518), TOBN(0xabd300f8, 0x94b03911),
+     TOBN(0x4ea44bd4, 0xc1cd1cf7), TOBN(0x525c3583, 0x124ef41a),
+     TOBN(0x03c18c0a, 0x6b3a701c), TOBN(0x5ef82731, 0xcc7b6885),
+     TOBN(0xb3716386, 0xa00d0089), TOBN(0xed9af50c, 0x741c0ea9),
+     TOBN(0x31f0e49a, 0x8a36f03f), TOBN(0xce993757, 0xca724a16),
+     TOBN(0x2b6bf5e2, 0x9a90c6b9), TOBN(0x9b134fc8, 0xa2c0b35f),
+     TOBN(0xd64157f8, 0xa6717af8), TOBN(0x7228156c, 0x45dd16f0),
+     TOBN(0x0a9ab894, 0xdaa99226), TOBN(0xa7b130f7, 0xbccb07e5),
+     TOBN(0x2b7ab41f, 0x4d9243d5), TOBN(0x570b4ed0, 0x88568fa4),
+     TOBN(0x666b98be, 0xc9c84d91), TOBN(0x2a75793d, 0x02124f7a),
+     TOBN(0x0fb9b82e, 0x0aa16891), TOBN(0x71e94c93, 0x3cc7f2d7),
+     TOBN(0xb7c13bfb, 0xf47211c0), TOBN(0x738fe4a9, 0xe70929ae),
+     TOBN(0x4cdac99b, 0x423db6f3), TOBN(0x3883201a, 0xe4255a4d),
+     TOBN(0x7ffe82d3, 0x9730d749), TOBN(0x033ba755, 0xafbaaabb),
+     TOBN(0xa302ba65, 0xf836d62b), TOBN(0xc626f604, 0x143a88bb),
+     TOBN(0xe1d189aa, 0x31c16b3f), TOBN(0x4664c050, 0x7d68ab17),
+     TOBN(0xcffc651c, 0xc02eb56b), TOBN(0x6c52f3c4, 0x6ab49c24),
+     TOBN(0x58775857, 0x8fb415b7), TOBN(0xab580f15, 0x9e88dca3),
+     TOBN(0x86a12e3d, 0xa62265d2), TOBN(0x8ec42786, 0x72d98b08),
+     TOBN(0xb9da8016, 0xf61e9c85), TOBN(0xa895aedb, 0x800994ce),
+     TOBN(0x63d0878c, 0xe38ef526), TOBN(0xa081d714, 0x1efb6575),
+     TOBN(0x780b9e12, 0x6a1c1efa), TOBN(0xeed68d0e, 0xebd0497a),
+     TOBN(0xbfeee3d2, 0x9265231e), TOBN(0x46f751da, 0x80e03127),
+     TOBN(0x806dce0b, 0x03e4074c), TOBN(0xd4054700, 0x6973bc6d),
+     TOBN(0x8c4d393e, 0xa2897b68), TOBN(0x7d592d04, 0xc7f9af16),
+     TOBN(0x0625826a, 0x4f895dbf), TOBN(0x038bed29, 0x37dfc8a1),
+     TOBN(0x981862da, 0x4799d78a), TOBN(0xf34c1895, 0x6675c1b3),
+     TOBN(0x64de9a5b, 0x8706afd3), TOBN(0xc80ff68e, 0xf74e6ca3),
+     TOBN(0x26a90422, 0x83ed8cf2), TOBN(0xc1f5ce53, 0x77a47011),
+     TOBN(0x0bd15783, 0x4aabf727), TOBN(0xfe79d2dd, 0x54fce3ad),
+     TOBN(0x242b1806, 0x1a77ce78), TOBN(0x30cf6c32, 0xda7e489c),
+     TOBN(0x854e43f8, 0xb2966f38), TOBN(0x6e5fb045, 0xa2dd4ea3),
+     TOBN(0xb2a48aec, 0xde3c9b7a), TOBN(0x66ac77e6, 0x3625ebd6),
+     TOBN(0x332a969b, 0x0bcbabe2), TOBN(0x19de2701, 0x5be51225),
+     TOBN(0xf26c73fc, 0x5b9b80e6), TOBN(0x98c9cbf7, 0x91025007),
+     TOBN(0x1e41874e, 0xbc098b8e), TOBN(0x758ccd5f, 0x8a234773),
+     TOBN(0x47ab76ca, 0xc1bc847f), TOBN(0x377f32e9, 0xc540ceaf),
+     TOBN(0xba8897c3, 0x69c2df21), TOBN(0x6afacb01, 0x233c3a02),
+     TOBN(0xf1609b45, 0xfb54ffb1), TOBN(0xb7a98e5a, 0xb8f9c150),
+     TOBN(0x607478b0, 0x08b1977e), TOBN(0xa9500582, 0xd48b7a90),
+     TOBN(0xacd841e3, 0x32fa7597), TOBN(0xdf53373d, 0xf9333957),
+     TOBN(0xd25f6508, 0x04926a41), TOBN(0x7236b475, 0x514045da),
+     TOBN(0x0b360311, 0x08b9b08b), TOBN(0x16477aff, 0x3fe92e91),
+     TOBN(0x6e5f6cb1, 0x03189ddc), TOBN(0x81ff008e, 0xc698a38f),
+     TOBN(0x02a09218, 0xc93adb23), TOBN(0x71fcecd3, 0x445d8fae),
+     TOBN(0x55a15eac, 0x8fd6b76c), TOBN(0x1e37ec36, 0x11ef96b4),
+     TOBN(0xd1b3b3fc, 0x30e433b5), TOBN(0x49518733, 0x51d174c3)},
+    {TOBN(0x7914213d, 0xb8c9f82e), TOBN(0x7a3e4e38, 0xfc038e90),
+     TOBN(0x6edae5a1, 0x26a34238), TOBN(0xe566bf50, 0x701ce8c7),
+     TOBN(0x3562e875, 0x55656e02), TOBN(0x48325ebf, 0xb4e8efbf),
+     TOBN(0x5f10a504, 0x66505ec3), TOBN(0xd8b9834b, 0x8da78aec),
+     TOBN(0x49d1fc25, 0xcc2f2e40), TOBN(0xe973bb1c, 0xaf5718c1),
+     TOBN(0x9b8825da, 0xd2d6b890), TOBN(0x7de7885e, 0xe2f00f12),
+     TOBN(0xe37211be, 0x7ef79898), TOBN(0xa8103877, 0x21344d16),
+     TOBN(0xfdcd7e26, 0xa1b9f8b4), TOBN(0x5641e45d, 0x7d7f72d5),
+     TOBN(0x5377c1be, 0xc449c920), TOBN(0xd3edcb0c, 0xefc7b2a1),
+     TOBN(0xc657a9ff, 0xe14b42fc), TOBN(0xc8f858c8, 0x00831b07),
+     TOBN(0x6bfcd1bc, 0xd020eaa8), TOBN(0x17534b0a, 0x3f6860c7),
+     TOBN(0x8ce57222, 0x84c7c806), TOBN(0xa1d40eaf, 0x2bd7456b),
+     TOBN(0xe0c93007, 0xc9aa57ee), TOBN(0xebb2d47b, 0x8895a604),
+     TOBN(0xb8aebc49, 0xc4fd6ffe), TOBN(0x2c06e1e5, 0x73f300b6),
+     TOBN(0xa019070d, 0x81628b8b), TOBN(0x2db1690b, 0xbaf8c1ea),
+     TOBN(0xb3fce6c8, 0xcc94ccd2), TOBN(0xf3014638, 0x85bcdf4f),
+     TOBN(0xb1e62616, 0xe2f82c32), TOBN(0x85581e24, 0x68295a54),
+     TOBN(0x0f2e2ff5, 0xbf51f8fa), TOBN(0x940716f1, 0x155c1f6f),
+     TOBN(0xaed02b6b, 0x4e623856), TOBN(0x7a6d2bef, 0x3e1d74cb),
+     TOBN(0x82226ec4, 0x654e7c30), TOBN(0x008ac003, 0xe7034bfd),
+     TOBN(0xe343c540, 0x7fd6b555), TOBN(0xca1b2907, 0x1b429d44),
+     TOBN(0xe0702a33, 0x9c3ceea2), TOBN(0x48079aa9, 0x732694c3),
+     TOBN(0x7e6d72f6, 0xd4652401), TOBN(0xd92655ed, 0x35f60043),
+     TOBN(0xa0dbaac6, 0x273e8cc4), TOBN(0x0bb8f0f9, 0x3c3ffb40),
+     TOBN(0xb41b87b6, 0xc95cd23b), TOBN(0xb99714ba, 0x55e371a4),
+     TOBN(0xb138ee8f, 0x6f571ceb), TOBN(0x09c42be4, 0x80146ec7),
+     TOBN(0x275ee21e, 0xee9aa125), TOBN(0x0cef4d6f, 0x3a878b59),
+     TOBN(0xd436eb1c, 0xa801068d), TOBN(0xe2c5448c, 0x762b8a80),
+     TOBN(0x243beee1, 0xf3640eca), TOBN(0xf979458b, 0x32bbba7a),
+     TOBN(0x6bc26cfe, 0xa63407d3), TOBN(0xd3b6e132, 0x392dd1d3),
+     TOBN(0xbc06ecab, 0x3de4ba2e), TOBN(0xf51ca063, 0x9e491bcd),
+     TOBN(0xa6fc6fa0, 0x453c94be), TOBN(0x5460f943, 0xed1a6731),
+     TOBN(0xeb11656a, 0x4ec3f1fb), TOBN(0x2fcb2cab, 0xff1e7d4e),
+     TOBN(0x59526467, 0x8fea2286), TOBN(0x838117a3, 0x4e0bee38),
+     TOBN(0x7bdf5888, 0x24fd2ce5), TOBN(0x13df0c83, 0x9f2c2925),
+     TOBN(0x1bf621e6, 0xdee97f30), TOBN(0xb43b2558, 0xebea6641),
+     TOBN(0x246c8660, 0x8e729329), TOBN(0x39fcc41d, 0xd693dac8),
+     TOBN(0x48a65b54, 0xc062a6c0), TOBN(0x368a5770, 0x6a5a3101),
+     TOBN(0xd143600f, 0x47ed1988), TOBN(0x48466d92, 0xa764ce3d),
+     TOBN(0xb0500613, 0x5a22cb6b), TOBN(0xf1d77247, 0xedea070c),
+     TOBN(0xb1ddd151, 0x617f2464), TOBN(0x79050698, 0x28b83fd9),
+     TOBN(0x021abb26, 0xd70bf93e), TOBN(0x590b3c42, 0xab5a5e1e),
+     TOBN(0x5906a35c, 0x1cfb991f), TOBN(0xb62a4f80, 0x740a7744),
+     TOBN(0x65c8ac91, 0x36f84763), TOBN(0xf73b3deb, 0xbe0f1dd3),
+     TOBN(0x40358868, 0xa2d26c21), TOBN(0xd907e90a, 0x76792ae7),
+     TOBN(0x3ecea167, 0x668c3d5f), TOBN(0x731068f2, 0x6754b49c),
+     TOBN(0x6db89109, 0x0e006243), TOBN(0xd29106e6, 0xdd94681b),
+     TOBN(0xb40b8694, 0xa85a3de2), TOBN(0xc80c7bf1, 0x936b86cc),
+     TOBN(0x003d45d0, 0x11913575), TOBN(0x866cb2dd, 0x87e1186b),
+     TOBN(0x692f6301, 0x46b69a22), TOBN(0xd296a55c, 0x8174c1d1),
+     TOBN(0x77ef6fbe, 0x9f17af00), TOBN(0x6b588be9, 0x3aa922e1),
+     TOBN(0x99ecb44f, 0x033e6dd7), TOBN(0x32edea2c, 0x1d22b7cd),
+     TOBN(0x3122b027, 0xba7006f3), TOBN(0x8950054b, 0xbb6ebc5c),
+     TOBN(0x4f6d6061, 0x82dab805), TOBN(0xc1205518, 0x1bae5f1b),
+     TOBN(0x28d33e79, 0xe08c180f), TOBN(0x768c7794, 0xf6aec9ce),
+     TOBN(0x5a749f3b, 0xce683c5b), TOBN(0x717629d9, 0x8371fe75),
+     TOBN(0x5e828fc0, 0x57712c1d), TOBN(0xb46c6ed1, 0x7e4c61aa),
+     TOBN(0x5d927bad, 0x5bccf95c), TOBN(0x55d6fc80, 0xd72f68ec),
+     TOBN(0x560a99a3, 0x98591dc2), TOBN(0xc885fe8a, 0x4836664c),
+     TOBN(0xd18acd42, 0x26d79298), TOBN(0x05e4cd17, 0x185df1d7),
+     TOBN(0xebc60e21, 0xfcc83355), TOBN(0xc94dbc02, 0xd9119b77),
+     TOBN(0xceb05a31, 0x2f18ae9a), TOBN(0xa8462962, 0xb8f69016),
+     TOBN(0x58dde5a4, 0x8f67b5f4), TOBN(0xb8bdf9c9, 0xaf3c234d),
+     TOBN(0xe95c069f, 0x80e85df8), TOBN(0x9d525e1b, 0xab3aa0e5),
+     TOBN(0x73c8a92f, 0x76276d8b), TOBN(0x7feb4abd, 0x163530ef),
+     TOBN(0x8ca949b3, 0x5ef5ad73), TOBN(0xe129431e, 0x2e3d057b),
+     TOBN(0x9d8a925b, 0x60dec308), TOBN(0xb72e3efa, 0x6b3ea363),
+     TOBN(0x4f53ca6d, 0xdfb534b8), TOBN(0x4e64874c, 0x6dd78a32),
+     TOBN(0x336e5b46, 0xc2a146d5), TOBN(0x07c76d63, 0x98395201),
+     TOBN(0xa4c09522, 0x8fe3e815), TOBN(0x887e659d, 0x3221cc26),
+     TOBN(0x0ff92f64, 0xc36286ec), TOBN(0x57b1b903, 0xc3ebb08c),
+     TOBN(0xc6bdc9b6, 0x65f00c30), TOBN(0x82624226, 0x9a46d36e),
+     TOBN(0xc782c16c, 0x1a0b619a), TOBN(0x8643d42b, 0xbe316086),
+     TOBN(0x49d2966b, 0xc0daa421), TOBN(0x080b1caf, 0xb7b487e0),
+     TOBN(0x1d33bb53, 0x144de273), TOBN(0x8bafce2d, 0x6faf7ed9),
+     TOBN(0xdafbe3cf, 0x408d4636), TOBN(0xf10527df, 0x7ee8835b),
+     TOBN(0xe1123f3e, 0xe2e75522), TOBN(0xb388c64b, 0xebe27d60),
+     TOBN(0x2cb38dc1, 0xe3f1f55e), TOBN(0x57ff8e43, 0xe34524d8),
+     TOBN(0xd67dc92b, 0x85653dc8), TOBN(0x8e0970af, 0x0bc93ab9),
+     TOBN(0xb6f09baa, 0x8b87c0af), TOBN(0x5a8a9030, 0x52760ef4),
+     TOBN(0x2e2ae756, 0x1047bf85), TOBN(0xd049078f, 0x85bd4e74),
+     TOBN(0xced11ff8, 0x3729f708), TOBN(0xdd21cbeb, 0xd91068a6),
+     TOBN(0x83d488ff, 0x24b3e911), TOBN(0x6e166fda, 0x1afd2196),
+     TOBN(0x66a91211, 0x4f0d2128), TOBN(0xd11078ed, 0x05c9f39c),
+     TOBN(0xd87003d3, 0xbdbdf0cf), TOBN(0xe9750b5b, 0x56c298f1),
+     TOBN(0xc256c3a2, 0xb73ad05d), TOBN(0xe0779a19, 0x2ee94279),
+     TOBN(0x31d8b3c6, 0x279626a3), TOBN(0x469056bb, 0x90163bc8),
+     TOBN(0xe6aeabc6, 0x23755853), TOBN(0x9fffdfe2, 0x896a6f4c),
+     TOBN(0x15c1ce78, 0xa36cf41b), TOBN(0xd4c8c025, 0xeee41941),
+     TOBN(0xf7a917ee, 0x7653be9d), TOBN(0xfa3cba96, 0x59d52222),
+     TOBN(0x913f9207, 0x5f8ab132), TOBN(0xd5b6792c, 0x5c14080f),
+     TOBN(0xefab4e2c, 0x787c3594), TOBN(0xa55d465f, 0xe7b7b7dd),
+     TOBN(0x921aaad8, 0x34e28e6a), TOBN(0xc4f3a35e, 0x12d6a7bc),
+     TOBN(0x109803c4, 0x6115a5ae), TOBN(0xc023098c, 0xe709f9a1),
+     TOBN(0x1a8c8bdb, 0x99c5bb66), TOBN(0x1cd1c2b6, 0xbc7c2da7),
+     TOBN(0x50189c97, 0x5f927eef), TOBN(0x493823d1, 0x229f9410)},
+    {TOBN(0x11a8fde5, 0xf0ce2df4), TOBN(0xbc70ca3e, 0xfa8d26df),
+     TOBN(0x6818c275, 0xc74dfe82), TOBN(0x2b0294ac, 0x38373a50),
+     TOBN(0x584c4061, 0xe8e5f88f), TOBN(0x1c05c1ca, 0x7342383a),
+     TOBN(0x263895b3, 0x911430ec), TOBN(0xef9b0032, 0xa5171453),
+     TOBN(0x144359da, 0x84da7f0c), TOBN(0x76e3095a, 0x924a09f2),
+     TOBN(0x612986e3, 0xd69ad835), TOBN(0x70e03ada, 0x392122af),
+     TOBN(0x3ee0a31c, 0x6754f492), TOBN(0x02636c6b, 0x96769ff5),
+     TOBN(0x90a64f4f, 0xf0fbfa96), TOBN(0x513f054e, 0xfafea65a),
+     TOBN(0x796ba747, 0x9cf4b9f9), TOBN(0x3198c068, 0x932a9590),
+     TOBN(0x93af8a65, 0x549ee095), TOBN(0xb8b6f72c, 0xa212760f),
+     TOBN(0x23bc71e9, 0xc1a46c8f), TOBN(0x000643af, 0x4c9bca72),
+     TOBN(0xb6d967c7, 0x848cea30), TOBN(0xe06b6b4e, 0x73312ec2),
+     TOBN(0xfeb707ee, 0x67aad17b), TOBN(0xbb21b287, 0x83042995),
+     TOBN(0x26de1645, 0x9a0d32ba), TOBN(0x9a2ff38a, 0x1ffb9266),
+     TOBN(0x4e5ad96d, 0x8f578b4a), TOBN(0x26cc0655, 0x883e7443),
+     TOBN(0x1d8eecab, 0x2ee9367a), TOBN(0x42b84337, 0x881de2f8),
+     TOBN(0xe49b2fae, 0xd758ae41), TOBN(0x6a9a2290, 0x4a85d867),
+     TOBN(0x2fb89dce, 0xe68cba86), TOBN(0xbc252635, 0x7f09a982),
+     TOBN(0x52ec9956, 0x1d85a725), TOBN(0x0f9be000, 0xf3208012),
+     TOBN(0xe881337c, 0x6dcc7816), TOBN(0xe4e7b6d9, 0x791f7cf1),
+     TOBN(0xfaa717aa, 0x59885a42), TOBN(0xb1bbb5c7, 0xf9c01e41),
+     TOBN(0xcf208d58, 0xa0361880), TOBN(0x24426e40, 0x20afa350),
+     TOBN(0x7261871b, 0x264ce04a), TOBN(0x66be4a86, 0xcd42026a),
+     TOBN(0xc5397b77, 0x829f99fe), TOBN(0xffe4a6bc, 0x24578e2b),
+     TOBN(0xadc79436, 0x8c61aaac), TOBN(0x24c7fd13, 0x5e926563),
+     TOBN(0xef9faaa4, 0x0406c129), TOBN(0xf4e6388c, 0x8b658d3c),
+     TOBN(0x7262beb4, 0x1e435baf), TOBN(0x3bf622cc, 0xfdaeac99),
+     TOBN(0xd359f7d8, 0x4e1aeddc), TOBN(0x05dc4f8c, 0xd78c17b7),
+     TOBN(0xb18cf032, 0x29498ba5), TOBN(0xc67388ca, 0x85bf35ad),
+     TOBN(0x8a7a6aa2, 0x62aa4bc8), TOBN(0x0b8f458e, 0x72f4627a),
+     TOBN(0x0733667a, 0xf822d5f9), TOBN(0xd7f81b9e, 0x18339700),
+     TOBN(0x7ca29b27, 0xa7bc265f), TOBN(0x9fefa698, 0xeb4f0c7a),
+     TOBN(0x7b6f3513, 0x01f27630), TOBN(0x72f0f152, 0xfcfb1133),
+     TOBN(0x9928d9d0, 0x5c81eb14), TOBN(0xa16ac36b, 0xed8ff6cb),
+     TOBN(0x7fbd1acb, 0xe041bef3), TOBN(0x7d25159a, 0xf8d99854),
+     TOBN(0x2ec3a7d8, 0xdb5a0dc5), TOBN(0xd86fc4cc, 0x87e3e933),
+     TOBN(0x3fb812ee, 0xc68e4488), TOBN(0x53c5eaa4, 0x60ef7281),
+     TOBN(0xe5724183, 0x8fbefbe4), TOBN(0x2b7d49f4, 0xa4b24a05),
+     TOBN(0x23b138d0, 0x710c0a43), TOBN(0x16a5b4c1, 0xa85ec1db),
+     TOBN(0x7cc1f3d7, 0x305feb02), TOBN(0x52f7947d, 0x5b6c1b54),
+     TOBN(0x1bda2312, 0x8f56981c), TOBN(0x68663eae, 0xb4080a01),
+     TOBN(0x8dd7ba7e, 0x9f999b7f), TOBN(0xd8768d19, 0xb686580c),
+     TOBN(0xba8418f3, 0x4c20e15f), TOBN(0x7eed2494, 0xfb54404e),
+     TOBN(0x4e6438d7, 0xbce1e82d), TOBN(0x9e489b3e, 0xb397915b),
+     TOBN(0xa9baea9f, 0xfb4cf659), TOBN(0x8bc5b2ba, 0x42ef4aff),
+     TOBN(0xae3fb533, 0x7e62a188), TOBN(0xcd648493, 0x496e8e35),
+     TOBN(0x89728e28, 0xdefe047b), TOBN(0x63a8c679, 0xd24e60fe),
+     TOBN(0xadacbf92, 0x470f710c), TOBN(0xd470aeb9, 0x5e198d3c),
+     TOBN(0xbcd0e0ad, 0x7afdda94), TOBN(0x95a0dbbe, 0x34a30687),
+     TOBN(0xbbe3c3df, 0x8c5e2665), TOBN(0x742becd8, 0xebf2bc16),
+     TOBN(0x300ceb48, 0x3fa163a6), TOBN(0x0c5d02ee, 0x4663354b),
+     TOBN(0xe4fb9ad6, 0xb5e606a4), TOBN(0x93f507b8, 0xcf49ff95),
+     TOBN(0x9406a90c, 0x585c193b), TOBN(0xad1440c1, 0x4ecf9517),
+     TOBN(0x184cb475, 0x9cea53f1), TOBN(0x6855c474, 0x8ef11302),
+     TOBN(0x8e3807dd, 0x7a3e874a), TOBN(0xc4edb45b, 0x89ac3a99),
+     TOBN(0x9ba9cdaf, 0x4bfd77d2), TOBN(0x31d33f59, 0xb540fffc),
+     TOBN(0x404c8779, 0x0c60028b), TOBN(0x7f89da71, 0x89688c81),
+     TOBN(0xdd3390e5, 0x504b862b), TOBN(0xdf1e721b, 0xe937efe3),
+     TOBN(0x5833d0df, 0x63e6036f), TOBN(0x7712527a, 0x385fbab4),
+     TOBN(0x6347236b, 0xd210c0d4), TOBN(0x12d7733c, 0x8d238e2d),
+     TOBN(0x00ecb523, 0xedcafa52), TOBN(0x0da0ae0e, 0x086f69d3),
+     TOBN(0xc384de15, 0xc242f347), TOBN(0xfb050e6e, 0x848c12b7),
+     TOBN(0x22f67654, 0x64e015ce), TOBN(0xcbdc2a48, 0x7ca122f2),
+     TOBN(0xa940d973, 0x445fb02c), TOBN(0x00f31e78, 0x3767d89d),
+     TOBN(0x2b65a237, 0x613dabdd), TOBN(0x2be0ab05, 0xc875ae09),
+     TOBN(0xb22e54fd, 0xba204f8e), TOBN(0x65e2029d, 0x0f7687b9),
+     TOBN(0x0ecb0723, 0x302e943f), TOBN(0xd180ca1e, 0x4a443e78),
+     TOBN(0x39e78911, 0x23dd2c9e), TOBN(0xfa2a4404, 0x01fe50bb),
+     TOBN(0x4678e7ed, 0x154d39d1), TOBN(0x64ddaee1, 0xaf513e01),
+     TOBN(0x6d4c615a, 0x634904da), TOBN(0x937c6326, 0xba5c900c),
+     TOBN(0x70658f5f, 0xeb6c8582), TOBN(0x2a04fd51, 0xf3d65166),
+     TOBN(0xcefe7472, 0xb676eb47), TOBN(0xd3565a71, 0xf597d887),
+     TOBN(0xffd82538, 0x1855a71c), TOBN(0x26a330b3, 0x438bd8d8),
+     TOBN(0x89628311, 0xf9d8c5f9), TOBN(0x8d5fb9cf, 0x953738a0),
+     TOBN(0xcb7159c9, 0xedfcd4e5), TOBN(0xd64e5230, 0x2064c7c2),
+     TOBN(0xf858ed80, 0x689f3cfe), TOBN(0x4830e309, 0x56128b67),
+     TOBN(0x2e1692da, 0xe0e90688), TOBN(0xab818913, 0xca9cc232),
+     TOBN(0xe2e30c23, 0xa5d229a6), TOBN(0xa544e8b1, 0x0e740e23),
+     TOBN(0x299520f4, 0xe5dcba80), TOBN(0x522ad4b5, 0x2b758045),
+     TOBN(0x54eabe27, 0x193b36d4), TOBN(0xda4d3bff, 0x45e9e442),
+     TOBN(0x44cb9252, 0x637311f3), TOBN(0x4cd620a9, 0x71338ebf),
+     TOBN(0xec908157, 0xcc9524fb), TOBN(0x2731a11b, 0xa8c955d7),
+     TOBN(0x72a5e054, 0x5cb94009), TOBN(0x7eee8f3b, 0x9126cfe8),
+     TOBN(0xc71e2920, 0x3dd5d5ce), TOBN(0xe886f91a, 0x22069494),
+     TOBN(0x1c15e569, 0xdc61e6cc), TOBN(0x8fd72967, 0x58fc7800),
+     TOBN(0xe61e7db7, 0x37a9dfc5), TOBN(0x3f34a9c6, 0x5afd7822),
+     TOBN(0x0a112742, 0x19e80773), TOBN(0xa353460c, 0x4760fc58),
+     TOBN(0x2fb7deeb, 0xb3124c71), TOBN(0x48463627, 0x2d4009cc),
+     TOBN(0x399d1933, 0xc3a10370), TOBN(0x7eb19450, 0x54388dbd),
+     TOBN(0x8ecce639, 0x7c2a006a), TOBN(0x3d565daf, 0x55c932a0),
+     TOBN(0x294d2955, 0x0db962c0), TOBN(0xd6994ef4, 0x6d523ab0),
+     TOBN(0xfa1a7f91, 0x58f95037), TOBN(0xb1379811, 0x64420c94),
+     TOBN(0x2b686e1e, 0x093caea8), TOBN(0xdef10944, 0xf9e1c340),
+     TOBN(0xcd1beecf, 0x611d9bf5), TOBN(0x34696c50, 0xa1b5267b),
+     TOBN(0xcecbc719, 0x2dfc2b16), TOBN(0x2cdb955d, 0xcee7e854),
+     TOBN(0x9fefc321, 0xf2635cc8), TOBN(0x276d2e4f, 0x2936f7d3)},
+    {TOBN(0x4962c021, 0x67141724), TOBN(0x5f81eabe, 0xabe7762f),
+     TOBN(0x78549a79, 0xdd189c3f), TOBN(0x47675cdd, 0x6ce517a7),
+     TOBN(0x5102294e, 0x32d6bb97), TOBN(0xb19500c6, 0x6ed1a029),
+     TOBN(0x3efb54e8, 0xb16a206c), TOBN(0x7dbdcc25, 0x0dc135b8),
+     TOBN(0x955bc294, 0x8967fb04), TOBN(0x373615c9, 0xbe04e909),
+     TOBN(0xf1fcf820, 0x111efad6), TOBN(0x8530f97d, 0x6fd2e97a),
+     TOBN(0x3f2b5bd4, 0xb4805410), TOBN(0x201ca7a9, 0xf96c5ee7),
+     TOBN(0x532ef2db, 0x94256fe1), TOBN(0xacbfc459, 0x318ddb03),
+     TOBN(0x2375f9fd, 0x5f24c8e1), TOBN(0xd27c479b, 0x370783db),
+     TOBN(0x1bd461e8, 0x56541ae6), TOBN(0x78f054a7, 0x7f7ea49a),
+     TOBN(0xc9f8777d, 0x8845f315), TOBN(0x81aed296, 0x97fc92c7),
+     TOBN(0x9f2f8d79, 0x49929540), TOBN(0x7531e78b, 0xff5ebfe0),
+     TOBN(0xbd9a66d6, 0x543b3e41), TOBN(0x2948c0a6, 0x2ae73774),
+     TOBN(0xa75151df, 0xef38e9b3), TOBN(0xa3348ae5, 0x754fb3fb),
+     TOBN(0x1218fa8f, 0x13069b72), TOBN(0x532bb051, 0x0835dfaf),
+     TOBN(0x2121a98e, 0xdf2be3c6), TOBN(0x85980de6, 0x9e5199bc),
+     TOBN(0x1b23a4be, 0x1a1eb6ee), TOBN(0xb5c48b92, 0xadeb3ae5),
+     TOBN(0xeebd305d, 0xedea2b45), TOBN(0x20543f04, 0xc37198ea),
+     TOBN(0xd0960bd8, 0x0fab968c), TOBN(0x6899e4fa, 0xae028db0),
+     TOBN(0x975ccc77, 0xa9850916), TOBN(0xb41bd531, 0xe5f81554),
+     TOBN(0xbdf8ab57, 0xc8cff2c8), TOBN(0xea306a01, 0xf5822be3),
+     TOBN(0x1f0ac0e7, 0xbefbdbbe), TOBN(0x72f4b0e9, 0x60519f87),
+     TOBN(0x22bd8b82, 0xe3cc86ab), TOBN(0xc43bde8d, 0x2b2beaee),
+     TOBN(0x8168781e, 0x412617ff), TOBN(0xc5610627, 0xb7ee7096),
+     TOBN(0xc4085538, 0x40671bd2), TOBN(0xccb74902, 0x599f8eba),
+     TOBN(0x477a4a09, 0x8d65e832), TOBN(0xc620c314, 0xf1241626),
+     TOBN(0x05f2f152, 0xe7344054), TOBN(0x2483a2d9, 0x6d83320d),
+     TOBN(0x167439d7, 0x0e344da8), TOBN(0xa0c02b1b, 0x1002fb36),
+     TOBN(0x46cb4a70, 0x30afbda2), TOBN(0xe74e3488, 0x229d4efe),
+     TOBN(0xd371dce2, 0x1cef3aec), TOBN(0x96e0592c, 0x7c3f2521),
+     TOBN(0xdec0e091, 0xcc5f4a6e), TOBN(0x055ff295, 0x201108d0),
+     TOBN(0x2b371998, 0xdc202800), TOBN(0x1b650d83, 0x0d5f5f9d),
+     TOBN(0x29be5503, 0xa0226262), TOBN(0x0f3681ac, 0x185bf3f1),
+     TOBN(0x4f5c44b4, 0x8c3e2c4f), TOBN(0xcfe74a51, 0x717814fd),
+     TOBN(0xb0ce4183, 0x7b52a561), TOBN(0xde143e3a, 0xee634895),
+     TOBN(0x08f83100, 0x48d46b2f), TOBN(0x34b79d55, 0x6386486d),
+     TOBN(0xa60659c4, 0xee1388ba), TOBN(0x475a4d06, 0x7eca29dd),
+     TOBN(0xf1ef88c1, 0x66470e08), TOBN(0x71cac87a, 0x687c716a),
+     TOBN(0x994fb1ee, 0x86f43fff), TOBN(0x53ded2ef, 0x43384658),
+     TOBN(0x317d9024, 0x56c41587), TOBN(0x6807f0ad, 0x9dea0f26),
+     TOBN(0xfee8beaa, 0xa0b0d53b), TOBN(0x15c06a1f, 0xb0288c94),
+     TOBN(0x4b9eab03, 0x47028bce), TOBN(0x6d214435, 0x1446bc6e),
+     TOBN(0x0869457a, 0x01a8eb44), TOBN(0x52223985, 0x7a7bedd7),
+     TOBN(0x2c04b0c6, 0x00057505), TOBN(0x468be6e8, 0x0b09adeb),
+     TOBN(0x2f3bf32b, 0x6f81474f), TOBN(0xf54f949d, 0xa712ccce),
+     TOBN(0x292cee42, 0x4cdd8f2a), TOBN(0x3d9fdf6b, 0x9c221be1),
+     TOBN(0xe54da661, 0x56f47b2a), TOBN(0x2ca76835, 0x840b5d1b),
+     TOBN(0xb52adb6a, 0x8a6e8cf6), TOBN(0x8b416a6b, 0xdade153e),
+     TOBN(0xb8c3a138, 0x3fd55732), TOBN(0x4b348243, 0x2fd63498),
+     TOBN(0x60cc7a0f, 0xf52c44d3), TOBN(0x9787f356, 0x9422c87e),
+     TOBN(0x0fae6177, 0x60ad9f57), TOBN(0xb9ac12d8, 0x82e307c4),
+     TOBN(0x52316618, 0x79416b16), TOBN(0xe603cb9a, 0x91611196),
+     TOBN(0x0ce22a84, 0xe34c3a39), TOBN(0xcb191237, 0x5b2dca8b),
+     TOBN(0xcb87c227, 0x9e5b750a), TOBN(0x7feccba0, 0x13a02f00),
+     TOBN(0xd3a66685, 0xa3cd6034), TOBN(0x74ad77ad, 0x3a283c3a),
+     TOBN(0x0c903afb, 0x66644cd0), TOBN(0x34e18018, 0xc1f90202),
+     TOBN(0x8fa168e7, 0x0008aa04), TOBN(0x871573df, 0xbe8e35ae),
+     TOBN(0x8841591e, 0xf4561f77), TOBN(0x55e3033d, 0xc6cd0f01),
+     TOBN(0x44327c97, 0xfe1fa6ff), TOBN(0xed4e69d6, 0xdddfcba8),
+     TOBN(0xe82e1e42, 0x52d907ec), TOBN(0x8a5d9a71, 0x79064b8d),
+     TOBN(0xa47a884c, 0xc26f1000), TOBN(0x9f047634, 0x44a4b7cb),
+     TOBN(0xa5a2bf4e, 0x89813d5f), TOBN(0x83ce02c9, 0xd8e9318d),
+     TOBN(0xf2731254, 0x2c86c874), TOBN(0xb76a3096, 0x02a0813f),
+     TOBN(0x1fabaa2d, 0x0c8b505d), TOBN(0xad693de0, 0x4895425b),
+     TOBN(0xaf7f5848, 0xa55ff754), TOBN(0x098a328f, 0xeadfa222),
+     TOBN(0x4c20adfb, 0x470c5898), TOBN(0xe4b23ead, 0x5d199733),
+     TOBN(0x37b29ca7, 0x9a605b1a), TOBN(0x2ca364f6, 0x30caed34),
+     TOBN(0x1e538aae, 0x3c2ff02f), TOBN(0xc10c493c, 0x42c6a320),
+     TOBN(0x92f18f28, 0xa2b9e130), TOBN(0xaf249c41, 0xdd0ed08f),
+     TOBN(0x42039a52, 0x70285f2f), TOBN(0x4e502f2e, 0xcfd3ebb0),
+     TOBN(0x42821914, 0x6e39b30f), TOBN(0xdbc809f1, 0x70e820ca),
+     TOBN(0xbccb5567, 0xd2781e34), TOBN(0x8c1e3bfc, 0xbe3d05dd),
+     TOBN(0xa29f0b65, 0x43eeed0a), TOBN(0x0b96b6a1, 0xfd8b3697),
+     TOBN(0xc2454ada, 0x88f8755a), TOBN(0x57202337, 0xaf85d4ac),
+     TOBN(0xaddfc388, 0xa7aaef40), TOBN(0xc1495163, 0xb156a5fc),
+     TOBN(0x67abbbcb, 0x1f1a8775), TOBN(0xb83e3dd6, 0x5958bb8b),
+     TOBN(0x17119d02, 0x36dbf23c), TOBN(0xeb336460, 0xb954337a),
+     TOBN(0x9b101001, 0x6f46dca7), TOBN(0xef862ae8, 0xbc991dbe),
+     TOBN(0xaa878db5, 0x66befae3), TOBN(0x28bb9c9e, 0x05110c6f),
+     TOBN(0xc3a57a8c, 0x4caa069a), TOBN(0xbb5b550e, 0x594a2753),
+     TOBN(0x01ab8056, 0x5187afb8), TOBN(0x1f7c9ed3, 0xb9255f65),
+     TOBN(0xcd669e2b, 0x146f6635), TOBN(0xa8f2d4b6, 0xcb9457a3),
+     TOBN(0x0f0541aa, 0x849dba46), TOBN(0x2537bf02, 0x2cc9c7e9),
+     TOBN(0x872b4f59, 0xd79ac77e), TOBN(0x705c2219, 0xe0a44aa9),
+     TOBN(0x03b42dbb, 0x3849051d), TOBN(0xe2efcfe3, 0xf27a63a6),
+     TOBN(0xf709a5ff, 0xceb478c2), TOBN(0x2cc86b82, 0xc4f7feda),
+     TOBN(0xefa834e4, 0x066a1c08), TOBN(0x153b64ef, 0x309fd644),
+     TOBN(0x8cff4eb0, 0xe62168ff), TOBN(0x0d7781db, 0x095d9f3b),
+     TOBN(0x01f8e1af, 0x10bce338), TOBN(0x14aa9a02, 0x139d8f2b),
+     TOBN(0x1985d844, 0x259ec819), TOBN(0xd7758b21, 0x3a072e8e),
+     TOBN(0x65f7d2c1, 0x8565afc9), TOBN(0x764c8971, 0x70fa7b82),
+     TOBN(0xe268634c, 0x986436f2), TOBN(0x6334d8d1, 0x33356165),
+     TOBN(0xf1716426, 0x9ec7957d), TOBN(0xae834331, 0xb8093983),
+     TOBN(0xedb1fe5c, 0xd2dfcce7), TOBN(0x6195b863, 0x68463e5c),
+     TOBN(0x746e5f4d, 0xa691b665), TOBN(0x61171291, 0xe1e2727e),
+     TOBN(0xbb4aa8f1, 0x6f27b029), TOBN(0x1037657d, 0x7f42c197)},
+    {TOBN(0xfe19901b, 0x0d5b855a), TOBN(0x5facb955, 0x2f745022),
+     TOBN(0x92fd0125, 0x56c4ce5c), TOBN(0x23172d65, 0x938c89ab),
+     TOBN(0xa71f8a33, 0xaaa587b1), TOBN(0x511a3745, 0xb55c9c50),
+     TOBN(0xec005f6a, 0x7185086e), TOBN(0x6dfc2761, 0xf894c6ab),
+     TOBN(0x98a4d67f, 0x9e26361f), TOBN(0x7f0a2b23, 0x21389c25),
+     TOBN(0xd1588207, 0x95ffbcee), TOBN(0x4d6b29ab, 0x9f36a888),
+     TOBN(0xeccb421e, 0xd0a701a5), TOBN(0xad4cb9a5, 0xb60cd286),
+     TOBN(0xd344da9e, 0x05a53972), TOBN(0x3a8035e0, 0x7bc99fea),
+     TOBN(0xe0214485, 0xc0f77bf5), TOBN(0x50ada30e, 0xe54df78a),
+     TOBN(0xdef45af6, 0x4ec2d576), TOBN(0xa05d6184, 0x5f9a8678),
+     TOBN(0xa9b17db1, 0xc337e017), TOBN(0x026a4f66, 0xb84671d5),
+     TOBN(0x60614234, 0x3b7d696d), TOBN(0x71ed9aaf, 0x81cfd22a),
+     TOBN(0x1b76a3c5, 0x439ada39), TOBN(0x818829cf, 0x89236ae5),
+     TOBN(0x2277cb7a, 0x750f8129), TOBN(0x44aa462a, 0x4d46502b),
+     TOBN(0x7a12e1e1, 0x64f06dc8), TOBN(0xb9a3300d, 0xba5630cf),
+     TOBN(0xd2cc8d9c, 0x55b05f4b), TOBN(0x6d0b0b88, 0xa700be7a),
+     TOBN(0xa7be9969, 0x9617500c), TOBN(0x2b5b8dea, 0xc03f8a50),
+     TOBN(0x712f703e, 0x785b3dfd), TOBN(0x96a5a60a, 0xccf93950),
+     TOBN(0xfeb984b3, 0xee828fba), TOBN(0x8273f830, 0xe2bd188c),
+     TOBN(0x177ef97e, 0x3ca0a99f), TOBN(0x76d4796d, 0xacc000ac),
+     TOBN(0xbad0fa6e, 0xb140f51a), TOBN(0xb2756567, 0x06ebc810),
+     TOBN(0xf89eb78f, 0xa18cb32f), TOBN(0xcfc37eae, 0xa65285b0),
+     TOBN(0xe2b29cfb, 0xb25e9d1b), TOBN(0x9388ea8f, 0xb4e7aef3),
+     TOBN(0xee606c12, 0xe267e845), TOBN(0x6b103c54, 0x9f5806d7),
+     TOBN(0xf418e3f6, 0x3766f2ae), TOBN(0x4a3ad3c8, 0x053ef1c1),
+     TOBN(0xd01e5b5b, 0x560db262), TOBN(0xa583edc7, 0xc02bf4c3),
+     TOBN(0x7c9f7060, 0x52f318d3), TOBN(0x0852556f, 0x1f5e1ffe),
+     TOBN(0xe1c70aa7, 0xfeb0e63c), TOBN(0x59f0a3f9, 0x89a8c058),
+     TOBN(0x4aa4cf02, 0x1ffc0ade), TOBN(0xbb880e41, 0x38a78632),
+     TOBN(0x35b0f759, 0x6f28f096), TOBN(0xf9c4fe17, 0xd5757d7d),
+     TOBN(0x78b8879c, 0xfd6376eb), TOBN(0x22a76461, 0xc01e1edb),
+     TOBN(0x6a44be39, 0x369cf0c4), TOBN(0x6653670d, 0x5ae54539),
+     TOBN(0x257bd751, 0x6fb43ad0), TOBN(0xb3ac3715, 0x12baffdd),
+     TOBN(0x48659d61, 0x7548eabb), TOBN(0xd8f931f8, 0x0cd468cb),
+     TOBN(0x98f02415, 0x49e3b531), TOBN(0x90b0d716, 0x70df011f),
+     TOBN(0x26d73c54, 0xab98f066), TOBN(0x06591ec9, 0x88475d5e),
+     TOBN(0x627f6328, 0x412b84c3), TOBN(0xd427e977, 0xa04545d2),
+     TOBN(0x5b0145bc, 0x104f25c2), TOBN(0xa6931c4f, 0x2ac7ad62),
+     TOBN(0x40761143, 0x1f8d42f5), TOBN(0xfda5a76b, 0xe7f8a0b3),
+     TOBN(0x4f1ca5cf, 0xfe0946b9), TOBN(0x6def7b9f, 0xbeb2d427),
+     TOBN(0x984bd4bb, 0xc9a0d136), TOBN(0xb9a77823, 0x5b3af1c1),
+     TOBN(0x04ee66ae, 0x38ac2087), TOBN(0x63374ed9, 0x26d9dbb9),
+     TOBN(0xcf947c06, 0x44ba39e6), TOBN(0xf5d5216c, 0xedfe78d7),
+     TOBN(0xd00115c0, 0x5f1835c9), TOBN(0xdf084152, 0xd8c79d90),
+     TOBN(0xc0c3a684, 0x6db5f791), TOBN(0x40514451, 0x749b18cd),
+     TOBN(0xd314b7d5, 0x734df3f1), TOBN(0xbccdd3f0, 0x7f541415),
+     TOBN(0x97ed5af0, 0x6855a942), TOBN(0xea84ae9e, 0xe9d02ab9),
+     TOBN(0xb87e9034, 0x3238a5d0), TOBN(0xd12d25c3, 0x650a0eab),
+     TOBN(0x1473b55b, 0x86a515a9), TOBN(0xa9e3230a, 0x3b337c64),
+     TOBN(0x7e8bf904, 0x9db668f1), TOBN(0x1db2c25e, 0xf27f9fc9),
+     TOBN(0x0c108607, 0x2d9e467e), TOBN(0x4505579a, 0xa3f00d52),
+     TOBN(0xe2ad661b, 0x240400a7), TOBN(0x8022294c, 0x11af4874),
+     TOBN(0x29e90370, 0x78bba8e8), TOBN(0xbf0fbf08, 0xf6baca04),
+     TOBN(0x2e46d2b7, 0x4101fab0), TOBN(0x66065490, 0xc61089e6),
+     TOBN(0x2131ce5b, 0x09f8a1cb), TOBN(0x7b373ed2, 0x8ab129e2),
+     TOBN(0x463cc8d6, 0x77c1292a), TOBN(0xa9b7cf65, 0x94ffe9c5),
+     TOBN(0x129125ce, 0xb99bfc4f), TOBN(0x819b4284, 0x9820d323),
+     TOBN(0x3f709763, 0x76541a41), TOBN(0xfd679ae5, 0xe32c7a7b),
+     TOBN(0xc39a208d, 0xf65b6b3c), TOBN(0x1c22ebc0, 0x50002745),
+     TOBN(0x268f19dd, 0xe2bcd202), TOBN(0xfeac809c, 0x9c3d4266),
+     TOBN(0x07467837, 0x87dcdbdb), TOBN(0x4cce33be, 0x320493d8),
+     TOBN(0x9ab08cbe, 0x713c7746), TOBN(0xd6f0c1de, 0x9c6dc5cb),
+     TOBN(0x19400538, 0x2ac03761), TOBN(0x3fc11f38, 0xd0547be5),
+     TOBN(0x66b378ce, 0x819fe3fd), TOBN(0x6a590acc, 0x3700fe7e),
+     TOBN(0x4c976a72, 0x8924b396), TOBN(0xa5006d8d, 0x70b9b250),
+     TOBN(0x2fdce1b2, 0x12b85f9c), TOBN(0x5858f7ce, 0x495f8f1c),
+     TOBN(0x357540ab, 0x903ff177), TOBN(0x225280b8, 0x276af514),
+     TOBN(0x33d273ac, 0x14d7fed3), TOBN(0xfef6b9ff, 0xd186ee3d),
+     TOBN(0xa94c2071, 0x01a7b1d9), TOBN(0x4ea36274, 0x50bc8bc2),
+     TOBN(0xc68959c9, 0xfa98a918), TOBN(0x8f5eccee, 0xc7bdc262),
+     TOBN(0x7a73a4fc, 0xe6861310), TOBN(0x19bcac90, 0xc828330f),
+     TOBN(0x73e3b66f, 0x7ef74fdb), TOBN(0x60f76983, 0x52d8f2f4),
+     TOBN(0xab357804, 0x7e03a14e), TOBN(0x0f4f2868, 0x8caf673f),
+     TOBN(0x919e661e, 0x66530425), TOBN(0x28da445c, 0x91ba47c5),
+     TOBN(0xd6d05375, 0x66c394fe), TOBN(0xfe1864a3, 0x02e8ae91),
+     TOBN(0xd34baca2, 0xa753aec4), TOBN(0x43b7ffe7, 0xa2c8d292),
+     TOBN(0x496659eb, 0x04efb8f1), TOBN(0x310ec2a9, 0xe0252dfd),
+     TOBN(0x98173d2f, 0x9168a80e), TOBN(0xa3e018d6, 0x31497255),
+     TOBN(0x3266c887, 0xd9d9284a), TOBN(0x690f818b, 0x73646ab7),
+     TOBN(0x67315ec6, 0xaf7fc33b), TOBN(0x181e61ab, 0xc30b1ccb),
+     TOBN(0x1b81e6cd, 0x105a9e1c), TOBN(0x62a15daf, 0x5078b9bb),
+     TOBN(0x74f9840f, 0x6fa8cc65), TOBN(0x356b7774, 0x43388573),
+     TOBN(0xba0f7d05, 0x06b3fd46), TOBN(0xb0ac864c, 0x92b4fdad),
+     TOBN(0xcdeac253, 0xef192cde), TOBN(0x0c24810b, 0xc313b4a7),
+     TOBN(0xef8c40bf, 0x1adb09b7), TOBN(0x2efeb49c, 0x0b74992a),
+     TOBN(0x3f0f8a41, 0x2b79957f), TOBN(0x08927bfe, 0x87a06873),
+     TOBN(0x1f63a410, 0x9288cb9a), TOBN(0x8c66fb70, 0xdf2b373a),
+     TOBN(0x98da4712, 0x980facae), TOBN(0x15ce5b17, 0xd819d026),
+     TOBN(0x097571a5, 0x749a671a), TOBN(0x85a40804, 0x894dd269),
+     TOBN(0x3e89c13c, 0x34cb6797), TOBN(0x2d19d5e4, 0xd07119a4),
+     TOBN(0x58225208, 0xecbafb80), TOBN(0x4f212035, 0xaa73d6de),
+     TOBN(0x1224e455, 0x62fe86db), TOBN(0xa8c8a478, 0x2dc5b2f1),
+     TOBN(0x8a957b8d, 0xc3096555), TOBN(0x6a3248b0, 0xb1591452),
+     TOBN(0x1e563c58, 0xcb604c18), TOBN(0x32808cb5, 0x9bf1045e),
+     TOBN(0xf8f62de9, 0x9462e7a2), TOBN(0x6b3dfe91, 0xc2489214),
+     TOBN(0x6c1d8fc4, 0x2174639c), TOBN(0xdfca11b8, 0xef88d4b5)},
+    {TOBN(0x5a4a5ce4, 0x18690ad0), TOBN(0xd0f788e0, 0xfe27f51a),
+     TOBN(0xd459388e, 0x4efe9a30), TOBN(0x3a45c11a, 0xef9d074b),
+     TOBN(0xf68ab50b, 0x93ab9cb0), TOBN(0x62fbc397, 0xecd9a566),
+     TOBN(0xbfb79b7f, 0xcc587a7e), TOBN(0xfcf4d66f, 0x92870bae),
+     TOBN(0x4f31aa21, 0x877390f0), TOBN(0x2de0c645, 0xe314cfb5),
+     TOBN(0x56d904f6, 0x238eab12), TOBN(0x4d104a42, 0xccb4d4f6),
+     TOBN(0x3eb83a87, 0x29358cd3), TOBN(0xad741295, 0xb9c6d430),
+     TOBN(0x57b8c77a, 0x53abe4e9), TOBN(0x0a14673e, 0xbb9feb82),
+     TOBN(0xc0a6cbf7, 0xf26f922e), TOBN(0x213de299, 0xa32e526c),
+     TOBN(0xca417e67, 0x7b6ca858), TOBN(0x8d6ae0f7, 0xfc2e0900),
+     TOBN(0x2bae0e7a, 0x62e135dd), TOBN(0x962bdcae, 0xa7ee82c7),
+     TOBN(0x573d7f6a, 0xe5776c74), TOBN(0x9c4de649, 0x6ffbefeb),
+     TOBN(0x8c962fc8, 0x09335d38), TOBN(0x26d1bc81, 0xeb38d176),
+     TOBN(0xe1aeb295, 0xc47711ed), TOBN(0x0812b992, 0x6cbe3e4e),
+     TOBN(0xeecacaf9, 0x0ab9805d), TOBN(0x82fefbaa, 0x3521a0ad),
+     TOBN(0x3a6948c0, 0xe2c31b9d), TOBN(0xb7d3905b, 0xe82daf2b),
+     TOBN(0xbd3ac90e, 0x25a34c37), TOBN(0x55afd99b, 0x61453063),
+     TOBN(0x56d87cd1, 0x90b99303), TOBN(0xc9bf82dd, 0x97ddb0a3),
+     TOBN(0xcbc0bb19, 0x68916917), TOBN(0x0bbb9f92, 0x1094bf88),
+     TOBN(0xf62cb350, 0xd3806442), TOBN(0xe4d2f1cc, 0x397a7602),
+     TOBN(0xa54bd48e, 0x43987d82), TOBN(0x77b6f831, 0x4f0a19fa),
+     TOBN(0xfa0c9a45, 0x6e766443), TOBN(0x995ae0ff, 0xf51ba70b),
+     TOBN(0x8e242c5b, 0x9cbd8d33), TOBN(0x1671eb08, 0x13d97956),
+     TOBN(0xccae388f, 0x40da55fa), TOBN(0x97cc48fa, 0xf376dce5),
+     TOBN(0x1c2919bb, 0xe8c91718), TOBN(0x9dbb727a, 0x5097bde3),
+     TOBN(0x23f87ae7, 0xf8ea2fb2), TOBN(0xe1bfffdc, 0xba310121),
+     TOBN(0x5938c50c, 0x75329669), TOBN(0x716c63e0, 0x0549855c),
+     TOBN(0xe091b0c9, 0x654814f0), TOBN(0xa20535d1, 0x0e43daee),
+     TOBN(0x16ce68b2, 0x593ddd04), TOBN(0x7813a49a, 0xf59900bd),
+     TOBN(0xef0d3eec, 0xd3e5d232), TOBN(0xe7d12cc4, 0x0ee3fd4d),
+     TOBN(0xe54d92cd, 0xef01fc5f), TOBN(0xc46c2ab8, 0xdda2e25a),
+     TOBN(0x7c907fd2, 0x849f6142), TOBN(0xbb11dd2d, 0xacd0202d),
+     TOBN(0xa4913a70, 0x1d92d19a), TOBN(0xe9a26ae0, 0xcf610677),
+     TOBN(0xfff1e1d5, 0x538943c5), TOBN(0x5943dcc4, 0xa47b2204),
+     TOBN(0xcafcf33a, 0x92cabf71), TOBN(0xd571e13c, 0xe329d1ad),
+     TOBN(0x7626ad23, 0x7a9a0e4c), TOBN(0xf0aa0d9f, 0x130d7f86),
+     TOBN(0x09df3a44, 0x19e6aa7e), TOBN(0xe27ad047, 0x5841b1cd),
+     TOBN(0x02d2a69f, 0xbde75934), TOBN(0xb0e05e53, 0xfd9ba435),
+     TOBN(0x4732d88a, 0xe008c16e), TOBN(0xdebc4777, 0xea72110d),
+     TOBN(0xccb7d993, 0x2e3143ad), TOBN(0x674f3753, 0xea8cd06a),
+     TOBN(0x56012a7a, 0x051562cf), TOBN(0x961df684, 0x25f74cd6),
+     TOBN(0x26630e71, 0x214d8a95), TOBN(0x584e8d63, 0x65d92f84),
+     TOBN(0x8a89daef, 0xebc5557c), TOBN(0x7ca71403, 0x275e1649),
+     TOBN(0x48d92377, 0x5b80bb4a), TOBN(0x0a587c52, 0xa45b3626),
+     TOBN(0xdaff503c, 0xc75bfe91), TOBN(0xd845d3e6, 0x116d07d7),
+     TOBN(0x6b5a4715, 0xa51eeca2), TOBN(0x34ac02bd, 0x74481991),
+     TOBN(0x8f076cfc, 0x595abf8d), TOBN(0xc9de4ce9, 0xed0391ce),
+     TOBN(0xaaaad03a, 0xe1fcabd3), TOBN(0x8d48ec00, 0x87b199ed),
+     TOBN(0xbd0f2653, 0xae5dd482), TOBN(0x59f968dd, 0x060032dc),
+     TOBN(0x6bea33e0, 0x67283310), TOBN(0xccce88cc, 0x012aa50c),
+     TOBN(0xbb6d7f2f, 0x66838f46), TOBN(0xb764c95f, 0x05ec9bcb),
+     TOBN(0xd097b604, 0x51477cca), TOBN(0xc2fbda7b, 0x82b20a85),
+     TOBN(0x75fe07a4, 0x24e9ca8d), TOBN(0xfc4fa824, 0x0cc40d01),
+     TOBN(0x0b17d5f9, 0x0c0e95f7), TOBN(0x285e6e8a, 0x6e1e46dc),
+     TOBN(0xb0641d09, 0xbc9b2654), TOBN(0xf9fcc2e6, 0x8aa8fa35),
+     TOBN(0xd12a5b4b, 0x00d5ec6e), TOBN(0x9be1a111, 0x5569d89a),
+     TOBN(0x9c0566de, 0xffac7208), TOBN(0x7a9fd4ff, 0x7034edf1),
+     TOBN(0x636aeb6b, 0x9571c375), TOBN(0x60d05aec, 0x55cdf187),
+     TOBN(0xf4e2f898, 0x734e9d2f), TOBN(0xdaf74219, 0x5ccdc6bc),
+     TOBN(0x9d39249f, 0x608a4f28), TOBN(0xb5f1bb5e, 0x8820e2c3),
+     TOBN(0xd02e9936, 0xd9589548), TOBN(0x8f1bf575, 0x5341402f),
+     TOBN(0x1535a443, 0x057300aa), TOBN(0x3062478e, 0x65d29324),
+     TOBN(0x4203351f, 0xc656a3f3), TOBN(0xbeb21b51, 0x6569c4ff),
+     TOBN(0x8113ce70, 0xe1f0f263), TOBN(0x59d12939, 0x03f9320c),
+     TOBN(0x95061255, 0xd08f8936), TOBN(0x8be3c0f9, 0x97d4b705),
+     TOBN(0x0259742e, 0x827837c2), TOBN(0xf55ea28d, 0x95c65cda),
+     TOBN(0x62024812, 0x603dc3dc), TOBN(0x25dc5337, 0xefd67b57),
+     TOBN(0x86b3eb38, 0xd7f033fd), TOBN(0xee3226b2, 0x32646d6f),
+     TOBN(0x8c4825f6, 0xf1dae596), TOBN(0xd2303055, 0xa5bcb8e5),
+     TOBN(0x904a5349, 0x3c0baa76), TOBN(0xe60f6125, 0xe08646a7),
+     TOBN(0xaf6a329f, 0x21d45f89), TOBN(0xf20ad88a, 0x06605546),
+     TOBN(0xcf7a0e96, 0x19a93d14), TOBN(0xf1eabcc8, 0x91c97174),
+     TOBN(0x72b76e9e, 0x8f02af51), TOBN(0xac94cbf1, 0xd580f95a),
+     TOBN(0x2e9cd748, 0x01d854a4), TOBN(0x4ed4e906, 0x1f08a1bc),
+     TOBN(0x0a2b2841, 0x9d2bd936), TOBN(0xbf863500, 0x51c89dda),
+     TOBN(0x9407b0e7, 0xe3f00bf5), TOBN(0x6b1f71ff, 0x28b57ac1),
+     TOBN(0xc1dfe03f, 0xcd28801f), TOBN(0xf3d83d64, 0xafa55309),
+     TOBN(0x47aafba2, 0x8af8f76f), TOBN(0x54eed45f, 0x6604b2e9),
+     TOBN(0x59edd264, 0x0f3e541f), TOBN(0x318674b5, 0x82b76ba8),
+     TOBN(0xbf4a0d30, 0x4e7f0716), TOBN(0x36fc0e41, 0x19b88200),
+     TOBN(0x91db5602, 0x40da801e), TOBN(0x638371ad, 0x2c72c2c7),
+     TOBN(0xfe960c25, 0xd5822da7), TOBN(0x7a7571d1, 0x4a7415e1),
+     TOBN(0x5a6480fe, 0xbccc1576), TOBN(0x72f4e5e5, 0xc3c88f47),
+     TOBN(0x224e7e74, 0x9a7bd8ec), TOBN(0x3ebbf52c, 0x7631455e),
+     TOBN(0xae3c2bc0, 0x8608ab37), TOBN(0x35e3da8c, 0x39f336b6),
+     TOBN(0x74136642, 0x81f44511), TOBN(0x21ce7c51, 0x1d8506e7),
+     TOBN(0x9b6718b3, 0x846165f1), TOBN(0x9e455007, 0xf5cabf6a),
+     TOBN(0xec582a0e, 0x02611073), TOBN(0x269aa18d, 0x83bf042e),
+     TOBN(0x7c54fb7c, 0x86306757), TOBN(0x45333602, 0x1b948faf),
+     TOBN(0xd3a5c508, 0xb7025d73), TOBN(0xcd6e555b, 0x428471e4),
+     TOBN(0x42c9fad5, 0x11a224e6), TOBN(0x6b6aeb8b, 0x69b2ac26),
+     TOBN(0x0cf4c7fd, 0xb149854b), TOBN(0x4a7d9000, 0x2fc359eb),
+     TOBN(0x9ff0c3ea, 0x29ec8603), TOBN(0x157ae785, 0x9b24ee14),
+     TOBN(0x638c809a, 0x8979e9bb), TOBN(0x347dfb2e, 0x7869d8c5),
+     TOBN(0x2fb1e0f8, 0xa07ea547), TOBN(0x1e580d32, 0xaecdec3f),
+     TOBN(0xbbf89573, 0x0f74025b), TOBN(0xeb94d71b, 0xdd529164)},
+    {TOBN(0xfa2db51a, 0x8d688e31), TOBN(0x225b696c, 0xa09c88d4),
+     TOBN(0x9f88af1d, 0x6059171f), TOBN(0x1c5fea5e, 0x782a0993),
+     TOBN(0xe0fb1588, 0x4ec710d3), TOBN(0xfaf372e5, 0xd32ce365),
+     TOBN(0xd9f896ab, 0x26506f45), TOBN(0x8d350338, 0x8373c724),
+     TOBN(0x1b76992d, 0xca6e7342), TOBN(0x76338fca, 0x6fd0c08b),
+     TOBN(0xc3ea4c65, 0xa00f5c23), TOBN(0xdfab29b3, 0xb316b35b),
+     TOBN(0x14f962e4, 0x04a8313d), TOBN(0xc6e3e7c4, 0x5f1f5a26),
+     TOBN(0x2c0e11c0, 0x79e777be), TOBN(0xa1705efb, 0x4657c31b),
+     TOBN(0x02688fd2, 0x3c494de3), TOBN(0x75664a84, 0x412a8718),
+     TOBN(0x878fc7ad, 0x7a422f8a), TOBN(0xe5d581df, 0x7419bd0a),
+     TOBN(0x7c813c4c, 0x704b70c0), TOBN(0x98553da8, 0x7323c008),
+     TOBN(0x4f63cec6, 0x63089f1a), TOBN(0x9626d6fa, 0x9655d291),
+     TOBN(0x84e5541f, 0x483aebf9), TOBN(0x8adff7dc, 0x49165772),
+     TOBN(0xe0a43ad6, 0x9beaad3c), TOBN(0x97dd1820, 0xf51c2714),
+     TOBN(0xac2b4cb4, 0x57ea5b0c), TOBN(0x87dbd011, 0xd11767ca),
+     TOBN(0x18ccf36c, 0xbfc7957a), TOBN(0xd4a08841, 0x1bc79227),
+     TOBN(0x9811ce43, 0xd8d292a8), TOBN(0x72c5fc68, 0xd58c4ee7),
+     TOBN(0x5bc0f0be, 0xd35c65a7), TOBN(0x0b446dbc, 0xcbbf9669),
+     TOBN(0x10586ea7, 0x507f8b27), TOBN(0x1510deb9, 0xa261f7d7),
+     TOBN(0xa42fc4d7, 0xdfbfa352), TOBN(0xbf38c382, 0x1e1c2291),
+     TOBN(0x46e40ef6, 0x0e11760a), TOBN(0xc24f6061, 0xdcb974d7),
+     TOBN(0x755b105b, 0xa7619027), TOBN(0x8004bf09, 0xb8ffa759),
+     TOBN(0xa630d0b0, 0x0945db60), TOBN(0xa160ac9c, 0xf2809e1c),
+     TOBN(0x38fc1113, 0xdc6c95c5), TOBN(0x01f54098, 0x5d52574f),
+     TOBN(0x7eba3da6, 0x9cee9bce), TOBN(0x3e2c1248, 0xd5377750),
+     TOBN(0x8c917d98, 0x2b93d8b2), TOBN(0xca8fc6ac, 0x7cad1f75),
+     TOBN(0x5f581f19, 0xa0ff150a), TOBN(0x872cc14a, 0xe08327fa),
+     TOBN(0xc774f187, 0xe9333188), TOBN(0x528ed4ac, 0x497af7e8),
+     TOBN(0xce036e9b, 0x8ad72b10), TOBN(0x463f9ebb, 0x917986cf),
+     TOBN(0xbe516328, 0x1325cf9b), TOBN(0xd28d5c50, 0xdd7e5fea),
+     TOBN(0xa4e9f29f, 0x0b237b7b), TOBN(0x8ed65b09, 0x4270ee2d),
+     TOBN(0x0e2184e4, 0x2993359d), TOBN(0x4f96ce7f, 0x224d5aa3),
+     TOBN(0x0862e200, 0x3a132c48), TOBN(0x5bbc6ad8, 0x0f015f5f),
+     TOBN(0xab9d5149, 0xd7162f5c), TOBN(0xfe657729, 0x1267e5d2),
+     TOBN(0x4865e671, 0xc1fd96e2), TOBN(0x7baf4dbe, 0x71a703b2),
+     TOBN(0x83dd6cf9, 0x142add10), TOBN(0xab4fc1aa, 0x98461d30),
+     TOBN(0x714c1d1b, 0xdd58bbe3), TOBN(0x85ba01ae, 0x039afd0f),
+     TOBN(0x7f23ea3a, 0x6951ac80), TOBN(0x5c599290, 0xac00c837),
+     TOBN(0xf6efa2b3, 0xbf24cc1b), TOBN(0x393d8e42, 0x1e84462b),
+     TOBN(0x9bda627d, 0xf8b89453), TOBN(0xe66fff2e, 0xb23e0d1b),
+     TOBN(0xd1ee7089, 0xc3b94ec2), TOBN(0xf75dba6e, 0x3031699a),
+     TOBN(0x8ff75f79, 0x242b2453), TOBN(0xe721edeb, 0x289bfed4),
+     TOBN(0xcda68a7e, 0x698ee21c), TOBN(0xc7414d19, 0x6a5e725e),
+     TOBN(0x483be2da, 0xdce20b91), TOBN(0x7de1601c, 0xfc69dca6),
+     TOBN(0x4bec17aa, 0xac4f9891), TOBN(0xe8741dd1, 0x8d479a56),
+     TOBN(0xc623cb8d, 0xac23a286), TOBN(0xe20a96b5, 0x166133f0),
+     TOBN(0xda9bb7c0, 0x30dcde61), TOBN(0xf84ea327, 0x3a1733fd),
+     TOBN(0xd7afb6c3, 0xe82fac31), TOBN(0x37ea7d35, 0xd3897449),
+     TOBN(0x083215a1, 0xc1390fa8), TOBN(0x901d686a, 0x6dce8ce0),
+     TOBN(0x4ab1ba62, 0x837073ff), TOBN(0x10c287aa, 0x34beaba5),
+     TOBN(0xb4931af4, 0x46985239), TOBN(0x07639899, 0xb053c4dc),
+     TOBN(0x29e7f44d, 0xe721eecd), TOBN(0x65817182, 0x57b3ff48),
+     TOBN(0x198542e2, 0x5054e2e0), TOBN(0x923c9e15, 0x84616de8),
+     TOBN(0x2a9c15e1, 0xad465bb9), TOBN(0xd8d4efc7, 0x16319245),
+     TOBN(0xed85257e, 0xfd028642), TOBN(0x93657f45, 0xb96a2068),
+     TOBN(0xfef64eda, 0xa13ac381), TOBN(0x108f6ff2, 0x56c557a3),
+     TOBN(0xe690d92b, 0x9204e3f7), TOBN(0x902a3e38, 0x03ef8640),
+     TOBN(0xaefd4922, 0x6416f50e), TOBN(0x9b272152, 0xb7eae8f0),
+     TOBN(0xa911921f, 0x29d93d8d), TOBN(0x7c6bc499, 0x5eeeea56),
+     TOBN(0xbd3439d8, 0x3ca7c720), TOBN(0x2f8cf2e3, 0xc39b208d),
+     TOBN(0x72dc7943, 0x9961a674), TOBN(0x839a0a52, 0xa0e13668),
+     TOBN(0xd7a53fa9, 0x334945ea), TOBN(0xdb21db77, 0xe7aa25db),
+     TOBN(0xb6675a7d, 0x66e96da3), TOBN(0x2c31c406, 0xe66f33c0),
+     TOBN(0x45020b62, 0x6ec7b9cb), TOBN(0xff46e9cd, 0x0391f267),
+     TOBN(0x7dabd744, 0x0fa2f221), TOBN(0x9a32364b, 0x9d4a2a3e),
+     TOBN(0xf0f84ae8, 0x52d2e47a), TOBN(0xd0b872bb, 0x888f488a),
+     TOBN(0x120649b2, 0x0370327b), TOBN(0x0e76555a, 0xcd48cdc6),
+     TOBN(0x4ed54dec, 0xca01db03), TOBN(0x7be21319, 0xac601d22),
+     TOBN(0xf7116619, 0x01b6576e), TOBN(0x7839fa06, 0x4e73537f),
+     TOBN(0x169d43ac, 0xe46e860a), TOBN(0xde6d658c, 0x3078eed9),
+     TOBN(0x8df73139, 0x5032142b), TOBN(0x6be199b0, 0x9b3c76c7),
+     TOBN(0xc2f385f6, 0xf8bbffe5), TOBN(0x848df7f3, 0xd5ffd28c),
+     TOBN(0x531e4cef, 0xc9790eef), TOBN(0xf7b5735e, 0x2b8d1a58),
+     TOBN(0xb8882f1e, 0xef568511), TOBN(0xafb08d1c, 0x86a86db3),
+     TOBN(0x88cb9df2, 0xf54de8c7), TOBN(0xa44234f1, 0x9a683282),
+     TOBN(0xbc1b3d3a, 0xa6e9ab2e), TOBN(0xefa071fb, 0x87fc99ee),
+     TOBN(0xfa3c737d, 0xa102dc0f), TOBN(0xdf3248a6, 0xd6a0cbd2),
+     TOBN(0x6e62a4ff, 0x1ecc1bf4), TOBN(0xf718f940, 0xc8f1bc17),
+     TOBN(0xa342bf65, 0xf874628f), TOBN(0x18de3f8a, 0xc71a57bd),
+     TOBN(0xb4d12a17, 0x71fc321b), TOBN(0x96716602, 0xa25ebf10),
+     TOBN(0x744f6820, 0x1a286d80), TOBN(0xd60bad1d, 0xe3cf63b8),
+     TOBN(0x0c0b1ac4, 0x4368da09), TOBN(0x53afeae3, 0x73a6d3be),
+     TOBN(0x4d2e6ce2, 0xa90af331), TOBN(0xd797224f, 0x88bc0638),
+     TOBN(0x10c60b2d, 0x9396d893), TOBN(0xae3b0c11, 0xfe45e1a8),
+     TOBN(0x2c8b0aad, 0x4f63f026), TOBN(0x2aff6238, 0x50b253cc),
+     TOBN(0xcab3e942, 0x10c4d122), TOBN(0x52b59f04, 0x07cd2816),
+     TOBN(0x22322803, 0x982c41fc), TOBN(0x38844e66, 0x8cf50b19),
+     TOBN(0x42a959f7, 0xbe3264cd), TOBN(0xbddc24bd, 0x6c983524),
+     TOBN(0xa489eb0c, 0x462b8640), TOBN(0xb7c05092, 0x98029be7),
+     TOBN(0xd5546b5f, 0xa1addc64), TOBN(0xe7cac1fc, 0xa0c655af),
+     TOBN(0xa189f30f, 0xc6a6d6d1), TOBN(0xdd674d36, 0x69665ab8),
+     TOBN(0x307c9ec3, 0x7d8da76d), TOBN(0xb3e1d006, 0xc1ea7c10),
+     TOBN(0xc15e20b3, 0xb88c62d4), TOBN(0xb0000ec5, 0x0bff3b3a),
+     TOBN(0x9e330eb1, 0x9ff9aa5c), TOBN(0x8663f9fd, 0xdf578877),
+     TOBN(0x157d3cb0, 0x02e1eb2a), TOBN(0x638f297b, 0xf525e4d4),
+     TOBN(0xa20f8332, 0x34a3dff1), TOBN(0x748ea86b, 0x45a9c051)},
+    {TOBN(0xfe9fdde8, 0xbc266ee3), TOBN(0x91668688, 0xba18e6c7),
+     TOBN(0xa65349ac, 0xddde6f6e), TOBN(0xc53c29c9, 0x7e54356c),
+     TOBN(0xee15ad94, 0x5709f73c), TOBN(0x033b3940, 0xe5429277),
+     TOBN(0xf52035cd, 0xd0c3475a), TOBN(0x9c5bef4d, 0x93f1f1f0),
+     TOBN(0x26e0b0ce, 0xca319bd4), TOBN(0x4e7eb67b, 0x6951fd8d),
+     TOBN(0xac3a6f43, 0x95c34d6f), TOBN(0x1f2769e6, 0x00f60b59),
+     TOBN(0xbd10b8bf, 0xfb787270), TOBN(0x4f0b1566, 0xe43aaab6),
+     TOBN(0x9a18be5e, 0xc0c90781), TOBN(0x3677f4c7, 0x1ad167ce),
+     TOBN(0xccb254e2, 0xa68c1c56), TOBN(0x392493e6, 0xe2c4d275),
+     TOBN(0x44958cb1, 0xd5b63617), TOBN(0x178f141a, 0x4caa4e7c),
+     TOBN(0x7445a767, 0xa2ffdbd5), TOBN(0x0e789c99, 0xb0b6c22d),
+     TOBN(0x3ff8b656, 0x5dc92b2e), TOBN(0x1623e5c3, 0xeca98782),
+     TOBN(0xfadf9be9, 0x78207cef), TOBN(0x97d5ba56, 0x9cb5718e),
+     TOBN(0xcbad24ec, 0x2f995393), TOBN(0x6236a268, 0x61203303),
+     TOBN(0xe4bafc33, 0x6589a4be), TOBN(0x6cba7718, 0x5e23fa82),
+     TOBN(0x8ccbc577, 0x4583e65a), TOBN(0xe5d88bca, 0x4bc2f415),
+     TOBN(0xe6bc2d58, 0x41df8dd1), TOBN(0xec24e1d9, 0x14d31fcd),
+     TOBN(0xacaaf13e, 0xfc26010b), TOBN(0x7e1da447, 0xe01b92f3),
+     TOBN(0x6f6a6104, 0x899ef333), TOBN(0x95496f6d, 0x39067165),
+     TOBN(0x42fd9a6a, 0xb51989e5), TOBN(0x1b60ce0f, 0x68f5b168),
+     TOBN(0x97324d87, 0x56f7fe67), TOBN(0x443812f7, 0x676815a8),
+     TOBN(0x265ee994, 0x685a7260), TOBN(0x342c7b2f, 0x6c6515f0),
+     TOBN(0xe9092323, 0x34b4adb0), TOBN(0xddcd233e, 0x1e5a8d18),
+     TOBN(0x3dc5b27c, 0x5f4f6456), TOBN(0x9664533a, 0x7f421d9b),
+     TOBN(0xc48bc829, 0xff7543c0), TOBN(0xc0bda14c, 0x4d72bfaa),
+     TOBN(0x2f470ec7, 0x03be0af1), TOBN(0xc70f1e8e, 0x92d37eb4),
+     TOBN(0x08abdd98, 0x418f410f), TOBN(0xe38c74ab, 0x35386176),
+     TOBN(0x9c07cfdd, 0x8c00426c), TOBN(0xba74c310, 0xa998f1ad),
+     TOBN(0x76b45140, 0xb7d2dda8), TOBN(0xa52b5e58, 0x4948330e),
+     TOBN(0x9b733234, 0x8d8efb26), TOBN(0x5d176373, 0x5d19a312),
+     TOBN(0x43b58def, 0x987cf64a), TOBN(0xc95b16c6, 0x3d4bcd4e),
+     TOBN(0x5d1b1373, 0xbcd9b923), TOBN(0xaf560542, 0x522e052b),
+     TOBN(0xc2ff8f75, 0x83800352), TOBN(0x11723aa1, 0x7fe2a4ea),
+     TOBN(0x28de7668, 0xe94bd9bd), TOBN(0x0ce80e0f, 0x874018a5),
+     TOBN(0x0fe3755d, 0x8d43e726), TOBN(0xa78296ac, 0xf9b075c5),
+     TOBN(0x76d58d98, 0x82207423), TOBN(0x5c5bc697, 0x1db99205),
+     TOBN(0x583ee7df, 0xe3b7e746), TOBN(0x0b6659e4, 0xa4fab3a8),
+     TOBN(0x34ee0275, 0x1946db5d), TOBN(0x5ae3c0ba, 0x1a12eeca),
+     TOBN(0x36756ed4, 0x4ccb83e7), TOBN(0x973b0861, 0xa80eaf3a),
+     TOBN(0x969e38f4, 0x6982ca90), TOBN(0x9a9bcd10, 0x018d01fc),
+     TOBN(0xb540e953, 0x3272476a), TOBN(0xcf91dd0a, 0x75ab7002),
+     TOBN(0x2c7d363f, 0x39ceb983), TOBN(0x4369c221, 0x974747c7),
+     TOBN(0xbfc40c30, 0xf893a2ca), TOBN(0xdf96980e, 0x0623bad1),
+     TOBN(0x4fd7b54d, 0xc027511c), TOBN(0xf4799284, 0xcf3484ce),
+     TOBN(0x655ab811, 0x069beea5), TOBN(0x52588bc8, 0x7392e280),
+     TOBN(0x522e7b40, 0x4f0c17cb), TOBN(0xc0d88aca, 0xc705e9b2),
+     TOBN(0x9cf1b958, 0x77f3913f), TOBN(0x3e06b926, 0x7dd52514),
+     TOBN(0x992e920e, 0x2908cbca), TOBN(0x13baced2, 0x6d6ed529),
+     TOBN(0x41c59b9c, 0x95ab4944), TOBN(0xfacdd4fa, 0xf32dcf4b),
+     TOBN(0x6401bcb6, 0xef361bc3), TOBN(0x8d1fbbf7, 0x697706ff),
+     TOBN(0xa9dcd2cd, 0x12fafc26), TOBN(0xc1fce537, 0xced1b64c),
+     TOBN(0x760b3eb2, 0x06433b06), TOBN(0x53a27b08, 0xf6f894d2),
+     TOBN(0xb50135cd, 0x851c8bce), TOBN(0x9bf9a243, 0x0e058bf5),
+     TOBN(0x231624a6, 0xcc0a78ef), TOBN(0x8200be42, 0xff090623),
+     TOBN(0x5a0f6f6b, 0x67a470ce), TOBN(0x7b8c2a88, 0x7ccca885),
+     TOBN(0x4421fe13, 0x25f812da), TOBN(0xc7a9c622, 0xe0833478),
+     TOBN(0x6aff42db, 0x94829d7c), TOBN(0x6fc2f23b, 0x37d888fe),
+     TOBN(0x9cfb8a14, 0x64b75c84), TOBN(0x56e1b7d4, 0x46139fee),
+     TOBN(0xcc6943b8, 0xfe72fca5), TOBN(0x12e757e1, 0xc3d621cd),
+     TOBN(0x6d9d63b0, 0x72c1571a), TOBN(0xa1fc3db1, 0x7b300fc6),
+     TOBN(0x7d58f7e6, 0x393e37ca), TOBN(0x30290d9b, 0x5e47e4c4),
+     TOBN(0x831e5039, 0xa69dc1eb), TOBN(0xe2f42725, 0x5a758799),
+     TOBN(0xe8166ff7, 0xc8f86525), TOBN(0x28e08f58, 0xaa85cc41),
+     TOBN(0x66be9bb7, 0xe5409138), TOBN(0x7d0f8807, 0xdcbb88ca),
+     TOBN(0x870cd794, 0xe7803e98), TOBN(0x78fd1eae, 0xd59d39c6),
+     TOBN(0x1aabe0af, 0xcc0e56c0), TOBN(0x7f8de733, 0x5bf0f272),
+     TOBN(0x36aa63d9, 0xfdf88aba), TOBN(0x87198fdc, 0xcdf43217),
+     TOBN(0xd8fe6f62, 0xa9a923c9), TOBN(0x85c81a0e, 0xee2ae4ba),
+     TOBN(0x7c20dea0, 0x32dbcb0b), TOBN(0x08baa938, 0x129a31c6),
+     TOBN(0xa47b3003, 0xb1d60f99), TOBN(0x31459993, 0x6905192e),
+     TOBN(0x67e22899, 0x32cf2c7c), TOBN(0x4c5f4375, 0x3b3c32bc),
+     TOBN(0x8de5d14d, 0xd499aa00), TOBN(0x54875c3f, 0xa311dac5),
+     TOBN(0xb6475210, 0x898dc5c7), TOBN(0x0f709811, 0x080e62b4),
+     TOBN(0x8a0016a7, 0xbb3bffd9), TOBN(0xfc56d337, 0xafb97dc7),
+     TOBN(0xff911c89, 0xca1b43d9), TOBN(0x9f8d40b7, 0x9187747a),
+     TOBN(0xf6ba5214, 0x5700a9ea), TOBN(0x7bc1c0e3, 0x8c04b9b7),
+     TOBN(0x2dd3de09, 0xa2c924d2), TOBN(0x12378655, 0x717b13cf),
+     TOBN(0x090f2556, 0x6e9d0e85), TOBN(0xf66a337d, 0x88f728c3),
+     TOBN(0x1f90b9b6, 0xe5140e1e), TOBN(0x7ab77ce1, 0xea2d44e5),
+     TOBN(0xc8a3343e, 0xf4878fcf), TOBN(0xbeb73f7c, 0xc544e407),
+     TOBN(0xdb3a8266, 0xfec32a61), TOBN(0xbe30a82e, 0x38db88f8),
+     TOBN(0xf33ad1df, 0x525080cc), TOBN(0xf66aa44d, 0x1a553e27),
+     TOBN(0x3194733f, 0xa9b7b198), TOBN(0xd87c8145, 0xb4b9b4c1),
+     TOBN(0xca7cd392, 0x68883c51), TOBN(0x2d12a779, 0xca49b152),
+     TOBN(0x407842b5, 0x2c4ffe71), TOBN(0xfa9a9143, 0xc3f5593b),
+     TOBN(0x97f9f32a, 0x69f25d01), TOBN(0x78e3d5fd, 0x4571d150),
+     TOBN(0x8cbd1078, 0x89878e86), TOBN(0xd4a4be53, 0x633ed774),
+     TOBN(0x2e6cf7f0, 0xd65d0ef1), TOBN(0x5cefa892, 0x18a2e243),
+     TOBN(0xb2e8ccb6, 0x130c9ba1), TOBN(0xda209fc8, 0xde1ec2f9),
+     TOBN(0x64845a36, 0xb3448d09), TOBN(0xbde9ae0a, 0x92896b12),
+     TOBN(0x8a46c911, 0xbfc6c637), TOBN(0x8dc3d699, 0xe4fa4fe6),
+     TOBN(0xd4ba64f1, 0x5cf8e4c9), TOBN(0x01b3908a, 0x01cb3488),
+     TOBN(0x69b1fa5d, 0x38bd7ded), TOBN(0x92ad4838, 0x18b2eae1),
+     TOBN(0x619324be, 0xb33955b6), TOBN(0xc7f37335, 0x5c8a6df7),
+     TOBN(0xa397f42e, 0x925b3f69), TOBN(0x32169a49, 0x5f7e4d11),
+     TOBN(0xc0fa9a54, 0x8d0d9f01), TOBN(0xf52a1f22, 0x89d8f2e5)},
+    {TOBN(0x9c0d5231, 0xba8e0a52), TOBN(0x94d0509e, 0x93e465d7),
+     TOBN(0x67df90dd, 0x98515454), TOBN(0x223e8b9c, 0x8dbfb46a),
+     TOBN(0xf39529a3, 0x6d757ce3), TOBN(0xffec9175, 0xb4648296),
+     TOBN(0x330749e8, 0xf78aae7b), TOBN(0x19e55496, 0x45f93cc3),
+     TOBN(0x8c320b34, 0x94083aa8), TOBN(0x1161f5a3, 0x21e321c6),
+     TOBN(0x0980deed, 0xde3e7892), TOBN(0x605aa919, 0x6ad76ccc),
+     TOBN(0x73fa3508, 0x180660f7), TOBN(0x4cae013e, 0x2d24936f),
+     TOBN(0xf64a549f, 0x58493d98), TOBN(0xd9ceae0a, 0xdc79f602),
+     TOBN(0x6569e37b, 0xd1512b84), TOBN(0x11e4c022, 0x151c9151),
+     TOBN(0x075678c2, 0xb55c5813), TOBN(0xb26cdb58, 0x09d3cb16),
+     TOBN(0x6334dca3, 0xa57fb969), TOBN(0x0ed90820, 0x223dc3ce),
+     TOBN(0x74f9c3ae, 0xbd11e277), TOBN(0xaeefed36, 0x79c0b8e2),
+     TOBN(0x0e2fc74c, 0x2a24c385), TOBN(0x836a4740, 0x34679278),
+     TOBN(0x25518f16, 0x817e2c41), TOBN(0x8b573a8e, 0xb4b7d3c1),
+     TOBN(0x012797f9, 0x4ab56adf), TOBN(0x9e0e56d0, 0xfa2ab690),
+     TOBN(0x009ba1ee, 0x1c9f6f08), TOBN(0x8ebf4aac, 0x2f412e9e),
+     TOBN(0xb143122a, 0x1cfb4e02), TOBN(0x988cf0ec, 0xcbf2b783),
+     TOBN(0x44a7ed96, 0x57f5be97), TOBN(0xbdcad872, 0x51804147),
+     TOBN(0x378205de, 0x2f9fbe67), TOBN(0xc4afcb83, 0x7f728e44),
+     TOBN(0xdbcec06c, 0x682e00f1), TOBN(0xf2a145c3, 0x114d5423),
+     TOBN(0xa01d9874, 0x7a52463e), TOBN(0xfc0935b1, 0x7d717b0a),
+     TOBN(0x9653bc4f, 0xd4d01f95), TOBN(0x9aa83ea8, 0x9560ad34),
+     TOBN(0xf77943dc, 0xaf8e3f3f), TOBN(0x70774a10, 0xe86fe16e),
+     TOBN(0x6b62e6f1, 0xbf9ffdcf), TOBN(0x8a72f39e, 0x588745c9),
+     TOBN(0xa96955b9, 0xb1bafbc4), TOBN(0x8dcb55a7, 0x646ece39),
+     TOBN(0x2b62784f, 0xeb00e541), TOBN(0x462f9d7d, 0x2693249b),
+     TOBN(0x8b264697, 0x794c189d), TOBN(0xded6ff55, 0x63354e69),
+     TOBN(0x7c8ea441, 0xeed1089f), TOBN(0xe355f75c, 0x1462f461),
+     TOBN(0x87b691f6, 0x1210fd5b), TOBN(0x7291bffb, 0x6983cb27),
+     TOBN(0x9ed83afc, 0x92800095), TOBN(0x307a3dc8, 0x1f24d923),
+     TOBN(0x7cec60ea, 0xd7804b2f), TOBN(0x00644643, 0x45c11441),
+     TOBN(0x3c6de88b, 0x769cd685), TOBN(0x34709186, 0xc7f01232),
+     TOBN(0xd9eef41e, 0xedd2bd0d), TOBN(0x3bafcccd, 0xe427faa9),
+     TOBN(0x33e5350e, 0xc07e701a), TOBN(0x9cb2eb47, 0xa87c1fd1),
+     TOBN(0x9fa9a779, 0x0d5f5b28), TOBN(0xa2e7076b, 0x07ea2e53),
+     TOBN(0x72f4da32, 0x5c169cf4), TOBN(0xb7f19294, 0x7e751588),
+     TOBN(0x47eb1335, 0x32dd7a30), TOBN(0x9d058169, 0xa9db654d),
+     TOBN(0x375c59df, 0x6e7a2b1a), TOBN(0x55d37c67, 0x7a35f29f),
+     TOBN(0xc78a3678, 0x493c4cde), TOBN(0xe5f0e2d6, 0x8d83e31b),
+     TOBN(0xf7927002, 0xe9777bf9), TOBN(0xdd559324, 0xa5afdfc7),
+     TOBN(0x077c6c48, 0xb81c08cc), TOBN(0xba1c98cc, 0xaa2ef694),
+     TOBN(0x06c6c954, 0x4c02dd46), TOBN(0x211e50f3, 0x7dd3145e),
+     TOBN(0x2a5f8ecf, 0x06616d0d), TOBN(0xca9b1cb8, 0xc7deb373),
+     TOBN(0x9de31ced, 0xc59c4301), TOBN(0x1e0f40b1, 0x0111d998),
+     TOBN(0xd29d229f, 0x960d5b95), TOBN(0x10563249, 0xd1dabab8),
+     TOBN(0x7b225cc9, 0xa05ecac9), TOBN(0xb02e6896, 0x78f3b8a0),
+     TOBN(0x009b52a1, 0xf5fb06b2), TOBN(0x8a575d3f, 0x842b9081),
+     TOBN(0xfddb48af, 0xe9272512), TOBN(0xd39b8f1d, 0x0b452cb7),
+     TOBN(0x0d6b9c7c, 0x67e09987), TOBN(0x261a564d, 0x0761ad52),
+     TOBN(0xec462174, 0x9f60925b), TOBN(0x83ee0c12, 0x18529b03),
+     TOBN(0x72972467, 0xfbcfff74), TOBN(0x37fc074c, 0x6abc4bfb),
+     TOBN(0x8b6015bd, 0x54e65e89), TOBN(0xde8583eb, 0x991583cb),
+     TOBN(0x379548e1, 0xb4d2c62a), TOBN(0x88024a9a, 0x9b24a5e5),
+     TOBN(0x633aa869, 0xfc03abfc), TOBN(0xa27657b9, 0x8fa35283),
+     TOBN(0xde9703b4, 0x61d9e770), TOBN(0x02d4091d, 0xef4653ef),
+     TOBN(0xefd229aa, 0x576eb5e1), TOBN(0xc0b0b243, 0xf77eb987),
+     TOBN(0xb11309b2, 0xeefe8f71), TOBN(0xfeeacf2f, 0x68478044),
+     TOBN(0x8dfd8e86, 0x43ac3dd7), TOBN(0xc0a24181, 0xb07f95c3),
+     TOBN(0x551ca096, 0x24be161c), TOBN(0x6cb2c1d4, 0xb098cdc3),
+     TOBN(0xbfc74e9b, 0xe74f84f8), TOBN(0xe58e14d9, 0x067e3388),
+     TOBN(0x9eca6f94, 0xf025baa6), TOBN(0xb2db0741, 0xbcf9c741),
+     TOBN(0xf8e2aab5, 0x90bb8f56), TOBN(0x47729032, 0x08762829),
+     TOBN(0x067a0c5a, 0xe2a266c8), TOBN(0x22b104c7, 0x71b7d7d0),
+     TOBN(0x4a48cd69, 0x53e406db), TOBN(0xb85e44d5, 0x24f0070b),
+     TOBN(0x6168262f, 0xe10133ff), TOBN(0xdfc02315, 0xe4874e8f),
+     TOBN(0x20dba2d7, 0xca317e3b), TOBN(0x441c56d2, 0xe1d2c0c3),
+     TOBN(0xae10069e, 0x808dc4b1), TOBN(0x64df30e1, 0x8fb3ba73),
+     TOBN(0xbbe4caf2, 0x7ebaad0b), TOBN(0x5907bf37, 0x3dd6119c),
+     TOBN(0x0a723dff, 0x9dfceefe), TOBN(0x59bff4dd, 0xf7cffc7e),
+     TOBN(0x7bc95fa2, 0x6a6f43c2), TOBN(0x9001d1d5, 0x3ca0e2b3),
+     TOBN(0x316a7ecd, 0x27b3335b), TOBN(0xbf08e672, 0x7b8d7d49),
+     TOBN(0x4b209f93, 0xc619058f), TOBN(0x4c0ca01e, 0x59d8f9ea),
+     TOBN(0x18c452c4, 0xcae69c3b), TOBN(0xf45690ac, 0xef0f00fa),
+     TOBN(0x3b363aa0, 0x4f66a5cc), TOBN(0x9dd41c0a, 0x47718c52),
+     TOBN(0xfa219d7e, 0x7e5cd370), TOBN(0x5d384db7, 0xb2196dfb),
+     TOBN(0x5e14749b, 0x90b4d46b), TOBN(0x55796656, 0xd9db9481),
+     TOBN(0x3bf13d0a, 0xc8cf353e), TOBN(0xb89a28a6, 0xa95c485a),
+     TOBN(0x568fa3d0, 0x5da29783), TOBN(0x4aa008ee, 0xd182b1a4),
+     TOBN(0xf7e1ed3b, 0xb09fa8f3), TOBN(0xbb4fe6f7, 0x1da5be9e),
+     TOBN(0xcbab0e01, 0xf4d1ba21), TOBN(0xb7327410, 0x76a5f326),
+     TOBN(0xd94d2349, 0x206092af), TOBN(0x739f3cd0, 0x728e0e4d),
+     TOBN(0x568644aa, 0xf81fd823), TOBN(0x510cff6b, 0x6110e2f6),
+     TOBN(0xef4cf1ac, 0x566c3598), TOBN(0x2c26f171, 0x62aae69b),
+     TOBN(0x1e436046, 0x8964a2a5), TOBN(0x83c0bbf6, 0x3e472c50),
+     TOBN(0x79c04804, 0xaabd965a), TOBN(0x9581aab4, 0x43d0b660),
+     TOBN(0x59bff003, 0x5ba71d23), TOBN(0x212ecd58, 0xb6a0cd80),
+     TOBN(0x29bdcd33, 0xbf1ea5d6), TOBN(0x59fd2ff4, 0x77a002e1),
+     TOBN(0x3c9d2130, 0x8d9cd247), TOBN(0x790e9dbc, 0xb1786da3),
+     TOBN(0x967ee5e7, 0x14464d04), TOBN(0xd6f7ebbd, 0x2b5373af),
+     TOBN(0x1c0b22d5, 0x39768d40), TOBN(0xdfb54983, 0x913f6cc3),
+     TOBN(0x167ec88a, 0x51b3f1ce), TOBN(0x19756ee0, 0x420024c8),
+     TOBN(0x10f2e244, 0x3877e634), TOBN(0x6321bf26, 0x03462cb3),
+     TOBN(0x1dbd10ee, 0x9d3afcee), TOBN(0x0726f5f2, 0x2ca17dcd),
+     TOBN(0x09465266, 0x0bacf018), TOBN(0xc92a9f2d, 0xe1feb969),
+     TOBN(0x0043b0f9, 0x5e1c5912), TOBN(0xa09b94d1, 0x757d3a63),
+     TOBN(0x53395652, 0x9fdef1e0), TOBN(0x9826886c, 0xd4fedd41)},
+    {TOBN(0x2e75a26e, 0xec65b53e), TOBN(0xfeb630b2, 0x70552fb3),
+     TOBN(0x53dfd057, 0xee7d8e4a), TOBN(0xb959110d, 0x8994f449),
+     TOBN(0xb4a16596, 0xbb538367), TOBN(0xa70917bd, 0xef82f29c),
+     TOBN(0x5a764300, 0x43bba6ae), TOBN(0xee207476, 0xcfbc194a),
+     TOBN(0xc7eab238, 0x03a4184b), TOBN(0x60c67ef2, 0x0f7fcd62),
+     TOBN(0x41e05799, 0xdfa8a0c6), TOBN(0x5d7d05e6, 0x04d352b0),
+     TOBN(0xc97c01eb, 0x436b59f5), TOBN(0x1d15aca7, 0xef1848ab),
+     TOBN(0xdba1ce80, 0x7fa7d3c2), TOBN(0x69e6f96e, 0x81060874),
+     TOBN(0x6e3e0df7, 0x4d7eeead), TOBN(0x8a3b5e85, 0xb0c87f3d),
+     TOBN(0xc55ae3db, 0xc8a23914), TOBN(0x5cdc2a92, 0xbf6d27d9),
+     TOBN(0xa6008c59, 0x1de7860a), TOBN(0x8202f8b6, 0x6e546731),
+     TOBN(0x652f2d07, 0xaa1e45d4), TOBN(0x146f214f, 0x6df5415a),
+     TOBN(0x4b01246a, 0x651ed62d), TOBN(0x9f6824a3, 0x0b9eb006),
+     TOBN(0x763ae8fe, 0xba95697f), TOBN(0xeff4f88d, 0xefe2182e),
+     TOBN(0x2c2ef50c, 0x74ba79b4), TOBN(0x319df6c9, 0x1d23d649),
+     TOBN(0x481f9faf, 0xf6c273a8), TOBN(0xe7156457, 0x9706dc07),
+     TOBN(0x06f0617a, 0x424d5cb9), TOBN(0x6d6b5d8b, 0xa8ad220a),
+     TOBN(0xa485ca14, 0xa2bd8c40), TOBN(0x7a7a15bf, 0x54cb54f6),
+     TOBN(0x041c706c, 0xce5fb4d9), TOBN(0xddc78cb3, 0xb22a79a7),
+     TOBN(0x7dc4cd27, 0x839e9d5a), TOBN(0xdfc9db83, 0xbf3c4c06),
+     TOBN(0x85b80941, 0x38b7bd22), TOBN(0x1007dea2, 0xd0f4c2da),
+     TOBN(0xd7b34006, 0xc633fba0), TOBN(0xa8880acf, 0x4476e55f),
+     TOBN(0xa340b2c2, 0x75236685), TOBN(0x5ddd0551, 0x0113a85f),
+     TOBN(0x7dfc7ab2, 0x9cb32704), TOBN(0x9a334a33, 0xdabf22ff),
+     TOBN(0xa8261c31, 0x7e546950), TOBN(0x89d19cae, 0x26706dc1),
+     TOBN(0xf8dbf6ca, 0xedc9af36), TOBN(0xda79fe4e, 0x7e446207),
+     TOBN(0x8bbc3195, 0x81cee38d), TOBN(0x9d121e9c, 0xb5be9577),
+     TOBN(0xdb3fff88, 0xcddb5a61), TOBN(0x751cad15, 0x3ee86665),
+     TOBN(0x5c0986df, 0x3d07abad), TOBN(0xf77489b3, 0x83fe8451),
+     TOBN(0x3546c5a9, 0xf90d3e94), TOBN(0x1ec54bd1, 0xd8a694b7),
+     TOBN(0x2fbce9be, 0xd7d1146b), TOBN(0xcec9e5d8, 0xb3980bd2),
+     TOBN(0x48ea4593, 0x9f4cbaf0), TOBN(0x56c54009, 0x2574a3bd),
+     TOBN(0x84a39630, 0xe792c39a), TOBN(0xe5c690f8, 0xeef81343),
+     TOBN(0xf996760f, 0x17655bc9), TOBN(0x6009c215, 0x6c0c191c),
+     TOBN(0xa0ca12e6, 0x966d7027), TOBN(0x92a6d5d5, 0x2e6f7c63),
+     TOBN(0x46809d26, 0x9bd13ead), TOBN(0x3c11fa79, 0x67aac681),
+     TOBN(0xca2876f9, 0xea8edc01), TOBN(0x85c1a4ac, 0x28d411c8),
+     TOBN(0x4d5fca4c, 0xfb0299a8), TOBN(0xa1df6c5a, 0x17fe8b37),
+     TOBN(0x2ffb3570, 0xcc062556), TOBN(0x4c59773e, 0x465ef78f),
+     TOBN(0xea3e39ae, 0xb3601ca5), TOBN(0x9806345f, 0xb7d30864),
+     TOBN(0x428fe41f, 0xe6600e5d), TOBN(0x19bd665d, 0x067a59c0),
+     TOBN(0xbd6b8272, 0x908cdb52), TOBN(0xb6025028, 0x0b2707d8),
+     TOBN(0x3fc9b3cf, 0xabe2cc87), TOBN(0xfd8d64e3, 0x514e77fe),
+     TOBN(0x2003a58a, 0xfe1ad535), TOBN(0xcec4be38, 0xcb39149f),
+     TOBN(0x4d578c99, 0xbdedf470), TOBN(0xcd35d7a3, 0x3a356519),
+     TOBN(0x7a762f27, 0x8b078d6b), TOBN(0x3b6891ed, 0x31ae2701),
+     TOBN(0xdc0e817f, 0x270c508e), TOBN(0x5a7be204, 0x9fdb29c8),
+     TOBN(0xfa1a0be3, 0xcb2711d3), TOBN(0x5865f55f, 0x3786a0c2),
+     TOBN(0x5f5db9af, 0x23bd1613), TOBN(0x0071d2c4, 0xcfd5bc16),
+     TOBN(0x273d7ad1, 0x81adfd03), TOBN(0x683508f4, 0xa0570ffa),
+     TOBN(0xa49f5c08, 0x611a75fc), TOBN(0xfca5bd12, 0x8fbcfbb1),
+     TOBN(0x7eabb339, 0x2a4fc49c), TOBN(0xdc5fae69, 0xad6e6d32),
+     TOBN(0x2e599c43, 0xe0b03dce), TOBN(0xf4ad8d3e, 0x7ca7250c),
+     TOBN(0x626c1f7e, 0xedeee0fe), TOBN(0x2296376f, 0xaab0b3f0),
+     TOBN(0x1d0af6b5, 0x2f641cff), TOBN(0xa932adeb, 0x3648c4a0),
+     TOBN(0x67641951, 0xb1ea8fc4), TOBN(0xc0b90064, 0xb1fae482),
+     TOBN(0x7012642f, 0x6623477b), TOBN(0x1cddc024, 0x5bf019ce),
+     TOBN(0xca1f4675, 0xc2c32737), TOBN(0x11525a5e, 0x97d6b18c),
+     TOBN(0x9c034ef2, 0xd3868de9), TOBN(0x0533d921, 0x044e0c18),
+     TOBN(0xba6cf14e, 0xcb5e38c3), TOBN(0x438309f3, 0x509d7053),
+     TOBN(0x0b82b506, 0x790b3f68), TOBN(0x75b38ef1, 0x12c1f59d),
+     TOBN(0x6bc1e007, 0x4dbdd80b), TOBN(0xf81480db, 0xd13bb11c),
+     TOBN(0x25131887, 0x17259091), TOBN(0xc5c8823e, 0xc61dde4e),
+     TOBN(0x0ddb06a0, 0x9b2736d1), TOBN(0x64dfb1fe, 0xa785e570),
+     TOBN(0x6f8f9945, 0xcc593359), TOBN(0xe8e457a9, 0xd186352c),
+     TOBN(0x389479b6, 0x7c342abc), TOBN(0xc73ddfee, 0x4cc71b3b),
+     TOBN(0xe164268e, 0xc4ff9f0b), TOBN(0x6c8e9349, 0xe6c36e63),
+     TOBN(0x734f9794, 0x78ab17f3), TOBN(0x46d468de, 0x0179ed0e),
+     TOBN(0x7e68f006, 0xdfa26867), TOBN(0xe4d4a85d, 0xe3d0485d),
+     TOBN(0x0913a1d7, 0xf84c0f8f), TOBN(0x4095c8c0, 0x25a9c9cd),
+     TOBN(0xeeb1a79e, 0x49eadd08), TOBN(0x433f5e41, 0x7dd8f954),
+     TOBN(0x70a62814, 0x30bb26d0), TOBN(0xad94d8f6, 0xff5e8e29),
+     TOBN(0x0b614a64, 0x5652a3c0), TOBN(0x89279185, 0x34597010),
+     TOBN(0x06c97f68, 0x810a812f), TOBN(0x566120f4, 0xbe358e91),
+     TOBN(0xcb1f8b75, 0xc044ff3c), TOBN(0x77b3b0b0, 0x7d1a468b),
+     TOBN(0x37a72862, 0x7d49aad9), TOBN(0x3ada117b, 0x8646efd4),
+     TOBN(0xd8626c0d, 0x21bac6d0), TOBN(0x2263d74c, 0xdd2c980c),
+     TOBN(0x8afd14c0, 0xfd1b6bda), TOBN(0x693742cb, 0xcae64c0b),
+     TOBN(0x6a352b57, 0x9e32c0a4), TOBN(0x5274a082, 0x77ec7a40),
+     TOBN(0xee1f7c7a, 0x240e6dc5), TOBN(0x85d5be62, 0xd313b4a9),
+     TOBN(0x1522c5d2, 0x5c01a405), TOBN(0xcfa08aab, 0x960afd5a),
+     TOBN(0xa3cb77f3, 0x8e8a93dc), TOBN(0xaacb1676, 0x6d1c98c7),
+     TOBN(0x84090c7d, 0x3b93fa9d), TOBN(0xc77f1ee1, 0x3c0383ad),
+     TOBN(0x461c93b7, 0x76f7a220), TOBN(0x66d63a1d, 0x04ac0bfc),
+     TOBN(0x3d1904c6, 0xd2343e0b), TOBN(0x8ce038f7, 0x775f877f),
+     TOBN(0xa9d4dce1, 0xd797f231), TOBN(0xb6712aa7, 0x16c08c2f),
+     TOBN(0x5045b87a, 0x335ad61a), TOBN(0x44a251fb, 0x7115bb4b),
+     TOBN(0x2363cf68, 0xe66511bc), TOBN(0xed8ab553, 0x81cc48f3),
+     TOBN(0x8bf71687, 0x725c6bae), TOBN(0x16e0d015, 0xc23ab12c),
+     TOBN(0xfbdcc064, 0x21f333c0), TOBN(0xe73df709, 0x62c9f01d),
+     TOBN(0x3c7d6b64, 0x4751207f), TOBN(0x65e1f96a, 0xe440c1a2),
+     TOBN(0x8ed15d20, 0xaa0eaa1e), TOBN(0xe944ad2f, 0xc0eab490),
+     TOBN(0x71525aa1, 0xf6d9f260), TOBN(0x5cd14c88, 0x16146ba3),
+     TOBN(0xf9401908, 0x14a41275), TOBN(0x3bb7ea74, 0x2288618d),
+     TOBN(0x6a4e1c37, 0xcab1060a), TOBN(0x357fe4d0, 0xc8cac96f),
+     TOBN(0x97a8b8ab, 0x6a2466ec), TOBN(0xb6e83fdb, 0x9c01be70)},
+    {TOBN(0x5b0b5d69, 0x2a7aeced), TOBN(0x4c03450c, 0x01dc545f),
+     TOBN(0x72ad0a4a, 0x404a3458), TOBN(0x1de8e255, 0x9f467b60),
+     TOBN(0xa4b35705, 0x90634809), TOBN(0x76f30205, 0x706f0178),
+     TOBN(0x588d21ab, 0x4454f0e5), TOBN(0xd22df549, 0x64134928),
+     TOBN(0xf4e7e73d, 0x241bcd90), TOBN(0xb8d8a1d2, 0x2facc7cc),
+     TOBN(0x483c35a7, 0x1d25d2a0), TOBN(0x7f8d2545, 0x1ef9f608),
+     TOBN(0xa7040160, 0x22ec7edd), TOBN(0x19124972, 0xcc9c8ee8),
+     TOBN(0x697f301f, 0x2ccb9417), TOBN(0x3ee87764, 0x6f00d8aa),
+     TOBN(0x2b5afaf8, 0x8138a017), TOBN(0xf152b14c, 0x832d7543),
+     TOBN(0x27c27ce2, 0x383052f9), TOBN(0x4746c5b5, 0xe1dae11b),
+     TOBN(0x92dc5ac7, 0x5b752008), TOBN(0xcf382e01, 0xe84fe5f1),
+     TOBN(0x90e03419, 0x7d5929ce), TOBN(0xafee3abb, 0x15ca3ffa),
+     TOBN(0xcb51f039, 0x54ebc926), TOBN(0xe235d356, 0xb8d4a7bb),
+     TOBN(0x93c8fafa, 0xb41fe1a6), TOBN(0x6297701d, 0xa719f254),
+     TOBN(0x6e9165bc, 0x644f5cde), TOBN(0x6506329d, 0x0c11c542),
+     TOBN(0xa2564809, 0xa92b4250), TOBN(0x0e9ac173, 0x889c2e3e),
+     TOBN(0x286a5926, 0x22b1d1be), TOBN(0x86a3d752, 0x6ecdd041),
+     TOBN(0x4b867e0a, 0x649f9524), TOBN(0x1fe7d95a, 0x0629cb0f),
+     TOBN(0x11dd860e, 0x1c6d03b0), TOBN(0x30c17008, 0x09eec660),
+     TOBN(0xd4f8aff6, 0x35c0192f), TOBN(0x96a727b1, 0xe3a4a900),
+     TOBN(0x1426daff, 0xde78c8ba), TOBN(0xfacaa9bd, 0x8d1527c4),
+     TOBN(0x0c0d5234, 0xcd072989), TOBN(0x1936c20d, 0x918550b5),
+     TOBN(0x4828bee4, 0x3d914fb3), TOBN(0x8324ea38, 0xf3ba26a6),
+     TOBN(0x027590f3, 0xa94eb26f), TOBN(0xfd354295, 0xacd957bf),
+     TOBN(0xf4f66843, 0xca5baf54), TOBN(0x298db357, 0xefe7db78),
+     TOBN(0xf607e86e, 0x7365712f), TOBN(0xd5882298, 0x8a822bc0),
+     TOBN(0x2cfbd63a, 0xc61299b3), TOBN(0x6f713d9b, 0x67167b1a),
+     TOBN(0x750f673f, 0xde0b077a), TOBN(0x07482708, 0xee2178da),
+     TOBN(0x5e6d5bd1, 0x69123c75), TOBN(0x6a93d1b6, 0xeab99b37),
+     TOBN(0x6ef4f7e6, 0x8caec6a3), TOBN(0x7be411d6, 0xcf3ed818),
+     TOBN(0x959353be, 0x3dfb423c), TOBN(0x8458e858, 0x36d41cc8),
+     TOBN(0x6a4826f7, 0x99d7a4f4), TOBN(0xab146ece, 0x52fe4b65),
+     TOBN(0x94fc21d7, 0x35038573), TOBN(0x26f50135, 0xf4d56e84),
+     TOBN(0xe15ca04d, 0x3162d92d), TOBN(0x8f652fcd, 0x34ed4e84),
+     TOBN(0xef7e7924, 0x4f21a910), TOBN(0x2eecb7e9, 0xdcc76132),
+     TOBN(0x5b484745, 0xdbe89048), TOBN(0xbf8c490f, 0x6e43a2c5),
+     TOBN(0xf92b3073, 0x63a0a7d2), TOBN(0x32da431c, 0x881dc8cf),
+     TOBN(0xe51bd5ed, 0xc578e3a3), TOBN(0xefda70d2, 0x9587fa22),
+     TOBN(0xcfec1708, 0x9b2eba85), TOBN(0x6ab51a4b, 0xaf7ba530),
+     TOBN(0x5ac155ae, 0x98174812), TOBN(0xcaf07a71, 0xccb076e3),
+     TOBN(0x280e86c2, 0xc38718a7), TOBN(0x9d12de73, 0xd63745b7),
+     TOBN(0x0e8ea855, 0xbf8a79aa), TOBN(0x5eb2bed8, 0xbd705bf7),
+     TOBN(0x3ede2484, 0xda756624), TOBN(0xb22da2ab, 0x73b13062),
+     TOBN(0x56069e93, 0x962a667b), TOBN(0xc931266b, 0x130f2cea),
+     TOBN(0x4bd6a6fc, 0xa7366a66), TOBN(0x23f30563, 0xaa5ac3b1),
+     TOBN(0xa025d0ef, 0xd7c2b26f), TOBN(0x597ce7d8, 0x62129bc7),
+     TOBN(0x4809927f, 0x2b3057f2), TOBN(0xb001c10a, 0x1499f884),
+     TOBN(0x309d141c, 0x30b9a653), TOBN(0xadddce7d, 0xbf659d05),
+     TOBN(0x33fe9578, 0xae16de53), TOBN(0x3ae85eb5, 0x10bec902),
+     TOBN(0xc4f49658, 0x44af850e), TOBN(0x6ea222b3, 0x087dd658),
+     TOBN(0xb255e6fd, 0xa51f1447), TOBN(0xb35e4997, 0x117e3f48),
+     TOBN(0x562e813b, 0x05616ca1), TOBN(0xdf5925d6, 0x8a61e156),
+     TOBN(0xb2fa8125, 0x571c728b), TOBN(0x00864805, 0xa2f2d1cf),
+     TOBN(0x2dc26f41, 0x1bccb6ff), TOBN(0xebd5e093, 0x63ae37dd),
+     TOBN(0xe448127c, 0x9303b5b0), TOBN(0x6ac65681, 0x7a74ec27),
+     TOBN(0x05128a52, 0x86f0e7ec), TOBN(0x9d9f32c1, 0x7603a73c),
+     TOBN(0xb5a799bf, 0x556c51ea), TOBN(0xea94f169, 0xa9a9a416),
+     TOBN(0xebb3e549, 0xaebde511), TOBN(0x9037046a, 0xf9cccd3f),
+     TOBN(0x2a9343a8, 0xf08a8254), TOBN(0xc5cc43f6, 0xd40c7f26),
+     TOBN(0xe1146cdc, 0xb39677d2), TOBN(0x6cbfec8b, 0xbe66d4b6),
+     TOBN(0xd2d68bb3, 0x0a285611), TOBN(0x3eae7596, 0xdc8378f2),
+     TOBN(0x2dc6ccc6, 0x6cc688a3), TOBN(0xc45e5713, 0x011f5dfb),
+     TOBN(0x6b9c4f6c, 0x62d34487), TOBN(0xfad6f077, 0x1fc65551),
+     TOBN(0x5e3266e0, 0x62b23b52), TOBN(0xf1daf319, 0xe98f4715),
+     TOBN(0x064d12ea, 0x3ed0ae83), TOBN(0x5ccf9326, 0x564125cb),
+     TOBN(0x09057022, 0xc63c1e9f), TOBN(0x7171972c, 0xdc9b5d2e),
+     TOBN(0x10867369, 0xb0a219fd), TOBN(0xe7efac97, 0x5ab56581),
+     TOBN(0xde3372e8, 0x7813f6f5), TOBN(0x3bbe5977, 0x1d4b8ed3),
+     TOBN(0xf17f61e5, 0x53376573), TOBN(0xf719d06d, 0x97964b90),
+     TOBN(0xb1e8c483, 0xb24d2e4a), TOBN(0x53709647, 0x184379eb),
+     TOBN(0xb739eb82, 0x8a8fcb83), TOBN(0x5d2f3a4d, 0x60163017),
+     TOBN(0xccedf4f4, 0xf823b4af), TOBN(0xa6e166a1, 0xff315eae),
+     TOBN(0x2364fd9a, 0xeabd21b2), TOBN(0x3ce5f4bb, 0x9174ad6d),
+     TOBN(0xa4d6d5d0, 0xb38688c0), TOBN(0x2292a2d2, 0x6d87fd7d),
+     TOBN(0x2a7d1b53, 0x4ca02e54), TOBN(0x7bee6e7e, 0xb4185715),
+     TOBN(0x73e54609, 0x8fc63acd), TOBN(0xf4d93a12, 0x4064e09d),
+     TOBN(0xd20e157a, 0x2b92daa5), TOBN(0x90d125db, 0xc4b81a00),
+     TOBN(0xcb951c9e, 0x7682de13), TOBN(0x1abe58f4, 0x27987545),
+     TOBN(0x76452ac1, 0xe1c01fab), TOBN(0x167d7326, 0x6bd32f0c),
+     TOBN(0x72d209c1, 0x4a283a42), TOBN(0xd26859b6, 0x48ea0ba9),
+     TOBN(0x7b3e5c46, 0x6369309b), TOBN(0x474a9625, 0x93c9a0b9),
+     TOBN(0x676ea3e4, 0xc76e25dc), TOBN(0xb0c9ccf7, 0x71400c71),
+     TOBN(0xc4295870, 0x36f83518), TOBN(0xb86c1b39, 0x267f0c25),
+     TOBN(0x8a3e3524, 0x28884a80), TOBN(0xea182c45, 0x43ba8e28),
+     TOBN(0x6d351640, 0x30c70c8d), TOBN(0x8047d811, 0xce2361b8),
+     TOBN(0x3f8b3d4f, 0xdf8e2c81), TOBN(0x5d595477, 0x33fa1f6c),
+     TOBN(0xf769fe5a, 0xe29b8a91), TOBN(0x26f0e606, 0xd737b2a2),
+     TOBN(0x70cbfa5d, 0xb8b31c6a), TOBN(0x0f883b4a, 0x863d3aea),
+     TOBN(0x156a4479, 0xe386ae2f), TOBN(0xa17a2fcd, 0xade8a684),
+     TOBN(0x78bdf958, 0xe2a7e335), TOBN(0xd1b4e673, 0x3b9e3041),
+     TOBN(0xa6c32900, 0xaf2825c1), TOBN(0xb37c46c1, 0xd223a04e),
+     TOBN(0x691e7d39, 0x063de7ea), TOBN(0x998df4e7, 0x10daf9bd),
+     TOBN(0xc7085b9e, 0x718b5d7a), TOBN(0xd41abcc8, 0x16b3d4b8),
+     TOBN(0x4dfce693, 0xf9bc4041), TOBN(0x383677ed, 0x659ec7a8),
+     TOBN(0x2c1904bf, 0x4491fb34), TOBN(0x7c1bf111, 0x4552451c),
+     TOBN(0x6562cc2c, 0x3c5e5e40), TOBN(0x1ecaa2a1, 0xfe0e4372)},
+    {TOBN(0x84c3630b, 0xf3087bc8), TOBN(0x152691e6, 0x74be6e26),
+     TOBN(0x5abd125f, 0xf61af001), TOBN(0x69bca56f, 0xbfea3525),
+     TOBN(0x384af199, 0x00e0cb6e), TOBN(0xb0b13cfe, 0xd00475a6),
+     TOBN(0xedafde49, 0x5e394049), TOBN(0xd988b558, 0xdaf2add6),
+     TOBN(0xf14cf97a, 0x6c8ffcc9), TOBN(0x4d6cec23, 0xe5a9cc5c),
+     TOBN(0xb0d678f8, 0x8a104e05), TOBN(0x80a7fcba, 0x9fb527c1),
+     TOBN(0x0d6cadbf, 0xc22137d2), TOBN(0xb5db59d3, 0x628a3298),
+     TOBN(0x3b433c73, 0x4ab19507), TOBN(0x4fc53405, 0x660086b3),
+     TOBN(0x770ae903, 0xa1eb0f43), TOBN(0x31b5857e, 0xf6b5b58d),
+     TOBN(0xe206e141, 0xd392868e), TOBN(0x8be6956f, 0x4b31de04),
+     TOBN(0xcfbfca2f, 0x47449e07), TOBN(0xebaef256, 0x39fef8e1),
+     TOBN(0x959e37b8, 0xc16fc80c), TOBN(0x8bb4bdd2, 0xe911d61b),
+     TOBN(0xc483d4b2, 0x4343bbf8), TOBN(0x42aca2e1, 0x8a0fc95e),
+     TOBN(0x5165df6f, 0xcbab1fb0), TOBN(0xeb284370, 0xf6cdfc0c),
+     TOBN(0xab565c00, 0x994320fc), TOBN(0xc0d157fd, 0x62133e80),
+     TOBN(0x7850cda5, 0x5b69644a), TOBN(0xe37ae76a, 0x806ec8b8),
+     TOBN(0xd14b805c, 0xc2c82edd), TOBN(0xcb5468b6, 0xcf244539),
+     TOBN(0x97d43ee8, 0x25dbe92d), TOBN(0x14422436, 0x89fb8f1e),
+     TOBN(0xd7bf2ac6, 0xa0a85236), TOBN(0x2921b55c, 0x7194c46d),
+     TOBN(0x162fabaa, 0x9afa9762), TOBN(0x7b7f1664, 0xb62b36ab),
+     TOBN(0x77b9f797, 0x296a84e9), TOBN(0xfcc1ad65, 0x7dbd843d),
+     TOBN(0xc6e9c1e1, 0xcd77b7f6), TOBN(0x9cf0e272, 0x917067c9),
+     TOBN(0xfa7fa93d, 0x3bfa90bf), TOBN(0x55846fe9, 0xd050e46a),
+     TOBN(0x473b9a0d, 0x35c56256), TOBN(0xadd29e33, 0x2b656a65),
+     TOBN(0x926c2552, 0xebc69b0b), TOBN(0x953a850f, 0xd4c7432e),
+     TOBN(0x0ee85e14, 0xb9359035), TOBN(0x8b10b01a, 0xbde090a5),
+     TOBN(0xb2878dca, 0xec423943), TOBN(0x2571a178, 0xf70bde20),
+     TOBN(0x24ed159a, 0xf5ebeee5), TOBN(0x60c202af, 0x043f6539),
+     TOBN(0xdaaa76f4, 0xc8d4ffc3), TOBN(0x2fc1f1ba, 0x06eda10f),
+     TOBN(0xddf159ee, 0x88ded556), TOBN(0xcfa71782, 0xe67b1ec4),
+     TOBN(0x31521f66, 0xd5d826b0), TOBN(0x0a636952, 0x40787844),
+     TOBN(0xc0a3bd05, 0x9c8f934e), TOBN(0x12c57dd4, 0x2f0ce835),
+     TOBN(0x847f6a99, 0x67064213), TOBN(0x1c9e1a7a, 0xa88bd71a),
+     TOBN(0xc4060eb2, 0x171e8407), TOBN(0xdf78d8df, 0xed106780),
+     TOBN(0xa3d28ceb, 0x0d704729), TOBN(0x4f8e5232, 0x46ca3912),
+     TOBN(0x09e9f852, 0x017791f4), TOBN(0x59400663, 0x1e6ea97d),
+     TOBN(0x547b0d95, 0x83939224), TOBN(0x3a0823ff, 0x1e026769),
+     TOBN(0x60166715, 0x25bd43ac), TOBN(0xb6cf475e, 0x18ba5f64),
+     TOBN(0xa22f9c92, 0xc8b6d09d), TOBN(0x73055368, 0x3ccf50ab),
+     TOBN(0xa6de248e, 0xee6deefe), TOBN(0x32aaf8b2, 0xacc3ca20),
+     TOBN(0x0e254c5b, 0xad44e674), TOBN(0x8aa73e65, 0x35f95f98),
+     TOBN(0xe6226001, 0x60a2dc1e), TOBN(0xdf948210, 0x9109020a),
+     TOBN(0x372798f0, 0x2893f2f7), TOBN(0x4f62bfac, 0x9e5030ca),
+     TOBN(0x5e64f9a9, 0x8a1e2567), TOBN(0x5870254c, 0xe70391c8),
+     TOBN(0x2def81a3, 0x41f02458), TOBN(0x25d4e4dc, 0x1d087bed),
+     TOBN(0x3557d07d, 0x4fe24a13), TOBN(0x6da49186, 0xdc3112bc),
+     TOBN(0x08c8c567, 0x5f73ba50), TOBN(0x5309050b, 0x9c7c6706),
+     TOBN(0x2ab67da3, 0xbd985072), TOBN(0x9bafa8b1, 0xe5df4e96),
+     TOBN(0x3ac66289, 0x5c02f173), TOBN(0x6a110e38, 0x76d566e5),
+     TOBN(0xd9cc14e2, 0xb9577e26), TOBN(0x6f3d5df9, 0xfdfe617e),
+     TOBN(0x8fac740f, 0x352bb2ca), TOBN(0x50bc8a0c, 0xc28e6310),
+     TOBN(0x6e572fc4, 0x77ac93f7), TOBN(0x56277377, 0x605bb8e9),
+     TOBN(0xad6d0637, 0x402b8c55), TOBN(0xdab37791, 0x4509eda7),
+     TOBN(0xae770abc, 0x0854e91b), TOBN(0x523bd278, 0x742b3de8),
+     TOBN(0xc2cbd644, 0x17fecb90), TOBN(0x61616eb3, 0xb32dffdb),
+     TOBN(0xdc4485a2, 0x9f5d2095), TOBN(0xf7891124, 0x6553371b),
+     TOBN(0x4f06ba18, 0xbf9b20af), TOBN(0x136d4f29, 0x1a2c4df1),
+     TOBN(0xc04aca34, 0xfb8b685f), TOBN(0xeec83c20, 0xf2b657bb),
+     TOBN(0x4da5d70a, 0x5925a36a), TOBN(0x80608741, 0x72ff2965),
+     TOBN(0x2e0dd9ff, 0x9f352620), TOBN(0x5f0afa67, 0x46d1a7a8),
+     TOBN(0xa995a95b, 0xf46aace5), TOBN(0x44ede537, 0x9eaa630a),
+     TOBN(0x421f3b35, 0x00336e3b), TOBN(0xbf897478, 0xcf47c9ed),
+     TOBN(0xf360ae32, 0x259e0827), TOBN(0x04e0e3e8, 0x2e6a9f6b),
+     TOBN(0xb26eae5f, 0xa9136702), TOBN(0xd6cb15a1, 0x853674b4),
+     TOBN(0xf81276e2, 0x748bcbc9), TOBN(0x7fc02e22, 0x0a4ca1d7),
+     TOBN(0xf650f48e, 0xcd82f330), TOBN(0xf4ea7c1d, 0xabaa8859),
+     TOBN(0x1ccd44ff, 0x95c746ec), TOBN(0xe18914b5, 0x10405763),
+     TOBN(0x50ed6443, 0x21a3a927), TOBN(0x4f96a1b1, 0x43ef8e8f),
+     TOBN(0x7f5645e5, 0x77952bf8), TOBN(0x4bc5c7ab, 0x66dbdf15),
+     TOBN(0xacc16126, 0x23930a08), TOBN(0xbf5ed482, 0x504cf9b6),
+     TOBN(0xdeb7a798, 0xd71ecbd7), TOBN(0xf62e63b1, 0x4a4dd859),
+     TOBN(0x668809a7, 0xdaf714d9), TOBN(0xdd836382, 0xf3a4329e),
+     TOBN(0x894bdbd9, 0xc48f3ad5), TOBN(0x687ff8de, 0x09e167f6),
+     TOBN(0xf06104a9, 0x30371c43), TOBN(0x82fd34b7, 0xce84dd10),
+     TOBN(0xae122deb, 0x66ce5abd), TOBN(0x31f041d2, 0xfc4a90b2),
+     TOBN(0x2589535c, 0x9a01c607), TOBN(0x231bcc85, 0x695bd7ab),
+     TOBN(0xc67c3062, 0x62e3a31d), TOBN(0x31be4475, 0x7af3e186),
+     TOBN(0x1a2077a3, 0x88efa7f1), TOBN(0xffe53e22, 0x815fad1a),
+     TOBN(0xdd155913, 0x66229776), TOBN(0x84093730, 0xf7882064),
+     TOBN(0x6dddcb14, 0xe50ee337), TOBN(0xa8e6ec59, 0x7a1f7e81),
+     TOBN(0x8467f998, 0xf3738a6a), TOBN(0x70fcc6bc, 0xad3f1840),
+     TOBN(0xf82eb4be, 0x723b3f4b), TOBN(0xf0f39354, 0x06beec1b),
+     TOBN(0x1b181ea3, 0x7ddcb539), TOBN(0x9c82c4fa, 0xad6a81b9),
+     TOBN(0xcc5ea543, 0x5c612c2b), TOBN(0x63ce7571, 0xbb258d6f),
+     TOBN(0x1b588855, 0x0b96547f), TOBN(0x4539c9c0, 0x65d1a59d),
+     TOBN(0xd6c95fea, 0x26e15084), TOBN(0xf84ad9e2, 0x86b96242),
+     TOBN(0x92f57d6d, 0x451a5486), TOBN(0x0215cfcb, 0x06a9e87e),
+     TOBN(0xe05b10ea, 0xf66e46f3), TOBN(0xe7b0e72f, 0x655a0642),
+     TOBN(0x03503267, 0x7b117f43), TOBN(0xf5b78105, 0x779ea4a1),
+     TOBN(0x28ee00fa, 0xa4adac77), TOBN(0x1ea67d71, 0x6a93a2b1),
+     TOBN(0x7be81fb1, 0x26882c6c), TOBN(0xe2d5a251, 0xecd25498),
+     TOBN(0xbb3d40e2, 0x7a8d1678), TOBN(0x1806c67a, 0xd520811e),
+     TOBN(0xadd4bb66, 0x86f65d23), TOBN(0x3a62b1b3, 0xe20e23d7),
+     TOBN(0x208b4700, 0x6548b3eb), TOBN(0x0497f09a, 0xb7ec2809),
+     TOBN(0xbd3964f8, 0x121c37e2), TOBN(0xd35ef301, 0xa598efbb),
+     TOBN(0xbd76a276, 0xc5eef966), TOBN(0x64700a7f, 0x0af64e46)},
+    {TOBN(0x169474a2, 0xd3812087), TOBN(0x9de300da, 0x6698ca7a),
+     TOBN(0x8589de92, 0x2ede425b), TOBN(0x50e03fea, 0x6df8a890),
+     TOBN(0x0d8a5c1c, 0x4ba8b8e3), TOBN(0xf273aa67, 0x3fffb91a),
+     TOBN(0x21cf0544, 0x75fc8236), TOBN(0x6ceafacf, 0x9799c242),
+     TOBN(0xc3237eae, 0xd0962c81), TOBN(0x43d6ac34, 0x213f6004),
+     TOBN(0x45e619b2, 0xd4148b6b), TOBN(0xfafa18b5, 0xea5fb80a),
+     TOBN(0x9a8580aa, 0x2f063b51), TOBN(0xa83c8ff7, 0x1c216613),
+     TOBN(0xb4da0970, 0xbe07f781), TOBN(0x0ac2a260, 0x712f7b7c),
+     TOBN(0xc9b8ee84, 0x436a7b97), TOBN(0xd758c20d, 0x11fb2f62),
+     TOBN(0x5daabed9, 0xf170b799), TOBN(0x018d2fdd, 0xc46bc387),
+     TOBN(0x82d6b5b7, 0xd96cfb8e), TOBN(0x4d7d0d93, 0x44d9e843),
+     TOBN(0xfa2a9ea9, 0x91e7da3c), TOBN(0x8230c1a3, 0xd531b253),
+     TOBN(0x82412f52, 0x5ec31754), TOBN(0x42f462c8, 0x9d32e890),
+     TOBN(0x1e7b58ce, 0xce897ff2), TOBN(0xcfef7852, 0x41164628),
+     TOBN(0x34ee0422, 0xd8bb22ef), TOBN(0x6e0d44ac, 0x7d32f01b),
+     TOBN(0x96825165, 0x5a3cc196), TOBN(0xa26724dc, 0x99eb23d3),
+     TOBN(0xdb575faf, 0xa75f7252), TOBN(0x778e3330, 0x62a3e5b1),
+     TOBN(0x8689884e, 0x84cccc80), TOBN(0x9883cd19, 0xb645502d),
+     TOBN(0x4cc41f28, 0x34220e26), TOBN(0xb5937c6d, 0xa49749c4),
+     TOBN(0x70536664, 0x0fa1ca24), TOBN(0xeeb40f3b, 0x91e5edaf),
+     TOBN(0xcdf98235, 0xf1d3de14), TOBN(0xa65e5b7e, 0xff018c43),
+     TOBN(0xaa3228e7, 0xacee3a6e), TOBN(0xb63a6289, 0xe08f4ff1),
+     TOBN(0x90e90425, 0x650b2daa), TOBN(0xe4a8cad2, 0x6d875f17),
+     TOBN(0xc212029c, 0x9ce8a46e), TOBN(0xce051283, 0x5ed7cfb5),
+     TOBN(0xb0df2261, 0x59b79436), TOBN(0x82bd0daf, 0xa195be26),
+     TOBN(0xbc99a94b, 0x3398c317), TOBN(0xbeb44c90, 0x3c96ee31),
+     TOBN(0x3c39ad81, 0x664d2e46), TOBN(0x08178752, 0x0a3e0585),
+     TOBN(0x9a054b6b, 0x413e269a), TOBN(0xbe58891d, 0x98c3b62e),
+     TOBN(0xe7fa4c4d, 0xe5734974), TOBN(0x8ac535f4, 0xd0a846a8),
+     TOBN(0xea0f95f1, 0xa651339c), TOBN(0xa255274f, 0xd96aa239),
+     TOBN(0xe23b7b22, 0x9534047e), TOBN(0xbd70aea8, 0x3a3bd625),
+     TOBN(0xf44b05fe, 0x238db60b), TOBN(0x9c46fb14, 0x0293abcf),
+     TOBN(0x12cab5d3, 0xbfd8875b), TOBN(0x1f38d4aa, 0x12dd0c65),
+     TOBN(0x4bed4157, 0x2adf9805), TOBN(0x3f87da92, 0x8a56609d),
+     TOBN(0x10b93363, 0xda02c903), TOBN(0x7ecc7266, 0x21ce4786),
+     TOBN(0x8ae36685, 0x1e3da5bf), TOBN(0x196040ff, 0xd3edee12),
+     TOBN(0x4805841f, 0xe81508e8), TOBN(0xe2a578d3, 0xa4808642),
+     TOBN(0x6bbf10ac, 0xcd0b2555), TOBN(0xc5071eff, 0xaf5cde28),
+     TOBN(0x665e7543, 0x9a7124a9), TOBN(0x157c11ed, 0xc1437981),
+     TOBN(0x2019367d, 0x7aeddd8b), TOBN(0x74a1e104, 0x386e3b8a),
+     TOBN(0xe72d429b, 0xfbe09a42), TOBN(0xaca96fd9, 0x061b862e),
+     TOBN(0xbb2d2bc8, 0x122595f8), TOBN(0xc90c6503, 0xc509d644),
+     TOBN(0xadb5966f, 0xcff05ada), TOBN(0x8ed26c02, 0x5c57284e),
+     TOBN(0xa76e73e2, 0x44693a95), TOBN(0x14da7435, 0x5982bbd3),
+     TOBN(0x46e982cd, 0x5d2ca132), TOBN(0x8f390740, 0x24938e76),
+     TOBN(0x749206b3, 0x0a89b09a), TOBN(0x429653c7, 0x93b4a1e5),
+     TOBN(0xbee3d156, 0x7025bb7c), TOBN(0xe23f0e1e, 0x19555c9e),
+     TOBN(0x0dec3837, 0x751639ba), TOBN(0xb36cb844, 0x05d43bd0),
+     TOBN(0xae76a96e, 0x74f90b6e), TOBN(0x5fa8e948, 0x24c6789c),
+     TOBN(0x2b3584bb, 0x03abbb81), TOBN(0xe19ce47c, 0x5c451f72),
+     TOBN(0x35792fba, 0xd619ac7a), TOBN(0xfa0282a2, 0x50059bf4),
+     TOBN(0x562bfd14, 0xdabe692f), TOBN(0x1aaf542c, 0x47eeb6c2),
+     TOBN(0x392d5bba, 0x045d0360), TOBN(0x4e7bb31b, 0xd80fe998),
+     TOBN(0x08f62ef3, 0x1111e14d), TOBN(0x4de917b0, 0x4e9ee1b8),
+     TOBN(0x8b9d2d58, 0x67166271), TOBN(0x658db4ea, 0x142bab7c),
+     TOBN(0xdf84932f, 0xa4ad2849), TOBN(0x04b11335, 0x5f6f86a7),
+     TOBN(0x2de6b29c, 0x50cfcea7), TOBN(0x46d8f68a, 0x9be6a3a3),
+     TOBN(0xfb88cda7, 0xaf0204af), TOBN(0x3ece4491, 0x26029d72),
+     TOBN(0x69fef1e2, 0x3f946dfd), TOBN(0x708532fb, 0x01ef7bb5),
+     TOBN(0x78d5053d, 0xeb3795a2), TOBN(0x819a6320, 0x6b36d57b),
+     TOBN(0xca07e0c1, 0xe509d19e), TOBN(0x6c7e42c3, 0x9f6281b1),
+     TOBN(0x0e2ff439, 0x77b66728), TOBN(0x1d740e78, 0x80e76251),
+     TOBN(0x6bfae4c6, 0x31a0eb23), TOBN(0xd78ca917, 0xaa9b0b3b),
+     TOBN(0xe140c662, 0x991e1781), TOBN(0x6e396b5f, 0x0dd3cfee),
+     TOBN(0xf0a1d197, 0x6ce7f6c7), TOBN(0xbe10f8ef, 0xd5b01564),
+     TOBN(0x865cbd54, 0x101a5194), TOBN(0xf6658852, 0x66861ded),
+     TOBN(0xe4e52e86, 0x5b28f7da), TOBN(0xeb43a680, 0x9a58683f),
+     TOBN(0x73b951bf, 0xb49f2b38), TOBN(0x7b6cb7db, 0x3f8097cf),
+     TOBN(0x9dfb8d0b, 0x328fbf05), TOBN(0x491635a5, 0xebce6211),
+     TOBN(0xa31a1523, 0x90fdd577), TOBN(0x334120df, 0x1cd2f39c),
+     TOBN(0x1d22834e, 0x6b563876), TOBN(0xfd91b30d, 0x10ee5a28),
+     TOBN(0x3d7a282d, 0x59aee4ea), TOBN(0x36814c6b, 0x73300a76),
+     TOBN(0x7b584add, 0x6621c251), TOBN(0x98da669d, 0x4233aba3),
+     TOBN(0x4d652b79, 0x33aa2065), TOBN(0x901bcfb8, 0xdf7b4ed4),
+     TOBN(0xb2ce5879, 0x48012f81), TOBN(0xc18e2cd6, 0x3cb71b88),
+     TOBN(0xadb0f2bd, 0xff86279d), TOBN(0x46d9e5d6, 0x5bd15866),
+     TOBN(0x11b1fb3e, 0xc635a4c0), TOBN(0x8bcd0ad2, 0x01b1006a),
+     TOBN(0x0f6f7502, 0xcbab210b), TOBN(0xd6cc3e56, 0x0d6b3995),
+     TOBN(0xa54a6420, 0x137264c5), TOBN(0xa6ef0e78, 0xf9c2e45e),
+     TOBN(0xba8b5a73, 0xd58d850c), TOBN(0xc0209ed8, 0x6ef6fc3e),
+     TOBN(0xe39dd0f3, 0x91f7518a), TOBN(0x74697b89, 0x42b3eda6),
+     TOBN(0x2dccac36, 0xabfc9150), TOBN(0x80e4fba2, 0x98b2f5a5),
+     TOBN(0xe0e56fd2, 0x771018d5), TOBN(0xa31fd168, 0x4c22bb94),
+     TOBN(0x8b0998f7, 0x1a66ef21), TOBN(0xed483e55, 0xb5a53ddb),
+     TOBN(0x95db1c0e, 0xf23978eb), TOBN(0x80ad1612, 0xf04011f4),
+     TOBN(0xe76bd182, 0x4d7ae83d), TOBN(0x841d6e66, 0x8fc3bd60),
+     TOBN(0xb68e8079, 0x6875e2d0), TOBN(0xe3965efc, 0xd5d9dee7),
+     TOBN(0xc488bb7e, 0x58930931), TOBN(0x52f4de19, 0xa907aa24),
+     TOBN(0x39aebbdd, 0x321cc197), TOBN(0xd2f5b1f9, 0x67de5c66),
+     TOBN(0x60f1a8c2, 0x8efe3e76), TOBN(0xf40604a0, 0xaf988831),
+     TOBN(0x78b5c14c, 0x0acb5935), TOBN(0xd9ec715c, 0x4311d3be),
+     TOBN(0xffa22ab2, 0x09e1759e), TOBN(0x5a86263d, 0xb4b2f68c),
+     TOBN(0x71e77c51, 0x6b5be7f4), TOBN(0xfb5bea3a, 0x19844f6d),
+     TOBN(0x2519d006, 0x0890ffab), TOBN(0x426a03f0, 0xf0329ef0),
+     TOBN(0x2c6d74a6, 0x85b3c2a9), TOBN(0x9306f68f, 0xc294f449),
+     TOBN(0x552e77c2, 0x2c69fb46), TOBN(0x7c7337ad, 0x10bb9886)},
+    {TOBN(0x3313a9d5, 0x44b133d9), TOBN(0xdb85c25d, 0x2da910dd),
+     TOBN(0xc0fdef91, 0x5e4dd5cd), TOBN(0x902a2a93, 0xc565dd67),
+     TOBN(0xd8eba4dc, 0x7fed05ac), TOBN(0xd453995c, 0xe157dae9),
+     TOBN(0xd655d0b3, 0xf250cb55), TOBN(0x4194a09e, 0x86119222),
+     TOBN(0x5b7e525a, 0x0652872b), TOBN(0xaf7968ef, 0xe68c0ddb),
+     TOBN(0x2ec02930, 0xf51cb31c), TOBN(0x237f3ae4, 0xf2be071e),
+     TOBN(0x9b23ab4e, 0x94d0864f), TOBN(0x46356266, 0x009c9fc1),
+     TOBN(0xdbe99e51, 0xe798edf9), TOBN(0x38547449, 0x307675c7),
+     TOBN(0x23ffaf55, 0x628c0fb6), TOBN(0x56ccd2a3, 0x1698c372),
+     TOBN(0x39f45a57, 0x8347ce95), TOBN(0xe0aaec74, 0x4f2c6118),
+     TOBN(0x2a89079e, 0x4af138fc), TOBN(0xb86371ea, 0x2ee4ecc0),
+     TOBN(0x076d256a, 0x06bbf92f), TOBN(0x9073adb8, 0xae3c4c51),
+     TOBN(0xdaa77b43, 0x4c99252c), TOBN(0x59e38731, 0x326cb0e1),
+     TOBN(0x281a38cc, 0x03ca6c85), TOBN(0x83565666, 0x433835a0),
+     TOBN(0x3654ec9e, 0x30a928fd), TOBN(0x1c82abca, 0x7cb281f8),
+     TOBN(0xbeba0fe5, 0x13fafa6f), TOBN(0x67432292, 0x99440e63),
+     TOBN(0xd62777af, 0x0034d0cf), TOBN(0xd42b95fe, 0x9cde52a0),
+     TOBN(0xb5b891bc, 0x6a23630f), TOBN(0x8e4d2984, 0x64594976),
+     TOBN(0xba2e9543, 0x743c15d9), TOBN(0x7d5812db, 0x1c99c984),
+     TOBN(0xf94db951, 0x45bdc19e), TOBN(0x951d00ae, 0x382e77bd),
+     TOBN(0x9940a5fb, 0xb220b29a), TOBN(0x6908d50e, 0x58fc91f1),
+     TOBN(0x682e42ea, 0xdd0940fe), TOBN(0x2124e23a, 0xa1d32009),
+     TOBN(0xbe158100, 0x16294d05), TOBN(0xaea13fe3, 0x2e326d68),
+     TOBN(0xc0dfe1ef, 0x15e64fce), TOBN(0x32dbc0b5, 0xb8237a8a),
+     TOBN(0xea6f1448, 0x663771f8), TOBN(0xbf11f126, 0x9a0906cb),
+     TOBN(0x8c08219d, 0xd1a6a6a5), TOBN(0xf2af6e04, 0xdd56f277),
+     TOBN(0x8ad26705, 0xd569188a), TOBN(0xf0547631, 0x6e071c9b),
+     TOBN(0x945f40bd, 0xfd4aa6ec), TOBN(0xbd6a8a8d, 0x8486987c),
+     TOBN(0x4f577728, 0xb947b6f2), TOBN(0xe2754a8e, 0x7aab6bc1),
+     TOBN(0x918d02cd, 0xfb48a9ab), TOBN(0x7e3ddaea, 0xbf904200),
+     TOBN(0xe59b8002, 0x0bc28725), TOBN(0xc6f8fa54, 0x149f8991),
+     TOBN(0x8799172a, 0x5af5b47e), TOBN(0xf72c9780, 0x160d7e8d),
+     TOBN(0x1d1ce972, 0xb2f9a549), TOBN(0x8fce3f16, 0x4857b44a),
+     TOBN(0x2545bdd7, 0x1ed5e0e5), TOBN(0x222c33a7, 0xc259176a),
+     TOBN(0x5a60343a, 0x4e23c064), TOBN(0x986779f9, 0x1d1fd9cd),
+     TOBN(0x5bd5611b, 0x3570b5b3), TOBN(0x2758caea, 0xf9d765a3),
+     TOBN(0xd8135f00, 0x3a16e352), TOBN(0xbfc784b2, 0x55d4e996),
+     TOBN(0x5da46321, 0x0a6874d0), TOBN(0xf1635286, 0xe8e1e4d0),
+     TOBN(0xe71332b3, 0xa0e9c4de), TOBN(0x5f076117, 0x60fc995e),
+     TOBN(0x1c1305d1, 0xc19ebb59), TOBN(0x1d5987f2, 0x4603baa2),
+     TOBN(0x6b7885b0, 0xea7c9f9c), TOBN(0x362734e8, 0xfe9ba1fc),
+     TOBN(0x49a3ff32, 0xb3892110), TOBN(0x0e5b2166, 0xd4997512),
+     TOBN(0x6ee65a08, 0xc36d3f25), TOBN(0x7b6c811f, 0xe393e4d4),
+     TOBN(0xc4a2cc38, 0x2876e523), TOBN(0xab7aba26, 0xd3bf53aa),
+     TOBN(0x5bf00871, 0xdb7f290c), TOBN(0x3cb1cd13, 0x1ee6d5bd),
+     TOBN(0x4cafb218, 0xde998ada), TOBN(0xa1ecf36a, 0xf6319101),
+     TOBN(0xa1fe7855, 0x20b281cc), TOBN(0xe457198e, 0x64d9c65e),
+     TOBN(0xa3d1a6d0, 0xc5a0e67b), TOBN(0x69ddbc32, 0x90cc468a),
+     TOBN(0x3f3cb2a5, 0x53a38094), TOBN(0xc9308152, 0x3b19448a),
+     TOBN(0x9cf32819, 0x925ba579), TOBN(0x44b9590a, 0x1801e686),
+     TOBN(0xab6b284c, 0xdf04be40), TOBN(0xc40a58e6, 0x2c216ae7),
+     TOBN(0xa6ced619, 0x018a60e8), TOBN(0x83d4cde1, 0x83e5cc65),
+     TOBN(0xe2559f51, 0xb5a91945), TOBN(0x53d9122b, 0xef0f53ee),
+     TOBN(0x474c281b, 0x32e40a83), TOBN(0x332324a7, 0x944dfe65),
+     TOBN(0xcb0a3657, 0xa1fd057d), TOBN(0xad79ae60, 0xb4aa013b),
+     TOBN(0x0b852109, 0x97ed887a), TOBN(0x5fec3e1f, 0x30d9b297),
+     TOBN(0x4ce4149f, 0x10fb9c74), TOBN(0x4e08b4d9, 0x8cbff785),
+     TOBN(0x81b0d7b4, 0x2f07cbae), TOBN(0x08bc321e, 0x495230ae),
+     TOBN(0xaec221de, 0x2b841eb8), TOBN(0x62c7d86a, 0xd83c22e6),
+     TOBN(0x5504dcf8, 0x85affe91), TOBN(0x785a06f1, 0xf445481d),
+     TOBN(0x8b68acc4, 0x18670cf4), TOBN(0x64073a95, 0xcba49dca),
+     TOBN(0x633757b0, 0x9f508534), TOBN(0x78ad9df7, 0x916f3a09),
+     TOBN(0x46187c92, 0x08617468), TOBN(0x48f37eb6, 0xc5f77b94),
+     TOBN(0x333224f0, 0xd058bb27), TOBN(0x7f28ace7, 0xd8852abb),
+     TOBN(0x8c9f634f, 0xa2e62327), TOBN(0x75212283, 0xc4116c1b),
+     TOBN(0xb7723ad0, 0xcc0c0851), TOBN(0xc8a4cff1, 0x5b72e5aa),
+     TOBN(0xd4ee3f7f, 0x6dadc46f), TOBN(0xa1f3dc92, 0x5d7febd6),
+     TOBN(0x4c0bee13, 0x63ebab5b), TOBN(0x70e32d77, 0x005ec237),
+     TOBN(0x302fc73d, 0xc52fb006), TOBN(0x1af84c0a, 0x8f159899),
+     TOBN(0x42a5478f, 0x0686232a), TOBN(0xb4fc5634, 0x8a308687),
+     TOBN(0x042c4970, 0xc8378f0d), TOBN(0x70c19575, 0x8e2c86c5),
+     TOBN(0x61a95e68, 0x84c7c767), TOBN(0xd96a8216, 0xd6fb43a8),
+     TOBN(0x67f8fa3e, 0x1a2db746), TOBN(0x2f041d4a, 0xba267cad),
+     TOBN(0xdf8126ea, 0x65bafbee), TOBN(0xf63fc68f, 0xfad7b234),
+     TOBN(0x4280e1e1, 0x702db8ab), TOBN(0xbe6122f2, 0x02468fc2),
+     TOBN(0x06b076d0, 0xc89b74de), TOBN(0xc2515543, 0x4bbdb7cc),
+     TOBN(0xae82a08f, 0x50eb6108), TOBN(0xf49da234, 0x2f0f3f5e),
+     TOBN(0x7d1923b2, 0xeca6448e), TOBN(0x9e01d58c, 0x70b144ab),
+     TOBN(0xeaf237a8, 0xee49a1bf), TOBN(0x78bf04bf, 0x4ea1da86),
+     TOBN(0x5fbffa47, 0x3f251ad5), TOBN(0xc40570f6, 0xd828578e),
+     TOBN(0x5cc65c0d, 0xd4e118ad), TOBN(0x9e18ff96, 0x5da48548),
+     TOBN(0xe27fc2e7, 0xef7e714b), TOBN(0x19ff3f7c, 0x13df7524),
+     TOBN(0x35a32fa5, 0x5e27fb12), TOBN(0x7fcfd728, 0x10003fae),
+     TOBN(0xc74b50a3, 0xf49800c1), TOBN(0xbf0732eb, 0xdbafb2e6),
+     TOBN(0x1d1b02ab, 0xc1238c95), TOBN(0x85b3878a, 0xee8c4d2b),
+     TOBN(0x23ba366c, 0xc761afd0), TOBN(0x47324d03, 0x4f023bb7),
+     TOBN(0x75902ccc, 0x388c8e5b), TOBN(0x374484b9, 0x86e2e6b6),
+     TOBN(0x38360f84, 0x9f548719), TOBN(0xdf999916, 0x41cbc7ef),
+     TOBN(0xa9cbe298, 0x5091ed27), TOBN(0xcf5a1440, 0xc5f2cb5d),
+     TOBN(0x5bdff729, 0xd413500d), TOBN(0x55530d56, 0x373f8b2d),
+     TOBN(0x0c62fd2d, 0x543c1255), TOBN(0x71ea9c6f, 0xef361a27),
+     TOBN(0x76b0933d, 0xcef3f9e3), TOBN(0x51b1ec2d, 0x9889ffa2),
+     TOBN(0x9e84b2ba, 0x9a3c88d2), TOBN(0xc8996b96, 0x1913e52f),
+     TOBN(0xbafc5e94, 0xcee43e36), TOBN(0xd9898d24, 0x70c658b7),
+     TOBN(0x4e9bcc41, 0xbed17108), TOBN(0x0db5b733, 0x6c7a41c8),
+     TOBN(0xd4be07a7, 0x795369cd), TOBN(0xb899f92f, 0x7bd3a934)},
+    {TOBN(0x3f2eff53, 0xde1e4e55), TOBN(0x6b749943, 0xe4d3ecc4),
+     TOBN(0xaf10b18a, 0x0dde190d), TOBN(0xf491b98d, 0xa26b0409),
+     TOBN(0x66080782, 0xa2b1d944), TOBN(0x59277dc6, 0x97e8c541),
+     TOBN(0xfdbfc5f6, 0x006f18aa), TOBN(0x435d165b, 0xfadd8be1),
+     TOBN(0x8e5d2638, 0x57645ef4), TOBN(0x31bcfda6, 0xa0258363),
+     TOBN(0xf5330ab8, 0xd35d2503), TOBN(0xb71369f0, 0xc7cab285),
+     TOBN(0xf16938f5, 0x14c5969b), TOBN(0xde2e3cf0, 0x944b2271),
+     TOBN(0x2d509553, 0x0b6490d6), TOBN(0x8432fef1, 0xa28a296a),
+     TOBN(0x6f254dd0, 0x8d26415c), TOBN(0x3780eead, 0xd50c2865),
+     TOBN(0x4f5bc455, 0x665b8794), TOBN(0xef31fb9e, 0x56cb7018),
+     TOBN(0xbab8dd6e, 0x65e59340), TOBN(0x676baca2, 0xa56dc2ea),
+     TOBN(0x38eea06b, 0xeaa90e05), TOBN(0x26e64224, 0x174bada0),
+     TOBN(0xe6a19dcc, 0x40acc5a8), TOBN(0x1c3a1ff1, 0xdbc6dbf8),
+     TOBN(0xb4d89b9f, 0xc6455613), TOBN(0x6cb0fe44, 0xa7390d0e),
+     TOBN(0xade197a4, 0x59ea135a), TOBN(0xda6aa865, 0x20680982),
+     TOBN(0x03db9be9, 0x5a442c1b), TOBN(0x221a2d73, 0x2bfb93f2),
+     TOBN(0x44dee8d4, 0x753c196c), TOBN(0x59adcc70, 0x0b7c6ff5),
+     TOBN(0xc6260ec2, 0x4ca1b142), TOBN(0x4c3cb5c6, 0x46cbd4f2),
+     TOBN(0xa35e411c, 0x2cb40964), TOBN(0xdd7d4f4c, 0xc331a3d6),
+     TOBN(0x7c7c859e, 0x89a66f2b), TOBN(0x9908c37e, 0x0def8ecd),
+     TOBN(0x8274124e, 0x344947b7), TOBN(0x0d279f7b, 0x568b0ce8),
+     TOBN(0xe5291961, 0x866091ec), TOBN(0xb056e3bf, 0x3a08acc7),
+     TOBN(0x60fb39e1, 0x56bd3a7d), TOBN(0xe56a34d6, 0x268f8562),
+     TOBN(0xb3a1fe16, 0x13fd8293), TOBN(0x6a41e1a9, 0x67537fcb),
+     TOBN(0x8a15d6fe, 0xa417111f), TOBN(0xfe4a16bd, 0x71d93fcc),
+     TOBN(0x7a7ee38c, 0x55bbe732), TOBN(0xeff146a5, 0x1ff94a9d),
+     TOBN(0xe572d13e, 0xdd585ab5), TOBN(0xd879790e, 0x06491a5d),
+     TOBN(0x9c84e1c5, 0x2a58cb2e), TOBN(0xd79d1374, 0x6c938630),
+     TOBN(0xdb12cd9b, 0x385f06c7), TOBN(0x0c93eb97, 0x7a7759c3),
+     TOBN(0xf1f5b0fe, 0x683bd706), TOBN(0x541e4f72, 0x85ec3d50),
+     TOBN(0x89e48d8b, 0xc6bb5e5f), TOBN(0x0880ede0, 0x1ea95a10),
+     TOBN(0x60f033d7, 0x302c0daa), TOBN(0x15e4578a, 0x048eefe3),
+     TOBN(0xfd6dec89, 0xb0a72244), TOBN(0x1f7cd75e, 0x309489cd),
+     TOBN(0x7cdcc2a0, 0xe9aba7fd), TOBN(0xd18dc5c7, 0xf28ba00f),
+     TOBN(0xa6300a45, 0x5812b55f), TOBN(0x8fa5c415, 0x2ca31d8c),
+     TOBN(0x36aa3c23, 0x4f3a5b5a), TOBN(0xd128739e, 0xc86cf4e0),
+     TOBN(0x9a0e1535, 0x81833608), TOBN(0x5cce871e, 0x6e2833ac),
+     TOBN(0xc17059ea, 0xfb29777c), TOBN(0x7e40e5fa, 0xe354cafd),
+     TOBN(0x9cf59405, 0x4d07c371), TOBN(0x64ce36b2, 0xa71c3945),
+     TOBN(0x69309e96, 0x56caf487), TOBN(0x3d719e9f, 0x1ae3454b),
+     TOBN(0xf2164070, 0xe25823b6), TOBN(0xead851bd, 0x0bc27359),
+     TOBN(0x3d21bfe8, 0xb0925094), TOBN(0xa783b1e9, 0x34a97f4e),
+     TOBN(0xd9272830, 0x13575004), TOBN(0x01a330d6, 0x20b2275e),
+     TOBN(0x58b9207f, 0x450db713), TOBN(0xae953384, 0x23e16d95),
+     TOBN(0x4f10c6d4, 0xe60e349c), TOBN(0x541d03ec, 0xfeb122bc),
+     TOBN(0x22548cd2, 0x2c648211), TOBN(0x5c2dc84c, 0xd01354f5),
+     TOBN(0xa1c6f912, 0xb6167b3c), TOBN(0x6967bab2, 0x7902d2ba),
+     TOBN(0xebbe0b08, 0x36de34ba), TOBN(0x6985b33a, 0x4b79625e),
+     TOBN(0x406b0c26, 0x9546491a), TOBN(0x9e5e15e2, 0xf293c4e5),
+     TOBN(0xc60d6413, 0x15b164db), TOBN(0x0da46f53, 0x0c75a78e),
+     TOBN(0x7c599bb7, 0xea0c656b), TOBN(0x0f07a512, 0x1b1a8122),
+     TOBN(0x14c7204a, 0x15172686), TOBN(0x8faedff8, 0x5165625d),
+     TOBN(0x20f260ce, 0x37aede40), TOBN(0xc81f771e, 0x8f357ffe),
+     TOBN(0x25499197, 0xb0912557), TOBN(0x736197dc, 0x4c739c74),
+     TOBN(0xf2d015bd, 0xaefdd5e1), TOBN(0x33b4e21c, 0x4bf9edae),
+     TOBN(0x4860aadc, 0x64b35fcc), TOBN(0x77b657e9, 0xf13f8112),
+     TOBN(0x65f28625, 0x90dc84fe), TOBN(0x4eabfd22, 0xd66be036),
+     TOBN(0xb0213123, 0x6ff05dd0), TOBN(0xa104d4aa, 0xa9fe5d11),
+     TOBN(0xdc7efe3b, 0x9b8ae390), TOBN(0x46918b54, 0xeb87fb5c),
+     TOBN(0xf5771d71, 0x72b7172a), TOBN(0x41e49e47, 0x13587bf0),
+     TOBN(0x6151bab1, 0x381b3462), TOBN(0x27e5a078, 0x43dbd344),
+     TOBN(0x2cb05bd6, 0xa1c3e9fb), TOBN(0x2a759760, 0x27cf2a11),
+     TOBN(0x0adcf9db, 0xff43e702), TOBN(0x4bbf03e2, 0x1f484146),
+     TOBN(0x0e74997f, 0x55b6521a), TOBN(0x15629231, 0xade17086),
+     TOBN(0x7f143e86, 0x7493fc58), TOBN(0x60869095, 0xaf8b9670),
+     TOBN(0x482cfcd7, 0x7e524869), TOBN(0x9e8060c3, 0x1d454756),
+     TOBN(0x3ec55ddc, 0x9004b845), TOBN(0x5101127c, 0xbe7b06eb),
+     TOBN(0xdddafd57, 0xfc4176e9), TOBN(0xd8cb31c0, 0xe4a31ddc),
+     TOBN(0x94e83a89, 0xd42feabb), TOBN(0xd4401def, 0x2f74ec68),
+     TOBN(0x9c9defb6, 0x5adb654d), TOBN(0x9a3513f0, 0x5053eeda),
+     TOBN(0xceab2dec, 0x7cdb455e), TOBN(0x99542808, 0x59d24f59),
+     TOBN(0x22ead452, 0x31d30504), TOBN(0xe9df48f9, 0x0521a229),
+     TOBN(0xe495747a, 0xc88b4d3b), TOBN(0xb7559835, 0xae8a948f),
+     TOBN(0x67eef3a9, 0xdeb56853), TOBN(0x0e20e269, 0x9dee5adf),
+     TOBN(0x9031af67, 0x61f0a1aa), TOBN(0x76669d32, 0x683402bc),
+     TOBN(0x90bd2313, 0x06718b16), TOBN(0xe1b22a21, 0x864efdac),
+     TOBN(0xe4ffe909, 0x6620089f), TOBN(0xb84c842e, 0x3428e2d9),
+     TOBN(0x0e28c880, 0xfe3871fc), TOBN(0x8932f698, 0x3f21c200),
+     TOBN(0x36dd28ea, 0x441d0806), TOBN(0x6680c72c, 0x21518207),
+     TOBN(0xc5d40e28, 0x0a484dbc), TOBN(0xdb1170c6, 0xa3a2ba6e),
+     TOBN(0x07290fd1, 0x40a91c7d), TOBN(0xdd125716, 0x95ee9ca2),
+     TOBN(0x595dad63, 0x07876188), TOBN(0x6fcf18c0, 0x499d4827),
+     TOBN(0xdcd946a3, 0x206e617d), TOBN(0x6cf08f51, 0xe7bceaef),
+     TOBN(0x7a85c02d, 0xb19a06ac), TOBN(0xf1365fc6, 0x7140a7df),
+     TOBN(0x603f00ce, 0x6c90ea5d), TOBN(0x64739307, 0x40a2f693),
+     TOBN(0xaf65148b, 0x2174e517), TOBN(0x162fc2ca, 0xf784ae74),
+     TOBN(0x0d9a8825, 0x4d5f6458), TOBN(0x0c2d5861, 0x43aace93),
+     TOBN(0xbf1eadde, 0x9f73cbfc), TOBN(0xde9c34c0, 0x9c68bbca),
+     TOBN(0x6d95602d, 0x67ef8a1a), TOBN(0x0af2581b, 0xa791b241),
+     TOBN(0x14f77361, 0x12cad604), TOBN(0x19f2354d, 0xe2acd1ad),
+     TOBN(0x9e857f33, 0x771560ab), TOBN(0x4ae1ba22, 0x250f109d),
+     TOBN(0xf8538d68, 0xff4f6566), TOBN(0x35380f15, 0xac339148),
+     TOBN(0xfef0bfdd, 0x5ddfc12f), TOBN(0xf706c6bf, 0x1387d93e),
+     TOBN(0x618ce77d, 0x5357e131), TOBN(0xf0921744, 0x236478c4),
+     TOBN(0x24eaf06e, 0x00dc0da5), TOBN(0x049113be, 0x07603cc7),
+     TOBN(0x5cf48908, 0x8f6963c7), TOBN(0xbe5eb9e6, 0xede4a300)},
+    {TOBN(0x77e486f8, 0x5d066c15), TOBN(0x0c05b6c2, 0x4ed5307d),
+     TOBN(0x322b28ab, 0x7df36628), TOBN(0x2d14d131, 0x6704dcd6),
+     TOBN(0xd359977a, 0xf29a3567), TOBN(0xc29bb132, 0xec96d3b6),
+     TOBN(0xfd6e400a, 0xe6bfa701), TOBN(0x03db9924, 0x4c7e5101),
+     TOBN(0x62d81c7d, 0x9b8533af), TOBN(0xefa638c2, 0x8de66eb8),
+     TOBN(0x7405a9d7, 0xe86784ee), TOBN(0xafaa74ef, 0xa6c22223),
+     TOBN(0xf9b2dba4, 0xb9d36e91), TOBN(0x5fb4f6ce, 0xfda9b2c4),
+     TOBN(0x7692a4f3, 0x3b8104ee), TOBN(0x5da885b0, 0xe4e1896e),
+     TOBN(0xc2a30fec, 0x73d2aa36), TOBN(0x7d06e6af, 0x86f60bca),
+     TOBN(0xbc8bf16d, 0x87287887), TOBN(0x6c3dd86a, 0x3d701bec),
+     TOBN(0x8e79e2f3, 0x7e35610a), TOBN(0x981139f4, 0x82f9d71c),
+     TOBN(0xf8997ec4, 0x24e62733), TOBN(0x330d989a, 0xa3518061),
+     TOBN(0x4e6ef410, 0xca89fbad), TOBN(0xe0fc53ba, 0x53933b78),
+     TOBN(0xa4f03403, 0xfd41d143), TOBN(0x3a507177, 0xe0774c37),
+     TOBN(0x078e8c56, 0x8ec7484a), TOBN(0xfb73c6b6, 0xfbb3f66b),
+     TOBN(0x169c9475, 0x3bfbdff6), TOBN(0x44d28606, 0x0a232243),
+     TOBN(0x3e8e9685, 0x08303114), TOBN(0x7a9797b8, 0xfad0def2),
+     TOBN(0x0ad14404, 0xefc1c8da), TOBN(0x6daae4e9, 0x21ced721),
+     TOBN(0xc7e9ddef, 0x88dd2dc2), TOBN(0x2c21a998, 0x19a0c0b5),
+     TOBN(0x6bc0746d, 0xb239bb82), TOBN(0xc811a8eb, 0x28ea1341),
+     TOBN(0x5f714ca7, 0x1d1309b0), TOBN(0x79eabd20, 0xd4eb9b34),
+     TOBN(0xe0e5afdc, 0xdf0fb30f), TOBN(0x1b01a16d, 0x8c0814c6),
+     TOBN(0x670e1e7b, 0x84334366), TOBN(0xc8c38f9a, 0x0eed1116),
+     TOBN(0xf914fae2, 0x619bbd50), TOBN(0x1ed062cb, 0x51c1995a),
+     TOBN(0xd4e60e15, 0xcb583422), TOBN(0xc6b1ef90, 0x320f296f),
+     TOBN(0x0714bad0, 0xd9bfc834), TOBN(0x5ee2ca8c, 0x9050e2c2),
+     TOBN(0x074a8ca8, 0x24f7cf1d), TOBN(0xb9750249, 0x10df8516),
+     TOBN(0xecee8ab7, 0xc2636d2c), TOBN(0x308e5af1, 0x3b4b7bbd),
+     TOBN(0xfed4f27e, 0xee2ae021), TOBN(0x7cd4bb19, 0x2065253b),
+     TOBN(0x6b21a3f8, 0x4de525b4), TOBN(0x0f10e7bd, 0xac27fddb),
+     TOBN(0xd5068487, 0x870e29cb), TOBN(0xf9420b85, 0xfc52d5cb),
+     TOBN(0x50c3265a, 0x496d000d), TOBN(0xe605414a, 0x166bd6b4),
+     TOBN(0x4de8d724, 0xc62b2a6c), TOBN(0x16af06f2, 0xa1a11048),
+     TOBN(0x5406bde9, 0x45f43c4c), TOBN(0x5e15bf6c, 0x751ad18e),
+     TOBN(0xa846e665, 0xb6a59587), TOBN(0xcdb28a7d, 0x1816ac55),
+     TOBN(0x899b3551, 0x819b73f8), TOBN(0x2d46297b, 0xbc848d08),
+     TOBN(0xdc4cc720, 0x299127be), TOBN(0x5b34e762, 0xfaab8165),
+     TOBN(0x2289b2f7, 0xb39c120d), TOBN(0x687a78d0, 0x6e52b913),
+     TOBN(0xd2a091dd, 0x2a3ea6a5), TOBN(0xc61eced6, 0x38eab329),
+     TOBN(0x652231ea, 0x7887ff2b), TOBN(0x77a56875, 0x0479db4e),
+     TOBN(0x1ef471c8, 0xd43c5722), TOBN(0xf82bf436, 0xf3764c34),
+     TOBN(0x962af405, 0x0445cafe), TOBN(0xed8b227f, 0x5ff47259),
+     TOBN(0xde849cd1, 0xd89594ab), TOBN(0x00e2d2b1, 0x0ec4fb3a),
+     TOBN(0x3fbd9e3d, 0xabe92fba), TOBN(0x785414d4, 0x3324900a),
+     TOBN(0xdaead1ab, 0xde20904e), TOBN(0xb493e121, 0xaa5f1ba8),
+     TOBN(0xd60a4f2d, 0x6eaea0dc), TOBN(0x394746b5, 0x6fca8596),
+     TOBN(0x163dc789, 0x34efa243), TOBN(0x3067dccf, 0x216a8d8c),
+     TOBN(0x116b6534, 0xa901617b), TOBN(0x8c4bd099, 0xbbabe51e),
+     TOBN(0xc8c2df45, 0xac3a082c), TOBN(0xc353d074, 0xc8d4c40e),
+     TOBN(0xb214f9c0, 0x5a3c2de7), TOBN(0x504bc42c, 0xf86b0214),
+     TOBN(0xc82df5cb, 0xd1922a58), TOBN(0x40887948, 0xa5bc3267),
+     TOBN(0x04bcd217, 0x88ba8bb2), TOBN(0xe21b3e7f, 0x046fd401),
+     TOBN(0x8419c338, 0x616af5cf), TOBN(0x7f24760b, 0xaedfce9d),
+     TOBN(0xded8035b, 0xddbd519a), TOBN(0x1f1fb0d7, 0x1693faab),
+     TOBN(0xbb067b49, 0xd02ffcf6), TOBN(0x7cedf8f9, 0x3e657299),
+     TOBN(0xc3829961, 0x406bbfe3), TOBN(0xefe4b5aa, 0x37c12472),
+     TOBN(0x7dc01cf9, 0xfec7dee8), TOBN(0x70a9db23, 0x89472f50),
+     TOBN(0x29c269f8, 0xb31bf737), TOBN(0xa26deac3, 0xae3fa7db),
+     TOBN(0x0046e912, 0x33caca41), TOBN(0x3bf4bc8a, 0xb6e78b55),
+     TOBN(0xca83bc6c, 0xd9eb5ef1), TOBN(0x73f25c62, 0xc0c5deff),
+     TOBN(0x697dc47d, 0x44b4aae8), TOBN(0xb3525cc0, 0x782c331c),
+     TOBN(0xff71cca4, 0x0bd7c78c), TOBN(0x5f3d7766, 0x10c0ab69),
+     TOBN(0xbdc10267, 0xe2ba07e3), TOBN(0xc656f75c, 0xe6373f6e),
+     TOBN(0x9e2938b4, 0xb5607b62), TOBN(0xa65017d4, 0x10b0a0f7),
+     TOBN(0x8dad3119, 0x5cc6ac25), TOBN(0x00f8f2d1, 0x8ba5d1e6),
+     TOBN(0x608137bc, 0x43305aef), TOBN(0xddad34bb, 0xdcb81cb1),
+     TOBN(0xe133d941, 0xb1f82ca5), TOBN(0x2af8b98b, 0xfdf115bf),
+     TOBN(0xdc6179c8, 0x57aaa6f3), TOBN(0xabaa83e9, 0x130ade06),
+     TOBN(0x7836b6fb, 0x0e8bffd1), TOBN(0xc479751f, 0xfa103703),
+     TOBN(0x0ff3c129, 0x9c89963b), TOBN(0xe6407256, 0x0b84c24f),
+     TOBN(0xa92a4ea2, 0xf34f6bc9), TOBN(0xba45b305, 0x3197989b),
+     TOBN(0xd12b5a01, 0x99243aab), TOBN(0x3015772c, 0x442af625),
+     TOBN(0xd95fca81, 0xe6f065c5), TOBN(0x45e886d5, 0xfc8655de),
+     TOBN(0x35809577, 0x27cff79e), TOBN(0x92a39a34, 0x625877d9),
+     TOBN(0xdda02684, 0xdfee17ee), TOBN(0x6354f871, 0x986f635b),
+     TOBN(0xb3a6e9ed, 0xd409c182), TOBN(0xf0b1c8d9, 0xc4fbbb3a),
+     TOBN(0x28721c01, 0x9b77aded), TOBN(0x3c356df1, 0xbf94f028),
+     TOBN(0xff221bd2, 0x29a81f1a), TOBN(0x20edf2e8, 0x56b20b0d),
+     TOBN(0x97fff124, 0x835fda9e), TOBN(0xa79ceb2f, 0x0bc68512),
+     TOBN(0x70ba93d1, 0xa2fc3995), TOBN(0x62bd28ab, 0x9e51c5ee),
+     TOBN(0xb95fa624, 0xd5bbbaa9), TOBN(0x0654dc45, 0x8c1f571e),
+     TOBN(0xb9a4edc6, 0x65a45ed6), TOBN(0xbf5ed1bc, 0x21ad0612),
+     TOBN(0x74adc1a1, 0xb1a3551b), TOBN(0x3dfa3dc8, 0xdbbd6cef),
+     TOBN(0xce5dd40b, 0x2fa3afd2), TOBN(0x14894e0f, 0x30a746ca),
+     TOBN(0x7e729c58, 0xb8ca2a2c), TOBN(0x0f32ea1e, 0xcaac04af),
+     TOBN(0x47267f13, 0xbdd549e3), TOBN(0x35b94406, 0x90be3b50),
+     TOBN(0xad0f2bb1, 0x4b27f670), TOBN(0xd7e5874e, 0x92341803),
+     TOBN(0x7dc841cf, 0x1f9ec462), TOBN(0xebeff994, 0x512b2a42),
+     TOBN(0x22998a7f, 0x320dc858), TOBN(0xf08eb5c7, 0x19946f59),
+     TOBN(0x228c8dcd, 0xa68ea75e), TOBN(0x40dc6dc3, 0x7b20dee5),
+     TOBN(0x929454f6, 0xb3952db4), TOBN(0x412142ec, 0x4d3f69f5),
+     TOBN(0xf5b0a7c5, 0xee25c0b0), TOBN(0x7d3372ff, 0x2e752295),
+     TOBN(0xd6dadc7d, 0x6eacac68), TOBN(0x5f0076cc, 0xa96a8e3c),
+     TOBN(0xea831db6, 0x71725b3a), TOBN(0x4a286c89, 0xc29ab454),
+     TOBN(0x5ff817e5, 0x72e3c00c), TOBN(0xb022e25d, 0x2a5fb6ba),
+     TOBN(0xb611c5bc, 0xbb392476), TOBN(0x062c14dc, 0x190485a0)},
+    {TOBN(0x0372678d, 0xc419b0aa), TOBN(0xf95031d8, 0xc13fdf17),
+     TOBN(0xebaebca4, 0xb79594c3), TOBN(0xe587850b, 0xaf3b75cf),
+     TOBN(0x534183ac, 0x2c1e09c6), TOBN(0x3f5b0bfd, 0xc08204cd),
+     TOBN(0xdac2cf06, 0xe297cc77), TOBN(0x5e47d9c6, 0xd0487084),
+     TOBN(0xf6f509f4, 0x90b0f6c2), TOBN(0x3ffc3cd6, 0xc2c62207),
+     TOBN(0xbb21eb11, 0x32ff1887), TOBN(0x2116a023, 0xe62ccc6f),
+     TOBN(0x406a7e21, 0x16960728), TOBN(0xd03923f8, 0x5597d8c4),
+     TOBN(0xd4402eff, 0x020748ee), TOBN(0x7827442a, 0xf39b58db),
+     TOBN(0x77e3f276, 0x8d8cfb04), TOBN(0xf6eb49c8, 0xe45a978f),
+     TOBN(0x9db08299, 0x49247f6a), TOBN(0xce71a747, 0x06669fe5),
+     TOBN(0xe434ce47, 0xb82775f5), TOBN(0xe84995ef, 0x63910016),
+     TOBN(0xa35e8b97, 0x1e47792f), TOBN(0xc779cb3d, 0x7c6aaeb9),
+     TOBN(0x66428800, 0xff381db7), TOBN(0xa9b9d019, 0x55574ac6),
+     TOBN(0x30cdc21f, 0xbdf4a86c), TOBN(0x2ec38d35, 0x741c4a26),
+     TOBN(0x35496c23, 0x0b6be057), TOBN(0xaecc67e6, 0x01656b1f),
+     TOBN(0x781af00f, 0xf7d70324), TOBN(0xac0e6579, 0x5d7ee71e),
+     TOBN(0x60a35c6c, 0xa6b14e3a), TOBN(0xacd6813b, 0x0e6c1c3a),
+     TOBN(0xd7f77024, 0x1faeef73), TOBN(0xd2254b8f, 0x23eddf05),
+     TOBN(0x1fa064cf, 0xaf31ea1d), TOBN(0x2a9547a8, 0x48e8d974),
+     TOBN(0xda8102a1, 0xfa9d9453), TOBN(0x786aecab, 0xdc6bd7ea),
+     TOBN(0xcaf91e3b, 0xca2f6044), TOBN(0x67d86ea7, 0x8573f208),
+     TOBN(0xd309fce9, 0xc505ae24), TOBN(0x67ddc5b1, 0x7f86eb8e),
+     TOBN(0x57791ae0, 0xf3d53056), TOBN(0x26b053f0, 0x0d1fd61e),
+     TOBN(0x91c962c0, 0x045ebfa6), TOBN(0xe95246de, 0x076ed979),
+     TOBN(0xc49c9989, 0x5f6e9ea4), TOBN(0x4a91578b, 0xe16ec8e4),
+     TOBN(0xa1c54e89, 0x0aeb5ac5), TOBN(0xa9094b07, 0xee09b9a0),
+     TOBN(0x3587752f, 0x09a74b27), TOBN(0x973bf8b0, 0x44bbfed0),
+     TOBN(0x91c26f23, 0x5636a52e), TOBN(0x8ac948b8, 0xeb7e3b41),
+     TOBN(0x14234675, 0xfc457d56), TOBN(0xde98e4fa, 0xc76398a3),
+     TOBN(0xa80f7311, 0x0f4a46e0), TOBN(0xcba089bd, 0x22b66fa3),
+     TOBN(0x156eaf57, 0x0746d174), TOBN(0xa2d4a83d, 0xcda35250),
+     TOBN(0x60a9f48c, 0x0290fa02), TOBN(0x9855d26d, 0x5c33b4ac),
+     TOBN(0x06e379c6, 0x97eb1c30), TOBN(0x4f2e2dbe, 0x6e219664),
+     TOBN(0x6b7448f8, 0x29006065), TOBN(0x237a1f31, 0x115062a9),
+     TOBN(0x5c635a90, 0xad92cb24), TOBN(0x2e857f8c, 0x2eed977e),
+     TOBN(0x3d512df7, 0x856dc88a), TOBN(0xbde85263, 0xe597a27b),
+     TOBN(0x0b114aea, 0x10a98e42), TOBN(0x6133aa52, 0xae19dd14),
+     TOBN(0x0c235df2, 0xa99eb2c5), TOBN(0x0085a619, 0x7f59582c),
+     TOBN(0xf9002bba, 0x8cf7feba), TOBN(0x275742d7, 0xaf6a3261),
+     TOBN(0x302b4823, 0x249e8e9e), TOBN(0xa142aba9, 0xce696f91),
+     TOBN(0xdeb28c44, 0x64c37b14), TOBN(0x14bb8f23, 0x0766002f),
+     TOBN(0xafeff88b, 0xc52fe891), TOBN(0xb9d493ae, 0x46faeb2d),
+     TOBN(0x49f24994, 0xe7c03ce4), TOBN(0x274a8c13, 0x2aed9ba3),
+     TOBN(0x897b9103, 0xd5e91bc0), TOBN(0x63db1efb, 0xcb404f68),
+     TOBN(0x70efd9d8, 0x42f7fc02), TOBN(0xd6e02921, 0xc6a230af),
+     TOBN(0x8d5b199f, 0x11ae0a56), TOBN(0xc98287de, 0xce33da6a),
+     TOBN(0xde583d34, 0x504dd889), TOBN(0x03756001, 0xf823686f),
+     TOBN(0xf19ab86f, 0x95fc73dc), TOBN(0x300406c6, 0x93f12f42),
+     TOBN(0x68fdb78a, 0xa427d89c), TOBN(0x84e9ba49, 0xa3944c0d),
+     TOBN(0x1c3569b1, 0xc1833422), TOBN(0x30773fc0, 0x1a01f4b9),
+     TOBN(0x18b8f17d, 0x7da01321), TOBN(0x8370fb0f, 0x7198c85e),
+     TOBN(0xda12c8d4, 0x99a898e3), TOBN(0x7667b46a, 0x8ba82ded),
+     TOBN(0x2aab259b, 0x77e1e31f), TOBN(0xd03f7708, 0xbe71c9bc),
+     TOBN(0x9f784cce, 0x8e43eb38), TOBN(0x7ddedc8b, 0x21c1208c),
+     TOBN(0x2f73595f, 0x7759701c), TOBN(0x8dc2069a, 0x6fe0e0d9),
+     TOBN(0xb7de7114, 0xc286a65d), TOBN(0xfecc429e, 0x84c0e487),
+     TOBN(0x51061a2c, 0x14344c07), TOBN(0x4d709725, 0x96869e37),
+     TOBN(0x8b02781f, 0x2be9403b), TOBN(0x6cb6aa02, 0xde3ab5d9),
+     TOBN(0xb013508e, 0xff6bdc9a), TOBN(0x568d2e84, 0xe5438c58),
+     TOBN(0x7b35a979, 0xe4206c3b), TOBN(0x0bb793c0, 0xb17a8bc7),
+     TOBN(0x41248052, 0x57ed2360), TOBN(0xfc0cb1b6, 0x6ba9bd95),
+     TOBN(0x342f16db, 0x2337a8fd), TOBN(0xe1417411, 0x88099007),
+     TOBN(0xc96c29ee, 0x8cd74752), TOBN(0x376047cc, 0xedf5fb4a),
+     TOBN(0x5f40ce08, 0x439546c1), TOBN(0x14d2c666, 0x1a235de8),
+     TOBN(0x9b66892d, 0x98e355f0), TOBN(0x8a65f6dd, 0xa4bb19e9),
+     TOBN(0xf72848f8, 0x046a2581), TOBN(0xfed74b3b, 0x8373b2b6),
+     TOBN(0x3f896ca9, 0xfa4dd561), TOBN(0x4b9a98ab, 0xd2de2ecb),
+     TOBN(0xd0741632, 0x600e4e2a), TOBN(0x87c7db5f, 0x69e702d5),
+     TOBN(0x1f5a3b80, 0x53e0df2b), TOBN(0xe1e24b49, 0xf443dfba),
+     TOBN(0xeb90e230, 0x5eef3a1d), TOBN(0x8f3fc8a6, 0xd38f73fc),
+     TOBN(0xfb1e8299, 0xa5aa335a), TOBN(0xd78504cd, 0x4197b32a),
+     TOBN(0x0e7a79cc, 0x6755918e), TOBN(0xc7c98ae2, 0x883b1c72),
+     TOBN(0x4b74fcbd, 0x969088c1), TOBN(0x4d16f895, 0x361a8c96),
+     TOBN(0xefcb6ced, 0x760d61fa), TOBN(0x3f14a7cb, 0xcc3e8808),
+     TOBN(0x51f5fd2c, 0x664ea335), TOBN(0xe0cad090, 0x3a65d305),
+     TOBN(0x86409de9, 0x031a6911), TOBN(0x23ea4aed, 0xe5f9715b),
+     TOBN(0x6e5b8cea, 0x1f3532c6), TOBN(0x33fc873e, 0x11271ead),
+     TOBN(0x842b59a6, 0x5b8131d7), TOBN(0xbd95818a, 0x61b7bf60),
+     TOBN(0x1a12727c, 0x03d2becc), TOBN(0x810a37df, 0xc6741372),
+     TOBN(0x44ac483f, 0xb7049f39), TOBN(0xab73e5e7, 0xa36fc614),
+     TOBN(0x298d453f, 0xeeff8aeb), TOBN(0x2127dd16, 0x7e1b586b),
+     TOBN(0xeadc5c54, 0xe07bd60c), TOBN(0x67cdae00, 0xf5e2d2e2),
+     TOBN(0x03fe0446, 0xc9d2f10a), TOBN(0x07840987, 0x95e38ed2),
+     TOBN(0x5d348a7c, 0xe1a6306e), TOBN(0x4903f1b6, 0x562f5463),
+     TOBN(0x906ab8a8, 0x4a3862e8), TOBN(0x8fc76114, 0xb2f5c878),
+     TOBN(0x2dac3952, 0x2035287f), TOBN(0xaa8372f3, 0x18af4378),
+     TOBN(0x915050c9, 0xdbf64476), TOBN(0x896f734d, 0xe992d0c8),
+     TOBN(0x5c3e36da, 0x3a35846c), TOBN(0xfe774b4a, 0xac8f4fc3),
+     TOBN(0x66347050, 0xaadd8a59), TOBN(0xea94ebda, 0x2cd12be8),
+     TOBN(0x45b1e7e2, 0xdab94de0), TOBN(0x539d580e, 0x264b508c),
+     TOBN(0xbf66baa5, 0xb44b1d0c), TOBN(0xbbed18ed, 0xa44f8eda),
+     TOBN(0x80bc32ab, 0xeaaa466c), TOBN(0x605b7897, 0xe5f2733b),
+     TOBN(0xe9e7e3a1, 0xa2531afa), TOBN(0x25d66db3, 0x3deb8369),
+     TOBN(0x36212ea3, 0xb2f25d10), TOBN(0x52d6b3f4, 0xa08d303e),
+     TOBN(0xefa54b31, 0x444e9e9f), TOBN(0x9c2229a1, 0x69530c1b),
+     TOBN(0x68feb985, 0x4b79bdd1), TOBN(0xd570e84f, 0x8b984cc3)},
+    {TOBN(0xd6a4d25c, 0x845f26e4), TOBN(0x71e554ce, 0x1b039dff),
+     TOBN(0x94205973, 0x1cdedfc0), TOBN(0x0c4e3856, 0x03d6502f),
+     TOBN(0x981a4fc5, 0xe15ce8c8), TOBN(0x85d1b0f1, 0x7aca30b7),
+     TOBN(0xf2037ef7, 0x77bb9e43), TOBN(0xc52804f4, 0xe87ae187),
+     TOBN(0x9c98a23c, 0x71f3e4e3), TOBN(0xa73c8b89, 0xf47b504b),
+     TOBN(0xb9e33f54, 0x023233aa), TOBN(0xf2bcfc17, 0xf92c9f68),
+     TOBN(0xba03ba3b, 0x7b3b336d), TOBN(0xe57ce509, 0x28c9c55d),
+     TOBN(0xf96b8cfe, 0x4f0f60b2), TOBN(0xb908d77e, 0x6fcccd96),
+     TOBN(0x7208ef7d, 0xe79dd17a), TOBN(0x73909533, 0x3ec3d048),
+     TOBN(0x9c5ad2da, 0x1163fe78), TOBN(0x4e2a8685, 0xcd4a15c2),
+     TOBN(0xac999449, 0x470eb938), TOBN(0xfaaf27fb, 0xee7d772f),
+     TOBN(0xfbe402ab, 0xd0b7ad09), TOBN(0x704d4f0e, 0x57db00a9),
+     TOBN(0xe93ee31a, 0xe12b4e64), TOBN(0x2ab8e378, 0x662d17f4),
+     TOBN(0x2544bd99, 0x69516582), TOBN(0x7bf80e4b, 0x2e1e5485),
+     TOBN(0xf30f0b14, 0x729d9361), TOBN(0xb3ffb5d1, 0x8268d40f),
+     TOBN(0x34605055, 0xac193a63), TOBN(0x9e5ca9a9, 0xf8e04d69),
+     TOBN(0xcbbeebc1, 0x085ecbb2), TOBN(0xda03b75b, 0xf340eac4),
+     TOBN(0x3bf9468a, 0x84436462), TOBN(0xdfa8b4c8, 0x0f26f20c),
+     TOBN(0x10c082a6, 0x3fc14a85), TOBN(0x59389ebc, 0x1c0b14c4),
+     TOBN(0x785d935b, 0x4cb291a7), TOBN(0xfc2ae153, 0x13e9ce08),
+     TOBN(0x3146fabf, 0x4df6f1c4), TOBN(0xa2a4a457, 0xc87dd24c),
+     TOBN(0x85fdd877, 0x1deb49bb), TOBN(0x2b784370, 0x9b055934),
+     TOBN(0xc81d0501, 0x3e7e0297), TOBN(0xb56ddd1f, 0xb92df904),
+     TOBN(0x4612df9f, 0x295ddccb), TOBN(0xc24bd4cf, 0x0e27cf1d),
+     TOBN(0x5564875b, 0x422ea2c0), TOBN(0xabc2e7de, 0x8285b03f),
+     TOBN(0xfd662091, 0x733e9f1f), TOBN(0x68f16745, 0x68465da3),
+     TOBN(0x965a0a05, 0x38fa6f63), TOBN(0x0ed70fee, 0xdfae710d),
+     TOBN(0x56c6227f, 0x153b24da), TOBN(0xf1dcf574, 0x01470f6e),
+     TOBN(0x9992caa8, 0xf51771cf), TOBN(0xa884b481, 0x14a9b029),
+     TOBN(0xad11cbaa, 0x7b9a4062), TOBN(0x60ec99d8, 0xe55533e0),
+     TOBN(0x86d9b060, 0x18674f49), TOBN(0x81b06486, 0x97bb1a7d),
+     TOBN(0x9b6e8e7c, 0x27d9d64c), TOBN(0x79bd66ba, 0xba04e6ad),
+     TOBN(0x77e4d0b0, 0x828abbbe), TOBN(0xae7548ac, 0xcc540d04),
+     TOBN(0xf5d8a46f, 0x869cbebf), TOBN(0x99fb1a63, 0x38a6cc83),
+     TOBN(0xb93bb852, 0x563fe6b4), TOBN(0x06bb3ae9, 0x97cdd04f),
+     TOBN(0x07f011d4, 0x8b7de47d), TOBN(0x8d90e2e4, 0xde78f61c),
+     TOBN(0x731c6dd6, 0xd33cb6e2), TOBN(0xa3ea317e, 0x8cce0290),
+     TOBN(0xdca9b2f9, 0x1c42206e), TOBN(0x6acbbce9, 0xd1e5dfd9),
+     TOBN(0x40745846, 0x2fc948cd), TOBN(0xc7a50d91, 0xa82f9cec),
+     TOBN(0xb906d69e, 0x4c1aa161), TOBN(0x3a9b14be, 0x0ebe948e),
+     TOBN(0x11a9f12c, 0xb63aeb70), TOBN(0x0365b4cc, 0xead745f2),
+     TOBN(0x5f6c2bbd, 0xf9f16c17), TOBN(0x89131238, 0xa03e558e),
+     TOBN(0x7830460f, 0xd1944d1b), TOBN(0xc56f08e7, 0x84350af2),
+     TOBN(0x73bee2aa, 0x307d9c78), TOBN(0x1b02af1b, 0x5aad8b6c),
+     TOBN(0x5e318827, 0x03848db5), TOBN(0x4785958b, 0xf230f476),
+     TOBN(0x4ea6535d, 0x4f80e25d), TOBN(0x9958c9c7, 0xd23c7f72),
+     TOBN(0x4c197b33, 0x2fd33cab), TOBN(0x24c7b0b1, 0xc566914f),
+     TOBN(0x956ce3c3, 0x71952d3b), TOBN(0x8735694b, 0xfabae5f2),
+     TOBN(0xde37ae28, 0x40ec913c), TOBN(0xdc915f83, 0x056685b3),
+     TOBN(0xf7bc3488, 0xf66a4501), TOBN(0x30e61042, 0x6a900e5f),
+     TOBN(0x505525c1, 0xca3cf645), TOBN(0x35338c53, 0xb1f3ed40),
+     TOBN(0x6823159a, 0xd70b7c41), TOBN(0x660f518a, 0x7384ba7c),
+     TOBN(0xc6cf6a4b, 0x2482056b), TOBN(0xb308b215, 0x1df15990),
+     TOBN(0xba63b2e3, 0xfb5c130b), TOBN(0x1c660db8, 0x277b7515),
+     TOBN(0x8a95e5c1, 0xfddc9fdd), TOBN(0x679d4e0f, 0x5adab0c3),
+     TOBN(0x1859df6a, 0xcda40bc0), TOBN(0xf9097aa5, 0x8234471d),
+     TOBN(0xaddc0c9b, 0x783c0100), TOBN(0x55388dc8, 0xfeb7067c),
+     TOBN(0xe3805fd1, 0x80a2eac7), TOBN(0xf800a75c, 0xec886879),
+     TOBN(0xa4599992, 0x1943a0a0), TOBN(0xb47f0619, 0x1dfe627e),
+     TOBN(0x313d4f09, 0xda06515f), TOBN(0xde26052d, 0x1f54a73e),
+     TOBN(0x85a1b879, 0x6827365d), TOBN(0x595a6915, 0x667debe8),
+     TOBN(0x214670fb, 0x93a3d50f), TOBN(0x9dfb028e, 0xb37de08e),
+     TOBN(0xdd077e2f, 0x9c6cf2a9), TOBN(0x96897d8f, 0xc9b96e8e),
+     TOBN(0xe6e93c07, 0xefd39543), TOBN(0x19dcdaa4, 0x4454e73d),
+     TOBN(0x4a67424f, 0xd7b8c758), TOBN(0x03d4de0d, 0xb1e91e2a),
+     TOBN(0x7c843988, 0xe887b6b6), TOBN(0x7db4f3da, 0x6ffdcfff),
+     TOBN(0x0db87bc3, 0xd8bb43ec), TOBN(0xbf71d27c, 0x13a7b669),
+     TOBN(0xea81e9c4, 0xa3fd2a60), TOBN(0x190c9c71, 0xc9f017e5),
+     TOBN(0x21864180, 0xbcc75768), TOBN(0x137bd615, 0x43dbcde6),
+     TOBN(0x5b090c71, 0x5d468ff5), TOBN(0x3a622b60, 0x126c6bc6),
+     TOBN(0xfef3d268, 0xa918bf24), TOBN(0xe10c52c8, 0xae204f49),
+     TOBN(0xf4be898d, 0x86d7c356), TOBN(0x8276da18, 0x2fdb5a17),
+     TOBN(0x89c992af, 0x7f2ad562), TOBN(0x7e1459d9, 0xafc83ad3),
+     TOBN(0x4c0d9681, 0x9278dd04), TOBN(0x4496d9a7, 0xd8eebe36),
+     TOBN(0x7c037261, 0xb8d4b1a2), TOBN(0x827c49a5, 0xbad3d6d7),
+     TOBN(0xf4d94deb, 0x836926ae), TOBN(0x65417bf6, 0x4064af58),
+     TOBN(0xa79471ac, 0xfcdafc9f), TOBN(0x3f85ccb4, 0x8123312d),
+     TOBN(0x4d374cad, 0xa3360be4), TOBN(0x56b476d6, 0xee325a2b),
+     TOBN(0x0079c69d, 0x41af8c08), TOBN(0x7dcfa4f4, 0xacbe515e),
+     TOBN(0xb8d18666, 0x01396859), TOBN(0x08590ca4, 0x946fbedd),
+     TOBN(0x7fecd9b9, 0x641aace4), TOBN(0xaad5cc44, 0x2936a1b6),
+     TOBN(0x925b6235, 0xf92c5958), TOBN(0x7b1442f1, 0x82d6231e),
+     TOBN(0x971e663d, 0x8c6fb34a), TOBN(0x543146dc, 0x2fc1c10d),
+     TOBN(0x6e4053c7, 0x0642b822), TOBN(0x4a49f247, 0x492e524d),
+     TOBN(0x1b51f7b4, 0x17ba53f1), TOBN(0x170ff1eb, 0x3d5c43bf),
+     TOBN(0xc2f160f8, 0x681f7ee7), TOBN(0x4c0a54d0, 0x47814310),
+     TOBN(0xfc689a13, 0xa83d061c), TOBN(0x1cbc99b4, 0x7ff6333d),
+     TOBN(0xe19fd790, 0x6581cd16), TOBN(0x67da79c7, 0x9ca37b0c),
+     TOBN(0x2507d167, 0x63bd0b5c), TOBN(0x4449985b, 0x1befb82b),
+     TOBN(0x6bea3969, 0x914699ec), TOBN(0x9f606dd4, 0xef202abb),
+     TOBN(0xca9872e1, 0x597bd10e), TOBN(0x6725cc9a, 0x4aed951f),
+     TOBN(0x96b17cb8, 0x4e05b280), TOBN(0x97987146, 0xfa234d45),
+     TOBN(0xba78949e, 0xbb35a7d8), TOBN(0xb82e9b9f, 0x6fc59384),
+     TOBN(0xa303e54a, 0x70f165c7), TOBN(0xfd6bb0dc, 0xb9c2cad9),
+     TOBN(0xe57e2de8, 0xee722045), TOBN(0xa05c1065, 0x63e27035),
+     TOBN(0xaa38e866, 0x02d2fe6f), TOBN(0x78e02fa8, 0xee2f6aad)},
+    {TOBN(0xc0426b77, 0x5e3c647b), TOBN(0xbfcbd939, 0x8cf05348),
+     TOBN(0x31d312e3, 0x172c0d3d), TOBN(0x5f49fde6, 0xee754737),
+     TOBN(0x895530f0, 0x6da7ee61), TOBN(0xcf281b0a, 0xe8b3a5fb),
+     TOBN(0xfd149735, 0x41b8a543), TOBN(0x41a625a7, 0x3080dd30),
+     TOBN(0xe2baae07, 0x653908cf), TOBN(0xc3d01436, 0xba02a278),
+     TOBN(0xa0d0222e, 0x7b21b8f8), TOBN(0xfdc270e9, 0xd7ec1297),
+     TOBN(0x4f120aa7, 0xe2a07891), TOBN(0x9158bab3, 0xa25d3225),
+     TOBN(0xc96bac5e, 0xcfe5f7a8), TOBN(0xd4e73d59, 0xbbf3cec6),
+     TOBN(0xed8d2335, 0x60361cd5), TOBN(0x9b1a252c, 0x562f444c),
+     TOBN(0xbd37d3cf, 0xc70f23c2), TOBN(0xf13b3b6e, 0xa52ea19e),
+     TOBN(0x7e35535a, 0x3d2f41ed), TOBN(0x0353b52e, 0xe8b1743e),
+     TOBN(0x31d89dfd, 0x7b5a2765), TOBN(0x2b7ac684, 0x8d9ea8b8),
+     TOBN(0x06a67bd2, 0x9f101e64), TOBN(0xcb6e0ac7, 0xe1733a4a),
+     TOBN(0xee0b5d51, 0x97bc62d2), TOBN(0x52b17039, 0x24c51874),
+     TOBN(0xfed1f423, 0x82a1a0d5), TOBN(0x55d90569, 0xdb6270ac),
+     TOBN(0x36be4a9c, 0x5d73d533), TOBN(0xbe9266d6, 0x976ed4d5),
+     TOBN(0xc17436d3, 0xb8f8074b), TOBN(0x3bb4d399, 0x718545c6),
+     TOBN(0x8e1ea355, 0x5c757d21), TOBN(0xf7edbc97, 0x8c474366),
+     TOBN(0x73457010, 0xc46db855), TOBN(0xccb68c43, 0xdd579fb8),
+     TOBN(0x705b0e8c, 0x9c25fe5b), TOBN(0x40f36ea1, 0x82dd0485),
+     TOBN(0x3d55bc85, 0x27ac2805), TOBN(0x15177c6f, 0xad921b92),
+     TOBN(0x51586cd5, 0x5ab18cab), TOBN(0xf51b5296, 0xcbb4488c),
+     TOBN(0xbb4e605e, 0x84f0abca), TOBN(0x354ef8e3, 0x772dd0da),
+     TOBN(0x7f1a8f79, 0x5e4e1d41), TOBN(0x93461f09, 0xde5d8491),
+     TOBN(0xec72c650, 0x6ea83242), TOBN(0xf7de7be5, 0x1b2d237f),
+     TOBN(0x3c5e2200, 0x1819efb0), TOBN(0xdf5ab6d6, 0x8cdde870),
+     TOBN(0x75a44e9d, 0x92a87aee), TOBN(0xbddc46f4, 0xbcf77f19),
+     TOBN(0x8191efbd, 0x669b674d), TOBN(0x52884df9, 0xed71768f),
+     TOBN(0xe62be582, 0x65cf242c), TOBN(0xae99a3b1, 0x80b1d17b),
+     TOBN(0x48cbb446, 0x92de59a9), TOBN(0xd3c226cf, 0x2dcb3ce2),
+     TOBN(0xf3899558, 0x9311182c), TOBN(0x1bee4c4b, 0xb657a7b7),
+     TOBN(0x0b1c4fd3, 0x2df8d1a7), TOBN(0xf16bcc23, 0x76d3fbbf),
+     TOBN(0xd5888916, 0xf4fd52bc), TOBN(0x3de6cfb4, 0xd5cde1f0),
+     TOBN(0x764ffffd, 0xd4a07dfd), TOBN(0x5e674426, 0xe2642182),
+     TOBN(0x34f64762, 0xccd57b85), TOBN(0x2233a4c3, 0x29351062),
+     TOBN(0xdf076095, 0xd9c642f3), TOBN(0xac917a2c, 0x59f0df34),
+     TOBN(0x9580cdfb, 0x9fd94ec4), TOBN(0xed273a6c, 0x28631ad9),
+     TOBN(0x5d3d5f77, 0xc327f3e7), TOBN(0x05d5339c, 0x35353c5f),
+     TOBN(0xc56fb5fe, 0x5c258eb1), TOBN(0xeff8425e, 0xedce1f79),
+     TOBN(0xab7aa141, 0xcf83cf9c), TOBN(0xbd2a690a, 0x207d6d4f),
+     TOBN(0xe1241491, 0x458d9e52), TOBN(0xdd2448cc, 0xaa7f0f31),
+     TOBN(0xec58d3c7, 0xf0fda7ab), TOBN(0x7b6e122d, 0xc91bba4d),
+     TOBN(0x3bd258d8, 0x775f516f), TOBN(0x4bedebd5, 0xc715927f),
+     TOBN(0x5b432512, 0xe3f966a0), TOBN(0x338bfca7, 0x709d0c2d),
+     TOBN(0xd142cc10, 0x49658259), TOBN(0xfabc6138, 0x636b8023),
+     TOBN(0xa9ef9401, 0x4d4ef14d), TOBN(0xd5917ac1, 0xc54c570c),
+     TOBN(0xfd2f63c5, 0x5cb64487), TOBN(0xbae949b1, 0x1cea475b),
+     TOBN(0xa4544603, 0x1e67a25f), TOBN(0xa547abc1, 0xdc6a7a6a),
+     TOBN(0x2a2dedaf, 0xb1b48156), TOBN(0xa0a2c63a, 0xbb93db87),
+     TOBN(0xc6559078, 0x08acd99e), TOBN(0x03ea42af, 0xfe4ac331),
+     TOBN(0x43d2c14a, 0xeb180ed6), TOBN(0xc2f293dd, 0xb1156a1a),
+     TOBN(0x1fafabf5, 0xa9d81249), TOBN(0x39addead, 0x9a8eee87),
+     TOBN(0x21e206f2, 0x119e2e92), TOBN(0xbc5dcc2e, 0xd74dceb6),
+     TOBN(0x86647fa3, 0x0a73a358), TOBN(0xead8bea4, 0x2f53f642),
+     TOBN(0x158d814d, 0xb12c4bb1), TOBN(0xe52f75d2, 0x2f0cf4fa),
+     TOBN(0xf106023e, 0x6141b59c), TOBN(0x5eb8b8eb, 0xbeb9d941),
+     TOBN(0x1dd39729, 0x90cf579c), TOBN(0xb273252e, 0x69ee6efa),
+     TOBN(0xe43a3c59, 0x3e9947a0), TOBN(0xd605124f, 0x6c19dd01),
+     TOBN(0x8090fdbd, 0x05c578b0), TOBN(0x8e6c535a, 0x622ff18c),
+     TOBN(0x3600b0c2, 0x57d12071), TOBN(0x6d026e5c, 0x78d001d7),
+     TOBN(0x636225f5, 0x91c09091), TOBN(0xccf5070a, 0x71bdcfdf),
+     TOBN(0x0ef8d625, 0xb9668ee2), TOBN(0x57bdf6cd, 0xb5e04e4f),
+     TOBN(0xfc6ab0a6, 0x7c75ea43), TOBN(0xeb6b8afb, 0xf7fd6ef3),
+     TOBN(0x5b2aeef0, 0x2a3df404), TOBN(0x31fd3b48, 0xb9823197),
+     TOBN(0x56226db6, 0x83a7eb23), TOBN(0x3772c21e, 0x5bb1ed2f),
+     TOBN(0x3e833624, 0xcd1aba6a), TOBN(0xbae58ffa, 0xac672dad),
+     TOBN(0x00e0a003, 0xdaff1807), TOBN(0xcb9d1559, 0x92c94fd0),
+     TOBN(0x3c2b5c3d, 0xcebbf905), TOBN(0x9c799ec7, 0xd338afa9),
+     TOBN(0x60b9908c, 0x4e2cfccc), TOBN(0x4bfe1a57, 0xae3c6f92),
+     TOBN(0x480d310e, 0xfb116150), TOBN(0xa1ed6c31, 0xe3e7888e),
+     TOBN(0x841a11d9, 0x720b5196), TOBN(0xcc337d17, 0x8adff37d),
+     TOBN(0x08c66826, 0x5faa86c5), TOBN(0x945c90d4, 0x9dfcc7ad),
+     TOBN(0xce92224d, 0x31ba1705), TOBN(0x022c6ed2, 0xf0197f63),
+     TOBN(0x21f18d99, 0xa4dc1113), TOBN(0x5cd04de8, 0x03616bf1),
+     TOBN(0x6f900679, 0x9ff12e08), TOBN(0xf59a3315, 0x48e61ddf),
+     TOBN(0x9474d42c, 0xb51bd024), TOBN(0x11a0a413, 0x9051e49d),
+     TOBN(0x79c92705, 0xdce70edb), TOBN(0x113ce278, 0x34198426),
+     TOBN(0x8978396f, 0xea8616d2), TOBN(0x9a2a14d0, 0xea894c36),
+     TOBN(0x9f9ac960, 0x8e2941a6), TOBN(0x43e7ff90, 0x2fc4fe1e),
+     TOBN(0x5ec41359, 0x6033e041), TOBN(0x5ce791c4, 0x6f6ff0f3),
+     TOBN(0x8d134b89, 0x9d907343), TOBN(0x7bd15c77, 0x86304df2),
+     TOBN(0x2cd2ebc7, 0x77c4a913), TOBN(0xcd86a39d, 0x45f07153),
+     TOBN(0xe7e12d2e, 0x88bc423b), TOBN(0x478e814b, 0x0b3163f4),
+     TOBN(0x78bd9c8a, 0xbe8ec766), TOBN(0x6a5763e8, 0x7709ce48),
+     TOBN(0x4f1e1254, 0x604f6e4a), TOBN(0x4513b088, 0x0187d585),
+     TOBN(0x9022f257, 0x19e0f482), TOBN(0x51fb2a80, 0xe2239dbf),
+     TOBN(0x49940d9e, 0x998ed9d5), TOBN(0x0583d241, 0x6c932c5d),
+     TOBN(0x1188cec8, 0xf25b73f7), TOBN(0xa28788cb, 0x3b3d06cd),
+     TOBN(0xdea194ec, 0xa083db5a), TOBN(0xd93a4f7e, 0x22df4272),
+     TOBN(0x8d84e4bf, 0x6a009c49), TOBN(0x893d8dd9, 0x3e3e4a9e),
+     TOBN(0xd699ea2d, 0x8d095606), TOBN(0x3cd080c5, 0x1e0ddd3a),
+     TOBN(0x46604bad, 0x66a8b35b), TOBN(0x0c779b62, 0x4233fccb),
+     TOBN(0x578458ac, 0xbfd3cf0c), TOBN(0x6820f665, 0x96bf57af),
+     TOBN(0xa9724245, 0xbf1f302c), TOBN(0xbbde24da, 0x277a6c3e),
+     TOBN(0x0980a5b8, 0xc6be8c14), TOBN(0x6230e3ec, 0x774d62c4),
+     TOBN(0xda1467d8, 0x4fbde24b), TOBN(0xd9d68d07, 0xcc862204)},
+    {TOBN(0x67c51634, 0x7378f90d), TOBN(0xbc201a79, 0x66647082),
+     TOBN(0x77fcc8dc, 0x9ee450cf), TOBN(0x8dd2b318, 0xb41a3e2f),
+     TOBN(0xdf6a935e, 0x93bf0689), TOBN(0x75edabf3, 0xa92e5464),
+     TOBN(0x49afcd9f, 0x604d208a), TOBN(0x372f0ea7, 0xd465ca48),
+     TOBN(0xcdbd8ad2, 0xc7ea7810), TOBN(0xfe61571e, 0x550822b2),
+     TOBN(0x744a4f93, 0x86606adc), TOBN(0x6beb3c9c, 0xd9d4e110),
+     TOBN(0x1fef389c, 0xe700b9f2), TOBN(0x63029466, 0x425bc8ab),
+     TOBN(0xbd770a14, 0x37f04a33), TOBN(0xc7438e29, 0xd0169369),
+     TOBN(0x6b265742, 0xe2377cc3), TOBN(0xdf24bf96, 0xc369fa4f),
+     TOBN(0xdfdbcf47, 0x0ad94e08), TOBN(0xd101b861, 0x7f75a7dc),
+     TOBN(0x5574a0b8, 0x2a9c483c), TOBN(0x0563fe94, 0x2de43228),
+     TOBN(0x58ca0e8a, 0xead1fabe), TOBN(0xdc3d9a84, 0x66023966),
+     TOBN(0x383bda07, 0xc3fd20e5), TOBN(0x9619b1df, 0x5c29449b),
+     TOBN(0x6f3c717d, 0x369f39bf), TOBN(0x1bb593d1, 0x1a5a3900),
+     TOBN(0xd0f07ecc, 0x2aec6c2b), TOBN(0x9d72eb2a, 0x4240b202),
+     TOBN(0x35342f6c, 0xc50e4a0c), TOBN(0x701b4662, 0x6b93bf61),
+     TOBN(0xfcd6eb09, 0xccb6a888), TOBN(0xabb7a6f7, 0x85aa42c5),
+     TOBN(0x952f8824, 0xaa4e5895), TOBN(0x49860db8, 0x5c406582),
+     TOBN(0x3667a720, 0x3955812b), TOBN(0x0d73483b, 0x284d1dac),
+     TOBN(0xe084535e, 0xfc62f791), TOBN(0x5bc1652b, 0x389faf7f),
+     TOBN(0x40cf5168, 0x3a71b7f6), TOBN(0x8a4b19fa, 0xd4f39703),
+     TOBN(0x823e754a, 0x2a8eff13), TOBN(0xf01b2021, 0xbffa5afc),
+     TOBN(0x5639ee02, 0x7225b319), TOBN(0x7533bc86, 0xfc282f16),
+     TOBN(0x710009d2, 0xc69f61ae), TOBN(0xe30c499d, 0xbf65e803),
+     TOBN(0x0da7ac1b, 0x734b4ec3), TOBN(0xf47fc1d0, 0x12a2afbe),
+     TOBN(0xbbbc99be, 0x87dce4a2), TOBN(0xf7264b4e, 0xdd5c6378),
+     TOBN(0xe9409305, 0xf618ffdc), TOBN(0xafadda9b, 0xd1846ac1),
+     TOBN(0xe734f9d0, 0xa21850d4), TOBN(0x199cb44f, 0x8722a316),
+     TOBN(0xcfe8704b, 0x38cae89f), TOBN(0x2db1e56b, 0x6b151b57),
+     TOBN(0x116ca5cf, 0x69ce7b2c), TOBN(0xe9b8625f, 0x57de97c8),
+     TOBN(0x18811bd5, 0xaf247c49), TOBN(0xbc180793, 0xe124dbda),
+     TOBN(0xed978d3a, 0x21234fc4), TOBN(0x516dd9a7, 0x0616ae15),
+     TOBN(0x8f806777, 0x74e430b8), TOBN(0x90942569, 0x06e8fc49),
+     TOBN(0x4ca03fb5, 0xa4e61235), TOBN(0xb91de709, 0xb617f361),
+     TOBN(0x0898d82d, 0x0ed08bc3), TOBN(0x2bd71236, 0x8cb08146),
+     TOBN(0x45b92d45, 0xe213176d), TOBN(0x05894791, 0xf2bf5b9c),
+     TOBN(0x0d79cb89, 0x2695ea2b), TOBN(0x2cb0f8df, 0xc88e538a),
+     TOBN(0xc1b8dc3d, 0xa80f36fe), TOBN(0xd756fa66, 0x84f00cc2),
+     TOBN(0xa6f1cdec, 0x9cb9efb2), TOBN(0x5c3f15a8, 0xa6a21818),
+     TOBN(0x9a7ee351, 0x6995d09f), TOBN(0x88885463, 0xd70434bf),
+     TOBN(0x18cecc6d, 0x4f7d5d33), TOBN(0x3f013886, 0x6b353bd1),
+     TOBN(0x53bf798b, 0x0d9ad368), TOBN(0xeffd465a, 0x28dbc3ee),
+     TOBN(0xeb29e44c, 0xb5d98ac1), TOBN(0xe47e57f8, 0x0e227a4f),
+     TOBN(0xd09c0494, 0x3d2bf688), TOBN(0x3ab7799a, 0x47428dd2),
+     TOBN(0xdc558d6b, 0xe9aafac8), TOBN(0xc042c4cd, 0x87f9f6e0),
+     TOBN(0x93842bcd, 0x89fb4693), TOBN(0x62dbc82f, 0x7068fbf7),
+     TOBN(0x16455268, 0x7e6d47b5), TOBN(0xab304b7a, 0x4c37eeee),
+     TOBN(0xdbb3d4e1, 0x3fc412ce), TOBN(0x4f65dad0, 0xa726a2c8),
+     TOBN(0xb25e01b2, 0x605cdaee), TOBN(0x74abec55, 0xbc57969d),
+     TOBN(0x9c57bfab, 0xcdd9d41a), TOBN(0xa3330e3f, 0x4a9e32a3),
+     TOBN(0x5929a0d8, 0xe5792fd8), TOBN(0x830b4ea2, 0x71ea2cde),
+     TOBN(0x80065ac1, 0xfd06d246), TOBN(0xa2b416e6, 0x32e64a25),
+     TOBN(0x3950bde7, 0xc0c927a9), TOBN(0x9951f3bd, 0x679d9b8c),
+     TOBN(0xc235a274, 0x651b6855), TOBN(0xbfe5e08e, 0x5ad97bc1),
+     TOBN(0x4409a5b6, 0x744ae145), TOBN(0x5e83fa0b, 0x7f620908),
+     TOBN(0xfc489bec, 0x2e140aa0), TOBN(0x5805a462, 0xe3cae337),
+     TOBN(0xe56e9ff7, 0xc2211c21), TOBN(0xb722f2b4, 0x0c955362),
+     TOBN(0xb098a32f, 0x41371f33), TOBN(0xe6ccecea, 0xbb4923d6),
+     TOBN(0x1cfbe2b3, 0xd82a311c), TOBN(0xcf942893, 0x6b98f917),
+     TOBN(0xd60dc624, 0x92ef848c), TOBN(0x34af446e, 0x5adb5228),
+     TOBN(0x0eb7e743, 0x796ce1ca), TOBN(0x138653e5, 0xd851377c),
+     TOBN(0x69c7c86f, 0x2b11c8e0), TOBN(0x878ec1de, 0xcdf2b205),
+     TOBN(0x03e6688a, 0xae0e8562), TOBN(0x20810666, 0x935a36a8),
+     TOBN(0xc8ab7c7f, 0x26635c50), TOBN(0xe75cdb06, 0x744a21db),
+     TOBN(0x4e26f32f, 0xd720e198), TOBN(0xa1c6395a, 0xd8cded81),
+     TOBN(0xb75dc6ea, 0x6ce4fc04), TOBN(0x71750b33, 0x004623b5),
+     TOBN(0xbdef8407, 0x7e60c447), TOBN(0x88570f71, 0x2a65acca),
+     TOBN(0xef3d4a40, 0x0bb6aa79), TOBN(0x5c9d1890, 0x60212976),
+     TOBN(0x80179ea2, 0x1d96c43c), TOBN(0x3f002e6d, 0x53d2948e),
+     TOBN(0x14b2cc91, 0x49d78183), TOBN(0x7a549c71, 0xb496c279),
+     TOBN(0xf4beac3f, 0x44995f6d), TOBN(0x5a342398, 0x00bc78fe),
+     TOBN(0xa874dc1b, 0x60e42da0), TOBN(0x3a984010, 0xcf5824d5),
+     TOBN(0xe514ee06, 0xdfb9760c), TOBN(0xb8862d75, 0x77b8951f),
+     TOBN(0x0144676e, 0xf8ee1141), TOBN(0x49561a30, 0x02eb3e82),
+     TOBN(0xb3541c15, 0x4ff9f897), TOBN(0x1670edf0, 0xa7a99791),
+     TOBN(0xd41d6035, 0x64aea7f9), TOBN(0xf66ffd09, 0x2b3463b4),
+     TOBN(0x0784e015, 0xc3b26fb6), TOBN(0x88edce33, 0xec46f8c8),
+     TOBN(0x1b1e25a3, 0xb6381011), TOBN(0xbfaadc03, 0xff95ab97),
+     TOBN(0x727a59fe, 0x0c7be4e1), TOBN(0x75a7d5e3, 0xf58ced15),
+     TOBN(0x146fc0d9, 0x90f569e7), TOBN(0x94dbccd2, 0xb7f1dc54),
+     TOBN(0x0df1ef90, 0xb75bf232), TOBN(0x2943a082, 0xa2568190),
+     TOBN(0x75f2f80d, 0x67837b06), TOBN(0x07e3506f, 0x24b44b6e),
+     TOBN(0x7c30829a, 0xd0d2231b), TOBN(0x9ce577ca, 0x93277abf),
+     TOBN(0xa19d1868, 0xb17549ec), TOBN(0x0ad6ff55, 0x25e8c4d7),
+     TOBN(0x16b38dfe, 0x1c24d075), TOBN(0x3acd4c36, 0x992959f6),
+     TOBN(0xdaf2fe88, 0xac2da7ab), TOBN(0x76e8ff0e, 0x89644935),
+     TOBN(0xb8547c26, 0xe85f7076), TOBN(0x9f149faa, 0x1cdea7ce),
+     TOBN(0x181a6072, 0x9e125d84), TOBN(0xc4aef9fa, 0x18751ce6),
+     TOBN(0x451c8466, 0x0e00f00a), TOBN(0x662b3e7a, 0xc4e3e6b8),
+     TOBN(0x57b7114e, 0xc6b64507), TOBN(0x07aeb198, 0x0b37fb70),
+     TOBN(0x79d88e00, 0x4516234a), TOBN(0x98dd3cb9, 0x31f9ceda),
+     TOBN(0xb528000f, 0xce7d606e), TOBN(0xc773557e, 0x2fa27fd3),
+     TOBN(0x55b53dd3, 0xe19436af), TOBN(0x675084b3, 0xe10b64c7),
+     TOBN(0xe5832665, 0x56d56374), TOBN(0xf8f7fd2a, 0x307e2e60),
+     TOBN(0x7b93bf53, 0x7af3e3dc), TOBN(0x94fafa2c, 0xf47d298c),
+     TOBN(0x94c2ff9a, 0x21121369), TOBN(0xa41de95f, 0x33468ff6)},
+    {TOBN(0xbe45d81a, 0x1b270599), TOBN(0x50696e7d, 0x97d6c603),
+     TOBN(0x63c5a516, 0xb078ea89), TOBN(0x9f3efe41, 0xb4464764),
+     TOBN(0x84580e24, 0x101e5232), TOBN(0x00850a1a, 0xc8ae8220),
+     TOBN(0xbff4077d, 0xed55c404), TOBN(0xd74de734, 0xf2e7bf50),
+     TOBN(0x4df4eef2, 0x07e1c03d), TOBN(0x4ab3d039, 0x6e654d58),
+     TOBN(0xb20056cd, 0x086f1596), TOBN(0xe4d08a27, 0x8acd7cd5),
+     TOBN(0x8cd6c9f7, 0xc90b13f5), TOBN(0xec0c187d, 0x52a9d469),
+     TOBN(0x9c0db0f5, 0x89b8ad2b), TOBN(0x692a8db7, 0x0d9c999d),
+     TOBN(0xa407fd03, 0xc9f84ab4), TOBN(0xa5742fd1, 0xcc9a906c),
+     TOBN(0x4813a765, 0xc8e72867), TOBN(0x9c65943d, 0xe2e9a10f),
+     TOBN(0xca6bf293, 0x4fa0a23e), TOBN(0x1dfa3af7, 0xcb1f8d7a),
+     TOBN(0x28036f54, 0x98d10c53), TOBN(0x7bfbcaf2, 0x0e012c13),
+     TOBN(0x2d9513a9, 0x893e8032), TOBN(0x49257f7a, 0xf4688db4),
+     TOBN(0x73d8b12c, 0x3af4d9ac), TOBN(0x903dc9fa, 0x48a13c4d),
+     TOBN(0x6190753e, 0x60709433), TOBN(0xa093364e, 0x49387d24),
+     TOBN(0x0436949e, 0x3b261e16), TOBN(0x96db3b27, 0x4a3055b6),
+     TOBN(0x514eacc7, 0xe85dfe23), TOBN(0x1538b25c, 0x5d8805c9),
+     TOBN(0xd4c6b75b, 0x664a20f6), TOBN(0xd1984f21, 0x4753292d),
+     TOBN(0xa53f1a10, 0x4ec177f6), TOBN(0x4a2ef9aa, 0x3faa5ca8),
+     TOBN(0x30efed85, 0x32976d13), TOBN(0xcf5ada16, 0x5ee692d1),
+     TOBN(0x3ceda69d, 0x259e7cc1), TOBN(0x2aae29e9, 0x9baab472),
+     TOBN(0x7ee5baef, 0x737cc8bc), TOBN(0x1717af74, 0x7fe68ded),
+     TOBN(0x9e5c8dda, 0xcfdaff63), TOBN(0x575c8db9, 0xcec07693),
+     TOBN(0x9afc8ae0, 0xfdfb509d), TOBN(0x27836d36, 0x85651697),
+     TOBN(0x9d152839, 0x85e79c26), TOBN(0x8d87faad, 0xd36ab6f7),
+     TOBN(0x08d4fe09, 0xa87afe15), TOBN(0x1e10b10f, 0xfab81fd4),
+     TOBN(0x3cbd17d3, 0x93c98a84), TOBN(0xbd40a4e8, 0x246ceed3),
+     TOBN(0x582d9de0, 0x9a09d134), TOBN(0x120440c2, 0x4ee37dec),
+     TOBN(0x4d4ff934, 0x2f1073e4), TOBN(0x7da76757, 0xf45e648d),
+     TOBN(0x4427a608, 0xebcbb80b), TOBN(0xc6bccb54, 0x30e661a7),
+     TOBN(0xb7b7628f, 0x135e2a30), TOBN(0x863552c4, 0xb526fa7b),
+     TOBN(0x6ec18d05, 0xe0e30451), TOBN(0x1b36c93a, 0x5769db60),
+     TOBN(0xf0fe0007, 0x170c236c), TOBN(0xeceb540c, 0x66130046),
+     TOBN(0x86a7a74d, 0x3fc4bdbe), TOBN(0x066b097b, 0xfbae3320),
+     TOBN(0x78fb5247, 0x6e5c21ae), TOBN(0x3e19e9fc, 0xe1adf398),
+     TOBN(0x429b9cbd, 0x1a32a745), TOBN(0xedd2c40f, 0x36d1a2b8),
+     TOBN(0x993ca8a9, 0xceeaeed7), TOBN(0xb2d28681, 0x62545429),
+     TOBN(0x24003737, 0x91cf32d4), TOBN(0xda9ef96f, 0xd88bd4f0),
+     TOBN(0x916a4947, 0xe1b2d52a), TOBN(0x5ef7f9d0, 0xf31b107c),
+     TOBN(0x3c424ba8, 0x62d3d3cb), TOBN(0xab155cc2, 0x7c3c3bba),
+     TOBN(0x6a0404b2, 0x4bae8070), TOBN(0x5f3d0592, 0xdf36677c),
+     TOBN(0x7c9f2bef, 0x9a0e4800), TOBN(0x6babbcb4, 0x97959a09),
+     TOBN(0xa7342f95, 0x17eb9264), TOBN(0x9264a6a0, 0x0a8a6eef),
+     TOBN(0x50e48bf0, 0x7471c384), TOBN(0x729e5ab1, 0x30827f34),
+     TOBN(0x17199191, 0xea779c23), TOBN(0xd13ab853, 0x9fa9fd58),
+     TOBN(0x7d579937, 0x3b1d773e), TOBN(0x65f8e7c6, 0xd196c3df),
+     TOBN(0x253f7d51, 0xe8541725), TOBN(0x107a793d, 0xec720355),
+     TOBN(0x1c14d056, 0x6aa16268), TOBN(0x9dc5fca3, 0x8bbb231b),
+     TOBN(0x69935431, 0x897a05a4), TOBN(0x34397b68, 0x51eaa290),
+     TOBN(0x90ec1a37, 0xf58fb7a5), TOBN(0xf10d0783, 0x50c4d76b),
+     TOBN(0xeb9db48c, 0xcc47f990), TOBN(0xef0b97a2, 0x0cea5865),
+     TOBN(0x04708d6f, 0xd9f94396), TOBN(0x82ff5771, 0x41c21452),
+     TOBN(0x772d8493, 0xdbb65bdd), TOBN(0x561abc8b, 0xddf73c8c),
+     TOBN(0x98a56463, 0x9830ff05), TOBN(0x73e28296, 0x9f0d4cad),
+     TOBN(0x7fa7064e, 0x589cb234), TOBN(0xdfa4e846, 0x65ca4f3c),
+     TOBN(0x476b6618, 0x792d5254), TOBN(0xc0ce93bc, 0x583bdaeb),
+     TOBN(0x30b11dac, 0xe4ab5dc9), TOBN(0x237a64e5, 0xf5c89e2f),
+     TOBN(0x54339fad, 0x7dba60b7), TOBN(0x0072505a, 0x084b09ed),
+     TOBN(0x5e89c81f, 0xb140717a), TOBN(0xd56de3a2, 0xb407595d),
+     TOBN(0x9f3a6c42, 0x0aab0d25), TOBN(0x6c2aa69d, 0xa685543d),
+     TOBN(0xda5fcddc, 0x6cd00d89), TOBN(0x0b8c3feb, 0xac9ef99d),
+     TOBN(0x16569ca8, 0xa19298e3), TOBN(0x5d998d56, 0x2783ac1d),
+     TOBN(0x298c681c, 0xc18ecbdf), TOBN(0x209323d1, 0xe6e13de4),
+     TOBN(0xe064255e, 0xbd75118d), TOBN(0x78f69fd3, 0x43f945ef),
+     TOBN(0x9a4d591f, 0x95e6ff8f), TOBN(0xfa621d46, 0x3b378848),
+     TOBN(0x4c951f31, 0xe4d12bb8), TOBN(0xefe8d01b, 0x00ebfea6),
+     TOBN(0xf5689c5e, 0x12b09f53), TOBN(0xc1da32e1, 0x9e87ff7d),
+     TOBN(0x1af879d0, 0x12eaa533), TOBN(0xdba775e6, 0xd9271e94),
+     TOBN(0x60f85073, 0x10e63c34), TOBN(0x445f3e21, 0xa686a24b),
+     TOBN(0xed5ca8fa, 0x15bc277e), TOBN(0x9839198a, 0x364ab7ab),
+     TOBN(0xe2ee3942, 0x6d90a7d4), TOBN(0xe5b3e4cb, 0xccd37e76),
+     TOBN(0x9013bd08, 0xf1412e0f), TOBN(0x82f5c532, 0xce999048),
+     TOBN(0xdd7ff816, 0xf4bbf123), TOBN(0xbf1a5fd0, 0xde3e9923),
+     TOBN(0x8c388f8c, 0x68d10f94), TOBN(0x4e9cf0c4, 0x45057388),
+     TOBN(0xcff64aa3, 0x8d010855), TOBN(0x4b639596, 0x7d8f55fc),
+     TOBN(0xca314522, 0xbddc00c5), TOBN(0x95482d72, 0x3da89cfa),
+     TOBN(0xb9bf18b8, 0x9eb9a710), TOBN(0x0936a88e, 0x4651cc5d),
+     TOBN(0xec20ac01, 0xf59d0f45), TOBN(0x011a4868, 0x8ba74374),
+     TOBN(0x07252272, 0xf9c4caf8), TOBN(0x9b016799, 0x290ab63f),
+     TOBN(0xeaa616bb, 0x558d649d), TOBN(0x00f2ef38, 0xa66d8089),
+     TOBN(0x284b0146, 0xf72863ae), TOBN(0x9a207d77, 0x1968cf45),
+     TOBN(0x33d7bac8, 0xbdcbb689), TOBN(0x393f34d5, 0xe5348dae),
+     TOBN(0xeb86c8f1, 0x6f524620), TOBN(0x62500c62, 0x610689f8),
+     TOBN(0x66febc05, 0x6b7fa65e), TOBN(0x39c8a70b, 0xfb836b3e),
+     TOBN(0xb91977b5, 0x5e4d0351), TOBN(0xd8ed39aa, 0x9e8dddf7),
+     TOBN(0x9ae994c2, 0x9d1b25c3), TOBN(0x7369e189, 0x6ca7b19b),
+     TOBN(0x33deb695, 0xec0d7c2c), TOBN(0xddcc6250, 0xede6435b),
+     TOBN(0x44b7ba23, 0x145a654d), TOBN(0x653ee81a, 0xd280567e),
+     TOBN(0x7694c972, 0x0a39d324), TOBN(0xf0af25b1, 0xe97e1710),
+     TOBN(0x6e154646, 0x3ee1a076), TOBN(0x062ce983, 0x7ccfde8c),
+     TOBN(0x61d0e01b, 0xf3fe3441), TOBN(0x674e5233, 0x2af47609),
+     TOBN(0xd4a4e224, 0xb362902d), TOBN(0x45923c12, 0x9e0a5d16),
+     TOBN(0x4fc2bdd4, 0x95e580e9), TOBN(0x6d1d974c, 0xa8c3d954),
+     TOBN(0xaeff1135, 0xd0bbeaaa), TOBN(0x013ab5b3, 0x1baafc9e),
+     TOBN(0x80907d3e, 0xab8f9f31), TOBN(0xaf2c1216, 0x6d566c15),
+     TOBN(0x0082daba, 0x952e6fa7), TOBN(0xa4671003, 0x2df9e03a)},
+    {TOBN(0x5f79f0df, 0x1fd64063), TOBN(0xd2d39dd3, 0x81e118ec),
+     TOBN(0xd631a68e, 0x11571c5b), TOBN(0x6d072b4e, 0x2474faf7),
+     TOBN(0x5e043a6d, 0x862a924a), TOBN(0xcae58bd8, 0xb0fc8d7a),
+     TOBN(0xf54bb7f3, 0xb1351f28), TOBN(0x4588b628, 0x0413275e),
+     TOBN(0x81459f4c, 0x5909ec04), TOBN(0xd28cda25, 0xabd16460),
+     TOBN(0xbb676d01, 0x8db1c69e), TOBN(0xc0056e2d, 0xac5036f4),
+     TOBN(0xdbe04c30, 0x44ce3ad8), TOBN(0x995fbb1b, 0x4ce8aad5),
+     TOBN(0xdbf8b546, 0x70911457), TOBN(0x9e683b5b, 0x3f7a1757),
+     TOBN(0x7b89a08a, 0x9c7bd62c), TOBN(0x448865a4, 0x0b3fc97e),
+     TOBN(0x0ac9abfc, 0x3bb01e94), TOBN(0xa0776042, 0x1e756124),
+     TOBN(0x0aa6c335, 0xd9deed97), TOBN(0xe270580f, 0x72603e08),
+     TOBN(0x70857a94, 0x6c783bb2), TOBN(0xa0047774, 0xcaa929ae),
+     TOBN(0x292f8874, 0xb25c4d4a), TOBN(0x54961fd8, 0x7e79f526),
+     TOBN(0x949a1fae, 0x008c6ec9), TOBN(0x6ae82f0d, 0x525524fd),
+     TOBN(0xd1f6f4ef, 0x2edbcb1a), TOBN(0x41617a6d, 0x977ddffb),
+     TOBN(0x6ae38fb7, 0x1baf0668), TOBN(0xa79ea228, 0xd538ab3c),
+     TOBN(0x70babb05, 0xfc44e273), TOBN(0x247384fb, 0xbca85910),
+     TOBN(0xdc0e069b, 0x6a564959), TOBN(0x37a9c552, 0x1a7438ad),
+     TOBN(0xf071c987, 0x8fa06859), TOBN(0x0083e531, 0x1a52390b),
+     TOBN(0x845eb12a, 0x61483bc2), TOBN(0x17471d80, 0x1caf6dd6),
+     TOBN(0x7b603616, 0xddc21b92), TOBN(0xd38fe0f6, 0xb992536d),
+     TOBN(0x433f0652, 0x297c25a4), TOBN(0x03d4d8fc, 0xb1c4bf41),
+     TOBN(0xdf617386, 0xa9adf49b), TOBN(0x4bfeb399, 0x2cb2944f),
+     TOBN(0xbf288427, 0xb3d9c076), TOBN(0x17818c3e, 0x965b4576),
+     TOBN(0x2bb798ff, 0x689f43ef), TOBN(0x5813e441, 0x5f26ec54),
+     TOBN(0x51f64c49, 0x5005c929), TOBN(0x60e213a5, 0x4b42e417),
+     TOBN(0xc1528442, 0x62cc3734), TOBN(0x6ecd6c3b, 0x09d994e1),
+     TOBN(0xa6e72f71, 0x83dd047f), TOBN(0x3836f663, 0xb0019803),
+     TOBN(0xbcf1265b, 0x257493cb), TOBN(0x59b15ff0, 0x9e62d78b),
+     TOBN(0xaac5ed5b, 0x6cb92ecf), TOBN(0x37e6ad7d, 0x9662651c),
+     TOBN(0xce23a19a, 0xa17e560c), TOBN(0x6491b95f, 0x62550e2b),
+     TOBN(0xc7200012, 0x1d15a005), TOBN(0x15fde735, 0xf4355a1f),
+     TOBN(0x3849761f, 0x607f7807), TOBN(0xcbe322d0, 0x18204691),
+     TOBN(0x75756e4e, 0xa95e8e91), TOBN(0x365959fe, 0x817a9b8e),
+     TOBN(0x63123276, 0x3d4ce3dc), TOBN(0xa769d2fe, 0xf1d66e00),
+     TOBN(0x8624ddba, 0xc28829e6), TOBN(0x03274297, 0xd2df06ef),
+     TOBN(0x52fced31, 0x16f01d7b), TOBN(0x88c6b172, 0xdaf046aa),
+     TOBN(0x1a189403, 0xfe7a338e), TOBN(0x39741ecd, 0x61798b1e),
+     TOBN(0x6a47b071, 0x2934b879), TOBN(0x3b1a5dd1, 0x828d1e9d),
+     TOBN(0xd4bd4848, 0x7f35a7ef), TOBN(0x71774b5b, 0xc1eebaf8),
+     TOBN(0xa86471e5, 0xd55344ba), TOBN(0xfbf145f1, 0x7b8a483a),
+     TOBN(0x70f9b214, 0xaa53802c), TOBN(0x995af930, 0x10b066e1),
+     TOBN(0x9ec11597, 0x27a28f9d), TOBN(0x96f2c44b, 0xb847cd83),
+     TOBN(0xacf794e1, 0x31fca111), TOBN(0x438b9178, 0x96076f45),
+     TOBN(0xad71035b, 0x51732588), TOBN(0x2db32f32, 0xa5d910da),
+     TOBN(0xefaad0e8, 0xfe1cc184), TOBN(0x6f0360b5, 0x2e00bbed),
+     TOBN(0x99402426, 0x474ce326), TOBN(0xd53b687a, 0x2aa270da),
+     TOBN(0x96c8bb78, 0xd78fa6eb), TOBN(0xd07f3bba, 0x6e699411),
+     TOBN(0x07276886, 0x361dae4c), TOBN(0xb26f2579, 0x84c57896),
+     TOBN(0xe8b59ef5, 0x5f0c2bf4), TOBN(0xf544c145, 0xdd64aaac),
+     TOBN(0xa9dc03bb, 0x9fdcb039), TOBN(0xeb1e9aeb, 0x58c44b72),
+     TOBN(0x39a4fe8e, 0x1d6bf26e), TOBN(0x2c4285cc, 0xeaf8e241),
+     TOBN(0x647ce584, 0x14770f31), TOBN(0xe5bfeb70, 0x062f0912),
+     TOBN(0x7031db80, 0xe8314467), TOBN(0xac970937, 0xd658d2cd),
+     TOBN(0x2dfc39e6, 0xefe1757b), TOBN(0xab52fbf3, 0xb5d2cb93),
+     TOBN(0x1cf12123, 0x313aa477), TOBN(0x785b025b, 0x9c6acbd1),
+     TOBN(0xb4aeb5b8, 0xe4d54177), TOBN(0xde3d28f8, 0xd943c1ea),
+     TOBN(0x7892db85, 0x5b0b1921), TOBN(0xc09ff903, 0x58caff2d),
+     TOBN(0xbdee13c6, 0x1cbd3231), TOBN(0x873e0a77, 0x00b6c34e),
+     TOBN(0xb279505a, 0xe23de32b), TOBN(0xf056ffdc, 0xc5a03302),
+     TOBN(0x0ac76959, 0x6ba563ee), TOBN(0x2053a5fb, 0xb9a51868),
+     TOBN(0x60e2555f, 0x06178e3c), TOBN(0x1bc99e72, 0xc0933775),
+     TOBN(0x4a2d31b2, 0xb7d5160e), TOBN(0x7cc03ff3, 0x895d1db8),
+     TOBN(0x98fb331e, 0xee53e79f), TOBN(0xc2f0a93f, 0x8583b893),
+     TOBN(0x8fa79ed8, 0x49802eb4), TOBN(0xe9548175, 0x55ce8dcd),
+     TOBN(0xb5155a21, 0x1d4d44f1), TOBN(0xbb044d28, 0x89570a82),
+     TOBN(0x430b669f, 0xe1f833e0), TOBN(0x1797ac3a, 0x6d8127bd),
+     TOBN(0x01ad730c, 0x4c33493e), TOBN(0x8c882c1f, 0xca00ed39),
+     TOBN(0xab2e9c89, 0xd24a5516), TOBN(0x21a49e0a, 0xf5d0327d),
+     TOBN(0x46488bd8, 0x58a280d1), TOBN(0xfc4a1e8a, 0x772ed759),
+     TOBN(0xf9f60e90, 0xaecfac7c), TOBN(0x4afd1f5f, 0xac6a9e8c),
+     TOBN(0x57a20bf8, 0xc98bcda8), TOBN(0xa1107ea0, 0x8b46b998),
+     TOBN(0xe931c21b, 0x45fc08c4), TOBN(0x13fad41f, 0x3aca653f),
+     TOBN(0xf28a3515, 0xec1fe395), TOBN(0x191a4f2d, 0xcf55cc91),
+     TOBN(0x46fb07b7, 0x90535f59), TOBN(0x76c60cc1, 0xd69686a9),
+     TOBN(0x1e7dec15, 0xc8122c04), TOBN(0x0743fcf0, 0x1b72798c),
+     TOBN(0xb10c96bd, 0x1e5939fd), TOBN(0x261e6c0a, 0x6e8338e5),
+     TOBN(0x56148d3c, 0xe5cdaa43), TOBN(0x3f004371, 0xa031239a),
+     TOBN(0x1f2f6c1f, 0x0db0c9c0), TOBN(0xca4e1964, 0xac770b5f),
+     TOBN(0x20dce4a6, 0x569c090b), TOBN(0xe4f7401a, 0xdb3986d0),
+     TOBN(0x13897994, 0x85f553ea), TOBN(0x119ad50d, 0x09026bff),
+     TOBN(0x88067aa7, 0xe265a0a9), TOBN(0x209c62b4, 0x7f749167),
+     TOBN(0x84165019, 0x459bf269), TOBN(0xec125bd5, 0x8b6e76f6),
+     TOBN(0xd636f932, 0x1f0d2434), TOBN(0xf6023a4c, 0x8e05e0b0),
+     TOBN(0x84c14e31, 0x65ea2b23), TOBN(0xb68121be, 0x19e93301),
+     TOBN(0x9c1a873f, 0xb25d9a83), TOBN(0xafb9d04c, 0xd13773f0),
+     TOBN(0xd05014da, 0x51c32d57), TOBN(0xff2e350b, 0x0904efdc),
+     TOBN(0x20bd7d22, 0xa0a01069), TOBN(0x3e74eb0f, 0x6c3b3fd8),
+     TOBN(0x643ea531, 0xb743b72c), TOBN(0xa2fe7414, 0x8e3ae785),
+     TOBN(0xb8fe89bf, 0x92e8d320), TOBN(0x58985dc1, 0x495f6d28),
+     TOBN(0xfe1f11ad, 0x389283ba), TOBN(0xc87e20b6, 0x0cd91b22),
+     TOBN(0x99d0015a, 0x3c5babf8), TOBN(0x7e795b4d, 0x5929ea0a),
+     TOBN(0xc9cf6833, 0x1dfb7b7e), TOBN(0xc1c07346, 0xa64992e8),
+     TOBN(0x0b7e0dd8, 0x9889746d), TOBN(0xa89d7b46, 0x1c43ea4a),
+     TOBN(0x64023cf0, 0x34f02b96), TOBN(0xf7dd410a, 0x5662f0c8),
+     TOBN(0xa3bb6088, 0xa1058cca), TOBN(0xedb25dc3, 0x4e7801ed)},
+    {TOBN(0x140a0f9f, 0xdd93d50a), TOBN(0x4799ffde, 0x83b7abac),
+     TOBN(0x78ff7c23, 0x04a1f742), TOBN(0xc0568f51, 0x195ba34e),
+     TOBN(0xe9718360, 0x3b7f78b4), TOBN(0x9cfd1ff1, 0xf9efaa53),
+     TOBN(0xe924d2c5, 0xbb06022e), TOBN(0x9987fa86, 0xfaa2af6d),
+     TOBN(0x4b12e73f, 0x6ee37e0f), TOBN(0x1836fdfa, 0x5e5a1dde),
+     TOBN(0x7f1b9225, 0x9dcd6416), TOBN(0xcb2c1b4d, 0x677544d8),
+     TOBN(0x279fd119, 0xda1c29ab), TOBN(0xbd068802, 0x2b30d40c),
+     TOBN(0xd8f57da4, 0xda44105d), TOBN(0xb1814b7a, 0x28223fe1),
+     TOBN(0xcf2fd241, 0xe06f2d2e), TOBN(0x99003a02, 0x01dfde06),
+     TOBN(0x876a31af, 0xfded7e4b), TOBN(0x1efaf827, 0x2f725094),
+     TOBN(0x5117d608, 0x493a6a0a), TOBN(0xdcec8088, 0xa88c03e7),
+     TOBN(0xeae1d352, 0xea916897), TOBN(0x8cdc2810, 0x6e8b2c57),
+     TOBN(0x0254486d, 0x9c213d95), TOBN(0x68a9db56, 0xcb2f6e94),
+     TOBN(0xfb5858ba, 0x000f5491), TOBN(0x1315bdd9, 0x34009fb6),
+     TOBN(0xb18a8e0a, 0xc42bde30), TOBN(0xfdcf93d1, 0xf1070358),
+     TOBN(0xbeb1db75, 0x3022937e), TOBN(0x9b9eca7a, 0xcac20db4),
+     TOBN(0x152214d4, 0xe4122b20), TOBN(0xd3e673f2, 0xaabccc7b),
+     TOBN(0x94c50f64, 0xaed07571), TOBN(0xd767059a, 0xe66b4f17),
+     TOBN(0x09f8bb06, 0x54e93c1e), TOBN(0xb0045884, 0xad81e27c),
+     TOBN(0x26ebc7b6, 0x076e13eb), TOBN(0xbda0b553, 0x5d5ac07f),
+     TOBN(0xbcb81322, 0x48ab69e6), TOBN(0xd3847d2e, 0x1c0f21fa),
+     TOBN(0x7a466528, 0xc834d740), TOBN(0x6c67a79a, 0xe0823ff2),
+     TOBN(0x85dd1186, 0x4c1d7cb8), TOBN(0x096f849f, 0x2d081301),
+     TOBN(0xb4f503dd, 0x8a5ea0f0), TOBN(0x71ee0889, 0xd1bf69b2),
+     TOBN(0x40336b12, 0xdcd6d14b), TOBN(0xf6bcff5d, 0xe3b4919c),
+     TOBN(0xc337048d, 0x9c841f0c), TOBN(0x4ce6d025, 0x1d617f50),
+     TOBN(0x00fef219, 0x8117d379), TOBN(0x18b7c4e9, 0xf95be243),
+     TOBN(0x98de119e, 0x38df08ff), TOBN(0xdfd803bd, 0x8d772d20),
+     TOBN(0x94125b72, 0x0f9678bd), TOBN(0xfc5b57cd, 0x334ace30),
+     TOBN(0x09486527, 0xb7e86e04), TOBN(0xfe9f8bcc, 0x6e552039),
+     TOBN(0x4ab7a22c, 0x02a2d1e6), TOBN(0x967e19a3, 0x1371d5a4),
+     TOBN(0x20f59f95, 0x078de336), TOBN(0xfd28fa36, 0xf7869245),
+     TOBN(0x1de42581, 0xcbf1d96f), TOBN(0x2e0127d7, 0x366e1f0f),
+     TOBN(0xbc65fa9d, 0x2258c741), TOBN(0x1f2f3356, 0xdd6d65f8),
+     TOBN(0x06384f3a, 0x4a0822a9), TOBN(0x1c81332b, 0xfd05a0aa),
+     TOBN(0xbfb12361, 0xd95ee3ce), TOBN(0x180aaf06, 0x42016d00),
+     TOBN(0x3b75c45b, 0xd6f5a10e), TOBN(0xfd4680f4, 0xc1c35f38),
+     TOBN(0x5450227d, 0xf8e0a113), TOBN(0x5e69f1ae, 0x73ddba24),
+     TOBN(0x2007b80e, 0x57f24645), TOBN(0xc63695dc, 0x3d159741),
+     TOBN(0xcbe54d29, 0x4530f623), TOBN(0x986ad573, 0x2869586b),
+     TOBN(0xe19f7059, 0x4cc39f73), TOBN(0x80f00ab3, 0x2b1b8da9),
+     TOBN(0xb765aaf9, 0x73f68d26), TOBN(0xbc79a394, 0xe993f829),
+     TOBN(0x0a159f62, 0x95b3287d), TOBN(0xb18f8759, 0x48cecad0),
+     TOBN(0x6d1ab8ee, 0x1661a23f), TOBN(0xcae7f40e, 0xc95c41b3),
+     TOBN(0xbc3d2040, 0x7c51eb56), TOBN(0xa7527283, 0xe8754250),
+     TOBN(0x81561056, 0x1f9e668a), TOBN(0xb8aa7296, 0x900f5912),
+     TOBN(0xabdbc1bf, 0x6af2a00c), TOBN(0xe9a94254, 0x2d0a56c0),
+     TOBN(0x4774a7b7, 0x7bc8959e), TOBN(0x0a837ff0, 0x19cef2f3),
+     TOBN(0x9c441043, 0xf310d2a0), TOBN(0x2865ee58, 0xdc5eb106),
+     TOBN(0x71a95922, 0x9cb8065c), TOBN(0x8eb3a733, 0xa052af0f),
+     TOBN(0x56009f42, 0xb09d716e), TOBN(0xa7f923c5, 0xabcbe6ad),
+     TOBN(0x263b7669, 0xfa375c01), TOBN(0x641c47e5, 0x21ef27a2),
+     TOBN(0xa89b474e, 0xb08ffd25), TOBN(0x5be8ec3f, 0xf0a239f3),
+     TOBN(0x0e79957a, 0x242a6c5a), TOBN(0x1dfb26d0, 0x0c6c75f5),
+     TOBN(0x36f3a3d8, 0xa084fae6), TOBN(0x75983589, 0x9a9b0d95),
+     TOBN(0x70722186, 0xcc80fcb6), TOBN(0xf28ed0c7, 0x96d84c04),
+     TOBN(0x95a32263, 0xffb63f90), TOBN(0xdd7d60a0, 0x98766034),
+     TOBN(0xe193a31f, 0x1d5c387c), TOBN(0x6c5eca7e, 0xb8310f8b),
+     TOBN(0xfe61d523, 0xc083ff47), TOBN(0x90c832db, 0xcb2944e9),
+     TOBN(0xa9f3f293, 0x593334b7), TOBN(0xe6cde2e1, 0x2d7d1c33),
+     TOBN(0x2fd97b9b, 0x9dfbf22a), TOBN(0xdec16cc8, 0x5643532d),
+     TOBN(0xdf0e6e39, 0x60fee7c3), TOBN(0xd09ad7b6, 0x545860c8),
+     TOBN(0xcc16e984, 0x73fc3b7c), TOBN(0x6ce734c1, 0x0d4e1555),
+     TOBN(0xc6efe68b, 0x4b5f6032), TOBN(0x3a64f34c, 0x14f54073),
+     TOBN(0x25da689c, 0xac44dc95), TOBN(0x990c477e, 0x5358ad8a),
+     TOBN(0x00e958a5, 0xf36da7de), TOBN(0x902b7360, 0xc9b6f161),
+     TOBN(0xbd079cf1, 0xf144b6cc), TOBN(0x7f86e29b, 0xb4f4a764),
+     TOBN(0x5b08b290, 0xf21f9cbf), TOBN(0xada0c85b, 0x75e3aeb9),
+     TOBN(0xd0789f8b, 0x6666c2df), TOBN(0xcf5d8a8c, 0xd71ec2ec),
+     TOBN(0x6f7780c3, 0xe7e4364b), TOBN(0xdd9a6529, 0x85d2eb75),
+     TOBN(0x8222f66b, 0xd952a38e), TOBN(0x9dd5f7eb, 0x27260a29),
+     TOBN(0xce49b344, 0x57947178), TOBN(0xaa215f82, 0xcdda7e39),
+     TOBN(0x454ab42c, 0x9347b90a), TOBN(0xcaebe64a, 0xa698b02b),
+     TOBN(0x119cdc69, 0xfb86fa40), TOBN(0x2e5cb7ad, 0xc3109281),
+     TOBN(0x67bb1ec5, 0xcd0c3d00), TOBN(0x5d430bc7, 0x83f25bbf),
+     TOBN(0x69fd84a8, 0x5cde0abb), TOBN(0x69da263e, 0x9816b688),
+     TOBN(0xe52d93df, 0x0e53cbb8), TOBN(0x42cf6f25, 0xadd2d5a7),
+     TOBN(0x227ba59d, 0xc87ca88f), TOBN(0x7a1ca876, 0xda738554),
+     TOBN(0xaa44b286, 0x3004db31), TOBN(0x86f43d7a, 0xd43e4430),
+     TOBN(0xdc4874cd, 0xb0b0240d), TOBN(0x79986a23, 0xadc45a06),
+     TOBN(0xbb275b44, 0x3cee4631), TOBN(0x21daee8a, 0x63a217aa),
+     TOBN(0x1e7c5397, 0xd7b25c02), TOBN(0xe677d3cb, 0xc5e668fa),
+     TOBN(0xc7c84e28, 0xed51b4bf), TOBN(0x7ca19e99, 0x923e5408),
+     TOBN(0xc6f8a595, 0xc3f832e7), TOBN(0x2d0a789c, 0x5fb049a3),
+     TOBN(0x3fa5c105, 0x1cac82c4), TOBN(0x23c76087, 0x8a78c9be),
+     TOBN(0xe98cdad6, 0x1c5cfa42), TOBN(0x09c30252, 0x0a6c0421),
+     TOBN(0x149bac7c, 0x42fc61b9), TOBN(0x3a1c22ac, 0x3004a3e2),
+     TOBN(0xde6b0d6e, 0x202c7fed), TOBN(0xb2457377, 0xe7e63052),
+     TOBN(0x31725fd4, 0x3706b3ef), TOBN(0xe16a347d, 0x2b1afdbf),
+     TOBN(0xbe4850c4, 0x8c29cf66), TOBN(0x8f51cc4d, 0x2939f23c),
+     TOBN(0x114a25c8, 0x44922386), TOBN(0xdd084d44, 0x6d4e8b57),
+     TOBN(0xc49b6841, 0x1e7bd7de), TOBN(0x5b0359fa, 0xd6da54db),
+     TOBN(0xa6e6e5f9, 0x3f0da321), TOBN(0xb65ec55c, 0xd640a87e),
+     TOBN(0xc1a4f6ce, 0xae64020e), TOBN(0x91e29cd2, 0x088e1337),
+     TOBN(0xf44ceb8e, 0x3c0a631c), TOBN(0x0205b11d, 0xb756445f),
+     TOBN(0x04844e84, 0x5bc8880e), TOBN(0xb630ddc0, 0xb85e00d3)},
+    {TOBN(0xe76894c3, 0xae7ce296), TOBN(0x87737ee2, 0xa6cafc34),
+     TOBN(0x566dfcfb, 0xe55cd1e6), TOBN(0x5421a9f2, 0x3a7ad5b9),
+     TOBN(0xa005838a, 0x4687a4ef), TOBN(0x3837219a, 0x23a2c423),
+     TOBN(0x4b780012, 0x8a82cd1b), TOBN(0x401c07be, 0xc728b588),
+     TOBN(0x2b5f69e9, 0x37ced8f3), TOBN(0x306b621d, 0x8c1e1eaa),
+     TOBN(0x8acbbe71, 0xd389cc4d), TOBN(0x922fa665, 0xf4ab7774),
+     TOBN(0x2df6f242, 0xd35c2d80), TOBN(0xf65a99a9, 0x3493ce97),
+     TOBN(0x9e80232b, 0x372bcc87), TOBN(0x26ba13b8, 0x6e428cc5),
+     TOBN(0x2526ef1f, 0x13a1b763), TOBN(0xcef3edcd, 0xdc97c5f3),
+     TOBN(0x4954867f, 0xbde16b73), TOBN(0x9817813d, 0x368ff6cb),
+     TOBN(0x7e39fa69, 0xbe143027), TOBN(0x12329463, 0xcf54f28b),
+     TOBN(0xcf0991dc, 0x7597c2da), TOBN(0x0cda3969, 0x52e07099),
+     TOBN(0xdc9daeef, 0xee993749), TOBN(0xd40c8a54, 0x7ff3d775),
+     TOBN(0x206d2271, 0xca53d53d), TOBN(0xb0546335, 0x4d1aa50b),
+     TOBN(0x52bca910, 0x88001e99), TOBN(0x25c117c2, 0x17fb7aa4),
+     TOBN(0xfff3af95, 0x42685945), TOBN(0x083fd4de, 0x8f4ce0fb),
+     TOBN(0xaac004be, 0x24753989), TOBN(0x4a5de2b6, 0xe90950c6),
+     TOBN(0xb46af0ab, 0x738efe5b), TOBN(0xcf80a17f, 0xdb4459f9),
+     TOBN(0x412f64a3, 0xf303955d), TOBN(0xe92bdca9, 0xbd692593),
+     TOBN(0xfbe6cdc2, 0xc2e964e0), TOBN(0xe9a3b1fd, 0x0011cb01),
+     TOBN(0x6c30762d, 0xcf228f23), TOBN(0x1270b84a, 0xbe9199a1),
+     TOBN(0x732711df, 0xe3c9cbb1), TOBN(0xa3aabe37, 0xd91d9513),
+     TOBN(0x8ee08ba0, 0xc6eceba7), TOBN(0xb1711531, 0xf3c3d31d),
+     TOBN(0x65060b63, 0x3c716948), TOBN(0x046b4ea1, 0x2ff2cadd),
+     TOBN(0xdeb7a462, 0x961719fe), TOBN(0x5e22796d, 0x76ba6ed7),
+     TOBN(0x5907daf2, 0x25d22208), TOBN(0xd98260a7, 0x2c21c04c),
+     TOBN(0x56b24923, 0xe090f349), TOBN(0xb5960ad9, 0xa31a8f95),
+     TOBN(0xb6ac57ce, 0xf8b1da62), TOBN(0xe47d0995, 0x9f14f70f),
+     TOBN(0x0ba6eb01, 0x04dba20b), TOBN(0x41ca71c8, 0x46b60e27),
+     TOBN(0x2bbfdb30, 0x6bf5eeef), TOBN(0x58e16788, 0xf075b238),
+     TOBN(0x25d1124f, 0xbab220c6), TOBN(0xcd1423c8, 0x61524e3e),
+     TOBN(0x75e4f45f, 0x0434fb51), TOBN(0xb5180a8f, 0x5180ab2b),
+     TOBN(0x144e214e, 0x5b22e388), TOBN(0x6b16dad1, 0x92263054),
+     TOBN(0x3ea75907, 0x40863566), TOBN(0x372d5abd, 0xdada3b46),
+     TOBN(0xb3ff5a3a, 0x893d210f), TOBN(0x39f8d1ce, 0x5e29f3dc),
+     TOBN(0x559186ce, 0x68200e82), TOBN(0xf4876454, 0x1202cb66),
+     TOBN(0x699c2db9, 0xeaf4f2a1), TOBN(0x8cd33227, 0x61c0c17c),
+     TOBN(0x971b50d4, 0x64f16a56), TOBN(0xcd00d42b, 0x102bbe10),
+     TOBN(0x928d0ae2, 0xb05f3cac), TOBN(0x245dbe38, 0x14bcf472),
+     TOBN(0x43d29526, 0x947c0184), TOBN(0x24089968, 0x4612a4ea),
+     TOBN(0xbc763fcd, 0x6c2b4541), TOBN(0xb4e7ae0f, 0xf82448fa),
+     TOBN(0x94f1fa15, 0xb02b6459), TOBN(0xbcafa1ec, 0x67d39bbd),
+     TOBN(0x6f178dbf, 0x8b540904), TOBN(0x0264bccd, 0x8720472a),
+     TOBN(0xa6e8b4b4, 0x59b46611), TOBN(0xafce8267, 0xc72b4a58),
+     TOBN(0x21142175, 0xa45985ad), TOBN(0xd23401df, 0xe649d733),
+     TOBN(0x6bf42fe0, 0x85dc7720), TOBN(0xc5c8ab94, 0x40e3f2f5),
+     TOBN(0xb0c8a58a, 0xcd029197), TOBN(0xa73ff329, 0x215492e1),
+     TOBN(0x895c545e, 0xb1b5a5f0), TOBN(0x6dbc2445, 0x6fcaf49b),
+     TOBN(0x705ad3d8, 0x44cc852a), TOBN(0x10bb5add, 0xb80518e0),
+     TOBN(0xa34905bb, 0x0de9f160), TOBN(0x7d45aae3, 0x94b1aacd),
+     TOBN(0xd30411d0, 0x7fd5de7a), TOBN(0xe2fc6206, 0x4d0167cd),
+     TOBN(0xd3b19612, 0x10ce71cf), TOBN(0x8e8096b6, 0xb28225fd),
+     TOBN(0x4b46fa80, 0x64a1c849), TOBN(0x160479ac, 0xa51364e9),
+     TOBN(0x9ebb6fdb, 0xfaa3f0f2), TOBN(0x9ce029b9, 0xf1511754),
+     TOBN(0x25ef32d6, 0x0f2d76a3), TOBN(0x540650b9, 0xaf4a7d46),
+     TOBN(0x8979a4b8, 0xd991d7f4), TOBN(0xdaa706c2, 0x99202400),
+     TOBN(0x8a729680, 0xf19d281d), TOBN(0xde25bdc4, 0x4ec44de2),
+     TOBN(0x0fc50832, 0xc2054496), TOBN(0xfee72fb6, 0x0aaf2941),
+     TOBN(0xc8263e64, 0xb82ed4f0), TOBN(0x91a8cb73, 0x6f49055c),
+     TOBN(0xb7585458, 0xf2bb515c), TOBN(0x03d2b23a, 0xb855e6c6),
+     TOBN(0x8e11e8e8, 0xa0879d68), TOBN(0x2bea77a3, 0xbf7a84ac),
+     TOBN(0x98140930, 0xa74b45d0), TOBN(0x1ce28654, 0x810e587c),
+     TOBN(0x0a30756b, 0x8869daac), TOBN(0xbf5e8245, 0x39d2fe12),
+     TOBN(0xe6414992, 0xcac16a87), TOBN(0xd2fa182d, 0x437aff7b),
+     TOBN(0x4e61412d, 0xb6146094), TOBN(0x30a949ec, 0x2f31bb4b),
+     TOBN(0xf254c71f, 0x22dc8ac6), TOBN(0x1d9ed85c, 0x1ab2a0bd),
+     TOBN(0x09ec1e3d, 0xcfd3f182), TOBN(0x1f1c30b5, 0xadae7af9),
+     TOBN(0xf3a33f7c, 0x6b454164), TOBN(0x0318926f, 0x94647c4f),
+     TOBN(0x8e37bdd7, 0x87db14ec), TOBN(0x811cbd34, 0x2ab364d3),
+     TOBN(0x1dd1e507, 0x7c2b369d), TOBN(0x7a57bc46, 0xa28056bd),
+     TOBN(0xfca5be4b, 0x089efe44), TOBN(0xb3bd84d7, 0x6dc1290e),
+     TOBN(0x40d7af09, 0x8793e6ae), TOBN(0x4e08e11f, 0xa3723942),
+     TOBN(0x649eeabb, 0xeb73ec7d), TOBN(0x10983304, 0x26a9aaf9),
+     TOBN(0xf22e4514, 0x4e296235), TOBN(0x695c8df4, 0x7b85f801),
+     TOBN(0xd4553344, 0x3ae7caaa), TOBN(0x3e35bd47, 0xffbba90e),
+     TOBN(0xdd04f7c9, 0x5d13b9ec), TOBN(0xe39a5d12, 0xe259f70d),
+     TOBN(0x39073063, 0x201ae17c), TOBN(0xdba3eda0, 0x6a85435f),
+     TOBN(0x6df48093, 0xe948924a), TOBN(0x9ffc4dcf, 0x00e3394f),
+     TOBN(0xca3709ad, 0x899ffebb), TOBN(0x1a873778, 0x77c00602),
+     TOBN(0x5ff40c2a, 0xa99b4af0), TOBN(0x680464e5, 0xa80e870c),
+     TOBN(0xd2f7f044, 0x94e10b1d), TOBN(0xee9b206c, 0x4e9aa1a7),
+     TOBN(0xb536d675, 0x96cbe950), TOBN(0x84185689, 0x9e8305f3),
+     TOBN(0xae1b669c, 0x369fa255), TOBN(0x62e26026, 0x7233e1ea),
+     TOBN(0xac05c513, 0x6aa60c24), TOBN(0xdfc6814f, 0xd2691677),
+     TOBN(0xbe414528, 0x397147d6), TOBN(0x74851314, 0x42592203),
+     TOBN(0x9084d330, 0x0364b0eb), TOBN(0xf8e5d6d5, 0x6ad70814),
+     TOBN(0xfcd4e0e3, 0xffb4ac5f), TOBN(0xf652417a, 0x1fbf8899),
+     TOBN(0xb1165da7, 0xccbd7eaa), TOBN(0xf5dbd11a, 0x6e2d4e8c),
+     TOBN(0x5dab120a, 0x32ddcea8), TOBN(0x30aaa56f, 0x9892f728),
+     TOBN(0x71c2412d, 0xd3d73838), TOBN(0xbc0253d1, 0xd2e2becb),
+     TOBN(0x8baef5df, 0x0a02b0fb), TOBN(0x58a2b06b, 0xc2b92b02),
+     TOBN(0x268558d7, 0x54c8267a), TOBN(0xf924f795, 0xccf70393),
+     TOBN(0xe3763f30, 0xf68ee021), TOBN(0xc1e856f0, 0x5c01ba4b),
+     TOBN(0xcc01a3e9, 0x722b6bff), TOBN(0xd2be4623, 0xed5b3b02),
+     TOBN(0x1ab3512e, 0x6c45e33f), TOBN(0xa978fe48, 0x4ef433f6),
+     TOBN(0x23e2ea01, 0x8e21f5af), TOBN(0x49647d88, 0x11524a40)},
+    {TOBN(0xe1d42d94, 0xd087b788), TOBN(0xfbfb221a, 0xba0e176a),
+     TOBN(0x5f6698e7, 0x83686966), TOBN(0xbb5e1594, 0x74a30dbf),
+     TOBN(0xef86bb5b, 0xcfd20230), TOBN(0xf055a1c5, 0x403b8f8b),
+     TOBN(0xf249aac8, 0xd9d85ea7), TOBN(0x7318f7bc, 0x3d200198),
+     TOBN(0x3b80960c, 0xefca9a90), TOBN(0xf28e3388, 0x8f449c4b),
+     TOBN(0x0cdfc61b, 0xf0cfe09e), TOBN(0x3b169c63, 0x8b22cd26),
+     TOBN(0x923e948c, 0x203bb368), TOBN(0x58e37a2b, 0x231a80e0),
+     TOBN(0x345a011a, 0x6df27deb), TOBN(0xba6784c1, 0xd57f4ca2),
+     TOBN(0xf01b3703, 0x114196e9), TOBN(0x981a63eb, 0x1aab426d),
+     TOBN(0x2ffdc978, 0x51770c1c), TOBN(0xddd19da6, 0xefa722fc),
+     TOBN(0x5ca1c012, 0x16f09c1e), TOBN(0x612021de, 0x5b9cc0b6),
+     TOBN(0x910e10e9, 0x5e150569), TOBN(0xacace9dc, 0xe2ab93ea),
+     TOBN(0x0cdd8372, 0x5070e0a9), TOBN(0x7c5ad562, 0xec550783),
+     TOBN(0x9652b847, 0x4f3b8d2b), TOBN(0xfdd60d93, 0xe6e98d73),
+     TOBN(0xd51cae2c, 0xa3479d0b), TOBN(0x11b93b6d, 0xee05c006),
+     TOBN(0x9d72b82d, 0x8a3b40d5), TOBN(0xc6e996fe, 0xa7d24855),
+     TOBN(0x420672f7, 0x398603de), TOBN(0xd551b34a, 0x9a1af2ce),
+     TOBN(0xdeb8c1d9, 0x13bdce0c), TOBN(0x56ca926d, 0xebbeba7a),
+     TOBN(0xac58c9e0, 0x9db9ca19), TOBN(0xd308ea5d, 0x390054d0),
+     TOBN(0x32ef4afc, 0x2cc42529), TOBN(0x08bd48b3, 0x97c2bdf9),
+     TOBN(0xac8a7803, 0xa849e19a), TOBN(0xcd51c0da, 0x75c31496),
+     TOBN(0x733dc7de, 0xf0e2d49f), TOBN(0x7c9caad1, 0xb44b8cc5),
+     TOBN(0x6d9c5b08, 0x47be21a8), TOBN(0xfab0fdc5, 0x5ebf426f),
+     TOBN(0xd60748ca, 0xf94e9e5b), TOBN(0x3072e592, 0x69366089),
+     TOBN(0x8f24cfd9, 0x007d3d4d), TOBN(0x2f4f7195, 0xcb27ae66),
+     TOBN(0x8166162e, 0x9c1ed35e), TOBN(0xfdcf7666, 0x4f4bdfd8),
+     TOBN(0x6dc993bc, 0x3b5373ca), TOBN(0x2faa34d6, 0xa3ec42d5),
+     TOBN(0x1cce84cb, 0xc6b6109e), TOBN(0x7a4178ad, 0x43632b7e),
+     TOBN(0x6899adb5, 0xb2aab55b), TOBN(0x080e42bd, 0x683c1397),
+     TOBN(0x34d5e192, 0x10960bfe), TOBN(0x65415d21, 0x7223406a),
+     TOBN(0x8acd0a3e, 0x6254954d), TOBN(0x708f9359, 0x1d8c2442),
+     TOBN(0x85f59135, 0x6dab2ff9), TOBN(0x9df92007, 0x33a9d96a),
+     TOBN(0xac9849a7, 0xcaa797ad), TOBN(0xcea2067f, 0xfe95aa38),
+     TOBN(0x5a3c21b4, 0x995cb879), TOBN(0x5c981a5d, 0x69d4f07d),
+     TOBN(0x028cf95d, 0xf0dc9aa6), TOBN(0xcc5cee93, 0xc68fd96a),
+     TOBN(0x8a5e73ee, 0x0b69676f), TOBN(0x190a7229, 0x832d230b),
+     TOBN(0xc0ab244b, 0xd40c5d9f), TOBN(0xc05a11cf, 0xf3ef03ed),
+     TOBN(0x1593d8ad, 0x650ea714), TOBN(0x1edb6cbd, 0xfc6a1235),
+     TOBN(0xead76e1e, 0x4e451d0b), TOBN(0x4759e3c0, 0xae7ee558),
+     TOBN(0x480627be, 0x7c8145e2), TOBN(0x82cec2c7, 0x88a339a2),
+     TOBN(0x17e887b6, 0x752b0f58), TOBN(0x91c866d0, 0xaa6c9df1),
+     TOBN(0xd9a54848, 0x29b3b1d3), TOBN(0x17ae47ae, 0xf641bbc1),
+     TOBN(0xb06c17a3, 0xf0ef77c5), TOBN(0xc144e784, 0x6df6bf59),
+     TOBN(0x2440ae99, 0x0038aeb2), TOBN(0x83bf711b, 0x58b402ca),
+     TOBN(0xb8763e00, 0xb577732a), TOBN(0x509e91ef, 0xf651a932),
+     TOBN(0xbe02ab9d, 0x00ac109e), TOBN(0xfbcb426c, 0x8dfd78f1),
+     TOBN(0x7ed272f6, 0x4283f80f), TOBN(0x098cf057, 0x2365da5e),
+     TOBN(0xd90e6f18, 0x05dc6beb), TOBN(0x09ef177f, 0xcf7b9d72),
+     TOBN(0xebee13d1, 0x199785d5), TOBN(0x3d370648, 0x92f8f141),
+     TOBN(0x56595c83, 0x15e3a026), TOBN(0xa0f4960e, 0xe6e5c659),
+     TOBN(0x27d5bc54, 0xc052f5d6), TOBN(0x9c5437dc, 0x8677ef24),
+     TOBN(0x28ae53a3, 0xdb9b78fc), TOBN(0x025b81a7, 0xd91113f9),
+     TOBN(0xfb423fb3, 0x6ac445f9), TOBN(0xb555a8b5, 0x575649cf),
+     TOBN(0x3ac93b08, 0x06ae0cb6), TOBN(0x7a706bb5, 0x8d2e3be1),
+     TOBN(0xcabd7301, 0x97c0cb32), TOBN(0x1698cfd3, 0x65f83e1d),
+     TOBN(0x44833254, 0x62043a8b), TOBN(0x43d1641f, 0x3b4c8bac),
+     TOBN(0xcc394a5b, 0xe344a05a), TOBN(0x9e085b71, 0x853c1f6d),
+     TOBN(0x35a67867, 0xcf627733), TOBN(0x9d668c2b, 0xeab971dc),
+     TOBN(0x458a801d, 0x46c5f3bd), TOBN(0xb7b08696, 0x446c5e3b),
+     TOBN(0x468ae44a, 0xc15fc828), TOBN(0x9503fd49, 0xab2761ff),
+     TOBN(0x7278f12f, 0xce8d4427), TOBN(0x036aef18, 0xeb15f81f),
+     TOBN(0xcbe64b86, 0xa58e95ea), TOBN(0xf933a850, 0x59b2428c),
+     TOBN(0x8d117bfc, 0x52f1b0fb), TOBN(0xba9dbc6f, 0x0bed33e2),
+     TOBN(0x3e152fb5, 0x6ece7dc5), TOBN(0x90e88871, 0xeb80d7ff),
+     TOBN(0x0aa265aa, 0xddf09489), TOBN(0xa17584cc, 0x2476414f),
+     TOBN(0x2d241d33, 0xcb0418ea), TOBN(0x1c40e835, 0xc3a7529b),
+     TOBN(0x89b2edba, 0xe3e1aee9), TOBN(0x33533137, 0xe55e4aca),
+     TOBN(0x1dded9ce, 0x8943fce4), TOBN(0xaaf07ff4, 0x5a2ff996),
+     TOBN(0x69e60f92, 0xc96e87fe), TOBN(0xc2e5c1d5, 0xb9ee808c),
+     TOBN(0x79d6d8c6, 0xbe466616), TOBN(0x897f6c2f, 0xdffe4e28),
+     TOBN(0xc8a65267, 0x350b7fc9), TOBN(0xe9fcb46d, 0x8a2abab0),
+     TOBN(0x57c3bfc6, 0x2c4faf7c), TOBN(0x41a8cc2a, 0xa8207c8a),
+     TOBN(0xb60e8daa, 0xa74858fb), TOBN(0xaa4c8ca5, 0x50c7c2f8),
+     TOBN(0x9eb37096, 0x31a39837), TOBN(0x5742fb32, 0x69f44aa5),
+     TOBN(0x086aa479, 0x51e793a0), TOBN(0x9bcaf657, 0x55e7c373),
+     TOBN(0x63cee90c, 0x1b13101d), TOBN(0xbc410452, 0xe7d42d91),
+     TOBN(0x3041007f, 0x913aa0fb), TOBN(0x9a00ad14, 0x502be876),
+     TOBN(0xa137a443, 0xb8677568), TOBN(0x5b26b995, 0x46ca4efa),
+     TOBN(0xe33585b7, 0xaed60a78), TOBN(0xd208deea, 0x3cbb2e24),
+     TOBN(0xff32cccb, 0x1aca34e8), TOBN(0x52ebce07, 0x7b64d250),
+     TOBN(0x93a4d0a1, 0x84d8b907), TOBN(0xd759bef0, 0x77de8d42),
+     TOBN(0xbd60c87a, 0x5d07487d), TOBN(0x63620986, 0xc74f79df),
+     TOBN(0x54f5f2c8, 0x4a52f837), TOBN(0x340a1f53, 0xf3cec619),
+     TOBN(0x1e922bc4, 0xfc85bf85), TOBN(0xc92e7b85, 0xc3bfdf09),
+     TOBN(0xeb1a37c3, 0x0eb9e6bc), TOBN(0x8c393d89, 0x4fbf1cb1),
+     TOBN(0x6ac9427e, 0xd1f10389), TOBN(0x77b8cfc1, 0x7c8caefc),
+     TOBN(0x554ab4af, 0x1a61bdd5), TOBN(0x661a99f1, 0xad75e46b),
+     TOBN(0x11fc01bb, 0x439a0456), TOBN(0x5b7fedd2, 0x8d0046c9),
+     TOBN(0xcfded2ef, 0xfbece9e3), TOBN(0x4e4dcb0b, 0x11440124),
+     TOBN(0x2a5fd0fa, 0xdee23c7d), TOBN(0xaa5f345a, 0xf662402c),
+     TOBN(0x6f101762, 0xeeb791c4), TOBN(0x0d942184, 0xdf261eff),
+     TOBN(0x2c58e2aa, 0xac1dc827), TOBN(0x51410e89, 0xf835a1b6),
+     TOBN(0x981333a7, 0x629915a4), TOBN(0x371891b6, 0x0c14148d),
+     TOBN(0x4d20b3d3, 0xc0904446), TOBN(0xdda7ecc8, 0x949776d8),
+     TOBN(0xa664b68c, 0x2a2645f7), TOBN(0x7a6bc857, 0xadd082ea),
+     TOBN(0xe7467dc6, 0x3e5ff206), TOBN(0x40a6c340, 0x04e2dfcc)},
+    {TOBN(0xa2354569, 0x03744726), TOBN(0xd2169e6d, 0xd8d275ac),
+     TOBN(0xab0c247b, 0x132c5689), TOBN(0x129a5c9d, 0xcc4760bb),
+     TOBN(0x03eba467, 0x26ae821b), TOBN(0x67a33fda, 0x3df1cf83),
+     TOBN(0x010813cf, 0xb8421b7a), TOBN(0x7b0f5070, 0x98cd6d76),
+     TOBN(0x907320b3, 0x1fe4b600), TOBN(0xda3bfeb3, 0x98dd3239),
+     TOBN(0x23f1ed16, 0x41abb34c), TOBN(0x01b30f29, 0x946f85f1),
+     TOBN(0x28524830, 0x9666f8ea), TOBN(0xd579b3df, 0xeff6502b),
+     TOBN(0x3a66fa99, 0x00e4f78a), TOBN(0xfd8a65bb, 0x54a3f7a3),
+     TOBN(0x505d3f63, 0x1965a79a), TOBN(0x9524972c, 0x1891469a),
+     TOBN(0x78367cbc, 0x3354da3a), TOBN(0xbfe1fe3d, 0xe4941c6e),
+     TOBN(0xe41bb3f6, 0xf5af173e), TOBN(0x57cb03ca, 0x5ca36597),
+     TOBN(0x27f86cb8, 0x7b99f795), TOBN(0x5cae6514, 0xad4dcef1),
+     TOBN(0x4952a350, 0xd87a86c9), TOBN(0x08ed7da7, 0x034f45f9),
+     TOBN(0x1e9ff827, 0x2bd716d0), TOBN(0x2471fd15, 0xf1d9331f),
+     TOBN(0x0c708362, 0xd7370b75), TOBN(0xaddedde6, 0xfc1a1051),
+     TOBN(0xf4475288, 0xdb27b186), TOBN(0x5be4d46b, 0x3760bc11),
+     TOBN(0xe44435d9, 0x06d47ee1), TOBN(0x865cf7c8, 0xd0b7c8a2),
+     TOBN(0xdb412be0, 0x8d31a252), TOBN(0x4b90a932, 0x2f24d71c),
+     TOBN(0x38a49bf5, 0x55f0ad9f), TOBN(0x1a84c6b8, 0xf3618639),
+     TOBN(0x5f709eca, 0x01b2f7c2), TOBN(0xc479a650, 0x5be8359f),
+     TOBN(0x6b6a22bf, 0xd6646b3f), TOBN(0xcce78878, 0xcc5b711b),
+     TOBN(0x8e7dbc63, 0xb446cc63), TOBN(0x231bd027, 0x218f800f),
+     TOBN(0x2d3a7e04, 0x030271eb), TOBN(0xb08b5978, 0xe22fb3c7),
+     TOBN(0x860d6278, 0x9be0d46c), TOBN(0x253a31c2, 0x1d49a915),
+     TOBN(0xbad6b669, 0x376bdc3f), TOBN(0xc4a8e7bc, 0x23a9ff38),
+     TOBN(0x3f54d8c4, 0x555fb0a3), TOBN(0xfb3d5e1d, 0x2b23db1b),
+     TOBN(0x6379f78a, 0xf0d7eba9), TOBN(0x36004feb, 0xfa0beffa),
+     TOBN(0xdf0a373c, 0x334ff01a), TOBN(0x10314749, 0xdff12a1c),
+     TOBN(0x1d52ddc7, 0xf184c1b3), TOBN(0x79431663, 0xab02d404),
+     TOBN(0x1a6488c1, 0x7f4d3795), TOBN(0x3363660f, 0x7cca9102),
+     TOBN(0x56d65156, 0x04dc109c), TOBN(0xcd740cc8, 0x09c1d307),
+     TOBN(0xef9e049f, 0x10dfaead), TOBN(0x19750b3a, 0xe30b70b8),
+     TOBN(0x11ed8600, 0x15c6a562), TOBN(0x53bdf97e, 0x12097026),
+     TOBN(0x79559d05, 0x6c0d908f), TOBN(0x8f1d75ba, 0xb506d527),
+     TOBN(0xd6fd7323, 0xae8fb3c4), TOBN(0x834639c9, 0xa4111f88),
+     TOBN(0xfc69a029, 0xa310a683), TOBN(0xa4467bbb, 0x255f2e9a),
+     TOBN(0x5f0a58a8, 0xa3526fec), TOBN(0x849c171b, 0x02f028c1),
+     TOBN(0x34d77ce8, 0x56a5d3b5), TOBN(0x97016217, 0x54d5a92b),
+     TOBN(0x0cce35c1, 0x2cc5b70b), TOBN(0xd9d5a00a, 0xe83f1f4a),
+     TOBN(0x064223f8, 0x26a0368b), TOBN(0x328a9f69, 0x40e16452),
+     TOBN(0x3a6ac093, 0xd305ad2c), TOBN(0x759d9a16, 0xbeba7c44),
+     TOBN(0x86021de7, 0x637ce7c8), TOBN(0x276bed61, 0xcc80c1cc),
+     TOBN(0x66797f56, 0xbbe4bdda), TOBN(0xb92a369e, 0xda51b1a2),
+     TOBN(0x18eef4a5, 0x31adb034), TOBN(0xcf1cb5ee, 0x5d185cfc),
+     TOBN(0xf596a59b, 0xbd53c27b), TOBN(0x1e1dd6f5, 0x69002569),
+     TOBN(0xd9433e79, 0x7687e48a), TOBN(0x7d8d24c2, 0x0cbcb9ce),
+     TOBN(0x233cd7ed, 0x65d68ecd), TOBN(0x201bbe09, 0xfb2aded8),
+     TOBN(0x987f4975, 0xac9b750e), TOBN(0x949da385, 0x337f7f25),
+     TOBN(0x00c2ee1c, 0x9c7de99f), TOBN(0x28a7461d, 0x15e50391),
+     TOBN(0x1bdc0e32, 0xa1c77952), TOBN(0xe98242c4, 0xd53d640d),
+     TOBN(0x1a4724d2, 0xcf153c7d), TOBN(0x194e5dcc, 0xba477d46),
+     TOBN(0x871c8cfe, 0x3a0d4ccd), TOBN(0x62010af0, 0x9af451fb),
+     TOBN(0x9b354f9e, 0x6ddec75c), TOBN(0xe5db0a5d, 0x680e3511),
+     TOBN(0x183d1270, 0xd247745b), TOBN(0x9910867a, 0xeecf52dc),
+     TOBN(0x6fb6b7bc, 0x0410ca0b), TOBN(0x0e16eed2, 0xb3c13935),
+     TOBN(0x98ad89d8, 0x316ff531), TOBN(0x4800ee17, 0x9894d65f),
+     TOBN(0x034ea3c4, 0x48280170), TOBN(0x8126d12d, 0xc30be537),
+     TOBN(0x43c2d27e, 0x5120e525), TOBN(0x96a5d498, 0xee65df90),
+     TOBN(0x65454010, 0x5eaef29a), TOBN(0x1d8f07a1, 0x7b678fc7),
+     TOBN(0x54bc6f73, 0x7b301270), TOBN(0xe58a8102, 0xe9473365),
+     TOBN(0x460c2990, 0x4ac6cf02), TOBN(0x01482cfa, 0x420a35b7),
+     TOBN(0xf793933a, 0x34680972), TOBN(0x2cd1f500, 0x17e2367b),
+     TOBN(0x2411c352, 0x3944f060), TOBN(0x3d58b974, 0x11c06b05),
+     TOBN(0x4552e369, 0xcddebb3b), TOBN(0xe1c38aec, 0x009aeab9),
+     TOBN(0x9d34737c, 0x353b6e4f), TOBN(0xf2c99e2c, 0xb16d7b0c),
+     TOBN(0x57029fa4, 0x7bbba6a2), TOBN(0x0565d1bc, 0xd13ef64d),
+     TOBN(0x3561b3fe, 0xa329deb1), TOBN(0xfdca0e34, 0xf1c3c3e4),
+     TOBN(0x43748313, 0x47fb79d6), TOBN(0xa7f497e1, 0xc48002ed),
+     TOBN(0x86221cce, 0x2c44dcb0), TOBN(0x65e3f046, 0x43785e06),
+     TOBN(0x9ee9061f, 0xdf4cf461), TOBN(0xc7479e8c, 0xf022d27a),
+     TOBN(0x1d8de85b, 0x76f7f52b), TOBN(0x39a713c9, 0x0fd6c65f),
+     TOBN(0xf74ca067, 0x711f8a39), TOBN(0xad1119ad, 0x8ebc640a),
+     TOBN(0x59753bf6, 0x8ba85dff), TOBN(0xec8b82ef, 0xd1c89bce),
+     TOBN(0xd7f1a651, 0xb8b6a683), TOBN(0x9c329bf3, 0x6f84416d),
+     TOBN(0xaecbf4b9, 0xe68db225), TOBN(0x94ec3b0f, 0x5a614d23),
+     TOBN(0xbcb66725, 0x93a9543d), TOBN(0x90c46c46, 0xf19132ed),
+     TOBN(0x4767c73c, 0x950b080f), TOBN(0x0b9b143e, 0x971fd9e5),
+     TOBN(0xbce6886f, 0x8ec8c68d), TOBN(0x167b0f8a, 0xd47f512e),
+     TOBN(0x1942c2ff, 0xcd74009d), TOBN(0x71c4d5f5, 0xe9c286a4),
+     TOBN(0xf3c152b5, 0x771a5972), TOBN(0x4cfb1e74, 0x363c2048),
+     TOBN(0xcd2ce824, 0x9ddb8da2), TOBN(0x5d97c8e0, 0xa5ee443d),
+     TOBN(0x6fa84b3d, 0x68d7b3d5), TOBN(0x97eaa76d, 0x9ce14ec3),
+     TOBN(0x2e457136, 0x8e13869d), TOBN(0x39ac6a0c, 0x96f0f8a1),
+     TOBN(0xe24458ac, 0x42d93dc0), TOBN(0x7eb3689d, 0x5f60bec9),
+     TOBN(0x29544fe8, 0x588360ec), TOBN(0xa1aa9b9f, 0xffb550ea),
+     TOBN(0xe1f6cf99, 0x4af4d28d), TOBN(0x723d48b0, 0x0c6fd477),
+     TOBN(0xf51f1b2f, 0x5c81b252), TOBN(0x88ec11c0, 0x4f5a33ee),
+     TOBN(0x7747f043, 0x2cd72de4), TOBN(0xcca69b0a, 0xd71c92c1),
+     TOBN(0x9455d86e, 0x4e8cc763), TOBN(0xc9e0aa1b, 0xc08444e0),
+     TOBN(0x93803b68, 0xe8fffa63), TOBN(0xc296af29, 0x2d781b7d),
+     TOBN(0x514cc1dc, 0xb08d2d0e), TOBN(0x4e6b379e, 0x30e93536),
+     TOBN(0xf0e422ac, 0x2fc9230f), TOBN(0xaa50a1ad, 0x92e23e21),
+     TOBN(0x70ac46d8, 0x676d1ac0), TOBN(0x698b9991, 0xf9f54493),
+     TOBN(0x59a6b86a, 0x8649519f), TOBN(0xc1f11ad6, 0xe3511da4),
+     TOBN(0xd3d9cff1, 0x3192968c), TOBN(0x13e700b4, 0x0b342dd8),
+     TOBN(0xfd5dc7bb, 0x3b1da441), TOBN(0x02426e7c, 0x2c883760)},
+    {TOBN(0x9e9af315, 0x1c4c9d90), TOBN(0x8665c5a9, 0xd12e0a89),
+     TOBN(0x204abd92, 0x58286493), TOBN(0x79959889, 0xb2e09205),
+     TOBN(0x0c727a3d, 0xfe56b101), TOBN(0xf366244c, 0x8b657f26),
+     TOBN(0xde35d954, 0xcca65be2), TOBN(0x52ee1230, 0xb0fd41ce),
+     TOBN(0xfa03261f, 0x36019fee), TOBN(0xafda42d9, 0x66511d8f),
+     TOBN(0xf63211dd, 0x821148b9), TOBN(0x7b56af7e, 0x6f13a3e1),
+     TOBN(0x3997900e, 0xcc8998d6), TOBN(0x8fa564b7, 0xbaa60da1),
+     TOBN(0x71bf5b0a, 0x661f3c57), TOBN(0x44b13388, 0xaab1292b),
+     TOBN(0xcbe80cb9, 0xd4d993f2), TOBN(0x0b19b4c9, 0x2203f966),
+     TOBN(0xbc82a652, 0x0080f259), TOBN(0x870ebc08, 0xad96dea3),
+     TOBN(0xa388c7e7, 0x502f0003), TOBN(0x9c704ef0, 0x56a38f73),
+     TOBN(0x93cde8a7, 0x3487d9b0), TOBN(0x5e9148b0, 0xec11a1f3),
+     TOBN(0x47fe4799, 0x5913e184), TOBN(0x5bbe584c, 0x82145900),
+     TOBN(0xb76cfa8b, 0x9a867173), TOBN(0x9bc87bf0, 0x514bf471),
+     TOBN(0x37392dce, 0x71dcf1fc), TOBN(0xec3efae0, 0x3ad1efa8),
+     TOBN(0xbbea5a34, 0x14876451), TOBN(0x96e5f543, 0x6217090f),
+     TOBN(0x5b3d4ecd, 0x9b1665a9), TOBN(0xe7b0df26, 0xe329df22),
+     TOBN(0x18fb438e, 0x0baa808d), TOBN(0x90757ebf, 0xdd516faf),
+     TOBN(0x63f27a25, 0xa748b8f5), TOBN(0x68c8f3ec, 0x2cd246c4),
+     TOBN(0x5d317cd9, 0x65f9ce38), TOBN(0x162c92e0, 0x635ba300),
+     TOBN(0x5259f64f, 0xfe343662), TOBN(0x4a6b2b66, 0x8e614ac8),
+     TOBN(0x97fb55bb, 0x01177c3b), TOBN(0xfb586c21, 0xa705cb01),
+     TOBN(0xa57e7325, 0x78061824), TOBN(0x892f6b38, 0x6c1e6306),
+     TOBN(0xf12e4c07, 0x2367b14c), TOBN(0x580d5fe2, 0xc83a48c5),
+     TOBN(0x1e6f9a95, 0xd5a98d68), TOBN(0x759ea7df, 0x849da828),
+     TOBN(0x365d5625, 0x6e8b4198), TOBN(0xe1b9c53b, 0x7a4a53f9),
+     TOBN(0x55dc1d50, 0xe32b9b16), TOBN(0xa4657ebb, 0xbb6d5701),
+     TOBN(0x4c270249, 0xeacc76e2), TOBN(0xbe49ec75, 0x162b1cc7),
+     TOBN(0x19a95b61, 0x0689902b), TOBN(0xdd5706bf, 0xa4cfc5a8),
+     TOBN(0xd33bdb73, 0x14e5b424), TOBN(0x21311bd1, 0xe69eba87),
+     TOBN(0x6897401c, 0xea2bafb3), TOBN(0x7b96ecc2, 0x15c56fe4),
+     TOBN(0xe511b329, 0x39e2b43b), TOBN(0x39522861, 0xbf809331),
+     TOBN(0x815f6c1d, 0xc958f8f4), TOBN(0x2abbdf6b, 0xc213e727),
+     TOBN(0xeb09ae59, 0xc39bc01f), TOBN(0xffe3b831, 0x676b56a5),
+     TOBN(0x8f4815a2, 0xa20f86c6), TOBN(0x748a1766, 0x9aa30807),
+     TOBN(0xf1f46a21, 0x1b758878), TOBN(0xbd421fe7, 0x6f6fc3d7),
+     TOBN(0x75ba2f9b, 0x72a21acc), TOBN(0x356688d4, 0xa28edb4c),
+     TOBN(0x3c339e0b, 0x610d080f), TOBN(0x614ac293, 0x33a99c2f),
+     TOBN(0xa5e23af2, 0xaa580aff), TOBN(0xa6bcb860, 0xe1fdba3a),
+     TOBN(0xaa603365, 0xb43f9425), TOBN(0xae8d7126, 0xf7ee4635),
+     TOBN(0xa2b25244, 0x56330a32), TOBN(0xc396b5bb, 0x9e025aa3),
+     TOBN(0xabbf77fa, 0xf8a0d5cf), TOBN(0xb322ee30, 0xea31c83b),
+     TOBN(0x300b0484, 0x0d6ded89), TOBN(0x0b1092cb, 0xc3ab55ed),
+     TOBN(0x17d9c542, 0x0cc10a74), TOBN(0x7f637e84, 0xeff9d010),
+     TOBN(0xd732aa1e, 0x27aa1285), TOBN(0xedb97340, 0xe2a77114),
+     TOBN(0x62acf158, 0x5ef4dfb0), TOBN(0x1e94fc6e, 0xba1d7b81),
+     TOBN(0x88bec5d2, 0x2e6eb2db), TOBN(0xaec27202, 0x8d18263d),
+     TOBN(0x4b687353, 0xe4bbd6ac), TOBN(0x031be351, 0x0ff7e4c0),
+     TOBN(0x04881384, 0x7890e234), TOBN(0x387f1159, 0x672e70c6),
+     TOBN(0x1468a614, 0x7b307f75), TOBN(0x56335b52, 0xed85ec96),
+     TOBN(0xda1bb60f, 0xd45bcae9), TOBN(0x4d94f3f0, 0xf9faeadd),
+     TOBN(0x6c6a7183, 0xfc78d86b), TOBN(0xa425b5c7, 0x3018dec6),
+     TOBN(0xb1549c33, 0x2d877399), TOBN(0x6c41c50c, 0x92b2bc37),
+     TOBN(0x3a9f380c, 0x83ee0ddb), TOBN(0xded5feb6, 0xc4599e73),
+     TOBN(0x6c00f388, 0xf086d06c), TOBN(0x17ee4503, 0x5add0cf4),
+     TOBN(0xf96984c7, 0x07caf89c), TOBN(0x9d49d667, 0x648ed5e9),
+     TOBN(0x3ef95015, 0xa0164881), TOBN(0x39e28e44, 0x7d9c651f),
+     TOBN(0xb13ad240, 0x59f37780), TOBN(0x08cee349, 0xb9522225),
+     TOBN(0x9245ee6f, 0x2ba1b214), TOBN(0x12bedaa9, 0xa886d8d2),
+     TOBN(0xe139ae08, 0xfcb8186f), TOBN(0x99203fb6, 0xfc2ef864),
+     TOBN(0x14d34c21, 0x0b7f8354), TOBN(0x1475a1cd, 0x9177ce45),
+     TOBN(0x9f5f764a, 0x9b926e4b), TOBN(0x77260d1e, 0x05dd21fe),
+     TOBN(0x3c882480, 0xc4b937f7), TOBN(0xc92dcd39, 0x722372f2),
+     TOBN(0xf636a1be, 0xec6f657e), TOBN(0xb0e6c312, 0x1d30dd35),
+     TOBN(0xfe4b0528, 0xe4654efe), TOBN(0x1c4a6820, 0x21d230d2),
+     TOBN(0x615d2e48, 0x98fa45ab), TOBN(0x1f35d6d8, 0x01fdbabf),
+     TOBN(0x3c292847, 0x64c9323d), TOBN(0x40115a89, 0x0491f77d),
+     TOBN(0xec141ade, 0x2d7a05f5), TOBN(0x0c35e4d9, 0x222a5f9f),
+     TOBN(0x5ea51791, 0x442a3e9b), TOBN(0x17e68ece, 0xe51b841e),
+     TOBN(0x415c0f6c, 0xd6ae9174), TOBN(0xe6df85f8, 0x9ffd7595),
+     TOBN(0x65fc694f, 0x8dedf59c), TOBN(0xc609503e, 0xfee92718),
+     TOBN(0x57d2592e, 0x97d565ae), TOBN(0xb761bf15, 0x7e20862b),
+     TOBN(0xa636eeb8, 0x3a7b10d1), TOBN(0x4e1ae352, 0xf4a29e73),
+     TOBN(0x01704f5f, 0xe6bb1ec7), TOBN(0x75c04f72, 0x0ef020ae),
+     TOBN(0x448d8cee, 0x5a31e6a6), TOBN(0xe40a9c29, 0x208f994b),
+     TOBN(0x69e09a30, 0xfd8f9d5d), TOBN(0xe6a5f7eb, 0x449bab7e),
+     TOBN(0xf25bc18a, 0x2aa1768b), TOBN(0x9449e404, 0x3c841234),
+     TOBN(0x7a3bf43e, 0x016a7bef), TOBN(0xf25803e8, 0x2a150b60),
+     TOBN(0xd443b265, 0x82376117), TOBN(0xb91087c1, 0x1a1beb0d),
+     TOBN(0x3fe62a65, 0x45cc5951), TOBN(0x49c754bc, 0xe6e472d5),
+     TOBN(0x7e60bb81, 0x77c424eb), TOBN(0xbcd4088e, 0x830cbb97),
+     TOBN(0x3da5c94e, 0xba26df7b), TOBN(0x508b4f55, 0xf72b4338),
+     TOBN(0x409c5c74, 0x69ad7784), TOBN(0x82e5f1b0, 0xfdf44d6a),
+     TOBN(0x10654a1c, 0xeed2766f), TOBN(0xef1e65fa, 0xa6e83f4a),
+     TOBN(0xe44a2a57, 0xb215f9e0), TOBN(0x38b34dce, 0x19066f0a),
+     TOBN(0x8bb91dad, 0x40bb1bfb), TOBN(0x64c9f775, 0xe67735fc),
+     TOBN(0xde142417, 0x88d613cd), TOBN(0xc5014ff5, 0x1901d88d),
+     TOBN(0xa250341d, 0xf38116b0), TOBN(0xf96b9dd4, 0x9d6cbcb2),
+     TOBN(0x15ec6c72, 0x76b3fac2), TOBN(0x88f1952f, 0x8124c1e9),
+     TOBN(0x6b72f8ea, 0x975be4f5), TOBN(0x23d288ff, 0x061f7530),
+     TOBN(0xa6e19d0a, 0x5f56dc3c), TOBN(0xe387e269, 0x0b88326a),
+     TOBN(0xef738095, 0x0ee527a4), TOBN(0x78b7174b, 0x7c4278a6),
+     TOBN(0xc133d867, 0xe70798ff), TOBN(0x9d0fef75, 0x9e9230ca),
+     TOBN(0x7431eef0, 0x1a955ab9), TOBN(0x3772e703, 0x8868d922),
+     TOBN(0xf7a4306a, 0x8d6af3f7), TOBN(0x633bb5a0, 0xbbec076a),
+     TOBN(0x6d07623e, 0x7a257ca3), TOBN(0xffb5e165, 0x21c00663)},
+    {TOBN(0x35ae891b, 0xbb71e9b0), TOBN(0x1f6ce6ca, 0x522b77f0),
+     TOBN(0xc2dab3ca, 0xe63745c4), TOBN(0x55b8c185, 0xf218d139),
+     TOBN(0x6ab039c8, 0x89f3b0e2), TOBN(0xd9e25bfd, 0xc644c3fa),
+     TOBN(0xc8496f20, 0x3e2ed47b), TOBN(0xc395ec02, 0x8d67e17c),
+     TOBN(0x5c678392, 0x92114918), TOBN(0xe962e52f, 0xef73f345),
+     TOBN(0x3818baf3, 0x54fcfb22), TOBN(0x4d75d65d, 0x9d4bc911),
+     TOBN(0x7f1f985c, 0x022ea83a), TOBN(0x90a22662, 0xa7584e7f),
+     TOBN(0xb40a930a, 0x5188fcf6), TOBN(0x3fad79ab, 0xa3a82904),
+     TOBN(0x7bee8d22, 0xf3151027), TOBN(0x79a1a838, 0xc2c3e17b),
+     TOBN(0x1fbe06e9, 0x33cc3509), TOBN(0x629c56aa, 0x9abd5cca),
+     TOBN(0xfff290ec, 0x2d9cf7a5), TOBN(0x5d0dedaa, 0x9bd062c5),
+     TOBN(0x080344ab, 0xd7d35381), TOBN(0x0848373a, 0xf5cf9eda),
+     TOBN(0x170098de, 0xa1b31832), TOBN(0xc6876bf9, 0x2cd8c540),
+     TOBN(0x35b1b04b, 0x8660d773), TOBN(0x8b4b6c4b, 0x5152ad1e),
+     TOBN(0x0b0bd1c2, 0x4a8e92aa), TOBN(0xd814f6f4, 0x88172f4e),
+     TOBN(0x13a76899, 0x41ac83d1), TOBN(0x355933b4, 0xf1d80357),
+     TOBN(0x4b394f97, 0x3dc17e72), TOBN(0x1b0cd166, 0x0a7124b2),
+     TOBN(0x7549880c, 0xce8a372c), TOBN(0x79f53f7e, 0xe712603b),
+     TOBN(0x31d31f7a, 0x7a0c0bc0), TOBN(0x7a37a84a, 0xb251d2bf),
+     TOBN(0x1793362e, 0x52f04d67), TOBN(0x5808e709, 0x21c7b651),
+     TOBN(0x33fe9123, 0xed6f47f6), TOBN(0xdeb1dde9, 0x58f71405),
+     TOBN(0x821d3045, 0xae56b472), TOBN(0x9f61f761, 0xe02043ad),
+     TOBN(0x932ddb14, 0x5b2048a9), TOBN(0x17d989fe, 0xd7811330),
+     TOBN(0x032ae4cb, 0x128fd85f), TOBN(0x8f1956b4, 0x7d1ef434),
+     TOBN(0x30cc44e0, 0xce1d819c), TOBN(0x3c2c4f04, 0x15a3a414),
+     TOBN(0x7f06d2c2, 0x665b634b), TOBN(0xf609fe64, 0x7df0bd69),
+     TOBN(0x4b0c8c36, 0x6a0dbf94), TOBN(0xd0a3a752, 0x46e9b487),
+     TOBN(0x7407e157, 0x9578a83f), TOBN(0xc46ffa4f, 0xfe0f975f),
+     TOBN(0xb086f199, 0x1efaeccf), TOBN(0xf984b69d, 0x64796c18),
+     TOBN(0x14de44fa, 0x8ebfb97d), TOBN(0x47bcb675, 0xf5245ba6),
+     TOBN(0xed58c1ab, 0x0dbafc49), TOBN(0x41995a5a, 0x6fa8b473),
+     TOBN(0x3af3853d, 0x85450ccb), TOBN(0x18d1a7be, 0x601fe529),
+     TOBN(0xd196520f, 0xdab2d926), TOBN(0xd1f2c1e9, 0x56213ae9),
+     TOBN(0x37218255, 0x77ded01d), TOBN(0x366c552d, 0xa7905433),
+     TOBN(0x023d0373, 0x7d9430d1), TOBN(0x65d70cb6, 0x9ddf69ea),
+     TOBN(0x6321df7a, 0xd4d3fa24), TOBN(0x77b1c2bf, 0xb91084c3),
+     TOBN(0x2434dbdf, 0x0aef0ff7), TOBN(0xca74413e, 0x9cc3d2ba),
+     TOBN(0x0aee0d65, 0x3dcbaeb9), TOBN(0x89568076, 0x4184a72e),
+     TOBN(0x3d7e4f61, 0xbe7d4e0f), TOBN(0x284a8608, 0xae441b4c),
+     TOBN(0x7274fd92, 0x6a67283c), TOBN(0xa222be15, 0xc06e0b84),
+     TOBN(0xa0713cd7, 0xe4623e88), TOBN(0x0ff4a317, 0x4710aa33),
+     TOBN(0xc9a35a65, 0x044dcecd), TOBN(0x7bae1eca, 0xde77a24b),
+     TOBN(0x070d34e1, 0x16973cf4), TOBN(0x20aee08b, 0x7e4f34f7),
+     TOBN(0x269af9b9, 0x5eb8ad29), TOBN(0xdde0a036, 0xa6a45dda),
+     TOBN(0xa18b528e, 0x63df41e0), TOBN(0x03cc71b2, 0xa260df2a),
+     TOBN(0x24a6770a, 0xa06b1dd7), TOBN(0x5bfa9c11, 0x9d2675d3),
+     TOBN(0x73c1e2a1, 0x96844432), TOBN(0x3660558d, 0x131a6cf0),
+     TOBN(0xb0289c83, 0x2ee79454), TOBN(0xa6aefb01, 0xc6d8ddcd),
+     TOBN(0xda10f552, 0x81069df0), TOBN(0x70088f4e, 0x560ea55a),
+     TOBN(0xdcee31af, 0xda8cbaa5), TOBN(0x1213b76a, 0xbe16a7b7),
+     TOBN(0x4fffa388, 0x781114d1), TOBN(0x2cc19aa9, 0x904479d2),
+     TOBN(0xc4ebf9be, 0x85eec3cd), TOBN(0x48ea527a, 0xbaff7431),
+     TOBN(0xa5b6fdca, 0x52d3ce22), TOBN(0xbcb07835, 0x7e139d7a),
+     TOBN(0xc7f17551, 0x5de5de75), TOBN(0x005ab4d9, 0x15bcf7aa),
+     TOBN(0x041511b0, 0x41383866), TOBN(0x7c90692a, 0xdb9c2b4c),
+     TOBN(0x736cc6af, 0x61deb106), TOBN(0x57d428cb, 0xb5b84abe),
+     TOBN(0x14bc4981, 0x35dbcca9), TOBN(0xece90041, 0x37f3ef2e),
+     TOBN(0xe2c33711, 0x85066bd0), TOBN(0x335bd50b, 0xabef34c2),
+     TOBN(0x755f513d, 0xb017a337), TOBN(0x28d263e2, 0x284445ad),
+     TOBN(0x83402ba9, 0xecb8436e), TOBN(0x66357324, 0xf31d28d4),
+     TOBN(0x05fb9811, 0xbce3cea0), TOBN(0x74adb5b5, 0xdf2b07df),
+     TOBN(0x870e63b8, 0x0c4e5e2a), TOBN(0xe873cba7, 0xe5fec889),
+     TOBN(0x28b0e005, 0x19cd8a3e), TOBN(0xbb16491b, 0x48112c8c),
+     TOBN(0xddb8cfb5, 0x5df42faa), TOBN(0x35f952ae, 0x2ab1a097),
+     TOBN(0x35e885e1, 0xd2dfa18f), TOBN(0xc3ec2325, 0x5b4a0277),
+     TOBN(0xdbe2e40c, 0xc5aecee0), TOBN(0x133383c9, 0x0690080a),
+     TOBN(0xe5d473dc, 0x7521f457), TOBN(0xe9ef09bd, 0xa00be577),
+     TOBN(0xf6d0965f, 0xb6eaa640), TOBN(0xeb494868, 0x75726560),
+     TOBN(0x452116d5, 0x28817302), TOBN(0xf0424fdb, 0xfbde3597),
+     TOBN(0xd6096da3, 0xbb454915), TOBN(0xde482808, 0x41422141),
+     TOBN(0x7a135197, 0x2d19fac0), TOBN(0xdc9a5ec4, 0x21393f6f),
+     TOBN(0xcabcc1e3, 0xeb2c8ada), TOBN(0xd4366431, 0x42d8c4f2),
+     TOBN(0x46c7b438, 0x34246834), TOBN(0xa0a570c3, 0x2eb9f9bc),
+     TOBN(0x3e01db21, 0x586a0fdd), TOBN(0x15732b07, 0x9d21192c),
+     TOBN(0xe544b5c9, 0xfd747dd8), TOBN(0xeee7e104, 0x7ed374fb),
+     TOBN(0xfa619086, 0x3b75a586), TOBN(0x9d0909f4, 0xe8a4cfd4),
+     TOBN(0x30e0e476, 0xccd93fa4), TOBN(0x5bdc5c02, 0xa14595d4),
+     TOBN(0xf6f8ab6a, 0xe245400f), TOBN(0x7bd194ce, 0xa4198419),
+     TOBN(0x713a654c, 0x68e190a6), TOBN(0x6317f6ab, 0x3037a8e6),
+     TOBN(0x005f412a, 0x6b6bafef), TOBN(0xf67f8201, 0xb53eb41a),
+     TOBN(0x96585fcb, 0xf51ccf93), TOBN(0x68ed706e, 0x045104e0),
+     TOBN(0x535dc2a7, 0x40db03d9), TOBN(0xb9f0b69d, 0xda583d56),
+     TOBN(0xeed71cb1, 0x414dc76a), TOBN(0x7368aabd, 0xc5e7698e),
+     TOBN(0x3eb6a4f1, 0x4689da93), TOBN(0x753fa65a, 0xfcb73b42),
+     TOBN(0xf5131aad, 0x9b860b0f), TOBN(0x19af93ce, 0xd9bcf9c9),
+     TOBN(0x69b9765d, 0x307ca1ca), TOBN(0x0b735808, 0x87936c0b),
+     TOBN(0x10eaf7ae, 0x1107f1cb), TOBN(0x15211ad5, 0x16dfe03b),
+     TOBN(0x9bde40d5, 0xb11c8af6), TOBN(0x513ea01a, 0xed1fc8be),
+     TOBN(0x2f04be27, 0x5412ab86), TOBN(0x2a1adc4a, 0x9de582fc),
+     TOBN(0xb0c43235, 0x00de0043), TOBN(0x689e15e4, 0x006efb33),
+     TOBN(0x0ed1082f, 0x89e4e449), TOBN(0xdb1fb471, 0x833f2378),
+     TOBN(0xa35fef0e, 0xece77352), TOBN(0x76adaa46, 0x4bf0c426),
+     TOBN(0xfbab929a, 0xa011b2fb), TOBN(0x6f475d5b, 0x9d8cc4d3),
+     TOBN(0xbe6d7f21, 0x74351480), TOBN(0x2d1362d1, 0x93e4a7ae),
+     TOBN(0xc7e2cba5, 0x106ceaab), TOBN(0xfe94528a, 0x45258697),
+     TOBN(0x7109b17d, 0x075945b0), TOBN(0xfd395b2c, 0xcae17f7a)},
+    {TOBN(0xfc1faedc, 0x310404a8), TOBN(0xea339148, 0xd3bcb128),
+     TOBN(0xf0048545, 0x6416defd), TOBN(0x75de7770, 0xc58653e7),
+     TOBN(0xdd2dcbeb, 0xe2f6f99e), TOBN(0xa4380ef4, 0xd159ac07),
+     TOBN(0x45dd713c, 0xe4173608), TOBN(0x44919b61, 0x446a6789),
+     TOBN(0x3f73756b, 0x6b962b38), TOBN(0x3cb9f53b, 0xbffd3f0c),
+     TOBN(0xd723c40b, 0x7f08ebae), TOBN(0x998a9b17, 0x0c3cddba),
+     TOBN(0xf6377e3b, 0xf6ba1469), TOBN(0xc334fb6c, 0x09c832d3),
+     TOBN(0x7f85ac42, 0xc21c0cf1), TOBN(0x7a3e31c9, 0x857d8edb),
+     TOBN(0x2eb10763, 0x27b77ed6), TOBN(0x2bfbbdbc, 0x38dae10b),
+     TOBN(0xed7c6fb1, 0x7bae3b4f), TOBN(0xc5911d9f, 0x36d04e6f),
+     TOBN(0x4dc43550, 0x4569e72f), TOBN(0xaa82fb97, 0xbedae3ab),
+     TOBN(0x06d37bef, 0x4f27e463), TOBN(0xd0dbce6d, 0xf0c35a11),
+     TOBN(0x43c78835, 0x661019ec), TOBN(0x68e916b1, 0x24e66d29),
+     TOBN(0x02c0f3a2, 0x24094671), TOBN(0xab6f1c05, 0xd0f17d86),
+     TOBN(0x6d3bac72, 0xa22d4264), TOBN(0xd7b8f152, 0xf6e5fafe),
+     TOBN(0x95627c63, 0x39447eb3), TOBN(0xfd159018, 0x79e1ff93),
+     TOBN(0x39277c83, 0x5ad80806), TOBN(0x758aafc9, 0x0d7c7b74),
+     TOBN(0x605ad8ca, 0x4cb8bec9), TOBN(0x6a90085c, 0x5741828a),
+     TOBN(0x6edf5561, 0xff8b1fbe), TOBN(0x614b788e, 0xf6eac0c0),
+     TOBN(0x7699ae56, 0xd8d66d29), TOBN(0x5f81602a, 0xe9d58eb2),
+     TOBN(0xd0c04874, 0xfaf9176d), TOBN(0x4b3a0046, 0x523153b1),
+     TOBN(0x9690930f, 0xf6315883), TOBN(0xa81c0b44, 0xa60ca92d),
+     TOBN(0x2d0e7258, 0x73bcba90), TOBN(0x57efe72d, 0xe902e329),
+     TOBN(0x3fcd5986, 0x76bc27b9), TOBN(0x492adf03, 0x93940c09),
+     TOBN(0x6895dbe2, 0xf820c195), TOBN(0x3787a500, 0x3f6c7b40),
+     TOBN(0xdc718243, 0xac1e90f3), TOBN(0x352f8c91, 0xba5d0870),
+     TOBN(0xf3d1c53e, 0xec0112b5), TOBN(0x08a0782f, 0x6b84f64a),
+     TOBN(0xd659e635, 0x8eedd5d4), TOBN(0xfc30df6c, 0x29537276),
+     TOBN(0xbfb09978, 0xa1755ce0), TOBN(0x227f7b12, 0xaa2b4187),
+     TOBN(0x828730b9, 0x226539d2), TOBN(0x9051a37c, 0xb2472c95),
+     TOBN(0x7de743e2, 0xb39317b8), TOBN(0x9205d447, 0x2d372acf),
+     TOBN(0x8226fc30, 0x3eeb0012), TOBN(0xab2a3e05, 0x2af74be6),
+     TOBN(0xbe476780, 0x4af91ac0), TOBN(0x98497c71, 0x0ca36bf4),
+     TOBN(0x74fdf7cd, 0x8d6dedb4), TOBN(0xb50778ee, 0xa0fc5919),
+     TOBN(0x5d5ec33f, 0x2fcd7c63), TOBN(0x667b8193, 0x7f33cde0),
+     TOBN(0xce48ae4b, 0x38364d44), TOBN(0xb8578963, 0x223ed67e),
+     TOBN(0x4b20d182, 0x9567f5f4), TOBN(0xde7e8149, 0x18f02b34),
+     TOBN(0xc9a4be7b, 0xecff9dd7), TOBN(0xe2f70bbe, 0x9812fd3f),
+     TOBN(0x471bf90c, 0x9c889263), TOBN(0xb60d01b5, 0x3e61f5bf),
+     TOBN(0x258c7f89, 0xd22d855b), TOBN(0x35ef5c15, 0xb75a7d4f),
+     TOBN(0x26d8e1da, 0xb247f27d), TOBN(0xcf136199, 0x8d0f7757),
+     TOBN(0x31244780, 0x3f8e894d), TOBN(0x8d2a20ba, 0xe1a3d47d),
+     TOBN(0xc68b641e, 0xc795a2c7), TOBN(0x4fe559b1, 0x5a4d6647),
+     TOBN(0xeda98cba, 0xd89ce668), TOBN(0x15f84dc0, 0x6c269d8e),
+     TOBN(0xf0eb685e, 0xcbf34023), TOBN(0x3668c530, 0xc032634a),
+     TOBN(0x2e3d7fff, 0xe4531f59), TOBN(0xe6270306, 0x85494d06),
+     TOBN(0xf02cabcf, 0xa3e050df), TOBN(0xccd2da67, 0xc001dcd9),
+     TOBN(0x50aa3723, 0x066d2d52), TOBN(0xdb075650, 0x7224a41f),
+     TOBN(0xeaf0b05d, 0x43c1e526), TOBN(0x7eddb25a, 0x5c673e17),
+     TOBN(0xfce700de, 0xc1f9bda7), TOBN(0x4e6f4c70, 0x646a1550),
+     TOBN(0xae06c3e5, 0x8ba60c35), TOBN(0x1a57101f, 0xc0c89c50),
+     TOBN(0xdb35b1f3, 0x60a36192), TOBN(0xf740a467, 0x265c3ed1),
+     TOBN(0xeab65a88, 0x6175e771), TOBN(0xd94c8cc6, 0xcbe28ed4),
+     TOBN(0xac347e7b, 0x465dd7a8), TOBN(0xca927337, 0xca9b899d),
+     TOBN(0x3499422e, 0xdd045c9e), TOBN(0x5119c675, 0x727f1f25),
+     TOBN(0xf44a89ae, 0xd76e7077), TOBN(0x9d6967b5, 0x8eb17f39),
+     TOBN(0x49b39b81, 0x2bbed398), TOBN(0x05b3a455, 0x07deb5e9),
+     TOBN(0x8fa1ebf3, 0x62039ba0), TOBN(0x52c3d14b, 0x0b650544),
+     TOBN(0x2603aaf7, 0x37d3fd20), TOBN(0xb6fe1148, 0xec70bfc0),
+     TOBN(0xe68b8475, 0xfeb74df8), TOBN(0x56fafdcb, 0xe1f4aba2),
+     TOBN(0xd061bce6, 0xa05b2adf), TOBN(0xdb6e9324, 0x8b7cf4c6),
+     TOBN(0x6344c3b6, 0x189f7ce1), TOBN(0x06993dc9, 0x3cfe678d),
+     TOBN(0xb00b5227, 0xb6e22f1b), TOBN(0x8f836e4c, 0x780137c1),
+     TOBN(0xaf822953, 0x1e9ad145), TOBN(0xb438997c, 0xdfaaa159),
+     TOBN(0x03e27459, 0x904396e6), TOBN(0xd06a0fdb, 0xc8259d86),
+     TOBN(0x8afe766b, 0xe040907b), TOBN(0x0f5ff265, 0x038fbdba),
+     TOBN(0x4b1f8698, 0xe1aa5953), TOBN(0x94af5c0c, 0xbf0a531c),
+     TOBN(0xba1c49f5, 0x6536e156), TOBN(0x31c31631, 0x09c95a75),
+     TOBN(0x268a308f, 0x0a6d9af1), TOBN(0x185b9762, 0xfa9ca8b7),
+     TOBN(0xc3b1cbcd, 0x65035840), TOBN(0x17b276c6, 0xb429c82a),
+     TOBN(0x1b4ec7b3, 0x34396850), TOBN(0x42f21d5a, 0x048a6943),
+     TOBN(0x0bf948f5, 0x5b5820bf), TOBN(0xac944487, 0xb48dca58),
+     TOBN(0xefa91b2e, 0xac575242), TOBN(0x58280b99, 0xcdaca77a),
+     TOBN(0x5c3f8382, 0xcf39d117), TOBN(0x4d460dba, 0x70e5d17c),
+     TOBN(0x440b4db8, 0x12f6d6ad), TOBN(0x14b9b335, 0x7f3a6bb8),
+     TOBN(0xfbb3746a, 0x837833cf), TOBN(0xbbf4735b, 0xda482df0),
+     TOBN(0x4efe32c0, 0x9fbf146f), TOBN(0x65e5d7c2, 0x346e3b9e),
+     TOBN(0x742e81ce, 0x434ce5d5), TOBN(0x87e2b772, 0x3bb80bd5),
+     TOBN(0x18d0983b, 0xe02f8540), TOBN(0x708654c7, 0xe8058c66),
+     TOBN(0x0b137f68, 0x92894720), TOBN(0x0b8b62e9, 0x4345444d),
+     TOBN(0x426807d3, 0xbfd043d0), TOBN(0x17ac2e64, 0x2a1ac390),
+     TOBN(0xd037e79c, 0xf2076839), TOBN(0x991d4ff0, 0x3ba4d3f2),
+     TOBN(0x3937247e, 0xd3724bfa), TOBN(0xb5b50d34, 0x218413d1),
+     TOBN(0x2accc172, 0x28157b81), TOBN(0xd07f18b7, 0xc472e8b2),
+     TOBN(0x0df64ab2, 0xca12be15), TOBN(0xdbac68f8, 0xc2f0d0f9),
+     TOBN(0x5772ba8b, 0xa2107d3e), TOBN(0x32c43ac9, 0x76724cfe),
+     TOBN(0x6f4a367e, 0x166229b7), TOBN(0x9c8bdb42, 0x230b3527),
+     TOBN(0x343d644d, 0xe71f261d), TOBN(0x45c849bf, 0x26283547),
+     TOBN(0x3a42b9b8, 0xd8e4c7b0), TOBN(0x0aff84ad, 0x9f8af5c7),
+     TOBN(0x453c3a30, 0x418cfee8), TOBN(0x6be57cdb, 0xa241633a),
+     TOBN(0x04418b59, 0x65b55050), TOBN(0xa8a797c3, 0xd324aa67),
+     TOBN(0x5f87e22c, 0x7c65a6d9), TOBN(0xaac71065, 0x1dbeffe4),
+     TOBN(0xff619d64, 0xbd3cc05c), TOBN(0x9a29c966, 0xe65c92c4),
+     TOBN(0x23af2b21, 0xdad7fcbd), TOBN(0x4950a767, 0x153b817f),
+     TOBN(0xc34a7efa, 0xc6478c55), TOBN(0x57cde95a, 0xf6cd140e),
+     TOBN(0x64b74575, 0xf5a0db2e), TOBN(0xd4b5ea52, 0x75d7fb76)},
+    {TOBN(0x28405062, 0x8e72aafb), TOBN(0x655bf353, 0x8ea8bf00),
+     TOBN(0x789d9444, 0x05547f7b), TOBN(0x7fa445ed, 0x3441e472),
+     TOBN(0xfeb19825, 0x4a44ce87), TOBN(0xccb5f12c, 0x129aed14),
+     TOBN(0x22b05de3, 0xaf94fb34), TOBN(0x7422a040, 0xd3f03199),
+     TOBN(0xfba252ca, 0xa83f7f08), TOBN(0x0f6ad6e6, 0xcefaa757),
+     TOBN(0xe1ad1871, 0x6517d806), TOBN(0xd16dc8ed, 0x8e9d97ad),
+     TOBN(0xcbb99194, 0xa3736eb6), TOBN(0xdd5161cd, 0x36dcf470),
+     TOBN(0xd50b24aa, 0xb6ab6c03), TOBN(0x419d2810, 0xbc41f4b7),
+     TOBN(0xe2e88d7a, 0x295496cf), TOBN(0x350713f2, 0xf2457ac0),
+     TOBN(0x838e4a36, 0x0427e2ae), TOBN(0x7631472a, 0x4d974e5a),
+     TOBN(0x9fa3ab1c, 0x7a5c5fdc), TOBN(0x324798cd, 0xde34cb8d),
+     TOBN(0xbfa5a9d0, 0x889105fe), TOBN(0xd05dad34, 0xfd0df249),
+     TOBN(0x536e5657, 0xcb419fc3), TOBN(0xe8c208bc, 0x1d271dd1),
+     TOBN(0x6a3713bd, 0x22d2b9ad), TOBN(0xa4c761a7, 0x471d808d),
+     TOBN(0xd93aafb6, 0x7e6dca35), TOBN(0xc46c0ae3, 0x8f55ca32),
+     TOBN(0x55dc0de7, 0xa78bfca0), TOBN(0xe9cfb301, 0x3407d0ca),
+     TOBN(0x777e2a60, 0xb3256c14), TOBN(0x32b2238c, 0x6d8fee02),
+     TOBN(0xe8b35396, 0x46e43ee8), TOBN(0x310bc1ba, 0x247985dd),
+     TOBN(0x9974759c, 0x581f9d3c), TOBN(0x9e76a970, 0xe5cb1973),
+     TOBN(0x8afec58e, 0xc64941ca), TOBN(0x2d7c57fa, 0x01d05575),
+     TOBN(0xc07c74cc, 0x5c448db5), TOBN(0xa52474ce, 0x01bb1440),
+     TOBN(0x93162d97, 0x00115bbb), TOBN(0x483b6147, 0xfd7480f9),
+     TOBN(0x4f28c57e, 0x6af18ded), TOBN(0x36faed8f, 0x174a3089),
+     TOBN(0x702dbd64, 0xa3dd6265), TOBN(0x86a9c43f, 0x6adc0d7b),
+     TOBN(0xa3510710, 0xb9de7b63), TOBN(0x9f364ad1, 0x4019c9df),
+     TOBN(0x5b66a5d7, 0x9b5bdce3), TOBN(0x2b2f6951, 0x78b1b385),
+     TOBN(0x3e4783d3, 0x3cfa9f99), TOBN(0x1af51750, 0x6bd6bcf4),
+     TOBN(0xf9c0686a, 0x81d8d7ef), TOBN(0xdc0f22ec, 0x37c068d3),
+     TOBN(0xe1b86653, 0x93545faf), TOBN(0x37ca8501, 0xa8a52881),
+     TOBN(0x07ac5c8a, 0x5603e359), TOBN(0x98fb2bab, 0x542cc937),
+     TOBN(0x4981be69, 0x0c5bbd3e), TOBN(0xb047df0a, 0x185fdb55),
+     TOBN(0x3168e050, 0x74cff00c), TOBN(0x111150a1, 0xb52c7f9c),
+     TOBN(0x0db2ed84, 0xa51c7986), TOBN(0x7d991630, 0xe61272ad),
+     TOBN(0x7443d936, 0x28de14dd), TOBN(0xfdf31f41, 0xa5daed5f),
+     TOBN(0x71e0ef4e, 0x866b5e40), TOBN(0x05c57a45, 0xb965a670),
+     TOBN(0x85bdb58c, 0x70e1aa77), TOBN(0xe4d1fe2a, 0x9df3ce32),
+     TOBN(0x5d461898, 0x2f722563), TOBN(0x11d22b39, 0x567db14c),
+     TOBN(0x9a8f004e, 0x6779cd40), TOBN(0x0812ae3d, 0x5473ecd5),
+     TOBN(0x4ed82862, 0x4e6c296a), TOBN(0x2d9ce40c, 0x064ee61f),
+     TOBN(0x4856d586, 0xd8a9eb1e), TOBN(0x2ddd6b12, 0x5d1b5e3a),
+     TOBN(0x0ab5eec0, 0x382fba3c), TOBN(0x302018df, 0xfcf4a9c8),
+     TOBN(0x7b4e6fd2, 0xab3cdedb), TOBN(0x266c246a, 0x8f64cb1d),
+     TOBN(0xc41e4aed, 0xf5c3af59), TOBN(0xa0284ad0, 0x6de9a78a),
+     TOBN(0xf5eaab7b, 0x8ed812d2), TOBN(0x7801fbb8, 0x1afb58b8),
+     TOBN(0xbe5cdba6, 0x71efcc3a), TOBN(0xe31a0e3c, 0xcd10cb91),
+     TOBN(0x882e821e, 0x85dc0bc6), TOBN(0xd3ad070f, 0xbb32e506),
+     TOBN(0x3afede2b, 0xd8a0f038), TOBN(0xe20a117c, 0x857fd3a0),
+     TOBN(0xebaa2aa4, 0x3060f767), TOBN(0x6524aa0d, 0x2b9d1da1),
+     TOBN(0x9cc5847c, 0x88cffe33), TOBN(0xff726b0f, 0x6e8eb6c1),
+     TOBN(0x9bb2ca16, 0x1bc45d8e), TOBN(0xe7903009, 0xa6d8a5a6),
+     TOBN(0x4f089cc0, 0x47db2201), TOBN(0x4135884d, 0xe6b5928a),
+     TOBN(0xb1a86a0a, 0xe5c017cf), TOBN(0xb1d9bf6d, 0xb0a393df),
+     TOBN(0x33d9c1c6, 0x28bb3277), TOBN(0xcb05b67b, 0x45b582ce),
+     TOBN(0xa72585fc, 0xf33792c5), TOBN(0x78b7c5e8, 0xa7d1ed84),
+     TOBN(0x70e478fb, 0x9346df25), TOBN(0x01dc0c2e, 0xb4a4ada5),
+     TOBN(0xaec82b00, 0x5be36ea7), TOBN(0x82618b8f, 0x6717e06a),
+     TOBN(0x2db1f6d4, 0x008f1977), TOBN(0x4e493f3b, 0x16b390d1),
+     TOBN(0xfe86fd4d, 0x990a75eb), TOBN(0xa1cf7f99, 0x783f6076),
+     TOBN(0x6cbb23e7, 0x0c049158), TOBN(0xd05be7e5, 0xed456235),
+     TOBN(0x60137406, 0x9bd836ef), TOBN(0x94ec9644, 0x32e5f604),
+     TOBN(0x3361e1ce, 0x3d87bfa8), TOBN(0x92f235e7, 0x8dcca4f0),
+     TOBN(0xc8084cb4, 0xbe323fd1), TOBN(0x3fd481a5, 0xc24c6d16),
+     TOBN(0x9b1bd940, 0x2cea81ba), TOBN(0xf5091191, 0x0c5aa59f),
+     TOBN(0x4cd8c9ef, 0xf81d5e2a), TOBN(0x5ad00013, 0x1550bff4),
+     TOBN(0x29d47b9f, 0x8cc32e55), TOBN(0x66e3e6f1, 0x11694ece),
+     TOBN(0xd5edf701, 0x7950dd7e), TOBN(0x9ccb1096, 0x0f6350c6),
+     TOBN(0x09db138d, 0x18f2470c), TOBN(0x63bd2290, 0xf613658f),
+     TOBN(0x0bb64779, 0x4feebab9), TOBN(0xfce4aee1, 0x7fdb1e71),
+     TOBN(0x7d5c0c61, 0xa7f1f65d), TOBN(0x46405b61, 0x8d02d6cd),
+     TOBN(0x7cac0485, 0x6fdcb0d0), TOBN(0x85224c4b, 0x2f8ec5af),
+     TOBN(0xb5879a59, 0xdb0aa864), TOBN(0x75f391b8, 0xff94f8b5),
+     TOBN(0xa6c994ae, 0x49c97f8e), TOBN(0x4d968fad, 0xd690b232),
+     TOBN(0xf5cd290a, 0x67e0b4e7), TOBN(0xaa6fa680, 0x7c1594b6),
+     TOBN(0xebedfbd7, 0xb63270be), TOBN(0x574b410b, 0xa369bfee),
+     TOBN(0x431cba5a, 0x020ea888), TOBN(0xd3a3102f, 0x56c71d47),
+     TOBN(0x4894bfe0, 0xa90a853a), TOBN(0xd78bd98b, 0x5f9c4b6b),
+     TOBN(0x9b1324f6, 0xd900c5c1), TOBN(0xc65c944d, 0x718c2147),
+     TOBN(0xf661de6b, 0xa987f634), TOBN(0x0315e69f, 0x172628d8),
+     TOBN(0x07c60c75, 0x22ea5f1c), TOBN(0x35beae34, 0xa36bee4f),
+     TOBN(0xa8b00a09, 0xdcba8997), TOBN(0xa77f1f3a, 0x802ce50c),
+     TOBN(0x6c4050df, 0x2a2144b0), TOBN(0xf79bfa96, 0xab1b10db),
+     TOBN(0x9025d470, 0x433a9b1c), TOBN(0xaf3e3917, 0x90d9eec8),
+     TOBN(0xbcad2d62, 0x9ae2d535), TOBN(0x7a152829, 0xeff0f6a9),
+     TOBN(0xe87345cd, 0x925fa5a0), TOBN(0x6ce00720, 0x0e84039c),
+     TOBN(0xdae449c0, 0x07f6a05a), TOBN(0xbc1b84f5, 0x5bf26c9e),
+     TOBN(0xe3b3f9ed, 0xb1c13820), TOBN(0x5442ad5b, 0x4090598b),
+     TOBN(0x794ef656, 0x13749e4d), TOBN(0xde809180, 0x948b71c5),
+     TOBN(0x4c72dc7d, 0xe203c5b5), TOBN(0x8902b097, 0x1b349fc4),
+     TOBN(0xa899bedb, 0x225a1569), TOBN(0xeb7da73d, 0xe6ff3f53),
+     TOBN(0x6ee8e160, 0x7c0be37b), TOBN(0x9ee667d2, 0xa31bf943),
+     TOBN(0x5017e145, 0xdb81146d), TOBN(0xc7d2086d, 0x45c54db8),
+     TOBN(0x2541059d, 0xfa98234a), TOBN(0x4bf344d9, 0x9985af98),
+     TOBN(0x39737ed6, 0x7b5b7b1c), TOBN(0x8e246919, 0x87c411ad),
+     TOBN(0x2fad8ced, 0xb877a75f), TOBN(0xe42352df, 0x17e60ee2),
+     TOBN(0x1a53d856, 0x404043f7), TOBN(0x6c1f07a5, 0x863927a1),
+     TOBN(0x38d3a4f4, 0xb6892121), TOBN(0xf4c10920, 0x01976c8f)},
+    {TOBN(0xbcc88422, 0xc2ec3731), TOBN(0x78a3e4d4, 0x10dc4ec2),
+     TOBN(0x745da1ef, 0x2571d6b1), TOBN(0xf01c2921, 0x739a956e),
+     TOBN(0xeffd8065, 0xe4bffc16), TOBN(0x6efe62a1, 0xf36fe72c),
+     TOBN(0xf49e90d2, 0x0f4629a4), TOBN(0xadd1dcc7, 0x8ce646f4),
+     TOBN(0xcb78b583, 0xb7240d91), TOBN(0x2e1a7c3c, 0x03f8387f),
+     TOBN(0x16566c22, 0x3200f2d9), TOBN(0x2361b14b, 0xaaf80a84),
+     TOBN(0x7a1a522b, 0x246dc690), TOBN(0xb563cbe1, 0x4b61ab70),
+     TOBN(0x41bb4abe, 0x3d4ac4ab), TOBN(0xc52950b3, 0x37f996e8),
+     TOBN(0x01d991e6, 0x79727761), TOBN(0x35de93bd, 0x978fd7d2),
+     TOBN(0x86bad5e6, 0x5706d336), TOBN(0x10844155, 0xe7f26c20),
+     TOBN(0x58ffeb77, 0x05757453), TOBN(0xbb186129, 0x3939df77),
+     TOBN(0xbfdd394a, 0x6a78ea0f), TOBN(0x907ff054, 0x6e33e1d3),
+     TOBN(0xdb1cffd2, 0xb5733309), TOBN(0x24bc250b, 0x0f9dd939),
+     TOBN(0xa4181e5a, 0xa3c1db85), TOBN(0xe5183e51, 0xac55d391),
+     TOBN(0x2793d5ef, 0xefd270d0), TOBN(0x7d56f63d, 0xc0631546),
+     TOBN(0xecb40a59, 0x0c1ee59d), TOBN(0xe613a9e4, 0xbb5bfa2c),
+     TOBN(0xa89b14ab, 0x6c5830f9), TOBN(0x4dc477dc, 0xa03f201e),
+     TOBN(0x5604f5da, 0xc88c54f6), TOBN(0xd49264dc, 0x2acfc66e),
+     TOBN(0xa7f29532, 0x0df93b34), TOBN(0x855934f2, 0x5c14df30),
+     TOBN(0xd2f54ce9, 0xefae348c), TOBN(0x5acb931c, 0xac52758d),
+     TOBN(0x287b3e18, 0xd22961a4), TOBN(0x42a5516d, 0x748f8fe1),
+     TOBN(0x1b62b341, 0x877224ca), TOBN(0xaff58db3, 0xd30a4aa7),
+     TOBN(0xbad78dad, 0xbe8da847), TOBN(0x85fa7109, 0x54f18276),
+     TOBN(0xe2cc9d28, 0x7c4bfdad), TOBN(0xbb131f76, 0x2c75f237),
+     TOBN(0x283dd7f0, 0x1c4dfa95), TOBN(0xb898cc2c, 0x62c0b160),
+     TOBN(0xba08c095, 0x870282aa), TOBN(0xb02b00d8, 0xf4e36324),
+     TOBN(0x53aaddc0, 0x604cecf2), TOBN(0xf1f927d3, 0x84ddd24e),
+     TOBN(0x34bc00a0, 0xe2abc9e1), TOBN(0x2da1227d, 0x60289f88),
+     TOBN(0x5228eaaa, 0xcef68f74), TOBN(0x40a790d2, 0x3c029351),
+     TOBN(0xe0e9af5c, 0x8442e3b7), TOBN(0xa3214142, 0xa9f141e0),
+     TOBN(0xcdcdd7d7, 0x03844670), TOBN(0x79ec59af, 0xb4a23f91),
+     TOBN(0x5923c569, 0xc00ce5c3), TOBN(0x099c17ff, 0xc589d0c7),
+     TOBN(0x0335eeea, 0x89fa6fe6), TOBN(0x916bcaca, 0xa4e868c4),
+     TOBN(0xb7037325, 0xfb687bd5), TOBN(0x57d6bca7, 0x9853b564),
+     TOBN(0xdf3132ef, 0xd5e26d28), TOBN(0x7ed994b8, 0xde919cbe),
+     TOBN(0x12df67cd, 0x6fbbb18d), TOBN(0x516e07c0, 0x6baff508),
+     TOBN(0x72f4949e, 0xf9a58e3d), TOBN(0x738c700b, 0xa48660a6),
+     TOBN(0x71b04726, 0x092a5805), TOBN(0xad5c3c11, 0x0f5cdb72),
+     TOBN(0xd4951f9e, 0x554bfc49), TOBN(0xee594ee5, 0x6131ebe7),
+     TOBN(0x37da59f3, 0x3c1af0a9), TOBN(0xd7afc73b, 0xcb040a63),
+     TOBN(0xd020962a, 0x4d89fa65), TOBN(0x2610c61e, 0x71d824f5),
+     TOBN(0x9c917da7, 0x3c050e31), TOBN(0x3840f92f, 0xe6e7ebfb),
+     TOBN(0xf2ec9ef5, 0x97e833e4), TOBN(0x97bdef97, 0x34ec7e41),
+     TOBN(0x90e2b238, 0x7d2ac6e3), TOBN(0xcf682b12, 0x0318a3b7),
+     TOBN(0x7fe76089, 0xea84a7a0), TOBN(0x85c489f9, 0x16546d05),
+     TOBN(0xf987118f, 0x6abdda05), TOBN(0x675cf998, 0xaa4b95fc),
+     TOBN(0x544c7774, 0x888a7e8c), TOBN(0xbd2647ba, 0x63ec5831),
+     TOBN(0xb479cea3, 0xfd2fe985), TOBN(0xa0421345, 0x28d163e8),
+     TOBN(0x50fbd7fe, 0x8d8b8ced), TOBN(0xc7282f75, 0x47d240ae),
+     TOBN(0x79646a47, 0x1930ff73), TOBN(0x2e0bac4e, 0x2f7f5a77),
+     TOBN(0x0ee44fa5, 0x26127e0b), TOBN(0x678881b7, 0x82bc2aa7),
+     TOBN(0xb9e5d384, 0x67f5f497), TOBN(0x8f94a7d4, 0xa9b7106b),
+     TOBN(0xbf7e0b07, 0x9d329f68), TOBN(0x169b93ea, 0x45d192fb),
+     TOBN(0xccaa9467, 0x20dbe8c0), TOBN(0xd4513a50, 0x938f9574),
+     TOBN(0xd93506a4, 0xe5947c6f), TOBN(0x4340d76a, 0x39b81d08),
+     TOBN(0x741aee59, 0x17930d30), TOBN(0xfea3d99a, 0x18fdb81c),
+     TOBN(0x1088ff6b, 0x289bcb07), TOBN(0xc6b45602, 0xb7c082c6),
+     TOBN(0x50e2baab, 0x453d8d69), TOBN(0xda9bf561, 0xe893e183),
+     TOBN(0x0af25f86, 0xb29a284d), TOBN(0x0e92e674, 0x73e01380),
+     TOBN(0xe173a0e3, 0x2be00e59), TOBN(0x402d2f3d, 0xada8954a),
+     TOBN(0x841c96b4, 0x054cb874), TOBN(0xd75b1af1, 0xa3c26834),
+     TOBN(0x7237169d, 0xee6575f0), TOBN(0xd71fc7e5, 0x0322aadc),
+     TOBN(0xd7a23f1e, 0x949e3a8e), TOBN(0x77e2d102, 0xdd31d8c7),
+     TOBN(0x5ad69d09, 0xd10f5a1f), TOBN(0x526c9cb4, 0xb99d9a0b),
+     TOBN(0x521bb10b, 0x972b237d), TOBN(0x1e4cd42f, 0xa326f342),
+     TOBN(0x5bb6db27, 0xf0f126ca), TOBN(0x587af22c, 0xa4a515ad),
+     TOBN(0xca9cb389, 0x0399721d), TOBN(0x03ad9f4a, 0xa3291479),
+     TOBN(0xd85b5df5, 0x6dee003d), TOBN(0xe1fa7b02, 0x64a4f83a),
+     TOBN(0x01c4cbfd, 0xb73f7324), TOBN(0x707010d4, 0x5cf2ddf4),
+     TOBN(0x3c6df430, 0xb12e02f8), TOBN(0x921a2901, 0x85531489),
+     TOBN(0x302fc77c, 0x91d1022c), TOBN(0xc3733ec0, 0x342d8f3f),
+     TOBN(0xb83bc75f, 0x6195a665), TOBN(0x4a14b9e7, 0xa79f8027),
+     TOBN(0x1123a531, 0xb12e542f), TOBN(0x1d01a64d, 0xb9eb2811),
+     TOBN(0xa4a3515b, 0xf2d70f87), TOBN(0xfa205234, 0xb4bd0270),
+     TOBN(0x74b81830, 0x5eda26b9), TOBN(0x9305d6e6, 0x56578e75),
+     TOBN(0xf38e69de, 0x9f11be19), TOBN(0x1e2a5c23, 0x44dbe89f),
+     TOBN(0x1077e7bc, 0xfd286654), TOBN(0xd3669894, 0x0fca4741),
+     TOBN(0x893bf904, 0x278f8497), TOBN(0xd6ac5f83, 0xeb3e14f4),
+     TOBN(0x9f0e5428, 0xe2a57359), TOBN(0xc690a3c7, 0x14998c16),
+     TOBN(0xd73c3ca2, 0xde37e07e), TOBN(0x2ddf91b8, 0xdba0bc0d),
+     TOBN(0x69d834b2, 0x7570ae71), TOBN(0x2ac8bed4, 0x735195a6),
+     TOBN(0xcd8c51ff, 0x3b1fcc5c), TOBN(0x7aa8cf4e, 0x1ba6863f),
+     TOBN(0xebb69e72, 0xae70f428), TOBN(0xa29409df, 0xaa9e936d),
+     TOBN(0x43f6ee80, 0x5a332b9b), TOBN(0x0de49efa, 0xc2eab0a9),
+     TOBN(0x327b9dab, 0x488f5f74), TOBN(0x2b44f4b8, 0xcab7364f),
+     TOBN(0xb4a6d22d, 0x19b6c6bd), TOBN(0xa087e613, 0xfc77cd3e),
+     TOBN(0x4558e327, 0xb0b49bc7), TOBN(0x188805be, 0xcd835d35),
+     TOBN(0x592f293c, 0xc1dc1007), TOBN(0xfaee660f, 0x6af02b44),
+     TOBN(0x5bfbb3bf, 0x904035f2), TOBN(0xd7c9ae60, 0x79c07e70),
+     TOBN(0xc5287dd4, 0x234896c2), TOBN(0xc4ce4523, 0xcb0e4121),
+     TOBN(0x04baa176, 0x2310333e), TOBN(0xdc75e35f, 0x7b9bad46),
+     TOBN(0xc4a6031d, 0xc6cd6108), TOBN(0xba2534d0, 0x30bf87a5),
+     TOBN(0x7ebc6e21, 0x31e497cc), TOBN(0x8a2a82b4, 0x851fd665),
+     TOBN(0x9ecae011, 0x6d5faf40), TOBN(0xfa3a6d7f, 0x96956ecb),
+     TOBN(0x39e8a9c2, 0x2fa52782), TOBN(0x74c93801, 0x236d442e),
+     TOBN(0x8b21ba23, 0xb1c289ce), TOBN(0x7f3e221b, 0x25c769cf)},
+    {TOBN(0x761e10e2, 0xca114c4a), TOBN(0xe39d121d, 0x894301b3),
+     TOBN(0xa0870ff4, 0x3dbc6fca), TOBN(0x97651286, 0xcbe0ba8a),
+     TOBN(0x47d46075, 0xc0f1ff6a), TOBN(0x18669c84, 0x3abeb5b6),
+     TOBN(0x1234c80e, 0xad8d9309), TOBN(0x1ccbe4d5, 0x1f6f97ff),
+     TOBN(0x399a2d41, 0xd82ab780), TOBN(0x8a03afaf, 0xde426e50),
+     TOBN(0xa2bcb109, 0xca6dde77), TOBN(0x840e13b0, 0x0618f5ec),
+     TOBN(0x15d47e52, 0xec645a62), TOBN(0xabe0ddb3, 0x8d6d4423),
+     TOBN(0x51226a30, 0x70cddb11), TOBN(0x63a253d3, 0x2b5a8db7),
+     TOBN(0xe8be4d1f, 0xbef37d65), TOBN(0x41e625d9, 0xc0920b91),
+     TOBN(0x08b713a8, 0xd9d040ec), TOBN(0x467fb08d, 0xc450cdba),
+     TOBN(0xa8975877, 0x917ee393), TOBN(0x294792e9, 0x1528cd12),
+     TOBN(0x4512dc8c, 0x37daf6aa), TOBN(0xa83becc9, 0x197a99b9),
+     TOBN(0x3b21dc1f, 0x538d92d8), TOBN(0xc80b22b3, 0xc005aa86),
+     TOBN(0xf536e5d3, 0x0da87d65), TOBN(0x4ce10edf, 0x0cd999a0),
+     TOBN(0x89491814, 0x50e08f5d), TOBN(0x77fd8f2e, 0x526647e6),
+     TOBN(0xcb207ee9, 0x250099fd), TOBN(0x03c7d1ab, 0xfd6aa078),
+     TOBN(0x7d4940d2, 0x25e0cf15), TOBN(0xb688b311, 0x067fa052),
+     TOBN(0x89308326, 0xa98b2e21), TOBN(0x3ee4cc2b, 0x72311eab),
+     TOBN(0x37be5d3f, 0x68d7dfcf), TOBN(0x97bdbd49, 0xb945e6f2),
+     TOBN(0x165a24b5, 0x9d1569e7), TOBN(0x254aaf59, 0xb4e293ab),
+     TOBN(0x3c751fbd, 0x6fb7c0a4), TOBN(0x14eda4ba, 0x5018cb18),
+     TOBN(0xacb3b897, 0x1b5f6aed), TOBN(0x6d10be44, 0x1e4b6b78),
+     TOBN(0x245d7258, 0x621df6d7), TOBN(0x2af0e283, 0x185f0e2a),
+     TOBN(0x1e7edc81, 0x8fddbd81), TOBN(0xbd1e6c72, 0xc538d02a),
+     TOBN(0x12014812, 0xaa006a4f), TOBN(0xf84aa1a2, 0x83374604),
+     TOBN(0x9f8475d9, 0x0ee4a8ae), TOBN(0x37a1b21d, 0x135811df),
+     TOBN(0x34143171, 0x1166af52), TOBN(0x204dd449, 0xf5a33016),
+     TOBN(0xc838d3d5, 0x372b6edd), TOBN(0x314f3053, 0x3987611c),
+     TOBN(0x819adbe0, 0xd112605c), TOBN(0x45da01ae, 0xf6b32c5c),
+     TOBN(0x3deb3018, 0x7e3b13a9), TOBN(0x0e78a3a2, 0x79058926),
+     TOBN(0xaab5f0c7, 0x42adface), TOBN(0x50d9f53f, 0xcb580132),
+     TOBN(0x68a3c689, 0xb5fd6ebf), TOBN(0xdea2f2ee, 0x9cde184a),
+     TOBN(0x8c174c44, 0x13a98466), TOBN(0x8c4e2ae1, 0xcb4d921b),
+     TOBN(0xba973c6c, 0x2d4c6d5a), TOBN(0xc6150714, 0x61d2ec5f),
+     TOBN(0x2aba1375, 0x666d8bf9), TOBN(0x2fa2768f, 0xd41272cd),
+     TOBN(0x49f3b8d7, 0xa0bc34bf), TOBN(0x61118166, 0xca45e5fc),
+     TOBN(0x92f565ea, 0x2665ae2e), TOBN(0xaaa91acf, 0x1aefd472),
+     TOBN(0x3878c718, 0xfbb062aa), TOBN(0xde46e7d8, 0x7de3c64d),
+     TOBN(0xff9900a4, 0xbd506a76), TOBN(0x4e30ed72, 0x3daa73b9),
+     TOBN(0xd6be9446, 0x7cbaff42), TOBN(0x26fe6305, 0x5dd691f4),
+     TOBN(0x64ef093c, 0x6d393800), TOBN(0x2448c67a, 0x7bb8f155),
+     TOBN(0x9da6e75f, 0xe5d732d7), TOBN(0xe837a602, 0x50b080e0),
+     TOBN(0x6858b674, 0x844626a2), TOBN(0x610cd40f, 0x0cbba6a6),
+     TOBN(0x324e674e, 0x29d9194d), TOBN(0x2dc6fdf6, 0xdcb30a51),
+     TOBN(0x3f3ecb77, 0x528aa549), TOBN(0x0721f8f9, 0x23ffaa92),
+     TOBN(0xd8efcbd6, 0x27a77538), TOBN(0xf4e642bf, 0xd6162c9c),
+     TOBN(0x04f2b0b7, 0x4cf4a16f), TOBN(0xbc0bb49f, 0xbbf335fd),
+     TOBN(0xc6b6e5bd, 0x5a928c36), TOBN(0x981b01f4, 0xd893dd45),
+     TOBN(0x2836b977, 0x518f01dc), TOBN(0x117e833e, 0xa06c7362),
+     TOBN(0xcda89f2c, 0x31152b22), TOBN(0x2084c5c4, 0x34be0102),
+     TOBN(0x6478de75, 0x2bfac8c2), TOBN(0x9f7e901a, 0xebda5ede),
+     TOBN(0x5f43adfc, 0x5aa25b6f), TOBN(0xfb719dca, 0xcdd0eee3),
+     TOBN(0x14431b2d, 0xf9b16d84), TOBN(0x846261af, 0x97f04b2b),
+     TOBN(0xcc6100b8, 0x1edd7d4d), TOBN(0x6197c87f, 0x87cde5f4),
+     TOBN(0x4a9e6281, 0xa01cb6d9), TOBN(0x699c0719, 0x87065307),
+     TOBN(0xa8ca4971, 0xdffa58be), TOBN(0x8adc304f, 0x89efaadd),
+     TOBN(0xeef0af15, 0x1f3c79d2), TOBN(0xb3be9c6c, 0x581587e8),
+     TOBN(0x79010ad2, 0xda0be326), TOBN(0x4f361e1e, 0x4be00f8b),
+     TOBN(0x180e66ba, 0xc53f3c74), TOBN(0xa668c3f3, 0xb2521c2d),
+     TOBN(0x60bc2fa6, 0xabb73a09), TOBN(0x0bda0ff6, 0x4392692f),
+     TOBN(0x2e88f308, 0x9aa349d0), TOBN(0x9f19df26, 0xa7cf751f),
+     TOBN(0x1e0229c7, 0x4885be75), TOBN(0x6770eee2, 0xa32fce2e),
+     TOBN(0x448366e4, 0x562d99d7), TOBN(0x7670bd68, 0x8bc7484a),
+     TOBN(0x15374837, 0x92d83c6b), TOBN(0xe0f499f8, 0x14f7c403),
+     TOBN(0x4cf02671, 0x8a6b78f6), TOBN(0x75f6e30a, 0x9849e689),
+     TOBN(0xaf6fe2a5, 0xcad5065a), TOBN(0x6378401b, 0x43ba98aa),
+     TOBN(0x26d6d225, 0xd2446552), TOBN(0x9b74929e, 0xd2600e42),
+     TOBN(0xcef3a052, 0x447126d2), TOBN(0xcba2f70c, 0x4d1c7e0a),
+     TOBN(0x0250a96f, 0x020d33a3), TOBN(0x9c946f94, 0xa5e587d9),
+     TOBN(0xc7d4343f, 0x86653ae6), TOBN(0x9c832859, 0x8884e9c6),
+     TOBN(0xa44fa8c5, 0x1c234f88), TOBN(0x7193e6db, 0x987f04dc),
+     TOBN(0x24efebac, 0x6a25ff37), TOBN(0xe23f0a14, 0x953b3db8),
+     TOBN(0xb13db9bb, 0x491d9ba9), TOBN(0x7105da91, 0x5556de42),
+     TOBN(0xafa75d3b, 0xbd48b3d9), TOBN(0x10246797, 0xed6c519c),
+     TOBN(0x83b27882, 0x1aa866f5), TOBN(0x66f4ceaa, 0x54f64e96),
+     TOBN(0xf4f03faf, 0x43c07b18), TOBN(0x97eed374, 0xdd18ddec),
+     TOBN(0x43b702f1, 0x6c454f23), TOBN(0x3c53810c, 0x3cb61e31),
+     TOBN(0x8a50cfe9, 0xedcaea49), TOBN(0xfb70772b, 0x89a6acd9),
+     TOBN(0xedc09655, 0xa01edb12), TOBN(0xdaa9f823, 0x7ad80675),
+     TOBN(0xb7f23b6c, 0xf6a1052d), TOBN(0x22dc809f, 0x697dc18b),
+     TOBN(0x0453593f, 0x6c8bcd69), TOBN(0x80f76d8b, 0xc9b43cf0),
+     TOBN(0x8e781e17, 0x8c5b3ba9), TOBN(0x66544c7c, 0x66a0b318),
+     TOBN(0xedd99cbd, 0x9d95b620), TOBN(0xc36c4334, 0xbdf0933e),
+     TOBN(0x3d550b68, 0x8b59acf3), TOBN(0xcd7d1701, 0x6ca6a2b7),
+     TOBN(0x94457602, 0xc3d5ad9a), TOBN(0xa1a9608e, 0x3a7a1abc),
+     TOBN(0x16eb2310, 0x31a107cb), TOBN(0x5d921026, 0x987bf106),
+     TOBN(0xec2e5789, 0xd2ccc296), TOBN(0x87b86d1b, 0xb8f2fbd4),
+     TOBN(0x939b5802, 0x6da88d7d), TOBN(0x22fa6ef8, 0xe19707e2),
+     TOBN(0x8b95bd5d, 0xc547ce83), TOBN(0x91268688, 0xd16fb119),
+     TOBN(0xbf199148, 0x6e3627f2), TOBN(0xd072bdf2, 0xc31ab346),
+     TOBN(0xfb083c2a, 0xf810465b), TOBN(0xb66a8de9, 0x02ce0dee),
+     TOBN(0x6e4130e7, 0x47a81b95), TOBN(0xcd704dc6, 0x58a98737),
+     TOBN(0x842ae329, 0x592829c9), TOBN(0x99bedc34, 0xbe20dd63),
+     TOBN(0xabee8e55, 0xd53b2df4), TOBN(0x6ce65758, 0x6010b37c),
+     TOBN(0x781f39b2, 0x467112b9), TOBN(0x6f06058f, 0xbe341038),
+     TOBN(0x5effdca5, 0x12a2f8be), TOBN(0xaa9bdad7, 0xaf34466e)},
+    {TOBN(0xab86639e, 0x9c216137), TOBN(0x45a12fb8, 0x82b18d64),
+     TOBN(0xb5734418, 0xd763f0bb), TOBN(0xd2cc3322, 0x11a9802c),
+     TOBN(0xe41d7db8, 0x81269b8a), TOBN(0x91072fc1, 0x2ecfa355),
+     TOBN(0x59d69125, 0x04ce306f), TOBN(0x916d9d4d, 0xa131b86d),
+     TOBN(0x84478b6b, 0x8a739738), TOBN(0xe86ad7d9, 0x1cc83ae3),
+     TOBN(0xbc9b2084, 0x797ccd97), TOBN(0xc1e94af4, 0x694944c6),
+     TOBN(0x585edee3, 0x895c0318), TOBN(0x775e142f, 0x45e8205b),
+     TOBN(0x3bd7924f, 0xd85ad31f), TOBN(0x2e7d8f91, 0x9124bffa),
+     TOBN(0x885397c0, 0x44c62868), TOBN(0xc0c2dff4, 0x7fda9f5d),
+     TOBN(0xd302582e, 0xc14e693d), TOBN(0x53d6e33a, 0x6cec31ba),
+     TOBN(0xb0216b5b, 0x63653c06), TOBN(0x8f08a1ad, 0x9c70dad4),
+     TOBN(0xccf014aa, 0xffbba93d), TOBN(0x900b0d2c, 0xa33f12b7),
+     TOBN(0x0dd2395e, 0x9b8cfa41), TOBN(0x50e203ab, 0xd4f92a44),
+     TOBN(0x7280aff1, 0x6630023b), TOBN(0xfcce59dc, 0x07de820e),
+     TOBN(0xa686be05, 0xbc8189ad), TOBN(0xac4b59bf, 0xaac70b7e),
+     TOBN(0xd2c0070e, 0x7a3c71ac), TOBN(0x1d550add, 0x35ac1c47),
+     TOBN(0xd42b6389, 0xfb881c1b), TOBN(0x57ca3fcc, 0xd0dafd42),
+     TOBN(0x909e8284, 0xbe26ccc9), TOBN(0x1abe7595, 0xa002235c),
+     TOBN(0x1e34781a, 0xa6a1913d), TOBN(0x9a8f3228, 0x7d0adc38),
+     TOBN(0xfc185ccc, 0x28af85ba), TOBN(0xc923d78b, 0x3ae9ba11),
+     TOBN(0x7d494d7e, 0xa7bdb313), TOBN(0xf774dfa5, 0xaf8f8b87),
+     TOBN(0xc178ccc1, 0x16e863b8), TOBN(0x2d472f2a, 0xa8899691),
+     TOBN(0x608747cc, 0x80a50372), TOBN(0x8147aa90, 0xe6f90197),
+     TOBN(0x4683d4c9, 0x78c2f216), TOBN(0x8323652c, 0x552f3b51),
+     TOBN(0xa5c08e8b, 0xcc2c9a2a), TOBN(0x70e1b405, 0x8baaf0fc),
+     TOBN(0xf29e1e5c, 0x9e36e50c), TOBN(0xa3d90800, 0x80f258c5),
+     TOBN(0xc9ceac25, 0xecad4498), TOBN(0xcb73130f, 0xca32f3fe),
+     TOBN(0x2dbe620c, 0x48b3863d), TOBN(0x8c52727f, 0x14ff53bf),
+     TOBN(0xb60b22a8, 0x6b45e9b8), TOBN(0x81e05bc0, 0xf6483c5d),
+     TOBN(0x217caa6b, 0xcd542972), TOBN(0xffab716a, 0xfa780778),
+     TOBN(0xe5d3e0d8, 0x0d7410d6), TOBN(0xcfa9ed74, 0x2be432c9),
+     TOBN(0x60044434, 0xa85a0686), TOBN(0x93b35716, 0x6ad6918a),
+     TOBN(0x1a3c3e6d, 0x051762be), TOBN(0x80813589, 0xb0ab32d6),
+     TOBN(0x64214b92, 0xaad403fd), TOBN(0x684befc1, 0x4d3fb746),
+     TOBN(0xaca5a514, 0x79515046), TOBN(0xacdba034, 0x72e84485),
+     TOBN(0x61aa2834, 0x287d9e97), TOBN(0x07a515a5, 0xcad222e7),
+     TOBN(0xb0309306, 0x8af19670), TOBN(0xd784125a, 0x34c6bf0f),
+     TOBN(0x0b425ee0, 0x255a8396), TOBN(0x91076433, 0xfb541162),
+     TOBN(0xc4d81885, 0x86f47a0e), TOBN(0x3b767d54, 0xfd7bc7c1),
+     TOBN(0x98b405d3, 0xbee196e9), TOBN(0x4ef9c511, 0xedaccf4a),
+     TOBN(0x5a6deb65, 0x03f4f1a6), TOBN(0x4a22ca64, 0x1b4c5104),
+     TOBN(0x2cce3667, 0x9145ce41), TOBN(0xd0518752, 0x3206810d),
+     TOBN(0x29d81538, 0x037bebad), TOBN(0x76e52c73, 0xd9e0b78c),
+     TOBN(0xaa4ace6e, 0x8783d1fd), TOBN(0x9c14ebdd, 0xf0e3c126),
+     TOBN(0x0eb1c08d, 0x6eca4b71), TOBN(0xd10c6b96, 0x1c91df35),
+     TOBN(0xdb8119bb, 0xe81bb84a), TOBN(0xf784d3c1, 0x17e3ceef),
+     TOBN(0x053c9168, 0x35436f81), TOBN(0xeb41ccbb, 0x9b18d212),
+     TOBN(0x93b3fb43, 0xb1bc3497), TOBN(0xd85a7c75, 0x8c1ced81),
+     TOBN(0x004105c3, 0x811af84a), TOBN(0x01307934, 0xa7934a0f),
+     TOBN(0x179fd49b, 0x9b3226a1), TOBN(0x195d9e5c, 0xde6834b4),
+     TOBN(0xfbb79dc0, 0x0e6051bd), TOBN(0x354273ed, 0x367f4487),
+     TOBN(0x4afa9d45, 0x74fb892d), TOBN(0x03ae905e, 0xa1b7f3bb),
+     TOBN(0xea32cd5d, 0x592f6122), TOBN(0xa758eed2, 0xf1103301),
+     TOBN(0x9dde4238, 0xc59d1cc8), TOBN(0xe2760bcc, 0x51022a42),
+     TOBN(0x54f84d70, 0xd377d7b0), TOBN(0xb745d190, 0x3344bc4e),
+     TOBN(0x1c693ed0, 0x8f33aa53), TOBN(0x990ed45f, 0x8bfbee7f),
+     TOBN(0xad620c9f, 0xe9b258fb), TOBN(0x465ccb10, 0x1a54bf46),
+     TOBN(0x5330a0d3, 0xebc40951), TOBN(0x34423e8c, 0xa405da61),
+     TOBN(0xeef1ce78, 0xb83043b6), TOBN(0x99678f22, 0xac06d182),
+     TOBN(0x9213f57d, 0x1802f14c), TOBN(0xf8549616, 0xadf11fda),
+     TOBN(0xf31796d2, 0xb6e392e1), TOBN(0x199d6248, 0x93b3395e),
+     TOBN(0xef14c7c2, 0x12f9b763), TOBN(0x721ebf21, 0x43edb7a5),
+     TOBN(0xa40b8894, 0x5e96f3ba), TOBN(0x8770608c, 0x4cff8394),
+     TOBN(0x990c99ae, 0x8d0def0e), TOBN(0x292b26df, 0xa15a5649),
+     TOBN(0xa98fda2c, 0x91ca89d7), TOBN(0x916cb1b4, 0x973e5f5f),
+     TOBN(0xa2823f13, 0xa72de0bb), TOBN(0x415f7bd2, 0x8cd3219d),
+     TOBN(0x521f4af7, 0x3ed03d5f), TOBN(0xe3461f66, 0xeaf9064c),
+     TOBN(0xad099ab7, 0xae03777f), TOBN(0x541cadcd, 0xb65f73ff),
+     TOBN(0x53430463, 0xa86059b9), TOBN(0x8ff88fe5, 0x043e9f82),
+     TOBN(0xd515f4c7, 0xe42cde45), TOBN(0xf7f3dec3, 0xf41c3269),
+     TOBN(0x7bed5356, 0x7ef1b8ff), TOBN(0x8782b45f, 0x1295b5fe),
+     TOBN(0xab54ebaa, 0x03917627), TOBN(0x8516beb2, 0x8787ed9f),
+     TOBN(0xba7df5a9, 0x65b68624), TOBN(0x30b4d6ed, 0x6e7d58bb),
+     TOBN(0x67e52341, 0xdbb81762), TOBN(0xd697ab1b, 0x0deeac1d),
+     TOBN(0x01d15e8e, 0x5577ea92), TOBN(0xbb12d724, 0x98fb38da),
+     TOBN(0x302faa6d, 0x4e04908d), TOBN(0x66cf6cb9, 0x09b90a9c),
+     TOBN(0xcd665dbd, 0x98d96736), TOBN(0xf7d3c528, 0xb86f3af4),
+     TOBN(0x4844c754, 0x1d8b07f4), TOBN(0x2a77d7b9, 0x1eaf7dc0),
+     TOBN(0x53e59f25, 0x1d70eb73), TOBN(0x8aed17af, 0xe69d0525),
+     TOBN(0x26ddc178, 0x64413768), TOBN(0xa7c8d40f, 0x5e48c349),
+     TOBN(0x29ad92d1, 0x87ff01fb), TOBN(0x8f4e1b3b, 0x965b2de1),
+     TOBN(0xb83cfadf, 0x1446eca2), TOBN(0x7432bda4, 0xe609d416),
+     TOBN(0xcf97e8a3, 0xf1c7de69), TOBN(0x45899bd8, 0x32f55f07),
+     TOBN(0x41a68117, 0x51175738), TOBN(0x89eeb115, 0xb8efff21),
+     TOBN(0x54a01e60, 0x936c3eba), TOBN(0xf326fe96, 0xec01b12c),
+     TOBN(0xcdfaf003, 0x66e4de2e), TOBN(0xc53dba07, 0x392fd0a8),
+     TOBN(0x00d9b80f, 0x6ec46004), TOBN(0x84d59be8, 0x3ba63f8d),
+     TOBN(0xbac4ea43, 0x9dea6062), TOBN(0xb4b4845b, 0xadd568ca),
+     TOBN(0xa6ca3d34, 0xd225e2d0), TOBN(0xce72955d, 0xb50070a2),
+     TOBN(0x56e5c913, 0x21c78b68), TOBN(0x888eb198, 0x999488a3),
+     TOBN(0x5255508c, 0x11c92f34), TOBN(0x9a346cf3, 0xa294d382),
+     TOBN(0xd9765eea, 0x3095205b), TOBN(0xfea2ed70, 0x2c470ef7),
+     TOBN(0xf5e8a0fc, 0x9c40bf0a), TOBN(0xb572390e, 0xe4137a16),
+     TOBN(0xb9175371, 0x2bf2f545), TOBN(0x2c2d0f4c, 0x58cd9cc7),
+     TOBN(0xbea6bce9, 0x02385486), TOBN(0x46208408, 0xa8bc3a94),
+     TOBN(0x64a87a2a, 0x3ac45044), TOBN(0xe40da33c, 0x7df70151)},
+    {TOBN(0xee9e25d9, 0x39161b8a), TOBN(0x8763f2a2, 0xe2eead91),
+     TOBN(0xd2fc1157, 0xd2d91300), TOBN(0xe7597e2f, 0xffcbe50f),
+     TOBN(0x4be3814f, 0xe11d376e), TOBN(0x1eab3d7e, 0xdbf14562),
+     TOBN(0x38a107c0, 0xc0ad183a), TOBN(0x82976626, 0x7c753bbf),
+     TOBN(0x18014e09, 0xcaebd481), TOBN(0xb28c331b, 0xf9ace60d),
+     TOBN(0xe8fba04f, 0x211cb8e7), TOBN(0x41c4b797, 0xe42dc65e),
+     TOBN(0x009dc2f4, 0xc3e88580), TOBN(0x4a405be8, 0x99db1fb5),
+     TOBN(0xc89bfaa2, 0xec5d91fe), TOBN(0x461be9a0, 0xf160afcb),
+     TOBN(0xfdd084bb, 0x7d7566b5), TOBN(0x795275e8, 0xe48099a2),
+     TOBN(0x1b461fc9, 0xfe9815db), TOBN(0x576214cd, 0x73627bbc),
+     TOBN(0x3246332d, 0x9f09a206), TOBN(0xbde4c0c3, 0x6941d6ef),
+     TOBN(0x44ef03fd, 0xf387f5f6), TOBN(0x99c8ac01, 0x57b63400),
+     TOBN(0xaa512f20, 0x2f6e4301), TOBN(0xef668a5f, 0xbf94a1cc),
+     TOBN(0x08713c30, 0x15861b88), TOBN(0x49d47551, 0xc99bb2b6),
+     TOBN(0x6db5f812, 0xe2f0258e), TOBN(0x70c9b299, 0x998d7435),
+     TOBN(0x46168e1c, 0x5d176ae0), TOBN(0xec3306e4, 0xf730ec30),
+     TOBN(0x49439df3, 0xab69c15d), TOBN(0x1040408b, 0xea0143e4),
+     TOBN(0xb48ab8ea, 0xbc549b0a), TOBN(0x4aa38bbf, 0x10f89223),
+     TOBN(0x7e485159, 0x9598f49a), TOBN(0xbdac3d5e, 0x9629305b),
+     TOBN(0x20de0daf, 0xa6fbabfb), TOBN(0x04f01583, 0x8f09fff7),
+     TOBN(0x5a056297, 0x6a06994f), TOBN(0xf51dac8f, 0x6e3ccd33),
+     TOBN(0xc087ef9c, 0x3af507b8), TOBN(0x525ab76e, 0x6a5c6663),
+     TOBN(0x4fc04814, 0xd916ee93), TOBN(0x3369c978, 0xd23d140b),
+     TOBN(0xb0fcd70f, 0x1662028f), TOBN(0x2ca77de2, 0xe1e28adb),
+     TOBN(0x838acd1b, 0xc512bc71), TOBN(0xac06d6bd, 0xdc18afd0),
+     TOBN(0xc991c1e3, 0x9ec45f4b), TOBN(0x667c5e89, 0xcc27c68e),
+     TOBN(0x0e059b04, 0xed07f829), TOBN(0xceccf1d4, 0xcec4b3a7),
+     TOBN(0x3d9c2dc9, 0xb953f9a1), TOBN(0x4be2f7e7, 0x2d599b16),
+     TOBN(0x1a2054b1, 0x97256c26), TOBN(0xcf66fa47, 0x8b4fdfeb),
+     TOBN(0x896cc1b3, 0x8134d7ef), TOBN(0xa17264ca, 0xd41dadbc),
+     TOBN(0xe3ccfe8e, 0x37627e56), TOBN(0x00733a86, 0x7b6b21a6),
+     TOBN(0x3f13e2cb, 0xb605c427), TOBN(0x5ee12395, 0xb0d80992),
+     TOBN(0x4dcaea94, 0xb9991381), TOBN(0x4cfed7ee, 0x8c4c4b6e),
+     TOBN(0xd7aad54b, 0x7f7f45df), TOBN(0x2229407f, 0xb3809bf8),
+     TOBN(0x6eb31eee, 0x68048fd9), TOBN(0x693842df, 0xd57225fc),
+     TOBN(0x3e62cd85, 0xa88dfd3f), TOBN(0xc6307d53, 0xd5462cf1),
+     TOBN(0x2d15615e, 0xf344f5fd), TOBN(0xe0ba6a8a, 0xa7f23989),
+     TOBN(0xbbfc5804, 0x1c84e3f2), TOBN(0x22ffeaae, 0x6f4ba826),
+     TOBN(0x1e9bf274, 0x94292682), TOBN(0xc768f891, 0x46c02af9),
+     TOBN(0x894127d6, 0x177cdafa), TOBN(0x8d0523da, 0x2acdc791),
+     TOBN(0x71ada9ae, 0xdc78c3c4), TOBN(0xf21dbbb9, 0x2c532a01),
+     TOBN(0x0c797d5e, 0xacb20fda), TOBN(0x1ff99d76, 0x16cf57b0),
+     TOBN(0x99b5f150, 0x493c1d64), TOBN(0x3422b656, 0xfb74075e),
+     TOBN(0xe7493900, 0xff19bf24), TOBN(0xc82e5b80, 0x260925ed),
+     TOBN(0x3398d340, 0xc0ea1eaf), TOBN(0xe7de2ba1, 0x1287121e),
+     TOBN(0xea6dfb0b, 0x87847031), TOBN(0x73bed0a1, 0x566af2f2),
+     TOBN(0xe26678bf, 0x12012999), TOBN(0xb5369e4d, 0x32e5cebc),
+     TOBN(0x2304eac8, 0x6d181e32), TOBN(0xafdbd954, 0x3d364add),
+     TOBN(0x5b1a53ca, 0x75da4189), TOBN(0xa9048580, 0x2eb4862b),
+     TOBN(0x31942409, 0x2783ad6a), TOBN(0x15a4c5e1, 0x1a9e025e),
+     TOBN(0x841bc533, 0x13837199), TOBN(0x6e9d3e14, 0xe642954a),
+     TOBN(0xf4a02bbd, 0xd436ec5c), TOBN(0x62fe177b, 0xc6d6ad53),
+     TOBN(0xedbf1e4e, 0xac86425a), TOBN(0xff9359c8, 0xd9f752f5),
+     TOBN(0x79c685d9, 0x2d7ad656), TOBN(0x8d82c0c4, 0xfdde9052),
+     TOBN(0xf55f868e, 0x702f640d), TOBN(0xe459aa9b, 0x1dedda11),
+     TOBN(0xbec0ff9b, 0xbb5ba193), TOBN(0xf7325c49, 0x57724703),
+     TOBN(0x5ab8f063, 0x23e0e4fb), TOBN(0xfbf02e91, 0xecb0fd7c),
+     TOBN(0xcc72e8da, 0xa2e5fa31), TOBN(0x47de2528, 0x32cb53cf),
+     TOBN(0xbfa646e6, 0x4252763c), TOBN(0x7a769efe, 0xb8d81de3),
+     TOBN(0xf5ec7003, 0x1e772f00), TOBN(0x049bea9a, 0x2729aa5e),
+     TOBN(0xe987ba54, 0x759090d6), TOBN(0x904d6901, 0x619ef08b),
+     TOBN(0x9e16d138, 0x2024a6fc), TOBN(0xb6f0459b, 0xa9f3b7e4),
+     TOBN(0x1f2a5308, 0x17ee069a), TOBN(0x99403b2e, 0x2be31049),
+     TOBN(0xba1663c6, 0xbfb2f288), TOBN(0xf829195c, 0xc7a92b41),
+     TOBN(0x89b915ee, 0x8ae621b1), TOBN(0x3fbbb1e1, 0x50f8ea92),
+     TOBN(0xb1fe7f97, 0x8c901ddc), TOBN(0x16d1f62c, 0xbbc69ca4),
+     TOBN(0x51f19bb3, 0xfda072db), TOBN(0xa815459f, 0xe3f7e0a2),
+     TOBN(0x5f7cde2f, 0x987112ca), TOBN(0xdc51d948, 0x759de2cb),
+     TOBN(0x9d05c410, 0xed49bd98), TOBN(0xf063ab99, 0x364341fd),
+     TOBN(0xd7869d68, 0xd1aa0a11), TOBN(0xc2029106, 0x5d862d01),
+     TOBN(0x7f258180, 0xc2591073), TOBN(0x7b90fc7a, 0x6ebc4ebc),
+     TOBN(0x5565390f, 0x3dda1d68), TOBN(0xae77fca8, 0xa44e4493),
+     TOBN(0x97564e48, 0x47c49ee8), TOBN(0xc56bb5a9, 0xab4ebef5),
+     TOBN(0x80d96941, 0x7b4f86bc), TOBN(0xa594b4e5, 0x41026cf0),
+     TOBN(0xd56c8996, 0x5a89ece9), TOBN(0xbcf60931, 0x6a0f922b),
+     TOBN(0x70259616, 0x1103475c), TOBN(0xb1224fb5, 0x8a2a2abb),
+     TOBN(0x0a437a03, 0x715cd61b), TOBN(0xcbe2d2b2, 0x739921ed),
+     TOBN(0xf3b1b5e9, 0x385541c4), TOBN(0x5d0984f4, 0xae010520),
+     TOBN(0xb4a2742d, 0xcfd9295e), TOBN(0x9cd36774, 0xae929cd0),
+     TOBN(0xb15fadcc, 0xdd7fcf4f), TOBN(0x0b1fa2b3, 0x37d4fcc6),
+     TOBN(0x242c7b26, 0xf01c7ab7), TOBN(0x2be8131b, 0x50574cc9),
+     TOBN(0x6ee50f42, 0xbd89a03c), TOBN(0xc7f6ff8f, 0x005e7765),
+     TOBN(0x04d13af1, 0x8420501b), TOBN(0xc22e092b, 0x1b6e7d2a),
+     TOBN(0xa393be7e, 0xe9516f80), TOBN(0xa2593652, 0xb80bb5b5),
+     TOBN(0x5caa5da6, 0x8b23bebb), TOBN(0xa1ad33e8, 0x1fdbbdf4),
+     TOBN(0x18dc93cf, 0x4e5c1de0), TOBN(0xc3e6addb, 0x5bd9e178),
+     TOBN(0xf30d517e, 0x7cb8cd03), TOBN(0xbb84ce54, 0xf1abc417),
+     TOBN(0x0774b64c, 0x67699659), TOBN(0x228005b9, 0xb7d4a401),
+     TOBN(0xd8c2ec5b, 0x80b2d3d2), TOBN(0x419c4cd9, 0x3450ba7f),
+     TOBN(0x520ae681, 0x789286a6), TOBN(0x24b67ea9, 0xaa8bcfbb),
+     TOBN(0x9e41b9b7, 0x0f74808f), TOBN(0x2d835dae, 0x0c061bdb),
+     TOBN(0x67e50c8c, 0xf272346c), TOBN(0xc98a5ef5, 0xdef57493),
+     TOBN(0xc2dea8af, 0xa02676fc), TOBN(0x59508de2, 0x6ace4659),
+     TOBN(0xc2b707aa, 0xda6cd733), TOBN(0x6c1f226a, 0x4be7bfb9),
+     TOBN(0x5b580fa2, 0xa778c20b), TOBN(0x272c3a1d, 0x57af166b),
+     TOBN(0xe47a64a9, 0xca78ce62), TOBN(0xd12db7d7, 0x71d35087)},
+    {TOBN(0xc20fb911, 0x1a42e5e7), TOBN(0x075a678b, 0x81d12863),
+     TOBN(0x12bcbc6a, 0x5cc0aa89), TOBN(0x5279c6ab, 0x4fb9f01e),
+     TOBN(0xbc8e1789, 0x11ae1b89), TOBN(0xae74a706, 0xc290003c),
+     TOBN(0x9949d6ec, 0x79df3f45), TOBN(0xba18e262, 0x96c8d37f),
+     TOBN(0x68de6ee2, 0xdd2275bf), TOBN(0xa9e4fff8, 0xc419f1d5),
+     TOBN(0xbc759ca4, 0xa52b5a40), TOBN(0xff18cbd8, 0x63b0996d),
+     TOBN(0xf6827150, 0x844eefc5), TOBN(0x002e82c4, 0x4515ef68),
+     TOBN(0xa46c8f55, 0xc51916c4), TOBN(0x98c3524b, 0x61ee081f),
+     TOBN(0x5ab7f2c2, 0xad64872a), TOBN(0x0b503ff0, 0x7e555faa),
+     TOBN(0x802e0d23, 0xb4c58d29), TOBN(0x12289040, 0x2fd917fe),
+     TOBN(0xb56d1908, 0x7af20d26), TOBN(0x8d619e21, 0x6be50784),
+     TOBN(0x10fdbb72, 0x1372b851), TOBN(0xf2c1673e, 0x4935576e),
+     TOBN(0x73c57fde, 0xd7dd47e5), TOBN(0xb0fe5479, 0xd49a7f5d),
+     TOBN(0xd25c71f1, 0xcfb9821e), TOBN(0x9427e209, 0xcf6a1d68),
+     TOBN(0xbf3c3916, 0xacd24e64), TOBN(0x7e9f5583, 0xbda7b8b5),
+     TOBN(0xe7c5f7c8, 0xcf971e11), TOBN(0xec16d5d7, 0x3c7f035e),
+     TOBN(0x818dc472, 0xe66b277c), TOBN(0x4413fd47, 0xb2816f1e),
+     TOBN(0x40f262af, 0x48383c6d), TOBN(0xfb057584, 0x4f190537),
+     TOBN(0xd97a9b14, 0x51a135f6), TOBN(0x6d16aaf5, 0x97b4df14),
+     TOBN(0xc57160c2, 0x54818818), TOBN(0x4dbdeab6, 0x1d59be44),
+     TOBN(0xb93a9dad, 0x81f2b247), TOBN(0xe2868cf5, 0xecbcab33),
+     TOBN(0x5e1ce828, 0x83a86711), TOBN(0x29a9ca2f, 0x29c55428),
+     TOBN(0xe716273a, 0x2d82b0df), TOBN(0xb017f5f6, 0xac8ff52f),
+     TOBN(0x7563e799, 0x70ea7ccd), TOBN(0x5fedf0a6, 0x3f0e674b),
+     TOBN(0x487edc07, 0x08962f6b), TOBN(0x6002f1e7, 0x190a7e55),
+     TOBN(0x7fc62bea, 0x10fdba0c), TOBN(0xc836bbc5, 0x2c3dbf33),
+     TOBN(0x4fdfb5c3, 0x4f7d2a46), TOBN(0x824654de, 0xdca0df71),
+     TOBN(0x30a07676, 0x0c23902b), TOBN(0x7f1ebb93, 0x77fbbf37),
+     TOBN(0xd307d49d, 0xfacc13db), TOBN(0x148d673a, 0xae1a261a),
+     TOBN(0xe008f95b, 0x52d98650), TOBN(0xc7614440, 0x9f558fde),
+     TOBN(0xd084564b, 0xaf907da2), TOBN(0x5b2ae487, 0x51d4997a),
+     TOBN(0x24bd4bf6, 0x3bc7206d), TOBN(0xdd37b4ef, 0xfc3d5772),
+     TOBN(0x8156d6f6, 0x35c4924f), TOBN(0x21e067c3, 0x1d1d396e),
+     TOBN(0x977b3b39, 0xd40c7db8), TOBN(0x7ea4ecb4, 0xf5ad63bc),
+     TOBN(0xe581f9c4, 0xae811d70), TOBN(0xe5441d5c, 0xa06c7f0d),
+     TOBN(0x0275c92b, 0x1949d87f), TOBN(0x511fd3e1, 0x780469bb),
+     TOBN(0x17cd6af6, 0x9cb16650), TOBN(0x86cc27c1, 0x69f4eebe),
+     TOBN(0x7e495b1d, 0x78822432), TOBN(0xfed338e3, 0x1b974525),
+     TOBN(0x527743d3, 0x86f3ce21), TOBN(0x87948ad3, 0xb515c896),
+     TOBN(0x9fde7039, 0xb17f2fb8), TOBN(0xa2fa9a5f, 0xd9b89d96),
+     TOBN(0x5d46600b, 0x36ff74dc), TOBN(0x8ea74b04, 0x8302c3c9),
+     TOBN(0xd560f570, 0xf744b5eb), TOBN(0xc921023b, 0xfe762402),
+     TOBN(0xa7f85014, 0x88d7b3fb), TOBN(0x3b5ec513, 0xec78386e),
+     TOBN(0xc6586b8a, 0x2ad5053d), TOBN(0x88c09a43, 0xfbcebe43),
+     TOBN(0xde7f2a4a, 0x20054f16), TOBN(0x63daba80, 0xbbbb147f),
+     TOBN(0x087e48f3, 0x7d352b55), TOBN(0x997e32a0, 0x8317ab79),
+     TOBN(0x8ae802ff, 0x7f27cac7), TOBN(0xb01a131c, 0x37b1f6e1),
+     TOBN(0x3f0d4c2e, 0x9a6d1dea), TOBN(0xe06114fc, 0xe7ceef80),
+     TOBN(0xa35ab657, 0xfff4c8ed), TOBN(0x017c6124, 0x8a5fabd7),
+     TOBN(0x56463025, 0x09acda28), TOBN(0x6038d361, 0x14cf238a),
+     TOBN(0x1428b1b6, 0xaf1b9f07), TOBN(0x5827ff44, 0x7482e95c),
+     TOBN(0xcb997e18, 0x780ff362), TOBN(0x2b89d702, 0xe0bcac1e),
+     TOBN(0xc632a0b5, 0xa837ddc8), TOBN(0xf3efcf1f, 0x59762647),
+     TOBN(0xe9ba309a, 0x38b0d60a), TOBN(0x05deabdd, 0x20b5fb37),
+     TOBN(0x1e2a4fb1, 0xe5ea795b), TOBN(0x862616a2, 0x89ef6c3d),
+     TOBN(0x24617f4f, 0xf69e2f1d), TOBN(0xe0be24fe, 0xffa0eb28),
+     TOBN(0x0ffb092f, 0x4b76a8ad), TOBN(0x21549090, 0x3a0dc9e8),
+     TOBN(0xf255fe06, 0xe9080e04), TOBN(0xd270d25e, 0x39228e7f),
+     TOBN(0x198e45db, 0x5d6c6f1c), TOBN(0x6c9060ad, 0x4373044c),
+     TOBN(0x3af93464, 0x61a8cc25), TOBN(0x1945bf59, 0xf22bbaa3),
+     TOBN(0xd44e5dba, 0xcb8af047), TOBN(0x15400cb4, 0x943cfe82),
+     TOBN(0xdbd69575, 0x9df88b67), TOBN(0x8299db2b, 0xb2405a7d),
+     TOBN(0x46e3bf77, 0x0b1d80cd), TOBN(0xc50cf66c, 0xe82ba3d9),
+     TOBN(0xb2910a07, 0xf2f747a9), TOBN(0xf6b669db, 0x5adc89c1),
+     TOBN(0x3b5ef1a0, 0x9052b081), TOBN(0x0f5d5ed3, 0xb594ace2),
+     TOBN(0xda30b8d5, 0xd5f01320), TOBN(0x0d688c5e, 0xaafcd58f),
+     TOBN(0x311df84c, 0x359590bf), TOBN(0xf907d69d, 0xdf6ca4b4),
+     TOBN(0x876fd367, 0x82f22c64), TOBN(0x64c4d14d, 0x9713e68c),
+     TOBN(0xd431858d, 0x6b07f539), TOBN(0x39dfea33, 0x84990283),
+     TOBN(0x6afb8cf0, 0x80cf6498), TOBN(0x327056bc, 0xde060e9e),
+     TOBN(0x5103ce4a, 0x49a71086), TOBN(0xfc94be75, 0xcdf853ab),
+     TOBN(0x2bfb105f, 0x8ca579cd), TOBN(0x02d19c3a, 0x50454b41),
+     TOBN(0x5eee3a31, 0x2a161074), TOBN(0x6baaae56, 0xefe2be37),
+     TOBN(0xf9787f61, 0xe3d78698), TOBN(0xc6836b26, 0x50630a30),
+     TOBN(0x7445b85d, 0x1445def1), TOBN(0xd72016a2, 0xd568a6a5),
+     TOBN(0x9dd6f533, 0xe355614f), TOBN(0x637e7e5f, 0x91e04588),
+     TOBN(0x42e142f3, 0xb9fb1391), TOBN(0x0d07c05c, 0x41afe5da),
+     TOBN(0xd7cd25c8, 0x1394edf1), TOBN(0xebe6a0fc, 0xb99288ee),
+     TOBN(0xd9e2c5ee, 0x7d4867b7), TOBN(0x2c5602e0, 0x87873152),
+     TOBN(0xb3358aa6, 0x2c06b73a), TOBN(0x967aec39, 0x09063076),
+     TOBN(0x94dec534, 0xd2f654fc), TOBN(0x119aa4ed, 0xd69f485e),
+     TOBN(0xb7c597b8, 0x35bc085d), TOBN(0x8781396d, 0xbdbe0d0c),
+     TOBN(0xba688929, 0x22f92ef5), TOBN(0xeece3d4e, 0xd438f5ec),
+     TOBN(0x4ead06f8, 0x44faac8b), TOBN(0x86a01ba9, 0x9ef7c5f1),
+     TOBN(0xb8e63b7b, 0xbabbad86), TOBN(0x63226a9f, 0x90d66766),
+     TOBN(0x26381836, 0x5cf26666), TOBN(0xccbd142d, 0x4cadd0bf),
+     TOBN(0xa070965e, 0x9ac29470), TOBN(0x6bdca260, 0x25ff23ed),
+     TOBN(0xd4e00fd4, 0x87dca7b3), TOBN(0xa5097833, 0x9e0e8734),
+     TOBN(0xf73f162e, 0x048173a4), TOBN(0xd23f9196, 0x9c3c2fa2),
+     TOBN(0x9ab98b45, 0xe4ac397a), TOBN(0x2baa0300, 0x543f2d4b),
+     TOBN(0xaa03b474, 0xcde121c7), TOBN(0x74a648cb, 0x55e52c76),
+     TOBN(0xb286ef86, 0xf37b57bc), TOBN(0x95b797eb, 0x2a6371d2),
+     TOBN(0xa489ef89, 0x4077ccbd), TOBN(0xf46ade04, 0x8e99ca6d),
+     TOBN(0x5cf9e237, 0x23242d03), TOBN(0x33c7d32a, 0xcb708390),
+     TOBN(0x329523b6, 0xba7ba477), TOBN(0xd406ab87, 0x57de30bf),
+     TOBN(0xaa10e4a2, 0x1536ca01), TOBN(0xdcec94f4, 0xdfa7aac5)},
+    {TOBN(0x762a5eec, 0x1f5a9609), TOBN(0xfe4f5f6a, 0x765b337f),
+     TOBN(0x0fd534ae, 0xaa4f964a), TOBN(0xcf46648e, 0xd6526f01),
+     TOBN(0xbc62a54a, 0x18d71d72), TOBN(0x48d94f2a, 0x4f8488ea),
+     TOBN(0x62c40de7, 0xa0c72a86), TOBN(0xd73ac51a, 0x725dd2ef),
+     TOBN(0x3a51d746, 0x6ab19096), TOBN(0xf07bea4b, 0x2dd1ad3d),
+     TOBN(0x2a0ec467, 0x2ef88078), TOBN(0x92598cb3, 0x664e435d),
+     TOBN(0xee6e7006, 0xb515fff5), TOBN(0xaedf6e39, 0x13258ed5),
+     TOBN(0x373adf7d, 0xfc45111b), TOBN(0x0c7535b1, 0x875c23c8),
+     TOBN(0x2a7e04f8, 0x97039d49), TOBN(0xd76787ae, 0x9afd1a06),
+     TOBN(0x049dd385, 0x91b6dc89), TOBN(0x8f0c8ad0, 0x932dab78),
+     TOBN(0xdce057b9, 0x925498c2), TOBN(0x7b9c9bd2, 0xda25daa3),
+     TOBN(0x6d0b70a3, 0xd4decb7d), TOBN(0x099a2183, 0x03df76ef),
+     TOBN(0x779905b6, 0xd8948f95), TOBN(0x3c7085b5, 0x91cd0206),
+     TOBN(0xce9af0aa, 0x679096db), TOBN(0xfdf04f10, 0xf558913c),
+     TOBN(0x05300cb0, 0x6f24a2e2), TOBN(0xf9d9a2f2, 0x5d581b35),
+     TOBN(0x855c8de9, 0x6a713751), TOBN(0xc9ac24bc, 0x0e0c0dfb),
+     TOBN(0x67612a41, 0x97740d65), TOBN(0x7588a527, 0x44c9360d),
+     TOBN(0x928ac910, 0x325cc880), TOBN(0xa74abdaf, 0xacdd3188),
+     TOBN(0x3c6c5618, 0xb9d926c2), TOBN(0x7e14c3ae, 0x4a9099f9),
+     TOBN(0xb3259c90, 0xae2fb830), TOBN(0xf7cc6e43, 0xec31a504),
+     TOBN(0x83bb13c6, 0x126230bd), TOBN(0x5a1f4313, 0xff1dae3a),
+     TOBN(0x0cc6c1a5, 0x49b0b65b), TOBN(0x67fa836a, 0x274a84c2),
+     TOBN(0xd454c75f, 0xe604a58d), TOBN(0xceadfd91, 0x2491f872),
+     TOBN(0x6c5575da, 0x9ce116a5), TOBN(0xfaa4903f, 0xb24a4481),
+     TOBN(0x7a8a898d, 0x5a4703aa), TOBN(0xc59933ea, 0x1cd6f9d6),
+     TOBN(0x703265f5, 0xd28124cd), TOBN(0xe1c1bee1, 0x0178d1fe),
+     TOBN(0x9ff31cd4, 0x241262e9), TOBN(0x9174a939, 0xa3c9f80f),
+     TOBN(0x0f7a3d2d, 0xbc2a62ee), TOBN(0x0454051c, 0x62f1b3ac),
+     TOBN(0x83502c9e, 0xa2421254), TOBN(0xb4fa51fc, 0xb684199b),
+     TOBN(0x257e9e2b, 0xc5e36a44), TOBN(0x14efeed5, 0x97d8647f),
+     TOBN(0x6e96a819, 0x5cecb21f), TOBN(0x3a58d8b2, 0xd8beecae),
+     TOBN(0x93c3cbb0, 0xc0c715a8), TOBN(0xfb06f977, 0x541759b7),
+     TOBN(0xf25ba095, 0x771c3d2c), TOBN(0x7560446e, 0xa3bfd322),
+     TOBN(0x7cd99f35, 0xa015cb4f), TOBN(0xa0e54196, 0x0786f235),
+     TOBN(0x0f868f76, 0x8b8e291a), TOBN(0xc8260b0b, 0x2f95050b),
+     TOBN(0xaf38376e, 0xf4c0a462), TOBN(0x2b3c0f3b, 0x98a3395d),
+     TOBN(0x0952b888, 0xb9d0bdf0), TOBN(0x3973763c, 0x8ce32fb7),
+     TOBN(0x221f0ba5, 0x6dd860c7), TOBN(0xbb7a27fe, 0xb16ac501),
+     TOBN(0xf113b194, 0xbc8fe58f), TOBN(0x18f3297a, 0x65839ffb),
+     TOBN(0xa2d4eb7c, 0x8dc30003), TOBN(0x3fb4b487, 0x8e334479),
+     TOBN(0xa4f32c65, 0x1a8310e3), TOBN(0x944cd644, 0xf78f46ac),
+     TOBN(0x14e40c4a, 0xf96fb91f), TOBN(0xc31402bd, 0x4ddf6e72),
+     TOBN(0xc5ad791e, 0xb45a8002), TOBN(0x4a23fd68, 0xba2d7a40),
+     TOBN(0x673b9e49, 0x98544bc4), TOBN(0x934d8f55, 0xd273c360),
+     TOBN(0x7fb48d07, 0x68a75a8c), TOBN(0x2e620105, 0x5e0fac97),
+     TOBN(0xbe01655f, 0xf10ed580), TOBN(0xd21d52ae, 0x9e96731f),
+     TOBN(0x74f830de, 0x53325138), TOBN(0xa7240331, 0xde9f3fc5),
+     TOBN(0x96b25206, 0xa7e01fa5), TOBN(0x3fcfedee, 0x07eda4b4),
+     TOBN(0xf1b08a42, 0x9336b8bb), TOBN(0xbaaa5571, 0x9a768ca6),
+     TOBN(0x70180b4c, 0x2c0a2938), TOBN(0x8e735436, 0x92dd3c07),
+     TOBN(0x2dd3af0b, 0xe3fd5b1c), TOBN(0x3cf3d179, 0x1f1af8b8),
+     TOBN(0xaff210c6, 0xd558c174), TOBN(0x1007938a, 0xe2560d5e),
+     TOBN(0xa625558c, 0x8f99a78f), TOBN(0xa61d5edf, 0xc1b91dea),
+     TOBN(0xa86a4e5b, 0xdab80815), TOBN(0x88944bfe, 0x78283ea3),
+     TOBN(0xeec9b118, 0x0ee6d492), TOBN(0xf2bd388f, 0xb7ef00fc),
+     TOBN(0x5c6c0bbf, 0x3191c902), TOBN(0x6796929a, 0xd42366de),
+     TOBN(0xeecb5b3f, 0x3285710d), TOBN(0x58d6773d, 0x41bad8a3),
+     TOBN(0x7cdbade6, 0xd0f05005), TOBN(0xb117e1ba, 0x0e25444b),
+     TOBN(0xa52b4926, 0xfe4dc071), TOBN(0xce8a1b69, 0xe0669f10),
+     TOBN(0x5e765439, 0x0db21d46), TOBN(0xc5dcdea4, 0xd929bfab),
+     TOBN(0x67832f48, 0xa36aea84), TOBN(0x25256118, 0xfc78df1d),
+     TOBN(0x5a085d70, 0x03b8f04d), TOBN(0x19a25d9c, 0x108969c2),
+     TOBN(0xb6fe713b, 0xb70b14b7), TOBN(0xba23ac4a, 0xfa6b89d8),
+     TOBN(0x6a88e4e7, 0xc2684b8c), TOBN(0x3e816609, 0x6ab59297),
+     TOBN(0xdb7927fe, 0x30151aaf), TOBN(0x0fd67681, 0xaa7d95da),
+     TOBN(0xc60e5dd5, 0x17432b4c), TOBN(0x3192dc27, 0xed48ccda),
+     TOBN(0x2116a017, 0x8af859e2), TOBN(0x8a77a7a2, 0xbd9f8800),
+     TOBN(0xc78836fb, 0xf1f2034d), TOBN(0x8fd4299a, 0x3864566b),
+     TOBN(0x0386eead, 0x29f9deca), TOBN(0x2042ef18, 0x2f1a677c),
+     TOBN(0xed4511c0, 0x2af95cc8), TOBN(0xdb0a334d, 0xc93dfbc5),
+     TOBN(0x0d788ac9, 0xb64ab345), TOBN(0xd8410402, 0xb20638f2),
+     TOBN(0x8aca5131, 0x592448e6), TOBN(0x3ac508d2, 0x000de69b),
+     TOBN(0x1ee6d3b5, 0x4f9b2400), TOBN(0x4c71999a, 0x00c9c182),
+     TOBN(0xd6b1c470, 0x35fc481e), TOBN(0xf41ef454, 0xf8b5d59c),
+     TOBN(0x7edbc3c9, 0x2824a13d), TOBN(0xa3baba91, 0xb7aa0ade),
+     TOBN(0x75c77e71, 0x2b97b392), TOBN(0x8ec107d6, 0x9cc2d53c),
+     TOBN(0x652146fe, 0x29322233), TOBN(0x710578df, 0xe679e990),
+     TOBN(0x47f838ba, 0x260547db), TOBN(0xa4e57bec, 0x23a78365),
+     TOBN(0xe4320313, 0xefb058db), TOBN(0xaad2377c, 0x3d04e752),
+     TOBN(0x3f8cbca9, 0x9865c63e), TOBN(0xe89238a5, 0x3009e55d),
+     TOBN(0x58fad5fe, 0x12519936), TOBN(0x03b16a00, 0xb024b695),
+     TOBN(0xa556d096, 0xf8f3b8c7), TOBN(0xce6df197, 0xd8a599c4),
+     TOBN(0x45ac8a25, 0x6a13b031), TOBN(0x31af2dcc, 0xca6819e8),
+     TOBN(0x7a4dce86, 0x390418e9), TOBN(0xdd24b0bd, 0x4600d7f4),
+     TOBN(0x88a8aa87, 0xb96e667f), TOBN(0xb9a76c18, 0x4e704eaa),
+     TOBN(0x25d4edc1, 0x72c924b7), TOBN(0xe56872a8, 0x16b67f80),
+     TOBN(0xda0dbb11, 0xc464e4ff), TOBN(0x0435f391, 0xc8cec410),
+     TOBN(0x8d9b4043, 0x0983fd7a), TOBN(0x51ec5bc1, 0xe7ff343c),
+     TOBN(0x8bc85fc4, 0x85994bc9), TOBN(0x69c78834, 0x8806c150),
+     TOBN(0x542cec89, 0x3db3665b), TOBN(0x931bc4b0, 0xfd720bde),
+     TOBN(0x3e6e9381, 0x8d5c039f), TOBN(0x80949422, 0x8a8d2cc9),
+     TOBN(0xf2d7c8b4, 0xb843ec06), TOBN(0x0055d882, 0xaf8a23f1),
+     TOBN(0xe848010e, 0xd3792335), TOBN(0x9b41a55f, 0x55e08e74),
+     TOBN(0x956ea8e9, 0x5de83059), TOBN(0xf159a997, 0x3263678e),
+     TOBN(0x5f7b9271, 0xcca1b548), TOBN(0xd41d2281, 0xf1d0b7f1),
+     TOBN(0xb187047b, 0x5c9963fb), TOBN(0x213ff6af, 0x02536cd8)},
+    {TOBN(0xe51a9570, 0x0d0fa76c), TOBN(0x67c7890e, 0x4d2e9c8e),
+     TOBN(0xc6160fa2, 0xf974d2cb), TOBN(0xe00474f7, 0x4c6a78de),
+     TOBN(0xee916e51, 0x0ac89d11), TOBN(0x1adad97a, 0xf826f133),
+     TOBN(0x3fc65d3f, 0x8d2d77f3), TOBN(0xda942075, 0x0ba6c300),
+     TOBN(0x5237a82e, 0x0b9196b1), TOBN(0x4975e680, 0xa572b6f5),
+     TOBN(0x41ea8b92, 0xb9bed2bc), TOBN(0xbe0ad710, 0x9826825e),
+     TOBN(0x8a390dca, 0x9fcaba39), TOBN(0x3879f0b4, 0x278d22b3),
+     TOBN(0x77bbea69, 0xbc5e82f1), TOBN(0x71f02e2d, 0x4628d6f1),
+     TOBN(0x6260790c, 0xf968e240), TOBN(0x1c7f3df5, 0x665270ee),
+     TOBN(0x33639545, 0x1a87b1c8), TOBN(0x2011fd21, 0x4ffd9fb8),
+     TOBN(0x69060f86, 0x7807ed55), TOBN(0x1b0ac011, 0x9dfa452c),
+     TOBN(0xbbdb25fe, 0x06d27c0d), TOBN(0x5c25d23a, 0xa60ef90c),
+     TOBN(0xd3eb69e4, 0x734b2e9c), TOBN(0x1c2754e2, 0xc35ff1b3),
+     TOBN(0xa26681e6, 0x9f3e8c51), TOBN(0x7892ad11, 0xa2cae737),
+     TOBN(0x88b1da43, 0xcbd8bda6), TOBN(0x8a576942, 0x419d21c4),
+     TOBN(0x7c124343, 0xc90f4545), TOBN(0xa5a8d93b, 0x26453bae),
+     TOBN(0x9a4c08fd, 0x76ae72e8), TOBN(0xa08b82d9, 0x7b064e94),
+     TOBN(0x4f803ba0, 0x83725330), TOBN(0x33672455, 0x865235f3),
+     TOBN(0x1877dfd0, 0xc8110f1f), TOBN(0xea88f59d, 0x18db27c2),
+     TOBN(0x9d089536, 0xc78e295e), TOBN(0xcbb5d553, 0x74a04cc5),
+     TOBN(0xe3666006, 0x827f75ed), TOBN(0x8557b81a, 0x61e7378c),
+     TOBN(0x74170170, 0xed223f48), TOBN(0x84197a6e, 0xd86ee829),
+     TOBN(0xd75a30f8, 0xac1c4a0f), TOBN(0xd7e7be0d, 0x3cd92824),
+     TOBN(0x5ea0abdb, 0x1b5e86d4), TOBN(0x41146ae1, 0xb3b615ef),
+     TOBN(0x570deceb, 0x1ae5e9da), TOBN(0x5c079c70, 0xb73ead01),
+     TOBN(0x522a30a6, 0xd2ce6639), TOBN(0x71dc5c3f, 0xf4056ac9),
+     TOBN(0xd93c7a2d, 0xbaac149f), TOBN(0x5c3298b8, 0xf1844ceb),
+     TOBN(0x282adf40, 0x8c23c0dc), TOBN(0xbe498189, 0x9b646f86),
+     TOBN(0xe77c1950, 0x628da9e5), TOBN(0x38cc27ba, 0xa1fd5a18),
+     TOBN(0xb5579728, 0xaacdca52), TOBN(0x8d34fdb4, 0xc8e1ecbd),
+     TOBN(0x323f2102, 0xadea7d6a), TOBN(0x035b354e, 0xb694b253),
+     TOBN(0x66dc4e4a, 0x5b8a36c2), TOBN(0xb6092224, 0x71795ca4),
+     TOBN(0xd8c6d7ee, 0xd300d80f), TOBN(0xf31f258d, 0xb3b94954),
+     TOBN(0x0f2eb679, 0x277ced5b), TOBN(0x0b16efa3, 0xeba40e3f),
+     TOBN(0x40003507, 0x0dca4f36), TOBN(0xd34c91cb, 0x59a9a3a1),
+     TOBN(0x5e8fea32, 0x86da6408), TOBN(0xf237959f, 0x03f31728),
+     TOBN(0x1b5bc630, 0xbbaaedc6), TOBN(0xe7d25088, 0xb49cbb3b),
+     TOBN(0x5622cbf7, 0x0deb8cf0), TOBN(0x3b20803c, 0xd309c3ba),
+     TOBN(0x64c2e7de, 0xff45e2fc), TOBN(0xfa730ffb, 0x9aab84a5),
+     TOBN(0xba83cc51, 0x4edfb52e), TOBN(0xe05c0140, 0x748bbd69),
+     TOBN(0x27bbb5f5, 0x2254ec43), TOBN(0xca740989, 0x324c8c40),
+     TOBN(0xa21488b1, 0xd26491b4), TOBN(0xe2753a1f, 0x69d8626b),
+     TOBN(0x618ca06b, 0x8956146c), TOBN(0xd51f1e6f, 0x552cdecf),
+     TOBN(0x981372cc, 0xa3b6ce7d), TOBN(0xb44a68ee, 0x5f14bb57),
+     TOBN(0xfc1167e9, 0x6373abbb), TOBN(0x3d621f8b, 0x767d4c0a),
+     TOBN(0xc6dcdfeb, 0xf6ecc778), TOBN(0xddda9262, 0x82d1fbdd),
+     TOBN(0x477501aa, 0xbfcbf2f7), TOBN(0x0be7228a, 0x67aa8277),
+     TOBN(0x5de7b833, 0x1daab9cd), TOBN(0xb88a4f9a, 0x262feb4a),
+     TOBN(0x28f18586, 0x936fb33f), TOBN(0x9809b2ab, 0x381bf7bb),
+     TOBN(0xf6e16931, 0xeac3c252), TOBN(0x366d1833, 0x5e151187),
+     TOBN(0xe5b4c235, 0x7a3b6460), TOBN(0x693a9fa5, 0x0a68bc91),
+     TOBN(0xa35f104a, 0x6a7f8b6e), TOBN(0x3e5d6981, 0x688676c4),
+     TOBN(0xc0c081b1, 0x0651a609), TOBN(0x6df5da2d, 0xd77057c9),
+     TOBN(0x8bb271bb, 0xc4602847), TOBN(0x322547b3, 0xc4bd07d8),
+     TOBN(0x8c283529, 0x233d39e4), TOBN(0x96300796, 0xc6092096),
+     TOBN(0x2c549de5, 0x5dde766c), TOBN(0x27e0b444, 0xb4151002),
+     TOBN(0x802e5fc3, 0xf2f88f1b), TOBN(0x2af579c2, 0x8ba1956d),
+     TOBN(0x52edd04e, 0xd68196c7), TOBN(0x2e22e714, 0x74a202b0),
+     TOBN(0x33894824, 0x8bf66459), TOBN(0x8f0d8c25, 0x9e39df55),
+     TOBN(0xee4f109e, 0x6c5276d9), TOBN(0xc0c893f0, 0xc5dc0bf0),
+     TOBN(0x06054c76, 0xf8482849), TOBN(0xc24b4a6a, 0x5fcca65d),
+     TOBN(0x71c27e01, 0xa17ebda3), TOBN(0x1ffce028, 0x1be9dfb8),
+     TOBN(0x3784c950, 0xebc43854), TOBN(0xcf0ecc2d, 0xd5086510),
+     TOBN(0x86d0fc3c, 0xbe24d8eb), TOBN(0x5bad0191, 0x1f21788e),
+     TOBN(0xe2c3bcb9, 0xc49b3a12), TOBN(0x66f82433, 0xf7d5992d),
+     TOBN(0xf7cc5eb9, 0x13969246), TOBN(0xe52defd4, 0x8660a6da),
+     TOBN(0x7a9623b6, 0x53fd1a04), TOBN(0x13bd35bf, 0x3a3b8500),
+     TOBN(0xf8a5dec9, 0xe0f8e530), TOBN(0x88bcbe29, 0x1d65dcd4),
+     TOBN(0x09fe3803, 0x6739541c), TOBN(0xebd04b7f, 0xe716a97a),
+     TOBN(0xbd8e34df, 0x1e5ef7cb), TOBN(0xddfc4243, 0xd7c4fd6c),
+     TOBN(0x0183d905, 0x3519411f), TOBN(0x63450996, 0xf7a3c483),
+     TOBN(0x18283cea, 0x01355739), TOBN(0x8c1d72cf, 0x9aaa72f7),
+     TOBN(0x551e1b4e, 0x8dc72468), TOBN(0x8a926cb2, 0xa7b2f1ac),
+     TOBN(0xb873e83b, 0x0fd12fad), TOBN(0xb6cde14f, 0xa4e7fb13),
+     TOBN(0x81ae4141, 0x5befc256), TOBN(0xffb0c636, 0xb4c7631c),
+     TOBN(0x80f1408f, 0x8a2478fe), TOBN(0xde6d051d, 0x44fa7605),
+     TOBN(0x5a15b1f8, 0x4d44a1e4), TOBN(0x1a0031c5, 0xa0daafe3),
+     TOBN(0x304338dd, 0x597652a7), TOBN(0x6830dcc7, 0xf257f17a),
+     TOBN(0x4a67ec76, 0x193aabbc), TOBN(0x3da6dec6, 0xd74761f9),
+     TOBN(0x751720c9, 0x0b35bb70), TOBN(0xe5e04905, 0x8d9e0f8b),
+     TOBN(0x3cd37c84, 0x0858f29c), TOBN(0x7ff1abfb, 0xb881733e),
+     TOBN(0xa0c2698b, 0x0c4f7694), TOBN(0xc7364192, 0x96b95e4e),
+     TOBN(0xcfa55c55, 0x37ece651), TOBN(0xa2bbd6ae, 0x7cb1e9e1),
+     TOBN(0xcd2292b9, 0xa0eb0e8a), TOBN(0x8aba99e1, 0x8d5030d0),
+     TOBN(0xb7c74c58, 0xdc4a1d3e), TOBN(0xe3ec3016, 0x0331ea39),
+     TOBN(0x83afb271, 0x023c8712), TOBN(0xc2670d56, 0xc9c82680),
+     TOBN(0xd426f350, 0xfeca1061), TOBN(0xe8aee692, 0xba6edc01),
+     TOBN(0xc916fbe5, 0x46e801d9), TOBN(0xcb001c37, 0x7097286e),
+     TOBN(0xfcf79d26, 0x78ee1328), TOBN(0xb05b0634, 0xb6a4afb3),
+     TOBN(0x2ab327bb, 0x306da14f), TOBN(0xc11a0294, 0xba5ff534),
+     TOBN(0x7b7da028, 0xe19763dd), TOBN(0x662f54df, 0x8b98ff78),
+     TOBN(0xc056d83c, 0x51f3dbd9), TOBN(0xe2f4d46f, 0xa91d085a),
+     TOBN(0x31759c9c, 0xeb35262d), TOBN(0x624d0cf2, 0x0c9dd29e),
+     TOBN(0x108cf9bb, 0x1624b02d), TOBN(0xa241444e, 0x345531d6),
+     TOBN(0xf69816b2, 0x73d372b2), TOBN(0x126575a7, 0xd5415e53),
+     TOBN(0x546bb4c1, 0x306b8b0e), TOBN(0x82bb0c12, 0x4d54ea5e)},
+    {TOBN(0xdaa7fcc9, 0xf9474bb7), TOBN(0x3c82e74b, 0xafa5db2a),
+     TOBN(0xfbf918c5, 0x9894edce), TOBN(0x470c45ed, 0xa9ac29a7),
+     TOBN(0xdfd44f6f, 0xbc372f2c), TOBN(0x73a4790a, 0xa1e38d3f),
+     TOBN(0x23d2400b, 0xa9674837), TOBN(0x3dad71bc, 0x136a92da),
+     TOBN(0xc76a4881, 0x48baa4ab), TOBN(0x73227e4e, 0xbc26e6b0),
+     TOBN(0xe732edcf, 0xe8ef5662), TOBN(0xfe96aa5f, 0x0c5662bb),
+     TOBN(0x87c7dd7d, 0x139b3239), TOBN(0x8b57824e, 0x4d833bae),
+     TOBN(0xbcbc4878, 0x9fff0015), TOBN(0x8ffcef8b, 0x909eaf1a),
+     TOBN(0x9905f4ee, 0xf1443a78), TOBN(0x020dd4a2, 0xe15cbfed),
+     TOBN(0xca2969ec, 0xa306d695), TOBN(0xdf940cad, 0xb93caf60),
+     TOBN(0x67f7fab7, 0x87ea6e39), TOBN(0x0d0ee10f, 0xf98c4fe5),
+     TOBN(0xc646879a, 0xc19cb91e), TOBN(0x4b4ea50c, 0x7d1d7ab4),
+     TOBN(0x7e047d9c, 0xe2fdc88b), TOBN(0x4f6166d9, 0x715be007),
+     TOBN(0xd9661068, 0xd0debb0a), TOBN(0x82f02fd3, 0xc3dafce2),
+     TOBN(0x41a6b644, 0x00f8df79), TOBN(0xccd5a798, 0x6cedd3a8),
+     TOBN(0xb6617354, 0xf11431b2), TOBN(0x116d0274, 0x8a677e83),
+     TOBN(0x2f399390, 0x89ef485a), TOBN(0x3ee06862, 0x5e2270d2),
+     TOBN(0x8c9a70de, 0x06d6c72f), TOBN(0xd7e69177, 0x4e4497e3),
+     TOBN(0xcfbcbc4a, 0x7db62b5a), TOBN(0x2919bf51, 0x4ab45dde),
+     TOBN(0x735de056, 0x22322f91), TOBN(0xd2590bda, 0x7662ae23),
+     TOBN(0x63d468fe, 0xd82be7a6), TOBN(0xc84d0435, 0x695ea172),
+     TOBN(0xc50f4941, 0x20a6fccd), TOBN(0x2d613990, 0x620f44f1),
+     TOBN(0x680ccd04, 0x1fd25778), TOBN(0x25ddac44, 0x4a3d0808),
+     TOBN(0x41d8b738, 0xc4684cba), TOBN(0x2611645f, 0x53963888),
+     TOBN(0xffe6bb22, 0xe9f43747), TOBN(0xf387957b, 0x22f6cd09),
+     TOBN(0x3eb09302, 0x607a4892), TOBN(0x52c733a8, 0xf3d2f552),
+     TOBN(0xcc935b2e, 0x741bd215), TOBN(0x5fff37e3, 0x1ae0b28e),
+     TOBN(0x4234e33c, 0xc2e9bc20), TOBN(0x4ee1488e, 0x39ea2555),
+     TOBN(0xb8821daf, 0x17156a8a), TOBN(0xc7b45844, 0x1af16ade),
+     TOBN(0xc1009ec7, 0x5b4fa74d), TOBN(0xe0262e65, 0x5d7cf8bd),
+     TOBN(0xb05cb834, 0xb0279be5), TOBN(0x2de7d0eb, 0xf08c5f93),
+     TOBN(0xf023b5aa, 0xefa9e4f0), TOBN(0xb8061e5d, 0x9bd075ec),
+     TOBN(0x7d2ba50f, 0x1aa41bfb), TOBN(0x8963f3e3, 0x90865d96),
+     TOBN(0x7f221a79, 0x4713ec7a), TOBN(0xc83bc517, 0x8500b4c3),
+     TOBN(0x085feb6a, 0xf6ab1540), TOBN(0xfd141024, 0xdc87cd93),
+     TOBN(0x3e196fdb, 0x3239dbf6), TOBN(0xb7cf3e16, 0xdbcd5364),
+     TOBN(0x72544edb, 0x41a64252), TOBN(0x5f3d376f, 0xa6fe493d),
+     TOBN(0x17ae424f, 0xd635df1e), TOBN(0x69cb55a0, 0xdf598c63),
+     TOBN(0x31297f4a, 0x6ce0f1d5), TOBN(0x4573bb7d, 0x1bd11b61),
+     TOBN(0x1d8a65c1, 0x45a1e918), TOBN(0x2729ab25, 0xe5dc2e63),
+     TOBN(0xa3dd0df0, 0x3ecc307b), TOBN(0x4856546f, 0x952019dd),
+     TOBN(0xf8d39888, 0xc784e4fe), TOBN(0xdc6732c7, 0x0043b09e),
+     TOBN(0x1466c9f5, 0xe03a2fb4), TOBN(0xb866c006, 0x862a58a2),
+     TOBN(0x291e8c75, 0xb5865550), TOBN(0x1ddb7154, 0xe65862cc),
+     TOBN(0x285153bc, 0x2b997167), TOBN(0xe2fce0e7, 0x954b6c19),
+     TOBN(0x985d4506, 0x16dc2937), TOBN(0xf7f14216, 0xee41d9c3),
+     TOBN(0x39e098da, 0xfa5fe5e5), TOBN(0x3fc26046, 0xf90f231d),
+     TOBN(0xde5d5ced, 0x32afd0b5), TOBN(0xad688b1d, 0x60c09c18),
+     TOBN(0xefd9aed0, 0x8f84e987), TOBN(0x5ee0c707, 0xae8c8308),
+     TOBN(0x4c8a7653, 0x2aafc403), TOBN(0xfafb60ce, 0xa232436a),
+     TOBN(0xc641294d, 0x9934f053), TOBN(0xc673e5b2, 0x30310529),
+     TOBN(0x3c8fa99a, 0x9066469d), TOBN(0x5626038b, 0x7c09af37),
+     TOBN(0x6ffd8f9b, 0xabd66748), TOBN(0x21ced048, 0xcea58a67),
+     TOBN(0x31071213, 0x1496d048), TOBN(0xfa575242, 0xa9c28d0d),
+     TOBN(0x3720b172, 0x0f806b59), TOBN(0x1f696d47, 0xf224597b),
+     TOBN(0x03c46e31, 0x5b54eefc), TOBN(0x387e4664, 0x72b0edaa),
+     TOBN(0xfc59b03d, 0xee77476e), TOBN(0x86854e54, 0x607a7259),
+     TOBN(0x1478bcee, 0x3e9320dc), TOBN(0x4aa825a8, 0x8c9d87e4),
+     TOBN(0x71272f72, 0xcf272ee0), TOBN(0x19e3a4a3, 0x8bd885cd),
+     TOBN(0x9af6415b, 0x376ba31c), TOBN(0x6394b5a7, 0x807b2b36),
+     TOBN(0x1bf6c56b, 0x77460193), TOBN(0xd6f7fabf, 0x5666ae6d),
+     TOBN(0xdf677909, 0xe3e839d1), TOBN(0x9124d341, 0x08cb9984),
+     TOBN(0xbb6b591d, 0x86a0c7c3), TOBN(0x4bf33423, 0x8f527a6a),
+     TOBN(0x7d137790, 0x26941bfe), TOBN(0x15a0b541, 0xcf6e4481),
+     TOBN(0xdf833b87, 0x124d5b9b), TOBN(0x85827dc5, 0xa7fdf95d),
+     TOBN(0xf05a2c45, 0x49e520af), TOBN(0xfb506d53, 0x91e0645a),
+     TOBN(0xdbfcfa75, 0xe572e06d), TOBN(0xafa019d0, 0x8b7d5653),
+     TOBN(0xcc6c851d, 0x67a19b60), TOBN(0xace88bf4, 0x31ae1a67),
+     TOBN(0x74554a61, 0x93d1e135), TOBN(0x51ba2cdd, 0x4211890a),
+     TOBN(0x7cb32689, 0x9e8d1f02), TOBN(0x29a6b825, 0x8b66ab99),
+     TOBN(0x0a672c21, 0x766e72f3), TOBN(0x24bb718a, 0x880642e3),
+     TOBN(0x425dc41d, 0x184d2b36), TOBN(0x96a1468e, 0x891024ab),
+     TOBN(0xeff22b64, 0x665fe173), TOBN(0x38efdef6, 0xef2eabea),
+     TOBN(0x8a1f3791, 0x21a309df), TOBN(0xa9cf02cf, 0x2431e2ed),
+     TOBN(0xf38507dc, 0x1d939394), TOBN(0xf116b085, 0x82fc3178),
+     TOBN(0x4c5460dc, 0xc7571366), TOBN(0x99efd9dd, 0x978495fd),
+     TOBN(0x5159dd41, 0xf26e347d), TOBN(0x692962ce, 0xe97ee9f1),
+     TOBN(0x1e2f3af2, 0x6a288815), TOBN(0x03512344, 0xa71ade78),
+     TOBN(0x3180789c, 0x26df7050), TOBN(0xe375a43e, 0x96cdfd31),
+     TOBN(0x7951b895, 0xe99e922d), TOBN(0x987ea250, 0x3d0bbe80),
+     TOBN(0x6d2f49f0, 0xe2fe79c0), TOBN(0xc9c2c636, 0xc2b18d2a),
+     TOBN(0x707798f3, 0xd8c8620c), TOBN(0xc2d603da, 0xd5c6a0ee),
+     TOBN(0x46cf1e32, 0xbc447940), TOBN(0x4dfc1459, 0x38a845f3),
+     TOBN(0x210083fe, 0x455e5d92), TOBN(0x6be989ea, 0xa1fedc3f),
+     TOBN(0x55d4fdc3, 0x9f019162), TOBN(0xa8222d08, 0xf1ec4585),
+     TOBN(0xd987e3eb, 0x3a0ae4f9), TOBN(0x07deda59, 0xa9c7a693),
+     TOBN(0xc06567d9, 0xf04ee53f), TOBN(0x93945788, 0x71364c4d),
+     TOBN(0xbb2a2422, 0xbaa5bc16), TOBN(0x89574a5d, 0xbfa3931a),
+     TOBN(0xf09b331e, 0xf300f081), TOBN(0x644de9b7, 0x1a0ff82b),
+     TOBN(0xae023ce4, 0xa5ecdf9b), TOBN(0x5b67cf8b, 0xc1907aac),
+     TOBN(0x72fc8198, 0xdacc038c), TOBN(0x5fdae1d9, 0xf1077bbd),
+     TOBN(0x369198bb, 0xd99e3036), TOBN(0x6b68390a, 0x0efddfca),
+     TOBN(0x8c35f3e4, 0xf0914741), TOBN(0xd2bc54ec, 0xca7d7807),
+     TOBN(0x564d991e, 0x3a8695d1), TOBN(0x5e1e14c8, 0x1b0d937d),
+     TOBN(0x51f30dab, 0x5d635893), TOBN(0x0427e346, 0xf944e49a),
+     TOBN(0x1e0bf1b5, 0x6a233bc0), TOBN(0x75b0ee6c, 0x617bf93e)},
+    {TOBN(0xd23658c8, 0xd2e15a8c), TOBN(0x23f93df7, 0x16ba28ca),
+     TOBN(0x6dab10ec, 0x082210f1), TOBN(0xfb1add91, 0xbfc36490),
+     TOBN(0xeda8b02f, 0x9a4f2d14), TOBN(0x9060318c, 0x56560443),
+     TOBN(0x6c01479e, 0x64711ab2), TOBN(0x41446fc7, 0xe337eb85),
+     TOBN(0x4dcf3c1d, 0x71888397), TOBN(0x87a9c04e, 0x13c34fd2),
+     TOBN(0xfe0e08ec, 0x510c15ac), TOBN(0xfc0d0413, 0xc0f495d2),
+     TOBN(0xb097b2c5, 0xc4e81268), TOBN(0x7ef17552, 0x1d50ca8c),
+     TOBN(0x638266e9, 0x42099644), TOBN(0x43d059de, 0xff729073),
+     TOBN(0xeebb5fe1, 0x148c3940), TOBN(0xb82e73d1, 0xdaa8e925),
+     TOBN(0xf43c78d8, 0x254380fd), TOBN(0x2beabc58, 0xfce37fa0),
+     TOBN(0xcdd5a7d6, 0x6b636357), TOBN(0x8b70a2eb, 0xe096a954),
+     TOBN(0x011d5419, 0xd0afa2fc), TOBN(0x3e49eb67, 0x04fb095a),
+     TOBN(0xeb05c516, 0x156636c2), TOBN(0x2f613aba, 0x090e93fc),
+     TOBN(0xcfd573cd, 0x489576f5), TOBN(0xe6535380, 0x535a8d57),
+     TOBN(0x13947314, 0x671436c4), TOBN(0x1172fb0c, 0x5f0a122d),
+     TOBN(0xaecc7ec1, 0xc12f58f6), TOBN(0xfe42f957, 0x8e41afd2),
+     TOBN(0xdf96f652, 0x3d4221aa), TOBN(0xfef5649f, 0x2851996b),
+     TOBN(0x46fb9f26, 0xd5cfb67e), TOBN(0xb047bfc7, 0xef5c4052),
+     TOBN(0x88e7ac8e, 0x168d5e60), TOBN(0x53abd569, 0x6188a98f),
+     TOBN(0x3b96d529, 0x18be419a), TOBN(0x7e75e354, 0xc057621c),
+     TOBN(0xcb1b709f, 0x5ce57e59), TOBN(0xe78befa2, 0x844f2463),
+     TOBN(0x53608199, 0x3276d4a0), TOBN(0x92636ade, 0x157f2024),
+     TOBN(0x6dd0d348, 0xe0411414), TOBN(0x5b28e950, 0x4d73eeae),
+     TOBN(0x08439232, 0x690ed85e), TOBN(0xdde1a349, 0x6da14b58),
+     TOBN(0x5cbdc442, 0xf4484374), TOBN(0x6b156957, 0xf92452ef),
+     TOBN(0x58a26886, 0xc118d02a), TOBN(0x87ff74e6, 0x75aaf276),
+     TOBN(0xb133be95, 0xf65f6ec1), TOBN(0xa89b6284, 0x4b1b8d32),
+     TOBN(0xdd8a8ef3, 0x09c81004), TOBN(0x7f8225db, 0x0cf21991),
+     TOBN(0xd525a6db, 0x26623faf), TOBN(0xf2368d40, 0xbae15453),
+     TOBN(0x55d6a84d, 0x84f89fc9), TOBN(0xaf38358a, 0x86021a3e),
+     TOBN(0x10520b27, 0x33c12f53), TOBN(0x97d4ef43, 0x9286a1f5),
+     TOBN(0x12468ef8, 0x8948f78b), TOBN(0x40a9d275, 0x50ad452e),
+     TOBN(0x5e382347, 0xc1c48470), TOBN(0x5cd739fd, 0x33e73ace),
+     TOBN(0x7d83d02f, 0x1041f8f3), TOBN(0x32642eb0, 0xe314ad92),
+     TOBN(0x6716d448, 0x885679e6), TOBN(0x0e12bdd5, 0xfc95919c),
+     TOBN(0x7da44204, 0x92c2194a), TOBN(0x78956db1, 0x15ffcd2d),
+     TOBN(0xbd048bdc, 0xff52e280), TOBN(0x8a51d0b2, 0x526a1795),
+     TOBN(0x40aaa758, 0xa985ac0f), TOBN(0x6039bcdc, 0xf2c7ace9),
+     TOBN(0x712092cc, 0x6aec347d), TOBN(0x7976d090, 0x6b5acab7),
+     TOBN(0x1ebcf80d, 0x6eed9617), TOBN(0xb3a63149, 0xb0f404a4),
+     TOBN(0x3fdd3d1a, 0xd0b610ef), TOBN(0xdd3f6f94, 0x98c28ac7),
+     TOBN(0x650b7794, 0x3a59750f), TOBN(0xec59bab1, 0x2d3991ac),
+     TOBN(0x6cbd2757, 0x39ed9ec9), TOBN(0x5db68a68, 0xfe5d4aa8),
+     TOBN(0x177eaa0b, 0xe4c58c7b), TOBN(0x603551ef, 0x0e488784),
+     TOBN(0xc8eba131, 0xdf916b0f), TOBN(0xd0dbceda, 0x159732e2),
+     TOBN(0x55acca84, 0xb0834afa), TOBN(0xdbe98440, 0xb59ffbf5),
+     TOBN(0x162a2c70, 0x3bd3b202), TOBN(0x4c5e5d25, 0x6ddd8eba),
+     TOBN(0x66e7844a, 0x77b1d93d), TOBN(0x1292bc0e, 0x110b9dcf),
+     TOBN(0x01f40e88, 0x2e552766), TOBN(0x1fe3d509, 0x66f5354f),
+     TOBN(0x0e46d006, 0xb3a8ea7f), TOBN(0xf75ab629, 0xf831cd6a),
+     TOBN(0xdad808d7, 0x91465119), TOBN(0x442405af, 0x17ef9b10),
+     TOBN(0xd5fe0a96, 0x672bdfcb), TOBN(0xa9dfa422, 0x355dbdec),
+     TOBN(0xfdb79aa1, 0x79b25636), TOBN(0xe7f26ffd, 0xeece8aec),
+     TOBN(0xb5925550, 0x7edd5aa2), TOBN(0x2c8f6ff0, 0x8eb3a6c2),
+     TOBN(0x34a4632c, 0x9341a2e0), TOBN(0x05ca421b, 0xc525bc5a),
+     TOBN(0x441cf2eb, 0x4ae3284a), TOBN(0x1a57684e, 0x146012ab),
+     TOBN(0x23a52ee3, 0x30acfd0e), TOBN(0xc3f4d94a, 0x7d29e389),
+     TOBN(0xfbd4d48e, 0xb4154640), TOBN(0x2352e791, 0xaf9ec396),
+     TOBN(0x45813e8e, 0x7327caee), TOBN(0x977f7a08, 0xd9db7e81),
+     TOBN(0xbe55b630, 0x5f53d15d), TOBN(0xee182ac6, 0x6a23f0dc),
+     TOBN(0x88887756, 0x757d6136), TOBN(0xad9ac183, 0x88b92e72),
+     TOBN(0x92cb2fc4, 0x8785d3eb), TOBN(0xd1a542fe, 0x9319764b),
+     TOBN(0xaf4cc78f, 0x626a62f8), TOBN(0x7f3f5fc9, 0x26bffaae),
+     TOBN(0x0a203d43, 0x40ae2231), TOBN(0xa8bfd9e0, 0x387898e8),
+     TOBN(0x1a0c379c, 0x474b7ddd), TOBN(0x03855e0a, 0x34fd49ea),
+     TOBN(0x02b26223, 0xb3ef4ae1), TOBN(0x804bd8cf, 0xe399e0a3),
+     TOBN(0x22723fa3, 0x7cdc2211), TOBN(0x1d339232, 0x31ddb2bd),
+     TOBN(0x63f354c1, 0x46626fe6), TOBN(0xd0f68526, 0xf67a4257),
+     TOBN(0x79aa889b, 0x8d3d00b6), TOBN(0xca5fc8a7, 0x0de4c413),
+     TOBN(0xe311a966, 0xd2879266), TOBN(0xc8d982fe, 0x5f21e1dd),
+     TOBN(0xc51f1604, 0xcbb159ff), TOBN(0xb449deb8, 0x092d83ce),
+     TOBN(0x4a5f68f8, 0x644fd0be), TOBN(0xeef3fa4d, 0xbffb0088),
+     TOBN(0x11a9f3d0, 0xde865713), TOBN(0x81e36b6b, 0xbde98821),
+     TOBN(0x324996c8, 0x6aa891d0), TOBN(0x7b95bdc1, 0x395682b5),
+     TOBN(0x47bf2219, 0xc1600563), TOBN(0x7a473f50, 0x643e38b4),
+     TOBN(0x0911f50a, 0xf5738288), TOBN(0xdf947a70, 0x6f9c415b),
+     TOBN(0xbdb994f2, 0x67a067f6), TOBN(0x3f4bec1b, 0x88be96cd),
+     TOBN(0x9820e931, 0xe56dd6d9), TOBN(0xb138f14f, 0x0a80f419),
+     TOBN(0x2b4056a4, 0x3b32932e), TOBN(0x1c74deb6, 0xbd8a1cb8),
+     TOBN(0x09601843, 0xb181b5a0), TOBN(0x50a92353, 0xdc6a92d8),
+     TOBN(0xe86c022c, 0x2d6f4331), TOBN(0x0d9671dc, 0x3a3ae821),
+     TOBN(0x3d618a20, 0xc8228d82), TOBN(0x20e809c1, 0xa5292169),
+     TOBN(0x3b2fe5e7, 0x3803f840), TOBN(0x1f2978e9, 0x416eb670),
+     TOBN(0x44dcc410, 0xc35b795c), TOBN(0xbf5065c0, 0x503ce975),
+     TOBN(0xa11a1a8f, 0x0429077a), TOBN(0x2bb1e33d, 0x10351c68),
+     TOBN(0x3c25abfe, 0x89459a27), TOBN(0x2d0091b8, 0x6b8ac774),
+     TOBN(0xdafc7853, 0x3b2415d9), TOBN(0xde713cf1, 0x9201680d),
+     TOBN(0x8e5f445d, 0x68889d57), TOBN(0x608b209c, 0x60eabf5b),
+     TOBN(0x10ec0acc, 0xf9cfa408), TOBN(0xd5256b9d, 0x4d1ee754),
+     TOBN(0xff866bab, 0x0aa6c18d), TOBN(0x9d196db8, 0xacb90a45),
+     TOBN(0x1b66faab, 0xf9e89bea), TOBN(0xc81c5ddc, 0x3a441284),
+     TOBN(0x1a82f3a0, 0xa675f7c8), TOBN(0x82884a2f, 0x30313a71),
+     TOBN(0x7ac5d7b0, 0x58aea9e6), TOBN(0x1954f075, 0xcd5ff05d),
+     TOBN(0x7c29638d, 0x6178d270), TOBN(0x6af7f8ba, 0x19381929),
+     TOBN(0xe85e3c47, 0xa17ae3a7), TOBN(0x91b107c7, 0x7009e38a),
+     TOBN(0xf3b777d8, 0xf1f9c52e), TOBN(0x5b7b74ff, 0x11b688a0)},
+    {TOBN(0x4ae3d232, 0xc0385874), TOBN(0x83bda9e6, 0xcbf96d2a),
+     TOBN(0xba73c769, 0xec62fd6a), TOBN(0xd586ba7f, 0x62a4720c),
+     TOBN(0x6497cd14, 0x0cc1f491), TOBN(0x8b012b70, 0x7b2ac571),
+     TOBN(0xa65eabb6, 0x268fd705), TOBN(0x8caf100a, 0x1431873d),
+     TOBN(0x25b31b84, 0x231457d7), TOBN(0xcab62f75, 0x901645c5),
+     TOBN(0x2377d74d, 0xb2f7b656), TOBN(0x4008277c, 0x2d33c95c),
+     TOBN(0xaae2f448, 0xed001c43), TOBN(0x08ad1d9b, 0xcf4be493),
+     TOBN(0x3262b2f4, 0x82c1f372), TOBN(0x5521febd, 0x351a5f7f),
+     TOBN(0xf8ec9190, 0x916c75a8), TOBN(0xf3c258c7, 0x2728dfb8),
+     TOBN(0x5dd4ff4f, 0x8af19574), TOBN(0xefddf579, 0x5d076b1c),
+     TOBN(0x318b5b98, 0xba8b777a), TOBN(0xd971d426, 0xfb7f8409),
+     TOBN(0xed1465e8, 0xb0fd31db), TOBN(0x80d24d43, 0x00f66347),
+     TOBN(0x5ba5288c, 0x1ae586a2), TOBN(0x044f1fc6, 0x1b715821),
+     TOBN(0xc1a9a997, 0x602f3c65), TOBN(0xc5c7512f, 0xe08c0223),
+     TOBN(0x48a19c3c, 0x367e6f1d), TOBN(0xa9f2195d, 0xfb241597),
+     TOBN(0x9f674a5f, 0xb5ba32a6), TOBN(0x275a060f, 0x0a312742),
+     TOBN(0x5aeb8c43, 0x03d6f13e), TOBN(0x0fed575d, 0x917433fb),
+     TOBN(0xe4a5ef9a, 0x59f53490), TOBN(0xa9f86145, 0xf315e616),
+     TOBN(0x315ad7a4, 0x7e5a59f4), TOBN(0x1c615bfc, 0x543c8b00),
+     TOBN(0xe12f97a8, 0xbaa56473), TOBN(0xf263db44, 0x46edcfcb),
+     TOBN(0x47cf91d5, 0x3c1a968e), TOBN(0x1a1165b4, 0xc15db875),
+     TOBN(0x5d35e53a, 0x3479616a), TOBN(0x649f87b4, 0x5c59958f),
+     TOBN(0x5d3d11ea, 0x246da3d3), TOBN(0xc1ddfcc6, 0x53f06820),
+     TOBN(0x8169d711, 0x6610c00f), TOBN(0x15f16ba5, 0x4bddc8c7),
+     TOBN(0xcf19fb2a, 0x1e548ef0), TOBN(0x8bb6dfa0, 0xcc694171),
+     TOBN(0xeb1668ca, 0x5c5e390f), TOBN(0xf5a3485b, 0xe1975263),
+     TOBN(0x4edfc596, 0x442cc850), TOBN(0x9901f447, 0xf9627d74),
+     TOBN(0x3a6b85c9, 0x84d0413a), TOBN(0x14663661, 0x67de639c),
+     TOBN(0x9fc9fdcf, 0x11705bbb), TOBN(0x6d066e2b, 0xbff2cf80),
+     TOBN(0x38dedc2f, 0xdc3026fd), TOBN(0xad533a98, 0x1b828538),
+     TOBN(0x6c75bc93, 0xb7bfa29e), TOBN(0xf86f22b2, 0x18ef6d69),
+     TOBN(0x90ce6a15, 0x36dcadf2), TOBN(0xf11f711c, 0x7ce50921),
+     TOBN(0x0739ceda, 0x38a479e3), TOBN(0x840b825e, 0x6ec3dbc6),
+     TOBN(0x7c36c0a5, 0x9fa23481), TOBN(0xceb61fd1, 0x70cb186d),
+     TOBN(0xac6f7d3c, 0x26e4754d), TOBN(0x4076d3b5, 0xf317b385),
+     TOBN(0x52f1bd72, 0x3fd9e9c7), TOBN(0x6649d8b6, 0xbf316043),
+     TOBN(0xdc2870f8, 0x243cfbd5), TOBN(0x000b71b3, 0x1ab496f3),
+     TOBN(0x53511a3f, 0x708f4507), TOBN(0xbd7bd038, 0x1949d835),
+     TOBN(0x723a007d, 0x938f4db6), TOBN(0x5bc8679e, 0x2d04e9fd),
+     TOBN(0x51ca5fd1, 0x76ec7fc4), TOBN(0x86c4205c, 0x988f354e),
+     TOBN(0x9042e76b, 0x2a0a4a90), TOBN(0x368f52a8, 0x4ad44d2d),
+     TOBN(0xddc2cab8, 0x912edfb7), TOBN(0xde74ccf5, 0xcde80199),
+     TOBN(0x8002f458, 0x3e455a61), TOBN(0xafbafd37, 0x5bea205a),
+     TOBN(0xa8ced112, 0xfb93f735), TOBN(0x27cb6292, 0x196e3084),
+     TOBN(0x72395bdd, 0x77e8c744), TOBN(0x02e018d8, 0xee71f5ff),
+     TOBN(0x7cfc14d9, 0xc1337a1d), TOBN(0x94e14c0a, 0xd7b4d86e),
+     TOBN(0x66e50129, 0xd213738e), TOBN(0x7a905d91, 0xbc0b5ea3),
+     TOBN(0x92cb630a, 0xfca06700), TOBN(0x65e06d5c, 0xbf3a0821),
+     TOBN(0xa81e4a4e, 0x55c2369d), TOBN(0x394de01b, 0x60a0f544),
+     TOBN(0x22acfd07, 0xa8906e17), TOBN(0xf59b37a6, 0xcc9bc4d0),
+     TOBN(0xdd16a22c, 0x7ffec12f), TOBN(0x07decc2a, 0xd5976455),
+     TOBN(0xc5019463, 0xabe1d122), TOBN(0x2bf0ac0c, 0xe318c92c),
+     TOBN(0xfa50280a, 0xb2bfc47b), TOBN(0x53354fc5, 0xc7cf8bff),
+     TOBN(0xaea1d293, 0xe20ca341), TOBN(0xec25ecda, 0x8b626244),
+     TOBN(0x313b66ca, 0xfd8ba33e), TOBN(0x10bdb130, 0xfabe27dd),
+     TOBN(0x1181334c, 0x125e2b8c), TOBN(0x0f4f198f, 0xdb6f94ba),
+     TOBN(0xf7000076, 0xac3f5de9), TOBN(0x1a78813d, 0x9d6402ae),
+     TOBN(0x3427f75d, 0xc8a9e758), TOBN(0xcdac8b34, 0xb01f791f),
+     TOBN(0x922c36d1, 0x2a9ebaf5), TOBN(0x195ea05f, 0xb0487cc4),
+     TOBN(0xe33de901, 0xa808baec), TOBN(0x15e1d5ac, 0x57291d89),
+     TOBN(0x4e2a05c1, 0xc21cdd1f), TOBN(0x8a232097, 0xdd46e76a),
+     TOBN(0x8b55313c, 0xd871b1d6), TOBN(0x976ce5f6, 0xaf396bc4),
+     TOBN(0xeb91527d, 0xafd381b1), TOBN(0x6cfd4490, 0x14455ee2),
+     TOBN(0x8723be9e, 0x1f274d1e), TOBN(0x1c63fd01, 0x1999fa9f),
+     TOBN(0x5f172625, 0x8049b6f8), TOBN(0xe18a3ecd, 0x99a51b4d),
+     TOBN(0x329fc2c1, 0xb13d4e65), TOBN(0x94da252b, 0x0f18f300),
+     TOBN(0x7b151b98, 0xe28fd10d), TOBN(0x8fc01ce8, 0x1dd884cf),
+     TOBN(0x1f0ffb50, 0x98d56c2c), TOBN(0xf9df1fa2, 0xb084606d),
+     TOBN(0xf86232bf, 0xdc7d2008), TOBN(0xeae5cb8f, 0xd8751699),
+     TOBN(0x70f02298, 0x83ed54fd), TOBN(0xb575283a, 0x86087697),
+     TOBN(0xad219135, 0x0302e2c3), TOBN(0x1c09a0d6, 0xc4b57e01),
+     TOBN(0x0f65e1e1, 0xc541b9fb), TOBN(0x85493d9b, 0xf4fe76c0),
+     TOBN(0x353718ce, 0x191c21cc), TOBN(0x08e6edf6, 0x4ad6bd18),
+     TOBN(0xc2bb0d6e, 0x4dc5b572), TOBN(0x328e19df, 0x88193daa),
+     TOBN(0xccc9f6ab, 0x7211c958), TOBN(0x377d99ef, 0x58aae5c5),
+     TOBN(0x40e2ecc9, 0x1c823442), TOBN(0x036d6d52, 0x8b0d36ab),
+     TOBN(0x2fe0cd7e, 0xda4d0ad3), TOBN(0xb8fc3c7f, 0xfc8af791),
+     TOBN(0xdb7e44a4, 0x2b201b20), TOBN(0xa5176004, 0xebcf527d),
+     TOBN(0xe19b7576, 0xfa5256d2), TOBN(0x418d5425, 0xdb3f8bfd),
+     TOBN(0x00424869, 0x951a1719), TOBN(0x2383c7a8, 0x533b69b0),
+     TOBN(0x166a38e2, 0xe67a86fd), TOBN(0xa6baa01c, 0x5876c435),
+     TOBN(0x574ddc45, 0x84a208f5), TOBN(0x8cee30b8, 0x26b18dbb),
+     TOBN(0xeced99c1, 0xe9f6b30d), TOBN(0xb638d88d, 0xa7d34bea),
+     TOBN(0xa4836806, 0x069adedf), TOBN(0x62beb7ee, 0x7a07c593),
+     TOBN(0x5093950b, 0x724fb94d), TOBN(0x10782271, 0x8117ff50),
+     TOBN(0xdc9e34b5, 0x9f5961d7), TOBN(0xfaa2fc01, 0x2351a33e),
+     TOBN(0xb9e0f1d9, 0xd5fc462e), TOBN(0x276a5b3b, 0xdd9c6914),
+     TOBN(0xe6136d17, 0x75365ca5), TOBN(0x228b77e2, 0xa91eed68),
+     TOBN(0x5cd6a269, 0x411e4770), TOBN(0xd8857b0e, 0x17590390),
+     TOBN(0xe7094f3a, 0xa0d45faf), TOBN(0xe52d11dc, 0xf40693e4),
+     TOBN(0xe96c4aeb, 0xe5f5b545), TOBN(0x10a85a00, 0x2d4c43b0),
+     TOBN(0xf86ad2f6, 0x32f9151d), TOBN(0x05daf874, 0x302b99e2),
+     TOBN(0x4299dbfa, 0x14fd3171), TOBN(0x27cbedd6, 0x812cfc62),
+     TOBN(0x42e61536, 0xb8772164), TOBN(0x52eecef7, 0x6a5423ef),
+     TOBN(0xc34c6c70, 0x548fffa3), TOBN(0x1fbed777, 0x7b6db825),
+     TOBN(0x850bded4, 0x4ef2989e), TOBN(0x3b8a542c, 0x815463ee)},
+    {TOBN(0x9decf217, 0x3079fe2f), TOBN(0xc32ec570, 0x7c817f6d),
+     TOBN(0xd5649ce8, 0xaeb36b92), TOBN(0xab9f77d1, 0x58fb4dc8),
+     TOBN(0x66b11fb6, 0xb52d60cf), TOBN(0xe217941d, 0xeaaa4619),
+     TOBN(0xf3522a9a, 0x1607c412), TOBN(0xea2eba4f, 0xc2a3d8c9),
+     TOBN(0x267997c6, 0x25e38722), TOBN(0xed5047b7, 0x2d4595ee),
+     TOBN(0xaaa41e5f, 0x55e5456c), TOBN(0x891e3d12, 0x78cfc6fe),
+     TOBN(0xa438634e, 0xd7357a51), TOBN(0x918f14cd, 0x18c04d59),
+     TOBN(0x2ab4dedf, 0xac40dd56), TOBN(0x758e95ee, 0x4956a5de),
+     TOBN(0xfc11e394, 0x5113f84d), TOBN(0x6d71b673, 0x6059f16c),
+     TOBN(0xfd8e2236, 0xfb357c3f), TOBN(0xd7c86812, 0x32dca873),
+     TOBN(0x02aeb153, 0x8ea13b44), TOBN(0xde1275d3, 0x013d3827),
+     TOBN(0x470a7b7e, 0x659ca201), TOBN(0x862c83c5, 0x5c77b351),
+     TOBN(0xfc9b800f, 0x05084cfb), TOBN(0x1c4d4510, 0x496f23fc),
+     TOBN(0xfea0003c, 0xc1d08465), TOBN(0xf0281da0, 0x9af48a41),
+     TOBN(0xa5c0d971, 0x44d32eed), TOBN(0x2613b73e, 0x023a2e31),
+     TOBN(0x455013c8, 0x7dc8ac1a), TOBN(0x581b1319, 0x5958b3da),
+     TOBN(0xd293f2f2, 0x2290aaea), TOBN(0xa0682564, 0x96f6223b),
+     TOBN(0x38fd18fa, 0x69410ef6), TOBN(0x74eaf35f, 0x2b2cf629),
+     TOBN(0x281f6e58, 0xc7ff5b50), TOBN(0xbc67791e, 0xcf9cd114),
+     TOBN(0xe29fa41a, 0xfd89abd8), TOBN(0xfcb0b0b0, 0x7984feef),
+     TOBN(0x0b0928a6, 0xd9d20a64), TOBN(0x2fd385c4, 0x6979ccd5),
+     TOBN(0xce9c34c8, 0x1fbe72e4), TOBN(0x69364344, 0xaad0135f),
+     TOBN(0xd4646352, 0x50946a5b), TOBN(0xb09a97c6, 0xf39f53b9),
+     TOBN(0x1d47bc20, 0xdcbc8b64), TOBN(0xcda5c7bd, 0xd458b0d6),
+     TOBN(0xad5b8c28, 0x87eff3b3), TOBN(0xa8a3917d, 0x9937833a),
+     TOBN(0xbafdc493, 0x200c3b49), TOBN(0x9e27aac5, 0x972c6fbf),
+     TOBN(0xfd292bb2, 0x0518c97d), TOBN(0xa62126db, 0x33515a63),
+     TOBN(0x9892a8bb, 0x1bcfc875), TOBN(0x93b066b7, 0xe0b674d1),
+     TOBN(0xcde9b008, 0x7fd3d080), TOBN(0x1e285a88, 0x59401ae8),
+     TOBN(0x4679e329, 0x82cfea96), TOBN(0x52406ea0, 0x23e615d3),
+     TOBN(0x27de6113, 0x8b6e9462), TOBN(0xb8ade1dc, 0x473464bf),
+     TOBN(0x911ad493, 0x94dacc08), TOBN(0xd036f28e, 0x44252cb1),
+     TOBN(0x3865abf6, 0xd13dc20d), TOBN(0xcea487cd, 0xd528f0ba),
+     TOBN(0x14d77eaf, 0x4fc290fe), TOBN(0x5106533b, 0xc5084101),
+     TOBN(0x11001dc7, 0xcda9eccd), TOBN(0xb79ad4bc, 0x49fc4a78),
+     TOBN(0x4f6369f5, 0x4567f8a9), TOBN(0x64050aa2, 0xdf7ab817),
+     TOBN(0xffe057aa, 0xde07f615), TOBN(0xf3f91b55, 0x342700bd),
+     TOBN(0x294761e1, 0x27a839f9), TOBN(0x6411a2b4, 0x80eafe1c),
+     TOBN(0x4900eb12, 0x0737b80a), TOBN(0xa1134d10, 0xbb73264c),
+     TOBN(0x0ebfad73, 0x0ddbf7f1), TOBN(0x57bbe692, 0xcd1f73ec),
+     TOBN(0x675931fc, 0xa20f8944), TOBN(0x1950eeff, 0xfad2ad19),
+     TOBN(0x60d30402, 0x9cdf88a0), TOBN(0x121af89e, 0x33fd2c6e),
+     TOBN(0x763e3664, 0x295c4db2), TOBN(0x632fd676, 0xdbbaa92d),
+     TOBN(0x62ab11a8, 0xc66b40e9), TOBN(0x06244698, 0xf384b708),
+     TOBN(0xe7cdf3bd, 0x69197876), TOBN(0x9cc79c48, 0x064f8837),
+     TOBN(0x95900a22, 0x9486589e), TOBN(0x7953f6e7, 0x2ff01639),
+     TOBN(0x3f65fbbd, 0xdd3e6e46), TOBN(0x84f52e06, 0xbaa2e2a0),
+     TOBN(0x1dc462a8, 0xe3852824), TOBN(0x9be69c3f, 0x7e4c032c),
+     TOBN(0xa40afc36, 0x70977e01), TOBN(0x965f110d, 0xa6c3b289),
+     TOBN(0xc4952f87, 0x805a8491), TOBN(0xb36804b8, 0x0b65e2d3),
+     TOBN(0xd3f6f5ac, 0xe8cf2b2b), TOBN(0x0f37a79d, 0xa4b71938),
+     TOBN(0xb2f810d9, 0x489ef671), TOBN(0x1feae026, 0x2df23cd8),
+     TOBN(0x7412eee3, 0x21a14e4f), TOBN(0x1458b8ad, 0x179d51fa),
+     TOBN(0x2156a90e, 0xe201509c), TOBN(0x39f29fca, 0x72605867),
+     TOBN(0x231f70ad, 0xb2e066e3), TOBN(0xf09db880, 0xbb477a19),
+     TOBN(0xdfa0e503, 0x907e5c63), TOBN(0x12fe09f4, 0xf97022ad),
+     TOBN(0xdbf06f36, 0x20bce7dd), TOBN(0x0140e197, 0xf1371cba),
+     TOBN(0x917b6da4, 0x64b0b4b0), TOBN(0x9a6f4d9b, 0x20fe3320),
+     TOBN(0x0981d60e, 0xd66bdf87), TOBN(0xb430e4e0, 0x62d3487c),
+     TOBN(0xc3440fb9, 0x34dc4a94), TOBN(0xe7972dda, 0x09a5e3c9),
+     TOBN(0x29d63940, 0x93f47052), TOBN(0xadf04e70, 0x847e5937),
+     TOBN(0xa0ef4fee, 0x731bab6f), TOBN(0x21de3195, 0x6ee7d7bd),
+     TOBN(0x99af4a8d, 0xbd716777), TOBN(0x9e15c983, 0xdf4c569e),
+     TOBN(0x2ec7bc0c, 0xe94401ea), TOBN(0xda1835ad, 0x85727722),
+     TOBN(0x2b5862ce, 0x5dad81da), TOBN(0xb2be5081, 0x88dddc2e),
+     TOBN(0xa0248210, 0x1414286b), TOBN(0xc52c436d, 0x8ea33f3f),
+     TOBN(0xcc580ea7, 0x3b24e776), TOBN(0x0f3a8b18, 0x9d721d6e),
+     TOBN(0x8665604f, 0xb23480cf), TOBN(0x95787cba, 0x34414689),
+     TOBN(0x425d7c6f, 0x4d10a945), TOBN(0xb5ec2626, 0xb2f1cc78),
+     TOBN(0x55da8885, 0x8658de6b), TOBN(0xb50919d1, 0xe9aba03e),
+     TOBN(0xc64881d7, 0xd99e417e), TOBN(0x1eeba5aa, 0xbf28fba2),
+     TOBN(0x20feb7b3, 0x504eff80), TOBN(0x9f5f9db6, 0x50debfb7),
+     TOBN(0x4eb94584, 0x230923db), TOBN(0xba861128, 0x7b3a6929),
+     TOBN(0x5aa7faa3, 0xab1d6b31), TOBN(0x95c1e239, 0x16ae0966),
+     TOBN(0x98674fd3, 0xa2fe2297), TOBN(0xa8da0ee5, 0x3c42d488),
+     TOBN(0x103cabac, 0xe0740db0), TOBN(0xf0b860d4, 0x5bf16882),
+     TOBN(0x03cb0cdc, 0x289e48ce), TOBN(0x3c15d375, 0x9e52c7d5),
+     TOBN(0x524f7319, 0x98103ca2), TOBN(0x828ed65c, 0xc609ffeb),
+     TOBN(0x518f231b, 0x83dfb993), TOBN(0x4b0987db, 0x37c0826c),
+     TOBN(0x0c34961c, 0xd5177ead), TOBN(0x9d882d3e, 0x452c92da),
+     TOBN(0xbfeaf558, 0x8765bced), TOBN(0x83957b62, 0xb9962295),
+     TOBN(0x2d1d0175, 0x7bb084cf), TOBN(0x04c4cfcd, 0xe8cffcfc),
+     TOBN(0x2f35e33d, 0x8d4536c1), TOBN(0xbebb31cb, 0xd83124cf),
+     TOBN(0xe342bed2, 0xabb29019), TOBN(0x2af0fcde, 0x2692a0d3),
+     TOBN(0xece5d865, 0xc7e3b29f), TOBN(0xe58106a4, 0x622839dd),
+     TOBN(0xf5272d43, 0xf2969d76), TOBN(0x90c72c1b, 0x2a1a240f),
+     TOBN(0x1e2aa0ac, 0xaf15e14f), TOBN(0xfa2f1c7b, 0xf1b6b5a0),
+     TOBN(0xfb5d343d, 0x880224a5), TOBN(0x47b88a84, 0xf91881c5),
+     TOBN(0x140f5ee9, 0xdd142fe7), TOBN(0x4e76982e, 0x24b37c44),
+     TOBN(0x6aaf61e9, 0x578b482b), TOBN(0x01950e22, 0x765bc4e2),
+     TOBN(0x20ebf79c, 0xe8a2e8f0), TOBN(0xec040d0d, 0xaca418a2),
+     TOBN(0x016c07e7, 0x8d630d2a), TOBN(0x20021d57, 0xfa605dcb),
+     TOBN(0x6190f3e9, 0x42d04705), TOBN(0x4e000df5, 0x8974b7e6),
+     TOBN(0x6710da6c, 0x5abcedac), TOBN(0xf31aa496, 0x5f95d37c),
+     TOBN(0x192c4b8b, 0xa5830899), TOBN(0x171ab8c4, 0xea7dbcdd),
+     TOBN(0x715f6081, 0x8cdf1097), TOBN(0x0e0135bf, 0x205d10ed)},
+    {TOBN(0xd2db4d35, 0xc8d2bf7b), TOBN(0x52105d09, 0x81571d06),
+     TOBN(0x447565cc, 0x723a57bf), TOBN(0xd98c3597, 0xd8ded62c),
+     TOBN(0x0aeac6d9, 0xde2f1a9e), TOBN(0xd363b0b7, 0x0a98d3b2),
+     TOBN(0xd9708f07, 0x02ad9933), TOBN(0x93346775, 0x64f5809d),
+     TOBN(0x499332cf, 0x49cda010), TOBN(0x546df74a, 0x858467e2),
+     TOBN(0x8b84a550, 0x93748e8e), TOBN(0x9e88ef97, 0x06f09073),
+     TOBN(0xc0a40cac, 0x52133095), TOBN(0xfe1b22fd, 0x93c162bb),
+     TOBN(0x8625898c, 0x34018741), TOBN(0x69c9f3f6, 0x36d9e57a),
+     TOBN(0x69d9d7f3, 0x378aa211), TOBN(0x6b03f897, 0xe7dca168),
+     TOBN(0x24d49aeb, 0xf997a48f), TOBN(0x1d984c67, 0xc149ac40),
+     TOBN(0x667c1d01, 0x576f533f), TOBN(0x372eee19, 0x9ef82ece),
+     TOBN(0x577723c0, 0xc207c14d), TOBN(0x4225907a, 0x0eed37f6),
+     TOBN(0xb8623f36, 0xc5a5a001), TOBN(0x21847b80, 0x86878b74),
+     TOBN(0xd19f57f6, 0xd05ac443), TOBN(0x9bd22882, 0xb9f8acec),
+     TOBN(0x128186d8, 0x2b41b60a), TOBN(0x1772e6b0, 0x71980fd1),
+     TOBN(0x22c5ee68, 0x812dfff5), TOBN(0xccbd2fe2, 0x7f952796),
+     TOBN(0x0d49bfde, 0x7da6d35a), TOBN(0x348b48db, 0xc249f319),
+     TOBN(0xdb376657, 0xc16a8c0f), TOBN(0x28ef362a, 0x002cf8b4),
+     TOBN(0xc61db977, 0xbc0e0903), TOBN(0xbaf6e4da, 0x645c32fb),
+     TOBN(0xce89b8ca, 0x060b1adb), TOBN(0x41db4481, 0x88e2c178),
+     TOBN(0xba6339f3, 0x923bdd3c), TOBN(0xff25b818, 0xd29db42c),
+     TOBN(0x3521116e, 0xe6d6b35d), TOBN(0x4e1bd283, 0xb22f16ac),
+     TOBN(0x9357c984, 0xbd79fe5d), TOBN(0x2eda73be, 0x9d45eee4),
+     TOBN(0x1a50c59f, 0x6288e01f), TOBN(0x37baf649, 0x75018873),
+     TOBN(0x431ea808, 0x751f66f6), TOBN(0x06feeefa, 0xf1b8e577),
+     TOBN(0xd109d9f0, 0x488a8eee), TOBN(0xeb826b96, 0xc69843c5),
+     TOBN(0x972272e9, 0x8b42da29), TOBN(0xa9ea9ad1, 0xa137ee9c),
+     TOBN(0x0385aa95, 0x25163be5), TOBN(0x963e9640, 0x34c32f2b),
+     TOBN(0x9067aa89, 0x4dfd935a), TOBN(0x6ab23131, 0xbc3f5f3c),
+     TOBN(0xb96c3406, 0xf302e0e1), TOBN(0xc8caad4e, 0xd65f811a),
+     TOBN(0xf323953b, 0x750261dc), TOBN(0xb8563bf1, 0x38552a8c),
+     TOBN(0x2937dfd9, 0xbd32cb8c), TOBN(0x07c4e563, 0x7ecf3538),
+     TOBN(0xb573960e, 0xb6399415), TOBN(0xc1ced6c1, 0xdd1a4a06),
+     TOBN(0xc625f400, 0x787ddf7a), TOBN(0xd998c28b, 0x1ce6778f),
+     TOBN(0x66c51e5b, 0x6220f24d), TOBN(0x9f97d758, 0x27d01c6f),
+     TOBN(0x60b15724, 0x0412372d), TOBN(0x2253abc1, 0x04d55048),
+     TOBN(0x15952eb8, 0xfad177ed), TOBN(0x57aaf91d, 0x05058d9f),
+     TOBN(0x268ba730, 0x8ab1b9d9), TOBN(0x7decfc47, 0xd5b8f86a),
+     TOBN(0x596353e7, 0x0879ab02), TOBN(0xa3ff2311, 0x9a68d5a4),
+     TOBN(0x257c68a1, 0x7534fb5a), TOBN(0x84f7c9de, 0x160ec5ea),
+     TOBN(0x1b2b770c, 0x6754185f), TOBN(0xf321ac71, 0xa74562f7),
+     TOBN(0x28bf0a15, 0x264a1961), TOBN(0x0093db73, 0x86a033ae),
+     TOBN(0xc552c6c6, 0x097f322f), TOBN(0xdf59a302, 0x8bc06287),
+     TOBN(0xc9ed375c, 0x19610b0c), TOBN(0xf0e7b4eb, 0xb051dad5),
+     TOBN(0x7267a304, 0xc6556643), TOBN(0x0044f6d8, 0xc96dc1d8),
+     TOBN(0xf0ed5f9a, 0xf4fc3725), TOBN(0xbbaf9f2c, 0x9de8e1ff),
+     TOBN(0xef5d66f4, 0xaf5a4b4b), TOBN(0x0b5bed3d, 0x20644cf2),
+     TOBN(0xf7e4543a, 0x75ae23c0), TOBN(0x696f60dc, 0x41325b66),
+     TOBN(0x4fd0b582, 0xcfc0dd38), TOBN(0x47fd984f, 0x55b7b68a),
+     TOBN(0x2722a0cb, 0x699460ec), TOBN(0x81b4afd8, 0xfa26d4c4),
+     TOBN(0xb921d0d5, 0x941c86e4), TOBN(0x7208f094, 0xef4db114),
+     TOBN(0x2997f43c, 0x17ddadf8), TOBN(0xd1aabdea, 0x21bc290d),
+     TOBN(0x64e20e00, 0x86182be1), TOBN(0x9bd11568, 0xcbddb8eb),
+     TOBN(0x639db1d4, 0x3ba0e6b5), TOBN(0xb99b11fb, 0x429a6b4f),
+     TOBN(0x04ef7ad5, 0xaaa48cd8), TOBN(0xb97a6501, 0x8a8ac319),
+     TOBN(0x9ae38a6a, 0x47591d88), TOBN(0x27d91254, 0x6902edb4),
+     TOBN(0x5dae3d83, 0x812b143a), TOBN(0x02ee1353, 0x93a2fdf6),
+     TOBN(0x07a00389, 0x72410377), TOBN(0xa2fbd343, 0x56e10c82),
+     TOBN(0x3fd6c171, 0x72b1bcb9), TOBN(0xa8d70f93, 0x2d0033c7),
+     TOBN(0x9ea9eea3, 0x2916c28a), TOBN(0xecb7e486, 0x423edad7),
+     TOBN(0x5525fbb0, 0xc515bacf), TOBN(0x48a72394, 0xa2aa22ba),
+     TOBN(0x9bcd64c9, 0x0b9e3fe3), TOBN(0xe9e11d17, 0x1975aa86),
+     TOBN(0xa435bbf0, 0xc9dbdaac), TOBN(0xe8451f6c, 0xe30c8911),
+     TOBN(0xa1706d89, 0x5bc2d12f), TOBN(0xfe73ff43, 0x406d4883),
+     TOBN(0xb713efc6, 0x49d5739c), TOBN(0xdfd0bbf8, 0x05c1ec9a),
+     TOBN(0xde17c52c, 0x5e6b3bd0), TOBN(0x57e06034, 0x5be196af),
+     TOBN(0x9949b33d, 0x2c20f868), TOBN(0xdb3aa790, 0xb5706250),
+     TOBN(0x88ce71e7, 0x88e17f2b), TOBN(0xd851baf2, 0xda9c0881),
+     TOBN(0xe869c5ba, 0x86d8c9e9), TOBN(0x1af68d65, 0xa01425b6),
+     TOBN(0xeae8b1c6, 0x9bbd3963), TOBN(0xf34900b1, 0xec087425),
+     TOBN(0x14942910, 0xc374bb96), TOBN(0x3e13c457, 0x05487483),
+     TOBN(0xe0e6fad4, 0x35bc6ee1), TOBN(0xc7c38dc7, 0xb54d247b),
+     TOBN(0x420dd8f6, 0x8bd92789), TOBN(0x3831b0e9, 0x4ce541dd),
+     TOBN(0xbde477e4, 0x31ed7f7f), TOBN(0xb46eb7f2, 0x29c5557b),
+     TOBN(0x00a07499, 0xc56940e0), TOBN(0xabb9d567, 0xabacf00e),
+     TOBN(0x9f63b87d, 0xc5ba9d0c), TOBN(0xf4c5c4a3, 0x708d4f4c),
+     TOBN(0xdbde9879, 0xde7fcf63), TOBN(0xbe88f949, 0x616cf5d6),
+     TOBN(0x17560674, 0xd1aa38be), TOBN(0x160ec365, 0x9c436175),
+     TOBN(0x9c85e50a, 0xb9bd0afb), TOBN(0x2b66a1c0, 0xd26ac425),
+     TOBN(0xcb78ce81, 0x807f33db), TOBN(0x9d337d8a, 0x3db81e06),
+     TOBN(0xe223eae4, 0x72638d70), TOBN(0x7f9ea217, 0x6bf2ebab),
+     TOBN(0x2804b59c, 0x9b634059), TOBN(0x1043fbf4, 0xf3dc8d46),
+     TOBN(0x321eca1e, 0x7bc6949c), TOBN(0xbf2906c0, 0x8f051155),
+     TOBN(0xb802a328, 0x9c539f40), TOBN(0x08bcca20, 0x073cd808),
+     TOBN(0x08cb6315, 0xcea8bf63), TOBN(0x7ac2699d, 0xb59ee7fa),
+     TOBN(0x4cd2c8a9, 0x8d1601e0), TOBN(0x6d7188e3, 0x7b90d9c3),
+     TOBN(0x63486716, 0x6bfe73d3), TOBN(0x49ed7faa, 0xcf9f30b0),
+     TOBN(0xf7edf5d6, 0xc9515fd6), TOBN(0xbb3ab848, 0x8a8ae607),
+     TOBN(0xe6e6b209, 0x21c5c388), TOBN(0x5dca0a1d, 0x5b1e03bc),
+     TOBN(0x15670f59, 0x94a8b174), TOBN(0x6f79e381, 0x68c27a97),
+     TOBN(0x6d34bdf6, 0xab463fa6), TOBN(0x7bb127b6, 0x0093b9cb),
+     TOBN(0x61d05113, 0x5a3bfdd0), TOBN(0x4abab575, 0xf1296bdd),
+     TOBN(0x72da6849, 0x4d2e9a7c), TOBN(0x90267bca, 0x8d11f03d),
+     TOBN(0x47811122, 0x3e9b310b), TOBN(0x8ffe91d3, 0x1b1920cd),
+     TOBN(0xec293ec6, 0x7521898e), TOBN(0xf0cf0269, 0x96c1da75),
+     TOBN(0xb0dbd4c3, 0x80f2c7b3), TOBN(0xe5281755, 0x34e4baf8)},
+    {TOBN(0xc32730e8, 0xdd14d47e), TOBN(0xcdc1fd42, 0xc0f01e0f),
+     TOBN(0x2bacfdbf, 0x3f5cd846), TOBN(0x45f36416, 0x7272d4dd),
+     TOBN(0xdd813a79, 0x5eb75776), TOBN(0xb57885e4, 0x50997be2),
+     TOBN(0xda054e2b, 0xdb8c9829), TOBN(0x4161d820, 0xaab5a594),
+     TOBN(0x4c428f31, 0x026116a3), TOBN(0x372af9a0, 0xdcd85e91),
+     TOBN(0xfda6e903, 0x673adc2d), TOBN(0x4526b8ac, 0xa8db59e6),
+     TOBN(0x51a033a5, 0xcecb916f), TOBN(0x2ac62f63, 0x8d7de61c),
+     TOBN(0x92eece49, 0xa42a266e), TOBN(0x87e037db, 0x82c4d11e),
+     TOBN(0x875be141, 0x6fbae08a), TOBN(0xf348fe26, 0xc539478c),
+     TOBN(0x51f8b907, 0xff94c01e), TOBN(0xc46cc0e0, 0x19695a9d),
+     TOBN(0x2c74bd66, 0x6c51b9c2), TOBN(0x635d3d24, 0xee565de8),
+     TOBN(0x6bd65663, 0x8982c8c3), TOBN(0x5c345b79, 0xdaf6a93c),
+     TOBN(0x68fe359d, 0xe23a8472), TOBN(0x43eb12bd, 0x4ce3c101),
+     TOBN(0x0ec652c3, 0xfc704935), TOBN(0x1eeff1f9, 0x52e4e22d),
+     TOBN(0xba6777cb, 0x083e3ada), TOBN(0xab52d7dc, 0x8befc871),
+     TOBN(0x4ede689f, 0x497cbd59), TOBN(0xc8ae42b9, 0x27577dd9),
+     TOBN(0xe0f08051, 0x7ab83c27), TOBN(0x1f3d5f25, 0x2c8c1f48),
+     TOBN(0x57991607, 0xaf241aac), TOBN(0xc4458b0a, 0xb8a337e0),
+     TOBN(0x179c59cf, 0x210c3144), TOBN(0xfb613c57, 0x33eebbc4),
+     TOBN(0xdda75cfd, 0xba0cf384), TOBN(0x94081a5b, 0x3a8fbafa),
+     TOBN(0xb91de90a, 0x33384e0b), TOBN(0x7d1f8f40, 0x27aa2a45),
+     TOBN(0x0747bcc1, 0x62031148), TOBN(0xd2db8e39, 0xf324160b),
+     TOBN(0x9c1ce3e9, 0x722484f0), TOBN(0x13a7ee5d, 0xa62d1dda),
+     TOBN(0x77fd7934, 0x3a963bce), TOBN(0xcd3d8717, 0x83d2f21b),
+     TOBN(0x3dbb3fa6, 0x51dd1ba9), TOBN(0xe53c1c4d, 0x545e960b),
+     TOBN(0x35ac6574, 0x793ce803), TOBN(0xb2697dc7, 0x83dbce4f),
+     TOBN(0xe35c5bf2, 0xe13cf6b0), TOBN(0x35034280, 0xb0c4a164),
+     TOBN(0xaa490908, 0xd9c0d3c1), TOBN(0x2cce614d, 0xcb4d2e90),
+     TOBN(0xf646e96c, 0x54d504e4), TOBN(0xd74e7541, 0xb73310a3),
+     TOBN(0xead71596, 0x18bde5da), TOBN(0x96e7f4a8, 0xaa09aef7),
+     TOBN(0x609deb16, 0x2d8bcd6e), TOBN(0xe42f23a9, 0x2591750d),
+     TOBN(0x4a9f3132, 0xb378305c), TOBN(0xf1017998, 0x69275f5e),
+     TOBN(0x14be7467, 0x61b089b5), TOBN(0x05f620d2, 0x0c81b0c5),
+     TOBN(0xca90a9c0, 0x6cb8412e), TOBN(0xfe0f6a89, 0x15b1b0d5),
+     TOBN(0x1b25ac96, 0x20c71988), TOBN(0xb971b61a, 0x390aedd0),
+     TOBN(0x995214d7, 0x79d8cd39), TOBN(0xd7fa135b, 0x65c6e11a),
+     TOBN(0xa8393a24, 0x5d6e5f48), TOBN(0x2c8d7ea2, 0xf9175ce8),
+     TOBN(0xd8824e02, 0x55a20268), TOBN(0x9dd9a272, 0xa446bcc6),
+     TOBN(0xc929cded, 0x5351499b), TOBN(0xea5ad9ec, 0xcfe76535),
+     TOBN(0x26f3d7d9, 0xdc32d001), TOBN(0x51c3be83, 0x43eb9689),
+     TOBN(0x91fdcc06, 0x759e6ddb), TOBN(0xac2e1904, 0xe302b891),
+     TOBN(0xad25c645, 0xc207e1f7), TOBN(0x28a70f0d, 0xab3deb4a),
+     TOBN(0xa13f19b4, 0x0f3ff12d), TOBN(0x57ee08b1, 0x019564aa),
+     TOBN(0x00ec0c99, 0x7044a6f4), TOBN(0xaf5665f8, 0xdca1075c),
+     TOBN(0xded5ca3f, 0x0620ab0c), TOBN(0x9b2cb8c7, 0xa896deff),
+     TOBN(0x032ab2b3, 0x07df2345), TOBN(0x964d109e, 0xf1da3f88),
+     TOBN(0x2286b6f7, 0x25133304), TOBN(0x0d16d531, 0x977a4567),
+     TOBN(0x00a66036, 0xf1abae4f), TOBN(0x5debab1d, 0x95f0103b),
+     TOBN(0x922d7f97, 0x03bea8f1), TOBN(0x3ad820d4, 0x584570be),
+     TOBN(0x0ce0a850, 0x3cd46b43), TOBN(0x4c07911f, 0xae66743d),
+     TOBN(0x66519eb9, 0xfda60023), TOBN(0x7f83004b, 0xec2acd9c),
+     TOBN(0x001e0b80, 0xc3117ead), TOBN(0xbb72d541, 0x0722ba25),
+     TOBN(0x3af7db96, 0x6e9a5078), TOBN(0x86c5774e, 0x701b6b4c),
+     TOBN(0xbd2c0e8e, 0x37824db5), TOBN(0x3ae3028c, 0xbfac286d),
+     TOBN(0xfd1b413f, 0x5fb7c5a8), TOBN(0x6152b9de, 0x0206cba1),
+     TOBN(0x487f8e3a, 0xd8f51960), TOBN(0xac34a23c, 0x033ca1bc),
+     TOBN(0x90bba98f, 0x60258d55), TOBN(0x30421acf, 0xbd9098f2),
+     TOBN(0xd9c601f9, 0x89c0ce44), TOBN(0x621bda83, 0x2f2f1af1),
+     TOBN(0x14fa7ef6, 0x38c45441), TOBN(0xbd5dc10f, 0xe47faa31),
+     TOBN(0x9dce0dcb, 0x74eeb6a1), TOBN(0x2cca3e66, 0x06346849),
+     TOBN(0x83d4d4a8, 0xa33e071b), TOBN(0x881c0a92, 0x61444bb5),
+     TOBN(0xeea1e292, 0x520e3bc3), TOBN(0x5a5f4c3c, 0x2aaab729),
+     TOBN(0x0b766c5e, 0xe63c7c94), TOBN(0x62bb8a9f, 0xbb2cc79c),
+     TOBN(0x97adc7d2, 0xaa5dc49d), TOBN(0x30cc26b3, 0x31718681),
+     TOBN(0xac86e6ff, 0x56e86ede), TOBN(0x37bca7a2, 0xcd52f7f2),
+     TOBN(0x734d2c94, 0x9ce6d87f), TOBN(0x06a71d71, 0xc2f7e0ca),
+     TOBN(0xcdb67ea9, 0x20066faf), TOBN(0x929b4d2a, 0xc7fb7154),
+     TOBN(0x5842d968, 0x7fdeb411), TOBN(0x2ddf764a, 0xafe55cb9),
+     TOBN(0x608bf76f, 0x47df3cf4), TOBN(0x1862463b, 0x5984e339),
+     TOBN(0x7feea86f, 0x944d22a2), TOBN(0xf8562c30, 0x281f2b84),
+     TOBN(0x332a54d2, 0xbd358ea4), TOBN(0xa54dec9f, 0xe7fe1ede),
+     TOBN(0x9c8e52a4, 0x932264d4), TOBN(0x428acd1a, 0x89817f5b),
+     TOBN(0x559dcf75, 0xc6357d33), TOBN(0x4616d940, 0x652517de),
+     TOBN(0x3d576b98, 0x1ccf207b), TOBN(0x51e2d1ef, 0x1979f631),
+     TOBN(0x57517ddd, 0x06ae8296), TOBN(0x309a3d7f, 0xd6e7151f),
+     TOBN(0xba2a23e6, 0x0e3a6fe5), TOBN(0x76cf674a, 0xd28b22c3),
+     TOBN(0xd235ad07, 0xf8b808c3), TOBN(0x7bbf4c58, 0x6b71213a),
+     TOBN(0x0676792e, 0x93271ebb), TOBN(0x2cfd2c76, 0x05b1fc31),
+     TOBN(0x42aeebc4, 0xeda2fa8f), TOBN(0xda91ada3, 0xe77a9c5b),
+     TOBN(0x29b9d55f, 0xc585a572), TOBN(0xb0e52414, 0xa256353d),
+     TOBN(0x1d0e7d5f, 0x29adbd21), TOBN(0x7ee5ff9c, 0xd057d175),
+     TOBN(0x0bf76fcf, 0xc9097bf9), TOBN(0x023170f8, 0xfe09f5b3),
+     TOBN(0x8a67c124, 0x0799f989), TOBN(0x4ce28eeb, 0xc6a20819),
+     TOBN(0xfc1d7c91, 0x79502d13), TOBN(0x7922d2d9, 0xde43f895),
+     TOBN(0x4258e5c0, 0x37a450f5), TOBN(0xc3245f1b, 0x52d2b118),
+     TOBN(0x6df7b484, 0x82bc5963), TOBN(0xe520da4d, 0x9c273d1e),
+     TOBN(0xed78e012, 0x2c3010e5), TOBN(0x11222948, 0x3c1d4c05),
+     TOBN(0xe3dae5af, 0xc692b490), TOBN(0x3272bd10, 0xc197f793),
+     TOBN(0xf7eae411, 0xe709acaa), TOBN(0x00b0c95f, 0x778270a6),
+     TOBN(0x4da76ee1, 0x220d4350), TOBN(0x521e1461, 0xab71e308),
+     TOBN(0xf2cdae31, 0x96230a58), TOBN(0x47cf36b4, 0xf304e1ea),
+     TOBN(0x9d14f25a, 0xd750b29b), TOBN(0x931b9c65, 0xdba15f3e),
+     TOBN(0x34db169e, 0xbf9fe2dd), TOBN(0x8a89e47c, 0x52663433),
+     TOBN(0x8859a4f8, 0x026ec31f), TOBN(0xeeb703ea, 0xa913ceea),
+     TOBN(0x74638d6a, 0x67ac4db7), TOBN(0x5c8ea7b2, 0xbe25d755),
+     TOBN(0x8a0f0a87, 0x38db10ee), TOBN(0x96a26bac, 0xe890bcd3)},
+    {TOBN(0x883533af, 0x64a5e869), TOBN(0xaaa778c2, 0x6973ec23),
+     TOBN(0x8f0b5fb5, 0x46d0fcf3), TOBN(0x7e6b0a0a, 0x4ab05da7),
+     TOBN(0xcd91a869, 0xc67b6614), TOBN(0x7de9f2ff, 0x6c6f7cf2),
+     TOBN(0xc072a106, 0xd1ec14c3), TOBN(0x3f4b9606, 0x42a128ee),
+     TOBN(0x7378192c, 0x8f0ce946), TOBN(0xdf2e7b9f, 0xd1149441),
+     TOBN(0x4fa17cb6, 0x14ccf45a), TOBN(0x575680e9, 0x45f03568),
+     TOBN(0x8b70e94f, 0x8f458c68), TOBN(0x29272654, 0x4160ecc7),
+     TOBN(0xe22219ba, 0x4d3ef22f), TOBN(0x7f8a712a, 0x1999f948),
+     TOBN(0x25575e96, 0xabfe7302), TOBN(0x21c6ffc6, 0x564a1af0),
+     TOBN(0x045e9c66, 0x7e8500da), TOBN(0xef7c3cf7, 0x04ef8ea6),
+     TOBN(0xdd23b825, 0xc3db161a), TOBN(0x05fb173a, 0xba33a906),
+     TOBN(0x9a8b5ecb, 0x870e41f2), TOBN(0xf3d9db0b, 0xccc30d1d),
+     TOBN(0xd9243926, 0xe873ff0f), TOBN(0x2e2a5ab6, 0xf20b0e49),
+     TOBN(0xa1bcfeee, 0x0e35f201), TOBN(0xd25be5f3, 0x196f23f3),
+     TOBN(0x298c67f2, 0xffc1d068), TOBN(0x77dae55c, 0x0c3d950b),
+     TOBN(0x5e15ab99, 0x8822c996), TOBN(0x52de2e6d, 0x83f60a98),
+     TOBN(0xa9f82ec9, 0x47a7e269), TOBN(0xf02af9a2, 0x2ac22e49),
+     TOBN(0xdfb3103f, 0xa706f090), TOBN(0x12559962, 0x3cf8dcb0),
+     TOBN(0xb7b85625, 0x88ad12b2), TOBN(0x81f5958b, 0x1e44b254),
+     TOBN(0xb4ebddd5, 0xc91b8ffd), TOBN(0xef815ae1, 0x55d38511),
+     TOBN(0x98587d55, 0x1b0da525), TOBN(0x1d418177, 0x34a9ebbd),
+     TOBN(0x844811fb, 0x1e6057d7), TOBN(0x0c169771, 0x76e5976d),
+     TOBN(0x4b268bb4, 0xf623789b), TOBN(0xb26ae5be, 0x40498058),
+     TOBN(0xb47a5ded, 0x3c2b435a), TOBN(0xe15a684b, 0x8fceceb3),
+     TOBN(0x122a3eed, 0xd09dc3c8), TOBN(0x6a19907f, 0xaefe0819),
+     TOBN(0x057aafa1, 0xda325339), TOBN(0x138033bd, 0xd42a5345),
+     TOBN(0x8ac206af, 0x1a065ebe), TOBN(0x0a46f5ae, 0x25c31ed6),
+     TOBN(0x7fc577a9, 0xd7e379db), TOBN(0xc6df6943, 0x69dcee54),
+     TOBN(0x4c167ba2, 0xa8336bc1), TOBN(0x0fbd9708, 0xf3a1339c),
+     TOBN(0xc6b8c01f, 0x226f612f), TOBN(0x5d4ed789, 0xd51332e1),
+     TOBN(0x26aa2c2e, 0x5a1abcd8), TOBN(0x2b16a12e, 0x9609d9d8),
+     TOBN(0xe485a551, 0xa2bee00c), TOBN(0xfa28c30b, 0xf4f2292e),
+     TOBN(0x99abef78, 0xb7358f1b), TOBN(0xda6b3cdf, 0x10a276a1),
+     TOBN(0xbd3858b7, 0x47c03f71), TOBN(0x4f0bf5f0, 0xb22d05d1),
+     TOBN(0x2d80f5d2, 0x8250f760), TOBN(0x060f9b27, 0x8cd9666c),
+     TOBN(0x6a6c40b0, 0xb1b014a9), TOBN(0x44537af3, 0x8c440a9e),
+     TOBN(0xb564cfd6, 0x76faaca5), TOBN(0x8a6e3925, 0x920dd223),
+     TOBN(0xee59a140, 0xa590a383), TOBN(0x9e29b552, 0xa1922ad9),
+     TOBN(0x604367de, 0x60a0da63), TOBN(0xc498aca5, 0x92c35fd0),
+     TOBN(0x74135082, 0x250ed8a0), TOBN(0x5d109d1a, 0x6c7c3e77),
+     TOBN(0xf9e2d84d, 0xc63dff94), TOBN(0xca50f5e4, 0xf7aa2b0e),
+     TOBN(0x7cba9e87, 0xd543d389), TOBN(0xaf5fbbef, 0xd8fd1292),
+     TOBN(0x70765683, 0x4fc11c3a), TOBN(0x53a94031, 0x66aac4d1),
+     TOBN(0x2a935ef0, 0xa6db6169), TOBN(0x00292761, 0x2032d599),
+     TOBN(0xb5babb2d, 0x3a6f1316), TOBN(0x601a7dfa, 0xdb26af51),
+     TOBN(0x00c34013, 0x1322d983), TOBN(0x45b062ec, 0x2bb507c5),
+     TOBN(0xa1bbe2ed, 0x0f9b3656), TOBN(0xe17a5d49, 0x34031d18),
+     TOBN(0xe3661047, 0xf8fe1224), TOBN(0x0e4f3b3d, 0x623c6cf5),
+     TOBN(0xffaac084, 0xca45cccf), TOBN(0xaea5cc3d, 0x061ffe3c),
+     TOBN(0x7c5d7c60, 0xb355f387), TOBN(0x4bbb2a0c, 0x99cba92d),
+     TOBN(0x6b4ba3ef, 0x2f7768d6), TOBN(0xc7484ed2, 0xcc5f9c40),
+     TOBN(0x5d4e92fc, 0x52b57a7e), TOBN(0xba9f16c4, 0xca2c200b),
+     TOBN(0xebe02a8a, 0x3797ccba), TOBN(0xb6b3f421, 0x38c4133a),
+     TOBN(0xad5d85b6, 0x8153d033), TOBN(0x782d6ee8, 0x5714f269),
+     TOBN(0x7845b696, 0x9c0cf752), TOBN(0xb82d052b, 0x5a732acf),
+     TOBN(0x7760564c, 0x1262877b), TOBN(0x29b3c57a, 0x8ecc7aa5),
+     TOBN(0xb58eccb0, 0xdf1ebbed), TOBN(0x86fc1544, 0x3c3a3303),
+     TOBN(0x44761ddf, 0x13060f0e), TOBN(0x5a3dacfd, 0x7371a5a8),
+     TOBN(0x846f6faa, 0xf7cbc2bc), TOBN(0xf5e098b0, 0x368caabf),
+     TOBN(0xe23ea107, 0x10c08769), TOBN(0xbc5df1db, 0x1563fcda),
+     TOBN(0x65c3a54e, 0x142d8955), TOBN(0x5c6583cc, 0xe7814f25),
+     TOBN(0xbd5a07d8, 0xd924dc7d), TOBN(0x9f717bd9, 0xc28f6e8e),
+     TOBN(0xa0c4ec4e, 0x3b6540a7), TOBN(0x3153bb2b, 0x142b3283),
+     TOBN(0x53bf403c, 0x9b296946), TOBN(0x659a828a, 0xb1cdb6d2),
+     TOBN(0xe9517d81, 0x1369af19), TOBN(0xd8c7a099, 0x8990e7a0),
+     TOBN(0xbaa9f59d, 0xe535cd04), TOBN(0xbb0cc68e, 0x0f269551),
+     TOBN(0x3c00ac52, 0x6a78c6e5), TOBN(0x9c61aca6, 0xdefaa52c),
+     TOBN(0x00341289, 0x39794a09), TOBN(0xe08910d1, 0x41cd7c0a),
+     TOBN(0xa58ffbb6, 0xa732e3bc), TOBN(0x87bf51ab, 0x91fe8fd8),
+     TOBN(0xc4f4f267, 0x4a59e2be), TOBN(0xdeb512c7, 0x438071c8),
+     TOBN(0xddf82842, 0xe9cd290b), TOBN(0x3e17311d, 0x6ae85fe0),
+     TOBN(0x6e9236a9, 0xb41be881), TOBN(0xbb9ddf98, 0x53555ebf),
+     TOBN(0xccc163ea, 0x09f3f0be), TOBN(0x9932b56f, 0x6a5b0a63),
+     TOBN(0xf89fae91, 0x9c69668e), TOBN(0x555f9821, 0x5ce13021),
+     TOBN(0x4b02693f, 0x37037aa9), TOBN(0xc4afee79, 0xbde50f35),
+     TOBN(0x4b0919c2, 0x02aa6c7a), TOBN(0x3166de2a, 0x991e15e9),
+     TOBN(0x284baa3e, 0x7077fb38), TOBN(0xbb7a6416, 0xa116ddec),
+     TOBN(0xe8c89547, 0xb7636772), TOBN(0xff940362, 0x0ef92c54),
+     TOBN(0xd5d81275, 0xe2ce6008), TOBN(0xc45bdf25, 0x0b3b9d10),
+     TOBN(0x15ab5da3, 0x6cbc83e2), TOBN(0x85a18cf8, 0xc52a66cb),
+     TOBN(0x77e202b8, 0xb042c047), TOBN(0xc4dc3de2, 0xe7e7997e),
+     TOBN(0xfe9335b1, 0x995fa67a), TOBN(0x809e161d, 0x75b96a00),
+     TOBN(0xfb03c2a5, 0xa0c3baea), TOBN(0x5c7e0523, 0x888c2f77),
+     TOBN(0xa8fda1c8, 0x87ad10e2), TOBN(0x90484f78, 0x858a3577),
+     TOBN(0x49e41f0a, 0xf9fde126), TOBN(0xec960044, 0x3613d3c2),
+     TOBN(0x2c62a49d, 0x10421d3b), TOBN(0xe2402464, 0x8131a0d8),
+     TOBN(0x8a7ce188, 0xbdf794fc), TOBN(0x704dea7d, 0x4665b1b6),
+     TOBN(0xbdb9c18e, 0x4d57c6ba), TOBN(0x5288a053, 0xf669b3c0),
+     TOBN(0xbf7d01b8, 0x78a5e252), TOBN(0xb26cccf9, 0x26b9cb7d),
+     TOBN(0x14191a32, 0x84326c47), TOBN(0x460ff747, 0x91f8425b),
+     TOBN(0x59367582, 0xbd27be7b), TOBN(0x92bf5bbc, 0x1ab2c596),
+     TOBN(0x5d96351a, 0xf6a27741), TOBN(0xeab94db8, 0x7f929e0d),
+     TOBN(0x865ba011, 0x043f1afb), TOBN(0x43acea12, 0x5fb631dd),
+     TOBN(0x192e0652, 0xb2fd1436), TOBN(0x44f22ff1, 0x7b38d121),
+     TOBN(0x7bcc228d, 0xb7cae5f6), TOBN(0x02eaeccd, 0x6a828b03),
+     TOBN(0x7c48a2ea, 0x91f301aa), TOBN(0x1e090717, 0xf5eb1a07)},
+    {TOBN(0xdf0ae8df, 0x941948e3), TOBN(0x123fee90, 0x1d010bcd),
+     TOBN(0xde3717ca, 0x1dd28691), TOBN(0x0c1db879, 0x709b678e),
+     TOBN(0x0288959a, 0x400acdc6), TOBN(0x66c69181, 0x5ca2d03a),
+     TOBN(0xe52534b3, 0xdbbb75de), TOBN(0xe914938c, 0x3de927cf),
+     TOBN(0x1a9a34f8, 0x73eece30), TOBN(0x0fb0c7bd, 0x642a6799),
+     TOBN(0x375cc0cf, 0xeaa7e8a8), TOBN(0x75fb9eb5, 0xd00ec238),
+     TOBN(0x9ca8cc9d, 0xb72958eb), TOBN(0x3c8cd0db, 0x1014f562),
+     TOBN(0x72115d53, 0x059b2bba), TOBN(0x8fe7ac30, 0x730e5dc3),
+     TOBN(0x4e67ef69, 0x841d8998), TOBN(0xfb6439ff, 0xc8ed37a5),
+     TOBN(0x48164b3e, 0x26df84c4), TOBN(0x37d492ad, 0x365bc99e),
+     TOBN(0xb7fd4643, 0xbeed38ce), TOBN(0x993cfa9f, 0xa3e30b3d),
+     TOBN(0xdcc5e7af, 0x01ddd484), TOBN(0x5edf3ac0, 0x6840175d),
+     TOBN(0x3ee87e54, 0x0c19c625), TOBN(0xe4ae611f, 0xf4a10f9a),
+     TOBN(0x27d65512, 0x0aec21e5), TOBN(0x737578f5, 0x8bea1b16),
+     TOBN(0x6e2b6bf7, 0x5fb7a3a2), TOBN(0xecc59251, 0x14f65000),
+     TOBN(0x53e1167c, 0xb8dd544c), TOBN(0xee60e60f, 0xc5862fdc),
+     TOBN(0xc86582cf, 0x6cccabeb), TOBN(0x849fc15d, 0x8b4d37c6),
+     TOBN(0xaa7960ad, 0x8f4a87bc), TOBN(0x17fe1082, 0x3b7f0a6d),
+     TOBN(0x79768e9f, 0x51d33c11), TOBN(0xeec34505, 0xa4b24889),
+     TOBN(0xc194821b, 0xbe0c67d7), TOBN(0x537a6a4a, 0x6909fdfc),
+     TOBN(0xae6d7051, 0x95ccdda7), TOBN(0xed4b7222, 0x92b3926c),
+     TOBN(0x2c5dd6af, 0x6b24a3d4), TOBN(0x9282ec39, 0xe4386095),
+     TOBN(0xdd3c7388, 0x397a3bd3), TOBN(0x9d176c6a, 0x8baf59c2),
+     TOBN(0xd5c6219e, 0x380ec958), TOBN(0x194fc116, 0x54e8e315),
+     TOBN(0x3c67c65c, 0x79650de1), TOBN(0x8e2a220b, 0x00bfb2ac),
+     TOBN(0x59d225dc, 0x42f02a3d), TOBN(0xc52ce4b2, 0x5d60e54f),
+     TOBN(0x8894e3cb, 0x3f306112), TOBN(0xb78a037b, 0x50d85aec),
+     TOBN(0xeeeb3b40, 0x2d85f328), TOBN(0x3d391b37, 0xe0406ddd),
+     TOBN(0x5273ebe9, 0x0502141b), TOBN(0xd17023e7, 0xe092bfeb),
+     TOBN(0x04564385, 0x282f5aed), TOBN(0x7e55a4e2, 0x55d82356),
+     TOBN(0x0b7576f9, 0x01ec1432), TOBN(0x84b30eec, 0xabc5f603),
+     TOBN(0xdaaf7ba9, 0xf4a84b7a), TOBN(0x9e3a5daa, 0x3bb37a99),
+     TOBN(0x56bd9648, 0x80378cff), TOBN(0x2fdeeeb7, 0x8e6ed856),
+     TOBN(0x079014a7, 0x3c81ac34), TOBN(0xf8de4004, 0xb4211c27),
+     TOBN(0x0cee3df9, 0x7fe4391e), TOBN(0x441aa7fb, 0x2fd2fc38),
+     TOBN(0xeba7be86, 0x4d1b575a), TOBN(0xca2fb5b7, 0x231c2d01),
+     TOBN(0x8307bc81, 0xd205869c), TOBN(0xdd282809, 0x9388e917),
+     TOBN(0xdd4cb2de, 0xbb572a87), TOBN(0x5a41595d, 0x14f0db39),
+     TOBN(0xd5db5f59, 0xf4e5c71e), TOBN(0xcc9c9f6f, 0x4a87f672),
+     TOBN(0x4ddce8c3, 0x012e65ce), TOBN(0xaae28eaf, 0xab3a94d3),
+     TOBN(0xd4b95011, 0x0b333aba), TOBN(0x3e171506, 0x914eb476),
+     TOBN(0x109ee9ab, 0x69bbfa63), TOBN(0xbddba098, 0x5dff5471),
+     TOBN(0x0683349e, 0x463a8251), TOBN(0x97dc4f47, 0x5103e72c),
+     TOBN(0x47c71810, 0x50663b9e), TOBN(0xf327d149, 0x9733dac6),
+     TOBN(0x03f55e4a, 0x292137c5), TOBN(0xccc6232a, 0xda59e1c7),
+     TOBN(0xbaa8b4dd, 0xadc59cb8), TOBN(0x45370d35, 0xfe7486e4),
+     TOBN(0x99a88c1d, 0xb0322df9), TOBN(0x394440a7, 0xfd69954f),
+     TOBN(0x9060473d, 0xa5a29889), TOBN(0xc8ca43e3, 0x2f04864a),
+     TOBN(0xf08c8efc, 0x9451d422), TOBN(0xc8beae41, 0xba846ac3),
+     TOBN(0x0157f46c, 0x807df062), TOBN(0x080eac20, 0xdeaada6a),
+     TOBN(0xdf146f3d, 0xa3bfddd0), TOBN(0x8ed7c2c6, 0x617d19d7),
+     TOBN(0x314ea3e7, 0x40439488), TOBN(0x544132c7, 0xb3e6806f),
+     TOBN(0x9b9bb477, 0xa215a3a2), TOBN(0x9310fee9, 0xe33f80b0),
+     TOBN(0xf277895c, 0xe71769af), TOBN(0xe8218e1a, 0x7d99d5b9),
+     TOBN(0xd5c7241a, 0xdd8b9644), TOBN(0x45a5f2d1, 0x993116d2),
+     TOBN(0xbacacd4a, 0x823048df), TOBN(0xa278fa04, 0x2568547a),
+     TOBN(0x3a4f2482, 0xbff72820), TOBN(0x1305d1a7, 0x13e4314a),
+     TOBN(0x9d84c333, 0x34ba28e3), TOBN(0x9995b5bb, 0x6a32fb41),
+     TOBN(0xb0f75f3c, 0x520946d8), TOBN(0xd7c4b8b7, 0xde98aa63),
+     TOBN(0xee5efcf3, 0xba856b6b), TOBN(0x36af3368, 0x3324ed66),
+     TOBN(0x29c741c3, 0xbb2af5fb), TOBN(0xb9c92da6, 0x89e6241e),
+     TOBN(0x07dace3c, 0x474b7c0f), TOBN(0xd0b3f9bc, 0xd996b6a8),
+     TOBN(0xe97e3847, 0x07c662de), TOBN(0xbf6d1e05, 0x6c851030),
+     TOBN(0x150c5e93, 0x99f1aade), TOBN(0x9c1e2351, 0x9bd848d5),
+     TOBN(0xeb808a55, 0x09cab3db), TOBN(0x1bfbe08d, 0x9a49916f),
+     TOBN(0xc6a70ea7, 0x64ab0e4e), TOBN(0x77d189f2, 0x7823f505),
+     TOBN(0x90762c1f, 0x5827fe2c), TOBN(0x20160f7a, 0xeaffda88),
+     TOBN(0x7420849f, 0x5c47c645), TOBN(0xb0823195, 0x6d72e748),
+     TOBN(0xaeac683b, 0x8ee11773), TOBN(0x8c2a0a79, 0xfb5c550e),
+     TOBN(0x6d986d69, 0x6c07cc1e), TOBN(0x57269140, 0xba8398b9),
+     TOBN(0xd13e136f, 0xd94d5223), TOBN(0x1aa75419, 0xed5b01c6),
+     TOBN(0x7c2014b1, 0x408fcdcc), TOBN(0x0680a985, 0xcffde5ee),
+     TOBN(0xfbe88fce, 0x23133885), TOBN(0x3c2e3669, 0x7c5a5c4b),
+     TOBN(0xe36cf261, 0xbbacc6e1), TOBN(0xa72c7bb1, 0x96ae3cad),
+     TOBN(0x08e37103, 0x4cb1a375), TOBN(0x5521f445, 0x2a02baee),
+     TOBN(0xda9329ba, 0xc157e471), TOBN(0x3f90cad1, 0x68470808),
+     TOBN(0x24182208, 0xa657de60), TOBN(0x17c082b7, 0x67c10d1b),
+     TOBN(0x9e222648, 0x9928d6fd), TOBN(0x1578c895, 0x36ced38f),
+     TOBN(0x92fc9a33, 0x42c5a7ee), TOBN(0x8768614a, 0xf9f0ed71),
+     TOBN(0x1ea5f7ed, 0x87ebfb66), TOBN(0x296852de, 0xd361069c),
+     TOBN(0x1cec6f1a, 0x0192498e), TOBN(0xbfd4858f, 0xa9cca3aa),
+     TOBN(0xfba98c24, 0x2ef240e8), TOBN(0xc8b500e4, 0xab635d9f),
+     TOBN(0x9f49c572, 0x913a3edd), TOBN(0xe6181f93, 0xd42b2d4d),
+     TOBN(0xf96b5db2, 0x6aa77fa3), TOBN(0xdfb2241f, 0xe43558d8),
+     TOBN(0x8f8a1964, 0x7481cd31), TOBN(0xd5b8197e, 0x17b37aa7),
+     TOBN(0x7cfbcd19, 0x7ac0dbf6), TOBN(0x4ecd8954, 0x93662f46),
+     TOBN(0x104a090d, 0x0501365f), TOBN(0x828694cd, 0x7f097083),
+     TOBN(0x60b865f3, 0x6dc105dd), TOBN(0x00549f1b, 0x85cd4ed7),
+     TOBN(0xd262e38b, 0xcc197cc9), TOBN(0x5d3271de, 0x9a262b4f),
+     TOBN(0xc7df47e9, 0xa953d539), TOBN(0xab8f1c8a, 0x5b9a86a6),
+     TOBN(0xc7d0abb2, 0xedee15a5), TOBN(0x72dc0105, 0x228cc4a1),
+     TOBN(0xeb67defc, 0xa80767de), TOBN(0x6fa174d8, 0x71820908),
+     TOBN(0x3215df48, 0x5674d19a), TOBN(0xf944531a, 0x960a081a),
+     TOBN(0x93ed7180, 0xef2cce62), TOBN(0xb318edbf, 0xc8bcfc0d),
+     TOBN(0x0909d56e, 0xfe787e58), TOBN(0x5ae74fc9, 0x8fe8b96f),
+     TOBN(0x8fc342c4, 0x35ab6811), TOBN(0x6fc6cc5c, 0x0b991e0c)},
+    {TOBN(0x55671129, 0x542f4e90), TOBN(0x43bedccf, 0x0623d4cd),
+     TOBN(0x7e21207c, 0xe99ca16b), TOBN(0x785fa105, 0x7c7a26b9),
+     TOBN(0x33c28658, 0xc2c3ab00), TOBN(0xcce42a48, 0xd79cd59f),
+     TOBN(0x9a674db4, 0xb8c3bc75), TOBN(0xea701d15, 0x6904e3fe),
+     TOBN(0x990e7221, 0x66bf2c6c), TOBN(0xba29affa, 0xbd4c3791),
+     TOBN(0xd98510cf, 0x20696ee1), TOBN(0x722ed471, 0xf93d26a5),
+     TOBN(0xe7cf5bac, 0xbc579793), TOBN(0x11db7ddf, 0xd73f881c),
+     TOBN(0x9c1a531d, 0x04fa8473), TOBN(0x399e8484, 0x5780efda),
+     TOBN(0x6e9c12be, 0x4f62cb5a), TOBN(0xf21bdc49, 0x94a5df3b),
+     TOBN(0x3c15fe12, 0x11da2a4f), TOBN(0xdea123bb, 0x23e631d1),
+     TOBN(0x3ef76da4, 0xbe294c90), TOBN(0x5cf21d5a, 0xa99b8398),
+     TOBN(0x50679cf8, 0x751b9f6a), TOBN(0x4b3f3b9c, 0x54d0b7bf),
+     TOBN(0x6c8d97e0, 0x75a46271), TOBN(0x0fa0c4cd, 0x9dbed39f),
+     TOBN(0xfb6da5e2, 0xde74ac6c), TOBN(0x041ce886, 0xc17c1ec5),
+     TOBN(0xb42941a8, 0xd7419105), TOBN(0x79768eee, 0x002fdfd5),
+     TOBN(0x64849afd, 0x88c8111f), TOBN(0xf425fe14, 0x814192d6),
+     TOBN(0xe916e864, 0x0448fd7e), TOBN(0x31e224ad, 0x72ed351f),
+     TOBN(0x73e6e6ac, 0x7c0183c1), TOBN(0x375657c6, 0x21bf7ceb),
+     TOBN(0xc84f9172, 0x03bdf6d6), TOBN(0xcfc47187, 0x69f60e03),
+     TOBN(0xcdc4753b, 0xa05068ea), TOBN(0xa177ad14, 0x077777ef),
+     TOBN(0x0b7f54eb, 0x7e4cf44a), TOBN(0x4ee443f9, 0x1860144e),
+     TOBN(0x1279ed4d, 0x42bb6a93), TOBN(0x511137d7, 0x436c1b54),
+     TOBN(0xebc958fa, 0xb8cdb6ce), TOBN(0xbc4f93f4, 0xa0c7614a),
+     TOBN(0xc5bd6cde, 0x7b2c6d8e), TOBN(0xecff7dd7, 0x8d65f38a),
+     TOBN(0x9a4af7af, 0xe45543d5), TOBN(0xb7478fe0, 0x6a04c87b),
+     TOBN(0x974eebba, 0x66f72454), TOBN(0x682578fa, 0x5901d1ec),
+     TOBN(0xc3595199, 0xe82b048b), TOBN(0x83da52fb, 0xbbc19ba2),
+     TOBN(0x40f337af, 0x90450b02), TOBN(0xbd1ea60b, 0x439c46d7),
+     TOBN(0x4f3e4818, 0x00d0ed85), TOBN(0x59d0a0a9, 0x766d9e20),
+     TOBN(0xe81dc4d6, 0x56a16718), TOBN(0xac872a21, 0xdf3d3d98),
+     TOBN(0x4da7d63a, 0xbbaae09b), TOBN(0xcae05f37, 0x0783fab2),
+     TOBN(0x1e8c0016, 0x68841d1e), TOBN(0x0688f485, 0xb10366f6),
+     TOBN(0x38ee34b0, 0x05b121e9), TOBN(0x2779f009, 0x14e0dc1e),
+     TOBN(0x83c1d44e, 0xdbff60ce), TOBN(0x63fbcf82, 0x4105c8c2),
+     TOBN(0x6b732744, 0x53715349), TOBN(0x5065bdcd, 0xc5ca18f6),
+     TOBN(0x677313cf, 0x2def86e3), TOBN(0x6c54d224, 0x33ebff5d),
+     TOBN(0x35361c91, 0x88b3fc7b), TOBN(0x706cf8c5, 0xc22a219e),
+     TOBN(0x545bb34b, 0x886348e9), TOBN(0xf25eef25, 0x4594a530),
+     TOBN(0x59427ed0, 0x73843cbb), TOBN(0x39638f20, 0xbeea8c4d),
+     TOBN(0x4e7d445f, 0x960e3c28), TOBN(0x989abc64, 0xd383df18),
+     TOBN(0xb4238e02, 0x04694ba7), TOBN(0xa3753137, 0x0203d67f),
+     TOBN(0x404bc421, 0x86d01fc1), TOBN(0x1af37190, 0xb162392d),
+     TOBN(0xffec6674, 0xf65de0f5), TOBN(0x4043079c, 0xd23ad193),
+     TOBN(0x31811365, 0xee61bc95), TOBN(0x358bbd6e, 0x8948b6e2),
+     TOBN(0x1cd9c342, 0xe31644be), TOBN(0xbab3aa8c, 0x60a8a7a7),
+     TOBN(0xe065519f, 0xa375beb6), TOBN(0xf7d0b041, 0x4439990c),
+     TOBN(0x8957c03b, 0x8517ae8a), TOBN(0xc96a0401, 0x73750d6e),
+     TOBN(0x4eb2e364, 0xb2aee6d7), TOBN(0x813054fe, 0xed099114),
+     TOBN(0x79d98e89, 0xec3c19fe), TOBN(0x860ec5a6, 0x429341e7),
+     TOBN(0x80ab8568, 0x25dd60c0), TOBN(0x7d0b3f3f, 0xe47973db),
+     TOBN(0x654435bd, 0xf7899dfb), TOBN(0x54c59689, 0xe6542b1d),
+     TOBN(0x171c6842, 0xbed69ab6), TOBN(0x82b8024d, 0x188a3126),
+     TOBN(0x31bf057d, 0x9c37538d), TOBN(0xe079326a, 0xcb0be742),
+     TOBN(0x0232e981, 0x29ace4e3), TOBN(0x7b06fb86, 0xce8596ab),
+     TOBN(0x71714896, 0xcaada268), TOBN(0xbb3d05dc, 0xfd0e302c),
+     TOBN(0xb0785f33, 0xfe56d08f), TOBN(0xdd43e0f6, 0x38a1b2ef),
+     TOBN(0x2df35cfb, 0x360fc15a), TOBN(0x97173f0f, 0x90b3ed36),
+     TOBN(0xd4970bdd, 0xb720544e), TOBN(0xb6075f76, 0x94a01944),
+     TOBN(0xc99e8a3e, 0x4a43c4f3), TOBN(0x8013609f, 0xd9cb4808),
+     TOBN(0xf3fef0ea, 0xecc3d094), TOBN(0x3829fac7, 0x8642d223),
+     TOBN(0xb7613dab, 0x0402156b), TOBN(0x4ad70f1c, 0x0b20ec7a),
+     TOBN(0xd9189b20, 0x9c46dd4d), TOBN(0x4b22485f, 0x4bd5235a),
+     TOBN(0x6e972031, 0x88822a0d), TOBN(0x3cf8d823, 0x2c136807),
+     TOBN(0x5997fa64, 0x0884e550), TOBN(0x73110b25, 0x293aedb8),
+     TOBN(0x7e820168, 0x35319a22), TOBN(0x2222c809, 0xa6c668ba),
+     TOBN(0x2f316be2, 0x31e0bfb8), TOBN(0x86cf3a2d, 0x0d832198),
+     TOBN(0xffe3104b, 0x684456b1), TOBN(0x37ba0db6, 0xf0f49278),
+     TOBN(0x15aaed42, 0xcca2f150), TOBN(0x8618aa02, 0xc421c694),
+     TOBN(0x4d6a091d, 0xfab87b36), TOBN(0x304eaea0, 0x0e786d5f),
+     TOBN(0x0be97747, 0x2c114074), TOBN(0xf57e3a19, 0xad387a8d),
+     TOBN(0x6094823b, 0x7a70d421), TOBN(0x59287918, 0x09de860f),
+     TOBN(0x7f7fca49, 0x6dcf6020), TOBN(0x57580c61, 0x5f46086e),
+     TOBN(0xeab34616, 0x5d89002f), TOBN(0xb3115628, 0x72a01a68),
+     TOBN(0x2f0ced58, 0xdce0c191), TOBN(0xec08b09a, 0x1a895760),
+     TOBN(0x206faa7f, 0xae62153c), TOBN(0xc31e3815, 0xcf2895bf),
+     TOBN(0xd57fbf57, 0x9ac88636), TOBN(0x966f5a84, 0xce91affd),
+     TOBN(0x092458b9, 0x63620a73), TOBN(0xda7b4910, 0x50805fc1),
+     TOBN(0x1fc60a25, 0x5c561649), TOBN(0x8110a1a9, 0x4f899e20),
+     TOBN(0xb509f702, 0xf0cb1370), TOBN(0xbdfcf4a0, 0xc658441f),
+     TOBN(0x853d832a, 0x7f07f328), TOBN(0x074fdecd, 0x8fbdcb83),
+     TOBN(0x80ed8de9, 0xd6a4650d), TOBN(0x61c39ce8, 0xa5d68720),
+     TOBN(0xe66666d2, 0x3177feb4), TOBN(0xdbf3fc57, 0xafacf38b),
+     TOBN(0x7e2d9951, 0x0da620fb), TOBN(0x901145ff, 0xdf866f77),
+     TOBN(0x442a37e5, 0xdb045beb), TOBN(0x0cb0600f, 0xbeb1b008),
+     TOBN(0x1e6604d3, 0x54d7a6af), TOBN(0xba6ae4d0, 0x07c97f80),
+     TOBN(0x5e3d978b, 0x77c527fb), TOBN(0xd0642c72, 0xe93a0d78),
+     TOBN(0x06d8ae5c, 0xb3c3c215), TOBN(0x8bf36e5a, 0x4eb9a4c9),
+     TOBN(0x1ca6403c, 0x4d505a53), TOBN(0x0187be5a, 0xd2f5c7a3),
+     TOBN(0x68cce2ba, 0x9f850eac), TOBN(0x81055e4a, 0x5805353b),
+     TOBN(0x3c242c1d, 0x89b4eb85), TOBN(0xee4a6691, 0xdda42eb8),
+     TOBN(0xbb39a17a, 0x7c34f095), TOBN(0x7be330a8, 0x22fbbe61),
+     TOBN(0x6be6abe3, 0xb91f1482), TOBN(0xf972804f, 0xbd39a2bc),
+     TOBN(0x06737e54, 0xf91d813e), TOBN(0xbd606668, 0x1a87cd4a),
+     TOBN(0xbf88b2e5, 0xf538d56e), TOBN(0xb8206a81, 0x34afd68f),
+     TOBN(0x7a93aedf, 0xa58af042), TOBN(0x8853cdf6, 0xac0511b0),
+     TOBN(0x9d7f416d, 0x067e2c19), TOBN(0x5d0bc923, 0xf9671d8a)},
+    {TOBN(0x2e7d0a16, 0x204be028), TOBN(0x4f1d082e, 0xd0e41851),
+     TOBN(0x15f1ddc6, 0x3eb317f9), TOBN(0xf0275071, 0x5adf71d7),
+     TOBN(0x2ce33c2e, 0xee858bc3), TOBN(0xa24c76d1, 0xda73b71a),
+     TOBN(0x9ef6a70a, 0x6c70c483), TOBN(0xefcf1705, 0x05cf9612),
+     TOBN(0x9f5bf5a6, 0x7502de64), TOBN(0xd11122a1, 0xa4701973),
+     TOBN(0x82cfaac2, 0xa2ea7b24), TOBN(0x6cad67cc, 0x0a4582e1),
+     TOBN(0x96a1e74f, 0x51e4de5e), TOBN(0x72913696, 0xe37f5006),
+     TOBN(0x12449c4f, 0xbe35109c), TOBN(0x1fad8b30, 0x4521d7e6),
+     TOBN(0xc85eb23d, 0x57d00293), TOBN(0x4ebd334b, 0x35f68229),
+     TOBN(0x7c5b8668, 0x2df5acf1), TOBN(0xc2b4da6e, 0x5463de2e),
+     TOBN(0x067b0456, 0x757cd570), TOBN(0xeaab81be, 0x3a1c866b),
+     TOBN(0x72a6af75, 0xbbba88c0), TOBN(0xaed4dbde, 0x0ef567dc),
+     TOBN(0x597a26ff, 0xb4dc8600), TOBN(0x264a09f3, 0xf9288555),
+     TOBN(0x0b06aff6, 0x5c27f5f6), TOBN(0xce5ab665, 0xd8d544e6),
+     TOBN(0x92f031be, 0x99275c32), TOBN(0xaf51c5bb, 0xf42e0e7c),
+     TOBN(0x5bb28b06, 0x1e37b36d), TOBN(0x583fba6a, 0x8473543a),
+     TOBN(0xe73fd299, 0xf93fb7dc), TOBN(0xfcd999a8, 0x6e2ccad9),
+     TOBN(0xb8c8a6df, 0x334d4f57), TOBN(0x5adb28dd, 0x9a2acc9b),
+     TOBN(0x3afdee27, 0x7d221ab6), TOBN(0xecf10abc, 0x47bb619e),
+     TOBN(0x340c8ee3, 0xba4a3301), TOBN(0x1a6ea51a, 0x2a883b7f),
+     TOBN(0x64f27976, 0xd5d7412b), TOBN(0x7fcf0ecc, 0x91251b6e),
+     TOBN(0x5f3f8f41, 0x365b18b7), TOBN(0x38e48b96, 0xe2e13e58),
+     TOBN(0xde3b73d6, 0xad61b2cb), TOBN(0xf08398d5, 0xd542676d),
+     TOBN(0xd373931e, 0x8e7d712b), TOBN(0x89325d7a, 0x7f96e023),
+     TOBN(0x5adf3d9a, 0x111792b9), TOBN(0x1c77a305, 0x4f1e0d09),
+     TOBN(0xf9fbce33, 0xa82d3736), TOBN(0xf307823e, 0x718c8aa3),
+     TOBN(0x860578cf, 0x416ccf69), TOBN(0xb942add8, 0x1ef8465b),
+     TOBN(0x9ee0cf97, 0xcd9472e1), TOBN(0xe6792eef, 0xb01528a8),
+     TOBN(0xf99b9a8d, 0xc09da90b), TOBN(0x1f521c2d, 0xcbf3ccb8),
+     TOBN(0x6bf66948, 0x91a62632), TOBN(0xcc7a9ceb, 0x854fe9da),
+     TOBN(0xe44e3f86, 0x4b3759cf), TOBN(0x90cab0eb, 0x9d74e3f6),
+     TOBN(0x10042545, 0x01c4e171), TOBN(0xc12df68c, 0xce52defb),
+     TOBN(0xb1fae2fb, 0xf363100a), TOBN(0x5016c853, 0x3573235f),
+     TOBN(0x8d4deb66, 0x1d922e9b), TOBN(0x8a20d423, 0x17f84ef2),
+     TOBN(0x32498583, 0x5a4e118e), TOBN(0x5abfa961, 0x308772e9),
+     TOBN(0x41c7611f, 0xf54e4876), TOBN(0xc1da40d3, 0x1f5867b2),
+     TOBN(0x46303171, 0x491ccb92), TOBN(0xa80a8c0d, 0x2771235b),
+     TOBN(0xd8e497ff, 0xf172c7cf), TOBN(0x7f7009d7, 0x35b193cf),
+     TOBN(0x6b9fd3f7, 0xf19df4bc), TOBN(0xada548c3, 0xb46f1e37),
+     TOBN(0x87c6eaa9, 0xc7a20270), TOBN(0xef2245d6, 0xae78ef99),
+     TOBN(0x2a121042, 0x539eab95), TOBN(0x29a6d5d7, 0x79b8f5cc),
+     TOBN(0x33803a10, 0xb77840dc), TOBN(0xfedd3a70, 0x11a6a30f),
+     TOBN(0x3c90a59f, 0x85adde98), TOBN(0x35414174, 0xe5269140),
+     TOBN(0x9aca885c, 0x1a0d58e2), TOBN(0x77b9b6dd, 0x6816b009),
+     TOBN(0x8e5c1213, 0x9ee4718f), TOBN(0x60ad991e, 0x4e4eac45),
+     TOBN(0xc00c3569, 0x4d71f624), TOBN(0xacbf4eb2, 0x5bc5fd2a),
+     TOBN(0xcba1ffc7, 0x5eaf3eaa), TOBN(0x5f99092d, 0x42a87e32),
+     TOBN(0x2e7b49c7, 0x6f7a882f), TOBN(0x5e9bfc5c, 0x29040512),
+     TOBN(0xfa070e22, 0x142403d1), TOBN(0x68ff3160, 0x15c6f7f5),
+     TOBN(0xe09f04e6, 0x223a0ce8), TOBN(0x22bbd018, 0x53e14183),
+     TOBN(0x35d9fafc, 0xcf45b75b), TOBN(0x3a34819d, 0x7eceec88),
+     TOBN(0xd9cf7568, 0xd33262d2), TOBN(0x431036d5, 0x841d1505),
+     TOBN(0x0c800565, 0x9eb2a79a), TOBN(0x8e77d9f0, 0x5f7edc6a),
+     TOBN(0x19e12d05, 0x65e800aa), TOBN(0x335c8d36, 0xb7784e7c),
+     TOBN(0x75cba9d5, 0x30a3ada1), TOBN(0xb69e308b, 0xf8ae9565),
+     TOBN(0x990e3425, 0xca7b8369), TOBN(0x9f67567f, 0xe0a7ad0b),
+     TOBN(0x76ed6fe7, 0x18bd01b7), TOBN(0x282358aa, 0x2ff95cfe),
+     TOBN(0x28d2ea41, 0x410f8841), TOBN(0x89d1533f, 0xccd67c81),
+     TOBN(0x969bb272, 0xb6a7b8f9), TOBN(0x54f8664c, 0x26330782),
+     TOBN(0xb89f3ae8, 0x1dcd9164), TOBN(0x54d845b9, 0x3d962c14),
+     TOBN(0x8b2fc4e9, 0x6484fd40), TOBN(0xee702764, 0xa35d24ea),
+     TOBN(0x15b28ac7, 0xb871c3f3), TOBN(0x805b4048, 0xe097047f),
+     TOBN(0xd6f1b8df, 0x647cad2f), TOBN(0xf1d5b458, 0xdc7dd67f),
+     TOBN(0x324c529c, 0x25148803), TOBN(0xf6185ebe, 0x21274faf),
+     TOBN(0xaf14751e, 0x95148b55), TOBN(0x283ed89d, 0x28f284f4),
+     TOBN(0x93ad20e7, 0x4cbebf1a), TOBN(0x5f6ec65d, 0x882935e1),
+     TOBN(0xb3984b17, 0x6c0f3509), TOBN(0xf9fa4483, 0xd8b4d6bc),
+     TOBN(0xf4ac2b67, 0x7dec20d2), TOBN(0x67ef024e, 0xb3dbe034),
+     TOBN(0x2dcc5118, 0x0f94f4d7), TOBN(0x024cdcfd, 0x74a51393),
+     TOBN(0xf1c0fead, 0x20e7abcb), TOBN(0xffc18f81, 0xd3a7414f),
+     TOBN(0xb00ce556, 0x7062cb0b), TOBN(0xeccb0521, 0x817bc8d1),
+     TOBN(0xa0c0fe60, 0x40411c15), TOBN(0x05311322, 0x1defbe00),
+     TOBN(0xe222eba4, 0xa4dcefe9), TOBN(0x63ad235f, 0xec1ceb74),
+     TOBN(0x2e0bf749, 0xe05b18e7), TOBN(0x547bd050, 0xb48bdd87),
+     TOBN(0x0490c970, 0xf5aa2fc4), TOBN(0xced5e4cf, 0x2b431390),
+     TOBN(0x07d82704, 0x51d2898e), TOBN(0x44b72442, 0x083b57d4),
+     TOBN(0xa4ada230, 0x5037fce8), TOBN(0x55f7905e, 0x50510da6),
+     TOBN(0xd8ee724f, 0x8d890a98), TOBN(0x925a8e7c, 0x11b85640),
+     TOBN(0xda828fe5, 0x56467257), TOBN(0x5e9abf67, 0xd640c2a1),
+     TOBN(0x0eed233c, 0xc25c696a), TOBN(0x72483dc5, 0xb3e1d84f),
+     TOBN(0x30bf1ee3, 0x4f114abc), TOBN(0xf58b321e, 0xd1f9bce8),
+     TOBN(0xcb26564c, 0x97524f33), TOBN(0xdc2f105e, 0x1e453229),
+     TOBN(0x9da43ceb, 0x72a982dd), TOBN(0xecf5649d, 0xfeef8862),
+     TOBN(0xd8afda34, 0x1fa2f06d), TOBN(0xf0d0ced3, 0x55035432),
+     TOBN(0x5bfa10cd, 0x1ca459ed), TOBN(0x593f085a, 0x6dcf56bf),
+     TOBN(0xe6f0ad9b, 0xc0579c3e), TOBN(0xc11c95a2, 0x2527c1ad),
+     TOBN(0x7cfa71e1, 0xcf1cb8b3), TOBN(0xedcff833, 0x1d6dc79d),
+     TOBN(0x581c4bbe, 0x432521c9), TOBN(0xbf620096, 0x144e11a0),
+     TOBN(0x54c38b71, 0xbe3a107b), TOBN(0xed555e37, 0xe2606ec0),
+     TOBN(0x3fb148b8, 0xd721d034), TOBN(0x79d53dad, 0x0091bc90),
+     TOBN(0xcf17f9dc, 0x08d1be5d), TOBN(0xb55de4c8, 0xafdfeb23),
+     TOBN(0xa69454ff, 0xe437b29c), TOBN(0x6628d789, 0xe27ee9e2),
+     TOBN(0x56e3b975, 0xee3af03b), TOBN(0x0083fe9c, 0x2f532d62),
+     TOBN(0xcae15213, 0xe63e7511), TOBN(0xdb5384f3, 0x86ed849c),
+     TOBN(0x902ba959, 0xfa4d825f), TOBN(0xbad700d5, 0x5ae17566),
+     TOBN(0x16b2c5dc, 0x14c82eb4), TOBN(0xa4b057a7, 0x36708ea7)}
+};
@@ -7,7 +7,7 @@
  * https://www.openssl.org/source/license.html
  */
 
-#include "internal/cryptlib.h"
+#include "internal/cryptlib_int.h"
 #include <openssl/evp.h>
 #include <openssl/lhash.h>
 #include "eng_int.h"
@@ -26,9 +26,25 @@ struct st_engine_pile {
     int uptodate;
 };
 
+/* Immutable, sorted list of the nids that have an ENGINE registered */
+typedef struct st_engine_table_snapshot ENGINE_TABLE_SNAPSHOT;
+struct st_engine_table_snapshot {
+    int *nids;
+    size_t num;
+    /* Next superseded snapshot, see engine_table_snapshot() */
+    ENGINE_TABLE_SNAPSHOT *next;
+};
+
 /* The type exposed in eng_int.h */
 struct st_engine_table {
-    LHASH_OF(ENGINE_PILE) piles;
+    LHASH_OF(ENGINE_PILE) *piles;
+    /*
+     * Snapshot of 'piles' for lookups without global_engine_lock, NULL if
+     * it couldn't be built.
+     */
+    ENGINE_TABLE_SNAPSHOT *snapshot;
+    /* Superseded snapshots which lock-free readers may still be using */
+    ENGINE_TABLE_SNAPSHOT *retired;
 };                              /* ENGINE_TABLE */
 
 typedef struct st_engine_pile_doall {
@@ -63,18 +79,97 @@ static int engine_pile_cmp(const ENGINE_PILE *a, const ENGINE_PILE *b)
 
 static int int_table_check(ENGINE_TABLE **t, int create)
 {
-    LHASH_OF(ENGINE_PILE) *lh;
+    ENGINE_TABLE *table;
 
     if (*t)
         return 1;
     if (!create)
         return 0;
-    if ((lh = lh_ENGINE_PILE_new(engine_pile_hash, engine_pile_cmp)) == NULL)
+    if ((table = OPENSSL_zalloc(sizeof(*table))) == NULL)
+        return 0;
+    table->piles = lh_ENGINE_PILE_new(engine_pile_hash, engine_pile_cmp);
+    if (table->piles == NULL) {
+        OPENSSL_free(table);
         return 0;
-    *t = (ENGINE_TABLE *)lh;
+    }
+    crypto_atomic_store_ptr((void **)t, table);
     return 1;
 }
 
+static int int_nid_cmp(const void *a, const void *b)
+{
+    return *(const int *)a - *(const int *)b;
+}
+
+static void int_snapshot_cb(const ENGINE_PILE *pile,
+                            ENGINE_TABLE_SNAPSHOT *snap)
+{
+    if (sk_ENGINE_num(pile->sk) > 0 || pile->funct != NULL)
+        snap->nids[snap->num++] = pile->nid;
+}
+
+IMPLEMENT_LHASH_DOALL_ARG_CONST(ENGINE_PILE, ENGINE_TABLE_SNAPSHOT);
+
+static void engine_snapshot_free(ENGINE_TABLE_SNAPSHOT *snap)
+{
+    ENGINE_TABLE_SNAPSHOT *next;
+
+    for (; snap != NULL; snap = next) {
+        next = snap->next;
+        OPENSSL_free(snap->nids);
+        OPENSSL_free(snap);
+    }
+}
+
+/*
+ * Publish a new snapshot of |table| after its piles have changed. Called with
+ * global_engine_lock held for writing. If memory runs out the snapshot is
+ * cleared, which makes engine_table_select() fall back to the locked lookup.
+ * Readers may still hold the old snapshot, so it is only freed along with the
+ * table in engine_table_cleanup().
+ */
+static void engine_table_snapshot(ENGINE_TABLE *table)
+{
+    ENGINE_TABLE_SNAPSHOT *old = table->snapshot, *snap;
+    size_t num = lh_ENGINE_PILE_num_items(table->piles);
+
+    snap = OPENSSL_zalloc(sizeof(*snap));
+    if (snap != NULL && num > 0) {
+        snap->nids = OPENSSL_malloc(num * sizeof(*snap->nids));
+        if (snap->nids == NULL) {
+            OPENSSL_free(snap);
+            snap = NULL;
+        }
+    }
+    if (snap != NULL) {
+        lh_ENGINE_PILE_doall_ENGINE_TABLE_SNAPSHOT(table->piles,
+                                                   int_snapshot_cb, snap);
+        if (snap->num > 1)
+            qsort(snap->nids, snap->num, sizeof(*snap->nids), int_nid_cmp);
+    }
+    crypto_atomic_store_ptr((void **)&table->snapshot, snap);
+    if (old != NULL) {
+        old->next = table->retired;
+        table->retired = old;
+    }
+}
+
+static int engine_snapshot_has_nid(const ENGINE_TABLE_SNAPSHOT *snap, int nid)
+{
+    size_t lo = 0, hi = snap->num, mid;
+
+    while (lo < hi) {
+        mid = lo + (hi - lo) / 2;
+        if (snap->nids[mid] == nid)
+            return 1;
+        if (snap->nids[mid] < nid)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return 0;
+}
+
 /*
  * Privately exposed (via eng_int.h) functions for adding and/or removing
  * ENGINEs from the implementation table
@@ -95,7 +190,7 @@ int engine_table_register(ENGINE_TABLE **table, ENGINE_CLEANUP_CB *cleanup,
         engine_cleanup_add_first(cleanup);
     while (num_nids--) {
         tmplate.nid = *nids;
-        fnd = lh_ENGINE_PILE_retrieve(&(*table)->piles, &tmplate);
+        fnd = lh_ENGINE_PILE_retrieve((*table)->piles, &tmplate);
         if (!fnd) {
             fnd = OPENSSL_malloc(sizeof(*fnd));
             if (fnd == NULL)
@@ -108,7 +203,7 @@ int engine_table_register(ENGINE_TABLE **table, ENGINE_CLEANUP_CB *cleanup,
                 goto end;
             }
             fnd->funct = NULL;
-            (void)lh_ENGINE_PILE_insert(&(*table)->piles, fnd);
+            (void)lh_ENGINE_PILE_insert((*table)->piles, fnd);
         }
         /* A registration shouldn't add duplicate entries */
         (void)sk_ENGINE_delete_ptr(fnd->sk, e);
@@ -134,6 +229,8 @@ int engine_table_register(ENGINE_TABLE **table, ENGINE_CLEANUP_CB *cleanup,
     }
     ret = 1;
  end:
+    if (*table)
+        engine_table_snapshot(*table);
     CRYPTO_THREAD_unlock(global_engine_lock);
     return ret;
 }
@@ -157,8 +254,10 @@ IMPLEMENT_LHASH_DOALL_ARG(ENGINE_PILE, ENGINE);
 void engine_table_unregister(ENGINE_TABLE **table, ENGINE *e)
 {
     CRYPTO_THREAD_write_lock(global_engine_lock);
-    if (int_table_check(table, 0))
-        lh_ENGINE_PILE_doall_ENGINE(&(*table)->piles, int_unregister_cb, e);
+    if (int_table_check(table, 0)) {
+        lh_ENGINE_PILE_doall_ENGINE((*table)->piles, int_unregister_cb, e);
+        engine_table_snapshot(*table);
+    }
     CRYPTO_THREAD_unlock(global_engine_lock);
 }
 
@@ -172,13 +271,24 @@ static void int_cleanup_cb_doall(ENGINE_PILE *p)
     OPENSSL_free(p);
 }
 
+/*
+ * Only called from engine_cleanup_int() when the library is shut down, by
+ * which time no other thread may be looking up ENGINEs. This is what keeps
+ * the table and its snapshots alive for the lock-free readers in
+ * engine_table_select().
+ */
 void engine_table_cleanup(ENGINE_TABLE **table)
 {
+    ENGINE_TABLE *t;
+
     CRYPTO_THREAD_write_lock(global_engine_lock);
-    if (*table) {
-        lh_ENGINE_PILE_doall(&(*table)->piles, int_cleanup_cb_doall);
-        lh_ENGINE_PILE_free(&(*table)->piles);
-        *table = NULL;
+    if ((t = *table) != NULL) {
+        crypto_atomic_store_ptr((void **)table, NULL);
+        lh_ENGINE_PILE_doall(t->piles, int_cleanup_cb_doall);
+        lh_ENGINE_PILE_free(t->piles);
+        engine_snapshot_free(t->snapshot);
+        engine_snapshot_free(t->retired);
+        OPENSSL_free(t);
     }
     CRYPTO_THREAD_unlock(global_engine_lock);
 }
@@ -193,12 +303,34 @@ ENGINE *engine_table_select_tmp(ENGINE_TABLE **table, int nid, const char *f,
 {
     ENGINE *ret = NULL;
     ENGINE_PILE tmplate, *fnd = NULL;
+    ENGINE_TABLE *t = NULL;
+    ENGINE_TABLE_SNAPSHOT *snap = NULL;
     int initres, loop = 0;
 
-    if (!(*table)) {
+    /*
+     * global_engine_lock doesn't exist until something has been registered,
+     * so check for that before crypto_atomic_load_ptr() may need the lock.
+     */
+    if (!int_table_check(table, 0)
+            || !crypto_atomic_load_ptr((void **)table, (void **)&t,
+                                       global_engine_lock)
+            || t == NULL) {
 #ifdef ENGINE_TABLE_DEBUG
         fprintf(stderr, "engine_table_dbg: %s:%d, nid=%d, nothing "
                 "registered!\n", f, l, nid);
+#endif
+        return NULL;
+    }
+    /*
+     * Most lookups are for algorithms that no ENGINE implements: answer those
+     * from the snapshot without taking global_engine_lock at all.
+     */
+    if (crypto_atomic_load_ptr((void **)&t->snapshot, (void **)&snap,
+                               global_engine_lock)
+            && snap != NULL && !engine_snapshot_has_nid(snap, nid)) {
+#ifdef ENGINE_TABLE_DEBUG
+        fprintf(stderr, "engine_table_dbg: %s:%d, nid=%d, nothing "
+                "registered for nid!\n", f, l, nid);
 #endif
         return NULL;
     }
@@ -211,7 +343,7 @@ ENGINE *engine_table_select_tmp(ENGINE_TABLE **table, int nid, const char *f,
     if (!int_table_check(table, 0))
         goto end;
     tmplate.nid = nid;
-    fnd = lh_ENGINE_PILE_retrieve(&(*table)->piles, &tmplate);
+    fnd = lh_ENGINE_PILE_retrieve((*table)->piles, &tmplate);
     if (!fnd)
         goto end;
     if (fnd->funct && engine_unlocked_init(fnd->funct)) {
@@ -299,5 +431,5 @@ void engine_table_doall(ENGINE_TABLE *table, engine_table_doall_cb *cb,
     dall.cb = cb;
     dall.arg = arg;
     if (table)
-        lh_ENGINE_PILE_doall_ENGINE_PILE_DOALL(&table->piles, int_dall, &dall);
+        lh_ENGINE_PILE_doall_ENGINE_PILE_DOALL(table->piles, int_dall, &dall);
 }
@@ -187,6 +187,24 @@ int EVP_MD_CTX_copy_ex(EVP_MD_CTX *out, const EVP_MD_CTX *in)
         EVPerr(EVP_F_EVP_MD_CTX_COPY_EX, EVP_R_INPUT_NOT_INITIALIZED);
         return 0;
     }
+
+    /*
+     * Restoring a saved state into a context that is already set up for the
+     * same digest only needs the state copied: |out| keeps its buffer and its
+     * ENGINE reference. Digests with their own copy or cleanup functions, or
+     * contexts with a pkey context, take the full path below.
+     */
+    if (out->digest == in->digest && out->engine == in->engine
+            && out->md_data != NULL && in->md_data != NULL
+            && out->pctx == NULL && in->pctx == NULL
+            && in->digest->copy == NULL && in->digest->cleanup == NULL
+            && !EVP_MD_CTX_test_flags(out, EVP_MD_CTX_FLAG_REUSE)) {
+        memcpy(out->md_data, in->md_data, in->digest->ctx_size);
+        out->flags = in->flags;
+        out->update = in->update;
+        return 1;
+    }
+
 #ifndef OPENSSL_NO_ENGINE
     /* Make sure it's safe to copy a digest context using an ENGINE */
     if (in->engine && !ENGINE_init(in->engine)) {
@@ -239,13 +257,73 @@ int EVP_MD_CTX_copy_ex(EVP_MD_CTX *out, const EVP_MD_CTX *in)
     return 1;
 }
 
+/* Large enough for the state of all built-in digests */
+#define EVP_ONESHOT_MD_DATA_SIZE 512
+
+int evp_digest_oneshot(const EVP_MD *type, const unsigned char *const data[],
+                       const size_t len[], size_t num, unsigned char *md,
+                       unsigned int *size)
+{
+    EVP_MD_CTX ctx;
+    union {
+        double align;
+        uint64_t align64;
+        void *alignp;
+        unsigned char buf[EVP_ONESHOT_MD_DATA_SIZE];
+    } md_data;
+    size_t i;
+    int ret;
+#ifndef OPENSSL_NO_ENGINE
+    ENGINE *e;
+#endif
+
+    if (type->ctx_size > (int)sizeof(md_data) || type->cleanup != NULL
+            || type->init == NULL)
+        return -1;
+#ifndef OPENSSL_NO_ENGINE
+    /* Same lookup as EVP_DigestInit_ex(), ENGINE implementations need a ctx */
+    if ((e = ENGINE_get_digest_engine(type->type)) != NULL) {
+        ENGINE_finish(e);
+        return -1;
+    }
+#endif
+
+    memset(&ctx, 0, sizeof(ctx));
+    ctx.digest = type;
+    ctx.flags = EVP_MD_CTX_FLAG_ONESHOT;
+    ctx.md_data = md_data.buf;
+    ctx.update = type->update;
+    memset(md_data.buf, 0, type->ctx_size);
+
+    ret = type->init(&ctx);
+    for (i = 0; ret && i < num; i++)
+        ret = ctx.update(&ctx, data[i], len[i]);
+    if (ret) {
+        OPENSSL_assert(type->md_size <= EVP_MAX_MD_SIZE);
+        ret = type->final(&ctx, md);
+        if (size != NULL)
+            *size = type->md_size;
+    }
+    OPENSSL_cleanse(md_data.buf, type->ctx_size);
+    return ret ? 1 : 0;
+}
+
 int EVP_Digest(const void *data, size_t count,
                unsigned char *md, unsigned int *size, const EVP_MD *type,
                ENGINE *impl)
 {
-    EVP_MD_CTX *ctx = EVP_MD_CTX_new();
+    EVP_MD_CTX *ctx;
     int ret;
 
+    if (impl == NULL) {
+        const unsigned char *const in[1] = { data };
+
+        ret = evp_digest_oneshot(type, in, &count, 1, md, size);
+        if (ret >= 0)
+            return ret;
+    }
+
+    ctx = EVP_MD_CTX_new();
     if (ctx == NULL)
         return 0;
     EVP_MD_CTX_set_flags(ctx, EVP_MD_CTX_FLAG_ONESHOT);
@@ -1238,22 +1238,105 @@ static int aes_cfb1_cipher(EVP_CIPHER_CTX *ctx, unsigned char *out,
     return 1;
 }
 
+static void aes_ctr_stream(const EVP_AES_KEY *dat, unsigned char *out,
+                           const unsigned char *in, size_t len,
+                           unsigned char *iv, unsigned char *buf,
+                           unsigned int *num)
+{
+    if (dat->stream.ctr)
+        CRYPTO_ctr128_encrypt_ctr32(in, out, len, &dat->ks, iv, buf, num,
+                                    dat->stream.ctr);
+    else
+        CRYPTO_ctr128_encrypt(in, out, len, &dat->ks, iv, buf, num,
+                              dat->block);
+}
+
+/* add |blocks| to the 128-bit big-endian counter |ctr| */
+static void ctr128_add(unsigned char *ctr, size_t blocks)
+{
+    size_t c = blocks;
+    int n = 16;
+
+    while (c != 0 && n > 0) {
+        --n;
+        c += ctr[n];
+        ctr[n] = (unsigned char)c;
+        c >>= 8;
+    }
+}
+
+typedef struct {
+    const EVP_AES_KEY *dat;
+    const unsigned char *in;
+    unsigned char *out;
+    size_t len;
+    unsigned char iv[16];
+} AES_CTR_TASK;
+
+static void aes_ctr_task(void *arg)
+{
+    AES_CTR_TASK *t = arg;
+    unsigned char buf[16];
+    unsigned int num = 0;
+
+    aes_ctr_stream(t->dat, t->out, t->in, t->len, t->iv, buf, &num);
+    OPENSSL_cleanse(buf, sizeof(buf));
+}
+
+/*
+ * Encrypt |n| chunks of whole blocks on the thread pool of |ctx|, each task
+ * starting from its own counter value.
+ */
+static int aes_ctr_tasks(EVP_CIPHER_CTX *ctx, const EVP_AES_KEY *dat,
+                         unsigned char *out, const unsigned char *in,
+                         size_t len, size_t n, size_t chunk)
+{
+    unsigned char *iv = EVP_CIPHER_CTX_iv_noconst(ctx);
+    AES_CTR_TASK *t;
+    size_t i;
+    int ret;
+
+    t = OPENSSL_malloc(n * sizeof(*t));
+    if (t == NULL) {
+        EVPerr(EVP_F_AES_CTR_TASKS, ERR_R_MALLOC_FAILURE);
+        return 0;
+    }
+    for (i = 0; i < n; i++) {
+        t[i].dat = dat;
+        t[i].in = in + i * chunk;
+        t[i].out = out + i * chunk;
+        t[i].len = i + 1 < n ? chunk : len - i * chunk;
+        memcpy(t[i].iv, iv, 16);
+        ctr128_add(t[i].iv, i * (chunk / 16));
+    }
+    ret = evp_cipher_ctx_run_tasks(ctx, aes_ctr_task, t, sizeof(*t), n);
+    OPENSSL_free(t);
+    if (ret)
+        ctr128_add(iv, len / 16);
+    return ret;
+}
+
 static int aes_ctr_cipher(EVP_CIPHER_CTX *ctx, unsigned char *out,
                           const unsigned char *in, size_t len)
 {
     unsigned int num = EVP_CIPHER_CTX_num(ctx);
     EVP_AES_KEY *dat = EVP_C_DATA(EVP_AES_KEY,ctx);
-
-    if (dat->stream.ctr)
-        CRYPTO_ctr128_encrypt_ctr32(in, out, len, &dat->ks,
-                                    EVP_CIPHER_CTX_iv_noconst(ctx),
-                                    EVP_CIPHER_CTX_buf_noconst(ctx),
-                                    &num, dat->stream.ctr);
-    else
-        CRYPTO_ctr128_encrypt(in, out, len, &dat->ks,
-                              EVP_CIPHER_CTX_iv_noconst(ctx),
-                              EVP_CIPHER_CTX_buf_noconst(ctx), &num,
-                              dat->block);
+    unsigned char *iv = EVP_CIPHER_CTX_iv_noconst(ctx);
+    unsigned char *buf = EVP_CIPHER_CTX_buf_noconst(ctx);
+    size_t res = (16 - num) % 16, bulk, chunk, n;
+
+    if (len > res
+        && (n = evp_cipher_ctx_split(ctx, bulk = (len - res) & ~(size_t)15,
+                                     &chunk)) != 0) {
+        /* Use up the current key stream block, the rest is split up */
+        aes_ctr_stream(dat, out, in, res, iv, buf, &num);
+        if (!aes_ctr_tasks(ctx, dat, out + res, in + res, bulk, n, chunk))
+            return 0;
+        in += res + bulk;
+        out += res + bulk;
+        len -= res + bulk;
+    }
+    aes_ctr_stream(dat, out, in, len, iv, buf, &num);
     EVP_CIPHER_CTX_set_num(ctx, num);
     return 1;
 }
@@ -1626,6 +1709,164 @@ static int aes_gcm_tls_cipher(EVP_CIPHER_CTX *ctx, unsigned char *out,
     return rv;
 }
 
+/*
+ * Process |len| bytes of text on |gcm|, which is either the context of
+ * |gctx| or a copy of it made for one task. Returns 0 on success.
+ */
+static int aes_gcm_text(EVP_AES_GCM_CTX *gctx, GCM128_CONTEXT *gcm, int enc,
+                        unsigned char *out, const unsigned char *in,
+                        size_t len)
+{
+    if (enc) {
+        if (gctx->ctr) {
+            size_t bulk = 0;
+#if defined(AES_GCM_ASM)
+            if (len >= 32 && AES_GCM_ASM(gctx)) {
+                size_t res = (16 - gcm->mres) % 16;
+
+                if (CRYPTO_gcm128_encrypt(gcm, in, out, res))
+                    return -1;
+
+                bulk = AES_gcm_encrypt(in + res,
+                                       out + res, len - res,
+                                       gcm->key, gcm->Yi.c,
+                                       gcm->Xi.u);
+                gcm->len.u[1] += bulk;
+                bulk += res;
+            }
+#endif
+            if (CRYPTO_gcm128_encrypt_ctr32(gcm,
+                                            in + bulk,
+                                            out + bulk,
+                                            len - bulk, gctx->ctr))
+                return -1;
+        } else {
+            size_t bulk = 0;
+#if defined(AES_GCM_ASM2)
+            if (len >= 32 && AES_GCM_ASM2(gctx)) {
+                size_t res = (16 - gcm->mres) % 16;
+
+                if (CRYPTO_gcm128_encrypt(gcm, in, out, res))
+                    return -1;
+
+                bulk = AES_gcm_encrypt(in + res,
+                                       out + res, len - res,
+                                       gcm->key, gcm->Yi.c,
+                                       gcm->Xi.u);
+                gcm->len.u[1] += bulk;
+                bulk += res;
+            }
+#endif
+            if (CRYPTO_gcm128_encrypt(gcm,
+                                      in + bulk, out + bulk, len - bulk))
+                return -1;
+        }
+    } else {
+        if (gctx->ctr) {
+            size_t bulk = 0;
+#if defined(AES_GCM_ASM)
+            if (len >= 16 && AES_GCM_ASM(gctx)) {
+                size_t res = (16 - gcm->mres) % 16;
+
+                if (CRYPTO_gcm128_decrypt(gcm, in, out, res))
+                    return -1;
+
+                bulk = AES_gcm_decrypt(in + res,
+                                       out + res, len - res,
+                                       gcm->key,
+                                       gcm->Yi.c, gcm->Xi.u);
+                gcm->len.u[1] += bulk;
+                bulk += res;
+            }
+#endif
+            if (CRYPTO_gcm128_decrypt_ctr32(gcm,
+                                            in + bulk,
+                                            out + bulk,
+                                            len - bulk, gctx->ctr))
+                return -1;
+        } else {
+            size_t bulk = 0;
+#if defined(AES_GCM_ASM2)
+            if (len >= 16 && AES_GCM_ASM2(gctx)) {
+                size_t res = (16 - gcm->mres) % 16;
+
+                if (CRYPTO_gcm128_decrypt(gcm, in, out, res))
+                    return -1;
+
+                bulk = AES_gcm_decrypt(in + res,
+                                       out + res, len - res,
+                                       gcm->key,
+                                       gcm->Yi.c, gcm->Xi.u);
+                gcm->len.u[1] += bulk;
+                bulk += res;
+            }
+#endif
+            if (CRYPTO_gcm128_decrypt(gcm,
+                                      in + bulk, out + bulk, len - bulk))
+                return -1;
+        }
+    }
+
+    return 0;
+}
+
+typedef struct {
+    EVP_AES_GCM_CTX *gctx;
+    GCM128_CONTEXT gcm;
+    int enc;
+    unsigned char *out;
+    const unsigned char *in;
+    size_t len;
+    int ret;
+} AES_GCM_TASK;
+
+static void aes_gcm_task(void *arg)
+{
+    AES_GCM_TASK *t = arg;
+
+    t->ret = aes_gcm_text(t->gctx, &t->gcm, t->enc, t->out, t->in, t->len);
+}
+
+/*
+ * Process |n| chunks of whole blocks on the thread pool of |ctx|. Each task
+ * works on its own fork of the GCM context, their hashes are combined in
+ * order afterwards.
+ */
+static int aes_gcm_tasks(EVP_CIPHER_CTX *ctx, EVP_AES_GCM_CTX *gctx, int enc,
+                         unsigned char *out, const unsigned char *in,
+                         size_t len, size_t n, size_t chunk)
+{
+    AES_GCM_TASK *t;
+    size_t i;
+    int ret = 0;
+
+    t = OPENSSL_malloc(n * sizeof(*t));
+    if (t == NULL) {
+        EVPerr(EVP_F_AES_GCM_TASKS, ERR_R_MALLOC_FAILURE);
+        return 0;
+    }
+    for (i = 0; i < n; i++) {
+        if (CRYPTO_gcm128_fork(&gctx->gcm, &t[i].gcm, i * chunk))
+            goto err;
+        t[i].gctx = gctx;
+        t[i].enc = enc;
+        t[i].out = out + i * chunk;
+        t[i].in = in + i * chunk;
+        t[i].len = i + 1 < n ? chunk : len - i * chunk;
+        t[i].ret = -1;
+    }
+    if (!evp_cipher_ctx_run_tasks(ctx, aes_gcm_task, t, sizeof(*t), n))
+        goto err;
+    for (i = 0; i < n; i++) {
+        if (t[i].ret || CRYPTO_gcm128_join(&gctx->gcm, &t[i].gcm))
+            goto err;
+    }
+    ret = 1;
+ err:
+    OPENSSL_clear_free(t, n * sizeof(*t));
+    return ret;
+}
+
 static int aes_gcm_cipher(EVP_CIPHER_CTX *ctx, unsigned char *out,
                           const unsigned char *in, size_t len)
 {
@@ -1643,93 +1884,23 @@ static int aes_gcm_cipher(EVP_CIPHER_CTX *ctx, unsigned char *out,
         if (out == NULL) {
             if (CRYPTO_gcm128_aad(&gctx->gcm, in, len))
                 return -1;
-        } else if (EVP_CIPHER_CTX_encrypting(ctx)) {
-            if (gctx->ctr) {
-                size_t bulk = 0;
-#if defined(AES_GCM_ASM)
-                if (len >= 32 && AES_GCM_ASM(gctx)) {
-                    size_t res = (16 - gctx->gcm.mres) % 16;
-
-                    if (CRYPTO_gcm128_encrypt(&gctx->gcm, in, out, res))
-                        return -1;
-
-                    bulk = AES_gcm_encrypt(in + res,
-                                           out + res, len - res,
-                                           gctx->gcm.key, gctx->gcm.Yi.c,
-                                           gctx->gcm.Xi.u);
-                    gctx->gcm.len.u[1] += bulk;
-                    bulk += res;
-                }
-#endif
-                if (CRYPTO_gcm128_encrypt_ctr32(&gctx->gcm,
-                                                in + bulk,
-                                                out + bulk,
-                                                len - bulk, gctx->ctr))
-                    return -1;
-            } else {
-                size_t bulk = 0;
-#if defined(AES_GCM_ASM2)
-                if (len >= 32 && AES_GCM_ASM2(gctx)) {
-                    size_t res = (16 - gctx->gcm.mres) % 16;
-
-                    if (CRYPTO_gcm128_encrypt(&gctx->gcm, in, out, res))
-                        return -1;
-
-                    bulk = AES_gcm_encrypt(in + res,
-                                           out + res, len - res,
-                                           gctx->gcm.key, gctx->gcm.Yi.c,
-                                           gctx->gcm.Xi.u);
-                    gctx->gcm.len.u[1] += bulk;
-                    bulk += res;
-                }
-#endif
-                if (CRYPTO_gcm128_encrypt(&gctx->gcm,
-                                          in + bulk, out + bulk, len - bulk))
-                    return -1;
-            }
         } else {
-            if (gctx->ctr) {
-                size_t bulk = 0;
-#if defined(AES_GCM_ASM)
-                if (len >= 16 && AES_GCM_ASM(gctx)) {
-                    size_t res = (16 - gctx->gcm.mres) % 16;
-
-                    if (CRYPTO_gcm128_decrypt(&gctx->gcm, in, out, res))
-                        return -1;
-
-                    bulk = AES_gcm_decrypt(in + res,
-                                           out + res, len - res,
-                                           gctx->gcm.key,
-                                           gctx->gcm.Yi.c, gctx->gcm.Xi.u);
-                    gctx->gcm.len.u[1] += bulk;
-                    bulk += res;
-                }
-#endif
-                if (CRYPTO_gcm128_decrypt_ctr32(&gctx->gcm,
-                                                in + bulk,
-                                                out + bulk,
-                                                len - bulk, gctx->ctr))
-                    return -1;
-            } else {
-                size_t bulk = 0;
-#if defined(AES_GCM_ASM2)
-                if (len >= 16 && AES_GCM_ASM2(gctx)) {
-                    size_t res = (16 - gctx->gcm.mres) % 16;
-
-                    if (CRYPTO_gcm128_decrypt(&gctx->gcm, in, out, res))
-                        return -1;
-
-                    bulk = AES_gcm_decrypt(in + res,
-                                           out + res, len - res,
-                                           gctx->gcm.key,
-                                           gctx->gcm.Yi.c, gctx->gcm.Xi.u);
-                    gctx->gcm.len.u[1] += bulk;
-                    bulk += res;
-                }
-#endif
-                if (CRYPTO_gcm128_decrypt(&gctx->gcm,
-                                          in + bulk, out + bulk, len - bulk))
+            int enc = EVP_CIPHER_CTX_encrypting(ctx);
+            size_t res = (16 - gctx->gcm.mres) % 16, bulk, chunk, n;
+
+            if (len > res
+                && (n = evp_cipher_ctx_split(ctx,
+                                             bulk = (len - res) & ~(size_t)15,
+                                             &chunk)) != 0) {
+                /* Complete the current block, the rest is split up */
+                if (aes_gcm_text(gctx, &gctx->gcm, enc, out, in, res)
+                    || !aes_gcm_tasks(ctx, gctx, enc, out + res, in + res,
+                                      bulk, n, chunk)
+                    || aes_gcm_text(gctx, &gctx->gcm, enc, out + res + bulk,
+                                    in + res + bulk, len - res - bulk))
                     return -1;
+            } else if (aes_gcm_text(gctx, &gctx->gcm, enc, out, in, len)) {
+                return -1;
             }
         }
         return len;
@@ -2672,3 +2843,284 @@ BLOCK_CIPHER_custom(NID_aes, 192, 16, 12, ocb, OCB,
 BLOCK_CIPHER_custom(NID_aes, 256, 16, 12, ocb, OCB,
                     EVP_CIPH_FLAG_AEAD_CIPHER | CUSTOM_FLAGS)
 #endif                         /* OPENSSL_NO_OCB */
+
+/*
+ * AES-GCM-SIV (RFC 8452). Encryption needs the hash of the whole plaintext
+ * before the first byte of ciphertext, so as with CCM the text has to be
+ * passed in a single update. The AAD may be split over several updates.
+ */
+typedef struct {
+    union {
+        double align;
+        AES_KEY ks;
+    } ks;                       /* key generating key */
+    union {
+        double align;
+        AES_KEY ks;
+    } mek;                      /* message encryption key */
+    GCM128_CONTEXT polyval;     /* keyed with the message authentication key */
+    int (*set_key) (const unsigned char *key, int bits, AES_KEY *ks);
+    block128_f block;
+    /* ECB encryption of whole blocks if available */
+    void (*ecb) (const unsigned char *in, unsigned char *out, size_t len,
+                 const AES_KEY *key, int enc);
+    int key_set;                /* Set if key initialised */
+    int iv_set;                 /* Set if the message keys are derived */
+    int tag_set;                /* Set if the tag is valid */
+    int text_done;              /* Set once the text has been processed */
+    u64 aad_len;
+    unsigned char nonce[12];
+    unsigned char tag[16];
+} EVP_AES_GCM_SIV_CTX;
+
+/* Blocks of key stream generated at a time */
+#define GCM_SIV_CTR_BLOCKS      32
+#define GCM_SIV_MAX_LEN         ((u64)1 << 36)
+
+/* Derive the message authentication and encryption keys from the nonce */
+static void aes_gcm_siv_setup(EVP_AES_GCM_SIV_CTX *sctx, int keylen)
+{
+    unsigned char in[16], out[16], keys[48];
+    int i;
+
+    memcpy(in + 4, sctx->nonce, 12);
+    for (i = 0; i < (keylen == 32 ? 6 : 4); i++) {
+        in[0] = (unsigned char)i;
+        in[1] = in[2] = in[3] = 0;
+        sctx->block(in, out, &sctx->ks.ks);
+        memcpy(keys + 8 * i, out, 8);
+    }
+    CRYPTO_polyval128_init(&sctx->polyval, keys);
+    sctx->set_key(keys + 16, keylen * 8, &sctx->mek.ks);
+    OPENSSL_cleanse(keys, sizeof(keys));
+    OPENSSL_cleanse(out, sizeof(out));
+
+    sctx->aad_len = 0;
+    sctx->text_done = 0;
+    sctx->iv_set = 1;
+}
+
+static int aes_gcm_siv_init_key(EVP_CIPHER_CTX *ctx, const unsigned char *key,
+                                const unsigned char *iv, int enc)
+{
+    EVP_AES_GCM_SIV_CTX *sctx = EVP_C_DATA(EVP_AES_GCM_SIV_CTX,ctx);
+
+    if (key != NULL) {
+        do {
+#ifdef AESNI_CAPABLE
+            if (AESNI_CAPABLE) {
+                sctx->set_key = aesni_set_encrypt_key;
+                sctx->block = (block128_f) aesni_encrypt;
+                sctx->ecb = aesni_ecb_encrypt;
+                break;
+            }
+#endif
+#ifdef HWAES_CAPABLE
+            if (HWAES_CAPABLE) {
+                sctx->set_key = HWAES_set_encrypt_key;
+                sctx->block = (block128_f) HWAES_encrypt;
+                sctx->ecb = NULL;
+                break;
+            }
+#endif
+#ifdef VPAES_CAPABLE
+            if (VPAES_CAPABLE) {
+                sctx->set_key = vpaes_set_encrypt_key;
+                sctx->block = (block128_f) vpaes_encrypt;
+                sctx->ecb = NULL;
+                break;
+            }
+#endif
+            sctx->set_key = AES_set_encrypt_key;
+            sctx->block = (block128_f) AES_encrypt;
+            sctx->ecb = NULL;
+        } while (0);
+        sctx->set_key(key, EVP_CIPHER_CTX_key_length(ctx) * 8, &sctx->ks.ks);
+        sctx->key_set = 1;
+    }
+    if (iv != NULL) {
+        memcpy(sctx->nonce, iv, sizeof(sctx->nonce));
+        sctx->iv_set = 0;
+    }
+    if (sctx->key_set && (key != NULL || iv != NULL)
+            && (iv != NULL || sctx->iv_set))
+        aes_gcm_siv_setup(sctx, EVP_CIPHER_CTX_key_length(ctx));
+    return 1;
+}
+
+static int aes_gcm_siv_ctrl(EVP_CIPHER_CTX *c, int type, int arg, void *ptr)
+{
+    EVP_AES_GCM_SIV_CTX *sctx = EVP_C_DATA(EVP_AES_GCM_SIV_CTX,c);
+
+    switch (type) {
+    case EVP_CTRL_INIT:
+        sctx->key_set = 0;
+        sctx->iv_set = 0;
+        sctx->tag_set = 0;
+        sctx->text_done = 0;
+        return 1;
+
+    case EVP_CTRL_AEAD_SET_IVLEN:
+        return arg == 12;
+
+    case EVP_CTRL_AEAD_SET_TAG:
+        if (arg != 16)
+            return 0;
+        if (ptr != NULL) {
+            if (EVP_CIPHER_CTX_encrypting(c))
+                return 0;
+            memcpy(sctx->tag, ptr, 16);
+            sctx->tag_set = 1;
+        }
+        return 1;
+
+    case EVP_CTRL_AEAD_GET_TAG:
+        if (arg <= 0 || arg > 16 || !EVP_CIPHER_CTX_encrypting(c)
+                || !sctx->text_done)
+            return 0;
+        memcpy(ptr, sctx->tag, arg);
+        return 1;
+
+    default:
+        return -1;
+    }
+}
+
+/* CTR mode with the 32-bit little-endian counter of AES-GCM-SIV */
+static void aes_gcm_siv_ctr(EVP_AES_GCM_SIV_CTX *sctx, unsigned char *out,
+                            const unsigned char *in, size_t len)
+{
+    unsigned char ctr[GCM_SIV_CTR_BLOCKS * 16], ks[GCM_SIV_CTR_BLOCKS * 16];
+    u32 c;
+    size_t i, n, blocks, used;
+
+    c = (u32)sctx->tag[0] | (u32)sctx->tag[1] << 8
+        | (u32)sctx->tag[2] << 16 | (u32)sctx->tag[3] << 24;
+    blocks = (len + 15) / 16 < GCM_SIV_CTR_BLOCKS ? (len + 15) / 16
+                                                  : GCM_SIV_CTR_BLOCKS;
+    used = blocks * 16;
+    for (i = 0; i < blocks; i++) {
+        memcpy(ctr + 16 * i + 4, sctx->tag + 4, 12);
+        ctr[16 * i + 15] |= 0x80;
+    }
+
+    while (len > 0) {
+        n = len < sizeof(ks) ? len : sizeof(ks);
+        blocks = (n + 15) / 16;
+        for (i = 0; i < blocks; i++, c++) {
+            ctr[16 * i] = (unsigned char)c;
+            ctr[16 * i + 1] = (unsigned char)(c >> 8);
+            ctr[16 * i + 2] = (unsigned char)(c >> 16);
+            ctr[16 * i + 3] = (unsigned char)(c >> 24);
+        }
+        if (sctx->ecb != NULL) {
+            sctx->ecb(ctr, ks, blocks * 16, &sctx->mek.ks, AES_ENCRYPT);
+        } else {
+            for (i = 0; i < blocks; i++)
+                sctx->block(ctr + 16 * i, ks + 16 * i, &sctx->mek.ks);
+        }
+        for (i = 0; i < n; i++)
+            out[i] = in[i] ^ ks[i];
+        in += n;
+        out += n;
+        len -= n;
+    }
+    OPENSSL_cleanse(ks, used);
+}
+
+/* Hash the lengths and compute the tag of a |len| byte plaintext */
+static void aes_gcm_siv_tag(EVP_AES_GCM_SIV_CTX *sctx, size_t len,
+                            unsigned char tag[16])
+{
+    unsigned char s[16];
+    u64 bits[2];
+    int i;
+
+    bits[0] = sctx->aad_len * 8;
+    bits[1] = (u64)len * 8;
+    for (i = 0; i < 16; i++)
+        s[i] = (unsigned char)(bits[i / 8] >> (8 * (i % 8)));
+    CRYPTO_polyval128_pad(&sctx->polyval);
+    CRYPTO_polyval128_update(&sctx->polyval, s, 16);
+    CRYPTO_polyval128_final(&sctx->polyval, s);
+    for (i = 0; i < 12; i++)
+        s[i] ^= sctx->nonce[i];
+    s[15] &= 0x7f;
+    sctx->block(s, tag, &sctx->mek.ks);
+}
+
+static int aes_gcm_siv_cipher(EVP_CIPHER_CTX *ctx, unsigned char *out,
+                              const unsigned char *in, size_t len)
+{
+    EVP_AES_GCM_SIV_CTX *sctx = EVP_C_DATA(EVP_AES_GCM_SIV_CTX,ctx);
+    int enc = EVP_CIPHER_CTX_encrypting(ctx);
+    unsigned char tag[16];
+
+    if (!sctx->key_set || !sctx->iv_set)
+        return -1;
+
+    if (in != NULL && out == NULL) {
+        if (sctx->text_done || len > GCM_SIV_MAX_LEN - sctx->aad_len)
+            return -1;
+        CRYPTO_polyval128_update(&sctx->polyval, in, len);
+        sctx->aad_len += len;
+        return len;
+    }
+
+    if (in == NULL) {
+        /* Final: a message with no text only authenticates the AAD */
+        if (!sctx->text_done) {
+            if (!enc && !sctx->tag_set)
+                return -1;
+            aes_gcm_siv_tag(sctx, 0, tag);
+            sctx->text_done = 1;
+            if (enc)
+                memcpy(sctx->tag, tag, 16);
+            else if (CRYPTO_memcmp(tag, sctx->tag, 16) != 0)
+                return -1;
+        }
+        sctx->iv_set = 0;
+        return 0;
+    }
+
+    if (sctx->text_done || (u64)len > GCM_SIV_MAX_LEN)
+        return -1;
+    sctx->text_done = 1;
+    CRYPTO_polyval128_pad(&sctx->polyval);
+    if (enc) {
+        CRYPTO_polyval128_update(&sctx->polyval, in, len);
+        aes_gcm_siv_tag(sctx, len, sctx->tag);
+        aes_gcm_siv_ctr(sctx, out, in, len);
+    } else {
+        if (!sctx->tag_set)
+            return -1;
+        aes_gcm_siv_ctr(sctx, out, in, len);
+        CRYPTO_polyval128_update(&sctx->polyval, out, len);
+        aes_gcm_siv_tag(sctx, len, tag);
+        if (CRYPTO_memcmp(tag, sctx->tag, 16) != 0) {
+            OPENSSL_cleanse(out, len);
+            sctx->iv_set = 0;
+            return -1;
+        }
+    }
+    return len;
+}
+
+#define GCM_SIV_FLAGS   (EVP_CIPH_FLAG_AEAD_CIPHER | EVP_CIPH_CUSTOM_IV \
+                | EVP_CIPH_FLAG_CUSTOM_CIPHER | EVP_CIPH_ALWAYS_CALL_INIT \
+                | EVP_CIPH_CTRL_INIT | EVP_CIPH_GCM_SIV_MODE)
+
+#define BLOCK_CIPHER_gcm_siv(keylen) \
+static const EVP_CIPHER aes_##keylen##_gcm_siv = { \
+        NID_aes_##keylen##_gcm_siv, 1, keylen / 8, 12, \
+        GCM_SIV_FLAGS, \
+        aes_gcm_siv_init_key, \
+        aes_gcm_siv_cipher, \
+        NULL, \
+        sizeof(EVP_AES_GCM_SIV_CTX), \
+        NULL, NULL, aes_gcm_siv_ctrl, NULL }; \
+const EVP_CIPHER *EVP_aes_##keylen##_gcm_siv(void) \
+{ return &aes_##keylen##_gcm_siv; }
+
+BLOCK_CIPHER_gcm_siv(128)
+BLOCK_CIPHER_gcm_siv(256)
@@ -159,6 +159,23 @@ typedef struct {
 #  define aead_data(ctx)        ((EVP_CHACHA_AEAD_CTX *)(ctx)->cipher_data)
 #  define POLY1305_ctx(actx)    ((POLY1305 *)(actx + 1))
 
+#  if defined(POLY1305_ASM) && (defined(__x86_64) || defined(__x86_64__) || \
+                                defined(_M_AMD64) || defined(_M_X64))
+/*
+ * Encrypt or decrypt a leading part of |inp| and hash the ciphertext into
+ * the Poly1305 state in the same pass over the data. The state is passed
+ * as the POLY1305 context, which starts with it. Return the number of
+ * bytes done, possibly none, the rest is left to the caller.
+ */
+size_t ChaCha20_Poly1305_seal(unsigned char *out, const unsigned char *inp,
+                              size_t len, const unsigned int key[8],
+                              const unsigned int counter[4], void *poly1305);
+size_t ChaCha20_Poly1305_open(unsigned char *out, const unsigned char *inp,
+                              size_t len, const unsigned int key[8],
+                              const unsigned int counter[4], void *poly1305);
+#   define CHACHA20_POLY1305_STITCH
+#  endif
+
 static int chacha20_poly1305_init_key(EVP_CIPHER_CTX *ctx,
                                       const unsigned char *inkey,
                                       const unsigned char *iv, int enc)
@@ -193,11 +210,42 @@ static int chacha20_poly1305_init_key(EVP_CIPHER_CTX *ctx,
     return 1;
 }
 
+/*
+ * Process as much of the |len| bytes of text as the stitched code can do
+ * in one pass, and return the number of bytes done. That is only possible
+ * at the start of a ChaCha20 block, with no Poly1305 input buffered, and
+ * when the 32-bit block counter doesn't wrap.
+ */
+static size_t chacha20_poly1305_stitch(EVP_CIPHER_CTX *ctx, unsigned char *out,
+                                       const unsigned char *in, size_t len)
+{
+#  ifdef CHACHA20_POLY1305_STITCH
+    EVP_CHACHA_AEAD_CTX *actx = aead_data(ctx);
+    size_t done;
+
+    if (actx->key.partial_len != 0
+            || actx->len.text % POLY1305_BLOCK_SIZE != 0
+            || len / CHACHA_BLK_SIZE > 0xffffffffU - actx->key.counter[0])
+        return 0;
+
+    if (ctx->encrypt)
+        done = ChaCha20_Poly1305_seal(out, in, len, actx->key.key.d,
+                                      actx->key.counter, POLY1305_ctx(actx));
+    else
+        done = ChaCha20_Poly1305_open(out, in, len, actx->key.key.d,
+                                      actx->key.counter, POLY1305_ctx(actx));
+    actx->key.counter[0] += (unsigned int)(done / CHACHA_BLK_SIZE);
+    return done;
+#  else
+    return 0;
+#  endif
+}
+
 static int chacha20_poly1305_cipher(EVP_CIPHER_CTX *ctx, unsigned char *out,
                                     const unsigned char *in, size_t len)
 {
     EVP_CHACHA_AEAD_CTX *actx = aead_data(ctx);
-    size_t rem, plen = actx->tls_payload_length;
+    size_t rem, done, plen = actx->tls_payload_length;
     static const unsigned char zero[POLY1305_BLOCK_SIZE] = { 0 };
 
     if (!actx->mac_inited) {
@@ -232,15 +280,16 @@ static int chacha20_poly1305_cipher(EVP_CIPHER_CTX *ctx, unsigned char *out,
             else if (len != plen + POLY1305_BLOCK_SIZE)
                 return -1;
 
+            done = chacha20_poly1305_stitch(ctx, out, in, plen);
             if (ctx->encrypt) {                 /* plaintext */
-                chacha_cipher(ctx, out, in, plen);
-                Poly1305_Update(POLY1305_ctx(actx), out, plen);
+                chacha_cipher(ctx, out + done, in + done, plen - done);
+                Poly1305_Update(POLY1305_ctx(actx), out + done, plen - done);
                 in += plen;
                 out += plen;
                 actx->len.text += plen;
             } else {                            /* ciphertext */
-                Poly1305_Update(POLY1305_ctx(actx), in, plen);
-                chacha_cipher(ctx, out, in, plen);
+                Poly1305_Update(POLY1305_ctx(actx), in + done, plen - done);
+                chacha_cipher(ctx, out + done, in + done, plen - done);
                 in += plen;
                 out += plen;
                 actx->len.text += plen;
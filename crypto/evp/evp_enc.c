@@ -10,6 +10,7 @@
 #include <stdio.h>
 #include <assert.h>
 #include "internal/cryptlib.h"
+#include "internal/cryptlib_int.h"
 #include <openssl/evp.h>
 #include <openssl/err.h>
 #include <openssl/rand.h>
@@ -84,10 +85,17 @@ int EVP_CipherInit_ex(EVP_CIPHER_CTX *ctx, const EVP_CIPHER *cipher,
          */
         if (ctx->cipher) {
             unsigned long flags = ctx->flags;
+            CRYPTO_RUN_TASKS *run_tasks = ctx->run_tasks;
+            void *pool = ctx->pool;
+            size_t chunk = ctx->chunk;
+
             EVP_CIPHER_CTX_reset(ctx);
-            /* Restore encrypt and flags */
+            /* Restore encrypt, flags and thread pool */
             ctx->encrypt = enc;
             ctx->flags = flags;
+            ctx->run_tasks = run_tasks;
+            ctx->pool = pool;
+            ctx->chunk = chunk;
         }
 #ifndef OPENSSL_NO_ENGINE
         if (impl) {
@@ -557,6 +565,52 @@ int EVP_CIPHER_CTX_set_padding(EVP_CIPHER_CTX *ctx, int pad)
     return 1;
 }
 
+int EVP_CIPHER_CTX_set_thread_pool(EVP_CIPHER_CTX *ctx,
+                                   CRYPTO_RUN_TASKS *run, void *pool,
+                                   size_t chunk)
+{
+    ctx->run_tasks = run;
+    ctx->pool = pool;
+    ctx->chunk = chunk;
+    return 1;
+}
+
+size_t evp_cipher_ctx_split(const EVP_CIPHER_CTX *ctx, size_t len,
+                            size_t *chunk)
+{
+    size_t n = ctx->chunk != 0 ? ctx->chunk : EVP_CIPHER_DEFAULT_TASK_SIZE;
+
+    n &= ~(size_t)(EVP_MAX_BLOCK_LENGTH - 1);
+    if (ctx->run_tasks == NULL || n == 0 || len / 2 < n)
+        return 0;
+    *chunk = n;
+    return len / n;
+}
+
+int evp_cipher_ctx_run_tasks(const EVP_CIPHER_CTX *ctx,
+                             void (*task) (void *arg), void *tasks,
+                             size_t size, size_t num)
+{
+    void **args;
+    size_t i;
+    int ret;
+
+    args = OPENSSL_malloc(num * sizeof(*args));
+    if (args == NULL) {
+        EVPerr(EVP_F_EVP_CIPHER_CTX_RUN_TASKS, ERR_R_MALLOC_FAILURE);
+        return 0;
+    }
+    for (i = 0; i < num; i++)
+        args[i] = (unsigned char *)tasks + i * size;
+    ret = crypto_run_tasks(ctx->run_tasks, ctx->pool, task, args, num);
+    OPENSSL_free(args);
+    if (!ret) {
+        EVPerr(EVP_F_EVP_CIPHER_CTX_RUN_TASKS, EVP_R_TASKS_FAILED);
+        return 0;
+    }
+    return 1;
+}
+
 int EVP_CIPHER_CTX_ctrl(EVP_CIPHER_CTX *ctx, int type, int arg, void *ptr)
 {
     int ret;
@@ -594,6 +648,24 @@ int EVP_CIPHER_CTX_copy(EVP_CIPHER_CTX *out, const EVP_CIPHER_CTX *in)
         EVPerr(EVP_F_EVP_CIPHER_CTX_COPY, EVP_R_INPUT_NOT_INITIALIZED);
         return 0;
     }
+
+    /*
+     * Restoring a saved state into a context that is already set up for the
+     * same cipher reuses the cipher data of |out| and its ENGINE reference.
+     * Ciphers that need a custom copy or cleanup take the full path below.
+     */
+    if (out->cipher == in->cipher && out->engine == in->engine
+            && out->cipher_data != NULL && in->cipher_data != NULL
+            && !(in->cipher->flags & EVP_CIPH_CUSTOM_COPY)
+            && in->cipher->cleanup == NULL) {
+        void *cipher_data = out->cipher_data;
+
+        memcpy(out, in, sizeof(*out));
+        out->cipher_data = cipher_data;
+        memcpy(out->cipher_data, in->cipher_data, in->cipher->ctx_size);
+        return 1;
+    }
+
 #ifndef OPENSSL_NO_ENGINE
     /* Make sure it's safe to copy a cipher context using an ENGINE */
     if (in->engine && !ENGINE_init(in->engine)) {
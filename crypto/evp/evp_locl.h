@@ -39,6 +39,10 @@ struct evp_cipher_ctx_st {
     int final_used;
     int block_mask;
     unsigned char final[EVP_MAX_BLOCK_LENGTH]; /* possible final block */
+    /* Optional thread pool large updates are split over */
+    CRYPTO_RUN_TASKS *run_tasks;
+    void *pool;
+    size_t chunk;               /* bytes per task, 0 for the default */
 } /* EVP_CIPHER_CTX */ ;
 
 int PKCS5_v2_PBKDF2_keyivgen(EVP_CIPHER_CTX *ctx, const char *pass,
@@ -22,12 +22,28 @@ struct ex_callback_st {
     CRYPTO_EX_dup *dup_func;
 };
 
+/*
+ * An immutable copy of the callbacks of a class. Objects are created, copied
+ * and freed using the current snapshot without taking |ex_data_lock|.
+ */
+typedef struct ex_callbacks_snapshot_st EX_CALLBACKS_SNAPSHOT;
+struct ex_callbacks_snapshot_st {
+    int num;
+    EX_CALLBACK **meth;
+    /* Next superseded snapshot, see publish_snapshot() */
+    EX_CALLBACKS_SNAPSHOT *next;
+};
+
 /*
  * The state for each class.  This could just be a typedef, but
  * a structure allows future changes.
  */
 typedef struct ex_callbacks_st {
     STACK_OF(EX_CALLBACK) *meth;
+    /* Snapshot of |meth|, NULL until the first index is registered */
+    EX_CALLBACKS_SNAPSHOT *snapshot;
+    /* Superseded snapshots, which lock-free readers may still be using */
+    EX_CALLBACKS_SNAPSHOT *retired;
 } EX_CALLBACKS;
 
 static EX_CALLBACKS ex_data[CRYPTO_EX_INDEX__COUNT];
@@ -73,6 +89,64 @@ static EX_CALLBACKS *get_and_lock(int class_index)
     return ip;
 }
 
+/*
+ * Get the current callback snapshot of a class, without locking. On success
+ * |*snap| is NULL if no index has been registered for the class.
+ */
+static int get_snapshot(int class_index, EX_CALLBACKS_SNAPSHOT **snap)
+{
+    if (class_index < 0 || class_index >= CRYPTO_EX_INDEX__COUNT) {
+        CRYPTOerr(CRYPTO_F_GET_SNAPSHOT, ERR_R_PASSED_INVALID_ARGUMENT);
+        return 0;
+    }
+
+    CRYPTO_THREAD_run_once(&ex_data_init, do_ex_data_init);
+
+    /* See get_and_lock() */
+    if (ex_data_lock == NULL)
+        return 0;
+
+    return crypto_atomic_load_ptr((void **)&ex_data[class_index].snapshot,
+                                  (void **)snap, ex_data_lock);
+}
+
+/*
+ * Replace the snapshot of |ip| after its callbacks changed. Must be called
+ * with |ex_data_lock| held. The superseded snapshot is only freed at cleanup,
+ * since threads that loaded it before the update may still be using it.
+ */
+static int publish_snapshot(EX_CALLBACKS *ip)
+{
+    EX_CALLBACKS_SNAPSHOT *snap, *old = ip->snapshot;
+    int i, num = sk_EX_CALLBACK_num(ip->meth);
+
+    snap = OPENSSL_malloc(sizeof(*snap) + sizeof(*snap->meth) * num);
+    if (snap == NULL)
+        return 0;
+    snap->num = num;
+    snap->meth = (EX_CALLBACK **)(snap + 1);
+    snap->next = NULL;
+    for (i = 0; i < num; i++)
+        snap->meth[i] = sk_EX_CALLBACK_value(ip->meth, i);
+
+    crypto_atomic_store_ptr((void **)&ip->snapshot, snap);
+    if (old != NULL) {
+        old->next = ip->retired;
+        ip->retired = old;
+    }
+    return 1;
+}
+
+static void free_snapshots(EX_CALLBACKS_SNAPSHOT *snap)
+{
+    EX_CALLBACKS_SNAPSHOT *next;
+
+    for (; snap != NULL; snap = next) {
+        next = snap->next;
+        OPENSSL_free(snap);
+    }
+}
+
 static void cleanup_cb(EX_CALLBACK *funcs)
 {
     OPENSSL_free(funcs);
@@ -93,6 +167,10 @@ void crypto_cleanup_all_ex_data_int(void)
 
         sk_EX_CALLBACK_pop_free(ip->meth, cleanup_cb);
         ip->meth = NULL;
+        free_snapshots(ip->snapshot);
+        ip->snapshot = NULL;
+        free_snapshots(ip->retired);
+        ip->retired = NULL;
     }
 
     CRYPTO_THREAD_lock_free(ex_data_lock);
@@ -186,6 +264,12 @@ int CRYPTO_get_ex_new_index(int class_index, long argl, void *argp,
     }
     toret = sk_EX_CALLBACK_num(ip->meth) - 1;
     (void)sk_EX_CALLBACK_set(ip->meth, toret, a);
+    if (!publish_snapshot(ip)) {
+        CRYPTOerr(CRYPTO_F_CRYPTO_GET_EX_NEW_INDEX, ERR_R_MALLOC_FAILURE);
+        (void)sk_EX_CALLBACK_pop(ip->meth);
+        OPENSSL_free(a);
+        toret = -1;
+    }
 
  err:
     CRYPTO_THREAD_unlock(ex_data_lock);
@@ -195,48 +279,31 @@ int CRYPTO_get_ex_new_index(int class_index, long argl, void *argp,
 /*
  * Initialise a new CRYPTO_EX_DATA for use in a particular class - including
  * calling new() callbacks for each index in the class used by this variable
- * Thread-safe by copying a class's array of "EX_CALLBACK" entries
- * in the lock, then using them outside the lock. Note this only applies
- * to the global "ex_data" state (ie. class definitions), not 'ad' itself.
+ * Thread-safe and lock-free by using the current snapshot of the class's
+ * callbacks. Note this only applies to the global "ex_data" state (ie. class
+ * definitions), not 'ad' itself.
  */
 int CRYPTO_new_ex_data(int class_index, void *obj, CRYPTO_EX_DATA *ad)
 {
-    int mx, i;
+    int i;
     void *ptr;
-    EX_CALLBACK **storage = NULL;
-    EX_CALLBACK *stack[10];
-    EX_CALLBACKS *ip = get_and_lock(class_index);
+    EX_CALLBACK *f;
+    EX_CALLBACKS_SNAPSHOT *snap;
 
-    if (ip == NULL)
+    if (!get_snapshot(class_index, &snap))
         return 0;
 
     ad->sk = NULL;
+    if (snap == NULL)
+        return 1;
 
-    mx = sk_EX_CALLBACK_num(ip->meth);
-    if (mx > 0) {
-        if (mx < (int)OSSL_NELEM(stack))
-            storage = stack;
-        else
-            storage = OPENSSL_malloc(sizeof(*storage) * mx);
-        if (storage != NULL)
-            for (i = 0; i < mx; i++)
-                storage[i] = sk_EX_CALLBACK_value(ip->meth, i);
-    }
-    CRYPTO_THREAD_unlock(ex_data_lock);
-
-    if (mx > 0 && storage == NULL) {
-        CRYPTOerr(CRYPTO_F_CRYPTO_NEW_EX_DATA, ERR_R_MALLOC_FAILURE);
-        return 0;
-    }
-    for (i = 0; i < mx; i++) {
-        if (storage[i] && storage[i]->new_func) {
+    for (i = 0; i < snap->num; i++) {
+        f = snap->meth[i];
+        if (f != NULL && f->new_func != NULL) {
             ptr = CRYPTO_get_ex_data(ad, i);
-            storage[i]->new_func(obj, ptr, ad, i,
-                                 storage[i]->argl, storage[i]->argp);
+            f->new_func(obj, ptr, ad, i, f->argl, f->argp);
         }
     }
-    if (storage != stack)
-        OPENSSL_free(storage);
     return 1;
 }
 
@@ -247,47 +314,30 @@ int CRYPTO_new_ex_data(int class_index, void *obj, CRYPTO_EX_DATA *ad)
 int CRYPTO_dup_ex_data(int class_index, CRYPTO_EX_DATA *to,
                        CRYPTO_EX_DATA *from)
 {
-    int mx, j, i;
+    int mx, i;
     char *ptr;
-    EX_CALLBACK *stack[10];
-    EX_CALLBACK **storage = NULL;
-    EX_CALLBACKS *ip;
+    EX_CALLBACK *f;
+    EX_CALLBACKS_SNAPSHOT *snap;
 
     if (from->sk == NULL)
         /* Nothing to copy over */
         return 1;
-    if ((ip = get_and_lock(class_index)) == NULL)
+    if (!get_snapshot(class_index, &snap))
         return 0;
+    if (snap == NULL)
+        return 1;
 
-    mx = sk_EX_CALLBACK_num(ip->meth);
-    j = sk_void_num(from->sk);
-    if (j < mx)
-        mx = j;
-    if (mx > 0) {
-        if (mx < (int)OSSL_NELEM(stack))
-            storage = stack;
-        else
-            storage = OPENSSL_malloc(sizeof(*storage) * mx);
-        if (storage != NULL)
-            for (i = 0; i < mx; i++)
-                storage[i] = sk_EX_CALLBACK_value(ip->meth, i);
-    }
-    CRYPTO_THREAD_unlock(ex_data_lock);
-
-    if (mx > 0 && storage == NULL) {
-        CRYPTOerr(CRYPTO_F_CRYPTO_DUP_EX_DATA, ERR_R_MALLOC_FAILURE);
-        return 0;
-    }
+    mx = sk_void_num(from->sk);
+    if (snap->num < mx)
+        mx = snap->num;
 
     for (i = 0; i < mx; i++) {
+        f = snap->meth[i];
         ptr = CRYPTO_get_ex_data(from, i);
-        if (storage[i] && storage[i]->dup_func)
-            storage[i]->dup_func(to, from, &ptr, i,
-                                 storage[i]->argl, storage[i]->argp);
+        if (f != NULL && f->dup_func != NULL)
+            f->dup_func(to, from, &ptr, i, f->argl, f->argp);
         CRYPTO_set_ex_data(to, i, ptr);
     }
-    if (storage != stack)
-        OPENSSL_free(storage);
     return 1;
 }
 
@@ -298,41 +348,24 @@ int CRYPTO_dup_ex_data(int class_index, CRYPTO_EX_DATA *to,
  */
 void CRYPTO_free_ex_data(int class_index, void *obj, CRYPTO_EX_DATA *ad)
 {
-    int mx, i;
-    EX_CALLBACKS *ip;
+    int i;
     void *ptr;
-    EX_CALLBACK *stack[10];
-    EX_CALLBACK **storage = NULL;
+    EX_CALLBACK *f;
+    EX_CALLBACKS_SNAPSHOT *snap;
 
-    if ((ip = get_and_lock(class_index)) == NULL)
+    if (!get_snapshot(class_index, &snap))
         return;
 
-    mx = sk_EX_CALLBACK_num(ip->meth);
-    if (mx > 0) {
-        if (mx < (int)OSSL_NELEM(stack))
-            storage = stack;
-        else
-            storage = OPENSSL_malloc(sizeof(*storage) * mx);
-        if (storage != NULL)
-            for (i = 0; i < mx; i++)
-                storage[i] = sk_EX_CALLBACK_value(ip->meth, i);
-    }
-    CRYPTO_THREAD_unlock(ex_data_lock);
-
-    if (mx > 0 && storage == NULL) {
-        CRYPTOerr(CRYPTO_F_CRYPTO_FREE_EX_DATA, ERR_R_MALLOC_FAILURE);
-        return;
-    }
-    for (i = 0; i < mx; i++) {
-        if (storage[i] && storage[i]->free_func) {
-            ptr = CRYPTO_get_ex_data(ad, i);
-            storage[i]->free_func(obj, ptr, ad, i,
-                                  storage[i]->argl, storage[i]->argp);
+    if (snap != NULL) {
+        for (i = 0; i < snap->num; i++) {
+            f = snap->meth[i];
+            if (f != NULL && f->free_func != NULL) {
+                ptr = CRYPTO_get_ex_data(ad, i);
+                f->free_func(obj, ptr, ad, i, f->argl, f->argp);
+            }
         }
     }
 
-    if (storage != stack)
-        OPENSSL_free(storage);
     sk_void_free(ad->sk);
     ad->sk = NULL;
 }
@@ -13,6 +13,7 @@
 #include "internal/cryptlib.h"
 #include <openssl/hmac.h>
 #include <openssl/opensslconf.h>
+#include "internal/evp_int.h"
 #include "hmac_lcl.h"
 
 int HMAC_Init_ex(HMAC_CTX *ctx, const void *key, int len,
@@ -179,7 +180,11 @@ int HMAC_CTX_reset(HMAC_CTX *ctx)
 
 int HMAC_CTX_copy(HMAC_CTX *dctx, HMAC_CTX *sctx)
 {
-    if (!HMAC_CTX_reset(dctx))
+    /*
+     * A context already set up for the same digest is overwritten in place,
+     * letting EVP_MD_CTX_copy_ex() reuse the digest states.
+     */
+    if ((dctx->md == NULL || dctx->md != sctx->md) && !HMAC_CTX_reset(dctx))
         goto err;
     if (!EVP_MD_CTX_copy_ex(dctx->i_ctx, sctx->i_ctx))
         goto err;
@@ -196,6 +201,59 @@ int HMAC_CTX_copy(HMAC_CTX *dctx, HMAC_CTX *sctx)
     return 0;
 }
 
+/*
+ * HMAC() for built-in digests, computing the inner and outer hashes with
+ * evp_digest_oneshot() so that no memory is allocated. Returns -1 if the
+ * digest needs an HMAC_CTX.
+ */
+static int hmac_oneshot(const EVP_MD *evp_md, const void *key, int key_len,
+                        const unsigned char *d, size_t n, unsigned char *md,
+                        unsigned int *md_len)
+{
+    unsigned char k[HMAC_MAX_MD_CBLOCK], pad[HMAC_MAX_MD_CBLOCK];
+    unsigned char ihash[EVP_MAX_MD_SIZE];
+    const unsigned char *data[2];
+    size_t len[2];
+    unsigned int klen, ilen;
+    int i, bs = EVP_MD_block_size(evp_md), ret;
+
+    if (bs <= 0 || bs > HMAC_MAX_MD_CBLOCK || key_len < 0
+            || (key == NULL && key_len != 0))
+        return -1;
+
+    if (key_len > bs) {
+        data[0] = key;
+        len[0] = key_len;
+        if ((ret = evp_digest_oneshot(evp_md, data, len, 1, k, &klen)) <= 0)
+            return ret;
+    } else {
+        if (key_len > 0)
+            memcpy(k, key, key_len);
+        klen = key_len;
+    }
+    memset(k + klen, 0, bs - klen);
+
+    for (i = 0; i < bs; i++)
+        pad[i] = 0x36 ^ k[i];
+    data[0] = pad;
+    len[0] = bs;
+    data[1] = d;
+    len[1] = n;
+    ret = evp_digest_oneshot(evp_md, data, len, 2, ihash, &ilen);
+    if (ret > 0) {
+        for (i = 0; i < bs; i++)
+            pad[i] = 0x5c ^ k[i];
+        data[1] = ihash;
+        len[1] = ilen;
+        ret = evp_digest_oneshot(evp_md, data, len, 2, md, md_len);
+    }
+
+    OPENSSL_cleanse(k, sizeof(k));
+    OPENSSL_cleanse(pad, sizeof(pad));
+    OPENSSL_cleanse(ihash, sizeof(ihash));
+    return ret;
+}
+
 unsigned char *HMAC(const EVP_MD *evp_md, const void *key, int key_len,
                     const unsigned char *d, size_t n, unsigned char *md,
                     unsigned int *md_len)
@@ -203,9 +261,16 @@ unsigned char *HMAC(const EVP_MD *evp_md, const void *key, int key_len,
     HMAC_CTX *c = NULL;
     static unsigned char m[EVP_MAX_MD_SIZE];
     static const unsigned char dummy_key[1] = {'\0'};
+    int ret;
 
     if (md == NULL)
         md = m;
+
+    if (evp_md != NULL
+            && (ret = hmac_oneshot(evp_md, key, key_len, d, n, md,
+                                   md_len)) >= 0)
+        return ret ? md : NULL;
+
     if ((c = HMAC_CTX_new()) == NULL)
         goto err;
 
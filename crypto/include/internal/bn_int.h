@@ -68,6 +68,43 @@ int bn_set_words(BIGNUM *a, BN_ULONG *words, int num_words);
 
 size_t bn_sizeof_BIGNUM(void);
 
+/*
+ * rp = ap*bp/2^(num*BN_BITS2) mod np, with n0 as in BN_MONT_CTX, in the
+ * bn_mul_mont() assembly modules. Returns 0 if |num| is not supported.
+ */
+int bn_mul_mont(BN_ULONG *rp, const BN_ULONG *ap, const BN_ULONG *bp,
+                const BN_ULONG *np, const BN_ULONG *n0, int num);
+
+/*
+ * Precomputed powers of a fixed base g modulo an odd m, for constant time
+ * exponentiation with exponents of up to |bits| bits. Longer exponents fall
+ * back to BN_mod_exp_mont_consttime(). The tables are reference counted so
+ * that copies of the same parameters can share them.
+ */
+typedef struct bn_fixed_base_st BN_FIXED_BASE;
+
+BN_FIXED_BASE *bn_fixed_base_new(const BIGNUM *g, const BIGNUM *m, int bits,
+                                 BN_CTX *ctx);
+int bn_fixed_base_up_ref(BN_FIXED_BASE *fb);
+int bn_fixed_base_bits(const BN_FIXED_BASE *fb);
+void bn_fixed_base_free(BN_FIXED_BASE *fb);
+BN_FIXED_BASE *bn_fixed_base_set_locked(BN_FIXED_BASE **pfb,
+                                        CRYPTO_RWLOCK *lock,
+                                        const BIGNUM *g, const BIGNUM *m,
+                                        int bits, BN_CTX *ctx);
+int bn_fixed_base_exp(BIGNUM *rr, const BIGNUM *p, const BN_FIXED_BASE *fb,
+                      BN_CTX *ctx);
+
+/*
+ * Get the calling thread's arena BN_CTX, sized for moduli of |bits| bits,
+ * for one public key operation. It must be returned with
+ * bn_ctx_thread_put() on the same thread, after all its frames have ended.
+ * A fresh BN_CTX is returned if the thread's one is in use.
+ */
+BN_CTX *bn_ctx_thread_get(int bits);
+void bn_ctx_thread_put(BN_CTX *ctx);
+void bn_ctx_delete_thread_state(void);
+
 /*
  * Return element el from an array of BIGNUMs starting at base (required
  * because callers do not know the size of BIGNUM at compilation time)
@@ -14,10 +14,27 @@
 struct thread_local_inits_st {
     int async;
     int err_state;
+    int bn_ctx;
 };
 
 int ossl_init_thread_start(uint64_t opts);
 
+/*
+ * Atomic pointer load (acquire) and store (release) for data that is read
+ * without taking the lock that protects its updates. Stores must be made
+ * with |lock| held for writing; loads only take it for reading on platforms
+ * without atomic primitives.
+ */
+int crypto_atomic_load_ptr(void **ptr, void **ret, CRYPTO_RWLOCK *lock);
+void crypto_atomic_store_ptr(void **ptr, void *val);
+
+/*
+ * Runs |task| on each of |args| through the application's |run| callback,
+ * moving errors that the tasks raise on other threads to the caller's queue.
+ */
+int crypto_run_tasks(CRYPTO_RUN_TASKS *run, void *pool,
+                     void (*task) (void *arg), void *args[], size_t num);
+
 /*
  * OPENSSL_INIT flags. The primary list of these is in crypto.h. Flags below
  * are those ommitted from crypto.h because they are "reserved for internal
@@ -28,4 +45,5 @@ int ossl_init_thread_start(uint64_t opts);
 /* OPENSSL_INIT_THREAD flags */
 # define OPENSSL_INIT_THREAD_ASYNC           0x01
 # define OPENSSL_INIT_THREAD_ERR_STATE       0x02
+# define OPENSSL_INIT_THREAD_BN_CTX          0x04
 
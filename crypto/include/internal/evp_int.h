@@ -374,3 +374,29 @@ struct evp_pkey_st {
 void openssl_add_all_ciphers_int(void);
 void openssl_add_all_digests_int(void);
 void evp_cleanup_int(void);
+
+/*
+ * Digest the concatenation of |num| buffers in one go, keeping the digest
+ * state on the stack. Returns -1 without doing anything if |type| can't be
+ * used that way, e.g. because an ENGINE implements it.
+ */
+int evp_digest_oneshot(const EVP_MD *type, const unsigned char *const data[],
+                       const size_t len[], size_t num, unsigned char *md,
+                       unsigned int *size);
+
+/*
+ * Splitting large updates over the thread pool set with
+ * EVP_CIPHER_CTX_set_thread_pool(). evp_cipher_ctx_split() returns how many
+ * tasks |len| bytes are split into, all |*chunk| bytes long except for the
+ * last one which takes the rest, or 0 if they should be processed in one
+ * go. |*chunk| is a multiple of EVP_MAX_BLOCK_LENGTH.
+ * evp_cipher_ctx_run_tasks() runs |task| on each of the |num| elements of
+ * the array |tasks| of |size| byte elements and returns once all are done.
+ */
+# define EVP_CIPHER_DEFAULT_TASK_SIZE    (1024 * 1024)
+
+size_t evp_cipher_ctx_split(const EVP_CIPHER_CTX *ctx, size_t len,
+                            size_t *chunk);
+int evp_cipher_ctx_run_tasks(const EVP_CIPHER_CTX *ctx,
+                             void (*task) (void *arg), void *tasks,
+                             size_t size, size_t num);
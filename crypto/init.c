@@ -18,6 +18,7 @@
 #include <internal/engine.h>
 #include <internal/comp.h>
 #include <internal/err.h>
+#include <internal/bn_int.h>
 #include <internal/err_int.h>
 #include <internal/objects.h>
 #include <stdlib.h>
@@ -307,6 +308,14 @@ static void ossl_init_thread_stop(struct thread_local_inits_st *locals)
         err_delete_thread_state();
     }
 
+    if (locals->bn_ctx) {
+#ifdef OPENSSL_INIT_DEBUG
+        fprintf(stderr, "OPENSSL_INIT: ossl_init_thread_stop: "
+                        "bn_ctx_delete_thread_state()\n");
+#endif
+        bn_ctx_delete_thread_state();
+    }
+
     OPENSSL_free(locals);
 }
 
@@ -339,6 +348,14 @@ int ossl_init_thread_start(uint64_t opts)
         locals->err_state = 1;
     }
 
+    if (opts & OPENSSL_INIT_THREAD_BN_CTX) {
+#ifdef OPENSSL_INIT_DEBUG
+        fprintf(stderr, "OPENSSL_INIT: ossl_init_thread_start: "
+                        "marking thread for bn_ctx\n");
+#endif
+        locals->bn_ctx = 1;
+    }
+
     return 1;
 }
 
@@ -710,33 +710,9 @@ void gcm_ghash_p8(u64 Xi[2], const u128 Htable[16], const u8 *inp,
 # endif
 #endif
 
-void CRYPTO_gcm128_init(GCM128_CONTEXT *ctx, void *key, block128_f block)
+/* Set up Htable and the GHASH functions for H, which is in host byte order */
+static void gcm_init_htable(GCM128_CONTEXT *ctx)
 {
-    const union {
-        long one;
-        char little;
-    } is_endian = { 1 };
-
-    memset(ctx, 0, sizeof(*ctx));
-    ctx->block = block;
-    ctx->key = key;
-
-    (*block) (ctx->H.c, ctx->H.c, key);
-
-    if (is_endian.little) {
-        /* H is stored in host byte order */
-#ifdef BSWAP8
-        ctx->H.u[0] = BSWAP8(ctx->H.u[0]);
-        ctx->H.u[1] = BSWAP8(ctx->H.u[1]);
-#else
-        u8 *p = ctx->H.c;
-        u64 hi, lo;
-        hi = (u64)GETU32(p) << 32 | GETU32(p + 4);
-        lo = (u64)GETU32(p + 8) << 32 | GETU32(p + 12);
-        ctx->H.u[0] = hi;
-        ctx->H.u[1] = lo;
-#endif
-    }
 #if     TABLE_BITS==8
     gcm_init_8bit(ctx->Htable, ctx->H.u);
 #elif   TABLE_BITS==4
@@ -825,6 +801,36 @@ void CRYPTO_gcm128_init(GCM128_CONTEXT *ctx, void *key, block128_f block)
 #endif
 }
 
+void CRYPTO_gcm128_init(GCM128_CONTEXT *ctx, void *key, block128_f block)
+{
+    const union {
+        long one;
+        char little;
+    } is_endian = { 1 };
+
+    memset(ctx, 0, sizeof(*ctx));
+    ctx->block = block;
+    ctx->key = key;
+
+    (*block) (ctx->H.c, ctx->H.c, key);
+
+    if (is_endian.little) {
+        /* H is stored in host byte order */
+#ifdef BSWAP8
+        ctx->H.u[0] = BSWAP8(ctx->H.u[0]);
+        ctx->H.u[1] = BSWAP8(ctx->H.u[1]);
+#else
+        u8 *p = ctx->H.c;
+        u64 hi, lo;
+        hi = (u64)GETU32(p) << 32 | GETU32(p + 4);
+        lo = (u64)GETU32(p + 8) << 32 | GETU32(p + 12);
+        ctx->H.u[0] = hi;
+        ctx->H.u[1] = lo;
+#endif
+    }
+    gcm_init_htable(ctx);
+}
+
 void CRYPTO_gcm128_setiv(GCM128_CONTEXT *ctx, const unsigned char *iv,
                          size_t len)
 {
@@ -1599,6 +1605,295 @@ int CRYPTO_gcm128_decrypt_ctr32(GCM128_CONTEXT *ctx,
 #endif
 }
 
+/*
+ * Splitting the text of a message between threads. GHASH is linear, so a
+ * run of m blocks hashed on its own from Xi = 0 to G contributes
+ * Xi * H^m + G to the running hash. The pieces are encrypted on copies of
+ * the context made with CRYPTO_gcm128_fork() and folded back into it in
+ * order with CRYPTO_gcm128_join().
+ */
+
+/* Xi in host byte order, it is stored big-endian */
+static void gcm_get_xi(u64 X[2], const GCM128_CONTEXT *ctx)
+{
+    const union {
+        long one;
+        char little;
+    } is_endian = { 1 };
+
+    if (is_endian.little) {
+#ifdef BSWAP8
+        X[0] = BSWAP8(ctx->Xi.u[0]);
+        X[1] = BSWAP8(ctx->Xi.u[1]);
+#else
+        const u8 *p = ctx->Xi.c;
+
+        X[0] = (u64)GETU32(p) << 32 | GETU32(p + 4);
+        X[1] = (u64)GETU32(p + 8) << 32 | GETU32(p + 12);
+#endif
+    } else {
+        X[0] = ctx->Xi.u[0];
+        X[1] = ctx->Xi.u[1];
+    }
+}
+
+static void gcm_set_xi(GCM128_CONTEXT *ctx, const u64 X[2])
+{
+    const union {
+        long one;
+        char little;
+    } is_endian = { 1 };
+
+    if (is_endian.little) {
+#ifdef BSWAP8
+        ctx->Xi.u[0] = BSWAP8(X[0]);
+        ctx->Xi.u[1] = BSWAP8(X[1]);
+#else
+        u8 *p = ctx->Xi.c;
+
+        PUTU32(p, (u32)(X[0] >> 32));
+        PUTU32(p + 4, (u32)X[0]);
+        PUTU32(p + 8, (u32)(X[1] >> 32));
+        PUTU32(p + 12, (u32)X[1]);
+#endif
+    } else {
+        ctx->Xi.u[0] = X[0];
+        ctx->Xi.u[1] = X[1];
+    }
+}
+
+/* Z = X * Y in GF(2^128), all in host byte order */
+static void gcm_mul(u64 Z[2], const u64 X[2], const u64 Y[2])
+{
+    u128 V, R = { 0, 0 };
+    int i;
+
+    V.hi = Y[0];
+    V.lo = Y[1];
+    for (i = 0; i < 128; i++) {
+        u64 M = 0 - ((X[i / 64] >> (63 - i % 64)) & 1);
+
+        R.hi ^= V.hi & M;
+        R.lo ^= V.lo & M;
+        REDUCE1BIT(V);
+    }
+    Z[0] = R.hi;
+    Z[1] = R.lo;
+}
+
+/*
+ * Set up |sub| to process whole blocks starting |offset| bytes into the
+ * text that follows what |ctx| has processed so far. |offset| must be a
+ * multiple of 16 and |ctx| must be at a block boundary.
+ */
+int CRYPTO_gcm128_fork(GCM128_CONTEXT *ctx, GCM128_CONTEXT *sub,
+                       size_t offset)
+{
+    const union {
+        long one;
+        char little;
+    } is_endian = { 1 };
+    unsigned int ctr;
+#ifdef GCM_FUNCREF_4BIT
+    void (*gcm_gmult_p) (u64 Xi[2], const u128 Htable[16]) = ctx->gmult;
+#endif
+
+    if (ctx->mres || offset % 16)
+        return -1;
+    if (ctx->ares) {
+        /* Finalize GHASH(AAD) before it is used as the starting point */
+        GCM_MUL(ctx, Xi);
+        ctx->ares = 0;
+    }
+
+    memcpy(sub, ctx, sizeof(*sub));
+    sub->Xi.u[0] = sub->Xi.u[1] = 0;
+    sub->len.u[0] = sub->len.u[1] = 0;
+
+    if (is_endian.little)
+#ifdef BSWAP4
+        ctr = BSWAP4(ctx->Yi.d[3]);
+#else
+        ctr = GETU32(ctx->Yi.c + 12);
+#endif
+    else
+        ctr = ctx->Yi.d[3];
+    ctr += (unsigned int)(offset / 16);
+    if (is_endian.little)
+#ifdef BSWAP4
+        sub->Yi.d[3] = BSWAP4(ctr);
+#else
+        PUTU32(sub->Yi.c + 12, ctr);
+#endif
+    else
+        sub->Yi.d[3] = ctr;
+
+    return 0;
+}
+
+/*
+ * Fold the hash of the text processed on |sub| into |ctx| and move |ctx|
+ * past it. Pieces must be joined in the order they appear in the text.
+ */
+int CRYPTO_gcm128_join(GCM128_CONTEXT *ctx, const GCM128_CONTEXT *sub)
+{
+    u64 mlen = ctx->len.u[1] + sub->len.u[1];
+    u64 blocks = sub->len.u[1] / 16;
+    u64 X[2], G[2], P[2], Hn[2];
+
+    if (sub->mres || sub->ares
+        || mlen > ((U64(1) << 36) - 32) || mlen < ctx->len.u[1])
+        return -1;
+
+    /* P = H^blocks */
+    P[0] = U64(0x8000000000000000);
+    P[1] = 0;
+    Hn[0] = ctx->H.u[0];
+    Hn[1] = ctx->H.u[1];
+    for (; blocks != 0; blocks >>= 1) {
+        if (blocks & 1)
+            gcm_mul(P, P, Hn);
+        gcm_mul(Hn, Hn, Hn);
+    }
+
+    gcm_get_xi(X, ctx);
+    gcm_get_xi(G, sub);
+    gcm_mul(X, X, P);
+    X[0] ^= G[0];
+    X[1] ^= G[1];
+    gcm_set_xi(ctx, X);
+
+    ctx->len.u[1] = mlen;
+    memcpy(ctx->Yi.c, sub->Yi.c, sizeof(ctx->Yi));
+
+    return 0;
+}
+
+/*
+ * POLYVAL, the hash of AES-GCM-SIV (RFC 8452), computed with the GHASH
+ * code. POLYVAL(H, X_1, ..., X_n) is the byte-reversed GHASH(H * x,
+ * ByteReverse(X_1), ..., ByteReverse(X_n)) with H * x taken in GHASH's
+ * field representation. The hash value is kept byte-reversed in Xi,
+ * partial blocks are accumulated in it with ares counting their bytes.
+ */
+
+#define POLYVAL_CHUNK   1024
+
+/* Byte-reverse |blocks| 16-byte blocks */
+static void polyval_reverse(u8 *out, const u8 *in, size_t blocks)
+{
+    for (; blocks--; in += 16, out += 16) {
+#ifdef BSWAP8
+        u64 hi, lo;
+
+        memcpy(&hi, in, 8);
+        memcpy(&lo, in + 8, 8);
+        hi = BSWAP8(hi);
+        lo = BSWAP8(lo);
+        memcpy(out, &lo, 8);
+        memcpy(out + 8, &hi, 8);
+#else
+        int i;
+
+        for (i = 0; i < 16; i++)
+            out[i] = in[15 - i];
+#endif
+    }
+}
+
+void CRYPTO_polyval128_init(GCM128_CONTEXT *ctx, const unsigned char H[16])
+{
+    u128 V;
+    int i;
+
+    memset(ctx, 0, sizeof(*ctx));
+
+    /* The byte-reversed key, multiplied by x, in host byte order */
+    V.hi = V.lo = 0;
+    for (i = 0; i < 8; i++) {
+        V.hi = V.hi << 8 | H[15 - i];
+        V.lo = V.lo << 8 | H[7 - i];
+    }
+    REDUCE1BIT(V);
+    ctx->H.u[0] = V.hi;
+    ctx->H.u[1] = V.lo;
+    gcm_init_htable(ctx);
+}
+
+void CRYPTO_polyval128_update(GCM128_CONTEXT *ctx, const unsigned char *in,
+                              size_t len)
+{
+    size_t i, used = 0;
+    unsigned int n = ctx->ares;
+    u64 buf[POLYVAL_CHUNK / 8];
+#ifdef GCM_FUNCREF_4BIT
+    void (*gcm_gmult_p) (u64 Xi[2], const u128 Htable[16]) = ctx->gmult;
+# ifdef GHASH
+    void (*gcm_ghash_p) (u64 Xi[2], const u128 Htable[16],
+                         const u8 *inp, size_t len) = ctx->ghash;
+# endif
+#endif
+
+    if (n) {
+        while (n && len) {
+            ctx->Xi.c[15 - n] ^= *(in++);
+            --len;
+            n = (n + 1) % 16;
+        }
+        if (n == 0)
+            GCM_MUL(ctx, Xi);
+        else {
+            ctx->ares = n;
+            return;
+        }
+    }
+
+    while (len >= 16) {
+        size_t blocks = (len < sizeof(buf) ? len : sizeof(buf)) / 16;
+
+        polyval_reverse((u8 *)buf, in, blocks);
+#ifdef GHASH
+        GHASH(ctx, (const u8 *)buf, blocks * 16);
+#else
+        for (i = 0; i < blocks; i++) {
+            ctx->Xi.u[0] ^= buf[2 * i];
+            ctx->Xi.u[1] ^= buf[2 * i + 1];
+            GCM_MUL(ctx, Xi);
+        }
+#endif
+        in += blocks * 16;
+        len -= blocks * 16;
+        if (used < blocks * 16)
+            used = blocks * 16;
+    }
+    /* Only what was written to, short messages are common */
+    if (used)
+        OPENSSL_cleanse(buf, used);
+
+    for (i = 0; i < len; i++)
+        ctx->Xi.c[15 - i] ^= in[i];
+    ctx->ares = (unsigned int)len;
+}
+
+/* Complete a partial block with zeroes */
+void CRYPTO_polyval128_pad(GCM128_CONTEXT *ctx)
+{
+#ifdef GCM_FUNCREF_4BIT
+    void (*gcm_gmult_p) (u64 Xi[2], const u128 Htable[16]) = ctx->gmult;
+#endif
+
+    if (ctx->ares) {
+        GCM_MUL(ctx, Xi);
+        ctx->ares = 0;
+    }
+}
+
+void CRYPTO_polyval128_final(GCM128_CONTEXT *ctx, unsigned char out[16])
+{
+    CRYPTO_polyval128_pad(ctx);
+    polyval_reverse(out, ctx->Xi.c, 1);
+}
+
 int CRYPTO_gcm128_finish(GCM128_CONTEXT *ctx, const unsigned char *tag,
                          size_t len)
 {
@@ -183,3 +183,13 @@ struct ocb128_context {
     OCB_BLOCK checksum;
 };
 #endif                          /* OPENSSL_NO_OCB */
+
+int CRYPTO_gcm128_fork(GCM128_CONTEXT *ctx, GCM128_CONTEXT *sub,
+                       size_t offset);
+int CRYPTO_gcm128_join(GCM128_CONTEXT *ctx, const GCM128_CONTEXT *sub);
+
+void CRYPTO_polyval128_init(GCM128_CONTEXT *ctx, const unsigned char H[16]);
+void CRYPTO_polyval128_update(GCM128_CONTEXT *ctx, const unsigned char *in,
+                              size_t len);
+void CRYPTO_polyval128_pad(GCM128_CONTEXT *ctx);
+void CRYPTO_polyval128_final(GCM128_CONTEXT *ctx, unsigned char out[16]);
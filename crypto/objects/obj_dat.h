@@ -9,12 +9,12 @@
  * https://www.openssl.org/source/license.html
  */
 
-#define NUM_NID 1058
-#define NUM_SN 1049
-#define NUM_LN 1049
-#define NUM_OBJ 953
+#define NUM_NID 1061
+#define NUM_SN 1052
+#define NUM_LN 1052
+#define NUM_OBJ 954
 
-static const unsigned char lvalues[6744]={
+static const unsigned char lvalues[6747]={
 0x2A,0x86,0x48,0x86,0xF7,0x0D,               /* [  0] OBJ_rsadsi */
 0x2A,0x86,0x48,0x86,0xF7,0x0D,0x01,          /* [  6] OBJ_pkcs */
 0x2A,0x86,0x48,0x86,0xF7,0x0D,0x02,0x02,     /* [ 13] OBJ_md2 */
@@ -962,6 +962,7 @@ static const unsigned char lvalues[6744]={
 0x2B,0x06,0x01,0x04,0x01,0xDA,0x47,0x0F,0x02,/* [6712] OBJ_X448 */
 0x2B,0x06,0x01,0x04,0x01,0x8D,0x3A,0x0C,0x02,0x01,0x10,/* [6721] OBJ_blake2b512 */
 0x2B,0x06,0x01,0x04,0x01,0x8D,0x3A,0x0C,0x02,0x02,0x08,/* [6732] OBJ_blake2s256 */
+0x2B,0x65,0x70,                              /* [6743] OBJ_ED25519 */
 };
 
 static const ASN1_OBJECT nid_objs[NUM_NID]={
@@ -2677,6 +2678,9 @@ static const ASN1_OBJECT nid_objs[NUM_NID]={
 {NULL,NULL,NID_undef,0,NULL,0},
 {"BLAKE2b512","blake2b512",NID_blake2b512,11,&(lvalues[6721]),0},
 {"BLAKE2s256","blake2s256",NID_blake2s256,11,&(lvalues[6732]),0},
+{"AES-128-GCM-SIV","aes-128-gcm-siv",NID_aes_128_gcm_siv,0,NULL,0},
+{"AES-256-GCM-SIV","aes-256-gcm-siv",NID_aes_256_gcm_siv,0,NULL,0},
+{"ED25519","ED25519",NID_ED25519,3,&(lvalues[6743]),0},
 };
 
 static const unsigned int sn_objs[NUM_SN]={
@@ -2689,6 +2693,7 @@ static const unsigned int sn_objs[NUM_SN]={
 653,	/* "AES-128-CFB8" */
 904,	/* "AES-128-CTR" */
 418,	/* "AES-128-ECB" */
+1058,	/* "AES-128-GCM-SIV" */
 958,	/* "AES-128-OCB" */
 420,	/* "AES-128-OFB" */
 913,	/* "AES-128-XTS" */
@@ -2710,6 +2715,7 @@ static const unsigned int sn_objs[NUM_SN]={
 655,	/* "AES-256-CFB8" */
 906,	/* "AES-256-CTR" */
 426,	/* "AES-256-ECB" */
+1059,	/* "AES-256-GCM-SIV" */
 960,	/* "AES-256-OCB" */
 428,	/* "AES-256-OFB" */
 914,	/* "AES-256-XTS" */
@@ -2795,6 +2801,7 @@ static const unsigned int sn_objs[NUM_SN]={
 70,	/* "DSA-SHA1-old" */
 67,	/* "DSA-old" */
 297,	/* "DVCS" */
+1060,	/* "ED25519" */
 99,	/* "GN" */
 1036,	/* "HKDF" */
 855,	/* "HMAC" */
@@ -3753,6 +3760,7 @@ static const unsigned int ln_objs[NUM_LN]={
 382,	/* "Directory" */
 392,	/* "Domain" */
 132,	/* "E-mail Protection" */
+1060,	/* "ED25519" */
 389,	/* "Enterprises" */
 384,	/* "Experimental" */
 372,	/* "Extended OCSP Status" */
@@ -3920,6 +3928,7 @@ static const unsigned int ln_objs[NUM_LN]={
 904,	/* "aes-128-ctr" */
 418,	/* "aes-128-ecb" */
 895,	/* "aes-128-gcm" */
+1058,	/* "aes-128-gcm-siv" */
 958,	/* "aes-128-ocb" */
 420,	/* "aes-128-ofb" */
 913,	/* "aes-128-xts" */
@@ -3945,6 +3954,7 @@ static const unsigned int ln_objs[NUM_LN]={
 906,	/* "aes-256-ctr" */
 426,	/* "aes-256-ecb" */
 901,	/* "aes-256-gcm" */
+1059,	/* "aes-256-gcm-siv" */
 960,	/* "aes-256-ocb" */
 428,	/* "aes-256-ofb" */
 914,	/* "aes-256-xts" */
@@ -4805,6 +4815,7 @@ static const unsigned int obj_objs[NUM_OBJ]={
 435,	/* OBJ_pss                          0 9 2342 */
 183,	/* OBJ_ISO_US                       1 2 840 */
 381,	/* OBJ_iana                         1 3 6 1 */
+1060,	/* OBJ_ED25519                      1 3 101 112 */
 677,	/* OBJ_certicom_arc                 1 3 132 */
 394,	/* OBJ_selected_attribute_types     2 5 1 5 */
 13,	/* OBJ_commonName                   2 5 4 3 */
@@ -41,6 +41,13 @@
 #	Core processors, 50-30%, less newer processor is, but slower on
 #	contemporary ones, for example almost 2x slower on Atom, and as
 #	former are naturally disappearing, SSE2 is deemed unnecessary;
+#
+# November 2016
+#
+# Add 8-way AVX512F code path to poly1305_blocks_avx2, taken for inputs
+# of 512 bytes or more. Powers r^5-r^8 are calculated on the fly, and
+# 128 bytes are processed per iteration. Together with 16xAVX512F
+# ChaCha20 it makes ChaCha20-Poly1305 ~1.7x faster on large buffers.
 
 $flavour = shift;
 $output  = shift;
@@ -55,12 +62,12 @@ die "can't locate x86_64-xlate.pl";
 
 if (`$ENV{CC} -Wa,-v -c -o /dev/null -x assembler /dev/null 2>&1`
 		=~ /GNU assembler version ([2-9]\.[0-9]+)/) {
-	$avx = ($1>=2.19) + ($1>=2.22);
+	$avx = ($1>=2.19) + ($1>=2.22) + ($1>=2.25);
 }
 
 if (!$avx && $win64 && ($flavour =~ /nasm/ || $ENV{ASM} =~ /nasm/) &&
 	   `nasm -v 2>&1` =~ /NASM version ([2-9]\.[0-9]+)/) {
-	$avx = ($1>=2.09) + ($1>=2.10);
+	$avx = ($1>=2.09) + ($1>=2.10) + ($1>=2.12);
 }
 
 if (!$avx && $win64 && ($flavour =~ /masm/ || $ENV{ASM} =~ /ml64/) &&
@@ -69,7 +76,7 @@ if (!$avx && $win64 && ($flavour =~ /masm/ || $ENV{ASM} =~ /ml64/) &&
 }
 
 if (!$avx && `$ENV{CC} -v 2>&1` =~ /((?:^clang|LLVM) version|.*based on LLVM) ([3-9]\.[0-9]+)/) {
-	$avx = ($2>=3.0) + ($2>3.0);
+	$avx = ($2>=3.0) + ($2>3.0) + ($2>=3.6);
 }
 
 open OUT,"| \"$^X\" \"$xlate\" $flavour \"$output\"";
@@ -1613,6 +1620,233 @@ ___
 $code.=<<___;
 	lea		48+64($ctx),$ctx	# size optimization
 	lea		.Lconst(%rip),%rcx
+___
+if ($avx>2) {
+# AVX512F path processes 8 blocks per iteration, multiplying every lane
+# by r^8, and is entered only with 512+ bytes, so that the run-time
+# calculation of r^5-r^8 is amortized. The input is splat as
+# [0,4,1,5,2,6,3,7] lane-wise, which is why powers for the last
+# iteration are permuted accordingly.
+my ($H0,$H1,$H2,$H3,$H4, $MASK, $T4,$T0,$T1,$T2,$T3, $D0,$D1,$D2,$D3,$D4) =
+    map("%zmm$_",(0..15));
+my ($R0,$R1,$R2,$R3,$R4, $S1,$S2,$S3,$S4, $PAD) = map("%zmm$_",(16..25));
+my ($A0,$A1,$A2,$A3,$A4, $X) = map("%zmm$_",(26..31));
+my @H=($H0,$H1,$H2,$H3,$H4);
+my @D=($D0,$D1,$D2,$D3,$D4);
+my @A=($A0,$A1,$A2,$A3,$A4);
+my @T=($T0,$T1,$T2,$T3,$T4);
+my @R=($R0,$R1,$R2,$R3,$R4);
+my @S=(undef,$S1,$S2,$S3,$S4);
+
+sub vpmul_avx512 {	# d[] = h[] * r[], s[i] being 5*r[i]
+my ($h,$r,$s,$d,@t)=@_;
+my $k=0;
+    for my $i (0..4) {
+	for my $j (0..4) {
+	    my $m = $i+$j>4 ? $$s[$j] : $$r[$j];
+	    my $n = ($i+$j)%5;
+	    if ($i==0) {
+		$code.="\tvpmuludq\t$m,$$h[0],$$d[$n]\n";
+	    } else {
+		my $t = $t[$k++%@t];
+		$code.="\tvpmuludq\t$m,$$h[$i],$t\n";
+		$code.="\tvpaddq\t\t$t,$$d[$n],$$d[$n]\n";
+	    }
+	}
+    }
+}
+
+sub lazy_reduce_avx512 {	# h[] = d[] with limbs reduced to 26 bits
+my ($d,$h,$t0,$t1)=@_;
+my ($d0,$d1,$d2,$d3,$d4)=@$d;
+my ($h0,$h1,$h2,$h3,$h4)=@$h;
+$code.=<<___;
+	vpsrlq		\$26,$d3,$t0
+	vpandq		$MASK,$d3,$h3
+	vpaddq		$t0,$d4,$h4		# h3 -> h4
+
+	vpsrlq		\$26,$d0,$t0
+	vpandq		$MASK,$d0,$h0
+	vpaddq		$t0,$d1,$h1		# h0 -> h1
+
+	vpsrlq		\$26,$h4,$t1
+	vpandq		$MASK,$h4,$h4
+
+	vpsrlq		\$26,$h1,$t0
+	vpandq		$MASK,$h1,$h1
+	vpaddq		$t0,$d2,$h2		# h1 -> h2
+
+	vpaddq		$t1,$h0,$h0
+	vpsllq		\$2,$t1,$t1
+	vpaddq		$t1,$h0,$h0		# h4 -> h0
+
+	vpsrlq		\$26,$h2,$t0
+	vpandq		$MASK,$h2,$h2
+	vpaddq		$t0,$h3,$h3		# h2 -> h3
+
+	vpsrlq		\$26,$h0,$t0
+	vpandq		$MASK,$h0,$h0
+	vpaddq		$t0,$h1,$h1		# h0 -> h1
+
+	vpsrlq		\$26,$h3,$t0
+	vpandq		$MASK,$h3,$h3
+	vpaddq		$t0,$h4,$h4		# h3 -> h4
+___
+}
+
+sub load_input_avx512 {
+$code.=<<___;
+	vmovdqu64	16*0($inp),$T1
+	vmovdqu64	16*4($inp),$T2
+	lea		16*8($inp),$inp
+
+	vpunpcklqdq	$T2,$T1,$T0		# splat input
+	vpunpckhqdq	$T2,$T1,$T4
+	vpsrlq		\$26,$T0,$T1
+	vpsrlq		\$52,$T0,$T2
+	vpsllq		\$12,$T4,$T3
+	vporq		$T3,$T2,$T2
+	vpsrlq		\$14,$T4,$T3
+	vpsrlq		\$40,$T4,$T4		# 4
+	vpandq		$MASK,$T0,$T0		# 0
+	vpandq		$MASK,$T1,$T1		# 1
+	vpandq		$MASK,$T2,$T2		# 2
+	vpandq		$MASK,$T3,$T3		# 3
+	vporq		$PAD,$T4,$T4		# padbit, yes, always
+___
+}
+
+$code.=<<___;
+	mov		OPENSSL_ia32cap_P+8(%rip),%r10d
+	cmp		\$512,$len
+	jb		.Lskip_avx512
+	test		\$`1<<16`,%r10d		# check for AVX512F
+	jz		.Lskip_avx512
+
+	sub		\$0x240,%rsp
+	and		\$-64,%rsp
+	vpbroadcastq	64(%rcx),$MASK		# .Lmask26
+
+	################################################################
+	# calculate [r^6,r^5,r^8,r^7] = [r^2,r,r^4,r^3] * r^4 (lanes 4-7
+	# are don't care)
+	vpmovzxdq	`16*0-64`($ctx),$A0
+	vpmovzxdq	`16*1-64`($ctx),$A1
+	vpmovzxdq	`16*3-64`($ctx),$A2
+	vpmovzxdq	`16*5-64`($ctx),$A3
+	vpmovzxdq	`16*7-64`($ctx),$A4
+___
+	foreach (0..4) { $code.="\tvpermq\t\t\$0xaa,$A[$_],$R[$_]\n"; }
+	foreach (1..4) {
+	    $code.="\tvpsllq\t\t\$2,$R[$_],$S[$_]\n";
+	    $code.="\tvpaddq\t\t$R[$_],$S[$_],$S[$_]\n";
+	}
+	&vpmul_avx512(\@A,\@R,\@S,\@D,$X,$PAD);
+	&lazy_reduce_avx512(\@D,\@D,$X,$PAD);
+$code.=<<___;
+
+	################################################################
+	# r^8 in all lanes for the loop, and [r^8,r^4,r^7,r^3,r^6,r^2,r^5,r]
+	# on stack for the last iteration
+	vmovdqa64	128(%rcx),$X		# .Lpermq_avx512
+___
+	foreach (0..4) {
+	    $code.=<<___;
+	vextracti32x4	\$1,$D[$_],%x#$R[$_]
+	vpbroadcastq	%x#$R[$_],$R[$_]
+	vpermt2q	$A[$_],$X,$D[$_]
+	vmovdqa64	$D[$_],`64*$_`(%rsp)
+___
+	    $code.=<<___	if ($_);
+	vpsllq		\$2,$R[$_],$S[$_]
+	vpsllq		\$2,$D[$_],$A[$_]
+	vpaddq		$R[$_],$S[$_],$S[$_]
+	vpaddq		$D[$_],$A[$_],$A[$_]
+	vmovdqa64	$A[$_],`64*(4+$_)`(%rsp)
+___
+	}
+$code.=<<___;
+	vpbroadcastq	32(%rcx),$PAD		# .L129
+
+	mov		$len,%r10
+	and		\$-128,%r10
+	and		\$127,$len		# 0 or 64 bytes are left for AVX2
+___
+	&load_input_avx512();
+$code.=<<___;
+	sub		\$128,%r10
+	jmp		.Loop_avx512
+
+.align	32
+.Loop_avx512:
+	################################################################
+	# ((inp[0]*r^8+r[8])*r^8+r[16])*r^8
+	# ((inp[1]*r^8+r[9])*r^8+r[17])*r^7
+	# ...
+	# ((inp[7]*r^8+r[15])*r^8+r[23])*r^1
+	#   \________/\________/
+	################################################################
+	vpaddq		$T0,$H0,$H0		# accumulate input
+	vpaddq		$T1,$H1,$H1
+	vpaddq		$T2,$H2,$H2
+	vpaddq		$T3,$H3,$H3
+	vpaddq		$T4,$H4,$H4
+___
+	&vpmul_avx512(\@H,\@R,\@S,\@D,$A0,$A1,$A2,$A3);
+	&load_input_avx512();
+	&lazy_reduce_avx512(\@D,\@H,$A0,$A1);
+$code.=<<___;
+	sub		\$128,%r10
+	jnz		.Loop_avx512
+
+	vpaddq		$T0,$H0,$H0
+	vpaddq		$T1,$H1,$H1
+	vpaddq		$T2,$H2,$H2
+	vpaddq		$T3,$H3,$H3
+	vpaddq		$T4,$H4,$H4
+___
+	&vpmul_avx512(\@H,[map("`64*$_`(%rsp)",(0..4))],
+			  [undef,map("`64*(4+$_)`(%rsp)",(1..4))],
+			  \@D,$A0,$A1,$A2,$A3);
+$code.=<<___;
+
+	################################################################
+	# horizontal addition, in VEX-encodable registers
+___
+	foreach (0..4) {
+	    $code.=<<___;
+	vextracti64x4	\$1,$D[$_],%y#$T[$_]
+	vpaddq		%y#$T[$_],%y#$D[$_],%y#$D[$_]
+___
+	}
+	foreach (0..4) {
+	    $code.=<<___;
+	vpsrldq		\$8,%y#$D[$_],%y#$T[$_]
+	vpaddq		%y#$T[$_],%y#$D[$_],%y#$D[$_]
+___
+	}
+	foreach (0..4) {
+	    $code.=<<___;
+	vpermq		\$0x2,%y#$D[$_],%y#$T[$_]
+	vpaddq		%y#$T[$_],%y#$D[$_],%y#$D[$_]
+___
+	}
+	&lazy_reduce_avx512(\@D,\@H,$A0,$A1);
+$code.=<<___;
+
+	test		$len,$len
+	jz		.Lstore_avx2
+
+	vmovq		%x#$H0,%x#$H0		# clear upper lanes
+	vmovq		%x#$H1,%x#$H1
+	vmovq		%x#$H2,%x#$H2
+	vmovq		%x#$H3,%x#$H3
+	vmovq		%x#$H4,%x#$H4
+
+.Lskip_avx512:
+___
+}
+$code.=<<___;
 
 	# expand and copy pre-calculated table to stack
 	vmovdqu		`16*0-64`($ctx),%x#$T2
@@ -1967,6 +2201,7 @@ $code.=<<___;
 	vpand		$MASK,$H3,$H3
 	vpaddq		$D3,$H4,$H4		# h3 -> h4
 
+.Lstore_avx2:
 	vmovd		%x#$H0,`4*0-48-64`($ctx)# save partially reduced
 	vmovd		%x#$H1,`4*1-48-64`($ctx)
 	vmovd		%x#$H2,`4*2-48-64`($ctx)
@@ -2007,6 +2242,8 @@ $code.=<<___;
 .long	0x3ffffff,0,0x3ffffff,0,0x3ffffff,0,0x3ffffff,0
 .Lfive:
 .long	5,0,5,0,5,0,5,0
+.Lpermq_avx512:
+.quad	2,10,3,11,0,8,1,9
 ___
 }
 
@@ -2260,7 +2497,8 @@ foreach (split('\n',$code)) {
 	s/\`([^\`]*)\`/eval($1)/ge;
 	s/%r([a-z]+)#d/%e$1/g;
 	s/%r([0-9]+)#d/%r$1d/g;
-	s/%x#%y/%x/g;
+	s/%x#%[yz]/%x/g;
+	s/%y#%z/%y/g;
 
 	print $_,"\n";
 }
@@ -304,6 +304,13 @@ void RSA_set_flags(RSA *r, int flags)
     r->flags |= flags;
 }
 
+int RSA_set_thread_pool(RSA *rsa, CRYPTO_RUN_TASKS *run, void *pool)
+{
+    rsa->run_tasks = run;
+    rsa->task_pool = pool;
+    return 1;
+}
+
 ENGINE *RSA_get0_engine(RSA *r)
 {
     return r->engine;
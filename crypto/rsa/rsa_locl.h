@@ -43,6 +43,9 @@ struct rsa_st {
     BN_BLINDING *blinding;
     BN_BLINDING *mt_blinding;
     CRYPTO_RWLOCK *lock;
+    /* runs the CRT halves of private key operations concurrently */
+    CRYPTO_RUN_TASKS *run_tasks;
+    void *task_pool;
 };
 
 struct rsa_meth_st {
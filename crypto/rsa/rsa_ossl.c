@@ -8,6 +8,7 @@
  */
 
 #include "internal/cryptlib.h"
+#include "internal/cryptlib_int.h"
 #include "internal/bn_int.h"
 #include "rsa_locl.h"
 
@@ -74,7 +75,7 @@ static int rsa_ossl_public_encrypt(int flen, const unsigned char *from,
         }
     }
 
-    if ((ctx = BN_CTX_new()) == NULL)
+    if ((ctx = bn_ctx_thread_get(BN_num_bits(rsa->n))) == NULL)
         goto err;
     BN_CTX_start(ctx);
     f = BN_CTX_get(ctx);
@@ -138,7 +139,7 @@ static int rsa_ossl_public_encrypt(int flen, const unsigned char *from,
  err:
     if (ctx != NULL)
         BN_CTX_end(ctx);
-    BN_CTX_free(ctx);
+    bn_ctx_thread_put(ctx);
     OPENSSL_clear_free(buf, num);
     return (r);
 }
@@ -235,7 +236,7 @@ static int rsa_ossl_private_encrypt(int flen, const unsigned char *from,
     BIGNUM *unblind = NULL;
     BN_BLINDING *blinding = NULL;
 
-    if ((ctx = BN_CTX_new()) == NULL)
+    if ((ctx = bn_ctx_thread_get(BN_num_bits(rsa->n))) == NULL)
         goto err;
     BN_CTX_start(ctx);
     f = BN_CTX_get(ctx);
@@ -348,7 +349,7 @@ static int rsa_ossl_private_encrypt(int flen, const unsigned char *from,
  err:
     if (ctx != NULL)
         BN_CTX_end(ctx);
-    BN_CTX_free(ctx);
+    bn_ctx_thread_put(ctx);
     OPENSSL_clear_free(buf, num);
     return (r);
 }
@@ -370,7 +371,7 @@ static int rsa_ossl_private_decrypt(int flen, const unsigned char *from,
     BIGNUM *unblind = NULL;
     BN_BLINDING *blinding = NULL;
 
-    if ((ctx = BN_CTX_new()) == NULL)
+    if ((ctx = bn_ctx_thread_get(BN_num_bits(rsa->n))) == NULL)
         goto err;
     BN_CTX_start(ctx);
     f = BN_CTX_get(ctx);
@@ -479,7 +480,7 @@ static int rsa_ossl_private_decrypt(int flen, const unsigned char *from,
  err:
     if (ctx != NULL)
         BN_CTX_end(ctx);
-    BN_CTX_free(ctx);
+    bn_ctx_thread_put(ctx);
     OPENSSL_clear_free(buf, num);
     return (r);
 }
@@ -512,7 +513,7 @@ static int rsa_ossl_public_decrypt(int flen, const unsigned char *from,
         }
     }
 
-    if ((ctx = BN_CTX_new()) == NULL)
+    if ((ctx = bn_ctx_thread_get(BN_num_bits(rsa->n))) == NULL)
         goto err;
     BN_CTX_start(ctx);
     f = BN_CTX_get(ctx);
@@ -578,19 +579,88 @@ static int rsa_ossl_public_decrypt(int flen, const unsigned char *from,
  err:
     if (ctx != NULL)
         BN_CTX_end(ctx);
-    BN_CTX_free(ctx);
+    bn_ctx_thread_put(ctx);
     OPENSSL_clear_free(buf, num);
     return (r);
 }
 
+typedef struct {
+    RSA *rsa;
+    BIGNUM *r;
+    const BIGNUM *a, *p, *m;
+    BN_MONT_CTX *mont;
+    int ret;
+} RSA_CRT_TASK;
+
+static void rsa_ossl_crt_task(void *arg)
+{
+    RSA_CRT_TASK *t = arg;
+    BN_CTX *ctx = bn_ctx_thread_get(BN_num_bits(t->m));
+
+    t->ret = ctx != NULL
+             && t->rsa->meth->bn_mod_exp(t->r, t->a, t->p, t->m, ctx,
+                                         t->mont);
+    bn_ctx_thread_put(ctx);
+}
+
+/*
+ * m1 = r1^dmq1 mod q and r0 = r2^dmp1 mod p. The two are independent, so
+ * they are handed to the thread pool if the caller set one up with
+ * RSA_set_thread_pool(), or computed side by side by
+ * BN_mod_exp_mont_consttime_x2() where that is what bn_mod_exp would do
+ * anyway.
+ */
+static int rsa_ossl_crt_exp(BIGNUM *m1, const BIGNUM *r1, const BIGNUM *dmq1,
+                            BIGNUM *r0, const BIGNUM *r2, const BIGNUM *dmp1,
+                            RSA *rsa, BN_CTX *ctx)
+{
+    if (rsa->run_tasks != NULL) {
+        RSA_CRT_TASK t[2];
+        void *args[2];
+
+        t[0].rsa = t[1].rsa = rsa;
+        t[0].r = m1;
+        t[0].a = r1;
+        t[0].p = dmq1;
+        t[0].m = rsa->q;
+        t[0].mont = rsa->_method_mod_q;
+        t[1].r = r0;
+        t[1].a = r2;
+        t[1].p = dmp1;
+        t[1].m = rsa->p;
+        t[1].mont = rsa->_method_mod_p;
+        t[0].ret = t[1].ret = 0;
+        args[0] = &t[0];
+        args[1] = &t[1];
+        if (!crypto_run_tasks(rsa->run_tasks, rsa->task_pool,
+                              rsa_ossl_crt_task, args, 2)) {
+            RSAerr(RSA_F_RSA_OSSL_CRT_EXP, RSA_R_TASKS_FAILED);
+            return 0;
+        }
+        return t[0].ret && t[1].ret;
+    }
+
+    if (rsa->meth->bn_mod_exp == BN_mod_exp_mont)
+        return BN_mod_exp_mont_consttime_x2(m1, r1, dmq1, rsa->q,
+                                            rsa->_method_mod_q,
+                                            r0, r2, dmp1, rsa->p,
+                                            rsa->_method_mod_p, ctx);
+
+    return rsa->meth->bn_mod_exp(m1, r1, dmq1, rsa->q, ctx,
+                                 rsa->_method_mod_q)
+           && rsa->meth->bn_mod_exp(r0, r2, dmp1, rsa->p, ctx,
+                                    rsa->_method_mod_p);
+}
+
 static int rsa_ossl_mod_exp(BIGNUM *r0, const BIGNUM *I, RSA *rsa, BN_CTX *ctx)
 {
-    BIGNUM *r1, *m1, *vrfy;
+    BIGNUM *r1, *r2, *m1, *vrfy;
     int ret = 0;
 
     BN_CTX_start(ctx);
 
     r1 = BN_CTX_get(ctx);
+    r2 = BN_CTX_get(ctx);
     m1 = BN_CTX_get(ctx);
     vrfy = BN_CTX_get(ctx);
 
@@ -631,39 +701,14 @@ static int rsa_ossl_mod_exp(BIGNUM *r0, const BIGNUM *I, RSA *rsa, BN_CTX *ctx)
             (&rsa->_method_mod_n, rsa->lock, rsa->n, ctx))
             goto err;
 
-    /* compute I mod q */
+    /* compute I mod q and I mod p */
     {
         BIGNUM *c = BN_new();
         if (c == NULL)
             goto err;
         BN_with_flags(c, I, BN_FLG_CONSTTIME);
 
-        if (!BN_mod(r1, c, rsa->q, ctx)) {
-            BN_free(c);
-            goto err;
-        }
-
-        {
-            BIGNUM *dmq1 = BN_new();
-            if (dmq1 == NULL) {
-                BN_free(c);
-                goto err;
-            }
-            BN_with_flags(dmq1, rsa->dmq1, BN_FLG_CONSTTIME);
-
-            /* compute r1^dmq1 mod q */
-            if (!rsa->meth->bn_mod_exp(m1, r1, dmq1, rsa->q, ctx,
-                rsa->_method_mod_q)) {
-                BN_free(c);
-                BN_free(dmq1);
-                goto err;
-            }
-            /* We MUST free dmq1 before any further use of rsa->dmq1 */
-            BN_free(dmq1);
-        }
-
-        /* compute I mod p */
-        if (!BN_mod(r1, c, rsa->p, ctx)) {
+        if (!BN_mod(r1, c, rsa->q, ctx) || !BN_mod(r2, c, rsa->p, ctx)) {
             BN_free(c);
             goto err;
         }
@@ -672,19 +717,24 @@ static int rsa_ossl_mod_exp(BIGNUM *r0, const BIGNUM *I, RSA *rsa, BN_CTX *ctx)
     }
 
     {
-        BIGNUM *dmp1 = BN_new();
-        if (dmp1 == NULL)
-            goto err;
-        BN_with_flags(dmp1, rsa->dmp1, BN_FLG_CONSTTIME);
+        BIGNUM *dmp1 = BN_new(), *dmq1 = BN_new();
+        int ok;
 
-        /* compute r1^dmp1 mod p */
-        if (!rsa->meth->bn_mod_exp(r0, r1, dmp1, rsa->p, ctx,
-                                   rsa->_method_mod_p)) {
+        if (dmp1 == NULL || dmq1 == NULL) {
             BN_free(dmp1);
+            BN_free(dmq1);
             goto err;
         }
-        /* We MUST free dmp1 before any further use of rsa->dmp1 */
+        BN_with_flags(dmp1, rsa->dmp1, BN_FLG_CONSTTIME);
+        BN_with_flags(dmq1, rsa->dmq1, BN_FLG_CONSTTIME);
+
+        /* compute r1^dmq1 mod q and r2^dmp1 mod p */
+        ok = rsa_ossl_crt_exp(m1, r1, dmq1, r0, r2, dmp1, rsa, ctx);
+        /* We MUST free dmp1 and dmq1 before any further use of rsa->dmp1 */
         BN_free(dmp1);
+        BN_free(dmq1);
+        if (!ok)
+            goto err;
     }
 
     if (!BN_sub(r0, r0, m1))
@@ -0,0 +1,305 @@
+/*
+ * Copyright 2016 The OpenSSL Project Authors. All Rights Reserved.
+ *
+ * Licensed under the OpenSSL license (the "License").  You may not use
+ * this file except in compliance with the License.  You can obtain a copy
+ * in the file LICENSE in the source distribution or at
+ * https://www.openssl.org/source/license.html
+ */
+
+#include <string.h>
+#include <openssl/crypto.h>
+#include <openssl/sha.h>
+
+/*
+ * Multi-buffer SHA-1 and SHA-256: hash a number of independent messages
+ * at once, keeping every SIMD lane of the multi-block assembly modules
+ * busy by refilling a lane as soon as the message in it is done.
+ */
+
+#if     defined(SHA256_ASM) &&  ( \
+        defined(__x86_64)       || defined(__x86_64__)  || \
+        defined(_M_AMD64)       || defined(_M_X64)      )
+
+extern unsigned int OPENSSL_ia32cap_P[];
+# define SSSE3_CAPABLE   (OPENSSL_ia32cap_P[1] & (1 << (41 - 32)))
+
+# define SHA_MB_LANES            8
+/*
+ * Below this many busy lanes the remaining messages are finished with the
+ * single-buffer code, which is faster than a mostly empty multi-block call.
+ */
+# define SHA_MB_MIN_LANES        3
+/* Upper bound on blocks per call, HASH_DESC counts blocks in an int */
+# define SHA_MB_MAX_BLOCKS       4096
+
+/* Layout expected by sha1_multi_block() and sha256_multi_block() */
+typedef struct {
+    unsigned int h[8][SHA_MB_LANES];
+} SHA_MB_STATE;
+typedef struct {
+    const unsigned char *ptr;
+    int blocks;
+} HASH_DESC;
+
+void sha1_multi_block(SHA_MB_STATE *, const HASH_DESC *, int);
+void sha256_multi_block(SHA_MB_STATE *, const HASH_DESC *, int);
+void sha1_block_data_order(SHA_CTX *c, const void *p, size_t num);
+void sha256_block_data_order(SHA256_CTX *ctx, const void *in, size_t num);
+
+typedef struct {
+    int words;                  /* digest length in 32-bit words */
+    const unsigned int *iv;
+    void (*multi_block) (SHA_MB_STATE *, const HASH_DESC *, int);
+    void (*block) (unsigned int *h, const unsigned char *in, size_t blocks);
+} SHA_MB_METHOD;
+
+typedef struct {
+    size_t msg;                 /* index of the message in this lane */
+    const unsigned char *ptr;   /* next block to hash */
+    size_t blocks;              /* blocks left at |ptr| */
+    int tail;                   /* |ptr| points into |pad| */
+    unsigned char pad[2 * SHA_CBLOCK];
+} SHA_MB_LANE;
+
+static void sha1_mb_block(unsigned int *h, const unsigned char *in,
+                          size_t blocks)
+{
+    SHA_CTX c;
+
+    c.h0 = h[0];
+    c.h1 = h[1];
+    c.h2 = h[2];
+    c.h3 = h[3];
+    c.h4 = h[4];
+    sha1_block_data_order(&c, in, blocks);
+    h[0] = c.h0;
+    h[1] = c.h1;
+    h[2] = c.h2;
+    h[3] = c.h3;
+    h[4] = c.h4;
+}
+
+static void sha256_mb_block(unsigned int *h, const unsigned char *in,
+                            size_t blocks)
+{
+    SHA256_CTX c;
+
+    memcpy(c.h, h, sizeof(c.h));
+    sha256_block_data_order(&c, in, blocks);
+    memcpy(h, c.h, sizeof(c.h));
+}
+
+static const unsigned int sha1_iv[5] = {
+    0x67452301UL, 0xefcdab89UL, 0x98badcfeUL, 0x10325476UL, 0xc3d2e1f0UL
+};
+
+static const unsigned int sha256_iv[8] = {
+    0x6a09e667UL, 0xbb67ae85UL, 0x3c6ef372UL, 0xa54ff53aUL,
+    0x510e527fUL, 0x9b05688cUL, 0x1f83d9abUL, 0x5be0cd19UL
+};
+
+static const SHA_MB_METHOD sha1_mb_method = {
+    SHA_DIGEST_LENGTH / 4, sha1_iv, sha1_multi_block, sha1_mb_block
+};
+
+static const SHA_MB_METHOD sha256_mb_method = {
+    SHA256_DIGEST_LENGTH / 4, sha256_iv, sha256_multi_block, sha256_mb_block
+};
+
+/* Point |lane| at the final, padded block(s) of a message of |len| bytes */
+static void sha_mb_set_tail(SHA_MB_LANE *lane, const unsigned char *rem,
+                            size_t len)
+{
+    size_t off = len % SHA_CBLOCK, end;
+    unsigned long long bits = (unsigned long long)len << 3;
+
+    memcpy(lane->pad, rem, off);
+    lane->pad[off++] = 0x80;
+    end = off <= SHA_CBLOCK - 8 ? SHA_CBLOCK : 2 * SHA_CBLOCK;
+    memset(lane->pad + off, 0, end - off);
+    for (off = end; off > end - 8; bits >>= 8)
+        lane->pad[--off] = (unsigned char)bits;
+
+    lane->ptr = lane->pad;
+    lane->blocks = end / SHA_CBLOCK;
+    lane->tail = 1;
+}
+
+static void sha_mb_start(const SHA_MB_METHOD *meth, SHA_MB_STATE *st,
+                         SHA_MB_LANE *lane, int i,
+                         const unsigned char *const d[], const size_t n[],
+                         size_t msg)
+{
+    int w;
+
+    for (w = 0; w < meth->words; w++)
+        st->h[w][i] = meth->iv[w];
+    lane->msg = msg;
+    lane->ptr = d[msg];
+    lane->blocks = n[msg] / SHA_CBLOCK;
+    lane->tail = 0;
+    if (lane->blocks == 0)
+        sha_mb_set_tail(lane, d[msg], n[msg]);
+}
+
+static void sha_mb_output(const SHA_MB_METHOD *meth, const SHA_MB_STATE *st,
+                          int i, unsigned char *md)
+{
+    int w;
+
+    for (w = 0; w < meth->words; w++) {
+        unsigned int h = st->h[w][i];
+
+        *md++ = (unsigned char)(h >> 24);
+        *md++ = (unsigned char)(h >> 16);
+        *md++ = (unsigned char)(h >> 8);
+        *md++ = (unsigned char)h;
+    }
+}
+
+/*
+ * Advance |lane| past |blocks| blocks. Returns 1 once the message in it has
+ * been completely hashed.
+ */
+static int sha_mb_advance(SHA_MB_LANE *lane, size_t blocks,
+                          const unsigned char *const d[], const size_t n[])
+{
+    size_t msg = lane->msg;
+
+    lane->ptr += blocks * SHA_CBLOCK;
+    lane->blocks -= blocks;
+    if (lane->blocks != 0)
+        return 0;
+    if (lane->tail)
+        return 1;
+    sha_mb_set_tail(lane, d[msg] + (n[msg] & ~(size_t)(SHA_CBLOCK - 1)),
+                    n[msg]);
+    return 0;
+}
+
+static void sha_mb(const SHA_MB_METHOD *meth, const unsigned char *const d[],
+                   const size_t n[], unsigned char *const md[], size_t num)
+{
+    unsigned char storage[sizeof(SHA_MB_STATE) + 32];
+    SHA_MB_STATE *st;
+    SHA_MB_LANE lanes[SHA_MB_LANES];
+    HASH_DESC desc[SHA_MB_LANES];
+    size_t next = 0, step;
+    int i, w, active = 0;
+
+    /* the assembly wants 32-byte alignment for AVX2 */
+    st = (SHA_MB_STATE *)(storage + 32 - ((size_t)storage % 32));
+
+    for (;;) {
+        while (active < SHA_MB_LANES && next < num) {
+            sha_mb_start(meth, st, &lanes[active], active, d, n, next++);
+            active++;
+        }
+        if (active < SHA_MB_MIN_LANES)
+            break;
+
+        /*
+         * Hash as many blocks as the shortest lane has left, so that no lane
+         * idles while others are still busy.
+         */
+        step = SHA_MB_MAX_BLOCKS;
+        for (i = 0; i < active; i++)
+            if (lanes[i].blocks < step)
+                step = lanes[i].blocks;
+        for (i = 0; i < SHA_MB_LANES; i++) {
+            desc[i].ptr = lanes[i < active ? i : 0].ptr;
+            desc[i].blocks = i < active ? (int)step : 0;
+        }
+        /*
+         * With 1 the assembly hashes lanes 0-3 only. Busy lanes are kept at
+         * the bottom because it stops at the first group of 4 idle lanes.
+         */
+        meth->multi_block(st, desc, active > 4 ? 2 : 1);
+
+        /* Downwards, so that a lane moved into a finished one is done */
+        for (i = active - 1; i >= 0; i--) {
+            if (!sha_mb_advance(&lanes[i], step, d, n))
+                continue;
+            sha_mb_output(meth, st, i, md[lanes[i].msg]);
+            if (next < num) {
+                sha_mb_start(meth, st, &lanes[i], i, d, n, next++);
+                continue;
+            }
+            if (i != --active) {
+                lanes[i] = lanes[active];
+                if (lanes[i].tail)
+                    lanes[i].ptr = lanes[i].pad
+                                   + (lanes[active].ptr - lanes[active].pad);
+                for (w = 0; w < meth->words; w++)
+                    st->h[w][i] = st->h[w][active];
+            }
+        }
+    }
+
+    /* Too few messages left to be worth the multi-block code */
+    for (i = 0; i < active; i++) {
+        unsigned int h[8];
+
+        for (w = 0; w < meth->words; w++)
+            h[w] = st->h[w][i];
+        do {
+            meth->block(h, lanes[i].ptr, lanes[i].blocks);
+        } while (!sha_mb_advance(&lanes[i], lanes[i].blocks, d, n));
+        for (w = 0; w < meth->words; w++)
+            st->h[w][i] = h[w];
+        sha_mb_output(meth, st, i, md[lanes[i].msg]);
+        OPENSSL_cleanse(h, sizeof(h));
+    }
+
+    OPENSSL_cleanse(storage, sizeof(storage));
+    OPENSSL_cleanse(lanes, sizeof(lanes));
+}
+
+void SHA1_mb(const unsigned char *const d[], const size_t n[],
+             unsigned char *const md[], size_t num)
+{
+    size_t i;
+
+    if (SSSE3_CAPABLE) {
+        sha_mb(&sha1_mb_method, d, n, md, num);
+        return;
+    }
+    for (i = 0; i < num; i++)
+        SHA1(d[i], n[i], md[i]);
+}
+
+void SHA256_mb(const unsigned char *const d[], const size_t n[],
+               unsigned char *const md[], size_t num)
+{
+    size_t i;
+
+    if (SSSE3_CAPABLE) {
+        sha_mb(&sha256_mb_method, d, n, md, num);
+        return;
+    }
+    for (i = 0; i < num; i++)
+        SHA256(d[i], n[i], md[i]);
+}
+
+#else
+
+void SHA1_mb(const unsigned char *const d[], const size_t n[],
+             unsigned char *const md[], size_t num)
+{
+    size_t i;
+
+    for (i = 0; i < num; i++)
+        SHA1(d[i], n[i], md[i]);
+}
+
+void SHA256_mb(const unsigned char *const d[], const size_t n[],
+               unsigned char *const md[], size_t num)
+{
+    size_t i;
+
+    for (i = 0; i < num; i++)
+        SHA256(d[i], n[i], md[i]);
+}
+
+#endif
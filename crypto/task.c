@@ -0,0 +1,97 @@
+/*
+ * Copyright 2016 The OpenSSL Project Authors. All Rights Reserved.
+ *
+ * Licensed under the OpenSSL license (the "License").  You may not use
+ * this file except in compliance with the License.  You can obtain a copy
+ * in the file LICENSE in the source distribution or at
+ * https://www.openssl.org/source/license.html
+ */
+
+#include "internal/cryptlib_int.h"
+#include <openssl/err.h>
+
+/*
+ * A task as handed to the application's CRYPTO_RUN_TASKS callback. Errors
+ * that |task| leaves on a thread other than the caller's are collected here
+ * and put back on the caller's error queue once all tasks have finished.
+ */
+typedef struct {
+    void (*task) (void *arg);
+    void *arg;
+    CRYPTO_THREAD_ID caller;
+    int num_errs;
+    struct {
+        unsigned long code;
+        const char *file;
+        int line;
+        char *data;
+    } errs[ERR_NUM_ERRORS];
+} CRYPTO_TASK;
+
+static void crypto_task(void *arg)
+{
+    CRYPTO_TASK *t = arg;
+    unsigned long code;
+    const char *file, *data;
+    int line, flags;
+
+    if (CRYPTO_THREAD_compare_id(t->caller, CRYPTO_THREAD_get_current_id())) {
+        t->task(t->arg);
+        return;
+    }
+
+    ERR_clear_error();
+    t->task(t->arg);
+    while ((code = ERR_get_error_line_data(&file, &line, &data, &flags)) != 0) {
+        if (t->num_errs == ERR_NUM_ERRORS)
+            continue;
+        t->errs[t->num_errs].code = code;
+        t->errs[t->num_errs].file = file;
+        t->errs[t->num_errs].line = line;
+        t->errs[t->num_errs].data = (flags & ERR_TXT_STRING) != 0
+                                    ? OPENSSL_strdup(data) : NULL;
+        t->num_errs++;
+    }
+}
+
+int crypto_run_tasks(CRYPTO_RUN_TASKS *run, void *pool,
+                     void (*task) (void *arg), void *args[], size_t num)
+{
+    CRYPTO_TASK *t;
+    void **targs;
+    size_t i;
+    int j, ret = 0;
+
+    t = OPENSSL_zalloc(num * sizeof(*t));
+    targs = OPENSSL_malloc(num * sizeof(*targs));
+    if (t == NULL || targs == NULL) {
+        CRYPTOerr(CRYPTO_F_CRYPTO_RUN_TASKS, ERR_R_MALLOC_FAILURE);
+        goto err;
+    }
+    for (i = 0; i < num; i++) {
+        t[i].task = task;
+        t[i].arg = args[i];
+        t[i].caller = CRYPTO_THREAD_get_current_id();
+        targs[i] = &t[i];
+    }
+
+    ret = run(pool, crypto_task, targs, num);
+
+    for (i = 0; i < num; i++) {
+        for (j = 0; j < t[i].num_errs; j++) {
+            unsigned long code = t[i].errs[j].code;
+
+            ERR_put_error(ERR_GET_LIB(code), ERR_GET_FUNC(code),
+                          ERR_GET_REASON(code), t[i].errs[j].file,
+                          t[i].errs[j].line);
+            if (t[i].errs[j].data != NULL)
+                ERR_set_error_data(t[i].errs[j].data,
+                                   ERR_TXT_MALLOCED | ERR_TXT_STRING);
+        }
+    }
+
+ err:
+    OPENSSL_free(t);
+    OPENSSL_free(targs);
+    return ret;
+}
@@ -8,6 +8,7 @@
  */
 
 #include <openssl/crypto.h>
+#include "internal/cryptlib_int.h"
 
 #if defined(OPENSSL_THREADS) && !defined(CRYPTO_TDEBUG) && !defined(OPENSSL_SYS_WINDOWS)
 
@@ -125,4 +126,30 @@ int CRYPTO_atomic_add(int *val, int amount, int *ret, CRYPTO_RWLOCK *lock)
     return 1;
 }
 
+int crypto_atomic_load_ptr(void **ptr, void **ret, CRYPTO_RWLOCK *lock)
+{
+#ifdef __ATOMIC_ACQUIRE
+    *ret = __atomic_load_n(ptr, __ATOMIC_ACQUIRE);
+#else
+    if (!CRYPTO_THREAD_read_lock(lock))
+        return 0;
+
+    *ret = *ptr;
+
+    if (!CRYPTO_THREAD_unlock(lock))
+        return 0;
+#endif
+
+    return 1;
+}
+
+void crypto_atomic_store_ptr(void **ptr, void *val)
+{
+#ifdef __ATOMIC_RELEASE
+    __atomic_store_n(ptr, val, __ATOMIC_RELEASE);
+#else
+    *ptr = val;
+#endif
+}
+
 #endif
@@ -54,6 +54,7 @@ extern "C" {
 # define BIO_TYPE_BIO            (19|0x0400)/* (half a) BIO pair */
 # define BIO_TYPE_LINEBUFFER     (20|0x0200)/* filter */
 # define BIO_TYPE_DGRAM          (21|0x0400|0x0100)
+# define BIO_TYPE_DGRAM_MMSG     (25|0x0400|0x0100)
 # ifndef OPENSSL_NO_SCTP
 #  define BIO_TYPE_DGRAM_SCTP     (24|0x0400|0x0100)
 # endif
@@ -146,6 +147,12 @@ extern "C" {
 #  define BIO_CTRL_DGRAM_SCTP_SAVE_SHUTDOWN               70
 # endif
 
+/* BIO_s_datagram_mmsg() only */
+# define BIO_CTRL_DGRAM_SET_READ_BATCH   71/* datagrams per recvmmsg() */
+# define BIO_CTRL_DGRAM_SET_WRITE_BATCH  72/* datagrams queued until flush */
+# define BIO_CTRL_DGRAM_SET_GSO          73/* use UDP GSO when possible */
+# define BIO_CTRL_DGRAM_GET_QUEUED       74/* datagrams received, not read */
+
 /* modifiers */
 # define BIO_FP_READ             0x02
 # define BIO_FP_WRITE            0x04
@@ -512,6 +519,14 @@ int BIO_ctrl_reset_read_request(BIO *b);
          (int)BIO_ctrl(b, BIO_CTRL_DGRAM_SET_PEER, 0, (char *)peer)
 # define BIO_dgram_get_mtu_overhead(b) \
          (unsigned int)BIO_ctrl((b), BIO_CTRL_DGRAM_GET_MTU_OVERHEAD, 0, NULL)
+# define BIO_dgram_set_read_batch(b,n) \
+         (int)BIO_ctrl((b), BIO_CTRL_DGRAM_SET_READ_BATCH, (n), NULL)
+# define BIO_dgram_set_write_batch(b,n) \
+         (int)BIO_ctrl((b), BIO_CTRL_DGRAM_SET_WRITE_BATCH, (n), NULL)
+# define BIO_dgram_set_gso(b,on) \
+         (int)BIO_ctrl((b), BIO_CTRL_DGRAM_SET_GSO, (on), NULL)
+# define BIO_dgram_get_queued(b) \
+         (int)BIO_ctrl((b), BIO_CTRL_DGRAM_GET_QUEUED, 0, NULL)
 
 #define BIO_get_ex_new_index(l, p, newf, dupf, freef) \
     CRYPTO_get_ex_new_index(CRYPTO_EX_INDEX_BIO, l, p, newf, dupf, freef)
@@ -595,6 +610,8 @@ const BIO_METHOD *BIO_f_nbio_test(void);
 const BIO_METHOD *BIO_s_datagram(void);
 int BIO_dgram_non_fatal_error(int error);
 BIO *BIO_new_dgram(int fd, int close_flag);
+const BIO_METHOD *BIO_s_datagram_mmsg(void);
+BIO *BIO_new_dgram_mmsg(int fd, int close_flag);
 #  ifndef OPENSSL_NO_SCTP
 const BIO_METHOD *BIO_s_datagram_sctp(void);
 BIO *BIO_new_dgram_sctp(int fd, int close_flag);
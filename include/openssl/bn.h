@@ -106,6 +106,9 @@ void BN_GENCB_set(BN_GENCB *gencb, int (*callback) (int, int, BN_GENCB *),
 
 void *BN_GENCB_get_arg(BN_GENCB *cb);
 
+int BN_GENCB_set_thread_pool(BN_GENCB *gencb, CRYPTO_RUN_TASKS *run,
+                             void *pool, int tasks);
+
 # define BN_prime_checks 0      /* default: select number of iterations based
                                  * on the size of the number */
 
@@ -152,6 +155,7 @@ const BIGNUM *BN_value_one(void);
 char *BN_options(void);
 BN_CTX *BN_CTX_new(void);
 BN_CTX *BN_CTX_secure_new(void);
+BN_CTX *BN_CTX_arena_new(int bits);
 void BN_CTX_free(BN_CTX *c);
 void BN_CTX_start(BN_CTX *ctx);
 BIGNUM *BN_CTX_get(BN_CTX *ctx);
@@ -235,6 +239,12 @@ int BN_mod_exp_mont(BIGNUM *r, const BIGNUM *a, const BIGNUM *p,
 int BN_mod_exp_mont_consttime(BIGNUM *rr, const BIGNUM *a, const BIGNUM *p,
                               const BIGNUM *m, BN_CTX *ctx,
                               BN_MONT_CTX *in_mont);
+int BN_mod_exp_mont_consttime_x2(BIGNUM *rr1, const BIGNUM *a1,
+                                 const BIGNUM *p1, const BIGNUM *m1,
+                                 BN_MONT_CTX *in_mont1,
+                                 BIGNUM *rr2, const BIGNUM *a2,
+                                 const BIGNUM *p2, const BIGNUM *m2,
+                                 BN_MONT_CTX *in_mont2, BN_CTX *ctx);
 int BN_mod_exp_mont_word(BIGNUM *r, BN_ULONG a, const BIGNUM *p,
                          const BIGNUM *m, BN_CTX *ctx, BN_MONT_CTX *m_ctx);
 int BN_mod_exp2_mont(BIGNUM *r, const BIGNUM *a1, const BIGNUM *p1,
@@ -512,6 +522,7 @@ void ERR_load_BN_strings(void);
 # define BN_F_BN_GENCB_NEW                                143
 # define BN_F_BN_GENERATE_DSA_NONCE                       140
 # define BN_F_BN_GENERATE_PRIME_EX                        141
+# define BN_F_BN_GENERATE_PRIME_MT                        147
 # define BN_F_BN_GF2M_MOD                                 131
 # define BN_F_BN_GF2M_MOD_EXP                             132
 # define BN_F_BN_GF2M_MOD_MUL                             133
@@ -557,6 +568,7 @@ void ERR_load_BN_strings(void);
 # define BN_R_NO_SOLUTION                                 116
 # define BN_R_PRIVATE_KEY_TOO_LARGE                       117
 # define BN_R_P_IS_NOT_PRIME                              112
+# define BN_R_TASKS_FAILED                                120
 # define BN_R_TOO_MANY_ITERATIONS                         113
 # define BN_R_TOO_MANY_TEMPORARY_VARIABLES                109
 
@@ -143,6 +143,11 @@ DH *DH_get_1024_160(void);
 DH *DH_get_2048_224(void);
 DH *DH_get_2048_256(void);
 
+/* RFC 7919 parameters */
+DH *DH_get_ffdhe2048(void);
+DH *DH_get_ffdhe3072(void);
+DH *DH_get_ffdhe4096(void);
+
 # ifndef OPENSSL_NO_CMS
 /* RFC2631 KDF */
 int DH_KDF_X9_42(unsigned char *out, size_t outlen,
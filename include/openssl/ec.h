@@ -694,6 +694,16 @@ int EC_GROUP_precompute_mult(EC_GROUP *group, BN_CTX *ctx);
  */
 int EC_GROUP_have_precompute_mult(const EC_GROUP *group);
 
+/** Stores multiples of an arbitrary point for faster repeated
+ *  multiplication of that point, e.g. in ECDH with a long-lived peer key
+ *  \param  group  underlying EC_GROUP object
+ *  \param  point  EC_POINT object
+ *  \param  ctx    BN_CTX object (optional)
+ *  \return 1 on success and 0 if an error occurred
+ */
+int EC_POINT_precompute_mult(const EC_GROUP *group, EC_POINT *point,
+                             BN_CTX *ctx);
+
 /********************************************************************/
 /*                       ASN1 stuff                                 */
 /********************************************************************/
@@ -848,6 +858,14 @@ void EC_KEY_set_asn1_flag(EC_KEY *eckey, int asn1_flag);
  */
 int EC_KEY_precompute_mult(EC_KEY *key, BN_CTX *ctx);
 
+/** Creates a table of pre-computed multiples of the public key to
+ *  accelerate ECDH with it as the peer key.
+ *  \param  key  EC_KEY object
+ *  \param  ctx  BN_CTX object (optional)
+ *  \return 1 on success and 0 if an error occurred.
+ */
+int EC_KEY_precompute_public_mult(EC_KEY *key, BN_CTX *ctx);
+
 /** Creates a new ec private (and optional a new public) key.
  *  \param  key  EC_KEY object
  *  \return 1 on success and 0 if an error occurred.
@@ -1177,6 +1195,21 @@ int ECDSA_verify(int type, const unsigned char *dgst, int dgstlen,
  */
 int ECDSA_size(const EC_KEY *eckey);
 
+/** Verifies a batch of Ed25519 signatures at once, which is considerably
+ *  faster than verifying them one by one
+ *  \param  msgs     the signed messages
+ *  \param  msglens  the lengths of the messages
+ *  \param  sigs     the 64 byte signatures
+ *  \param  pubkeys  the 32 byte encoded public keys
+ *  \param  num      number of signatures
+ *  \return 1 if all signatures are valid, 0 if at least one is invalid
+ *          and -1 on error
+ */
+int ED25519_verify_batch(const unsigned char *const *msgs,
+                         const size_t *msglens,
+                         const unsigned char *const *sigs,
+                         const unsigned char *const *pubkeys, size_t num);
+
 /********************************************************************/
 /*  EC_KEY_METHOD constructors, destructors, writers and accessors  */
 /********************************************************************/
@@ -1392,9 +1425,15 @@ void ERR_load_EC_strings(void);
 # define EC_F_ECPKPARAMETERS_PRINT_FP                     150
 # define EC_F_ECP_NISTZ256_GET_AFFINE                     240
 # define EC_F_ECP_NISTZ256_MULT_PRECOMPUTE                243
+# define EC_F_ECP_NISTZ256_PIPPENGER_MUL                  272
+# define EC_F_ECP_NISTZ256_POINT_PRECOMPUTE_MULT          266
 # define EC_F_ECP_NISTZ256_POINTS_MUL                     241
 # define EC_F_ECP_NISTZ256_PRE_COMP_NEW                   244
 # define EC_F_ECP_NISTZ256_WINDOWED_MUL                   242
+# define EC_F_ECP_NISTZ384_GET_AFFINE                     267
+# define EC_F_ECP_NISTZ384_PIPPENGER_MUL                  273
+# define EC_F_ECP_NISTZ384_POINTS_MUL                     268
+# define EC_F_ECP_NISTZ384_WINDOWED_MUL                   269
 # define EC_F_EC_ASN1_GROUP2CURVE                         153
 # define EC_F_EC_ASN1_GROUP2FIELDID                       154
 # define EC_F_EC_GF2M_MONTGOMERY_POINT_MULTIPLY           208
@@ -1463,6 +1502,7 @@ void ERR_load_EC_strings(void);
 # define EC_F_EC_KEY_SIMPLE_CHECK_KEY                     258
 # define EC_F_EC_KEY_SIMPLE_OCT2PRIV                      259
 # define EC_F_EC_KEY_SIMPLE_PRIV2OCT                      260
+# define EC_F_EC_PIPPENGER_MUL                            271
 # define EC_F_EC_POINTS_MAKE_AFFINE                       136
 # define EC_F_EC_POINT_ADD                                112
 # define EC_F_EC_POINT_CMP                                113
@@ -1478,6 +1518,7 @@ void ERR_load_EC_strings(void);
 # define EC_F_EC_POINT_NEW                                121
 # define EC_F_EC_POINT_OCT2POINT                          122
 # define EC_F_EC_POINT_POINT2OCT                          123
+# define EC_F_EC_POINT_PRECOMPUTE_MULT                    265
 # define EC_F_EC_POINT_SET_AFFINE_COORDINATES_GF2M        185
 # define EC_F_EC_POINT_SET_AFFINE_COORDINATES_GFP         124
 # define EC_F_EC_POINT_SET_COMPRESSED_COORDINATES_GF2M    186
@@ -1487,6 +1528,7 @@ void ERR_load_EC_strings(void);
 # define EC_F_EC_PRE_COMP_NEW                             196
 # define EC_F_EC_WNAF_MUL                                 187
 # define EC_F_EC_WNAF_PRECOMPUTE_MULT                     188
+# define EC_F_ED25519_VERIFY_BATCH                        270
 # define EC_F_I2D_ECPARAMETERS                            190
 # define EC_F_I2D_ECPKPARAMETERS                          191
 # define EC_F_I2D_ECPRIVATEKEY                            192
@@ -4316,6 +4316,14 @@
 #define LN_chacha20             "chacha20"
 #define NID_chacha20            1019
 
+#define SN_aes_128_gcm_siv              "AES-128-GCM-SIV"
+#define LN_aes_128_gcm_siv              "aes-128-gcm-siv"
+#define NID_aes_128_gcm_siv             1058
+
+#define SN_aes_256_gcm_siv              "AES-256-GCM-SIV"
+#define LN_aes_256_gcm_siv              "aes-256-gcm-siv"
+#define NID_aes_256_gcm_siv             1059
+
 #define SN_dhpublicnumber               "dhpublicnumber"
 #define LN_dhpublicnumber               "X9.42 DH"
 #define NID_dhpublicnumber              920
@@ -4496,6 +4504,10 @@
 #define NID_X448                1035
 #define OBJ_X448                1L,3L,6L,1L,4L,1L,11591L,15L,2L
 
+#define SN_ED25519              "ED25519"
+#define NID_ED25519             1060
+#define OBJ_ED25519             1L,3L,101L,112L
+
 #define SN_kx_rsa               "KxRSA"
 #define LN_kx_rsa               "kx-rsa"
 #define NID_kx_rsa              1037
@@ -403,6 +403,13 @@ typedef int (*custom_ext_parse_cb) (SSL *s, unsigned int ext_type,
  * Support Asynchronous operation
  */
 # define SSL_MODE_ASYNC 0x00000100U
+/*
+ * Let SSL_read() read the ciphertext of AEAD protected records straight into
+ * the caller's buffer and decrypt it there whenever the whole record fits,
+ * bypassing the internal read buffer. A retried SSL_read() must then be
+ * passed the same buffer.
+ */
+# define SSL_MODE_DECRYPT_IN_PLACE 0x00000200U
 
 /* Cert related flags */
 /*
@@ -1458,6 +1465,15 @@ __owur int SSL_CTX_set_session_id_context(SSL_CTX *ctx, const unsigned char *sid
 SSL *SSL_new(SSL_CTX *ctx);
 int SSL_up_ref(SSL *s);
 int SSL_is_dtls(const SSL *s);
+
+/* Components reported by SSL_get_memory_usage() */
+# define SSL_MEM_USAGE_TOTAL             0
+# define SSL_MEM_USAGE_OBJECTS           1
+# define SSL_MEM_USAGE_RECORD_BUFFERS    2
+# define SSL_MEM_USAGE_HANDSHAKE         3
+# define SSL_MEM_USAGE_CRYPTO            4
+# define SSL_MEM_USAGE_CERT              5
+size_t SSL_get_memory_usage(const SSL *s, int component);
 __owur int SSL_set_session_id_context(SSL *ssl, const unsigned char *sid_ctx,
                                unsigned int sid_ctx_len);
 
@@ -1528,6 +1544,8 @@ __owur int SSL_accept(SSL *ssl);
 __owur int SSL_connect(SSL *ssl);
 __owur int SSL_read(SSL *ssl, void *buf, int num);
 __owur int SSL_peek(SSL *ssl, void *buf, int num);
+__owur int SSL_read_view(SSL *ssl, const unsigned char **data, size_t *len);
+int SSL_release_view(SSL *ssl, size_t num);
 __owur int SSL_write(SSL *ssl, const void *buf, int num);
 long SSL_ctrl(SSL *ssl, int cmd, long larg, void *parg);
 long SSL_callback_ctrl(SSL *, int, void (*)(void));
@@ -2131,6 +2149,8 @@ void ERR_load_SSL_strings(void);
 # define SSL_F_SSL_PARSE_SERVERHELLO_USE_SRTP_EXT         311
 # define SSL_F_SSL_PEEK                                   270
 # define SSL_F_SSL_READ                                   223
+# define SSL_F_SSL_READ_VIEW                              409
+# define SSL_F_SSL_RELEASE_VIEW                           410
 # define SSL_F_SSL_SCAN_CLIENTHELLO_TLSEXT                320
 # define SSL_F_SSL_SCAN_SERVERHELLO_TLSEXT                321
 # define SSL_F_SSL_SESSION_DUP                            348
@@ -2227,6 +2247,7 @@ void ERR_load_SSL_strings(void);
 # define SSL_R_BAD_LENGTH                                 271
 # define SSL_R_BAD_PACKET_LENGTH                          115
 # define SSL_R_BAD_PROTOCOL_VERSION_NUMBER                116
+# define SSL_R_BAD_READ_RETRY                             408
 # define SSL_R_BAD_RSA_ENCRYPT                            119
 # define SSL_R_BAD_SIGNATURE                              123
 # define SSL_R_BAD_SRP_A_LENGTH                           347
@@ -217,6 +217,12 @@ extern "C" {
 # define TLSEXT_curve_P_256                              23
 # define TLSEXT_curve_P_384                              24
 
+/* Finite field groups from RFC 7919 */
+
+# define TLSEXT_ffdhe2048                                256
+# define TLSEXT_ffdhe3072                                257
+# define TLSEXT_ffdhe4096                                258
+
 # define TLSEXT_MAXLEN_host_name 255
 
 __owur const char *SSL_get_servername(const SSL *s, const int type);
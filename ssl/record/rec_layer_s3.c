@@ -58,6 +58,10 @@ void RECORD_LAYER_clear(RECORD_LAYER *rl)
     rl->wpend_type = 0;
     rl->wpend_ret = 0;
     rl->wpend_buf = NULL;
+    rl->inplace_buf = NULL;
+    rl->inplace_len = 0;
+    rl->inplace_rec = NULL;
+    rl->inplace_got = 0;
 
     SSL3_BUFFER_clear(&rl->rbuf);
     for(pipes = 0; pipes < rl->numwpipes; pipes++)
@@ -84,7 +88,15 @@ void RECORD_LAYER_release(RECORD_LAYER *rl)
 
 int RECORD_LAYER_read_pending(const RECORD_LAYER *rl)
 {
-    return SSL3_BUFFER_get_left(&rl->rbuf) != 0;
+    if (SSL3_BUFFER_get_left(&rl->rbuf) != 0)
+        return 1;
+
+    /*
+     * A batching datagram BIO may already have pulled further records off
+     * the socket, so polling the socket would not reveal them.
+     */
+    return SSL_IS_DTLS(rl->s) && rl->s->rbio != NULL
+           && BIO_dgram_get_queued(rl->s->rbio) > 0;
 }
 
 int RECORD_LAYER_write_pending(const RECORD_LAYER *rl)
@@ -93,6 +105,107 @@ int RECORD_LAYER_write_pending(const RECORD_LAYER *rl)
             && SSL3_BUFFER_get_left(&rl->wbuf[rl->numwpipes-1]) != 0;
 }
 
+/*
+ * Heap bytes owned by the record layer: either its read, write and
+ * decompression buffers (|buffers| != 0) or the DTLS record layer structure.
+ */
+size_t RECORD_LAYER_get_memory_usage(const RECORD_LAYER *rl, int buffers)
+{
+    size_t ret = 0;
+    unsigned int i;
+
+    if (!buffers)
+        return rl->d != NULL ? sizeof(*rl->d) : 0;
+
+    if (rl->rbuf.buf != NULL)
+        ret += rl->rbuf.len;
+    for (i = 0; i < rl->numwpipes; i++) {
+        if (rl->wbuf[i].buf != NULL)
+            ret += rl->wbuf[i].len;
+    }
+    for (i = 0; i < SSL_MAX_PIPELINES; i++) {
+        if (rl->rrec[i].comp != NULL)
+            ret += SSL3_RT_MAX_ENCRYPTED_LENGTH;
+    }
+    return ret;
+}
+
+/*
+ * Find the record holding the next unread application data bytes, if the
+ * read path has already decrypted one.
+ */
+static SSL3_RECORD *record_layer_view_record(RECORD_LAYER *rl)
+{
+    SSL3_RECORD *rr;
+    unsigned int i;
+
+    if (SSL_IS_DTLS(rl->s)) {
+        /* DTLS only ever has one record in flight */
+        rr = &rl->rrec[0];
+        if (SSL3_RECORD_get_type(rr) == SSL3_RT_APPLICATION_DATA
+                && SSL3_RECORD_get_length(rr) > 0)
+            return rr;
+        return NULL;
+    }
+
+    for (i = 0; i < RECORD_LAYER_get_numrpipes(rl); i++) {
+        rr = &rl->rrec[i];
+        if (SSL3_RECORD_is_read(rr) || SSL3_RECORD_get_length(rr) == 0)
+            continue;
+        if (SSL3_RECORD_get_type(rr) != SSL3_RT_APPLICATION_DATA)
+            return NULL;
+        return rr;
+    }
+    return NULL;
+}
+
+/*
+ * Return a pointer to the decrypted, not yet consumed plaintext of the
+ * current application data record.  The data lives in the read buffer and
+ * stays valid until it is released or the record layer is used again.
+ */
+int RECORD_LAYER_get0_view(RECORD_LAYER *rl, const unsigned char **data,
+                           size_t *len)
+{
+    SSL3_RECORD *rr = record_layer_view_record(rl);
+
+    if (rr == NULL)
+        return 0;
+
+    *data = &(SSL3_RECORD_get_data(rr)[SSL3_RECORD_get_off(rr)]);
+    *len = SSL3_RECORD_get_length(rr);
+    return 1;
+}
+
+/*
+ * Consume |len| bytes from the view handed out by RECORD_LAYER_get0_view(),
+ * exactly as a non-peeking read of the same length would have done.
+ */
+int RECORD_LAYER_release_view(RECORD_LAYER *rl, size_t len)
+{
+    SSL3_RECORD *rr = record_layer_view_record(rl);
+
+    if (rr == NULL)
+        return len == 0;
+    if (len > SSL3_RECORD_get_length(rr))
+        return 0;
+
+    SSL3_RECORD_sub_length(rr, (unsigned int)len);
+    SSL3_RECORD_add_off(rr, (unsigned int)len);
+    if (SSL3_RECORD_get_length(rr) == 0) {
+        rl->rstate = SSL_ST_READ_HEADER;
+        SSL3_RECORD_set_off(rr, 0);
+        if (!SSL_IS_DTLS(rl->s)) {
+            SSL3_RECORD_set_read(rr);
+            if ((rl->s->mode & SSL_MODE_RELEASE_BUFFERS)
+                    && SSL3_BUFFER_get_left(&rl->rbuf) == 0
+                    && record_layer_view_record(rl) == NULL)
+                ssl3_release_read_buffer(rl->s);
+        }
+    }
+    return 1;
+}
+
 int RECORD_LAYER_set_data(RECORD_LAYER *rl, const unsigned char *buf, int len)
 {
     rl->packet_length = len;
@@ -326,6 +439,47 @@ int ssl3_read_n(SSL *s, int n, int max, int extend, int clearold)
     return (n);
 }
 
+/*
+ * Read the |n| byte body of the current record into s->rlayer.inplace_rec
+ * rather than into the read buffer. Progress is kept in
+ * s->rlayer.inplace_got so that a non-blocking read can be resumed.
+ */
+int ssl3_read_n_inplace(SSL *s, unsigned int n)
+{
+    RECORD_LAYER *rl = &s->rlayer;
+    SSL3_BUFFER *rb = &rl->rbuf;
+    unsigned int take;
+    int i;
+
+    /* Use up anything that was read ahead into the read buffer first */
+    if (rb->left > 0 && rl->inplace_got < n) {
+        take = n - rl->inplace_got;
+        if (take > rb->left)
+            take = rb->left;
+        memcpy(rl->inplace_rec + rl->inplace_got, rb->buf + rb->offset, take);
+        rb->offset += take;
+        rb->left -= take;
+        rl->inplace_got += take;
+    }
+
+    while (rl->inplace_got < n) {
+        clear_sys_error();
+        if (s->rbio == NULL) {
+            SSLerr(SSL_F_SSL3_READ_N, SSL_R_READ_BIO_NOT_SET);
+            return -1;
+        }
+        s->rwstate = SSL_READING;
+        i = BIO_read(s->rbio, rl->inplace_rec + rl->inplace_got,
+                     n - rl->inplace_got);
+        if (i <= 0)
+            return i;
+        rl->inplace_got += i;
+    }
+
+    s->rwstate = SSL_NOTHING;
+    return n;
+}
+
 
 /*
  * Call this to write data in records of type 'type' It will return <= 0 if
@@ -1046,7 +1200,14 @@ int ssl3_read_bytes(SSL *s, int type, int *recvd_type, unsigned char *buf,
     do {
         /* get new records if necessary */
         if (num_recs == 0) {
+            if (type == SSL3_RT_APPLICATION_DATA && !peek
+                    && (s->mode & SSL_MODE_DECRYPT_IN_PLACE)) {
+                s->rlayer.inplace_buf = buf;
+                s->rlayer.inplace_len = (unsigned int)len;
+            }
             ret = ssl3_get_record(s);
+            s->rlayer.inplace_buf = NULL;
+            s->rlayer.inplace_len = 0;
             if (ret <= 0)
                 return (ret);
             num_recs = RECORD_LAYER_get_numrpipes(&s->rlayer);
@@ -1129,7 +1290,9 @@ int ssl3_read_bytes(SSL *s, int type, int *recvd_type, unsigned char *buf,
             else
                 n = (unsigned int)len - read_bytes;
 
-            memcpy(buf, &(rr->data[rr->off]), n);
+            /* Records decrypted in place already live in |buf| */
+            if (&(rr->data[rr->off]) != buf)
+                memmove(buf, &(rr->data[rr->off]), n);
             buf += n;
             if (!peek) {
                 SSL3_RECORD_sub_length(rr, n);
@@ -196,6 +196,16 @@ typedef struct record_layer_st {
     int wpend_ret;
     const unsigned char *wpend_buf;
 
+    /*
+     * SSL_MODE_DECRYPT_IN_PLACE: caller buffer on offer for the next record,
+     * the buffer the current record body is being read into and how many
+     * body bytes it holds so far.
+     */
+    unsigned char *inplace_buf;
+    unsigned int inplace_len;
+    unsigned char *inplace_rec;
+    unsigned int inplace_got;
+
     unsigned char read_sequence[SEQ_NUM_SIZE];
     unsigned char write_sequence[SEQ_NUM_SIZE];
     
@@ -228,6 +238,10 @@ void RECORD_LAYER_clear(RECORD_LAYER *rl);
 void RECORD_LAYER_release(RECORD_LAYER *rl);
 int RECORD_LAYER_read_pending(const RECORD_LAYER *rl);
 int RECORD_LAYER_write_pending(const RECORD_LAYER *rl);
+size_t RECORD_LAYER_get_memory_usage(const RECORD_LAYER *rl, int buffers);
+int RECORD_LAYER_get0_view(RECORD_LAYER *rl, const unsigned char **data,
+                           size_t *len);
+int RECORD_LAYER_release_view(RECORD_LAYER *rl, size_t len);
 int RECORD_LAYER_set_data(RECORD_LAYER *rl, const unsigned char *buf, int len);
 void RECORD_LAYER_reset_read_sequence(RECORD_LAYER *rl);
 void RECORD_LAYER_reset_write_sequence(RECORD_LAYER *rl);
@@ -110,6 +110,26 @@ static int ssl3_record_app_data_waiting(SSL *s)
 #define MAX_EMPTY_RECORDS 32
 
 #define SSL2_RT_HEADER_LENGTH   2
+
+/*
+ * Can the record whose header has just been parsed be read and decrypted
+ * directly in the caller's buffer? Only application data protected by an
+ * AEAD cipher qualifies: the plaintext then never needs the read buffer and
+ * there is no separate MAC or padding to strip afterwards.
+ */
+static int ssl3_record_inplace_ok(SSL *s, const SSL3_RECORD *rr)
+{
+    return s->rlayer.inplace_buf != NULL
+        && rr->type == SSL3_RT_APPLICATION_DATA
+        && rr->rec_version != SSL2_VERSION
+        && rr->length > 0
+        && rr->length <= s->rlayer.inplace_len
+        && s->enc_read_ctx != NULL
+        && (EVP_CIPHER_flags(EVP_CIPHER_CTX_cipher(s->enc_read_ctx))
+            & EVP_CIPH_FLAG_AEAD_CIPHER)
+        && s->expand == NULL;
+}
+
 /*-
  * Call this to get new input records.
  * It will return <= 0 if more data is needed, normally due to an error
@@ -137,6 +157,7 @@ int ssl3_get_record(SSL *s)
     unsigned int num_recs = 0;
     unsigned int max_recs;
     unsigned int j;
+    int new_header, inplace = 0;
 
     rr = RECORD_LAYER_get_rrec(&s->rlayer);
     rbuf = RECORD_LAYER_get_rbuf(&s->rlayer);
@@ -146,6 +167,7 @@ int ssl3_get_record(SSL *s)
     sess = s->session;
 
     do {
+        new_header = 0;
         /* check if we have the header */
         if ((RECORD_LAYER_get_rstate(&s->rlayer) != SSL_ST_READ_BODY) ||
             (RECORD_LAYER_get_packet_length(&s->rlayer)
@@ -155,6 +177,7 @@ int ssl3_get_record(SSL *s)
             if (n <= 0)
                 return (n);         /* error or non-blocking */
             RECORD_LAYER_set_rstate(&s->rlayer, SSL_ST_READ_BODY);
+            new_header = 1;
 
             p = RECORD_LAYER_get_packet(&s->rlayer);
 
@@ -275,7 +298,25 @@ int ssl3_get_record(SSL *s)
         } else {
             i = rr[num_recs].length;
         }
-        if (i > 0) {
+        /*
+         * The decision to read a body in place is taken once, when its header
+         * arrives; a resumed read has to carry on into the same buffer.
+         */
+        if (new_header && num_recs == 0
+                && ssl3_record_inplace_ok(s, &rr[num_recs])) {
+            s->rlayer.inplace_rec = s->rlayer.inplace_buf;
+            s->rlayer.inplace_got = 0;
+        }
+        if (s->rlayer.inplace_rec != NULL) {
+            if (s->rlayer.inplace_rec != s->rlayer.inplace_buf) {
+                SSLerr(SSL_F_SSL3_GET_RECORD, SSL_R_BAD_READ_RETRY);
+                goto err;
+            }
+            n = ssl3_read_n_inplace(s, i);
+            if (n <= 0)
+                return (n);         /* error or non-blocking io */
+            inplace = 1;
+        } else if (i > 0) {
             /* now s->packet_length == SSL3_RT_HEADER_LENGTH */
 
             n = ssl3_read_n(s, i, i, 1, 0);
@@ -291,7 +332,11 @@ int ssl3_get_record(SSL *s)
          * or s->packet_length == SSL2_RT_HEADER_LENGTH + rr->length
          * and we have that many bytes in s->packet
          */
-        if(rr[num_recs].rec_version == SSL2_VERSION) {
+        if (inplace) {
+            rr[num_recs].input = s->rlayer.inplace_rec;
+            s->rlayer.inplace_rec = NULL;
+            s->rlayer.inplace_got = 0;
+        } else if(rr[num_recs].rec_version == SSL2_VERSION) {
             rr[num_recs].input =
                 &(RECORD_LAYER_get_packet(&s->rlayer)[SSL2_RT_HEADER_LENGTH]);
         } else {
@@ -330,6 +375,7 @@ int ssl3_get_record(SSL *s)
         /* we have pulled in a full packet so zero things */
         RECORD_LAYER_reset_packet_length(&s->rlayer);
     } while (num_recs < max_recs
+             && !inplace
              && rr[num_recs-1].type == SSL3_RT_APPLICATION_DATA
              && SSL_USE_EXPLICIT_IV(s)
              && s->enc_read_ctx != NULL
@@ -355,10 +355,14 @@ void ssl3_free_digest_list(SSL *s)
 
 void ssl3_finish_mac(SSL *s, const unsigned char *buf, int len)
 {
-    if (s->s3->handshake_dgst == NULL)
-        BIO_write(s->s3->handshake_buffer, (void *)buf, len);
-    else
+    if (s->s3->handshake_dgst != NULL)
         EVP_DigestUpdate(s->s3->handshake_dgst, buf, len);
+    else if (s->s3->handshake_buffer != NULL)
+        BIO_write(s->s3->handshake_buffer, (void *)buf, len);
+    /*
+     * Neither is present outside of a handshake, e.g. when a server sends a
+     * HelloRequest; that message is not part of any transcript.
+     */
 }
 
 int ssl3_digest_cached_records(SSL *s, int keep)
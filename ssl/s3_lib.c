@@ -2864,10 +2864,42 @@ static char *srp_password_from_info_cb(SSL *s, void *arg)
 static int ssl3_set_req_cert_type(CERT *c, const unsigned char *p,
                                   size_t len);
 
+/*
+ * Returns 1 if |cmd| modifies the CERT structure: such commands must make
+ * a private copy first if it is still shared with other SSL objects.
+ */
+static int ssl3_ctrl_modifies_cert(int cmd)
+{
+    switch (cmd) {
+    case SSL_CTRL_SET_TMP_DH:
+    case SSL_CTRL_SET_DH_AUTO:
+    case SSL_CTRL_CHAIN:
+    case SSL_CTRL_CHAIN_CERT:
+    case SSL_CTRL_SELECT_CURRENT_CERT:
+    case SSL_CTRL_SET_CURRENT_CERT:
+    case SSL_CTRL_SET_SIGALGS:
+    case SSL_CTRL_SET_SIGALGS_LIST:
+    case SSL_CTRL_SET_CLIENT_SIGALGS:
+    case SSL_CTRL_SET_CLIENT_SIGALGS_LIST:
+    case SSL_CTRL_SET_CLIENT_CERT_TYPES:
+    case SSL_CTRL_BUILD_CERT_CHAIN:
+    case SSL_CTRL_SET_VERIFY_CERT_STORE:
+    case SSL_CTRL_SET_CHAIN_CERT_STORE:
+        return 1;
+    default:
+        return 0;
+    }
+}
+
 long ssl3_ctrl(SSL *s, int cmd, long larg, void *parg)
 {
     int ret = 0;
 
+    if (ssl3_ctrl_modifies_cert(cmd) && !ssl_cert_unshare(&s->cert)) {
+        SSLerr(SSL_F_SSL3_CTRL, ERR_R_MALLOC_FAILURE);
+        return 0;
+    }
+
     switch (cmd) {
     case SSL_CTRL_GET_CLIENT_CERT_REQUEST:
         break;
@@ -3209,6 +3241,8 @@ long ssl3_callback_ctrl(SSL *s, int cmd, void (*fp) (void))
 #ifndef OPENSSL_NO_DH
     case SSL_CTRL_SET_TMP_DH_CB:
         {
+            if (!ssl_cert_unshare(&s->cert))
+                return 0;
             s->cert->dh_tmp_cb = (DH *(*)(SSL *, int, int))fp;
         }
         break;
@@ -3231,6 +3265,11 @@ long ssl3_callback_ctrl(SSL *s, int cmd, void (*fp) (void))
 
 long ssl3_ctx_ctrl(SSL_CTX *ctx, int cmd, long larg, void *parg)
 {
+    if (ssl3_ctrl_modifies_cert(cmd) && !ssl_cert_unshare(&ctx->cert)) {
+        SSLerr(SSL_F_SSL3_CTX_CTRL, ERR_R_MALLOC_FAILURE);
+        return 0;
+    }
+
     switch (cmd) {
 #ifndef OPENSSL_NO_DH
     case SSL_CTRL_SET_TMP_DH:
@@ -3467,6 +3506,8 @@ long ssl3_ctx_callback_ctrl(SSL_CTX *ctx, int cmd, void (*fp) (void))
 #ifndef OPENSSL_NO_DH
     case SSL_CTRL_SET_TMP_DH_CB:
         {
+            if (!ssl_cert_unshare(&ctx->cert))
+                return 0;
             ctx->cert->dh_tmp_cb = (DH *(*)(SSL *, int, int))fp;
         }
         break;
@@ -158,8 +158,6 @@ CERT *ssl_cert_dup(CERT *cert)
         ret->client_sigalgslen = cert->client_sigalgslen;
     } else
         ret->client_sigalgs = NULL;
-    /* Shared sigalgs also NULL */
-    ret->shared_sigalgs = NULL;
     /* Copy any custom client certificate types */
     if (cert->ctypes) {
         ret->ctypes = OPENSSL_malloc(cert->ctype_num);
@@ -207,6 +205,118 @@ CERT *ssl_cert_dup(CERT *cert)
     return NULL;
 }
 
+/*
+ * An SSL starts out sharing the CERT of its SSL_CTX. Anything about to
+ * modify a CERT must call this first: if the CERT is referenced from
+ * anywhere else it is replaced by a private copy, so that neither the
+ * SSL_CTX nor other connections see the change.
+ */
+int ssl_cert_unshare(CERT **pc)
+{
+    CERT *c = *pc, *dup;
+    int i;
+
+    CRYPTO_atomic_add(&c->references, 0, &i, c->lock);
+    if (i == 1)
+        return 1;
+
+    dup = ssl_cert_dup(c);
+    if (dup == NULL)
+        return 0;
+    ssl_cert_free(c);
+    *pc = dup;
+    return 1;
+}
+
+static size_t ssl_x509_usage(X509 *x)
+{
+    int len = x != NULL ? i2d_X509(x, NULL) : 0;
+
+    return len > 0 ? (size_t)len : 0;
+}
+
+static size_t ssl_pkey_usage(EVP_PKEY *pkey)
+{
+    int len = pkey != NULL ? i2d_PrivateKey(pkey, NULL) : 0;
+
+    return len > 0 ? (size_t)len : 0;
+}
+
+static size_t ssl_store_usage(X509_STORE *store)
+{
+    STACK_OF(X509_OBJECT) *objs;
+    X509_OBJECT *obj;
+    size_t ret = 0;
+    int i, len;
+
+    if (store == NULL || (objs = X509_STORE_get0_objects(store)) == NULL)
+        return 0;
+    for (i = 0; i < sk_X509_OBJECT_num(objs); i++) {
+        obj = sk_X509_OBJECT_value(objs, i);
+        if (X509_OBJECT_get_type(obj) == X509_LU_X509)
+            ret += ssl_x509_usage(X509_OBJECT_get0_X509(obj));
+        else if (X509_OBJECT_get_type(obj) == X509_LU_CRL
+                 && (len = i2d_X509_CRL(X509_OBJECT_get0_X509_CRL(obj),
+                                        NULL)) > 0)
+            ret += len;
+    }
+    return ret;
+}
+
+/*
+ * Approximate heap bytes held by |c| on top of what it shares with |base|,
+ * the CERT of the SSL_CTX. Certificates, keys and stores that are not also
+ * used by |base| are counted by the size of their encoding.
+ */
+size_t ssl_cert_memory_usage(const CERT *c, const CERT *base)
+{
+    size_t ret = sizeof(*c);
+    int i, j;
+
+    if (c == base)
+        return 0;
+
+    for (i = 0; i < SSL_PKEY_NUM; i++) {
+        const CERT_PKEY *cpk = c->pkeys + i, *bpk = base->pkeys + i;
+
+        if (cpk->x509 != bpk->x509)
+            ret += ssl_x509_usage(cpk->x509);
+        if (cpk->privatekey != bpk->privatekey)
+            ret += ssl_pkey_usage(cpk->privatekey);
+        if (cpk->chain != NULL && cpk->chain != bpk->chain) {
+            for (j = 0; j < sk_X509_num(cpk->chain); j++) {
+                X509 *x = sk_X509_value(cpk->chain, j);
+
+                ret += sizeof(x);
+                if (j >= sk_X509_num(bpk->chain)
+                    || x != sk_X509_value(bpk->chain, j))
+                    ret += ssl_x509_usage(x);
+            }
+        }
+        ret += cpk->serverinfo_length;
+    }
+#ifndef OPENSSL_NO_DH
+    if (c->dh_tmp != NULL && c->dh_tmp != base->dh_tmp) {
+        int len = i2d_DHparams(EVP_PKEY_get0_DH(c->dh_tmp), NULL);
+
+        if (len > 0)
+            ret += len;
+    }
+#endif
+    ret += c->ctype_num + c->conf_sigalgslen + c->client_sigalgslen;
+    ret += (c->cli_ext.meths_count + c->srv_ext.meths_count)
+           * sizeof(custom_ext_method);
+    if (c->chain_store != base->chain_store)
+        ret += ssl_store_usage(c->chain_store);
+    if (c->verify_store != base->verify_store)
+        ret += ssl_store_usage(c->verify_store);
+#ifndef OPENSSL_NO_PSK
+    if (c->psk_identity_hint != NULL)
+        ret += strlen(c->psk_identity_hint) + 1;
+#endif
+    return ret;
+}
+
 /* Free up and clear all certificates and chains */
 
 void ssl_cert_clear_certs(CERT *c)
@@ -248,7 +358,6 @@ void ssl_cert_free(CERT *c)
     ssl_cert_clear_certs(c);
     OPENSSL_free(c->conf_sigalgs);
     OPENSSL_free(c->client_sigalgs);
-    OPENSSL_free(c->shared_sigalgs);
     OPENSSL_free(c->ctypes);
     X509_STORE_free(c->verify_store);
     X509_STORE_free(c->chain_store);
@@ -85,8 +85,6 @@ struct ssl_conf_ctx_st {
     uint32_t *poptions;
     /* Certificate filenames for each type */
     char *cert_filename[SSL_PKEY_NUM];
-    /* Pointer to SSL or SSL_CTX cert_flags or NULL if none */
-    uint32_t *pcert_flags;
     /* Pointer to SSL or SSL_CTX verify_mode or NULL if none */
     uint32_t *pvfy_flags;
     /* Pointer to SSL or SSL_CTX min_version field or NULL if none */
@@ -112,8 +110,19 @@ static void ssl_set_option(SSL_CONF_CTX *cctx, unsigned int name_flags,
     switch (name_flags & SSL_TFLAG_TYPE_MASK) {
 
     case SSL_TFLAG_CERT:
-        pflags = cctx->pcert_flags;
-        break;
+        /* Use the ctrls so that a CERT shared with an SSL_CTX is unshared */
+        if (cctx->ctx != NULL) {
+            if (onoff)
+                SSL_CTX_set_cert_flags(cctx->ctx, option_value);
+            else
+                SSL_CTX_clear_cert_flags(cctx->ctx, option_value);
+        } else if (cctx->ssl != NULL) {
+            if (onoff)
+                SSL_set_cert_flags(cctx->ssl, option_value);
+            else
+                SSL_clear_cert_flags(cctx->ssl, option_value);
+        }
+        return;
 
     case SSL_TFLAG_VFY:
         pflags =  cctx->pvfy_flags;
@@ -422,11 +431,15 @@ static int do_store(SSL_CONF_CTX *cctx,
 {
     CERT *cert;
     X509_STORE **st;
-    if (cctx->ctx)
+    if (cctx->ctx) {
+        if (!ssl_cert_unshare(&cctx->ctx->cert))
+            return 0;
         cert = cctx->ctx->cert;
-    else if (cctx->ssl)
+    } else if (cctx->ssl) {
+        if (!ssl_cert_unshare(&cctx->ssl->cert))
+            return 0;
         cert = cctx->ssl->cert;
-    else
+    } else
         return 1;
     st = verify_store ? &cert->verify_store : &cert->chain_store;
     if (*st == NULL) {
@@ -852,13 +865,11 @@ void SSL_CONF_CTX_set_ssl(SSL_CONF_CTX *cctx, SSL *ssl)
         cctx->poptions = &ssl->options;
         cctx->min_version = &ssl->min_proto_version;
         cctx->max_version = &ssl->max_proto_version;
-        cctx->pcert_flags = &ssl->cert->cert_flags;
         cctx->pvfy_flags = &ssl->verify_mode;
     } else {
         cctx->poptions = NULL;
         cctx->min_version = NULL;
         cctx->max_version = NULL;
-        cctx->pcert_flags = NULL;
         cctx->pvfy_flags = NULL;
     }
 }
@@ -871,13 +882,11 @@ void SSL_CONF_CTX_set_ssl_ctx(SSL_CONF_CTX *cctx, SSL_CTX *ctx)
         cctx->poptions = &ctx->options;
         cctx->min_version = &ctx->min_proto_version;
         cctx->max_version = &ctx->max_proto_version;
-        cctx->pcert_flags = &ctx->cert->cert_flags;
         cctx->pvfy_flags = &ctx->verify_mode;
     } else {
         cctx->poptions = NULL;
         cctx->min_version = NULL;
         cctx->max_version = NULL;
-        cctx->pcert_flags = NULL;
         cctx->pvfy_flags = NULL;
     }
 }
@@ -148,6 +148,13 @@ static void ssl_library_stop(void)
                         "ssl_comp_free_compression_methods_int()\n");
 #endif
         ssl_comp_free_compression_methods_int();
+#endif
+#ifndef OPENSSL_NO_DH
+#ifdef OPENSSL_INIT_DEBUG
+        fprintf(stderr, "OPENSSL_INIT: ssl_library_stop: "
+                        "tls1_ffdhe_free_int()\n");
+#endif
+        tls1_ffdhe_free_int();
 #endif
     }
 
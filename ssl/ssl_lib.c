@@ -518,6 +518,7 @@ int SSL_CTX_set_ssl_version(SSL_CTX *ctx, const SSL_METHOD *meth)
 SSL *SSL_new(SSL_CTX *ctx)
 {
     SSL *s;
+    int i;
 
     if (ctx == NULL) {
         SSLerr(SSL_F_SSL_NEW, SSL_R_NULL_SSL_CTX);
@@ -549,17 +550,13 @@ SSL *SSL_new(SSL_CTX *ctx)
     s->references = 1;
 
     /*
-     * Earlier library versions used to copy the pointer to the CERT, not
-     * its contents; only when setting new parameters for the per-SSL
-     * copy, ssl_cert_new would be called (and the direct reference to
-     * the per-SSL_CTX settings would be lost, but those still were
-     * indirectly accessed for various purposes, and for that reason they
-     * used to be known as s->ctx->default_cert). Now we don't look at the
-     * SSL_CTX's CERT after having duplicated it once.
+     * Share the SSL_CTX's CERT: hardly any connection changes it, so it is
+     * only copied by ssl_cert_unshare() once something is about to modify
+     * it, on either side. Changes to the SSL_CTX are therefore still not
+     * seen by existing connections.
      */
-    s->cert = ssl_cert_dup(ctx->cert);
-    if (s->cert == NULL)
-        goto err;
+    CRYPTO_atomic_add(&ctx->cert->references, 1, &i, ctx->cert->lock);
+    s->cert = ctx->cert;
 
     RECORD_LAYER_set_read_ahead(&s->rlayer, ctx->read_ahead);
     s->msg_callback = ctx->msg_callback;
@@ -676,6 +673,82 @@ int SSL_is_dtls(const SSL *s)
     return SSL_IS_DTLS(s) ? 1 : 0;
 }
 
+static size_t ssl_md_ctx_usage(const EVP_MD_CTX *ctx)
+{
+    const EVP_MD *md;
+
+    if (ctx == NULL || (md = EVP_MD_CTX_md(ctx)) == NULL)
+        return 0;
+    return EVP_MD_meth_get_app_datasize(md);
+}
+
+static size_t ssl_cipher_ctx_usage(const EVP_CIPHER_CTX *ctx)
+{
+    const EVP_CIPHER *cipher;
+
+    if (ctx == NULL || (cipher = EVP_CIPHER_CTX_cipher(ctx)) == NULL)
+        return 0;
+    return EVP_CIPHER_impl_ctx_size(cipher);
+}
+
+/*
+ * Approximate number of heap bytes held by |s| itself, broken down by
+ * |component|. Objects shared with the SSL_CTX or the session are not
+ * included.
+ */
+size_t SSL_get_memory_usage(const SSL *s, int component)
+{
+    size_t ret = 0;
+    BUF_MEM *bm;
+
+    switch (component) {
+    case SSL_MEM_USAGE_TOTAL:
+        return SSL_get_memory_usage(s, SSL_MEM_USAGE_OBJECTS)
+            + SSL_get_memory_usage(s, SSL_MEM_USAGE_RECORD_BUFFERS)
+            + SSL_get_memory_usage(s, SSL_MEM_USAGE_HANDSHAKE)
+            + SSL_get_memory_usage(s, SSL_MEM_USAGE_CRYPTO)
+            + SSL_get_memory_usage(s, SSL_MEM_USAGE_CERT);
+
+    case SSL_MEM_USAGE_OBJECTS:
+        ret = sizeof(*s);
+        if (s->s3 != NULL)
+            ret += sizeof(*s->s3);
+        if (s->d1 != NULL)
+            ret += sizeof(*s->d1);
+        return ret + RECORD_LAYER_get_memory_usage(&s->rlayer, 0);
+
+    case SSL_MEM_USAGE_RECORD_BUFFERS:
+        return RECORD_LAYER_get_memory_usage(&s->rlayer, 1);
+
+    case SSL_MEM_USAGE_HANDSHAKE:
+        if (s->init_buf != NULL)
+            ret += s->init_buf->max;
+        if (s->s3 != NULL) {
+            if (s->s3->handshake_buffer != NULL) {
+                BIO_get_mem_ptr(s->s3->handshake_buffer, &bm);
+                if (bm != NULL)
+                    ret += bm->max;
+            }
+            ret += ssl_md_ctx_usage(s->s3->handshake_dgst);
+            ret += s->s3->tmp.key_block_length;
+        }
+        return ret;
+
+    case SSL_MEM_USAGE_CRYPTO:
+        return ssl_cipher_ctx_usage(s->enc_read_ctx)
+            + ssl_cipher_ctx_usage(s->enc_write_ctx)
+            + ssl_md_ctx_usage(s->read_hash)
+            + ssl_md_ctx_usage(s->write_hash);
+
+    case SSL_MEM_USAGE_CERT:
+        /* Nothing is used while the CERT is still shared with the SSL_CTX */
+        if (s->cert == NULL)
+            return 0;
+        return ssl_cert_memory_usage(s->cert, s->ctx->cert);
+    }
+    return 0;
+}
+
 int SSL_up_ref(SSL *s)
 {
     int i;
@@ -920,6 +993,8 @@ X509_VERIFY_PARAM *SSL_get0_param(SSL *ssl)
 
 void SSL_certs_clear(SSL *s)
 {
+    if (!ssl_cert_unshare(&s->cert))
+        return;
     ssl_cert_clear_certs(s->cert);
 }
 
@@ -967,6 +1042,7 @@ void SSL_free(SSL *s)
     clear_ciphers(s);
 
     ssl_cert_free(s->cert);
+    OPENSSL_free(s->shared_sigalgs);
     /* Free up if allocated */
 
     OPENSSL_free(s->tlsext_hostname);
@@ -1512,6 +1588,41 @@ int SSL_peek(SSL *s, void *buf, int num)
     }
 }
 
+/*
+ * Zero-copy read: make sure a decrypted application data record is available
+ * (processing handshake and alert records along the way exactly like
+ * SSL_peek()) and hand out a pointer into the read buffer instead of copying.
+ */
+int SSL_read_view(SSL *s, const unsigned char **data, size_t *len)
+{
+    unsigned char c;
+    int ret;
+
+    if (data == NULL || len == NULL) {
+        SSLerr(SSL_F_SSL_READ_VIEW, ERR_R_PASSED_NULL_PARAMETER);
+        return -1;
+    }
+
+    ret = SSL_peek(s, &c, 1);
+    if (ret <= 0)
+        return ret;
+
+    if (!RECORD_LAYER_get0_view(&s->rlayer, data, len)) {
+        SSLerr(SSL_F_SSL_READ_VIEW, ERR_R_INTERNAL_ERROR);
+        return -1;
+    }
+    return (int)*len;
+}
+
+int SSL_release_view(SSL *s, size_t num)
+{
+    if (!RECORD_LAYER_release_view(&s->rlayer, num)) {
+        SSLerr(SSL_F_SSL_RELEASE_VIEW, SSL_R_BAD_LENGTH);
+        return 0;
+    }
+    return 1;
+}
+
 int SSL_write(SSL *s, const void *buf, int num)
 {
     if (s->handshake_func == NULL) {
@@ -1652,8 +1763,12 @@ long SSL_ctrl(SSL *s, int cmd, long larg, void *parg)
         else
             return 0;
     case SSL_CTRL_CERT_FLAGS:
+        if (!ssl_cert_unshare(&s->cert))
+            return 0;
         return (s->cert->cert_flags |= larg);
     case SSL_CTRL_CLEAR_CERT_FLAGS:
+        if (!ssl_cert_unshare(&s->cert))
+            return 0;
         return (s->cert->cert_flags &= ~larg);
 
     case SSL_CTRL_GET_RAW_CIPHERLIST:
@@ -1799,8 +1914,12 @@ long SSL_CTX_ctrl(SSL_CTX *ctx, int cmd, long larg, void *parg)
         ctx->max_pipelines = larg;
         return 1;
     case SSL_CTRL_CERT_FLAGS:
+        if (!ssl_cert_unshare(&ctx->cert))
+            return 0;
         return (ctx->cert->cert_flags |= larg);
     case SSL_CTRL_CLEAR_CERT_FLAGS:
+        if (!ssl_cert_unshare(&ctx->cert))
+            return 0;
         return (ctx->cert->cert_flags &= ~larg);
     case SSL_CTRL_SET_MIN_PROTO_VERSION:
         return ssl_set_version_bound(ctx->method->version, (int)larg,
@@ -1937,6 +2056,9 @@ int SSL_CTX_set_cipher_list(SSL_CTX *ctx, const char *str)
 {
     STACK_OF(SSL_CIPHER) *sk;
 
+    /* "@SECLEVEL=" and the Suite B strings modify the CERT */
+    if (!ssl_cert_unshare(&ctx->cert))
+        return 0;
     sk = ssl_create_cipher_list(ctx->method, &ctx->cipher_list,
                                 &ctx->cipher_list_by_id, str, ctx->cert);
     /*
@@ -1960,6 +2082,9 @@ int SSL_set_cipher_list(SSL *s, const char *str)
 {
     STACK_OF(SSL_CIPHER) *sk;
 
+    /* see comment in SSL_CTX_set_cipher_list */
+    if (!ssl_cert_unshare(&s->cert))
+        return 0;
     sk = ssl_create_cipher_list(s->ctx->method, &s->cipher_list,
                                 &s->cipher_list_by_id, str, s->cert);
     /* see comment in SSL_CTX_set_cipher_list */
@@ -2550,11 +2675,15 @@ void SSL_CTX_set_verify_depth(SSL_CTX *ctx, int depth)
 void SSL_CTX_set_cert_cb(SSL_CTX *c, int (*cb) (SSL *ssl, void *arg),
                          void *arg)
 {
+    if (!ssl_cert_unshare(&c->cert))
+        return;
     ssl_cert_set_cert_cb(c->cert, cb, arg);
 }
 
 void SSL_set_cert_cb(SSL *s, int (*cb) (SSL *ssl, void *arg), void *arg)
 {
+    if (!ssl_cert_unshare(&s->cert))
+        return;
     ssl_cert_set_cert_cb(s->cert, cb, arg);
 }
 
@@ -3311,14 +3440,13 @@ SSL_CTX *SSL_get_SSL_CTX(const SSL *ssl)
 SSL_CTX *SSL_set_SSL_CTX(SSL *ssl, SSL_CTX *ctx)
 {
     CERT *new_cert;
+    int i;
     if (ssl->ctx == ctx)
         return ssl->ctx;
     if (ctx == NULL)
         ctx = ssl->initial_ctx;
-    new_cert = ssl_cert_dup(ctx->cert);
-    if (new_cert == NULL) {
-        return NULL;
-    }
+    new_cert = ctx->cert;
+    CRYPTO_atomic_add(&new_cert->references, 1, &i, new_cert->lock);
     ssl_cert_free(ssl->cert);
     ssl->cert = new_cert;
 
@@ -3521,6 +3649,8 @@ int SSL_CTX_use_psk_identity_hint(SSL_CTX *ctx, const char *identity_hint)
                SSL_R_DATA_LENGTH_TOO_LONG);
         return 0;
     }
+    if (!ssl_cert_unshare(&ctx->cert))
+        return 0;
     OPENSSL_free(ctx->cert->psk_identity_hint);
     if (identity_hint != NULL) {
         ctx->cert->psk_identity_hint = OPENSSL_strdup(identity_hint);
@@ -3540,6 +3670,8 @@ int SSL_use_psk_identity_hint(SSL *s, const char *identity_hint)
         SSLerr(SSL_F_SSL_USE_PSK_IDENTITY_HINT, SSL_R_DATA_LENGTH_TOO_LONG);
         return 0;
     }
+    if (!ssl_cert_unshare(&s->cert))
+        return 0;
     OPENSSL_free(s->cert->psk_identity_hint);
     if (identity_hint != NULL) {
         s->cert->psk_identity_hint = OPENSSL_strdup(identity_hint);
@@ -3716,6 +3848,8 @@ void SSL_set_debug(SSL *s, int debug)
 
 void SSL_set_security_level(SSL *s, int level)
 {
+    if (!ssl_cert_unshare(&s->cert))
+        return;
     s->cert->sec_level = level;
 }
 
@@ -3729,6 +3863,8 @@ void SSL_set_security_callback(SSL *s,
                                           int bits, int nid, void *other,
                                           void *ex))
 {
+    if (!ssl_cert_unshare(&s->cert))
+        return;
     s->cert->sec_cb = cb;
 }
 
@@ -3740,6 +3876,8 @@ int (*SSL_get_security_callback(const SSL *s)) (const SSL *s, const SSL_CTX *ctx
 
 void SSL_set0_security_ex_data(SSL *s, void *ex)
 {
+    if (!ssl_cert_unshare(&s->cert))
+        return;
     s->cert->sec_ex = ex;
 }
 
@@ -3750,6 +3888,8 @@ void *SSL_get0_security_ex_data(const SSL *s)
 
 void SSL_CTX_set_security_level(SSL_CTX *ctx, int level)
 {
+    if (!ssl_cert_unshare(&ctx->cert))
+        return;
     ctx->cert->sec_level = level;
 }
 
@@ -3763,6 +3903,8 @@ void SSL_CTX_set_security_callback(SSL_CTX *ctx,
                                               int bits, int nid, void *other,
                                               void *ex))
 {
+    if (!ssl_cert_unshare(&ctx->cert))
+        return;
     ctx->cert->sec_cb = cb;
 }
 
@@ -3777,6 +3919,8 @@ int (*SSL_CTX_get_security_callback(const SSL_CTX *ctx)) (const SSL *s,
 
 void SSL_CTX_set0_security_ex_data(SSL_CTX *ctx, void *ex)
 {
+    if (!ssl_cert_unshare(&ctx->cert))
+        return;
     ctx->cert->sec_ex = ex;
 }
 
@@ -944,8 +944,17 @@ struct ssl_st {
     EVP_MD_CTX *write_hash;     /* used for mac generation */
     /* session info */
     /* client cert? */
-    /* This is used to hold the server certificate used */
+    /*
+     * This is used to hold the server certificate used. It is shared with
+     * the SSL_CTX until ssl_cert_unshare() is called before a modification.
+     */
     struct cert_st /* CERT */ *cert;
+    /*
+     * Signature algorithms shared by client and server: cached because these
+     * are used most often.
+     */
+    TLS_SIGALGS *shared_sigalgs;
+    size_t shared_sigalgslen;
     /*
      * the session_id_context is used to ensure sessions are only reused in
      * the appropriate context
@@ -1516,12 +1525,6 @@ typedef struct cert_st {
     unsigned char *client_sigalgs;
     /* Size of above array */
     size_t client_sigalgslen;
-    /*
-     * Signature algorithms shared by client and server: cached because these
-     * are used most often.
-     */
-    TLS_SIGALGS *shared_sigalgs;
-    size_t shared_sigalgslen;
     /*
      * Certificate setup callback: if set is called whenever a certificate
      * may be required (client or server). the callback can then examine any
@@ -1550,7 +1553,8 @@ typedef struct cert_st {
     /* If not NULL psk identity hint to use for servers */
     char *psk_identity_hint;
 #endif
-    int references;             /* >1 only if SSL_copy_session_id is used */
+    /* >1 while shared between an SSL_CTX and its SSL objects */
+    int references;
     CRYPTO_RWLOCK *lock;
 } CERT;
 
@@ -1799,6 +1803,8 @@ void ssl_clear_cipher_ctx(SSL *s);
 int ssl_clear_bad_session(SSL *s);
 __owur CERT *ssl_cert_new(void);
 __owur CERT *ssl_cert_dup(CERT *cert);
+__owur int ssl_cert_unshare(CERT **pc);
+size_t ssl_cert_memory_usage(const CERT *c, const CERT *base);
 void ssl_cert_clear_certs(CERT *c);
 void ssl_cert_free(CERT *c);
 __owur int ssl_get_new_session(SSL *s, int session);
@@ -2035,7 +2041,9 @@ __owur int ssl_validate_ct(SSL *s);
 #endif
 
 #  ifndef OPENSSL_NO_DH
-__owur DH *ssl_get_auto_dh(SSL *s);
+__owur EVP_PKEY *ssl_get_auto_dh(SSL *s);
+__owur EVP_PKEY *tls1_get_ffdhe(const EVP_PKEY *pkey);
+void tls1_ffdhe_free_int(void);
 #  endif
 
 __owur int ssl_security_cert(SSL *s, SSL_CTX *ctx, X509 *x, int vfy, int is_ee);
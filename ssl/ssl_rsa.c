@@ -30,7 +30,7 @@ int SSL_use_certificate(SSL *ssl, X509 *x)
         return 0;
     }
 
-    return (ssl_set_cert(ssl->cert, x));
+    return ssl_cert_unshare(&ssl->cert) && ssl_set_cert(ssl->cert, x);
 }
 
 #ifndef OPENSSL_NO_STDIO
@@ -113,7 +113,7 @@ int SSL_use_RSAPrivateKey(SSL *ssl, RSA *rsa)
         return 0;
     }
 
-    ret = ssl_set_pkey(ssl->cert, pkey);
+    ret = ssl_cert_unshare(&ssl->cert) && ssl_set_pkey(ssl->cert, pkey);
     EVP_PKEY_free(pkey);
     return (ret);
 }
@@ -234,7 +234,7 @@ int SSL_use_PrivateKey(SSL *ssl, EVP_PKEY *pkey)
         SSLerr(SSL_F_SSL_USE_PRIVATEKEY, ERR_R_PASSED_NULL_PARAMETER);
         return (0);
     }
-    ret = ssl_set_pkey(ssl->cert, pkey);
+    ret = ssl_cert_unshare(&ssl->cert) && ssl_set_pkey(ssl->cert, pkey);
     return (ret);
 }
 
@@ -310,7 +310,7 @@ int SSL_CTX_use_certificate(SSL_CTX *ctx, X509 *x)
         SSLerr(SSL_F_SSL_CTX_USE_CERTIFICATE, rv);
         return 0;
     }
-    return (ssl_set_cert(ctx->cert, x));
+    return ssl_cert_unshare(&ctx->cert) && ssl_set_cert(ctx->cert, x);
 }
 
 static int ssl_set_cert(CERT *c, X509 *x)
@@ -455,7 +455,7 @@ int SSL_CTX_use_RSAPrivateKey(SSL_CTX *ctx, RSA *rsa)
         return 0;
     }
 
-    ret = ssl_set_pkey(ctx->cert, pkey);
+    ret = ssl_cert_unshare(&ctx->cert) && ssl_set_pkey(ctx->cert, pkey);
     EVP_PKEY_free(pkey);
     return (ret);
 }
@@ -526,7 +526,7 @@ int SSL_CTX_use_PrivateKey(SSL_CTX *ctx, EVP_PKEY *pkey)
         SSLerr(SSL_F_SSL_CTX_USE_PRIVATEKEY, ERR_R_PASSED_NULL_PARAMETER);
         return (0);
     }
-    return (ssl_set_pkey(ctx->cert, pkey));
+    return ssl_cert_unshare(&ctx->cert) && ssl_set_pkey(ctx->cert, pkey);
 }
 
 #ifndef OPENSSL_NO_STDIO
@@ -864,6 +864,10 @@ int SSL_CTX_use_serverinfo(SSL_CTX *ctx, const unsigned char *serverinfo,
         SSLerr(SSL_F_SSL_CTX_USE_SERVERINFO, SSL_R_INVALID_SERVERINFO_DATA);
         return 0;
     }
+    if (!ssl_cert_unshare(&ctx->cert)) {
+        SSLerr(SSL_F_SSL_CTX_USE_SERVERINFO, ERR_R_MALLOC_FAILURE);
+        return 0;
+    }
     if (ctx->cert->key == NULL) {
         SSLerr(SSL_F_SSL_CTX_USE_SERVERINFO, ERR_R_INTERNAL_ERROR);
         return 0;
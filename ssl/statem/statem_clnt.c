@@ -1706,6 +1706,11 @@ MSG_PROCESS_RETURN tls_process_certificate_request(SSL *s, PACKET *pkt)
         SSLerr(SSL_F_TLS_PROCESS_CERTIFICATE_REQUEST, SSL_R_LENGTH_MISMATCH);
         goto err;
     }
+    if ((s->cert->ctypes != NULL || ctype_num > SSL3_CT_NUMBER)
+            && !ssl_cert_unshare(&s->cert)) {
+        SSLerr(SSL_F_TLS_PROCESS_CERTIFICATE_REQUEST, ERR_R_MALLOC_FAILURE);
+        goto err;
+    }
     OPENSSL_free(s->cert->ctypes);
     s->cert->ctypes = NULL;
     if (ctype_num > SSL3_CT_NUMBER) {
@@ -2179,13 +2184,20 @@ psk_err:
     else if (alg_k & (SSL_kDHE | SSL_kDHEPSK)) {
         DH *dh_clnt = NULL;
         const BIGNUM *pub_key;
+        EVP_PKEY *params;
         skey = s->s3->peer_tmp;
         if (skey == NULL) {
             SSLerr(SSL_F_TLS_CONSTRUCT_CLIENT_KEY_EXCHANGE,
                    ERR_R_INTERNAL_ERROR);
             goto err;
         }
-        ckey = ssl_generate_pkey(skey, NID_undef);
+        /*
+         * For the RFC 7919 groups use our own copy of the parameters, which
+         * has the recommended private key length and keeps the powers of g
+         * from one connection to the next.
+         */
+        params = tls1_get_ffdhe(skey);
+        ckey = ssl_generate_pkey(params != NULL ? params : skey, NID_undef);
         dh_clnt = EVP_PKEY_get0_DH(ckey);
 
         if (dh_clnt == NULL || ssl_derive(s, ckey, skey) == 0) {
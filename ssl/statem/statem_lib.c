@@ -291,6 +291,12 @@ WORK_STATE tls_finish_handshake(SSL *s, WORK_STATE wst)
          */
         BUF_MEM_free(s->init_buf);
         s->init_buf = NULL;
+
+        /*
+         * The transcript hash is only needed again once a new handshake
+         * starts, and ssl3_init_finished_mac() recreates it then.
+         */
+        ssl3_free_digest_list(s);
     }
 
     ssl_free_wbio_buffer(s);
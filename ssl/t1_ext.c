@@ -227,6 +227,8 @@ int SSL_CTX_add_client_custom_ext(SSL_CTX *ctx, unsigned int ext_type,
         SSL_CTX_ct_is_enabled(ctx))
         return 0;
 #endif
+    if (!ssl_cert_unshare(&ctx->cert))
+        return 0;
     return custom_ext_meth_add(&ctx->cert->cli_ext, ext_type, add_cb,
                                free_cb, add_arg, parse_cb, parse_arg);
 }
@@ -238,6 +240,8 @@ int SSL_CTX_add_server_custom_ext(SSL_CTX *ctx, unsigned int ext_type,
                                   custom_ext_parse_cb parse_cb,
                                   void *parse_arg)
 {
+    if (!ssl_cert_unshare(&ctx->cert))
+        return 0;
     return custom_ext_meth_add(&ctx->cert->srv_ext, ext_type,
                                add_cb, free_cb, add_arg, parse_cb, parse_arg);
 }
@@ -113,6 +113,27 @@ void tls1_clear(SSL *s)
         s->version = s->method->version;
 }
 
+#ifndef OPENSSL_NO_DH
+/*
+ * The RFC 7919 groups, in ascending order of strength. Their parameters are
+ * created once and shared read-only by all connections, so that what key
+ * generation caches in them is computed only once.
+ */
+typedef struct {
+    unsigned int group_id;
+    DH *(*get_params) (void);
+} tls_ffdhe_info;
+
+static const tls_ffdhe_info ffdhe_list[] = {
+    {TLSEXT_ffdhe2048, DH_get_ffdhe2048},
+    {TLSEXT_ffdhe3072, DH_get_ffdhe3072},
+    {TLSEXT_ffdhe4096, DH_get_ffdhe4096},
+};
+
+static CRYPTO_ONCE ffdhe_once = CRYPTO_ONCE_STATIC_INIT;
+static EVP_PKEY *ffdhe_params[OSSL_NELEM(ffdhe_list)];
+#endif
+
 #ifndef OPENSSL_NO_EC
 
 typedef struct {
@@ -640,7 +661,6 @@ static int tls1_check_cert_param(SSL *s, X509 *x, int set_ee_md)
     if (set_ee_md && tls1_suiteb(s)) {
         int check_md;
         size_t i;
-        CERT *c = s->cert;
         if (curve_id[0])
             return 0;
         /* Check to see we have necessary signing algorithm */
@@ -650,10 +670,10 @@ static int tls1_check_cert_param(SSL *s, X509 *x, int set_ee_md)
             check_md = NID_ecdsa_with_SHA384;
         else
             return 0;           /* Should never happen */
-        for (i = 0; i < c->shared_sigalgslen; i++)
-            if (check_md == c->shared_sigalgs[i].signandhash_nid)
+        for (i = 0; i < s->shared_sigalgslen; i++)
+            if (check_md == s->shared_sigalgs[i].signandhash_nid)
                 break;
-        if (i == c->shared_sigalgslen)
+        if (i == s->shared_sigalgslen)
             return 0;
         if (set_ee_md == 2) {
             if (check_md == NID_ecdsa_with_SHA256)
@@ -1020,8 +1040,8 @@ unsigned char *ssl_add_clienthello_tlsext(SSL *s, unsigned char *buf,
     unsigned char *orig = buf;
     unsigned char *ret = buf;
 #ifndef OPENSSL_NO_EC
-    /* See if we support any ECC ciphersuites */
-    int using_ecc = 0;
+    /* See if we support any ECC ciphersuites, or DHE ones */
+    int using_ecc = 0, using_ffdhe = 0;
     if (s->version >= TLS1_VERSION || SSL_IS_DTLS(s)) {
         int i;
         unsigned long alg_k, alg_a;
@@ -1033,10 +1053,12 @@ unsigned char *ssl_add_clienthello_tlsext(SSL *s, unsigned char *buf,
             alg_k = c->algorithm_mkey;
             alg_a = c->algorithm_auth;
             if ((alg_k & (SSL_kECDHE | SSL_kECDHEPSK))
-                 || (alg_a & SSL_aECDSA)) {
+                 || (alg_a & SSL_aECDSA))
                 using_ecc = 1;
-                break;
-            }
+# ifndef OPENSSL_NO_DH
+            if (alg_k & (SSL_kDHE | SSL_kDHEPSK))
+                using_ffdhe = 1;
+# endif
         }
     }
 #endif
@@ -1139,10 +1161,8 @@ unsigned char *ssl_add_clienthello_tlsext(SSL *s, unsigned char *buf,
          * Add TLS extension ECPointFormats to the ClientHello message
          */
         long lenmax;
-        const unsigned char *pcurves, *pformats;
-        size_t num_curves, num_formats, curves_list_len;
-        size_t i;
-        unsigned char *etmp;
+        const unsigned char *pformats;
+        size_t num_formats;
 
         tls1_get_formatlist(s, &pformats, &num_formats);
 
@@ -1161,19 +1181,31 @@ unsigned char *ssl_add_clienthello_tlsext(SSL *s, unsigned char *buf,
         *(ret++) = (unsigned char)num_formats;
         memcpy(ret, pformats, num_formats);
         ret += num_formats;
-
+    }
+    if (using_ecc || using_ffdhe) {
         /*
-         * Add TLS extension EllipticCurves to the ClientHello message
+         * Add TLS extension EllipticCurves to the ClientHello message, with
+         * the RFC 7919 groups after the curves if we offer DHE
          */
-        pcurves = s->tlsext_ellipticcurvelist;
-        if (!tls1_get_curvelist(s, 0, &pcurves, &num_curves))
+        long lenmax;
+        const unsigned char *pcurves = NULL;
+        size_t num_curves = 0, num_groups, curves_list_len;
+        size_t i;
+        unsigned char *etmp;
+
+        if (using_ecc && !tls1_get_curvelist(s, 0, &pcurves, &num_curves))
             return NULL;
+        num_groups = num_curves;
+# ifndef OPENSSL_NO_DH
+        if (using_ffdhe)
+            num_groups += OSSL_NELEM(ffdhe_list);
+# endif
 
         if ((lenmax = limit - ret - 6) < 0)
             return NULL;
-        if (num_curves > (size_t)lenmax / 2)
+        if (num_groups > (size_t)lenmax / 2)
             return NULL;
-        if (num_curves > 65532 / 2) {
+        if (num_groups > 65532 / 2) {
             SSLerr(SSL_F_SSL_ADD_CLIENTHELLO_TLSEXT, ERR_R_INTERNAL_ERROR);
             return NULL;
         }
@@ -1187,6 +1219,10 @@ unsigned char *ssl_add_clienthello_tlsext(SSL *s, unsigned char *buf,
                 *etmp++ = pcurves[1];
             }
         }
+# ifndef OPENSSL_NO_DH
+        for (i = 0; using_ffdhe && i < OSSL_NELEM(ffdhe_list); i++)
+            s2n(ffdhe_list[i].group_id, etmp);
+# endif
 
         curves_list_len = etmp - ret - 4;
 
@@ -1362,6 +1398,11 @@ unsigned char *ssl_add_clienthello_tlsext(SSL *s, unsigned char *buf,
         ret += el;
     }
 #endif
+    /* Custom extension state is kept in the CERT, so it must be private */
+    if (s->cert->cli_ext.meths_count > 0 && !ssl_cert_unshare(&s->cert)) {
+        SSLerr(SSL_F_SSL_ADD_CLIENTHELLO_TLSEXT, ERR_R_MALLOC_FAILURE);
+        return NULL;
+    }
     custom_ext_init(&s->cert->cli_ext);
     /* Add custom TLS Extensions to ClientHello */
     if (!custom_ext_add(s, 0, &ret, limit, al))
@@ -2212,6 +2253,12 @@ static int ssl_scan_clienthello_tlsext(SSL *s, PACKET *pkt, int *al)
 int ssl_parse_clienthello_tlsext(SSL *s, PACKET *pkt)
 {
     int al = -1;
+    /* Custom extension state is kept in the CERT, so it must be private */
+    if (s->cert->srv_ext.meths_count > 0 && !ssl_cert_unshare(&s->cert)) {
+        SSLerr(SSL_F_SSL_PARSE_CLIENTHELLO_TLSEXT, ERR_R_MALLOC_FAILURE);
+        ssl3_send_alert(s, SSL3_AL_FATAL, SSL_AD_INTERNAL_ERROR);
+        return 0;
+    }
     custom_ext_init(&s->cert->srv_ext);
     if (ssl_scan_clienthello_tlsext(s, pkt, &al) <= 0) {
         ssl3_send_alert(s, SSL3_AL_FATAL, al);
@@ -2629,9 +2676,9 @@ int tls1_set_server_sigalgs(SSL *s)
     size_t i;
 
     /* Clear any shared signature algorithms */
-    OPENSSL_free(s->cert->shared_sigalgs);
-    s->cert->shared_sigalgs = NULL;
-    s->cert->shared_sigalgslen = 0;
+    OPENSSL_free(s->shared_sigalgs);
+    s->shared_sigalgs = NULL;
+    s->shared_sigalgslen = 0;
     /* Clear certificate digests and validity flags */
     for (i = 0; i < SSL_PKEY_NUM; i++) {
         s->s3->tmp.md[i] = NULL;
@@ -2646,7 +2693,7 @@ int tls1_set_server_sigalgs(SSL *s)
             goto err;
         }
         /* Fatal error is no shared signature algorithms */
-        if (!s->cert->shared_sigalgs) {
+        if (!s->shared_sigalgs) {
             SSLerr(SSL_F_TLS1_SET_SERVER_SIGALGS,
                    SSL_R_NO_SHARED_SIGNATURE_ALGORITHMS);
             al = SSL_AD_ILLEGAL_PARAMETER;
@@ -2685,7 +2732,15 @@ int ssl_check_clienthello_tlsext_late(SSL *s)
          * Set current certificate to one we will use so SSL_get_certificate
          * et al can pick it up.
          */
-        s->cert->key = certpkey;
+        if (s->cert->key != certpkey) {
+            size_t idx = certpkey - s->cert->pkeys;
+
+            if (!ssl_cert_unshare(&s->cert)) {
+                ret = SSL_TLSEXT_ERR_ALERT_FATAL;
+                goto err;
+            }
+            s->cert->key = &s->cert->pkeys[idx];
+        }
         r = s->ctx->tlsext_status_cb(s, s->ctx->tlsext_status_arg);
         switch (r) {
             /* We don't want to send a status request response */
@@ -3383,9 +3438,9 @@ static int tls1_set_shared_sigalgs(SSL *s)
     CERT *c = s->cert;
     unsigned int is_suiteb = tls1_suiteb(s);
 
-    OPENSSL_free(c->shared_sigalgs);
-    c->shared_sigalgs = NULL;
-    c->shared_sigalgslen = 0;
+    OPENSSL_free(s->shared_sigalgs);
+    s->shared_sigalgs = NULL;
+    s->shared_sigalgslen = 0;
     /* If client use client signature algorithms if not NULL */
     if (!s->server && c->client_sigalgs && !is_suiteb) {
         conf = c->client_sigalgs;
@@ -3415,8 +3470,8 @@ static int tls1_set_shared_sigalgs(SSL *s)
     } else {
         salgs = NULL;
     }
-    c->shared_sigalgs = salgs;
-    c->shared_sigalgslen = nmatch;
+    s->shared_sigalgs = salgs;
+    s->shared_sigalgslen = nmatch;
     return 1;
 }
 
@@ -3448,13 +3503,12 @@ int tls1_process_sigalgs(SSL *s)
     const EVP_MD *md;
     const EVP_MD **pmd = s->s3->tmp.md;
     uint32_t *pvalid = s->s3->tmp.valid_flags;
-    CERT *c = s->cert;
     TLS_SIGALGS *sigptr;
     if (!tls1_set_shared_sigalgs(s))
         return 0;
 
-    for (i = 0, sigptr = c->shared_sigalgs;
-         i < c->shared_sigalgslen; i++, sigptr++) {
+    for (i = 0, sigptr = s->shared_sigalgs;
+         i < s->shared_sigalgslen; i++, sigptr++) {
         idx = tls12_get_pkey_idx(sigptr->rsign);
         if (idx > 0 && pmd[idx] == NULL) {
             md = tls12_get_hash(sigptr->rhash);
@@ -3527,8 +3581,8 @@ int SSL_get_shared_sigalgs(SSL *s, int idx,
                            int *psign, int *phash, int *psignhash,
                            unsigned char *rsig, unsigned char *rhash)
 {
-    TLS_SIGALGS *shsigalgs = s->cert->shared_sigalgs;
-    if (!shsigalgs || idx >= (int)s->cert->shared_sigalgslen)
+    TLS_SIGALGS *shsigalgs = s->shared_sigalgs;
+    if (!shsigalgs || idx >= (int)s->shared_sigalgslen)
         return 0;
     shsigalgs += idx;
     if (phash)
@@ -3541,7 +3595,7 @@ int SSL_get_shared_sigalgs(SSL *s, int idx,
         *rsig = shsigalgs->rsign;
     if (rhash)
         *rhash = shsigalgs->rhash;
-    return s->cert->shared_sigalgslen;
+    return s->shared_sigalgslen;
 }
 
 #define MAX_SIGALGLEN   (TLSEXT_hash_num * TLSEXT_signature_num * 2)
@@ -3656,7 +3710,7 @@ int tls1_set_sigalgs(CERT *c, const int *psig_nids, size_t salglen,
     return 0;
 }
 
-static int tls1_check_sig_alg(CERT *c, X509 *x, int default_nid)
+static int tls1_check_sig_alg(SSL *s, X509 *x, int default_nid)
 {
     int sig_nid;
     size_t i;
@@ -3665,8 +3719,8 @@ static int tls1_check_sig_alg(CERT *c, X509 *x, int default_nid)
     sig_nid = X509_get_signature_nid(x);
     if (default_nid)
         return sig_nid == default_nid ? 1 : 0;
-    for (i = 0; i < c->shared_sigalgslen; i++)
-        if (sig_nid == c->shared_sigalgs[i].signandhash_nid)
+    for (i = 0; i < s->shared_sigalgslen; i++)
+        if (sig_nid == s->shared_sigalgs[i].signandhash_nid)
             return 1;
     return 0;
 }
@@ -3819,14 +3873,14 @@ int tls1_check_chain(SSL *s, X509 *x, EVP_PKEY *pk, STACK_OF(X509) *chain,
             }
         }
         /* Check signature algorithm of each cert in chain */
-        if (!tls1_check_sig_alg(c, x, default_nid)) {
+        if (!tls1_check_sig_alg(s, x, default_nid)) {
             if (!check_flags)
                 goto end;
         } else
             rv |= CERT_PKEY_EE_SIGNATURE;
         rv |= CERT_PKEY_CA_SIGNATURE;
         for (i = 0; i < sk_X509_num(chain); i++) {
-            if (!tls1_check_sig_alg(c, sk_X509_value(chain, i), default_nid)) {
+            if (!tls1_check_sig_alg(s, sk_X509_value(chain, i), default_nid)) {
                 if (check_flags) {
                     rv &= ~CERT_PKEY_CA_SIGNATURE;
                     break;
@@ -3967,11 +4021,114 @@ int SSL_check_chain(SSL *s, X509 *x, EVP_PKEY *pk, STACK_OF(X509) *chain)
 
 
 #ifndef OPENSSL_NO_DH
-DH *ssl_get_auto_dh(SSL *s)
+static void tls1_ffdhe_init(void)
+{
+    size_t i;
+
+    for (i = 0; i < OSSL_NELEM(ffdhe_list); i++) {
+        DH *dh = ffdhe_list[i].get_params();
+        EVP_PKEY *pkey = EVP_PKEY_new();
+
+        if (dh == NULL || pkey == NULL || !EVP_PKEY_assign_DH(pkey, dh)) {
+            DH_free(dh);
+            EVP_PKEY_free(pkey);
+            continue;
+        }
+        ffdhe_params[i] = pkey;
+    }
+}
+
+/* The shared parameters of ffdhe_list[i], or NULL */
+static EVP_PKEY *tls1_ffdhe_params(size_t i)
+{
+    if (!CRYPTO_THREAD_run_once(&ffdhe_once, tls1_ffdhe_init))
+        return NULL;
+    return ffdhe_params[i];
+}
+
+void tls1_ffdhe_free_int(void)
+{
+    size_t i;
+
+    for (i = 0; i < OSSL_NELEM(ffdhe_list); i++) {
+        EVP_PKEY_free(ffdhe_params[i]);
+        ffdhe_params[i] = NULL;
+    }
+}
+
+/*
+ * Return the shared parameters of |pkey| if they are those of one of the
+ * RFC 7919 groups, or NULL.
+ */
+EVP_PKEY *tls1_get_ffdhe(const EVP_PKEY *pkey)
+{
+    const BIGNUM *p, *g, *fp, *fg;
+    EVP_PKEY *params;
+    size_t i;
+
+    if (EVP_PKEY_id(pkey) != EVP_PKEY_DH)
+        return NULL;
+    DH_get0_pqg(EVP_PKEY_get0_DH((EVP_PKEY *)pkey), &p, NULL, &g);
+    for (i = 0; i < OSSL_NELEM(ffdhe_list); i++) {
+        if ((params = tls1_ffdhe_params(i)) == NULL)
+            continue;
+        DH_get0_pqg(EVP_PKEY_get0_DH(params), &fp, NULL, &fg);
+        if (BN_cmp(p, fp) == 0 && BN_cmp(g, fg) == 0)
+            return params;
+    }
+    return NULL;
+}
+
+/*
+ * Pick the RFC 7919 group to use with a client that listed some in its
+ * supported groups extension: the weakest one that gives at least |secbits|
+ * bits of security, or else the strongest one. Returns a new reference to
+ * the shared parameters, or NULL if the client did not list any usable one.
+ */
+static EVP_PKEY *tls1_shared_ffdhe(SSL *s, int secbits)
+{
+    EVP_PKEY *ret = NULL;
+# ifndef OPENSSL_NO_EC
+    const unsigned char *groups = s->session->tlsext_ellipticcurvelist;
+    size_t num_groups = s->session->tlsext_ellipticcurvelist_length / 2;
+    size_t i, j;
+
+    for (i = 0; i < OSSL_NELEM(ffdhe_list); i++) {
+        EVP_PKEY *params;
+
+        for (j = 0; j < num_groups; j++) {
+            if (((unsigned int)groups[2 * j] << 8 | groups[2 * j + 1])
+                == ffdhe_list[i].group_id)
+                break;
+        }
+        if (j == num_groups || (params = tls1_ffdhe_params(i)) == NULL
+            || !ssl_security(s, SSL_SECOP_TMP_DH,
+                             EVP_PKEY_security_bits(params), 0, params))
+            continue;
+        ret = params;
+        if (EVP_PKEY_security_bits(params) >= secbits)
+            break;
+    }
+    if (ret != NULL && !EVP_PKEY_up_ref(ret))
+        ret = NULL;
+# endif
+    return ret;
+}
+
+/*
+ * Return a new reference to the parameters to use for DHE, preferably one
+ * of the RFC 7919 groups.
+ */
+EVP_PKEY *ssl_get_auto_dh(SSL *s)
 {
     int dh_secbits = 80;
-    if (s->cert->dh_tmp_auto == 2)
-        return DH_get_1024_160();
+    DH *dhp = NULL;
+    EVP_PKEY *pkey;
+
+    if (s->cert->dh_tmp_auto == 2) {
+        dhp = DH_get_1024_160();
+        goto wrap;
+    }
     if (s->s3->tmp.new_cipher->algorithm_auth & (SSL_aNULL | SSL_aPSK)) {
         if (s->s3->tmp.new_cipher->strength_bits == 256)
             dh_secbits = 128;
@@ -3982,29 +4139,42 @@ DH *ssl_get_auto_dh(SSL *s)
         dh_secbits = EVP_PKEY_security_bits(cpk->privatekey);
     }
 
-    if (dh_secbits >= 128) {
-        DH *dhp = DH_new();
+    if ((pkey = tls1_shared_ffdhe(s, dh_secbits)) != NULL)
+        return pkey;
+
+    if (dh_secbits >= 192) {
         BIGNUM *p, *g;
+
+        dhp = DH_new();
         if (dhp == NULL)
             return NULL;
         g = BN_new();
         if (g != NULL)
             BN_set_word(g, 2);
-        if (dh_secbits >= 192)
-            p = BN_get_rfc3526_prime_8192(NULL);
-        else
-            p = BN_get_rfc3526_prime_3072(NULL);
+        p = BN_get_rfc3526_prime_8192(NULL);
         if (p == NULL || g == NULL || !DH_set0_pqg(dhp, p, NULL, g)) {
             DH_free(dhp);
             BN_free(p);
             BN_free(g);
             return NULL;
         }
-        return dhp;
+    } else if (dh_secbits >= 112) {
+        /* Offer the RFC 7919 groups to clients that did not list them too */
+        pkey = tls1_ffdhe_params(dh_secbits >= 128 ? 1 : 0);
+        if (pkey == NULL || !EVP_PKEY_up_ref(pkey))
+            return NULL;
+        return pkey;
+    } else {
+        dhp = DH_get_1024_160();
+    }
+
+ wrap:
+    if (dhp == NULL || (pkey = EVP_PKEY_new()) == NULL) {
+        DH_free(dhp);
+        return NULL;
     }
-    if (dh_secbits >= 112)
-        return DH_get_2048_224();
-    return DH_get_1024_160();
+    EVP_PKEY_assign_DH(pkey, dhp);
+    return pkey;
 }
 #endif
 
@@ -70,6 +70,8 @@ int test_mod_mul(BIO *bp, BN_CTX *ctx);
 int test_mod_exp(BIO *bp, BN_CTX *ctx);
 int test_mod_exp_mont_consttime(BIO *bp, BN_CTX *ctx);
 int test_mod_exp_mont5(BIO *bp, BN_CTX *ctx);
+int test_mod_exp_rsaz(BIO *bp, BN_CTX *ctx);
+int test_ctx_arena(BIO *bp, BN_CTX *ctx);
 int test_exp(BIO *bp, BN_CTX *ctx);
 int test_gf2m_add(BIO *bp);
 int test_gf2m_mod(BIO *bp);
@@ -83,6 +85,7 @@ int test_gf2m_mod_solve_quad(BIO *bp, BN_CTX *ctx);
 int test_kron(BIO *bp, BN_CTX *ctx);
 int test_sqrt(BIO *bp, BN_CTX *ctx);
 int test_small_prime(BIO *bp, BN_CTX *ctx);
+int test_prime_gen(BIO *bp, BN_CTX *ctx);
 int rand_neg(void);
 static int results = 0;
 
@@ -238,6 +241,13 @@ int main(int argc, char *argv[])
         goto err;
     if (!test_mod_exp_mont5(out, ctx))
         goto err;
+    if (!test_mod_exp_rsaz(out, ctx))
+        goto err;
+    (void)BIO_flush(out);
+
+    message(out, "BN_CTX_arena_new");
+    if (!test_ctx_arena(out, ctx))
+        goto err;
     (void)BIO_flush(out);
 
     message(out, "BN_exp");
@@ -260,6 +270,11 @@ int main(int argc, char *argv[])
         goto err;
     (void)BIO_flush(out);
 
+    message(out, "Prime generation");
+    if (!test_prime_gen(out, ctx))
+        goto err;
+    (void)BIO_flush(out);
+
 #ifndef OPENSSL_NO_EC2M
     message(out, "BN_GF2m_add");
     if (!test_gf2m_add(out))
@@ -1163,6 +1178,139 @@ int test_mod_exp_mont5(BIO *bp, BN_CTX *ctx)
     return (1);
 }
 
+/*
+ * Test constant-time modular exponentiation with moduli of RSA-2048, 3072
+ * and 4096 CRT halves, which on x86_64 with AVX512IFMA take yet another
+ * code path, against BN_mod_exp_simple. Pairs of them are also run
+ * through BN_mod_exp_mont_consttime_x2.
+ */
+int test_mod_exp_rsaz(BIO *bp, BN_CTX *ctx)
+{
+    static const int sizes[] = { 1024, 1536, 2048 };
+    BIGNUM *a, *p, *m, *d, *e, *a2, *m2, *d2, *e2;
+    int i, j, ret = 0;
+
+    a = BN_new();
+    p = BN_new();
+    m = BN_new();
+    d = BN_new();
+    e = BN_new();
+    a2 = BN_new();
+    m2 = BN_new();
+    d2 = BN_new();
+    e2 = BN_new();
+    if (a == NULL || p == NULL || m == NULL || d == NULL || e == NULL
+        || a2 == NULL || m2 == NULL || d2 == NULL || e2 == NULL)
+        goto err;
+
+    for (i = 0; i < (int)(sizeof(sizes) / sizeof(sizes[0])); i++) {
+        for (j = 0; j < 4; j++) {
+            /* top bit set in the first rounds, as in RSA primes */
+            if (!BN_bntest_rand(m, sizes[i], j < 2 ? 0 : -1, 1)
+                || !BN_bntest_rand(p, sizes[i] - j, 0, 0))
+                goto err;
+            switch (j) {
+            case 0:                /* largest input */
+                if (!BN_sub(a, m, BN_value_one()))
+                    goto err;
+                break;
+            case 1:                /* short input */
+                if (!BN_set_word(a, 2))
+                    goto err;
+                break;
+            default:
+                if (!BN_rand_range(a, m))
+                    goto err;
+            }
+            if (!BN_mod_exp_mont_consttime(d, a, p, m, ctx, NULL)
+                || !BN_mod_exp_simple(e, a, p, m, ctx))
+                goto err;
+            if (BN_cmp(d, e) != 0) {
+                fprintf(stderr, "Modular exponentiation test failed for "
+                        "%d-bit modulus!\n", sizes[i]);
+                goto err;
+            }
+
+            if (!BN_bntest_rand(m2, sizes[i], 0, 1)
+                || !BN_rand_range(a2, m2)
+                || !BN_mod_exp_simple(e2, a2, p, m2, ctx)
+                || !BN_mod_exp_mont_consttime_x2(d, a, p, m, NULL,
+                                                 d2, a2, p, m2, NULL, ctx))
+                goto err;
+            if (BN_cmp(d, e) != 0 || BN_cmp(d2, e2) != 0) {
+                fprintf(stderr, "Modular exponentiation x2 test failed for "
+                        "%d-bit moduli!\n", sizes[i]);
+                goto err;
+            }
+        }
+    }
+    ret = 1;
+ err:
+    BN_free(a);
+    BN_free(p);
+    BN_free(m);
+    BN_free(d);
+    BN_free(e);
+    BN_free(a2);
+    BN_free(m2);
+    BN_free(d2);
+    BN_free(e2);
+    return ret;
+}
+
+/*
+ * Check that an arena BN_CTX gives the same results as an ordinary one, for
+ * moduli both within and beyond the size it was created for, and with more
+ * temporaries than fit in one of its blocks.
+ */
+int test_ctx_arena(BIO *bp, BN_CTX *ctx)
+{
+    BN_CTX *actx = BN_CTX_arena_new(256);
+    BIGNUM *a = BN_new(), *p = BN_new(), *m = BN_new();
+    BIGNUM *r = BN_new(), *s = BN_new(), *t[40];
+    int i, j, bits, ret = 0;
+
+    if (actx == NULL || a == NULL || p == NULL || m == NULL || r == NULL
+        || s == NULL)
+        goto err;
+
+    for (i = 0; i < num2; i++) {
+        bits = (i & 1) ? 1024 : 256;
+        BN_CTX_start(actx);
+        for (j = 0; j < (int)(sizeof(t) / sizeof(t[0])); j++)
+            if ((t[j] = BN_CTX_get(actx)) == NULL
+                || !BN_bntest_rand(t[j], bits, 0, 0))
+                goto err;
+
+        if (!BN_bntest_rand(m, bits, 0, 1)
+            || !BN_bntest_rand(a, bits - 1, 0, 0)
+            || !BN_bntest_rand(p, bits, 0, 0)
+            || !BN_mod_exp_mont_consttime(r, a, p, m, actx, NULL)
+            || !BN_mod_exp_mont_consttime(s, a, p, m, ctx, NULL)
+            || !BN_mul(t[0], t[1], t[2], actx)) {
+            BN_CTX_end(actx);
+            goto err;
+        }
+        BN_swap(t[3], s);
+        BN_swap(t[3], s);
+        BN_CTX_end(actx);
+
+        if (BN_cmp(r, s) != 0) {
+            fprintf(stderr, "BN_CTX arena test failed!\n");
+            goto err;
+        }
+    }
+    ret = 1;
+ err:
+    BN_CTX_free(actx);
+    BN_free(a);
+    BN_free(p);
+    BN_free(m);
+    BN_free(r);
+    BN_free(s);
+    return ret;
+}
+
 int test_exp(BIO *bp, BN_CTX *ctx)
 {
     BIGNUM *a, *b, *d, *e, *one;
@@ -1839,6 +1987,76 @@ int test_small_prime(BIO *bp, BN_CTX *ctx)
     return ret;
 }
 
+/* A "thread pool" that runs tasks in reverse order on the calling thread */
+static int run_tasks_backwards(void *pool, void (*task) (void *arg),
+                               void *args[], size_t num)
+{
+    while (num-- > 0)
+        task(args[num]);
+    return 1;
+}
+
+/*
+ * Test the sieve used for primes of more than one word, with and without
+ * |add| and |rem|, and the search over a thread pool.
+ */
+int test_prime_gen(BIO *bp, BN_CTX *ctx)
+{
+    static const struct {
+        int bits, safe;
+        BN_ULONG add, rem;
+    } tests[] = {
+        { 80, 0, 0, 0 }, { 512, 0, 0, 0 }, { 256, 1, 0, 0 },
+        { 256, 0, 12, 7 }, { 256, 1, 24, 23 }, { 256, 1, 12, 11 },
+        /* odd add, or odd add/2 for safe primes: DH generators 5 and 2 */
+        { 256, 0, 15, 4 }, { 256, 1, 10, 3 }, { 256, 1, 2, 1 }
+    };
+    BN_GENCB *cb = BN_GENCB_new();
+    BIGNUM *p = BN_new(), *q = BN_new(), *add = BN_new(), *rem = BN_new();
+    int i, pool, ret = 0;
+
+    if (cb == NULL || p == NULL || q == NULL || add == NULL || rem == NULL)
+        goto err;
+
+    for (pool = 0; pool < 2; pool++) {
+        BN_GENCB_set(cb, genprime_cb, NULL);
+        if (pool)
+            BN_GENCB_set_thread_pool(cb, run_tasks_backwards, NULL, 3);
+
+        for (i = 0; i < (int)(sizeof(tests) / sizeof(tests[0])); i++) {
+            int with_add = tests[i].add != 0;
+
+            if (!BN_set_word(add, tests[i].add)
+                || !BN_set_word(rem, tests[i].rem)
+                || !BN_generate_prime_ex(p, tests[i].bits, tests[i].safe,
+                                         with_add ? add : NULL,
+                                         with_add ? rem : NULL, cb)
+                || !BN_rshift1(q, p))
+                goto err;
+            putc('\n', stderr);
+            if (BN_num_bits(p) > tests[i].bits
+                || (!with_add && BN_num_bits(p) != tests[i].bits)
+                || BN_is_prime_ex(p, BN_prime_checks, ctx, NULL) != 1
+                || (tests[i].safe
+                    && BN_is_prime_ex(q, BN_prime_checks, ctx, NULL) != 1)
+                || (with_add
+                    && BN_mod_word(p, tests[i].add) != tests[i].rem)) {
+                fprintf(stderr, "Prime generation test %d failed%s!\n", i,
+                        pool ? " with thread pool" : "");
+                goto err;
+            }
+        }
+    }
+    ret = 1;
+ err:
+    BN_GENCB_free(cb);
+    BN_free(p);
+    BN_free(q);
+    BN_free(add);
+    BN_free(rem);
+    return ret;
+}
+
 int test_lshift(BIO *bp, BN_CTX *ctx, BIGNUM *a_)
 {
     BIGNUM *a, *b, *c, *d;
@@ -0,0 +1,164 @@
+/*
+ * Copyright 2016 The OpenSSL Project Authors. All Rights Reserved.
+ *
+ * Licensed under the OpenSSL license (the "License").  You may not use
+ * this file except in compliance with the License.  You can obtain a copy
+ * in the file LICENSE in the source distribution or at
+ * https://www.openssl.org/source/license.html
+ */
+
+/*
+ * Exercise the batching datagram BIO over a pair of connected UDP sockets on
+ * the loopback interface.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#define USE_SOCKETS
+#include "e_os.h"
+
+#include <openssl/bio.h>
+#include <openssl/err.h>
+
+#if !defined(OPENSSL_NO_DGRAM) && !defined(OPENSSL_NO_SOCK)
+
+# define NUM_DGRAMS 11
+
+static int make_socket(BIO_ADDR *local)
+{
+    static const unsigned char loopback[4] = { 127, 0, 0, 1 };
+    union BIO_sock_info_u info;
+    int s;
+
+    if (!BIO_ADDR_rawmake(local, AF_INET, loopback, sizeof(loopback), 0))
+        return -1;
+    s = BIO_socket(AF_INET, SOCK_DGRAM, 0, 0);
+    if (s == -1)
+        return -1;
+    info.addr = local;
+    if (!BIO_listen(s, local, 0)
+            || !BIO_sock_info(s, BIO_SOCK_INFO_ADDRESS, &info)) {
+        BIO_closesocket(s);
+        return -1;
+    }
+    return s;
+}
+
+static int test_batched_io(void)
+{
+    BIO_ADDR *addr1 = BIO_ADDR_new(), *addr2 = BIO_ADDR_new();
+    BIO *tx = NULL, *rx = NULL;
+    int s1 = -1, s2 = -1, i, len, got = 0, ret = 0;
+    unsigned char msg[64], buf[64];
+
+    if (addr1 == NULL || addr2 == NULL)
+        goto err;
+    if ((s1 = make_socket(addr1)) == -1 || (s2 = make_socket(addr2)) == -1) {
+        /* No usable loopback interface: nothing we can test here */
+        printf("Unable to create loopback sockets, skipping\n");
+        ret = 1;
+        goto err;
+    }
+    if (!BIO_connect(s1, addr2, 0) || !BIO_connect(s2, addr1, 0))
+        goto err;
+
+    tx = BIO_new_dgram_mmsg(s1, BIO_CLOSE);
+    if (tx == NULL)
+        goto err;
+    s1 = -1;
+    rx = BIO_new_dgram_mmsg(s2, BIO_CLOSE);
+    if (rx == NULL)
+        goto err;
+    s2 = -1;
+    BIO_ctrl_set_connected(tx, addr2);
+    BIO_ctrl_set_connected(rx, addr1);
+
+    if (!BIO_socket_nbio(BIO_get_fd(rx, NULL), 1))
+        goto err;
+    if (!BIO_dgram_set_write_batch(tx, 16) || !BIO_dgram_set_read_batch(rx, 4)) {
+        printf("Failed to configure batch sizes\n");
+        goto err;
+    }
+    /* Try to use GSO where the kernel supports it; falls back silently */
+    BIO_dgram_set_gso(tx, 1);
+
+    for (i = 0; i < NUM_DGRAMS; i++) {
+        memset(msg, 'a' + i, sizeof(msg));
+        /* Every datagram but the last has the same size, as GSO wants */
+        len = i == NUM_DGRAMS - 1 ? 17 : (int)sizeof(msg);
+        if (BIO_write(tx, msg, len) != len) {
+            printf("Write of datagram %d failed\n", i);
+            goto err;
+        }
+    }
+    /* Nothing may have reached the wire before the flush */
+    if (BIO_read(rx, buf, sizeof(buf)) > 0 || !BIO_should_retry(rx)) {
+        printf("Datagrams sent before flush\n");
+        goto err;
+    }
+    if (BIO_flush(tx) <= 0) {
+        printf("Flush failed\n");
+        goto err;
+    }
+    if (!BIO_socket_nbio(BIO_get_fd(rx, NULL), 0))
+        goto err;
+
+    while (got < NUM_DGRAMS) {
+        len = BIO_read(rx, buf, sizeof(buf));
+        if (len <= 0) {
+            printf("Read of datagram %d failed\n", got);
+            goto err;
+        }
+        if (len != (got == NUM_DGRAMS - 1 ? 17 : (int)sizeof(msg))
+                || buf[0] != 'a' + got || buf[len - 1] != 'a' + got) {
+            printf("Datagram %d corrupted or out of order\n", got);
+            goto err;
+        }
+        if (BIO_dgram_get_queued(rx) > 3) {
+            printf("More datagrams queued than the batch allows\n");
+            goto err;
+        }
+        got++;
+    }
+    if (BIO_dgram_get_queued(rx) != 0 || BIO_pending(rx) != 0) {
+        printf("Unexpected datagrams left in the queue\n");
+        goto err;
+    }
+
+    ret = 1;
+ err:
+    if (s1 != -1)
+        BIO_closesocket(s1);
+    if (s2 != -1)
+        BIO_closesocket(s2);
+    BIO_free(tx);
+    BIO_free(rx);
+    BIO_ADDR_free(addr1);
+    BIO_ADDR_free(addr2);
+    return ret;
+}
+
+int main(void)
+{
+    int ret = 1;
+
+    if (!test_batched_io())
+        goto end;
+
+    printf("PASS\n");
+    ret = 0;
+ end:
+    ERR_print_errors_fp(stderr);
+    return ret;
+}
+
+#else
+
+int main(void)
+{
+    printf("No datagram support, skipping\n");
+    return 0;
+}
+
+#endif
@@ -34,6 +34,8 @@ static const char rnd_seed[] =
     "string to make the random number generator think it has entropy";
 
 static int run_rfc5114_tests(void);
+static int run_fixed_base_tests(void);
+static int run_rfc7919_tests(void);
 
 int main(int argc, char *argv[])
 {
@@ -148,6 +150,10 @@ int main(int argc, char *argv[])
         ret = 0;
     if (!run_rfc5114_tests())
         ret = 1;
+    if (!run_fixed_base_tests())
+        ret = 1;
+    if (!run_rfc7919_tests())
+        ret = 1;
  err:
     (void)BIO_flush(out);
     ERR_print_errors_fp(stderr);
@@ -595,4 +601,139 @@ static int run_rfc5114_tests(void)
     return 0;
 }
 
+/*
+ * Key generation reuses the powers of g of the parameters, also across
+ * copies of them, so check that repeated keys match g^x computed afresh.
+ */
+static int check_key(DH *dh, BN_CTX *ctx)
+{
+    const BIGNUM *p, *g, *pub_key, *priv_key;
+    BIGNUM *y = BN_new();
+    int ok;
+
+    ok = y != NULL && DH_generate_key(dh);
+    if (ok) {
+        DH_get0_pqg(dh, &p, NULL, &g);
+        DH_get0_key(dh, &pub_key, &priv_key);
+        ok = BN_mod_exp(y, g, priv_key, p, ctx) && BN_cmp(y, pub_key) == 0;
+    }
+    BN_free(y);
+    return ok;
+}
+
+static int run_fixed_base_tests(void)
+{
+    int i = 0, j;
+    DH *dh = NULL, *dup = NULL;
+    const BIGNUM *p;
+    BIGNUM *pub_key = NULL, *priv_key = NULL;
+    BN_CTX *ctx = BN_CTX_new();
+
+    if (ctx == NULL)
+        goto err;
+    for (i = 0; i < (int)OSSL_NELEM(rfctd); i++) {
+        if ((dh = rfctd[i].get_param()) == NULL)
+            goto err;
+        for (j = 0; j < 3; j++) {
+            if (!check_key(dh, ctx))
+                goto err;
+            if ((dup = DHparams_dup(dh)) == NULL || !check_key(dup, ctx))
+                goto err;
+            DH_free(dup);
+            dup = NULL;
+        }
+        /* A private key longer than the powers were computed for */
+        DH_get0_pqg(dh, &p, NULL, NULL);
+        pub_key = BN_new();
+        priv_key = BN_new();
+        if (pub_key == NULL || priv_key == NULL
+            || !BN_rand(priv_key, BN_num_bits(p) - 1, 0, 0)
+            || !DH_set0_key(dh, pub_key, priv_key))
+            goto err;
+        pub_key = priv_key = NULL;
+        if (!check_key(dh, ctx))
+            goto err;
+        DH_free(dh);
+        dh = NULL;
+        printf("Fixed base test %d OK\n", i + 1);
+    }
+    BN_CTX_free(ctx);
+    return 1;
+ err:
+    BN_free(pub_key);
+    BN_free(priv_key);
+    DH_free(dup);
+    DH_free(dh);
+    BN_CTX_free(ctx);
+    fprintf(stderr, "Fixed base test %d failed\n", i + 1);
+    ERR_print_errors_fp(stderr);
+    return 0;
+}
+
+static const struct {
+    DH *(*get_param) (void);
+    int bits;
+    long length;
+} rfc7919_groups[] = {
+    { DH_get_ffdhe2048, 2048, 225 },
+    { DH_get_ffdhe3072, 3072, 275 },
+    { DH_get_ffdhe4096, 4096, 325 }
+};
+
+static int run_rfc7919_tests(void)
+{
+    int i, codes, len;
+    DH *dhA = NULL, *dhB = NULL;
+    const BIGNUM *p, *g, *pub_key;
+    unsigned char *Z1 = NULL, *Z2 = NULL;
+
+    for (i = 0; i < (int)OSSL_NELEM(rfc7919_groups); i++) {
+        if ((dhA = rfc7919_groups[i].get_param()) == NULL
+            || (dhB = rfc7919_groups[i].get_param()) == NULL)
+            goto err;
+        DH_get0_pqg(dhA, &p, NULL, &g);
+        /*
+         * Check the smallest prime is a safe one. DH_check() wants 2 to
+         * generate the whole group, but here it generates the subgroup of
+         * order (p - 1) / 2, as intended.
+         */
+        if (BN_num_bits(p) != rfc7919_groups[i].bits || !BN_is_word(g, 2)
+            || DH_get_length(dhA) != rfc7919_groups[i].length
+            || (i == 0 && (!DH_check(dhA, &codes)
+                           || (codes & ~DH_NOT_SUITABLE_GENERATOR) != 0)))
+            goto err;
+
+        len = DH_size(dhA);
+        Z1 = OPENSSL_malloc(len);
+        Z2 = OPENSSL_malloc(len);
+        if (Z1 == NULL || Z2 == NULL
+            || !DH_generate_key(dhA) || !DH_generate_key(dhB))
+            goto err;
+        DH_get0_key(dhA, &pub_key, NULL);
+        if (DH_compute_key_padded(Z2, pub_key, dhB) != len)
+            goto err;
+        DH_get0_key(dhB, &pub_key, NULL);
+        if (DH_compute_key_padded(Z1, pub_key, dhA) != len
+            || memcmp(Z1, Z2, len) != 0)
+            goto err;
+
+        printf("RFC7919 group test %d OK\n", i + 1);
+        DH_free(dhA);
+        DH_free(dhB);
+        OPENSSL_free(Z1);
+        OPENSSL_free(Z2);
+        dhA = dhB = NULL;
+        Z1 = Z2 = NULL;
+    }
+    return 1;
+ err:
+    DH_free(dhA);
+    DH_free(dhB);
+    OPENSSL_free(Z1);
+    OPENSSL_free(Z2);
+    fprintf(stderr, "RFC7919 group test %d failed\n", i + 1);
+    ERR_print_errors_fp(stderr);
+    return 0;
+}
+
 #endif
@@ -53,6 +53,7 @@ static const char rnd_seed[] = "string to make the random number generator "
 int x9_62_tests(BIO *);
 int x9_62_test_internal(BIO *out, int nid, const char *r, const char *s);
 int test_builtin(BIO *);
+int test_ed25519_batch(BIO *);
 
 /* functions to change the RAND_METHOD */
 int change_rand(void);
@@ -293,7 +294,7 @@ int test_builtin(BIO *out)
         unsigned char dirt, offset;
 
         nid = curves[n].nid;
-        if (nid == NID_ipsec4 || nid == NID_X25519)
+        if (nid == NID_ipsec4 || nid == NID_X25519 || nid == NID_ED25519)
             continue;
         /* create new ecdsa key (== EC_KEY) */
         if ((eckey = EC_KEY_new()) == NULL)
@@ -479,6 +480,145 @@ int test_builtin(BIO *out)
     return ret;
 }
 
+/*
+ * Signs a batch of messages with Ed25519 keys through EVP and checks that
+ * ED25519_verify_batch() accepts it, and rejects it after any one signature,
+ * message or public key has been modified. Batches of 256 signatures and
+ * more are verified with Pippenger's method.
+ */
+# define ED25519_BATCH_NUM 300
+
+int test_ed25519_batch(BIO *out)
+{
+    EVP_PKEY_CTX *ctx = NULL;
+    EVP_PKEY *pkey[ED25519_BATCH_NUM] = { NULL };
+    EC_KEY *other = NULL;
+    static unsigned char msgbuf[ED25519_BATCH_NUM][20];
+    static unsigned char sigbuf[ED25519_BATCH_NUM][64];
+    static unsigned char pubbuf[ED25519_BATCH_NUM][32];
+    unsigned char sig[64], small_sig[64], small_pub[32];
+    const unsigned char *msgs[ED25519_BATCH_NUM];
+    const unsigned char *sigs[ED25519_BATCH_NUM];
+    const unsigned char *pubs[ED25519_BATCH_NUM];
+    size_t msglens[ED25519_BATCH_NUM];
+    size_t siglen, i, num;
+    int ret = 0;
+
+    BIO_printf(out, "testing Ed25519 batch verification: ");
+
+    for (i = 0; i < ED25519_BATCH_NUM; i++) {
+        EC_KEY *eckey = EC_KEY_new_by_curve_name(NID_ED25519);
+
+        pkey[i] = EVP_PKEY_new();
+        if (eckey == NULL || pkey[i] == NULL
+            || !EC_KEY_generate_key(eckey)
+            || !EVP_PKEY_assign_EC_KEY(pkey[i], eckey)) {
+            EC_KEY_free(eckey);
+            goto err;
+        }
+        if (EC_POINT_point2oct(EC_KEY_get0_group(eckey),
+                               EC_KEY_get0_public_key(eckey), 0,
+                               pubbuf[i], sizeof(pubbuf[i]), NULL)
+            != sizeof(pubbuf[i]))
+            goto err;
+
+        /* message lengths vary from 0 to 19 bytes */
+        msglens[i] = i % sizeof(msgbuf[i]);
+        if (RAND_bytes(msgbuf[i], sizeof(msgbuf[i])) <= 0)
+            goto err;
+
+        siglen = sizeof(sigbuf[i]);
+        if ((ctx = EVP_PKEY_CTX_new(pkey[i], NULL)) == NULL
+            || EVP_PKEY_sign_init(ctx) <= 0
+            || EVP_PKEY_sign(ctx, sigbuf[i], &siglen, msgbuf[i],
+                             msglens[i]) <= 0
+            || siglen != sizeof(sigbuf[i])
+            || EVP_PKEY_verify_init(ctx) <= 0
+            || EVP_PKEY_verify(ctx, sigbuf[i], siglen, msgbuf[i],
+                               msglens[i]) != 1)
+            goto err;
+        EVP_PKEY_CTX_free(ctx);
+        ctx = NULL;
+
+        msgs[i] = msgbuf[i];
+        sigs[i] = sigbuf[i];
+        pubs[i] = pubbuf[i];
+    }
+
+    /*
+     * Signing must not use a stored public key that does not belong to the
+     * private key. Signatures are deterministic, so the result is the same.
+     */
+    other = EC_KEY_new_by_curve_name(NID_ED25519);
+    siglen = sizeof(sig);
+    if (other == NULL || !EC_KEY_generate_key(other)
+        || !EC_KEY_set_public_key(EVP_PKEY_get0_EC_KEY(pkey[0]),
+                                  EC_KEY_get0_public_key(other))
+        || (ctx = EVP_PKEY_CTX_new(pkey[0], NULL)) == NULL
+        || EVP_PKEY_sign_init(ctx) <= 0
+        || EVP_PKEY_sign(ctx, sig, &siglen, msgbuf[0], msglens[0]) <= 0
+        || siglen != sizeof(sig) || memcmp(sig, sigbuf[0], siglen) != 0)
+        goto err;
+    EVP_PKEY_CTX_free(ctx);
+    ctx = NULL;
+
+    /*
+     * With the neutral element as public key and S = 0, R of order 2 only
+     * satisfies the equation multiplied by the cofactor. Single and batch
+     * verification must agree on that.
+     */
+    memset(small_pub, 0, sizeof(small_pub));
+    small_pub[0] = 1;
+    memset(small_sig, 0xff, 32);
+    small_sig[0] = 0xec;
+    small_sig[31] = 0x7f;
+    memset(small_sig + 32, 0, 32);
+    sigs[0] = small_sig;
+    pubs[0] = small_pub;
+    if (ED25519_verify_batch(msgs, msglens, sigs, pubs, 1) != 1
+        || ED25519_verify_batch(msgs, msglens, sigs, pubs, 8) != 1)
+        goto err;
+    sigs[0] = sigbuf[0];
+    pubs[0] = pubbuf[0];
+
+    /* Both the one at a time and the batched code paths */
+    for (num = 1; num <= ED25519_BATCH_NUM; num += 13) {
+        i = num / 2;
+        if (ED25519_verify_batch(msgs, msglens, sigs, pubs, num) != 1)
+            goto err;
+        sigbuf[i][0] ^= 1;
+        if (ED25519_verify_batch(msgs, msglens, sigs, pubs, num) != 0)
+            goto err;
+        sigbuf[i][0] ^= 1;
+        sigbuf[i][40] ^= 1;
+        if (ED25519_verify_batch(msgs, msglens, sigs, pubs, num) != 0)
+            goto err;
+        sigbuf[i][40] ^= 1;
+        msgbuf[i][0] ^= 1;
+        if (msglens[i] > 0
+            && ED25519_verify_batch(msgs, msglens, sigs, pubs, num) != 0)
+            goto err;
+        msgbuf[i][0] ^= 1;
+        pubs[i] = pubbuf[(i + 1) % ED25519_BATCH_NUM];
+        if (ED25519_verify_batch(msgs, msglens, sigs, pubs, num) != 0)
+            goto err;
+        pubs[i] = pubbuf[i];
+        BIO_printf(out, ".");
+        (void)BIO_flush(out);
+    }
+    BIO_printf(out, " ok\n");
+    ret = 1;
+
+ err:
+    if (!ret)
+        BIO_printf(out, " failed\n");
+    EVP_PKEY_CTX_free(ctx);
+    EC_KEY_free(other);
+    for (i = 0; i < ED25519_BATCH_NUM; i++)
+        EVP_PKEY_free(pkey[i]);
+    return ret;
+}
+
 int main(void)
 {
     int ret = 1;
@@ -499,6 +639,8 @@ int main(void)
         goto err;
     if (!test_builtin(out))
         goto err;
+    if (!test_ed25519_batch(out))
+        goto err;
 
     ret = 0;
  err:
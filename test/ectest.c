@@ -193,6 +193,198 @@ static void group_order_tests(EC_GROUP *group)
     BN_CTX_free(ctx);
 }
 
+/*
+ * test that multiplying a point with a table from EC_POINT_precompute_mult
+ * gives the same results as without it
+ */
+static void point_precompute_tests(EC_GROUP *group)
+{
+    BIGNUM *k, *order;
+    EC_POINT *P = EC_POINT_new(group);
+    EC_POINT *P2 = EC_POINT_new(group);
+    EC_POINT *Q = EC_POINT_new(group);
+    EC_POINT *R = EC_POINT_new(group);
+    BN_CTX *ctx = BN_CTX_new();
+    const EC_POINT *points[2];
+    const BIGNUM *scalars[2];
+    int i;
+
+    k = BN_new();
+    order = BN_new();
+    fprintf(stdout, "point precomputation tests ...");
+    fflush(stdout);
+    if (P == NULL || P2 == NULL || Q == NULL || R == NULL || ctx == NULL
+        || k == NULL || order == NULL)
+        ABORT;
+    if (!EC_GROUP_get_order(group, order, ctx))
+        ABORT;
+
+    if (!BN_rand_range(k, order)
+        || !EC_POINT_mul(group, P, k, NULL, NULL, ctx)
+        || !EC_POINT_copy(P2, P)
+        || !EC_POINT_precompute_mult(group, P, ctx))
+        ABORT;
+
+    for (i = 0; i < 8; i++) {
+        switch (i) {
+        case 0:
+            BN_zero(k);
+            break;
+        case 1:
+            if (!BN_one(k))
+                ABORT;
+            break;
+        case 2:
+            if (!BN_sub(k, order, BN_value_one()))
+                ABORT;
+            break;
+        case 3:
+            if (!BN_add(k, order, BN_value_one()))
+                ABORT;
+            break;
+        case 4:
+            if (!BN_rand(k, EC_GROUP_get_degree(group) + 64, 0, 0))
+                ABORT;
+            BN_set_negative(k, 1);
+            break;
+        default:
+            if (!BN_rand_range(k, order))
+                ABORT;
+        }
+        if (!EC_POINT_mul(group, Q, NULL, P, k, ctx)
+            || !EC_POINT_mul(group, R, NULL, P2, k, ctx))
+            ABORT;
+        if (0 != EC_POINT_cmp(group, Q, R, ctx))
+            ABORT;
+        fprintf(stdout, ".");
+        fflush(stdout);
+    }
+
+    /* together with the generator and a point without a table */
+    points[0] = P2;
+    points[1] = P;
+    scalars[0] = order;
+    scalars[1] = k;
+    if (!EC_POINTs_mul(group, Q, k, 2, points, scalars, ctx)
+        || !EC_POINT_mul(group, R, k, P2, k, ctx))
+        ABORT;
+    if (0 != EC_POINT_cmp(group, Q, R, ctx))
+        ABORT;
+
+    /* a table must not be used once the point has changed */
+    if (!EC_POINT_dbl(group, P, P, ctx)
+        || !EC_POINT_make_affine(group, P, ctx)
+        || !EC_POINT_dbl(group, P2, P2, ctx)
+        || !EC_POINT_mul(group, Q, NULL, P, k, ctx)
+        || !EC_POINT_mul(group, R, NULL, P2, k, ctx))
+        ABORT;
+    if (0 != EC_POINT_cmp(group, Q, R, ctx))
+        ABORT;
+    fprintf(stdout, " ok\n");
+
+    EC_POINT_free(P);
+    EC_POINT_free(P2);
+    EC_POINT_free(Q);
+    EC_POINT_free(R);
+    BN_free(k);
+    BN_free(order);
+    BN_CTX_free(ctx);
+}
+
+/*
+ * test that EC_POINTs_mul() with enough points for the bucket method gives
+ * the same result as adding up the products of a few points at a time
+ */
+# define MULTI_MUL_POINTS 130
+
+static void multi_mul_tests(EC_GROUP *group)
+{
+    const EC_POINT *points[MULTI_MUL_POINTS];
+    const BIGNUM *scalars[MULTI_MUL_POINTS];
+    EC_POINT *P[MULTI_MUL_POINTS];
+    BIGNUM *k[MULTI_MUL_POINTS];
+    EC_POINT *Q = EC_POINT_new(group);
+    EC_POINT *R = EC_POINT_new(group);
+    EC_POINT *T = EC_POINT_new(group);
+    BN_CTX *ctx = BN_CTX_new();
+    BIGNUM *order = BN_new();
+    int i, n;
+
+    fprintf(stdout, "multi-point multiplication tests ...");
+    fflush(stdout);
+    if (Q == NULL || R == NULL || T == NULL || ctx == NULL || order == NULL)
+        ABORT;
+    if (!EC_GROUP_get_order(group, order, ctx))
+        ABORT;
+
+    for (i = 0; i < MULTI_MUL_POINTS; i++) {
+        P[i] = EC_POINT_new(group);
+        k[i] = BN_new();
+        if (P[i] == NULL || k[i] == NULL)
+            ABORT;
+
+        /* every seventh term repeats the previous one */
+        if (i % 7 == 6) {
+            if (!EC_POINT_copy(P[i], P[i - 1]) || !BN_copy(k[i], k[i - 1]))
+                ABORT;
+        } else {
+            if (!BN_rand_range(k[i], order)
+                || !EC_POINT_mul(group, P[i], k[i], NULL, NULL, ctx))
+                ABORT;
+            switch (i) {
+            case 0:
+                BN_zero(k[i]);
+                break;
+            case 1:
+                if (!BN_sub(k[i], order, BN_value_one()))
+                    ABORT;
+                break;
+            case 2:
+                if (!BN_add(k[i], order, BN_value_one()))
+                    ABORT;
+                break;
+            case 3:
+                if (!EC_POINT_set_to_infinity(group, P[i]))
+                    ABORT;
+                break;
+            case 4:
+                if (!BN_rand(k[i], EC_GROUP_get_degree(group) + 64, 0, 0))
+                    ABORT;
+                BN_set_negative(k[i], 1);
+                break;
+            default:
+                if (!BN_rand_range(k[i], order))
+                    ABORT;
+            }
+        }
+        points[i] = P[i];
+        scalars[i] = k[i];
+    }
+
+    if (!EC_POINTs_mul(group, Q, k[7], MULTI_MUL_POINTS, points, scalars, ctx)
+        || !EC_POINT_mul(group, R, k[7], NULL, NULL, ctx))
+        ABORT;
+    for (i = 0; i < MULTI_MUL_POINTS; i += n) {
+        n = MULTI_MUL_POINTS - i < 10 ? MULTI_MUL_POINTS - i : 10;
+        if (!EC_POINTs_mul(group, T, NULL, n, points + i, scalars + i, ctx)
+            || !EC_POINT_add(group, R, R, T, ctx))
+            ABORT;
+    }
+    if (0 != EC_POINT_cmp(group, Q, R, ctx))
+        ABORT;
+    fprintf(stdout, " ok\n");
+
+    for (i = 0; i < MULTI_MUL_POINTS; i++) {
+        EC_POINT_free(P[i]);
+        BN_free(k[i]);
+    }
+    EC_POINT_free(Q);
+    EC_POINT_free(R);
+    EC_POINT_free(T);
+    BN_free(order);
+    BN_CTX_free(ctx);
+}
+
 static void prime_field_tests(void)
 {
     BN_CTX *ctx = NULL;
@@ -1445,10 +1637,10 @@ static void internal_curve_test(void)
         EC_GROUP *group = NULL;
         int nid = curves[n].nid;
         /*
-         * Skip for X25519 because low level operations such as EC_POINT_mul()
-         * are not supported for this curve
+         * Skip for X25519 and Ed25519 because low level operations such as
+         * EC_POINT_mul() are not supported for these curves
          */
-        if (nid == NID_X25519)
+        if (nid == NID_X25519 || nid == NID_ED25519)
             continue;
         fprintf(stdout, "%s:\n", OBJ_nid2sn(nid));
         fflush(stdout);
@@ -1456,6 +1648,8 @@ static void internal_curve_test(void)
             ABORT;
         }
         group_order_tests(group);
+        point_precompute_tests(group);
+        multi_mul_tests(group);
         EC_GROUP_free(group);
     }
 
@@ -22,6 +22,8 @@ int main(int argc, char *argv[])
 # include <openssl/crypto.h>
 # include <openssl/engine.h>
 # include <openssl/err.h>
+# include <openssl/evp.h>
+# include <openssl/objects.h>
 
 static void display_engine_list(void)
 {
@@ -44,6 +46,66 @@ static void display_engine_list(void)
     ENGINE_free(h);
 }
 
+static int test_digest_nids[] = { NID_sha256 };
+
+static int test_digests(ENGINE *e, const EVP_MD **digest, const int **nids,
+                        int nid)
+{
+    if (digest == NULL) {
+        *nids = test_digest_nids;
+        return sizeof(test_digest_nids) / sizeof(test_digest_nids[0]);
+    }
+    if (nid == NID_sha256) {
+        *digest = EVP_sha256();
+        return 1;
+    }
+    *digest = NULL;
+    return 0;
+}
+
+/* Check that digest dispatch follows ENGINE registration changes */
+static int test_dispatch(void)
+{
+    ENGINE *e, *impl = NULL;
+    int ret = 0;
+
+    if ((e = ENGINE_new()) == NULL
+            || !ENGINE_set_id(e, "test_dispatch")
+            || !ENGINE_set_name(e, "Dispatch test item")
+            || !ENGINE_set_digests(e, test_digests)) {
+        printf("Couldn't set up dispatch test ENGINE\n");
+        goto end;
+    }
+    if ((impl = ENGINE_get_digest_engine(NID_sha256)) != NULL) {
+        printf("Digest ENGINE found before registration!\n");
+        goto end;
+    }
+    if (!ENGINE_register_digests(e)) {
+        printf("Digest registration failed!\n");
+        goto end;
+    }
+    if ((impl = ENGINE_get_digest_engine(NID_sha256)) != e) {
+        printf("Registered digest ENGINE not found!\n");
+        goto end;
+    }
+    ENGINE_finish(impl);
+    if ((impl = ENGINE_get_digest_engine(NID_sha1)) != NULL) {
+        printf("Digest ENGINE found for unregistered nid!\n");
+        goto end;
+    }
+    ENGINE_unregister_digests(e);
+    if ((impl = ENGINE_get_digest_engine(NID_sha256)) != NULL) {
+        printf("Digest ENGINE found after unregistration!\n");
+        goto end;
+    }
+    printf("Digest dispatch follows registrations\n");
+    ret = 1;
+ end:
+    ENGINE_finish(impl);
+    ENGINE_free(e);
+    return ret;
+}
+
 int main(int argc, char *argv[])
 {
     ENGINE *block[512];
@@ -144,6 +206,8 @@ int main(int argc, char *argv[])
         goto end;
     } else
         printf("Successfully added and removed to an empty list!\n");
+    if (!test_dispatch())
+        goto end;
     printf("About to beef up the engine-type list\n");
     for (loop = 0; loop < 512; loop++) {
         sprintf(buf, "id%i", loop);
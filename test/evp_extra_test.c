@@ -9,10 +9,12 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <openssl/bio.h>
 #include <openssl/crypto.h>
 #include <openssl/err.h>
 #include <openssl/evp.h>
+#include <openssl/hmac.h>
 #include <openssl/rsa.h>
 #include <openssl/x509.h>
 
@@ -358,6 +360,221 @@ static int test_EVP_PKCS82PKEY(void)
 }
 #endif
 
+/*
+ * Tests restoring saved digest, HMAC and cipher contexts into contexts that
+ * are already set up, which takes the in place copy path.
+ */
+static int test_EVP_restore(void)
+{
+    static const unsigned char key[16] = "restore test key";
+    static const unsigned char msg[32] = "message to be hashed or crypted";
+    unsigned char md[EVP_MAX_MD_SIZE], md2[EVP_MAX_MD_SIZE];
+    unsigned char ct[sizeof(msg)], ct2[sizeof(msg)];
+    unsigned int mdlen, mdlen2;
+    int i, outl, ret = 0;
+    EVP_MD_CTX *mctx = EVP_MD_CTX_new(), *saved_mctx = EVP_MD_CTX_new();
+    HMAC_CTX *hctx = HMAC_CTX_new(), *saved_hctx = HMAC_CTX_new();
+    EVP_CIPHER_CTX *cctx = EVP_CIPHER_CTX_new();
+    EVP_CIPHER_CTX *saved_cctx = EVP_CIPHER_CTX_new();
+
+    if (mctx == NULL || saved_mctx == NULL || hctx == NULL
+            || saved_hctx == NULL || cctx == NULL || saved_cctx == NULL)
+        goto done;
+
+    if (!EVP_DigestInit_ex(saved_mctx, EVP_sha256(), NULL)
+            || !EVP_DigestUpdate(saved_mctx, key, sizeof(key))
+            || !HMAC_Init_ex(saved_hctx, key, sizeof(key), EVP_sha256(), NULL)
+            || !EVP_EncryptInit_ex(saved_cctx, EVP_aes_128_cbc(), NULL, key,
+                                   key))
+        goto done;
+
+    for (i = 0; i < 2; i++) {
+        if (!EVP_MD_CTX_copy_ex(mctx, saved_mctx)
+                || !EVP_DigestUpdate(mctx, msg, sizeof(msg))
+                || !EVP_DigestFinal_ex(mctx, md, &mdlen)
+                || !EVP_DigestInit_ex(mctx, EVP_sha256(), NULL)
+                || !EVP_DigestUpdate(mctx, key, sizeof(key))
+                || !EVP_DigestUpdate(mctx, msg, sizeof(msg))
+                || !EVP_DigestFinal_ex(mctx, md2, &mdlen2)
+                || mdlen != mdlen2 || memcmp(md, md2, mdlen) != 0) {
+            fprintf(stderr, "Restored digest context mismatch\n");
+            goto done;
+        }
+
+        if (!HMAC_CTX_copy(hctx, saved_hctx)
+                || !HMAC_Update(hctx, msg, sizeof(msg))
+                || !HMAC_Final(hctx, md, &mdlen)
+                || HMAC(EVP_sha256(), key, sizeof(key), msg, sizeof(msg),
+                        md2, &mdlen2) == NULL
+                || mdlen != mdlen2 || memcmp(md, md2, mdlen) != 0) {
+            fprintf(stderr, "Restored HMAC context mismatch\n");
+            goto done;
+        }
+
+        if (!EVP_CIPHER_CTX_copy(cctx, saved_cctx)
+                || !EVP_EncryptUpdate(cctx, ct, &outl, msg, sizeof(msg))
+                || outl != (int)sizeof(msg)
+                || !EVP_EncryptInit_ex(cctx, EVP_aes_128_cbc(), NULL, key,
+                                       key)
+                || !EVP_EncryptUpdate(cctx, ct2, &outl, msg, sizeof(msg))
+                || outl != (int)sizeof(msg)
+                || memcmp(ct, ct2, sizeof(ct)) != 0) {
+            fprintf(stderr, "Restored cipher context mismatch\n");
+            goto done;
+        }
+    }
+
+    ret = 1;
+
+ done:
+    EVP_MD_CTX_free(mctx);
+    EVP_MD_CTX_free(saved_mctx);
+    HMAC_CTX_free(hctx);
+    HMAC_CTX_free(saved_hctx);
+    EVP_CIPHER_CTX_free(cctx);
+    EVP_CIPHER_CTX_free(saved_cctx);
+
+    return ret;
+}
+
+/*
+ * A thread pool that runs the tasks one after the other, last one first, so
+ * that the result can't depend on the order they are done in.
+ */
+static int pool_tasks_run = 0;
+
+static int run_tasks_backwards(void *pool, void (*task) (void *arg),
+                               void *args[], size_t num)
+{
+    while (num > 0)
+        task(args[--num]);
+    pool_tasks_run++;
+    return 1;
+}
+
+/*
+ * Encrypt or decrypt |len| bytes in updates of the sizes in |split|, with a
+ * thread pool if |chunk| is non-zero. For GCM the tag is written to or
+ * checked against |tag|.
+ */
+static int thread_pool_cipher(const EVP_CIPHER *cipher, int enc, size_t chunk,
+                              const unsigned char *key,
+                              const unsigned char *iv,
+                              const unsigned char *in, unsigned char *out,
+                              const int split[], unsigned char *tag)
+{
+    static const unsigned char aad[15] = "additional data";
+    EVP_CIPHER_CTX *ctx = EVP_CIPHER_CTX_new();
+    int gcm = EVP_CIPHER_mode(cipher) == EVP_CIPH_GCM_MODE;
+    int i, outl, ret = 0;
+
+    if (ctx == NULL)
+        return 0;
+    if (chunk != 0
+            && !EVP_CIPHER_CTX_set_thread_pool(ctx, run_tasks_backwards,
+                                               NULL, chunk))
+        goto done;
+    if (!EVP_CipherInit_ex(ctx, cipher, NULL, key, iv, enc)
+            || (gcm && !EVP_CipherUpdate(ctx, NULL, &outl, aad, sizeof(aad))))
+        goto done;
+    for (i = 0; split[i] != 0; i++) {
+        if (!EVP_CipherUpdate(ctx, out, &outl, in, split[i])
+                || outl != split[i])
+            goto done;
+        in += split[i];
+        out += split[i];
+    }
+    if (gcm && !enc
+            && !EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_AEAD_SET_TAG, 16, tag))
+        goto done;
+    if (!EVP_CipherFinal_ex(ctx, out, &outl) || outl != 0)
+        goto done;
+    if (gcm && enc
+            && !EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_AEAD_GET_TAG, 16, tag))
+        goto done;
+    ret = 1;
+
+ done:
+    EVP_CIPHER_CTX_free(ctx);
+    return ret;
+}
+
+/*
+ * Tests that splitting CTR and GCM updates over a thread pool gives the
+ * same ciphertext and tag as processing them in one go.
+ */
+static int test_EVP_thread_pool(void)
+{
+    static const unsigned char key[32] = "thread pool test key, 32 bytes.";
+    /* The counter carries across the low 96 bits after 16 blocks */
+    static const unsigned char iv[16] = {
+        0x00, 0x00, 0x00, 0x00, 0xff, 0xff, 0xff, 0xff,
+        0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xf0
+    };
+    static const int splits[][5] = {
+        { 60000, 0 },
+        { 5, 20000, 31, 16, 0 },
+        { 4096, 4096, 4096, 0 },
+        { 1, 15, 8300, 7, 0 }
+    };
+    const EVP_CIPHER *ciphers[4];
+    unsigned char *pt = OPENSSL_malloc(60000), *ct = OPENSSL_malloc(60000);
+    unsigned char *buf = OPENSSL_malloc(60000);
+    unsigned char tag[16], tag2[16];
+    size_t i, j, len;
+    int k, ret = 0;
+
+    ciphers[0] = EVP_aes_128_ctr();
+    ciphers[1] = EVP_aes_256_ctr();
+    ciphers[2] = EVP_aes_128_gcm();
+    ciphers[3] = EVP_aes_256_gcm();
+
+    if (pt == NULL || ct == NULL || buf == NULL)
+        goto done;
+    for (i = 0; i < 60000; i++)
+        pt[i] = (unsigned char)(i * 7 + (i >> 8));
+
+    for (i = 0; i < sizeof(ciphers) / sizeof(ciphers[0]); i++) {
+        for (j = 0; j < sizeof(splits) / sizeof(splits[0]); j++) {
+            for (len = 0, k = 0; splits[j][k] != 0; k++)
+                len += splits[j][k];
+            pool_tasks_run = 0;
+            memset(tag, 0, sizeof(tag));
+            memset(tag2, 0, sizeof(tag2));
+            if (!thread_pool_cipher(ciphers[i], 1, 0, key, iv, pt, ct,
+                                    splits[j], tag)
+                    || !thread_pool_cipher(ciphers[i], 1, 1000, key, iv, pt,
+                                           buf, splits[j], tag2)
+                    || memcmp(ct, buf, len) != 0
+                    || memcmp(tag, tag2, sizeof(tag)) != 0) {
+                fprintf(stderr, "Thread pool encryption mismatch, "
+                        "cipher %d split %d\n", (int)i, (int)j);
+                goto done;
+            }
+            if (!thread_pool_cipher(ciphers[i], 0, 1000, key, iv, ct, buf,
+                                    splits[j], tag)
+                    || memcmp(pt, buf, len) != 0) {
+                fprintf(stderr, "Thread pool decryption mismatch, "
+                        "cipher %d split %d\n", (int)i, (int)j);
+                goto done;
+            }
+            if (pool_tasks_run == 0) {
+                fprintf(stderr, "Thread pool not used, cipher %d split %d\n",
+                        (int)i, (int)j);
+                goto done;
+            }
+        }
+    }
+
+    ret = 1;
+
+ done:
+    OPENSSL_free(pt);
+    OPENSSL_free(ct);
+    OPENSSL_free(buf);
+    return ret;
+}
+
 int main(void)
 {
     CRYPTO_set_mem_debug(1);
@@ -399,6 +616,16 @@ int main(void)
     }
 #endif
 
+    if (!test_EVP_restore()) {
+        fprintf(stderr, "test_EVP_restore failed\n");
+        return 1;
+    }
+
+    if (!test_EVP_thread_pool()) {
+        fprintf(stderr, "test_EVP_thread_pool failed\n");
+        return 1;
+    }
+
 #ifndef OPENSSL_NO_CRYPTO_MDEBUG
     if (CRYPTO_mem_leaks_fp(stderr) <= 0)
         return 1;
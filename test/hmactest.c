@@ -293,6 +293,50 @@ test6:
     } else {
         printf("test 6 ok\n");
     }
+
+    /*
+     * Test 7: single-shot HMAC() (which doesn't use an HMAC_CTX for built-in
+     * digests) must match HMAC_CTX for short, block-sized and long keys.
+     */
+    {
+        const EVP_MD *mds[4];
+        static const int key_lens[] = { 0, 20, 64, 128, 200 };
+        unsigned char key[200], buf2[EVP_MAX_MD_SIZE];
+        unsigned int len2;
+        size_t m, k;
+        int nmds = 0;
+
+        mds[nmds++] = EVP_sha1();
+        mds[nmds++] = EVP_sha256();
+        mds[nmds++] = EVP_sha512();
+# ifndef OPENSSL_NO_BLAKE2
+        mds[nmds++] = EVP_blake2b512();
+# endif
+        for (k = 0; k < sizeof(key); k++)
+            key[k] = (unsigned char)k;
+
+        for (m = 0; m < (size_t)nmds; m++) {
+            for (k = 0; k < OSSL_NELEM(key_lens); k++) {
+                if (!HMAC_Init_ex(ctx, key, key_lens[k], mds[m], NULL)
+                        || !HMAC_Update(ctx, test[7].data, test[7].data_len)
+                        || !HMAC_Final(ctx, buf, &len)
+                        || HMAC(mds[m], key, key_lens[k], test[7].data,
+                                test[7].data_len, buf2, &len2) == NULL) {
+                    printf("Error calculating HMAC (test 7)\n");
+                    err++;
+                    goto end;
+                }
+                if (len != len2 || memcmp(buf, buf2, len) != 0) {
+                    printf("Single-shot HMAC mismatch for %s with %d byte "
+                           "key (test 7)\n", EVP_MD_name(mds[m]),
+                           key_lens[k]);
+                    err++;
+                    goto end;
+                }
+            }
+        }
+        printf("test 7 ok\n");
+    }
 end:
     HMAC_CTX_free(ctx2);
     HMAC_CTX_free(ctx);
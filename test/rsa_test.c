@@ -217,6 +217,16 @@ static int pad_unknown(void)
     return (0);
 }
 
+/* A "thread pool" that runs tasks in reverse order on the calling thread */
+static int run_tasks(void *pool, void (*task) (void *arg), void *args[],
+                     size_t num)
+{
+    (*(int *)pool)++;
+    while (num-- > 0)
+        task(args[num]);
+    return 1;
+}
+
 static const char rnd_seed[] =
     "string to make the random number generator think it has entropy";
 
@@ -233,6 +243,7 @@ int main(int argc, char *argv[])
     int clen = 0;
     int num;
     int n;
+    int calls;
 
     CRYPTO_set_mem_debug(1);
     CRYPTO_mem_ctrl(CRYPTO_MEM_CHECK_ON);
@@ -270,6 +281,16 @@ int main(int argc, char *argv[])
         } else
             printf("PKCS #1 v1.5 encryption/decryption ok\n");
 
+        /* Same again with the CRT halves run as pool tasks */
+        calls = 0;
+        RSA_set_thread_pool(key, run_tasks, &calls);
+        num = RSA_private_decrypt(clen, ctext, ptext, key, RSA_PKCS1_PADDING);
+        RSA_set_thread_pool(key, NULL, NULL);
+        if (num != plen || memcmp(ptext, ptext_ex, num) != 0 || calls != 1) {
+            printf("PKCS#1 v1.5 decryption with thread pool failed!\n");
+            err = 1;
+        }
+
  oaep:
         ERR_clear_error();
         num = RSA_public_encrypt(plen, ptext_ex, ctext, key,
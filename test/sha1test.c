@@ -32,6 +32,7 @@ static char *ret[] = {
 static char *bigret = "34aa973cd4c4daa4f61eeb2bdbad27316534016f";
 
 static char *pt(unsigned char *md);
+static int test_mb(void);
 int main(int argc, char *argv[])
 {
     unsigned int i;
@@ -77,11 +78,57 @@ int main(int argc, char *argv[])
     } else
         printf("test 3 ok\n");
 
+    if (!test_mb()) {
+        printf("error calculating multi-buffer SHA1\n");
+        err++;
+    } else
+        printf("test 4 ok\n");
+
     EVP_MD_CTX_free(c);
     EXIT(err);
     return (0);
 }
 
+/*
+ * Hash batches of messages of assorted lengths, around the padding
+ * boundaries and long enough to leave lanes idle, with SHA1_mb() and
+ * compare with SHA1().
+ */
+#define MB_MSGS 40
+
+static int test_mb(void)
+{
+    static unsigned char data[MB_MSGS * 64 + 5000];
+    static const size_t nums[] = { 1, 2, 3, 4, 5, 8, 9, 17, MB_MSGS };
+    const unsigned char *d[MB_MSGS];
+    size_t n[MB_MSGS], i, j;
+    unsigned char mds[MB_MSGS][SHA_DIGEST_LENGTH], *md[MB_MSGS];
+    unsigned char ref[SHA_DIGEST_LENGTH];
+
+    for (i = 0; i < sizeof(data); i++)
+        data[i] = (unsigned char)(i * 7 + (i >> 8));
+    for (i = 0; i < MB_MSGS; i++) {
+        d[i] = data + i;
+        n[i] = i % 7 == 3 ? 5000 - i * 13 : i * 64 / 5 + i % 3;
+        md[i] = mds[i];
+    }
+
+    for (j = 0; j < OSSL_NELEM(nums); j++) {
+        memset(mds, 0, sizeof(mds));
+        SHA1_mb(d, n, md, nums[j]);
+        for (i = 0; i < nums[j]; i++) {
+            SHA1(d[i], n[i], ref);
+            if (memcmp(md[i], ref, sizeof(ref)) != 0) {
+                printf("SHA1_mb mismatch for message %u of %u (%u bytes)\n",
+                       (unsigned int)i, (unsigned int)nums[j],
+                       (unsigned int)n[i]);
+                return 0;
+            }
+        }
+    }
+    return 1;
+}
+
 static char *pt(unsigned char *md)
 {
     int i;
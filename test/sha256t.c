@@ -56,6 +56,46 @@ static const unsigned char addenum_3[SHA224_DIGEST_LENGTH] = {
     0x4e, 0xe7, 0xad, 0x67
 };
 
+/*
+ * Hash batches of messages of assorted lengths, around the padding
+ * boundaries and long enough to leave lanes idle, with SHA256_mb() and
+ * compare with SHA256().
+ */
+#define MB_MSGS 40
+
+static int test_mb(void)
+{
+    static unsigned char data[MB_MSGS * 64 + 5000];
+    static const size_t nums[] = { 1, 2, 3, 4, 5, 8, 9, 17, MB_MSGS };
+    const unsigned char *d[MB_MSGS];
+    size_t n[MB_MSGS], i, j;
+    unsigned char mds[MB_MSGS][SHA256_DIGEST_LENGTH], *md[MB_MSGS];
+    unsigned char ref[SHA256_DIGEST_LENGTH];
+
+    for (i = 0; i < sizeof(data); i++)
+        data[i] = (unsigned char)(i * 7 + (i >> 8));
+    for (i = 0; i < MB_MSGS; i++) {
+        d[i] = data + i;
+        n[i] = i % 7 == 3 ? 5000 - i * 13 : i * 64 / 5 + i % 3;
+        md[i] = mds[i];
+    }
+
+    for (j = 0; j < sizeof(nums) / sizeof(nums[0]); j++) {
+        memset(mds, 0, sizeof(mds));
+        SHA256_mb(d, n, md, nums[j]);
+        for (i = 0; i < nums[j]; i++) {
+            SHA256(d[i], n[i], ref);
+            if (memcmp(md[i], ref, sizeof(ref)) != 0) {
+                fprintf(stderr, "\nSHA256_mb mismatch for message %u of %u "
+                        "(%u bytes)\n", (unsigned int)i, (unsigned int)nums[j],
+                        (unsigned int)n[i]);
+                return 0;
+            }
+        }
+    }
+    return 1;
+}
+
 int main(int argc, char **argv)
 {
     unsigned char md[SHA256_DIGEST_LENGTH];
@@ -157,5 +197,11 @@ int main(int argc, char **argv)
     fprintf(stdout, " passed.\n");
     fflush(stdout);
 
+    fprintf(stdout, "Testing multi-buffer SHA-256 ");
+    if (!test_mb())
+        return 1;
+    fprintf(stdout, ". passed.\n");
+    fflush(stdout);
+
     return 0;
 }
@@ -7,10 +7,16 @@
  * https://www.openssl.org/source/license.html
  */
 
+#include <string.h>
+
 #include <openssl/opensslconf.h>
 #include <openssl/bio.h>
 #include <openssl/crypto.h>
+#include <openssl/err.h>
 #include <openssl/ssl.h>
+#ifndef OPENSSL_NO_DH
+# include <openssl/dh.h>
+#endif
 
 #include "ssltestlib.h"
 #include "testutil.h"
@@ -172,6 +178,505 @@ static int test_session(void)
     return testresult;
 }
 
+static int test_read_view(void)
+{
+    SSL_CTX *sctx = NULL, *cctx = NULL;
+    SSL *serverssl = NULL, *clientssl = NULL;
+    static const char msg[] = "zero-copy read view test message";
+    const unsigned char *data;
+    size_t len, msglen = sizeof(msg) - 1;
+    unsigned char buf[sizeof(msg)];
+    int testresult = 0;
+
+    if (!create_ssl_ctx_pair(TLS_server_method(), TLS_client_method(), &sctx,
+                             &cctx, cert, privkey)) {
+        printf("Unable to create SSL_CTX pair\n");
+        return 0;
+    }
+
+    if (!create_ssl_connection(sctx, cctx, &serverssl, &clientssl, NULL,
+                               NULL)) {
+        printf("Unable to create SSL connection\n");
+        goto end;
+    }
+
+    if (SSL_write(clientssl, msg, (int)msglen) != (int)msglen) {
+        printf("Failed to write test message\n");
+        goto end;
+    }
+
+    if (SSL_read_view(serverssl, &data, &len) != (int)msglen
+            || len != msglen || memcmp(data, msg, len) != 0) {
+        printf("Unexpected data from SSL_read_view()\n");
+        goto end;
+    }
+
+    /* Releasing more than is available must fail */
+    if (SSL_release_view(serverssl, len + 1)) {
+        printf("Unexpected success releasing past the end of the view\n");
+        goto end;
+    }
+    ERR_clear_error();
+
+    if (!SSL_release_view(serverssl, 5)) {
+        printf("Failed to release part of the view\n");
+        goto end;
+    }
+
+    if (SSL_read_view(serverssl, &data, &len) != (int)(msglen - 5)
+            || len != msglen - 5 || memcmp(data, msg + 5, len) != 0) {
+        printf("Unexpected data from second SSL_read_view()\n");
+        goto end;
+    }
+
+    if (!SSL_release_view(serverssl, len)) {
+        printf("Failed to release remainder of the view\n");
+        goto end;
+    }
+
+    if (SSL_pending(serverssl) != 0) {
+        printf("Unexpected pending data after releasing the view\n");
+        goto end;
+    }
+
+    /* The view must not disturb ordinary reads of the following record */
+    if (SSL_write(clientssl, msg, (int)msglen) != (int)msglen
+            || SSL_read(serverssl, buf, sizeof(buf)) != (int)msglen
+            || memcmp(buf, msg, msglen) != 0) {
+        printf("SSL_read() after SSL_release_view() failed\n");
+        goto end;
+    }
+
+    testresult = 1;
+ end:
+    SSL_free(serverssl);
+    SSL_free(clientssl);
+    SSL_CTX_free(sctx);
+    SSL_CTX_free(cctx);
+
+    return testresult;
+}
+
+static const char *inplace_ciphers[] = {
+    "AES128-GCM-SHA256",
+    "ECDHE-RSA-CHACHA20-POLY1305",
+    /* Not AEAD, so never decrypted in place */
+    "AES128-SHA"
+};
+
+static int test_decrypt_in_place(int idx)
+{
+    SSL_CTX *sctx = NULL, *cctx = NULL;
+    SSL *serverssl = NULL, *clientssl = NULL;
+    BIO *rbio;
+    static unsigned char msg[SSL3_RT_MAX_PLAIN_LENGTH];
+    static unsigned char raw[SSL3_RT_MAX_ENCRYPTED_LENGTH];
+    static unsigned char buf[SSL3_RT_MAX_ENCRYPTED_LENGTH];
+    static unsigned char other[SSL3_RT_MAX_ENCRYPTED_LENGTH];
+    unsigned char small[100];
+    int rawlen, ret, i, testresult = 0;
+
+    for (i = 0; i < (int)sizeof(msg); i++)
+        msg[i] = (unsigned char)i;
+
+    if (!create_ssl_ctx_pair(TLS_server_method(), TLS_client_method(), &sctx,
+                             &cctx, cert, privkey)) {
+        printf("Unable to create SSL_CTX pair\n");
+        return 0;
+    }
+
+    if (!SSL_CTX_set_cipher_list(cctx, inplace_ciphers[idx])) {
+        /* Cipher not compiled in */
+        testresult = 1;
+        goto end;
+    }
+    SSL_CTX_set_mode(sctx, SSL_MODE_DECRYPT_IN_PLACE);
+
+    if (!create_ssl_connection(sctx, cctx, &serverssl, &clientssl, NULL,
+                               NULL)) {
+        printf("Unable to create SSL connection\n");
+        goto end;
+    }
+
+    /* Hand over one full record in two parts to force a resumed read */
+    rbio = SSL_get_rbio(serverssl);
+    if (SSL_write(clientssl, msg, sizeof(msg)) != (int)sizeof(msg)
+            || (rawlen = BIO_read(rbio, raw, sizeof(raw))) <= 100) {
+        printf("Failed to write full record\n");
+        goto end;
+    }
+    if (BIO_write(rbio, raw, 100) != 100
+            || SSL_read(serverssl, buf, sizeof(buf)) > 0
+            || SSL_get_error(serverssl, -1) != SSL_ERROR_WANT_READ) {
+        printf("Unexpected result reading a partial record\n");
+        goto end;
+    }
+    if (BIO_write(rbio, raw + 100, rawlen - 100) != rawlen - 100
+            || SSL_read(serverssl, buf, sizeof(buf)) != (int)sizeof(msg)
+            || memcmp(buf, msg, sizeof(msg)) != 0) {
+        printf("Unexpected data reading a full record\n");
+        goto end;
+    }
+
+    /* A buffer too small for the record must use the read buffer */
+    if (SSL_write(clientssl, msg, 1000) != 1000) {
+        printf("Failed to write short record\n");
+        goto end;
+    }
+    for (i = 0; i < 1000; i += ret) {
+        ret = SSL_read(serverssl, small, sizeof(small));
+        if (ret <= 0 || memcmp(small, msg + i, ret) != 0) {
+            printf("Unexpected data reading into a small buffer\n");
+            goto end;
+        }
+    }
+
+    /*
+     * Retrying with a different buffer once part of an AEAD record has been
+     * read in place must fail.
+     */
+    if (SSL_write(clientssl, msg, sizeof(msg)) != (int)sizeof(msg)
+            || (rawlen = BIO_read(rbio, raw, sizeof(raw))) <= 100
+            || BIO_write(rbio, raw, 100) != 100
+            || SSL_read(serverssl, buf, sizeof(buf)) > 0
+            || BIO_write(rbio, raw + 100, rawlen - 100) != rawlen - 100) {
+        printf("Failed to set up moved buffer retry\n");
+        goto end;
+    }
+    ret = SSL_read(serverssl, other, sizeof(other));
+    if (idx == 2) {
+        if (ret != (int)sizeof(msg) || memcmp(other, msg, sizeof(msg)) != 0) {
+            printf("Unexpected data after moving a non-AEAD read buffer\n");
+            goto end;
+        }
+    } else if (ret > 0
+               || ERR_GET_REASON(ERR_peek_error()) != SSL_R_BAD_READ_RETRY) {
+        printf("Unexpected success retrying with a moved read buffer\n");
+        goto end;
+    }
+    ERR_clear_error();
+
+    testresult = 1;
+ end:
+    SSL_free(serverssl);
+    SSL_free(clientssl);
+    SSL_CTX_free(sctx);
+    SSL_CTX_free(cctx);
+
+    return testresult;
+}
+
+static int test_memory_usage(void)
+{
+    SSL_CTX *sctx = NULL, *cctx = NULL;
+    SSL *serverssl = NULL, *clientssl = NULL;
+    static const char msg[] = "memory usage";
+    char buf[sizeof(msg)];
+    size_t sum;
+    int i, testresult = 0;
+
+    if (!create_ssl_ctx_pair(TLS_server_method(), TLS_client_method(), &sctx,
+                             &cctx, cert, privkey)) {
+        printf("Unable to create SSL_CTX pair\n");
+        return 0;
+    }
+    SSL_CTX_set_mode(sctx, SSL_MODE_RELEASE_BUFFERS);
+
+    if (!create_ssl_connection(sctx, cctx, &serverssl, &clientssl, NULL,
+                               NULL)) {
+        printf("Unable to create SSL connection\n");
+        goto end;
+    }
+
+    for (i = SSL_MEM_USAGE_OBJECTS, sum = 0; i <= SSL_MEM_USAGE_CERT; i++)
+        sum += SSL_get_memory_usage(serverssl, i);
+    if (sum != SSL_get_memory_usage(serverssl, SSL_MEM_USAGE_TOTAL)) {
+        printf("Memory usage components do not add up to the total\n");
+        goto end;
+    }
+
+    /* Handshake state must be gone once the handshake has completed */
+    if (SSL_get_memory_usage(serverssl, SSL_MEM_USAGE_HANDSHAKE) != 0
+            || SSL_get_memory_usage(clientssl, SSL_MEM_USAGE_HANDSHAKE) != 0) {
+        printf("Handshake state retained after the handshake\n");
+        goto end;
+    }
+
+    if (SSL_get_memory_usage(serverssl, SSL_MEM_USAGE_OBJECTS) == 0
+            || SSL_get_memory_usage(serverssl, SSL_MEM_USAGE_CRYPTO) == 0
+            || SSL_get_memory_usage(serverssl, -1) != 0) {
+        printf("Unexpected memory usage values\n");
+        goto end;
+    }
+
+    /* An idle connection releasing its buffers holds no record buffers */
+    if (SSL_write(clientssl, msg, sizeof(msg)) != (int)sizeof(msg)
+            || SSL_read(serverssl, buf, sizeof(buf)) != (int)sizeof(msg)
+            || SSL_get_memory_usage(serverssl,
+                                    SSL_MEM_USAGE_RECORD_BUFFERS) != 0) {
+        printf("Record buffers retained by idle connection\n");
+        goto end;
+    }
+
+    /* Renegotiation must still work without the old transcript */
+    if (!SSL_renegotiate(clientssl)) {
+        printf("Unable to start renegotiation\n");
+        goto end;
+    }
+    for (i = 0; i < 5 && SSL_renegotiate_pending(clientssl); i++) {
+        if (SSL_do_handshake(clientssl) <= 0
+                && SSL_get_error(clientssl, -1) != SSL_ERROR_WANT_READ) {
+            printf("Client renegotiation failed\n");
+            goto end;
+        }
+        if (SSL_read(serverssl, buf, sizeof(buf)) > 0
+                || SSL_get_error(serverssl, -1) != SSL_ERROR_WANT_READ) {
+            printf("Server renegotiation failed\n");
+            goto end;
+        }
+    }
+    if (SSL_renegotiate_pending(clientssl)
+            || SSL_write(clientssl, msg, sizeof(msg)) != (int)sizeof(msg)
+            || SSL_read(serverssl, buf, sizeof(buf)) != (int)sizeof(msg)
+            || SSL_write(serverssl, msg, sizeof(msg)) != (int)sizeof(msg)
+            || SSL_read(clientssl, buf, sizeof(buf)) != (int)sizeof(msg)) {
+        printf("Data exchange after renegotiation failed\n");
+        goto end;
+    }
+
+    testresult = 1;
+ end:
+    SSL_free(serverssl);
+    SSL_free(clientssl);
+    SSL_CTX_free(sctx);
+    SSL_CTX_free(cctx);
+
+    return testresult;
+}
+
+static int test_cert_cow(void)
+{
+    SSL_CTX *sctx = NULL, *cctx = NULL;
+    SSL *serverssl = NULL, *clientssl = NULL, *otherssl = NULL;
+    int testresult = 0;
+
+    if (!create_ssl_ctx_pair(TLS_server_method(), TLS_client_method(), &sctx,
+                             &cctx, cert, privkey)) {
+        printf("Unable to create SSL_CTX pair\n");
+        return 0;
+    }
+
+    /* A new SSL shares the certificate configuration of its SSL_CTX */
+    otherssl = SSL_new(sctx);
+    if (otherssl == NULL
+            || SSL_get_certificate(otherssl) != SSL_CTX_get0_certificate(sctx)
+            || SSL_get_memory_usage(otherssl, SSL_MEM_USAGE_CERT) != 0) {
+        printf("Certificate configuration not shared\n");
+        goto end;
+    }
+
+    /* A certificate of the connection's own counts towards its usage */
+    if (SSL_use_certificate_file(otherssl, cert, SSL_FILETYPE_PEM) != 1
+            || SSL_get_memory_usage(otherssl, SSL_MEM_USAGE_CERT)
+               < (size_t)i2d_X509(SSL_get_certificate(otherssl), NULL)) {
+        printf("Certificate of the SSL not counted\n");
+        goto end;
+    }
+
+    /* Changing the SSL must not affect the SSL_CTX... */
+    SSL_set_security_level(otherssl, 2);
+    if (SSL_get_memory_usage(otherssl, SSL_MEM_USAGE_CERT) == 0
+            || SSL_get_security_level(otherssl) != 2
+            || SSL_CTX_get_security_level(sctx) == 2) {
+        printf("SSL change leaked into SSL_CTX\n");
+        goto end;
+    }
+
+    /* ...and changing the SSL_CTX must not affect existing SSL objects */
+    SSL_CTX_set_security_level(sctx, 0);
+    if (SSL_get_security_level(otherssl) != 2) {
+        printf("SSL_CTX change leaked into SSL\n");
+        goto end;
+    }
+
+    if (!create_ssl_connection(sctx, cctx, &serverssl, &clientssl, NULL,
+                               NULL)) {
+        printf("Unable to create SSL connection\n");
+        goto end;
+    }
+    if (SSL_get_security_level(serverssl) != 0) {
+        printf("New SSL does not see SSL_CTX change\n");
+        goto end;
+    }
+
+    testresult = 1;
+ end:
+    SSL_free(otherssl);
+    SSL_free(serverssl);
+    SSL_free(clientssl);
+    SSL_CTX_free(sctx);
+    SSL_CTX_free(cctx);
+
+    return testresult;
+}
+
+/*
+ * A cipher string can set the security level, which must only apply to the
+ * object it was given to
+ */
+static int test_cipher_list_cow(void)
+{
+    SSL_CTX *ctx = SSL_CTX_new(TLS_server_method());
+    SSL *ssl = NULL, *otherssl = NULL;
+    int level, testresult = 0;
+
+    if (ctx == NULL || (ssl = SSL_new(ctx)) == NULL
+            || (otherssl = SSL_new(ctx)) == NULL) {
+        printf("Unable to create SSL objects\n");
+        goto end;
+    }
+
+    level = SSL_CTX_get_security_level(ctx);
+    if (!SSL_set_cipher_list(ssl, "@SECLEVEL=0:ALL")
+            || SSL_get_security_level(ssl) != 0
+            || SSL_CTX_get_security_level(ctx) != level
+            || SSL_get_security_level(otherssl) != level) {
+        printf("SSL cipher string leaked into SSL_CTX\n");
+        goto end;
+    }
+
+    if (!SSL_CTX_set_cipher_list(ctx, "@SECLEVEL=3:ALL")
+            || SSL_CTX_get_security_level(ctx) != 3
+            || SSL_get_security_level(otherssl) != level) {
+        printf("SSL_CTX cipher string leaked into SSL\n");
+        goto end;
+    }
+
+    testresult = 1;
+ end:
+    SSL_free(ssl);
+    SSL_free(otherssl);
+    SSL_CTX_free(ctx);
+
+    return testresult;
+}
+
+#if !defined(OPENSSL_NO_DH) && !defined(OPENSSL_NO_EC)
+static int (*default_sec_cb) (const SSL *s, const SSL_CTX *ctx, int op,
+                              int bits, int nid, void *other, void *ex);
+
+/* Allow no DH group stronger than 80 bits, so that none of RFC 7919 is */
+static int ffdhe_sec_cb(const SSL *s, const SSL_CTX *ctx, int op, int bits,
+                        int nid, void *other, void *ex)
+{
+    if (op == SSL_SECOP_TMP_DH && bits > 80)
+        return 0;
+    return default_sec_cb(s, ctx, op, bits, nid, other, ex);
+}
+
+static const struct {
+    const char *ciphers;
+    DH *(*group) (void);        /* NULL for the 1024-bit fallback */
+    int restrict_server;
+} ffdhe_tests[] = {
+    /* the weakest listed group that matches the RSA-2048 certificate */
+    { "DHE-RSA-AES128-GCM-SHA256", DH_get_ffdhe2048, 0 },
+    /* ...or the 128 bits of an anonymous 256-bit cipher */
+    { "ADH-AES256-SHA:@SECLEVEL=0", DH_get_ffdhe3072, 0 },
+    /* no listed group is acceptable to the server */
+    { "ADH-AES128-SHA:@SECLEVEL=0", NULL, 1 }
+};
+
+/*
+ * The client lists the RFC 7919 groups when it offers DHE, and the server
+ * picks its DH parameters from them
+ */
+static int test_ffdhe(int idx)
+{
+    SSL_CTX *sctx = NULL, *cctx = NULL;
+    SSL *serverssl = NULL, *clientssl = NULL;
+    EVP_PKEY *tmp = NULL;
+    DH *group = NULL;
+    const BIGNUM *p, *group_p;
+    int *groups = NULL, ngroups, i, found = 0, testresult = 0;
+
+    if (!create_ssl_ctx_pair(TLS_server_method(), TLS_client_method(), &sctx,
+                             &cctx, cert, privkey)) {
+        printf("Unable to create SSL_CTX pair\n");
+        return 0;
+    }
+
+    if (!SSL_CTX_set_cipher_list(sctx, ffdhe_tests[idx].ciphers)
+            || !SSL_CTX_set_cipher_list(cctx, ffdhe_tests[idx].ciphers)
+            || !SSL_CTX_set_dh_auto(sctx, 1)) {
+        printf("Unable to set up DHE\n");
+        goto end;
+    }
+    if (ffdhe_tests[idx].restrict_server) {
+        default_sec_cb = SSL_CTX_get_security_callback(sctx);
+        SSL_CTX_set_security_callback(sctx, ffdhe_sec_cb);
+    }
+
+    if (!create_ssl_connection(sctx, cctx, &serverssl, &clientssl, NULL,
+                               NULL)) {
+        printf("Unable to create SSL connection\n");
+        goto end;
+    }
+
+    ngroups = SSL_get1_curves(serverssl, NULL);
+    if (ngroups <= 0
+            || (groups = OPENSSL_malloc(ngroups * sizeof(*groups))) == NULL) {
+        printf("No supported groups received\n");
+        goto end;
+    }
+    SSL_get1_curves(serverssl, groups);
+    for (i = 0; i < ngroups; i++) {
+        if (groups[i] == (TLSEXT_nid_unknown | TLSEXT_ffdhe2048)
+                || groups[i] == (TLSEXT_nid_unknown | TLSEXT_ffdhe3072)
+                || groups[i] == (TLSEXT_nid_unknown | TLSEXT_ffdhe4096))
+            found++;
+    }
+    if (found != 3) {
+        printf("Client did not list the RFC 7919 groups\n");
+        goto end;
+    }
+
+    if (!SSL_get_server_tmp_key(clientssl, &tmp)
+            || EVP_PKEY_id(tmp) != EVP_PKEY_DH) {
+        printf("No server DH key\n");
+        goto end;
+    }
+    DH_get0_pqg(EVP_PKEY_get0_DH(tmp), &p, NULL, NULL);
+    if (ffdhe_tests[idx].group == NULL) {
+        if (BN_num_bits(p) != 1024) {
+            printf("Unexpected fallback DH group of %d bits\n",
+                   BN_num_bits(p));
+            goto end;
+        }
+    } else {
+        if ((group = ffdhe_tests[idx].group()) == NULL)
+            goto end;
+        DH_get0_pqg(group, &group_p, NULL, NULL);
+        if (BN_cmp(p, group_p) != 0) {
+            printf("Server did not pick the expected RFC 7919 group\n");
+            goto end;
+        }
+    }
+
+    testresult = 1;
+ end:
+    OPENSSL_free(groups);
+    EVP_PKEY_free(tmp);
+    DH_free(group);
+    SSL_free(serverssl);
+    SSL_free(clientssl);
+    SSL_CTX_free(sctx);
+    SSL_CTX_free(cctx);
+
+    return testresult;
+}
+#endif
+
 int main(int argc, char *argv[])
 {
     BIO *err = NULL;
@@ -192,6 +697,15 @@ int main(int argc, char *argv[])
 
     ADD_TEST(test_tlsext_status_type);
     ADD_TEST(test_session);
+    ADD_TEST(test_read_view);
+    ADD_TEST(test_memory_usage);
+    ADD_TEST(test_cert_cow);
+    ADD_TEST(test_cipher_list_cow);
+#if !defined(OPENSSL_NO_DH) && !defined(OPENSSL_NO_EC)
+    ADD_ALL_TESTS(test_ffdhe, sizeof(ffdhe_tests) / sizeof(ffdhe_tests[0]));
+#endif
+    ADD_ALL_TESTS(test_decrypt_in_place,
+                  sizeof(inplace_ciphers) / sizeof(inplace_ciphers[0]));
 
     testresult = run_tests(argv[0]);
 
@@ -8,8 +8,21 @@
  */
 
 #include <stdio.h>
+#include <string.h>
+#include <time.h>
 
 #include <openssl/crypto.h>
+#include <openssl/bio.h>
+#include <openssl/x509.h>
+#include <openssl/evp.h>
+#include <openssl/bn.h>
+#include <openssl/err.h>
+#ifndef OPENSSL_NO_RSA
+# include <openssl/rsa.h>
+#endif
+#ifndef OPENSSL_NO_EC
+# include <openssl/ec.h>
+#endif
 
 #if !defined(OPENSSL_THREADS) || defined(CRYPTO_TDEBUG)
 
@@ -26,6 +39,11 @@ static int wait_for_thread(thread_t thread)
     return 1;
 }
 
+static double wall_time(void)
+{
+    return (double)time(NULL);
+}
+
 #elif defined(OPENSSL_SYS_WINDOWS)
 
 typedef HANDLE thread_t;
@@ -51,6 +69,11 @@ static int wait_for_thread(thread_t thread)
     return WaitForSingleObject(thread, INFINITE) == 0;
 }
 
+static double wall_time(void)
+{
+    return GetTickCount() / 1000.0;
+}
+
 #else
 
 typedef pthread_t thread_t;
@@ -75,6 +98,16 @@ static int wait_for_thread(thread_t thread)
     return pthread_join(thread, NULL) == 0;
 }
 
+# include <sys/time.h>
+
+static double wall_time(void)
+{
+    struct timeval tv;
+
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
 #endif
 
 static int test_lock(void)
@@ -226,8 +259,362 @@ static int test_thread_local(void)
     return 1;
 }
 
+#define MAX_THREADS 64
+
+static CRYPTO_RWLOCK *ex_data_count_lock;
+static int ex_data_new_count = 0;
+static int ex_data_free_count = 0;
+static int objects_per_thread = 1000;
+static int objects_ok = 1;
+
+static void ex_data_count_new(void *parent, void *ptr, CRYPTO_EX_DATA *ad,
+                              int idx, long argl, void *argp)
+{
+    int ret;
+
+    CRYPTO_atomic_add(&ex_data_new_count, 1, &ret, ex_data_count_lock);
+}
+
+static void ex_data_count_free(void *parent, void *ptr, CRYPTO_EX_DATA *ad,
+                               int idx, long argl, void *argp)
+{
+    int ret;
+
+    CRYPTO_atomic_add(&ex_data_free_count, 1, &ret, ex_data_count_lock);
+}
+
+/* Create and free objects of the classes most often allocated in bulk */
+static void objects_thread_cb(void)
+{
+    BIO *bio;
+    X509 *x;
+#ifndef OPENSSL_NO_RSA
+    RSA *rsa;
+#endif
+#ifndef OPENSSL_NO_EC
+    EC_KEY *ec;
+#endif
+    int i;
+
+    for (i = 0; i < objects_per_thread; i++) {
+        bio = BIO_new(BIO_s_mem());
+        x = X509_new();
+        if (bio == NULL || x == NULL)
+            objects_ok = 0;
+        BIO_free(bio);
+        X509_free(x);
+#ifndef OPENSSL_NO_RSA
+        if ((rsa = RSA_new()) == NULL)
+            objects_ok = 0;
+        RSA_free(rsa);
+#endif
+#ifndef OPENSSL_NO_EC
+        if ((ec = EC_KEY_new()) == NULL)
+            objects_ok = 0;
+        EC_KEY_free(ec);
+#endif
+    }
+}
+
+static int run_objects_threads(int num)
+{
+    thread_t threads[MAX_THREADS];
+    int i, ret = 1;
+
+    for (i = 0; i < num; i++) {
+        if (!run_thread(&threads[i], objects_thread_cb)) {
+            num = i;
+            ret = 0;
+            break;
+        }
+    }
+    for (i = 0; i < num; i++)
+        if (!wait_for_thread(threads[i]))
+            ret = 0;
+    if (!ret)
+        fprintf(stderr, "run_thread() failed\n");
+    return ret && objects_ok;
+}
+
+/* ex_data callbacks must run exactly once per object from all threads */
+static int test_ex_data(void)
+{
+    int idx, ret = 0;
+
+    ex_data_count_lock = CRYPTO_THREAD_lock_new();
+    idx = BIO_get_ex_new_index(0, NULL, ex_data_count_new, NULL,
+                               ex_data_count_free);
+    if (ex_data_count_lock == NULL || idx < 0) {
+        fprintf(stderr, "BIO_get_ex_new_index() failed\n");
+        goto end;
+    }
+
+    if (!run_objects_threads(8))
+        goto end;
+
+    if (ex_data_new_count != 8 * objects_per_thread
+            || ex_data_free_count != ex_data_new_count) {
+        fprintf(stderr, "ex_data callbacks run %d/%d times, expected %d\n",
+                ex_data_new_count, ex_data_free_count,
+                8 * objects_per_thread);
+        goto end;
+    }
+    ret = 1;
+ end:
+    if (idx >= 0)
+        CRYPTO_free_ex_index(CRYPTO_EX_INDEX_BIO, idx);
+    CRYPTO_THREAD_lock_free(ex_data_count_lock);
+    return ret;
+}
+
+#define POOL_THREADS 4
+
+static CRYPTO_RWLOCK *pool_lock;
+static void (*pool_task) (void *arg);
+static void **pool_args;
+static size_t pool_num, pool_next;
+static int pool_calls = 0;
+
+static void pool_thread_cb(void)
+{
+    size_t i;
+
+    for (;;) {
+        CRYPTO_THREAD_write_lock(pool_lock);
+        i = pool_next++;
+        CRYPTO_THREAD_unlock(pool_lock);
+        if (i >= pool_num)
+            return;
+        pool_task(pool_args[i]);
+    }
+}
+
+/* A CRYPTO_RUN_TASKS that shares the tasks between POOL_THREADS threads */
+static int run_tasks_threads(void *pool, void (*task) (void *arg),
+                             void *args[], size_t num)
+{
+    thread_t threads[POOL_THREADS];
+    int i, n, ret = 1;
+
+    pool_task = task;
+    pool_args = args;
+    pool_num = num;
+    pool_next = 0;
+    pool_calls++;
+    for (n = 0; n < POOL_THREADS; n++) {
+        if (!run_thread(&threads[n], pool_thread_cb)) {
+            ret = n > 0;
+            break;
+        }
+    }
+    for (i = 0; i < n; i++)
+        if (!wait_for_thread(threads[i]))
+            ret = 0;
+    return ret;
+}
+
+static int pool_encrypt(const EVP_CIPHER *cipher, int pool,
+                        const unsigned char *in, int inl,
+                        unsigned char *out, unsigned char *tag)
+{
+    static const unsigned char key[16] = "0123456789abcdef";
+    static const unsigned char iv[16] = "fedcba9876543210";
+    EVP_CIPHER_CTX *ctx = EVP_CIPHER_CTX_new();
+    int outl, finl, ret = 0;
+
+    if (ctx == NULL
+            || !EVP_EncryptInit_ex(ctx, cipher, NULL, key, iv)
+            || (pool && !EVP_CIPHER_CTX_set_thread_pool(ctx, run_tasks_threads,
+                                                         NULL, 4096))
+            || !EVP_EncryptUpdate(ctx, out, &outl, in, inl)
+            || !EVP_EncryptFinal_ex(ctx, out + outl, &finl)
+            || outl + finl != inl)
+        goto end;
+    if (EVP_CIPHER_mode(cipher) == EVP_CIPH_GCM_MODE
+            && !EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_AEAD_GET_TAG, 16, tag))
+        goto end;
+    ret = 1;
+ end:
+    EVP_CIPHER_CTX_free(ctx);
+    return ret;
+}
+
+static int test_pool_cipher(const EVP_CIPHER *cipher)
+{
+    static unsigned char in[65536], out1[65536], out2[65536];
+    unsigned char tag1[16] = { 0 }, tag2[16] = { 0 };
+    int calls = pool_calls;
+    size_t i;
+
+    for (i = 0; i < sizeof(in); i++)
+        in[i] = (unsigned char)(i * 7);
+    if (!pool_encrypt(cipher, 0, in, sizeof(in), out1, tag1)
+            || !pool_encrypt(cipher, 1, in, sizeof(in), out2, tag2)) {
+        fprintf(stderr, "%s encryption failed\n",
+                OBJ_nid2sn(EVP_CIPHER_nid(cipher)));
+        return 0;
+    }
+    if (pool_calls == calls || memcmp(out1, out2, sizeof(out1)) != 0
+            || memcmp(tag1, tag2, sizeof(tag1)) != 0) {
+        fprintf(stderr, "%s thread pool output mismatch\n",
+                OBJ_nid2sn(EVP_CIPHER_nid(cipher)));
+        return 0;
+    }
+    return 1;
+}
+
+static int test_pool_prime(void)
+{
+    BN_GENCB *cb = BN_GENCB_new();
+    BIGNUM *p = BN_new(), *q = BN_new();
+    int calls = pool_calls, ret = 0;
+
+    if (cb == NULL || p == NULL || q == NULL)
+        goto end;
+    BN_GENCB_set_old(cb, NULL, NULL);
+    BN_GENCB_set_thread_pool(cb, run_tasks_threads, NULL, POOL_THREADS);
+    if (!BN_generate_prime_ex(p, 256, 1, NULL, NULL, cb)
+            || !BN_rshift1(q, p)
+            || BN_is_prime_ex(p, BN_prime_checks, NULL, NULL) != 1
+            || BN_is_prime_ex(q, BN_prime_checks, NULL, NULL) != 1
+            || pool_calls == calls) {
+        fprintf(stderr, "threaded safe prime generation failed\n");
+        goto end;
+    }
+    ret = 1;
+ end:
+    BN_GENCB_free(cb);
+    BN_free(p);
+    BN_free(q);
+    return ret;
+}
+
+#ifndef OPENSSL_NO_RSA
+/*
+ * A key whose p has been made even, and which does not cache Montgomery
+ * contexts, fails inside the exponentiation task modulo p.
+ */
+static RSA *pool_bad_rsa(const RSA *rsa)
+{
+    const BIGNUM *n, *e, *d, *p, *q, *dmp1, *dmq1, *iqmp;
+    BIGNUM *bad_p = NULL;
+    RSA *bad = RSA_new();
+
+    RSA_get0_key(rsa, &n, &e, &d);
+    RSA_get0_factors(rsa, &p, &q);
+    RSA_get0_crt_params(rsa, &dmp1, &dmq1, &iqmp);
+    if (bad == NULL
+            || !RSA_set0_key(bad, BN_dup(n), BN_dup(e), BN_dup(d))
+            || (bad_p = BN_dup(p)) == NULL
+            || !BN_add_word(bad_p, 1)
+            || !RSA_set0_factors(bad, bad_p, BN_dup(q))
+            || !RSA_set0_crt_params(bad, BN_dup(dmp1), BN_dup(dmq1),
+                                    BN_dup(iqmp))) {
+        RSA_free(bad);
+        return NULL;
+    }
+    RSA_clear_flags(bad, RSA_FLAG_CACHE_PRIVATE);
+    return bad;
+}
+
+static int test_pool_rsa(void)
+{
+    static const unsigned char msg[] = "thread pool";
+    unsigned char sig1[128], sig2[128];
+    RSA *rsa = RSA_new(), *bad = NULL;
+    BIGNUM *e = BN_new();
+    unsigned long err;
+    int calls, ret = 0;
+
+    if (rsa == NULL || e == NULL || !BN_set_word(e, RSA_F4)
+            || !RSA_generate_key_ex(rsa, 1024, e, NULL)
+            || RSA_private_encrypt(sizeof(msg), msg, sig1, rsa,
+                                   RSA_PKCS1_PADDING) != sizeof(sig1))
+        goto end;
+    calls = pool_calls;
+    RSA_set_thread_pool(rsa, run_tasks_threads, NULL);
+    if (RSA_private_encrypt(sizeof(msg), msg, sig2, rsa,
+                            RSA_PKCS1_PADDING) != sizeof(sig2)
+            || pool_calls == calls
+            || memcmp(sig1, sig2, sizeof(sig1)) != 0) {
+        fprintf(stderr, "threaded RSA signature mismatch\n");
+        goto end;
+    }
+
+    /* Errors raised on the pool's threads must reach this one */
+    if ((bad = pool_bad_rsa(rsa)) == NULL)
+        goto end;
+    RSA_set_thread_pool(bad, run_tasks_threads, NULL);
+    ERR_clear_error();
+    calls = pool_calls;
+    if (RSA_private_encrypt(sizeof(msg), msg, sig2, bad,
+                            RSA_PKCS1_PADDING) > 0 || pool_calls == calls) {
+        fprintf(stderr, "RSA with an even prime did not fail\n");
+        goto end;
+    }
+    while ((err = ERR_get_error()) != 0)
+        if (ERR_GET_LIB(err) == ERR_LIB_BN
+                && ERR_GET_REASON(err) == BN_R_CALLED_WITH_EVEN_MODULUS)
+            ret = 1;
+    if (!ret)
+        fprintf(stderr, "thread pool error not propagated\n");
+ end:
+    RSA_free(rsa);
+    RSA_free(bad);
+    BN_free(e);
+    return ret;
+}
+#endif
+
+/* Operations split between threads give the results of serial ones */
+static int test_thread_pool(void)
+{
+    int ret = 0;
+
+    if ((pool_lock = CRYPTO_THREAD_lock_new()) == NULL)
+        return 0;
+    if (!test_pool_cipher(EVP_aes_128_ctr())
+            || !test_pool_cipher(EVP_aes_128_gcm())
+            || !test_pool_prime())
+        goto end;
+#ifndef OPENSSL_NO_RSA
+    if (!test_pool_rsa())
+        goto end;
+#endif
+    ret = 1;
+ end:
+    CRYPTO_THREAD_lock_free(pool_lock);
+    return ret;
+}
+
+/*
+ * Object creation throughput for 1 to MAX_THREADS threads, run with the
+ * "-bench" option. Each thread creates and frees a BIO, an X509, an RSA and
+ * an EC_KEY per iteration, counted as four objects.
+ */
+static int bench_objects(void)
+{
+    double start, elapsed;
+    int num;
+
+    objects_per_thread = 100000;
+    printf("%8s %16s\n", "threads", "objects/s");
+    for (num = 1; num <= MAX_THREADS; num *= 2) {
+        start = wall_time();
+        if (!run_objects_threads(num))
+            return 0;
+        elapsed = wall_time() - start;
+        printf("%8d %16.0f\n", num,
+               elapsed > 0 ? 4.0 * num * objects_per_thread / elapsed : 0.0);
+    }
+    return 1;
+}
+
 int main(int argc, char **argv)
 {
+    if (argc > 1 && strcmp(argv[1], "-bench") == 0)
+        return bench_objects() ? 0 : 1;
+
     if (!test_lock())
       return 1;
 
@@ -237,6 +624,12 @@ int main(int argc, char **argv)
     if (!test_thread_local())
       return 1;
 
+    if (!test_ex_data())
+      return 1;
+
+    if (!test_thread_pool())
+      return 1;
+
     printf("PASS\n");
     return 0;
 }